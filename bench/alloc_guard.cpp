@@ -0,0 +1,217 @@
+/*
+
+This file is part of VROOM.
+
+Copyright (c) 2015-2021, Julien Coupey.
+All rights reserved (see LICENSE).
+
+*/
+
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "problems/cvrp/operators/exchange.h"
+#include "structures/vroom/input/input.h"
+#include "structures/vroom/solution_state.h"
+#include "structures/vroom/tw_route.h"
+#include "utils/helpers.h"
+#include "utils/memory_usage.h"
+
+// Allocation-regression guard for the hot kernels exercised on every
+// candidate move. Each check runs a kernel in steady state under the
+// process-wide heap counters from memory_usage.cpp and fails when
+// the allocation count exceeds its hard ceiling, so a change that
+// reintroduces per-move heap traffic fails `make alloccheck` instead
+// of silently eating the wins back. Fixtures match the ones in
+// micro.cpp so guarded kernels and timed kernels stay in sync.
+
+namespace {
+
+// Accumulating into a volatile sink keeps the guarded calls from
+// being optimized away.
+volatile long long sink = 0;
+
+bool all_ok = true;
+
+template <typename F>
+void guard(const std::string& name, std::uint64_t ceiling, F&& fn) {
+  constexpr std::size_t iterations = 1000;
+
+  // Warm-up so lazily built caches do not count against the kernel.
+  sink += fn();
+
+  const auto before = vroom::utils::allocation_snapshot();
+  for (std::size_t i = 0; i < iterations; ++i) {
+    sink += fn();
+  }
+  const auto after = vroom::utils::allocation_snapshot();
+
+  const auto allocations = after.nb_allocations - before.nb_allocations;
+  const bool ok = allocations <= ceiling;
+  all_ok = all_ok and ok;
+
+  std::cout << "{\"check\":\"" << name << "\",\"iterations\":" << iterations
+            << ",\"allocations\":" << allocations
+            << ",\"ceiling\":" << ceiling << ",\"status\":\""
+            << (ok ? "ok" : "FAIL") << "\"}" << std::endl;
+}
+
+vroom::Input build_synthetic(std::size_t nb_jobs, unsigned nb_vehicles) {
+  vroom::Input input(1);
+  input.set_trusted(true);
+  input.reserve(nb_jobs, nb_vehicles);
+
+  std::minstd_rand rng(42);
+  std::uniform_real_distribution<double> coord(0., 100.);
+
+  std::vector<vroom::Coordinates> points;
+  points.reserve(nb_jobs + 1);
+  for (std::size_t i = 0; i <= nb_jobs; ++i) {
+    points.push_back({coord(rng), coord(rng)});
+  }
+
+  vroom::Matrix<vroom::Cost> m(nb_jobs + 1);
+  for (std::size_t i = 0; i <= nb_jobs; ++i) {
+    for (std::size_t j = 0; j <= nb_jobs; ++j) {
+      const auto dx = points[i][0] - points[j][0];
+      const auto dy = points[i][1] - points[j][1];
+      m[i][j] = static_cast<vroom::Cost>(100 * std::sqrt(dx * dx + dy * dy));
+    }
+  }
+  input.set_matrix(vroom::DEFAULT_PROFILE, std::move(m));
+
+  vroom::Amount delivery(1);
+  delivery[0] = 1;
+  // Zero-valued but correctly sized: set_trusted skips the length
+  // checks, so an empty default pickup would trip size assertions
+  // deeper in the solve.
+  const vroom::Amount pickup(1);
+  for (std::size_t j = 0; j < nb_jobs; ++j) {
+    input.add_job(vroom::Job(j + 1,
+                             vroom::Location(static_cast<vroom::Index>(j + 1),
+                                             points[j + 1]),
+                             0,
+                             delivery,
+                             pickup));
+  }
+
+  vroom::Amount capacity(1);
+  capacity[0] = 40;
+  const vroom::Location depot(0, points[0]);
+  for (unsigned v = 0; v < nb_vehicles; ++v) {
+    input.add_vehicle(vroom::Vehicle(v + 1,
+                                     depot,
+                                     depot,
+                                     vroom::DEFAULT_PROFILE,
+                                     capacity));
+  }
+
+  return input;
+}
+
+} // namespace
+
+int main() {
+  constexpr std::size_t nb_jobs = 200;
+  constexpr unsigned nb_vehicles = 8;
+
+  auto input = build_synthetic(nb_jobs, nb_vehicles);
+
+  // Solving once populates the internal caches (compatibility
+  // matrices in particular) the kernels below rely on.
+  const auto sol = input.solve(0, 1);
+
+  // Rebuild raw routes from the solution.
+  std::vector<vroom::RawRoute> raw_sol;
+  for (vroom::Index v = 0; v < nb_vehicles; ++v) {
+    raw_sol.emplace_back(input, v);
+  }
+  for (const auto& route : sol.routes) {
+    auto& raw_route = raw_sol[route.vehicle - 1].route;
+    for (const auto& step : route.steps) {
+      if (step.step_type == vroom::STEP_TYPE::JOB) {
+        raw_route.push_back(input.job_id_to_rank.find(step.id)->second);
+      }
+    }
+  }
+
+  vroom::utils::SolutionState sol_state(input);
+  sol_state.setup(raw_sol);
+
+  const auto& route_0 = raw_sol[0].route;
+  const auto& route_1 = raw_sol[1].route;
+  const auto& vehicle_0 = input.vehicles[0];
+
+  std::size_t tick = 0;
+
+  // Per-candidate-move kernels must not touch the heap at all.
+  guard("addition_cost", 0, [&]() {
+    const auto job_rank = route_1[tick % route_1.size()];
+    const auto rank = static_cast<vroom::Index>(++tick % route_0.size());
+    return vroom::utils::addition_cost(input,
+                                       job_rank,
+                                       vehicle_0,
+                                       route_0,
+                                       rank);
+  });
+
+  vroom::TWRoute tw_route(input, 0);
+  for (std::size_t r = 0; r < route_0.size(); ++r) {
+    tw_route.add(input, route_0[r], static_cast<vroom::Index>(r));
+  }
+
+  guard("is_valid_addition_for_tw", 0, [&]() {
+    const auto job_rank = route_1[tick % route_1.size()];
+    const auto rank = static_cast<vroom::Index>(++tick % route_0.size());
+    return tw_route.is_valid_addition_for_tw(input, job_rank, rank) ? 1 : 0;
+  });
+
+  guard("update_cheapest_job_rank_in_routes", 0, [&]() {
+    sol_state.update_cheapest_job_rank_in_routes(route_0, route_1, 0, 1);
+    return 1;
+  });
+
+  guard("exchange_compute_gain", 0, [&]() {
+    const auto s_rank = static_cast<vroom::Index>(tick % route_0.size());
+    const auto t_rank = static_cast<vroom::Index>(++tick % route_1.size());
+    vroom::cvrp::Exchange exchange(input,
+                                   sol_state,
+                                   raw_sol[0],
+                                   0,
+                                   s_rank,
+                                   raw_sol[1],
+                                   1,
+                                   t_rank);
+    return exchange.gain();
+  });
+
+  // Whole steady-state re-solve, covering the local search rounds
+  // and try_job_additions refills end to end. The ceiling leaves
+  // headroom over the current count (~120k on this fixture, mostly
+  // setup and solution formatting): per-move heap traffic multiplies
+  // allocations by candidate moves per round and blows way past it.
+  {
+    // Warm-up re-solve so one-time lazy setup does not count.
+    sink += static_cast<long long>(input.solve(0, 1).summary.cost);
+
+    const auto before = vroom::utils::allocation_snapshot();
+    sink += static_cast<long long>(input.solve(0, 1).summary.cost);
+    const auto after = vroom::utils::allocation_snapshot();
+
+    const auto allocations = after.nb_allocations - before.nb_allocations;
+    const std::uint64_t ceiling = 1000 * nb_jobs;
+    const bool ok = allocations <= ceiling;
+    all_ok = all_ok and ok;
+
+    std::cout << "{\"check\":\"steady_state_solve\",\"iterations\":1"
+              << ",\"allocations\":" << allocations
+              << ",\"ceiling\":" << ceiling << ",\"status\":\""
+              << (ok ? "ok" : "FAIL") << "\"}" << std::endl;
+  }
+
+  return all_ok ? 0 : 1;
+}
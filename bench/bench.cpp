@@ -0,0 +1,198 @@
+/*
+
+This file is part of VROOM.
+
+Copyright (c) 2015-2021, Julien Coupey.
+All rights reserved (see LICENSE).
+
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "structures/cl_args.h"
+#include "structures/vroom/input/input.h"
+#include "utils/exception.h"
+#include "utils/input_parser.h"
+#include "utils/memory_usage.h"
+
+// Benchmark driver: run instances through Input::solve at each
+// exploration level and report wall time, cost gap and peak memory as
+// NDJSON, one line per (instance, level) pair.
+//
+// Usage:
+//   vroom-bench [FILE...]
+//
+// Each FILE is an instance in the usual json input format and must
+// embed its matrices (curated CVRPLIB/Solomon/Homberger instances are
+// used in their json conversion, which keeps this driver free of
+// per-format parsers). Without arguments a synthetic scaling series
+// of random euclidean instances is generated instead.
+
+namespace {
+
+constexpr unsigned NB_THREADS = 4;
+constexpr unsigned MAX_EXPLORATION_LEVEL = 6;
+
+struct BenchResult {
+  unsigned exploration_level;
+  double solving_ms;
+  vroom::Cost cost;
+  unsigned unassigned;
+  std::size_t peak_rss_kb;
+};
+
+// Run one instance at all exploration levels. The builder is invoked
+// once per level since an Input is consumed by its solve call.
+void run_instance(const std::string& name,
+                  std::size_t nb_jobs,
+                  const std::function<vroom::Input()>& build) {
+  std::vector<BenchResult> results;
+
+  for (unsigned level = 0; level <= MAX_EXPLORATION_LEVEL; ++level) {
+    auto input = build();
+
+    const auto start = std::chrono::high_resolution_clock::now();
+    const auto sol = input.solve(level, NB_THREADS);
+    const auto end = std::chrono::high_resolution_clock::now();
+
+    results.push_back(
+      {level,
+       static_cast<double>(
+         std::chrono::duration_cast<std::chrono::microseconds>(end - start)
+           .count()) /
+         1000,
+       sol.summary.cost,
+       sol.summary.unassigned,
+       vroom::utils::peak_rss_kb()});
+  }
+
+  // Gaps are relative to the best cost across levels, restricted to
+  // runs reaching the lowest unassigned count.
+  const auto min_unassigned =
+    std::min_element(results.begin(),
+                     results.end(),
+                     [](const auto& lhs, const auto& rhs) {
+                       return lhs.unassigned < rhs.unassigned;
+                     })
+      ->unassigned;
+  vroom::Cost best_cost = std::numeric_limits<vroom::Cost>::max();
+  for (const auto& r : results) {
+    if (r.unassigned == min_unassigned) {
+      best_cost = std::min(best_cost, r.cost);
+    }
+  }
+
+  for (const auto& r : results) {
+    const double gap =
+      (best_cost == 0 or r.unassigned != min_unassigned)
+        ? 0
+        : 100 * (static_cast<double>(r.cost) - best_cost) / best_cost;
+    std::cout << "{\"instance\":\"" << name << "\",\"jobs\":" << nb_jobs
+              << ",\"exploration_level\":" << r.exploration_level
+              << ",\"solving_ms\":" << r.solving_ms << ",\"cost\":" << r.cost
+              << ",\"unassigned\":" << r.unassigned << ",\"gap_pct\":" << gap
+              << ",\"peak_rss_kb\":" << r.peak_rss_kb << "}" << std::endl;
+  }
+}
+
+// Random euclidean instance: one depot, jobs with unit delivery and
+// enough homogeneous vehicles to serve everything.
+vroom::Input build_synthetic(std::size_t nb_jobs, unsigned seed) {
+  vroom::Input input(1);
+  const unsigned nb_vehicles =
+    std::max<unsigned>(2, static_cast<unsigned>(nb_jobs) / 25);
+  input.set_trusted(true);
+  input.reserve(nb_jobs, nb_vehicles);
+
+  std::minstd_rand rng(seed);
+  std::uniform_real_distribution<double> coord(0., 100.);
+
+  std::vector<vroom::Coordinates> points;
+  points.reserve(nb_jobs + 1);
+  for (std::size_t i = 0; i <= nb_jobs; ++i) {
+    points.push_back({coord(rng), coord(rng)});
+  }
+
+  vroom::Matrix<vroom::Cost> m(nb_jobs + 1);
+  for (std::size_t i = 0; i <= nb_jobs; ++i) {
+    for (std::size_t j = 0; j <= nb_jobs; ++j) {
+      const auto dx = points[i][0] - points[j][0];
+      const auto dy = points[i][1] - points[j][1];
+      m[i][j] = static_cast<vroom::Cost>(100 * std::sqrt(dx * dx + dy * dy));
+    }
+  }
+  input.set_matrix(vroom::DEFAULT_PROFILE, std::move(m));
+
+  vroom::Amount delivery(1);
+  delivery[0] = 1;
+  for (std::size_t j = 0; j < nb_jobs; ++j) {
+    input.add_job(vroom::Job(j + 1,
+                             vroom::Location(static_cast<vroom::Index>(j + 1),
+                                             points[j + 1]),
+                             0,
+                             delivery));
+  }
+
+  vroom::Amount capacity(1);
+  capacity[0] = 30;
+  const vroom::Location depot(0, points[0]);
+  for (unsigned v = 0; v < nb_vehicles; ++v) {
+    input.add_vehicle(vroom::Vehicle(v + 1,
+                                     depot,
+                                     depot,
+                                     vroom::DEFAULT_PROFILE,
+                                     capacity));
+  }
+
+  return input;
+}
+
+vroom::Input build_from_file(const std::string& file_name) {
+  std::ifstream ifs(file_name);
+  std::stringstream buffer;
+  buffer << ifs.rdbuf();
+
+  vroom::io::CLArgs cl_args;
+  cl_args.input = buffer.str();
+  return vroom::io::parse(cl_args);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  try {
+    if (argc < 2) {
+      // Synthetic scaling series.
+      for (const std::size_t nb_jobs : {100, 250, 500, 1000}) {
+        run_instance("synthetic-" + std::to_string(nb_jobs),
+                     nb_jobs,
+                     [nb_jobs]() { return build_synthetic(nb_jobs, 42); });
+      }
+    } else {
+      for (int i = 1; i < argc; ++i) {
+        const std::string file_name = argv[i];
+        auto probe = build_from_file(file_name);
+        run_instance(file_name, probe.jobs.size(), [&file_name]() {
+          return build_from_file(file_name);
+        });
+      }
+    }
+  } catch (const vroom::Exception& e) {
+    std::cerr << "[Error] " << e.message << std::endl;
+    return 1;
+  } catch (const std::exception& e) {
+    std::cerr << "[Error] " << e.what() << std::endl;
+    return 1;
+  }
+
+  return 0;
+}
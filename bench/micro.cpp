@@ -0,0 +1,202 @@
+/*
+
+This file is part of VROOM.
+
+Copyright (c) 2015-2021, Julien Coupey.
+All rights reserved (see LICENSE).
+
+*/
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "problems/cvrp/operators/exchange.h"
+#include "structures/vroom/input/input.h"
+#include "structures/vroom/solution_state.h"
+#include "structures/vroom/tw_route.h"
+#include "utils/helpers.h"
+
+// Microbenchmark harness for the hot kernels exercised on every
+// candidate move. Fixtures are built from a synthetic euclidean
+// instance solved once, so all internal caches (compatibility
+// matrices, solution state) hold realistic content. Results are
+// printed as NDJSON in nanoseconds per operation.
+
+namespace {
+
+// Accumulating into a volatile sink keeps the measured calls from
+// being optimized away.
+volatile long long sink = 0;
+
+template <typename F> void benchmark(const std::string& name, F&& fn) {
+  // Warm-up.
+  sink += fn();
+
+  std::size_t iterations = 1;
+  double elapsed_ns = 0;
+  while (true) {
+    const auto start = std::chrono::high_resolution_clock::now();
+    for (std::size_t i = 0; i < iterations; ++i) {
+      sink += fn();
+    }
+    const auto end = std::chrono::high_resolution_clock::now();
+    elapsed_ns = static_cast<double>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(end - start)
+        .count());
+    if (elapsed_ns >= 1e8) {
+      break;
+    }
+    iterations *= 4;
+  }
+
+  std::cout << "{\"benchmark\":\"" << name
+            << "\",\"iterations\":" << iterations
+            << ",\"ns_per_op\":" << elapsed_ns / iterations << "}"
+            << std::endl;
+}
+
+vroom::Input build_synthetic(std::size_t nb_jobs, unsigned nb_vehicles) {
+  vroom::Input input(1);
+  input.set_trusted(true);
+  input.reserve(nb_jobs, nb_vehicles);
+
+  std::minstd_rand rng(42);
+  std::uniform_real_distribution<double> coord(0., 100.);
+
+  std::vector<vroom::Coordinates> points;
+  points.reserve(nb_jobs + 1);
+  for (std::size_t i = 0; i <= nb_jobs; ++i) {
+    points.push_back({coord(rng), coord(rng)});
+  }
+
+  vroom::Matrix<vroom::Cost> m(nb_jobs + 1);
+  for (std::size_t i = 0; i <= nb_jobs; ++i) {
+    for (std::size_t j = 0; j <= nb_jobs; ++j) {
+      const auto dx = points[i][0] - points[j][0];
+      const auto dy = points[i][1] - points[j][1];
+      m[i][j] = static_cast<vroom::Cost>(100 * std::sqrt(dx * dx + dy * dy));
+    }
+  }
+  input.set_matrix(vroom::DEFAULT_PROFILE, std::move(m));
+
+  vroom::Amount delivery(1);
+  delivery[0] = 1;
+  // Zero-valued but correctly sized: set_trusted skips the length
+  // checks, so an empty default pickup would trip size assertions
+  // deeper in the solve.
+  const vroom::Amount pickup(1);
+  for (std::size_t j = 0; j < nb_jobs; ++j) {
+    input.add_job(vroom::Job(j + 1,
+                             vroom::Location(static_cast<vroom::Index>(j + 1),
+                                             points[j + 1]),
+                             0,
+                             delivery,
+                             pickup));
+  }
+
+  vroom::Amount capacity(1);
+  capacity[0] = 40;
+  const vroom::Location depot(0, points[0]);
+  for (unsigned v = 0; v < nb_vehicles; ++v) {
+    input.add_vehicle(vroom::Vehicle(v + 1,
+                                     depot,
+                                     depot,
+                                     vroom::DEFAULT_PROFILE,
+                                     capacity));
+  }
+
+  return input;
+}
+
+} // namespace
+
+int main() {
+  constexpr std::size_t nb_jobs = 200;
+  constexpr unsigned nb_vehicles = 8;
+
+  auto input = build_synthetic(nb_jobs, nb_vehicles);
+
+  // Solving once populates the internal caches (compatibility
+  // matrices in particular) the kernels below rely on.
+  const auto sol = input.solve(0, 1);
+
+  // Rebuild raw routes from the solution.
+  std::vector<vroom::RawRoute> raw_sol;
+  for (vroom::Index v = 0; v < nb_vehicles; ++v) {
+    raw_sol.emplace_back(input, v);
+  }
+  for (const auto& route : sol.routes) {
+    auto& raw_route = raw_sol[route.vehicle - 1].route;
+    for (const auto& step : route.steps) {
+      if (step.step_type == vroom::STEP_TYPE::JOB) {
+        raw_route.push_back(input.job_id_to_rank.find(step.id)->second);
+      }
+    }
+  }
+
+  vroom::utils::SolutionState sol_state(input);
+  sol_state.setup(raw_sol);
+
+  const auto& route_0 = raw_sol[0].route;
+  const auto& route_1 = raw_sol[1].route;
+  const auto& vehicle_0 = input.vehicles[0];
+
+  std::size_t tick = 0;
+
+  benchmark("addition_cost", [&]() {
+    const auto job_rank = route_1[tick % route_1.size()];
+    const auto rank = static_cast<vroom::Index>(++tick % route_0.size());
+    return vroom::utils::addition_cost(input,
+                                       job_rank,
+                                       vehicle_0,
+                                       route_0,
+                                       rank);
+  });
+
+  vroom::TWRoute tw_route(input, 0);
+  for (std::size_t r = 0; r < route_0.size(); ++r) {
+    tw_route.add(input, route_0[r], static_cast<vroom::Index>(r));
+  }
+
+  benchmark("is_valid_addition_for_tw", [&]() {
+    const auto job_rank = route_1[tick % route_1.size()];
+    const auto rank = static_cast<vroom::Index>(++tick % route_0.size());
+    return tw_route.is_valid_addition_for_tw(input, job_rank, rank) ? 1 : 0;
+  });
+
+  benchmark("update_cheapest_job_rank_in_routes", [&]() {
+    sol_state.update_cheapest_job_rank_in_routes(route_0, route_1, 0, 1);
+    return 1;
+  });
+
+  vroom::Amount lhs(5);
+  vroom::Amount rhs(5);
+  for (std::size_t i = 0; i < 5; ++i) {
+    lhs[i] = static_cast<vroom::Capacity>(i);
+    rhs[i] = static_cast<vroom::Capacity>(i + 1);
+  }
+
+  benchmark("amount_lexicographic_comparison", [&]() {
+    return (lhs << rhs) ? 1 : 0;
+  });
+
+  benchmark("exchange_compute_gain", [&]() {
+    const auto s_rank = static_cast<vroom::Index>(tick % route_0.size());
+    const auto t_rank = static_cast<vroom::Index>(++tick % route_1.size());
+    vroom::cvrp::Exchange exchange(input,
+                                   sol_state,
+                                   raw_sol[0],
+                                   0,
+                                   s_rank,
+                                   raw_sol[1],
+                                   1,
+                                   t_rank);
+    return exchange.gain();
+  });
+
+  return 0;
+}
@@ -0,0 +1,195 @@
+/*
+
+This file is part of VROOM.
+
+Copyright (c) 2015-2021, Julien Coupey.
+All rights reserved (see LICENSE).
+
+*/
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "structures/cl_args.h"
+#include "structures/vroom/input/input.h"
+#include "utils/exception.h"
+#include "utils/input_parser.h"
+
+// Replay driver turning production request logs into a performance
+// gate: re-run each logged problem through Input::solve in
+// deterministic mode and diff cost, unassigned count and solving
+// time against a recorded baseline, reporting regressions as NDJSON
+// and exiting nonzero when any is found.
+//
+// Usage:
+//   vroom-replay LOG BASELINE [-t THREADS] [-x LEVEL]
+//
+// LOG holds one problem per line in the usual json input format
+// (matrices embedded). When BASELINE does not exist it is recorded
+// from this run; when it does, results are diffed against it. Cost
+// is compared with a 1% tolerance and solving time with a 25% plus
+// 50 ms margin to absorb machine noise; any unassigned increase is a
+// regression. Solves run sequentially so per-line timings are not
+// perturbed, with THREADS (default 4) used inside each solve.
+
+namespace {
+
+constexpr double COST_TOLERANCE = 0.01;
+constexpr double TIME_TOLERANCE = 0.25;
+constexpr double TIME_MARGIN_MS = 50.;
+
+struct ReplayResult {
+  std::size_t line;
+  vroom::Cost cost;
+  unsigned unassigned;
+  double solving_ms;
+};
+
+bool parse_baseline_line(const std::string& line, ReplayResult& result) {
+  long long cost = 0;
+  return std::sscanf(line.c_str(),
+                     "{\"line\":%zu,\"cost\":%lld,\"unassigned\":%u,"
+                     "\"solving_ms\":%lf}",
+                     &result.line,
+                     &cost,
+                     &result.unassigned,
+                     &result.solving_ms) == 4 and
+         (result.cost = static_cast<vroom::Cost>(cost), true);
+}
+
+std::string result_line(const ReplayResult& r) {
+  return "{\"line\":" + std::to_string(r.line) +
+         ",\"cost\":" + std::to_string(r.cost) +
+         ",\"unassigned\":" + std::to_string(r.unassigned) +
+         ",\"solving_ms\":" + std::to_string(r.solving_ms) + "}";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  std::vector<std::string> positional;
+  unsigned nb_threads = 4;
+  unsigned exploration_level = 5;
+
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg = argv[i];
+    if (arg == "-t" and i + 1 < argc) {
+      nb_threads = std::stoul(argv[++i]);
+    } else if (arg == "-x" and i + 1 < argc) {
+      exploration_level = std::stoul(argv[++i]);
+    } else {
+      positional.push_back(arg);
+    }
+  }
+
+  if (positional.size() != 2) {
+    std::cerr << "Usage: vroom-replay LOG BASELINE [-t THREADS] [-x LEVEL]"
+              << std::endl;
+    return 1;
+  }
+
+  std::ifstream log(positional[0]);
+  if (!log.is_open()) {
+    std::cerr << "Cannot open log file " << positional[0] << "." << std::endl;
+    return 1;
+  }
+
+  // Replay every logged problem.
+  std::vector<ReplayResult> results;
+  std::string line;
+  std::size_t line_number = 0;
+  while (std::getline(log, line)) {
+    ++line_number;
+    if (line.empty()) {
+      continue;
+    }
+
+    vroom::io::CLArgs cl_args;
+    cl_args.input = line;
+
+    try {
+      auto input = vroom::io::parse(cl_args);
+      input.set_deterministic(true);
+
+      const auto start = std::chrono::high_resolution_clock::now();
+      const auto sol = input.solve(exploration_level, nb_threads);
+      const auto end = std::chrono::high_resolution_clock::now();
+
+      results.push_back(
+        {line_number,
+         sol.summary.cost,
+         sol.summary.unassigned,
+         static_cast<double>(
+           std::chrono::duration_cast<std::chrono::microseconds>(end - start)
+             .count()) /
+           1000});
+    } catch (const vroom::Exception& e) {
+      std::cerr << "Line " << line_number << ": " << e.message << std::endl;
+      return 1;
+    }
+  }
+
+  std::ifstream baseline_in(positional[1]);
+  if (!baseline_in.is_open()) {
+    // No baseline yet: record one from this run.
+    std::ofstream baseline_out(positional[1]);
+    for (const auto& r : results) {
+      baseline_out << result_line(r) << '\n';
+    }
+    std::cout << "Recorded baseline for " << results.size()
+              << " problems in " << positional[1] << "." << std::endl;
+    return 0;
+  }
+
+  // Diff against the recorded baseline.
+  std::vector<ReplayResult> baseline;
+  while (std::getline(baseline_in, line)) {
+    ReplayResult r;
+    if (parse_baseline_line(line, r)) {
+      baseline.push_back(r);
+    }
+  }
+
+  if (baseline.size() != results.size()) {
+    std::cerr << "Baseline holds " << baseline.size() << " entries but "
+              << results.size() << " problems were replayed." << std::endl;
+    return 1;
+  }
+
+  unsigned regressions = 0;
+  for (std::size_t i = 0; i < results.size(); ++i) {
+    const auto& b = baseline[i];
+    const auto& r = results[i];
+
+    std::string verdict = "ok";
+    if (b.unassigned < r.unassigned) {
+      verdict = "unassigned_regression";
+    } else if (static_cast<double>(b.cost) * (1. + COST_TOLERANCE) <
+               static_cast<double>(r.cost)) {
+      verdict = "cost_regression";
+    } else if (b.solving_ms * (1. + TIME_TOLERANCE) + TIME_MARGIN_MS <
+               r.solving_ms) {
+      verdict = "time_regression";
+    }
+    if (verdict != "ok") {
+      ++regressions;
+    }
+
+    std::cout << "{\"line\":" << r.line << ",\"status\":\"" << verdict
+              << "\",\"cost\":" << r.cost << ",\"baseline_cost\":" << b.cost
+              << ",\"unassigned\":" << r.unassigned
+              << ",\"baseline_unassigned\":" << b.unassigned
+              << ",\"solving_ms\":" << r.solving_ms
+              << ",\"baseline_solving_ms\":" << b.solving_ms << "}"
+              << std::endl;
+  }
+
+  std::cout << regressions << " regression(s) over " << results.size()
+            << " problems." << std::endl;
+
+  return (regressions == 0) ? 0 : 1;
+}
@@ -0,0 +1,88 @@
+#!/usr/bin/env python3
+
+"""Reader for the binary move trace written with VROOM_LS_TRACE.
+
+Prints one tab-separated line per record (timestamp in microseconds,
+operator, source route, target route, gain, accepted), plus a short
+per-operator summary on stderr. See trace_move in
+src/algorithms/local_search/operator.cpp for the file layout.
+"""
+
+import struct
+import sys
+
+MAGIC = 0x5652544C
+VERSION = 1
+HEADER = struct.Struct("<II")
+# timestamp_us, gain, op, s_route, t_route, accepted, padding.
+RECORD = struct.Struct("<QqHHHBb")
+
+OPERATOR_NAMES = [
+    "unassigned_exchange",
+    "exchange",
+    "cross_exchange",
+    "mixed_exchange",
+    "two_opt",
+    "reverse_two_opt",
+    "relocate",
+    "or_opt",
+    "intra_exchange",
+    "intra_cross_exchange",
+    "intra_mixed_exchange",
+    "intra_relocate",
+    "intra_or_opt",
+    "pd_shift",
+    "route_exchange",
+    "job_addition",
+]
+
+
+def main():
+    if len(sys.argv) != 2:
+        print("Usage: {} TRACE_FILE".format(sys.argv[0]), file=sys.stderr)
+        sys.exit(1)
+
+    with open(sys.argv[1], "rb") as trace:
+        magic, version = HEADER.unpack(trace.read(HEADER.size))
+        if magic != MAGIC or version != VERSION:
+            print("Not a move trace file.", file=sys.stderr)
+            sys.exit(1)
+
+        summary = {}
+        while True:
+            chunk = trace.read(RECORD.size)
+            if len(chunk) < RECORD.size:
+                break
+            timestamp, gain, op, s_route, t_route, accepted, _ = RECORD.unpack(
+                chunk
+            )
+            name = (
+                OPERATOR_NAMES[op]
+                if op < len(OPERATOR_NAMES)
+                else "unknown_{}".format(op)
+            )
+            print(
+                "{}\t{}\t{}\t{}\t{}\t{}".format(
+                    timestamp, name, s_route, t_route, gain, accepted
+                )
+            )
+            applied, discarded, total_gain = summary.get(name, (0, 0, 0))
+            if accepted:
+                applied += 1
+                total_gain += gain
+            else:
+                discarded += 1
+            summary[name] = (applied, discarded, total_gain)
+
+    for name in sorted(summary):
+        applied, discarded, total_gain = summary[name]
+        print(
+            "{}: {} applied, {} discarded, total gain {}".format(
+                name, applied, discarded, total_gain
+            ),
+            file=sys.stderr,
+        )
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,87 @@
+#!/usr/bin/env python3
+
+"""Coordinator for a distributed heuristic parameter sweep.
+
+Fans one problem out to several vroom processes, each running its own
+share of the parameter set (-w RANK/COUNT), then keeps the best
+reported solution, ranked like SolutionIndicators: higher assigned
+priority first, then fewer unassigned tasks, then lower cost.
+
+Workers are plain commands: "local" runs vroom on this machine, any
+other value is used as an ssh target expected to have vroom on its
+PATH. The input document is piped to each worker on stdin so fetched
+matrices embedded in it travel along.
+
+Usage:
+  sweep_solve.py -i problem.json -n local,box1,box2 [-- vroom args...]
+"""
+
+import argparse
+import json
+import subprocess
+import sys
+
+
+def worker_command(host, rank, count, vroom_args):
+    command = []
+    if host != "local":
+        command += ["ssh", host]
+    command += ["vroom", "-w", "%d/%d" % (rank, count)] + vroom_args
+    return command
+
+
+def indicators(solution):
+    summary = solution["summary"]
+    return (-summary.get("priority", 0),
+            len(solution.get("unassigned", [])),
+            summary["cost"])
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("-i", required=True, dest="input_file",
+                        help="problem file, piped to all workers")
+    parser.add_argument("-n", required=True, dest="nodes",
+                        help="comma-separated worker list, \"local\" or "
+                        "ssh targets")
+    parser.add_argument("vroom_args", nargs="*",
+                        help="extra arguments passed through to vroom")
+    args = parser.parse_args()
+
+    hosts = args.nodes.split(",")
+    with open(args.input_file, "rb") as f:
+        problem = f.read()
+
+    processes = [
+        subprocess.Popen(worker_command(host, rank, len(hosts),
+                                        args.vroom_args),
+                         stdin=subprocess.PIPE,
+                         stdout=subprocess.PIPE)
+        for rank, host in enumerate(hosts)
+    ]
+
+    best = None
+    for rank, process in enumerate(processes):
+        out, _ = process.communicate(problem)
+        try:
+            solution = json.loads(out)
+        except ValueError:
+            print("worker %d: unreadable output" % rank, file=sys.stderr)
+            continue
+        if solution.get("code", 0) != 0:
+            print("worker %d: %s" % (rank, solution.get("error", "error")),
+                  file=sys.stderr)
+            continue
+        if best is None or indicators(solution) < indicators(best):
+            best = solution
+
+    if best is None:
+        print("no worker returned a solution", file=sys.stderr)
+        sys.exit(1)
+
+    json.dump(best, sys.stdout)
+    print()
+
+
+if __name__ == "__main__":
+    main()
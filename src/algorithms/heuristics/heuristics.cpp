@@ -8,18 +8,19 @@ All rights reserved (see LICENSE).
 */
 
 #include <set>
+#include <unordered_map>
 
 #include "algorithms/heuristics/heuristics.h"
+#include "problems/tsp/tsp.h"
 #include "utils/helpers.h"
 
 namespace vroom {
 namespace heuristics {
 
+namespace {
+
+// See SharedHeuristicData::costs for semantics.
 std::vector<std::vector<Cost>> get_jobs_vehicles_costs(const Input& input) {
-  // For a single job j, costs[j][v] is the cost of fetching job j in
-  // an empty route from vehicle at rank v. For a pickup job j,
-  // costs[j][v] is the cost of fetching job j **and** associated
-  // delivery in an empty route from vehicle at rank v.
   std::vector<std::vector<Cost>> costs(input.jobs.size(),
                                        std::vector<Cost>(
                                          input.vehicles.size()));
@@ -60,21 +61,71 @@ std::vector<std::vector<Cost>> get_jobs_vehicles_costs(const Input& input) {
   return costs;
 }
 
-template <class T> T basic(const Input& input, INIT init, float lambda) {
-  auto nb_vehicles = input.vehicles.size();
-  T routes;
-  for (Index v = 0; v < nb_vehicles; ++v) {
-    routes.emplace_back(input, v);
+// Memoized per-job insertion cost vectors for a route built up one
+// insertion at a time. Each cached vector is aligned with insertion
+// ranks in the route and patched in place when a job gets inserted:
+// only the edge split by the new job is recomputed, so scans in later
+// rounds read warm contiguous deltas instead of redoing three matrix
+// lookups per candidate rank.
+class InsertionCostCache {
+  const Input& _input;
+  const Vehicle& _v;
+  std::unordered_map<Index, std::vector<Gain>> _costs;
+
+public:
+  InsertionCostCache(const Input& input, const Vehicle& v)
+    : _input(input), _v(v) {
   }
 
-  std::set<Index> unassigned;
-  for (Index j = 0; j < input.jobs.size(); ++j) {
-    unassigned.insert(j);
+  const std::vector<Gain>& get(Index job_rank,
+                               const std::vector<Index>& route) {
+    auto search = _costs.find(job_rank);
+    if (search == _costs.end()) {
+      utils::ArenaScope arena_scope;
+      // The cache keeps wide values either way so in-place patches
+      // stay type-independent, only the scan kernel narrows.
+      if (_input.gains_fit_32bit()) {
+        const auto costs =
+          utils::addition_costs<NarrowGain>(_input, job_rank, _v, route);
+        search = _costs
+                   .emplace(job_rank,
+                            std::vector<Gain>(costs.begin(), costs.end()))
+                   .first;
+      } else {
+        const auto costs = utils::addition_costs(_input, job_rank, _v, route);
+        search = _costs
+                   .emplace(job_rank,
+                            std::vector<Gain>(costs.begin(), costs.end()))
+                   .first;
+      }
+    }
+    assert(search->second.size() == route.size() + 1);
+    return search->second;
   }
 
-  // One level of indirection to allow easy ordering of the vehicles
-  // within the heuristic.
-  std::vector<Index> vehicles_ranks(nb_vehicles);
+  // Patch all cached vectors after an insertion at rank in route
+  // (passed after the update): the delta for the edge the new job
+  // splits is replaced by the deltas for the two edges around it.
+  void notify_addition(Index rank, const std::vector<Index>& route) {
+    for (auto& [job_rank, costs] : _costs) {
+      costs[rank] = utils::addition_cost(_input, job_rank, _v, route, rank);
+      costs.insert(costs.begin() + rank + 1,
+                   utils::addition_cost(_input, job_rank, _v, route, rank + 1));
+    }
+  }
+
+  void forget(Index job_rank) {
+    _costs.erase(job_rank);
+  }
+};
+
+} // namespace
+
+SharedHeuristicData::SharedHeuristicData(const Input& input)
+  : costs(get_jobs_vehicles_costs(input)),
+    vehicles_ranks(input.vehicles.size()) {
+  const auto nb_vehicles = input.vehicles.size();
+
   std::iota(vehicles_ranks.begin(), vehicles_ranks.end(), 0);
   // Sort vehicles by "higher" capacity or by time window in case of
   // capacities ties.
@@ -88,13 +139,9 @@ template <class T> T basic(const Input& input, INIT init, float lambda) {
                              v_lhs.tw.length > v_rhs.tw.length);
                    });
 
-  auto costs = get_jobs_vehicles_costs(input);
-
-  // regrets[v][j] holds the min cost for reaching job j in an empty
-  // route across all remaining vehicles **after** vehicle at rank v
-  // in vehicle_ranks.
-  std::vector<std::vector<Cost>> regrets(nb_vehicles,
-                                         std::vector<Cost>(input.jobs.size()));
+  regrets = std::vector<std::vector<Cost>>(nb_vehicles,
+                                           std::vector<Cost>(
+                                             input.jobs.size()));
 
   // Use own cost for last vehicle regret values.
   auto& last_regrets = regrets.back();
@@ -111,12 +158,72 @@ template <class T> T basic(const Input& input, INIT init, float lambda) {
     }
   }
 
+  tw_candidates = std::vector<std::vector<Index>>(nb_vehicles);
+  for (Index v = 0; v < nb_vehicles; ++v) {
+    const auto& vehicle = input.vehicles[v];
+    auto& candidates = tw_candidates[v];
+
+    std::vector<Duration> earliest(input.jobs.size());
+    for (Index j = 0; j < input.jobs.size(); ++j) {
+      if (!input.vehicle_ok_with_job(v, j) or
+          input.jobs[j].type == JOB_TYPE::DELIVERY) {
+        // Compatibility bits already encode static TW reachability,
+        // see Input::set_extra_compatibility.
+        continue;
+      }
+      Duration earliest_service = vehicle.tw.start;
+      if (vehicle.has_start()) {
+        earliest_service +=
+          vehicle.duration(vehicle.start.value().index(),
+                           input.jobs[j].index());
+      }
+      earliest[j] = std::max(earliest_service, input.jobs[j].tws.front().start);
+      candidates.push_back(j);
+    }
+
+    std::stable_sort(candidates.begin(),
+                     candidates.end(),
+                     [&earliest](const auto lhs, const auto rhs) {
+                       return earliest[lhs] < earliest[rhs];
+                     });
+  }
+}
+
+template <class T>
+T basic(const Input& input,
+        const SharedHeuristicData& data,
+        INIT init,
+        float lambda) {
+  auto nb_vehicles = input.vehicles.size();
+  T routes;
+  for (Index v = 0; v < nb_vehicles; ++v) {
+    routes.emplace_back(input, v);
+  }
+
+  std::set<Index> unassigned;
+  for (Index j = 0; j < input.jobs.size(); ++j) {
+    unassigned.insert(j);
+  }
+
+  const auto& vehicles_ranks = data.vehicles_ranks;
+
   for (Index v = 0; v < nb_vehicles; ++v) {
     auto v_rank = vehicles_ranks[v];
     auto& current_r = routes[v_rank];
 
     const auto& vehicle = input.vehicles[v_rank];
 
+    // Hoist seed costs and lambda-weighted regret terms for current
+    // vehicle into contiguous buffers: the scoring below reads them
+    // for every candidate and rank, so conversions and products are
+    // done once per job when the route is opened.
+    std::vector<Cost> seed_costs(input.jobs.size());
+    std::vector<float> lambda_regrets(input.jobs.size());
+    for (Index j = 0; j < input.jobs.size(); ++j) {
+      seed_costs[j] = data.costs[j][v_rank];
+      lambda_regrets[j] = lambda * static_cast<float>(data.regrets[v][j]);
+    }
+
     if (init != INIT::NONE) {
       // Initialize current route with the "best" valid job.
       bool init_ok = false;
@@ -126,9 +233,8 @@ template <class T> T basic(const Input& input, INIT init, float lambda) {
       Cost nearest_cost = std::numeric_limits<Cost>::max();
       Duration earliest_deadline = std::numeric_limits<Duration>::max();
       Index best_job_rank = 0;
-      for (const auto job_rank : unassigned) {
-        if (!input.vehicle_ok_with_job(v_rank, job_rank) or
-            input.jobs[job_rank].type == JOB_TYPE::DELIVERY) {
+      for (const auto job_rank : data.tw_candidates[v_rank]) {
+        if (unassigned.find(job_rank) == unassigned.end()) {
           continue;
         }
 
@@ -147,10 +253,10 @@ template <class T> T basic(const Input& input, INIT init, float lambda) {
           try_validity |= (current_deadline < earliest_deadline);
         }
         if (init == INIT::FURTHEST) {
-          try_validity |= (furthest_cost < costs[job_rank][v_rank]);
+          try_validity |= (furthest_cost < seed_costs[job_rank]);
         }
         if (init == INIT::NEAREST) {
-          try_validity |= (costs[job_rank][v_rank] < nearest_cost);
+          try_validity |= (seed_costs[job_rank] < nearest_cost);
         }
 
         if (!try_validity) {
@@ -198,10 +304,10 @@ template <class T> T basic(const Input& input, INIT init, float lambda) {
                                   : input.jobs[job_rank].tws.back().end;
             break;
           case INIT::FURTHEST:
-            furthest_cost = costs[job_rank][v_rank];
+            furthest_cost = seed_costs[job_rank];
             break;
           case INIT::NEAREST:
-            nearest_cost = costs[job_rank][v_rank];
+            nearest_cost = seed_costs[job_rank];
             break;
           }
         }
@@ -222,6 +328,10 @@ template <class T> T basic(const Input& input, INIT init, float lambda) {
       }
     }
 
+    // Insertion cost vectors are cached across rounds and patched
+    // incrementally as the route grows.
+    InsertionCostCache cache(input, vehicle);
+
     bool keep_going = true;
     while (keep_going) {
       keep_going = false;
@@ -231,28 +341,28 @@ template <class T> T basic(const Input& input, INIT init, float lambda) {
       Index best_pickup_r = 0;
       Index best_delivery_r = 0;
 
-      for (const auto job_rank : unassigned) {
-        if (!input.vehicle_ok_with_job(v_rank, job_rank)) {
-          continue;
-        }
-
-        if (input.jobs[job_rank].type == JOB_TYPE::DELIVERY) {
+      for (const auto job_rank : data.tw_candidates[v_rank]) {
+        if (unassigned.find(job_rank) == unassigned.end()) {
           continue;
         }
 
         if (input.jobs[job_rank].type == JOB_TYPE::SINGLE) {
-          for (Index r = 0; r <= current_r.size(); ++r) {
-            float current_add = utils::addition_cost(input,
-                                                     job_rank,
-                                                     vehicle,
-                                                     current_r.route,
-                                                     r);
+          const auto& job_adds = cache.get(job_rank, current_r.route);
 
-            float current_cost =
-              current_add - lambda * static_cast<float>(regrets[v][job_rank]);
+          // Check slots in best-first cost order: validity checks
+          // stop either at the first valid slot (optimal for this
+          // job) or as soon as slots can't beat the current best.
+          utils::ArenaScope arena_scope;
+          for (const auto r : utils::ranked_addition_ranks(job_adds)) {
+            const float current_add = job_adds[r];
 
-            if (current_cost < best_cost and
-                current_r
+            float current_cost = current_add - lambda_regrets[job_rank];
+
+            if (best_cost <= current_cost) {
+              break;
+            }
+
+            if (current_r
                   .is_valid_addition_for_capacity(input,
                                                   input.jobs[job_rank].pickup,
                                                   input.jobs[job_rank].delivery,
@@ -261,33 +371,28 @@ template <class T> T basic(const Input& input, INIT init, float lambda) {
               best_cost = current_cost;
               best_job_rank = job_rank;
               best_r = r;
+              break;
             }
           }
         }
 
         if (input.jobs[job_rank].type == JOB_TYPE::PICKUP) {
-          // Pre-compute cost of addition for matching delivery.
-          std::vector<Gain> d_adds(current_r.route.size() + 1);
+          // Addition costs for pickup and matching delivery at all
+          // insertion ranks.
+          const auto& p_adds = cache.get(job_rank, current_r.route);
+          const auto& d_adds = cache.get(job_rank + 1, current_r.route);
+
           std::vector<unsigned char> valid_delivery_insertions(
             current_r.route.size() + 1);
 
           for (unsigned d_rank = 0; d_rank <= current_r.route.size();
                ++d_rank) {
-            d_adds[d_rank] = utils::addition_cost(input,
-                                                  job_rank + 1,
-                                                  vehicle,
-                                                  current_r.route,
-                                                  d_rank);
             valid_delivery_insertions[d_rank] =
               current_r.is_valid_addition_for_tw(input, job_rank + 1, d_rank);
           }
 
           for (Index pickup_r = 0; pickup_r <= current_r.size(); ++pickup_r) {
-            Gain p_add = utils::addition_cost(input,
-                                              job_rank,
-                                              vehicle,
-                                              current_r.route,
-                                              pickup_r);
+            const Gain p_add = p_adds[pickup_r];
 
             if (!current_r
                    .is_valid_addition_for_load(input,
@@ -332,8 +437,7 @@ template <class T> T basic(const Input& input, INIT init, float lambda) {
                 current_add = p_add + d_adds[delivery_r];
               }
 
-              float current_cost =
-                current_add - lambda * static_cast<float>(regrets[v][job_rank]);
+              float current_cost = current_add - lambda_regrets[job_rank];
 
               if (current_cost < best_cost) {
                 modified_with_pd.push_back(job_rank + 1);
@@ -376,6 +480,8 @@ template <class T> T basic(const Input& input, INIT init, float lambda) {
         if (input.jobs[best_job_rank].type == JOB_TYPE::SINGLE) {
           current_r.add(input, best_job_rank, best_r);
           unassigned.erase(best_job_rank);
+          cache.forget(best_job_rank);
+          cache.notify_addition(best_r, current_r.route);
           keep_going = true;
         }
         if (input.jobs[best_job_rank].type == JOB_TYPE::PICKUP) {
@@ -392,6 +498,12 @@ template <class T> T basic(const Input& input, INIT init, float lambda) {
                             best_delivery_r);
           unassigned.erase(best_job_rank);
           unassigned.erase(best_job_rank + 1);
+          cache.forget(best_job_rank);
+          cache.forget(best_job_rank + 1);
+          // Patch pickup insertion first, which shifts the delivery
+          // edge one rank to the right.
+          cache.notify_addition(best_pickup_r, current_r.route);
+          cache.notify_addition(best_delivery_r + 1, current_r.route);
           keep_going = true;
         }
       }
@@ -402,7 +514,10 @@ template <class T> T basic(const Input& input, INIT init, float lambda) {
 }
 
 template <class T>
-T dynamic_vehicle_choice(const Input& input, INIT init, float lambda) {
+T dynamic_vehicle_choice(const Input& input,
+                         const SharedHeuristicData& data,
+                         INIT init,
+                         float lambda) {
   auto nb_vehicles = input.vehicles.size();
   T routes;
   for (Index v = 0; v < nb_vehicles; ++v) {
@@ -417,41 +532,72 @@ T dynamic_vehicle_choice(const Input& input, INIT init, float lambda) {
   std::vector<Index> vehicles_ranks(nb_vehicles);
   std::iota(vehicles_ranks.begin(), vehicles_ranks.end(), 0);
 
-  auto costs = get_jobs_vehicles_costs(input);
-
-  while (!vehicles_ranks.empty() and !unassigned.empty()) {
-    // For any unassigned job at j, jobs_min_costs[j]
-    // (resp. jobs_second_min_costs[j]) holds the min cost
-    // (resp. second min cost) of picking the job in an empty route
-    // for any remaining vehicle.
-    std::vector<Cost> jobs_min_costs(input.jobs.size(),
-                                     std::numeric_limits<Cost>::max());
-    std::vector<Cost> jobs_second_min_costs(input.jobs.size(),
-                                            std::numeric_limits<Cost>::max());
-    for (const auto job_rank : unassigned) {
-      for (const auto v_rank : vehicles_ranks) {
-        if (costs[job_rank][v_rank] <= jobs_min_costs[job_rank]) {
-          jobs_second_min_costs[job_rank] = jobs_min_costs[job_rank];
-          jobs_min_costs[job_rank] = costs[job_rank][v_rank];
-        } else {
-          if (costs[job_rank][v_rank] < jobs_second_min_costs[job_rank]) {
-            jobs_second_min_costs[job_rank] = costs[job_rank][v_rank];
-          }
+  const auto& costs = data.costs;
+
+  // For any unassigned job at j, jobs_min_costs[j]
+  // (resp. jobs_second_min_costs[j]) holds the min cost (resp. second
+  // min cost) of picking the job in an empty route for any remaining
+  // vehicle. Both are maintained incrementally across rounds instead
+  // of being rescanned per round: removing a vehicle only affects
+  // jobs for which it attained one of the two smallest costs, and
+  // affects none at all while another vehicle of the same equivalence
+  // class -- an identical cost column -- remains.
+  std::vector<Cost> jobs_min_costs(input.jobs.size(),
+                                   std::numeric_limits<Cost>::max());
+  std::vector<Cost> jobs_second_min_costs(input.jobs.size(),
+                                          std::numeric_limits<Cost>::max());
+  const auto rescan_mins = [&](Index job_rank) {
+    jobs_min_costs[job_rank] = std::numeric_limits<Cost>::max();
+    jobs_second_min_costs[job_rank] = std::numeric_limits<Cost>::max();
+    for (const auto v_rank : vehicles_ranks) {
+      if (costs[job_rank][v_rank] <= jobs_min_costs[job_rank]) {
+        jobs_second_min_costs[job_rank] = jobs_min_costs[job_rank];
+        jobs_min_costs[job_rank] = costs[job_rank][v_rank];
+      } else {
+        if (costs[job_rank][v_rank] < jobs_second_min_costs[job_rank]) {
+          jobs_second_min_costs[job_rank] = costs[job_rank][v_rank];
         }
       }
     }
+  };
+  for (const auto job_rank : unassigned) {
+    rescan_mins(job_rank);
+  }
 
-    // Pick vehicle that has the biggest number of compatible jobs
-    // closest to him than to any other different vehicle.
-    std::vector<unsigned> closest_jobs_count(nb_vehicles, 0);
-    for (const auto job_rank : unassigned) {
-      for (const auto v_rank : vehicles_ranks) {
-        if (costs[job_rank][v_rank] == jobs_min_costs[job_rank]) {
-          ++closest_jobs_count[v_rank];
-        }
+  // closest_jobs_count[v] holds the number of unassigned jobs for
+  // which v matches jobs_min_costs, also patched in place as jobs get
+  // assigned and vehicle removals move the mins.
+  std::vector<unsigned> closest_jobs_count(nb_vehicles, 0);
+  for (const auto job_rank : unassigned) {
+    for (const auto v_rank : vehicles_ranks) {
+      if (costs[job_rank][v_rank] == jobs_min_costs[job_rank]) {
+        ++closest_jobs_count[v_rank];
+      }
+    }
+  }
+
+  // Remaining vehicles per equivalence class, keyed by the class
+  // representative rank.
+  std::vector<unsigned> class_remaining(nb_vehicles, 0);
+  for (const auto v_rank : vehicles_ranks) {
+    ++class_remaining[input.vehicle_class(v_rank)];
+  }
+
+  // Settle an assigned job, downgrading the count of the vehicles it
+  // was closest to.
+  const auto retire_job = [&](Index job_rank) {
+    for (const auto v_rank : vehicles_ranks) {
+      if (costs[job_rank][v_rank] == jobs_min_costs[job_rank]) {
+        assert(closest_jobs_count[v_rank] > 0);
+        --closest_jobs_count[v_rank];
       }
     }
+    unassigned.erase(job_rank);
+  };
 
+  while (!vehicles_ranks.empty() and !unassigned.empty()) {
+    // Pick vehicle that has the biggest number of compatible jobs
+    // closest to him than to any other different vehicle.
     const auto chosen_vehicle =
       std::min_element(vehicles_ranks.begin(),
                        vehicles_ranks.end(),
@@ -469,17 +615,45 @@ T dynamic_vehicle_choice(const Input& input, INIT init, float lambda) {
     auto v_rank = *chosen_vehicle;
     vehicles_ranks.erase(chosen_vehicle);
 
+    // Propagate the removal. A surviving vehicle of the same class
+    // carries an identical cost column, so mins and counts are
+    // untouched; otherwise the chosen vehicle can only have mattered
+    // for jobs where it attained one of the two smallest costs.
+    --class_remaining[input.vehicle_class(v_rank)];
+    if (class_remaining[input.vehicle_class(v_rank)] == 0) {
+      for (const auto job_rank : unassigned) {
+        if (jobs_second_min_costs[job_rank] < costs[job_rank][v_rank]) {
+          continue;
+        }
+        const auto previous_min = jobs_min_costs[job_rank];
+        rescan_mins(job_rank);
+        if (previous_min < jobs_min_costs[job_rank]) {
+          // The chosen vehicle was the single closest one, credit the
+          // vehicles matching the new min.
+          for (const auto other_v : vehicles_ranks) {
+            if (costs[job_rank][other_v] == jobs_min_costs[job_rank]) {
+              ++closest_jobs_count[other_v];
+            }
+          }
+        }
+      }
+    }
+
     // Once current vehicle is decided, regrets[j] holds the min cost
     // of picking the job in an empty route for other remaining
-    // vehicles.
+    // vehicles, which is exactly the maintained min now that the
+    // chosen vehicle is removed.
     std::vector<Cost> regrets(input.jobs.size(),
                               std::numeric_limits<Cost>::max());
     for (const auto job_rank : unassigned) {
-      if (jobs_min_costs[job_rank] < costs[job_rank][v_rank]) {
-        regrets[job_rank] = jobs_min_costs[job_rank];
-      } else {
-        regrets[job_rank] = jobs_second_min_costs[job_rank];
-      }
+      regrets[job_rank] = jobs_min_costs[job_rank];
+    }
+
+    // Hoist lambda-weighted regret terms into a contiguous buffer,
+    // read by the scoring below for every candidate and rank.
+    std::vector<float> lambda_regrets(input.jobs.size());
+    for (Index j = 0; j < input.jobs.size(); ++j) {
+      lambda_regrets[j] = lambda * static_cast<float>(regrets[j]);
     }
 
     const auto& vehicle = input.vehicles[v_rank];
@@ -496,11 +670,10 @@ T dynamic_vehicle_choice(const Input& input, INIT init, float lambda) {
       Cost nearest_cost = std::numeric_limits<Cost>::max();
       Duration earliest_deadline = std::numeric_limits<Duration>::max();
       Index best_job_rank = 0;
-      for (const auto job_rank : unassigned) {
-        if (jobs_min_costs[job_rank] < costs[job_rank][v_rank] or
+      for (const auto job_rank : data.tw_candidates[v_rank]) {
+        if (unassigned.find(job_rank) == unassigned.end() or
             // One of the remaining vehicles is closest to that job.
-            !input.vehicle_ok_with_job(v_rank, job_rank) or
-            input.jobs[job_rank].type == JOB_TYPE::DELIVERY) {
+            jobs_min_costs[job_rank] < costs[job_rank][v_rank]) {
           continue;
         }
 
@@ -583,18 +756,22 @@ T dynamic_vehicle_choice(const Input& input, INIT init, float lambda) {
       if (init_ok) {
         if (input.jobs[best_job_rank].type == JOB_TYPE::SINGLE) {
           current_r.add(input, best_job_rank, 0);
-          unassigned.erase(best_job_rank);
+          retire_job(best_job_rank);
         }
         if (input.jobs[best_job_rank].type == JOB_TYPE::PICKUP) {
           std::vector<Index> p_d(
             {best_job_rank, static_cast<Index>(best_job_rank + 1)});
           current_r.replace(input, p_d.begin(), p_d.end(), 0, 0);
-          unassigned.erase(best_job_rank);
-          unassigned.erase(best_job_rank + 1);
+          retire_job(best_job_rank);
+          retire_job(best_job_rank + 1);
         }
       }
     }
 
+    // Insertion cost vectors are cached across rounds and patched
+    // incrementally as the route grows.
+    InsertionCostCache cache(input, vehicle);
+
     bool keep_going = true;
     while (keep_going) {
       keep_going = false;
@@ -604,28 +781,28 @@ T dynamic_vehicle_choice(const Input& input, INIT init, float lambda) {
       Index best_pickup_r = 0;
       Index best_delivery_r = 0;
 
-      for (const auto job_rank : unassigned) {
-        if (!input.vehicle_ok_with_job(v_rank, job_rank)) {
-          continue;
-        }
-
-        if (input.jobs[job_rank].type == JOB_TYPE::DELIVERY) {
+      for (const auto job_rank : data.tw_candidates[v_rank]) {
+        if (unassigned.find(job_rank) == unassigned.end()) {
           continue;
         }
 
         if (input.jobs[job_rank].type == JOB_TYPE::SINGLE) {
-          for (Index r = 0; r <= current_r.size(); ++r) {
-            float current_add = utils::addition_cost(input,
-                                                     job_rank,
-                                                     vehicle,
-                                                     current_r.route,
-                                                     r);
+          const auto& job_adds = cache.get(job_rank, current_r.route);
+
+          // Check slots in best-first cost order: validity checks
+          // stop either at the first valid slot (optimal for this
+          // job) or as soon as slots can't beat the current best.
+          utils::ArenaScope arena_scope;
+          for (const auto r : utils::ranked_addition_ranks(job_adds)) {
+            const float current_add = job_adds[r];
+
+            float current_cost = current_add - lambda_regrets[job_rank];
 
-            float current_cost =
-              current_add - lambda * static_cast<float>(regrets[job_rank]);
+            if (best_cost <= current_cost) {
+              break;
+            }
 
-            if (current_cost < best_cost and
-                current_r
+            if (current_r
                   .is_valid_addition_for_capacity(input,
                                                   input.jobs[job_rank].pickup,
                                                   input.jobs[job_rank].delivery,
@@ -634,33 +811,28 @@ T dynamic_vehicle_choice(const Input& input, INIT init, float lambda) {
               best_cost = current_cost;
               best_job_rank = job_rank;
               best_r = r;
+              break;
             }
           }
         }
 
         if (input.jobs[job_rank].type == JOB_TYPE::PICKUP) {
-          // Pre-compute cost of addition for matching delivery.
-          std::vector<Gain> d_adds(current_r.route.size() + 1);
+          // Addition costs for pickup and matching delivery at all
+          // insertion ranks.
+          const auto& p_adds = cache.get(job_rank, current_r.route);
+          const auto& d_adds = cache.get(job_rank + 1, current_r.route);
+
           std::vector<unsigned char> valid_delivery_insertions(
             current_r.route.size() + 1);
 
           for (unsigned d_rank = 0; d_rank <= current_r.route.size();
                ++d_rank) {
-            d_adds[d_rank] = utils::addition_cost(input,
-                                                  job_rank + 1,
-                                                  vehicle,
-                                                  current_r.route,
-                                                  d_rank);
             valid_delivery_insertions[d_rank] =
               current_r.is_valid_addition_for_tw(input, job_rank + 1, d_rank);
           }
 
           for (Index pickup_r = 0; pickup_r <= current_r.size(); ++pickup_r) {
-            Gain p_add = utils::addition_cost(input,
-                                              job_rank,
-                                              vehicle,
-                                              current_r.route,
-                                              pickup_r);
+            const Gain p_add = p_adds[pickup_r];
 
             if (!current_r
                    .is_valid_addition_for_load(input,
@@ -705,8 +877,7 @@ T dynamic_vehicle_choice(const Input& input, INIT init, float lambda) {
                 current_add = p_add + d_adds[delivery_r];
               }
 
-              float current_cost =
-                current_add - lambda * static_cast<float>(regrets[job_rank]);
+              float current_cost = current_add - lambda_regrets[job_rank];
 
               if (current_cost < best_cost) {
                 modified_with_pd.push_back(job_rank + 1);
@@ -748,7 +919,9 @@ T dynamic_vehicle_choice(const Input& input, INIT init, float lambda) {
       if (best_cost < std::numeric_limits<float>::max()) {
         if (input.jobs[best_job_rank].type == JOB_TYPE::SINGLE) {
           current_r.add(input, best_job_rank, best_r);
-          unassigned.erase(best_job_rank);
+          retire_job(best_job_rank);
+          cache.forget(best_job_rank);
+          cache.notify_addition(best_r, current_r.route);
           keep_going = true;
         }
         if (input.jobs[best_job_rank].type == JOB_TYPE::PICKUP) {
@@ -763,8 +936,14 @@ T dynamic_vehicle_choice(const Input& input, INIT init, float lambda) {
                             modified_with_pd.end(),
                             best_pickup_r,
                             best_delivery_r);
-          unassigned.erase(best_job_rank);
-          unassigned.erase(best_job_rank + 1);
+          retire_job(best_job_rank);
+          retire_job(best_job_rank + 1);
+          cache.forget(best_job_rank);
+          cache.forget(best_job_rank + 1);
+          // Patch pickup insertion first, which shifts the delivery
+          // edge one rank to the right.
+          cache.notify_addition(best_pickup_r, current_r.route);
+          cache.notify_addition(best_delivery_r + 1, current_r.route);
           keep_going = true;
         }
       }
@@ -774,20 +953,565 @@ T dynamic_vehicle_choice(const Input& input, INIT init, float lambda) {
   return routes;
 }
 
+template <class T>
+T beam(const Input& input, const SharedHeuristicData& data, float lambda) {
+  const auto nb_vehicles = input.vehicles.size();
+
+  // Number of partial assignments kept at each construction step.
+  constexpr std::size_t beam_width = 4;
+
+  // Partial assignment of jobs to routes.
+  struct BeamState {
+    T routes;
+    std::set<Index> unassigned;
+    Priority priority_sum;
+    float cost_sum;
+  };
+
+  // Rank states consistently with SolutionIndicators.
+  auto state_cmp = [](const BeamState& lhs, const BeamState& rhs) {
+    if (lhs.priority_sum != rhs.priority_sum) {
+      return lhs.priority_sum > rhs.priority_sum;
+    }
+    if (lhs.unassigned.size() != rhs.unassigned.size()) {
+      return lhs.unassigned.size() < rhs.unassigned.size();
+    }
+    return lhs.cost_sum < rhs.cost_sum;
+  };
+
+  // Best valid insertion found for a given job in the route of
+  // current vehicle.
+  struct BeamCandidate {
+    Priority priority;
+    float addition;
+    float score;
+    Index job_rank;
+    Index single_r;
+    Index pickup_r;
+    Index delivery_r;
+  };
+
+  std::vector<BeamState> beam(1);
+  for (Index v = 0; v < nb_vehicles; ++v) {
+    beam.front().routes.emplace_back(input, v);
+  }
+  for (Index j = 0; j < input.jobs.size(); ++j) {
+    beam.front().unassigned.insert(j);
+  }
+  beam.front().priority_sum = 0;
+  beam.front().cost_sum = 0;
+
+  for (Index v = 0; v < nb_vehicles; ++v) {
+    const auto v_rank = data.vehicles_ranks[v];
+    const auto& vehicle = input.vehicles[v_rank];
+
+    // Hoist lambda-weighted regret terms for current vehicle, see
+    // basic().
+    std::vector<float> lambda_regrets(input.jobs.size());
+    for (Index j = 0; j < input.jobs.size(); ++j) {
+      lambda_regrets[j] = lambda * static_cast<float>(data.regrets[v][j]);
+    }
+
+    // States whose route for current vehicle can't take any more job.
+    std::vector<BeamState> done;
+
+    auto frontier = std::move(beam);
+    beam = std::vector<BeamState>();
+
+    while (!frontier.empty()) {
+      std::vector<BeamState> extended;
+
+      for (auto& state : frontier) {
+        auto& current_r = state.routes[v_rank];
+
+        // Insertion cost vectors below only live while expanding this
+        // state.
+        utils::ArenaScope arena_scope;
+
+        std::vector<BeamCandidate> candidates;
+
+        for (const auto job_rank : state.unassigned) {
+          if (!input.vehicle_ok_with_job(v_rank, job_rank)) {
+            continue;
+          }
+
+          if (input.jobs[job_rank].type == JOB_TYPE::DELIVERY) {
+            continue;
+          }
+
+          float job_best_cost = std::numeric_limits<float>::max();
+          BeamCandidate c{input.jobs[job_rank].priority,
+                          0,
+                          0,
+                          job_rank,
+                          0,
+                          0,
+                          0};
+
+          if (input.jobs[job_rank].type == JOB_TYPE::SINGLE) {
+            const auto job_adds =
+              utils::addition_costs(input, job_rank, vehicle, current_r.route);
+
+            for (Index r = 0; r <= current_r.size(); ++r) {
+              const float current_add = job_adds[r];
+
+              float current_cost = current_add - lambda_regrets[job_rank];
+
+              if (current_cost < job_best_cost and
+                  current_r
+                    .is_valid_addition_for_capacity(input,
+                                                    input.jobs[job_rank].pickup,
+                                                    input.jobs[job_rank]
+                                                      .delivery,
+                                                    r) and
+                  current_r.is_valid_addition_for_tw(input, job_rank, r)) {
+                job_best_cost = current_cost;
+                c.addition = current_add;
+                c.single_r = r;
+              }
+            }
+          }
+
+          if (input.jobs[job_rank].type == JOB_TYPE::PICKUP) {
+            c.priority += input.jobs[job_rank + 1].priority;
+
+            // Pre-compute addition costs for pickup and matching
+            // delivery at all insertion ranks.
+            const auto p_adds = utils::addition_costs(input,
+                                                      job_rank,
+                                                      vehicle,
+                                                      current_r.route);
+            const auto d_adds = utils::addition_costs(input,
+                                                      job_rank + 1,
+                                                      vehicle,
+                                                      current_r.route);
+
+            std::vector<unsigned char> valid_delivery_insertions(
+              current_r.route.size() + 1);
+
+            for (unsigned d_rank = 0; d_rank <= current_r.route.size();
+                 ++d_rank) {
+              valid_delivery_insertions[d_rank] =
+                current_r.is_valid_addition_for_tw(input, job_rank + 1, d_rank);
+            }
+
+            for (Index pickup_r = 0; pickup_r <= current_r.size(); ++pickup_r) {
+              const Gain p_add = p_adds[pickup_r];
+
+              if (!current_r
+                     .is_valid_addition_for_load(input,
+                                                 input.jobs[job_rank].pickup,
+                                                 pickup_r) or
+                  !current_r.is_valid_addition_for_tw(input,
+                                                      job_rank,
+                                                      pickup_r)) {
+                continue;
+              }
+
+              // Build replacement sequence for current insertion.
+              std::vector<Index> modified_with_pd({job_rank});
+              Amount modified_delivery = input.zero_amount();
+
+              for (Index delivery_r = pickup_r; delivery_r <= current_r.size();
+                   ++delivery_r) {
+                // Update state variables along the way before
+                // potential early abort.
+                if (pickup_r < delivery_r) {
+                  modified_with_pd.push_back(current_r.route[delivery_r - 1]);
+                  const auto& new_modified_job =
+                    input.jobs[current_r.route[delivery_r - 1]];
+                  if (new_modified_job.type == JOB_TYPE::SINGLE) {
+                    modified_delivery += new_modified_job.delivery;
+                  }
+                }
+
+                if (!(bool)valid_delivery_insertions[delivery_r]) {
+                  continue;
+                }
+
+                float current_add;
+                if (pickup_r == delivery_r) {
+                  current_add = utils::addition_cost(input,
+                                                     job_rank,
+                                                     vehicle,
+                                                     current_r.route,
+                                                     pickup_r,
+                                                     pickup_r + 1);
+                } else {
+                  current_add = p_add + d_adds[delivery_r];
+                }
+
+                float current_cost = current_add - lambda_regrets[job_rank];
+
+                if (current_cost < job_best_cost) {
+                  modified_with_pd.push_back(job_rank + 1);
+
+                  // Update best cost depending on validity.
+                  bool valid =
+                    current_r
+                      .is_valid_addition_for_capacity_inclusion(
+                        input,
+                        modified_delivery,
+                        modified_with_pd.begin(),
+                        modified_with_pd.end(),
+                        pickup_r,
+                        delivery_r);
+
+                  valid = valid &&
+                          current_r
+                            .is_valid_addition_for_tw(input,
+                                                      modified_with_pd.begin(),
+                                                      modified_with_pd.end(),
+                                                      pickup_r,
+                                                      delivery_r);
+
+                  modified_with_pd.pop_back();
+
+                  if (valid) {
+                    job_best_cost = current_cost;
+                    c.addition = current_add;
+                    c.pickup_r = pickup_r;
+                    c.delivery_r = delivery_r;
+                  }
+                }
+              }
+            }
+          }
+
+          if (job_best_cost < std::numeric_limits<float>::max()) {
+            c.score = job_best_cost;
+            candidates.push_back(c);
+          }
+        }
+
+        if (candidates.empty()) {
+          done.push_back(std::move(state));
+          continue;
+        }
+
+        // Branch on the most promising insertions only: higher job
+        // priority first, then lower regret-adjusted cost.
+        if (candidates.size() > beam_width) {
+          std::partial_sort(candidates.begin(),
+                            candidates.begin() + beam_width,
+                            candidates.end(),
+                            [](const auto& lhs, const auto& rhs) {
+                              return lhs.priority > rhs.priority or
+                                     (lhs.priority == rhs.priority and
+                                      lhs.score < rhs.score);
+                            });
+          candidates.resize(beam_width);
+        }
+
+        for (const auto& c : candidates) {
+          extended.push_back(state);
+          auto& next = extended.back();
+          auto& next_r = next.routes[v_rank];
+
+          if (input.jobs[c.job_rank].type == JOB_TYPE::SINGLE) {
+            next_r.add(input, c.job_rank, c.single_r);
+            next.unassigned.erase(c.job_rank);
+          } else {
+            std::vector<Index> modified_with_pd({c.job_rank});
+            std::copy(next_r.route.begin() + c.pickup_r,
+                      next_r.route.begin() + c.delivery_r,
+                      std::back_inserter(modified_with_pd));
+            modified_with_pd.push_back(c.job_rank + 1);
+
+            next_r.replace(input,
+                           modified_with_pd.begin(),
+                           modified_with_pd.end(),
+                           c.pickup_r,
+                           c.delivery_r);
+            next.unassigned.erase(c.job_rank);
+            next.unassigned.erase(c.job_rank + 1);
+          }
+          next.priority_sum += c.priority;
+          next.cost_sum += c.addition;
+        }
+      }
+
+      if (extended.size() > beam_width) {
+        std::partial_sort(extended.begin(),
+                          extended.begin() + beam_width,
+                          extended.end(),
+                          state_cmp);
+        extended.resize(beam_width);
+      }
+      frontier = std::move(extended);
+    }
+
+    std::sort(done.begin(), done.end(), state_cmp);
+    if (done.size() > beam_width) {
+      done.resize(beam_width);
+    }
+    beam = std::move(done);
+  }
+
+  assert(!beam.empty());
+  return std::move(beam.front().routes);
+}
+
+template <class T> T giant_tour(const Input& input) {
+  T routes;
+  for (Index v = 0; v < input.vehicles.size(); ++v) {
+    routes.emplace_back(input, v);
+  }
+
+  const auto& v0 = input.vehicles[0];
+  const auto& capacity = v0.capacity;
+
+  // Jobs no vehicle can serve (or that don't fit in an empty
+  // vehicle) would void whole tour segments, leave them out.
+  std::vector<Index> job_ranks;
+  for (Index j = 0; j < input.jobs.size(); ++j) {
+    if (input.vehicle_ok_with_job(0, j) and
+        input.jobs[j].pickup <= capacity and
+        input.jobs[j].delivery <= capacity) {
+      job_ranks.push_back(j);
+    }
+  }
+  if (job_ranks.empty()) {
+    return routes;
+  }
+
+  // Build a single giant tour over all jobs. Threading is handled
+  // one level up, across heuristic runs.
+  TSP tsp(input, std::move(job_ranks), 0);
+  const auto tour = tsp.raw_solve(1);
+  const std::size_t m = tour.size();
+
+  // Cost of getting to (resp. away from) a job opening (resp.
+  // closing) a route, and travel cost prefix sums along the tour.
+  std::vector<Cost> first_costs(m, 0);
+  std::vector<Cost> last_costs(m, 0);
+  std::vector<Cost> leg_sums(m, 0);
+  for (std::size_t t = 0; t < m; ++t) {
+    const auto j_index = input.jobs[tour[t]].index();
+    if (v0.has_start()) {
+      first_costs[t] = v0.cost(v0.start.value().index(), j_index);
+    }
+    if (v0.has_end()) {
+      last_costs[t] = v0.cost(j_index, v0.end.value().index());
+    }
+    if (t + 1 < m) {
+      leg_sums[t + 1] =
+        leg_sums[t] + v0.cost(j_index, input.jobs[tour[t + 1]].index());
+    }
+  }
+
+  // Split DP: f[k][i] is the cheapest way to serve the first i tour
+  // jobs with k routes, cutting the tour into consecutive segments.
+  // Thanks to Amount prefix sums maintained while extending the
+  // candidate segment, capacity feasibility is O(1) per extension
+  // and caps the inner loop since the load peak only grows with the
+  // segment.
+  constexpr Cost infeasible = std::numeric_limits<Cost>::max();
+  const std::size_t max_splits = std::min<std::size_t>(routes.size(), m);
+
+  std::vector<std::vector<Cost>> f(max_splits + 1,
+                                   std::vector<Cost>(m + 1, infeasible));
+  std::vector<std::vector<std::size_t>>
+    splits(max_splits + 1, std::vector<std::size_t>(m + 1, 0));
+  f[0][0] = 0;
+
+  for (std::size_t k = 1; k <= max_splits; ++k) {
+    for (std::size_t i = k - 1; i < m; ++i) {
+      if (f[k - 1][i] == infeasible) {
+        continue;
+      }
+      // Segment load profile: deliveries are on board upfront, then
+      // each job trades its delivery for its pickup. The peak is the
+      // segment delivery sum plus the best prefix excess.
+      Amount seg_delivery(input.zero_amount());
+      Amount seg_excess(input.zero_amount());
+      Amount max_excess(input.zero_amount());
+
+      for (std::size_t t = i; t < m; ++t) {
+        const auto& job = input.jobs[tour[t]];
+        seg_delivery += job.delivery;
+        seg_excess += job.pickup;
+        seg_excess -= job.delivery;
+        for (std::size_t c = 0; c < seg_excess.size(); ++c) {
+          max_excess[c] = std::max(max_excess[c], seg_excess[c]);
+        }
+        const Amount seg_peak = seg_delivery + max_excess;
+        if (!(seg_peak <= capacity)) {
+          break;
+        }
+
+        const Cost candidate = f[k - 1][i] + first_costs[i] +
+                               (leg_sums[t] - leg_sums[i]) + last_costs[t];
+        if (candidate < f[k][t + 1]) {
+          f[k][t + 1] = candidate;
+          splits[k][t + 1] = i;
+        }
+      }
+    }
+  }
+
+  // Retain the cheapest split serving the longest feasible tour
+  // prefix, leaving any remainder unassigned.
+  std::size_t served = m;
+  std::size_t best_k = 0;
+  Cost best_cost = infeasible;
+  while (true) {
+    for (std::size_t k = 0; k <= max_splits; ++k) {
+      if (f[k][served] < best_cost) {
+        best_cost = f[k][served];
+        best_k = k;
+      }
+    }
+    if (best_cost != infeasible) {
+      break;
+    }
+    assert(served > 0);
+    --served;
+  }
+
+  std::vector<std::size_t> cuts(best_k + 1);
+  cuts[best_k] = served;
+  for (std::size_t k = best_k; k > 0; --k) {
+    cuts[k - 1] = splits[k][cuts[k]];
+  }
+
+  for (std::size_t k = 0; k < best_k; ++k) {
+    auto& route = routes[k];
+    for (std::size_t t = cuts[k]; t < cuts[k + 1]; ++t) {
+      // Time windows are not part of the split model, appends they
+      // rule out are simply left unassigned for local search to
+      // recover.
+      if (route.is_valid_addition_for_tw(input, tour[t], route.size())) {
+        route.add(input, tour[t], route.size());
+      }
+    }
+  }
+
+  return routes;
+}
+
+template <class T> T initial_routes(const Input& input) {
+  T routes;
+  for (Index v = 0; v < input.vehicles.size(); ++v) {
+    auto& vehicle = input.vehicles[v];
+    routes.emplace_back(input, v);
+
+    // Startup load is the sum of deliveries for single jobs.
+    Amount single_jobs_deliveries(input.zero_amount());
+    std::vector<Index> job_ranks;
+    std::unordered_set<Index> expected_delivery_ranks;
+    for (const auto& step : vehicle.steps) {
+      if (step.type != STEP_TYPE::JOB) {
+        continue;
+      }
+      const auto job_rank = step.rank;
+      const auto& job = input.jobs[job_rank];
+
+      if (!input.vehicle_ok_with_job(v, job_rank)) {
+        throw Exception(ERROR::INPUT,
+                        "Missing skills or insufficient capacity for job " +
+                          std::to_string(job.id) + " in route for vehicle " +
+                          std::to_string(vehicle.id) + ".");
+      }
+      job_ranks.push_back(job_rank);
+
+      switch (job.type) {
+      case JOB_TYPE::SINGLE:
+        single_jobs_deliveries += job.delivery;
+        break;
+      case JOB_TYPE::PICKUP:
+        expected_delivery_ranks.insert(job_rank + 1);
+        break;
+      case JOB_TYPE::DELIVERY: {
+        auto search = expected_delivery_ranks.find(job_rank);
+        if (search == expected_delivery_ranks.end()) {
+          throw Exception(ERROR::INPUT,
+                          "Delivery with id " + std::to_string(job.id) +
+                            " before matching pickup in route for vehicle " +
+                            std::to_string(vehicle.id) + ".");
+        }
+        expected_delivery_ranks.erase(search);
+        break;
+      }
+      }
+    }
+    if (!expected_delivery_ranks.empty()) {
+      throw Exception(ERROR::INPUT,
+                      "Unmatched pickup in route for vehicle " +
+                        std::to_string(vehicle.id) + ".");
+    }
+
+    if (job_ranks.empty()) {
+      continue;
+    }
+
+    // Check load along the route against vehicle capacity.
+    Amount current_load = single_jobs_deliveries;
+    bool valid_load = (current_load <= vehicle.capacity);
+    for (const auto job_rank : job_ranks) {
+      const auto& job = input.jobs[job_rank];
+      current_load += job.pickup;
+      current_load -= job.delivery;
+      valid_load = valid_load and (current_load <= vehicle.capacity);
+    }
+    if (!valid_load) {
+      throw Exception(ERROR::INPUT,
+                      "Route over capacity for vehicle " +
+                        std::to_string(vehicle.id) + ".");
+    }
+
+    if (!routes.back().is_valid_addition_for_tw(input,
+                                                job_ranks.begin(),
+                                                job_ranks.end(),
+                                                0,
+                                                0)) {
+      throw Exception(ERROR::INPUT,
+                      "Infeasible route for vehicle " +
+                        std::to_string(vehicle.id) + ".");
+    }
+
+    routes.back().replace(input, job_ranks.begin(), job_ranks.end(), 0, 0);
+  }
+
+  return routes;
+}
+
 using RawSolution = std::vector<RawRoute>;
 using TWSolution = std::vector<TWRoute>;
 
-template RawSolution basic(const Input& input, INIT init, float lambda);
+template RawSolution basic(const Input& input,
+                           const SharedHeuristicData& data,
+                           INIT init,
+                           float lambda);
 
 template RawSolution dynamic_vehicle_choice(const Input& input,
+                                            const SharedHeuristicData& data,
                                             INIT init,
                                             float lambda);
 
-template TWSolution basic(const Input& input, INIT init, float lambda);
+template TWSolution basic(const Input& input,
+                          const SharedHeuristicData& data,
+                          INIT init,
+                          float lambda);
 
 template TWSolution dynamic_vehicle_choice(const Input& input,
+                                           const SharedHeuristicData& data,
                                            INIT init,
                                            float lambda);
 
+template RawSolution beam(const Input& input,
+                          const SharedHeuristicData& data,
+                          float lambda);
+
+template TWSolution beam(const Input& input,
+                         const SharedHeuristicData& data,
+                         float lambda);
+
+template RawSolution giant_tour(const Input& input);
+template TWSolution giant_tour(const Input& input);
+
+template RawSolution initial_routes(const Input& input);
+template TWSolution initial_routes(const Input& input);
+
 } // namespace heuristics
 } // namespace vroom
@@ -15,12 +15,70 @@ All rights reserved (see LICENSE).
 namespace vroom {
 namespace heuristics {
 
+// Invariant data shared by all runs of the constructive heuristics
+// within a solve. Nothing in here depends on the INIT and lambda
+// parameters, so it is built once and read concurrently by all
+// parameter sets instead of being recomputed from scratch per run.
+struct SharedHeuristicData {
+  // For a single job j, costs[j][v] is the cost of fetching job j in
+  // an empty route from vehicle at rank v. For a pickup job j,
+  // costs[j][v] is the cost of fetching job j **and** associated
+  // delivery in an empty route from vehicle at rank v.
+  std::vector<std::vector<Cost>> costs;
+
+  // Vehicles sorted by "higher" capacity, or by time window length in
+  // case of capacities ties, as browsed by basic().
+  std::vector<Index> vehicles_ranks;
+
+  // regrets[v][j] holds the min cost for reaching job j in an empty
+  // route across all vehicles **after** rank v in vehicles_ranks,
+  // used by basic().
+  std::vector<std::vector<Cost>> regrets;
+
+  // For each vehicle, compatible non-delivery candidate job ranks
+  // sorted by earliest feasible service time: vehicle TW start plus
+  // travel from the vehicle start, clamped to the job's first window
+  // opening. Construction scans iterate these instead of the whole
+  // unassigned set, so statically infeasible candidates are pruned
+  // once up front and plausible ones come out in temporal order.
+  std::vector<std::vector<Index>> tw_candidates;
+
+  SharedHeuristicData(const Input& input);
+};
+
 // Implementation of a variant of the Solomon I1 heuristic.
-template <class T> T basic(const Input& input, INIT init, float lambda);
+template <class T>
+T basic(const Input& input,
+        const SharedHeuristicData& data,
+        INIT init,
+        float lambda);
 
 // Adjusting the above for situation with heterogeneous fleet.
 template <class T>
-T dynamic_vehicle_choice(const Input& input, INIT init, float lambda);
+T dynamic_vehicle_choice(const Input& input,
+                         const SharedHeuristicData& data,
+                         INIT init,
+                         float lambda);
+
+// Beam-search construction keeping several partial assignments at
+// each step, ranked consistently with SolutionIndicators: higher
+// priority sum first, then fewer unassigned jobs, then lower
+// cost. Only run on instances with job priorities, where the greedy
+// choices above can strand high-priority jobs.
+template <class T>
+T beam(const Input& input, const SharedHeuristicData& data, float lambda);
+
+// Order-first, split-second construction: a single giant tour over
+// all compatible jobs, built with the TSP machinery, is optimally
+// cut into consecutive vehicle routes by a split DP honoring
+// capacity through Amount prefix sums. Much cheaper than the
+// insertion heuristics above on homogeneous fleets, where any tour
+// segment can go to any vehicle.
+template <class T> T giant_tour(const Input& input);
+
+// Build a solution from the steps provided in input for each
+// vehicle, throwing iff any of those routes is invalid.
+template <class T> T initial_routes(const Input& input);
 
 } // namespace heuristics
 } // namespace vroom
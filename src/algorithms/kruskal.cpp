@@ -8,6 +8,8 @@ All rights reserved (see LICENSE).
 */
 
 #include <algorithm>
+#include <cassert>
+#include <limits>
 #include <numeric>
 
 #include "algorithms/kruskal.h"
@@ -60,8 +62,56 @@ UndirectedGraph<T> minimum_spanning_tree(const UndirectedGraph<T>& graph) {
   return UndirectedGraph<T>(mst);
 }
 
+template <class T>
+UndirectedGraph<T> minimum_spanning_tree(const Matrix<T>& m) {
+  assert(m.size() > 0);
+
+  // Prim's algorithm on the dense matrix: O(n²) time and O(n) extra
+  // memory, while sorting the materialized edge list above requires
+  // O(n².log(n)) time and O(n²) memory.
+  std::vector<bool> in_tree(m.size(), false);
+  std::vector<T> min_weight(m.size(), std::numeric_limits<T>::max());
+  std::vector<Index> closest_vertex(m.size(), 0);
+
+  in_tree[0] = true;
+  for (Index v = 1; v < m.size(); ++v) {
+    min_weight[v] = m[0][v];
+  }
+
+  std::vector<Edge<T>> mst;
+  mst.reserve(m.size() - 1);
+
+  for (std::size_t e = 1; e < m.size(); ++e) {
+    // Pick vertex with smallest connecting weight among those not in
+    // the tree yet.
+    T current_min = std::numeric_limits<T>::max();
+    Index chosen = 0;
+    for (Index v = 0; v < m.size(); ++v) {
+      if (!in_tree[v] and min_weight[v] < current_min) {
+        current_min = min_weight[v];
+        chosen = v;
+      }
+    }
+
+    in_tree[chosen] = true;
+    mst.emplace_back(closest_vertex[chosen], chosen, min_weight[chosen]);
+
+    // Update candidate weights based on newly added vertex.
+    for (Index v = 0; v < m.size(); ++v) {
+      if (!in_tree[v] and m[chosen][v] < min_weight[v]) {
+        min_weight[v] = m[chosen][v];
+        closest_vertex[v] = chosen;
+      }
+    }
+  }
+
+  return UndirectedGraph<T>(std::move(mst));
+}
+
 template UndirectedGraph<Cost>
 minimum_spanning_tree(const UndirectedGraph<Cost>& graph);
 
+template UndirectedGraph<Cost> minimum_spanning_tree(const Matrix<Cost>& m);
+
 } // namespace utils
 } // namespace vroom
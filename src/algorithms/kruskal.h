@@ -18,6 +18,10 @@ namespace utils {
 template <class T>
 UndirectedGraph<T> minimum_spanning_tree(const UndirectedGraph<T>& graph);
 
+// Overload working directly on a dense matrix with Prim's algorithm,
+// avoiding materialization and sorting of the full edge list.
+template <class T> UndirectedGraph<T> minimum_spanning_tree(const Matrix<T>& m);
+
 } // namespace utils
 } // namespace vroom
 
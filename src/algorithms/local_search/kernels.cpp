@@ -0,0 +1,58 @@
+/*
+
+This file is part of VROOM.
+
+Copyright (c) 2015-2021, Julien Coupey.
+All rights reserved (see LICENSE).
+
+*/
+
+#include "algorithms/local_search/kernels.h"
+
+namespace vroom {
+namespace ls {
+
+Gain job_route_cost(const Input& input,
+                    const utils::SolutionState& sol_state,
+                    const std::vector<Index>& source_route,
+                    const std::vector<Index>& target_route,
+                    Index v_target,
+                    Index v,
+                    Index r) {
+  assert(v != v_target);
+
+  Gain cost = static_cast<Gain>(INFINITE_COST);
+  const auto job_index = input.jobs[source_route[r]].index();
+
+  const auto& vehicle = input.vehicles[v_target];
+  if (vehicle.has_start()) {
+    const auto start_index = vehicle.start.value().index();
+    const Gain start_cost = vehicle.cost(start_index, job_index);
+    cost = std::min(cost, start_cost);
+  }
+  if (vehicle.has_end()) {
+    const auto end_index = vehicle.end.value().index();
+    const Gain end_cost = vehicle.cost(job_index, end_index);
+    cost = std::min(cost, end_cost);
+  }
+  if (!target_route.empty()) {
+    const auto cheapest_from_rank =
+      sol_state.cheapest_job_rank_in_routes_from(v, v_target)[r];
+    const auto cheapest_from_index =
+      input.jobs[target_route[cheapest_from_rank]].index();
+    const Gain cost_from = vehicle.cost(cheapest_from_index, job_index);
+    cost = std::min(cost, cost_from);
+
+    const auto cheapest_to_rank =
+      sol_state.cheapest_job_rank_in_routes_to(v, v_target)[r];
+    const auto cheapest_to_index =
+      input.jobs[target_route[cheapest_to_rank]].index();
+    const Gain cost_to = vehicle.cost(job_index, cheapest_to_index);
+    cost = std::min(cost, cost_to);
+  }
+
+  return cost;
+}
+
+} // namespace ls
+} // namespace vroom
@@ -0,0 +1,39 @@
+#ifndef KERNELS_H
+#define KERNELS_H
+
+/*
+
+This file is part of VROOM.
+
+Copyright (c) 2015-2021, Julien Coupey.
+All rights reserved (see LICENSE).
+
+*/
+
+#include "structures/vroom/input/input.h"
+#include "structures/vroom/solution_state.h"
+
+namespace vroom {
+namespace ls {
+
+// Type-independent inner kernels shared by the CVRP and VRPTW
+// LocalSearch instantiations. They only read job indices and
+// solution state, so compiling them once here keeps them out of both
+// template instantiations.
+
+// Lower bound for the cost of relocating the job at rank r in
+// source_route (for vehicle v) anywhere in target_route (for vehicle
+// v_target). Relies on sol_state.cheapest_job_rank_in_routes_* being
+// up to date.
+Gain job_route_cost(const Input& input,
+                    const utils::SolutionState& sol_state,
+                    const std::vector<Index>& source_route,
+                    const std::vector<Index>& target_route,
+                    Index v_target,
+                    Index v,
+                    Index r);
+
+} // namespace ls
+} // namespace vroom
+
+#endif
@@ -10,11 +10,19 @@ All rights reserved (see LICENSE).
 
 */
 
+#include <array>
+#include <random>
+
+#include "algorithms/local_search/operator.h"
 #include "structures/vroom/solution_state.h"
 
 namespace vroom {
 namespace ls {
 
+// Defaults for plateau detection, see LocalSearch constructor.
+constexpr unsigned DEFAULT_PLATEAU_WINDOW = 5;
+constexpr double DEFAULT_PLATEAU_THRESHOLD = 0.001;
+
 template <class Route,
           class UnassignedExchange,
           class Exchange,
@@ -37,8 +45,39 @@ private:
   const std::size_t _nb_vehicles;
 
   const unsigned _max_nb_jobs_removal;
+  // Number of threads used to evaluate candidate moves inside a
+  // local-search step.
+  const unsigned _nb_ls_threads;
+  // Optional deadline after which the search returns the best
+  // solution found so far.
+  const Deadline _deadline;
+  // Plateau detection: the depth schedule in run exits early when the
+  // best cost improves by less than _plateau_threshold (relative)
+  // over the last _plateau_window rounds, reported as a PLATEAU
+  // progress event. Orthogonal to the deadline above.
+  const unsigned _plateau_window;
+  const double _plateau_threshold;
+  // Route versions and unassigned jobs as they were at the end of the
+  // last completed local-search step, used as don't-look marks to
+  // skip route pairs left untouched in between.
+  std::vector<unsigned> _last_step_versions;
+  std::unordered_set<Index> _last_step_unassigned;
   std::vector<Index> _all_routes;
 
+  // Route versions (offset by one, zero meaning never polished) as
+  // they were when each route last went through TSP re-sequencing,
+  // so settled routes are only shipped out again after changing.
+  std::vector<unsigned> _polished_versions;
+
+  // Adaptive operator scheduling state: per-family number of steps
+  // where the family was evaluated, and number of moves it got
+  // applied within this run. Families repeatedly evaluated without a
+  // single applied move are demoted to periodic probing, see
+  // run_ls_step.
+  std::array<unsigned, NB_OPERATOR_FAMILIES> _op_evaluated_steps;
+  std::array<unsigned, NB_OPERATOR_FAMILIES> _op_applied_moves;
+  unsigned _ls_step_counter;
+
   utils::SolutionState _sol_state;
 
   std::vector<Route> _sol;
@@ -50,6 +89,10 @@ private:
 
   void run_ls_step();
 
+  // Re-sequence routes the last step converged on with the TSP
+  // machinery, splicing improved orders back when valid.
+  void polish_settled_routes();
+
   // Compute "cost" between route at rank v_target and job with rank r
   // in route at rank v. Relies on
   // _sol_state.cheapest_job_rank_in_routes_* being up to date.
@@ -63,16 +106,113 @@ private:
 
   void remove_from_routes();
 
+  utils::SolutionIndicators current_indicators() const;
+
+  // Ruin strategies used by run_lns, each turning part of the current
+  // solution back into unassigned jobs.
+  void ruin_related(unsigned nb_removals, std::minstd_rand& rand_engine);
+  void ruin_route(std::minstd_rand& rand_engine);
+  void ruin_worst(unsigned nb_removals);
+
 public:
   LocalSearch(const Input& input,
               std::vector<Route>& tw_sol,
-              unsigned max_nb_jobs_removal);
+              unsigned max_nb_jobs_removal,
+              unsigned nb_threads = 1,
+              const Deadline& deadline = Deadline(),
+              unsigned plateau_window = DEFAULT_PLATEAU_WINDOW,
+              double plateau_threshold = DEFAULT_PLATEAU_THRESHOLD);
 
   utils::SolutionIndicators indicators() const;
 
   void run();
+
+  // Additional ruin-and-recreate phase with adaptive strategy
+  // weights, expected to run after run.
+  void run_lns();
 };
 
+} // namespace ls
+
+// The two solver stacks are instantiated once for all in dedicated
+// translation units (local_search_cvrp.cpp and local_search_vrptw.cpp
+// include the member definitions from local_search_impl.h), so other
+// includers only ever see declarations.
+class RawRoute;
+class TWRoute;
+
+namespace cvrp {
+class UnassignedExchange;
+class Exchange;
+class CrossExchange;
+class MixedExchange;
+class TwoOpt;
+class ReverseTwoOpt;
+class Relocate;
+class OrOpt;
+class IntraExchange;
+class IntraCrossExchange;
+class IntraMixedExchange;
+class IntraRelocate;
+class IntraOrOpt;
+class PDShift;
+class RouteExchange;
+} // namespace cvrp
+
+namespace vrptw {
+class UnassignedExchange;
+class Exchange;
+class CrossExchange;
+class MixedExchange;
+class TwoOpt;
+class ReverseTwoOpt;
+class Relocate;
+class OrOpt;
+class IntraExchange;
+class IntraCrossExchange;
+class IntraMixedExchange;
+class IntraRelocate;
+class IntraOrOpt;
+class PDShift;
+class RouteExchange;
+} // namespace vrptw
+
+namespace ls {
+
+extern template class LocalSearch<RawRoute,
+                                  cvrp::UnassignedExchange,
+                                  cvrp::Exchange,
+                                  cvrp::CrossExchange,
+                                  cvrp::MixedExchange,
+                                  cvrp::TwoOpt,
+                                  cvrp::ReverseTwoOpt,
+                                  cvrp::Relocate,
+                                  cvrp::OrOpt,
+                                  cvrp::IntraExchange,
+                                  cvrp::IntraCrossExchange,
+                                  cvrp::IntraMixedExchange,
+                                  cvrp::IntraRelocate,
+                                  cvrp::IntraOrOpt,
+                                  cvrp::PDShift,
+                                  cvrp::RouteExchange>;
+
+extern template class LocalSearch<TWRoute,
+                                  vrptw::UnassignedExchange,
+                                  vrptw::Exchange,
+                                  vrptw::CrossExchange,
+                                  vrptw::MixedExchange,
+                                  vrptw::TwoOpt,
+                                  vrptw::ReverseTwoOpt,
+                                  vrptw::Relocate,
+                                  vrptw::OrOpt,
+                                  vrptw::IntraExchange,
+                                  vrptw::IntraCrossExchange,
+                                  vrptw::IntraMixedExchange,
+                                  vrptw::IntraRelocate,
+                                  vrptw::IntraOrOpt,
+                                  vrptw::PDShift,
+                                  vrptw::RouteExchange>;
+
 } // namespace ls
 } // namespace vroom
 
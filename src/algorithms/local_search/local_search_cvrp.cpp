@@ -0,0 +1,38 @@
+/*
+
+This file is part of VROOM.
+
+Copyright (c) 2015-2021, Julien Coupey.
+All rights reserved (see LICENSE).
+
+*/
+
+#include "algorithms/local_search/local_search_impl.h"
+
+// Dedicated instantiation unit for the CVRP operator stack: keeping
+// it apart from the VRPTW one lets both compile in parallel and
+// groups each solver's move loops in its own object for better
+// instruction cache layout in mixed workloads.
+
+namespace vroom {
+namespace ls {
+
+template class LocalSearch<RawRoute,
+                           cvrp::UnassignedExchange,
+                           cvrp::Exchange,
+                           cvrp::CrossExchange,
+                           cvrp::MixedExchange,
+                           cvrp::TwoOpt,
+                           cvrp::ReverseTwoOpt,
+                           cvrp::Relocate,
+                           cvrp::OrOpt,
+                           cvrp::IntraExchange,
+                           cvrp::IntraCrossExchange,
+                           cvrp::IntraMixedExchange,
+                           cvrp::IntraRelocate,
+                           cvrp::IntraOrOpt,
+                           cvrp::PDShift,
+                           cvrp::RouteExchange>;
+
+} // namespace ls
+} // namespace vroom
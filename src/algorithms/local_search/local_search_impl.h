@@ -1,3 +1,6 @@
+#ifndef LOCAL_SEARCH_IMPL_H
+#define LOCAL_SEARCH_IMPL_H
+
 /*
 
 This file is part of VROOM.
@@ -7,7 +10,19 @@ All rights reserved (see LICENSE).
 
 */
 
+// LocalSearch member definitions, only included by the dedicated
+// instantiation translation units (local_search_cvrp.cpp and
+// local_search_vrptw.cpp) so each solver stack compiles to its own
+// object and other includers of local_search.h never re-instantiate
+// anything.
+
+#include <array>
+#include <tuple>
+#include <unordered_set>
+
+#include "algorithms/local_search/kernels.h"
 #include "algorithms/local_search/local_search.h"
+#include "problems/tsp/tsp.h"
 #include "problems/vrptw/operators/cross_exchange.h"
 #include "problems/vrptw/operators/exchange.h"
 #include "problems/vrptw/operators/intra_cross_exchange.h"
@@ -24,6 +39,8 @@ All rights reserved (see LICENSE).
 #include "problems/vrptw/operators/two_opt.h"
 #include "problems/vrptw/operators/unassigned_exchange.h"
 #include "utils/helpers.h"
+#include "utils/thread_pool.h"
+#include "utils/tracepoints.h"
 
 namespace vroom {
 namespace ls {
@@ -61,12 +78,26 @@ LocalSearch<Route,
             PDShift,
             RouteExchange>::LocalSearch(const Input& input,
                                         std::vector<Route>& sol,
-                                        unsigned max_nb_jobs_removal)
+                                        unsigned max_nb_jobs_removal,
+                                        unsigned nb_threads,
+                                        const Deadline& deadline,
+                                        unsigned plateau_window,
+                                        double plateau_threshold)
   : _input(input),
     _nb_vehicles(_input.vehicles.size()),
     _max_nb_jobs_removal(max_nb_jobs_removal),
+    _nb_ls_threads(
+      std::min(nb_threads, static_cast<unsigned>(_nb_vehicles))),
+    _deadline(deadline),
+    _plateau_window(plateau_window),
+    _plateau_threshold(plateau_threshold),
+    _last_step_versions(_nb_vehicles, 0),
     _all_routes(_nb_vehicles),
-    _sol_state(input),
+    _polished_versions(_nb_vehicles, 0),
+    _op_evaluated_steps{},
+    _op_applied_moves{},
+    _ls_step_counter(0),
+    _sol_state(input, _nb_ls_threads),
     _sol(sol),
     _best_sol(sol) {
   // Initialize all route indices.
@@ -82,16 +113,23 @@ LocalSearch<Route,
 
   _best_sol_indicators.unassigned = _sol_state.unassigned.size();
 
-  Index v_rank = 0;
-  _best_sol_indicators.cost =
-    std::accumulate(_sol.begin(), _sol.end(), 0, [&](auto sum, const auto& r) {
-      return sum + utils::route_cost_for_vehicle(_input, v_rank++, r.route);
-    });
+  _best_sol_indicators.cost = std::accumulate(_sol_state.route_costs.begin(),
+                                              _sol_state.route_costs.end(),
+                                              0);
 
   _best_sol_indicators.used_vehicles =
     std::count_if(_sol.begin(), _sol.end(), [](const auto& r) {
       return !r.empty();
     });
+
+  Index h_rank = 0;
+  _best_sol_indicators.hash =
+    std::accumulate(_sol.begin(),
+                    _sol.end(),
+                    uint64_t(0),
+                    [&](auto sum, const auto& r) {
+                      return sum + utils::route_hash(h_rank++, r.route);
+                    });
 }
 
 struct RouteInsertion {
@@ -115,18 +153,30 @@ RouteInsertion compute_best_insertion_single(const Input& input,
   const auto& v_target = input.vehicles[v];
 
   if (input.vehicle_ok_with_job(v, j)) {
-
-    for (Index rank = 0; rank <= route.size(); ++rank) {
-      Gain current_cost =
-        utils::addition_cost(input, j, v_target, route.route, rank);
-      if (current_cost < result.cost and
-          route.is_valid_addition_for_capacity(input,
-                                               current_job.pickup,
-                                               current_job.delivery,
-                                               rank) and
-          route.is_valid_addition_for_tw(input, j, rank)) {
-        result = {current_cost, rank, 0, 0};
+    // Insertion costs only live for the scan below.
+    utils::ArenaScope arena_scope;
+
+    // Check slots in best-first cost order: the first valid one is
+    // the cheapest valid insertion.
+    const auto scan_ranks = [&](const auto& addition_costs) {
+      for (const auto rank : utils::ranked_addition_ranks(addition_costs)) {
+        const Gain current_cost = addition_costs[rank];
+        if (route.is_valid_addition_for_capacity(input,
+                                                 current_job.pickup,
+                                                 current_job.delivery,
+                                                 rank) and
+            route.is_valid_addition_for_tw(input, j, rank)) {
+          result = {current_cost, rank, 0, 0};
+          break;
+        }
       }
+    };
+
+    if (input.gains_fit_32bit()) {
+      scan_ranks(
+        utils::addition_costs<NarrowGain>(input, j, v_target, route.route));
+    } else {
+      scan_ranks(utils::addition_costs(input, j, v_target, route.route));
     }
   }
   return result;
@@ -145,20 +195,21 @@ RouteInsertion compute_best_insertion_pd(const Input& input,
     return result;
   }
 
-  // Pre-compute cost of addition for matching delivery.
-  std::vector<Gain> d_adds(route.size() + 1);
-  std::vector<unsigned char> valid_delivery_insertions(route.size() + 1);
+  // Pre-compute addition costs for pickup and matching delivery at
+  // all insertion ranks. They only live for the scan below.
+  utils::ArenaScope arena_scope;
+  const auto p_adds = utils::addition_costs(input, j, v_target, route.route);
+  const auto d_adds =
+    utils::addition_costs(input, j + 1, v_target, route.route);
 
+  std::vector<unsigned char> valid_delivery_insertions(route.size() + 1);
   for (unsigned d_rank = 0; d_rank <= route.size(); ++d_rank) {
-    d_adds[d_rank] =
-      utils::addition_cost(input, j + 1, v_target, route.route, d_rank);
     valid_delivery_insertions[d_rank] =
       route.is_valid_addition_for_tw(input, j + 1, d_rank);
   }
 
   for (Index pickup_r = 0; pickup_r <= route.size(); ++pickup_r) {
-    Gain p_add =
-      utils::addition_cost(input, j, v_target, route.route, pickup_r);
+    const Gain p_add = p_adds[pickup_r];
 
     if (!route.is_valid_addition_for_load(input,
                                           current_job.pickup,
@@ -280,6 +331,7 @@ void LocalSearch<Route,
                  RouteExchange>::try_job_additions(const std::vector<Index>&
                                                      routes,
                                                    double regret_coeff) {
+  VROOM_TRACE2(try_job_additions, routes.size(), _sol_state.unassigned.size());
 
   bool job_added;
 
@@ -300,6 +352,44 @@ void LocalSearch<Route,
     }
   }
 
+  // Per-job top-two insertion costs across considered routes,
+  // maintained incrementally as routes change so that regret
+  // evaluation does not rescan all routes at every insertion.
+  constexpr std::size_t no_route = std::numeric_limits<std::size_t>::max();
+  std::vector<Gain> smallest(_input.jobs.size(),
+                             std::numeric_limits<Gain>::max());
+  std::vector<Gain> second_smallest(_input.jobs.size(),
+                                    std::numeric_limits<Gain>::max());
+  std::vector<std::size_t> smallest_idx(_input.jobs.size(), no_route);
+  std::vector<std::size_t> second_idx(_input.jobs.size(), no_route);
+
+  auto rescan_cheapest_routes = [&](const Index j) {
+    smallest[j] = std::numeric_limits<Gain>::max();
+    second_smallest[j] = std::numeric_limits<Gain>::max();
+    smallest_idx[j] = no_route;
+    second_idx[j] = no_route;
+
+    for (std::size_t i = 0; i < routes.size(); ++i) {
+      const auto cost = route_job_insertions[i][j].cost;
+      if (cost < smallest[j]) {
+        second_smallest[j] = smallest[j];
+        second_idx[j] = smallest_idx[j];
+        smallest[j] = cost;
+        smallest_idx[j] = i;
+      } else if (cost < second_smallest[j]) {
+        second_smallest[j] = cost;
+        second_idx[j] = i;
+      }
+    }
+  };
+
+  for (const auto j : _sol_state.unassigned) {
+    if (_input.jobs[j].type == JOB_TYPE::DELIVERY) {
+      continue;
+    }
+    rescan_cheapest_routes(j);
+  }
+
   do {
 
     Priority best_priority = 0;
@@ -318,46 +408,44 @@ void LocalSearch<Route,
       const auto job_priority = current_job.priority;
 
       if (job_priority < best_priority) {
-        // Insert higher priority jobs first.
-        continue;
+        // Unassigned jobs come in decreasing priority order, so once
+        // a higher stratum yielded a candidate nothing below can
+        // compete.
+        break;
       }
 
-      auto smallest = std::numeric_limits<Gain>::max();
-      auto second_smallest = std::numeric_limits<Gain>::max();
-      std::size_t smallest_idx = std::numeric_limits<std::size_t>::max();
+      if (smallest_idx[j] == no_route) {
+        // No valid insertion for current job.
+        continue;
+      }
 
-      for (std::size_t i = 0; i < routes.size(); ++i) {
-        if (route_job_insertions[i][j].cost < smallest) {
-          smallest_idx = i;
-          second_smallest = smallest;
-          smallest = route_job_insertions[i][j].cost;
-        } else if (route_job_insertions[i][j].cost < second_smallest) {
-          second_smallest = route_job_insertions[i][j].cost;
+      // Only two routes can minimize the regret-based evaluation:
+      // the cheapest one (regret cost is the second cheapest cost)
+      // and the second cheapest one (regret cost is the cheapest
+      // cost). Any other route has a higher addition cost than the
+      // latter for the same regret cost.
+      double eval = static_cast<double>(smallest[j]) -
+                    regret_coeff * static_cast<double>(second_smallest[j]);
+      std::size_t candidate_idx = smallest_idx[j];
+
+      if (second_idx[j] != no_route) {
+        const double second_eval =
+          static_cast<double>(second_smallest[j]) -
+          regret_coeff * static_cast<double>(smallest[j]);
+        if (second_eval < eval) {
+          eval = second_eval;
+          candidate_idx = second_idx[j];
         }
       }
 
-      // Find best route for current job based on cost of addition and
-      // regret cost of not adding.
-      for (std::size_t i = 0; i < routes.size(); ++i) {
-        const auto addition_cost = route_job_insertions[i][j].cost;
-        if (addition_cost == std::numeric_limits<Gain>::max()) {
-          continue;
-        }
-        const Gain regret_cost =
-          (i == smallest_idx) ? second_smallest : smallest;
-
-        const double eval = static_cast<double>(addition_cost) -
-                            regret_coeff * static_cast<double>(regret_cost);
-
-        if ((job_priority > best_priority) or
-            (job_priority == best_priority and eval < best_cost)) {
-          best_priority = job_priority;
-          best_job_rank = j;
-          best_route = routes[i];
-          best_insertion = route_job_insertions[i][j];
-          best_cost = eval;
-          best_route_idx = i;
-        }
+      if ((job_priority > best_priority) or
+          (job_priority == best_priority and eval < best_cost)) {
+        best_priority = job_priority;
+        best_job_rank = j;
+        best_route = routes[candidate_idx];
+        best_insertion = route_job_insertions[candidate_idx][j];
+        best_cost = eval;
+        best_route_idx = candidate_idx;
       }
     }
 
@@ -384,11 +472,21 @@ void LocalSearch<Route,
                                  best_insertion.pickup_rank,
                                  best_insertion.delivery_rank);
 
-        assert(_sol_state.unassigned.find(best_job_rank + 1) !=
-               _sol_state.unassigned.end());
+        assert(_sol_state.unassigned.contains(best_job_rank + 1));
         _sol_state.unassigned.erase(best_job_rank + 1);
       }
-      // Update route/job insertions for best_route
+      _sol_state.bump_route_version(best_route);
+
+      // Additions have no gain as such, their trace records carry
+      // the insertion cost negated instead.
+      trace_move(TRACE_OP_JOB_ADDITION,
+                 best_route,
+                 best_route,
+                 -best_insertion.cost,
+                 true);
+
+      // Update route/job insertions for best_route, adjusting
+      // cheapest route data along the way.
       for (const auto j : _sol_state.unassigned) {
         const auto& current_job = _input.jobs[j];
         if (current_job.type == JOB_TYPE::DELIVERY) {
@@ -396,11 +494,27 @@ void LocalSearch<Route,
         }
         route_job_insertions[best_route_idx][j] =
           compute_best_insertion(_input, j, best_route, _sol[best_route]);
+
+        if (best_route_idx == smallest_idx[j] or
+            best_route_idx == second_idx[j]) {
+          // One of the top-two entries changed so a full rescan is
+          // required.
+          rescan_cheapest_routes(j);
+        } else {
+          const auto cost = route_job_insertions[best_route_idx][j].cost;
+          if (cost < smallest[j]) {
+            second_smallest[j] = smallest[j];
+            second_idx[j] = smallest_idx[j];
+            smallest[j] = cost;
+            smallest_idx[j] = best_route_idx;
+          } else if (cost < second_smallest[j]) {
+            second_smallest[j] = cost;
+            second_idx[j] = best_route_idx;
+          }
+        }
       }
-#ifndef NDEBUG
       // Update cost after addition.
       _sol_state.update_route_cost(_sol[best_route].route, best_route);
-#endif
     }
   } while (job_added);
 }
@@ -443,17 +557,155 @@ void LocalSearch<Route,
     best_ops[v] = std::vector<std::unique_ptr<Operator>>(_nb_vehicles);
   }
 
+  // Adaptive operator scheduling: a family that keeps being
+  // evaluated without ever providing an applied move on this
+  // instance is pure overhead, so it is demoted to periodic probing
+  // and the evaluation budget concentrates on operators that pay
+  // off. Probing steps are staggered across families so demoted
+  // operators are re-tested one at a time against modified routes.
+  constexpr unsigned scheduling_warmup = 3;
+  constexpr unsigned probing_period = 8;
+
+  ++_ls_step_counter;
+
+  std::array<bool, NB_OPERATOR_FAMILIES> try_op;
+  for (std::size_t o = 0; o < NB_OPERATOR_FAMILIES; ++o) {
+    const bool cold = (_op_evaluated_steps[o] >= scheduling_warmup) and
+                      (_op_applied_moves[o] == 0);
+    try_op[o] =
+      !cold or (_ls_step_counter % probing_period == o % probing_period);
+    if (try_op[o]) {
+      ++_op_evaluated_steps[o];
+    }
+  }
+
+  auto use_op = [&try_op](OPERATOR op) {
+    return try_op[static_cast<std::size_t>(op)];
+  };
+
+  // Don't-look marks: previous step only converged once all moves
+  // for current route contents were ruled out, so a route untouched
+  // since then can only be involved in an improving move against a
+  // modified route or a newly unassigned job.
+  std::vector<bool> look_at_route(_nb_vehicles);
+  for (unsigned v = 0; v < _nb_vehicles; ++v) {
+    look_at_route[v] = (_sol_state.route_version(v) != _last_step_versions[v]);
+  }
+  for (const auto u : _sol_state.unassigned) {
+    if (_last_step_unassigned.find(u) == _last_step_unassigned.end()) {
+      for (unsigned v = 0; v < _nb_vehicles; ++v) {
+        if (_input.vehicle_ok_with_job(v, u)) {
+          look_at_route[v] = true;
+        }
+      }
+    }
+  }
+
+  // Empty routes of interchangeable vehicles are symmetric: any move
+  // involving one has an identical counterpart on the lowest-rank
+  // one, so the others are not worth pairing up at all.
+  std::vector<bool> symmetric_empty(_nb_vehicles, false);
+  for (unsigned v = 0; v < _nb_vehicles; ++v) {
+    if (!_sol[v].empty()) {
+      continue;
+    }
+    for (unsigned other_v = 0; other_v < v; ++other_v) {
+      if (_sol[other_v].empty() and
+          _input.vehicles_interchangeable(other_v, v)) {
+        symmetric_empty[v] = true;
+        break;
+      }
+    }
+  }
+
   // List of source/target pairs we need to test (all related vehicles
-  // at first).
+  // with at least one side to look at, at first).
   std::vector<std::pair<Index, Index>> s_t_pairs;
   for (unsigned s_v = 0; s_v < _nb_vehicles; ++s_v) {
+    if (symmetric_empty[s_v]) {
+      continue;
+    }
     for (unsigned t_v = 0; t_v < _nb_vehicles; ++t_v) {
-      if (_input.vehicle_ok_with_vehicle(s_v, t_v)) {
+      if (_input.vehicle_ok_with_vehicle(s_v, t_v) and
+          !symmetric_empty[t_v] and
+          (look_at_route[s_v] or look_at_route[t_v])) {
         s_t_pairs.emplace_back(s_v, t_v);
       }
     }
   }
 
+  // Cluster-level tier for inter-route pruning: one word marks the
+  // clusters each route touches (vehicle ends included), and
+  // cross_lb[s][t] lower-bounds the duration of any new edge between
+  // a location of route s and one of route t. Scans whose best-case
+  // gain cannot beat the incumbent are then discarded without any
+  // full matrix read.
+  std::vector<std::vector<Gain>> cross_lb;
+  std::vector<unsigned> min_links(_nb_vehicles, 0);
+  if (_input.has_cluster_bounds()) {
+    std::vector<uint64_t> route_clusters(_nb_vehicles, 0);
+    for (unsigned v = 0; v < _nb_vehicles; ++v) {
+      uint64_t mask = 0;
+      const auto& vehicle = _input.vehicles[v];
+      if (vehicle.has_start()) {
+        mask |= 1ULL
+                << _input.location_cluster(vehicle.start.value().index());
+      }
+      if (vehicle.has_end()) {
+        mask |= 1ULL << _input.location_cluster(vehicle.end.value().index());
+      }
+      for (const auto j : _sol[v].route) {
+        mask |= 1ULL << _input.location_cluster(_input.jobs[j].index());
+      }
+      route_clusters[v] = mask;
+
+      // Least number of new edges a swapped-in node or edge has to
+      // add on this route's side: open ends mean a boundary position
+      // may only connect once, or not at all for a lone job.
+      const unsigned hs = vehicle.has_start() ? 1 : 0;
+      const unsigned he = vehicle.has_end() ? 1 : 0;
+      min_links[v] =
+        (_sol[v].route.size() <= 2) ? (hs + he) : (1 + std::min(hs, he));
+    }
+
+    cross_lb = std::vector<std::vector<Gain>>(_nb_vehicles,
+                                              std::vector<Gain>(_nb_vehicles,
+                                                                0));
+    for (const auto& s_t : s_t_pairs) {
+      if (s_t.first == s_t.second) {
+        continue;
+      }
+      Gain lb = std::numeric_limits<Gain>::max();
+      auto m1 = route_clusters[s_t.first];
+      while (m1 != 0) {
+        const Index c1 = static_cast<Index>(__builtin_ctzll(m1));
+        m1 &= m1 - 1;
+        auto m2 = route_clusters[s_t.second];
+        while (m2 != 0) {
+          const Index c2 = static_cast<Index>(__builtin_ctzll(m2));
+          m2 &= m2 - 1;
+          lb = std::min<Gain>(lb,
+                              std::min(_input.cluster_duration_lb(c1, c2),
+                                       _input.cluster_duration_lb(c2, c1)));
+        }
+      }
+      // A route without any location (no job, no vehicle end) leaves
+      // the sentinel; store a neutral bound instead.
+      cross_lb[s_t.first][s_t.second] =
+        (lb == std::numeric_limits<Gain>::max()) ? 0 : lb;
+    }
+  }
+
+  // Cluster bound on the route-crossing edges any move swapping
+  // single nodes or edges between both routes has to add, zero
+  // without cluster bounds.
+  const auto crossing_edges_lb =
+    [&cross_lb, &min_links](const Index v1, const Index v2) -> Gain {
+    return cross_lb.empty()
+             ? 0
+             : (min_links[v1] + min_links[v2]) * cross_lb[v1][v2];
+  };
+
   // Store best gain for matching move.
   std::vector<std::vector<Gain>> best_gains(_nb_vehicles,
                                             std::vector<Gain>(_nb_vehicles, 0));
@@ -466,7 +718,16 @@ void LocalSearch<Route,
   Gain best_gain = 1;
   Priority best_priority = 0;
 
-  while (best_gain > 0 or best_priority > 0) {
+  // Store priorities as they were at the start of the current
+  // evaluation pass. Pruning against other rows reads this snapshot
+  // so that parallel evaluation threads never read a row while its
+  // owning thread writes it.
+  std::vector<Priority> start_priorities(_nb_vehicles, 0);
+
+  // Search for the best move involving each pair in the given
+  // list. Writes are limited to the best_gains, best_priorities and
+  // best_ops rows matching source vehicles of handled pairs.
+  auto evaluate_pairs = [&](const std::vector<std::pair<Index, Index>>& pairs) {
     // Operators applied to a pair of (different) routes.
 
     if (_input.has_jobs()) {
@@ -479,13 +740,25 @@ void LocalSearch<Route,
         }
 
         Priority u_priority = _input.jobs[u].priority;
-        for (const auto& s_t : s_t_pairs) {
-          if (s_t.first != s_t.second or
+        for (const auto& s_t : pairs) {
+          if (!use_op(OPERATOR::UNASSIGNED_EXCHANGE) or
+              s_t.first != s_t.second or
               !_input.vehicle_ok_with_job(s_t.first, u) or
               _sol[s_t.first].empty()) {
             continue;
           }
 
+          // Addition costs of u at every rank in the route, computed
+          // once and shared by the slot evaluation below: combined
+          // with node_gains they give the exact gain of inserting u
+          // at t_rank while removing the job at a distinct s_rank, so
+          // only slots beating the incumbent reach the operator.
+          utils::ArenaScope arena_scope;
+          const auto u_adds = utils::addition_costs(_input,
+                                                    u,
+                                                    _input.vehicles[s_t.first],
+                                                    _sol[s_t.first].route);
+
           for (unsigned s_rank = 0; s_rank < _sol[s_t.first].size(); ++s_rank) {
             const auto& current_job =
               _input.jobs[_sol[s_t.first].route[s_rank]];
@@ -497,12 +770,23 @@ void LocalSearch<Route,
             const Priority priority_gain = u_priority - current_job.priority;
 
             if (best_priorities[s_t.first] <= priority_gain) {
+              const Gain removal_gain =
+                _sol_state.node_gains[s_t.first][s_rank];
+
               for (unsigned t_rank = 0; t_rank <= _sol[s_t.first].size();
                    ++t_rank) {
                 if (t_rank == s_rank + 1) {
                   // Same move as with t_rank == s_rank.
                   continue;
                 }
+                if (t_rank != s_rank and
+                    best_priorities[s_t.first] == priority_gain and
+                    removal_gain - u_adds[t_rank] <=
+                      best_gains[s_t.first][s_t.first]) {
+                  // Exact gain for this slot, not good enough at
+                  // equal priority.
+                  continue;
+                }
                 UnassignedExchange r(_input,
                                      _sol_state,
                                      _sol_state.unassigned,
@@ -517,7 +801,7 @@ void LocalSearch<Route,
                   (best_priorities[s_t.first] == priority_gain and
                    r.gain() > best_gains[s_t.first][s_t.first]);
 
-                if (better_if_valid and r.is_valid()) {
+                if (better_if_valid and r.valid()) {
                   best_priorities[s_t.first] = priority_gain;
                   // This may potentially define a negative value as
                   // best gain in case priority_gain is non-zero.
@@ -532,13 +816,24 @@ void LocalSearch<Route,
       }
 
       // Exchange stuff
-      for (const auto& s_t : s_t_pairs) {
-        if (s_t.second <= s_t.first or // This operator is symmetric.
-            best_priorities[s_t.first] > 0 or best_priorities[s_t.second] > 0 or
+      for (const auto& s_t : pairs) {
+        if (!use_op(OPERATOR::EXCHANGE) or
+            s_t.second <= s_t.first or // This operator is symmetric.
+            best_priorities[s_t.first] > 0 or start_priorities[s_t.second] > 0 or
             _sol[s_t.first].size() == 0 or _sol[s_t.second].size() == 0) {
           continue;
         }
 
+        // Removal gains are bounded by the edge costs around any
+        // single node, and all four new edges cross routes, so the
+        // cluster tier caps the best case for the whole scan.
+        if (_sol_state.max_edge_costs_around_node[s_t.first] +
+              _sol_state.max_edge_costs_around_node[s_t.second] -
+              crossing_edges_lb(s_t.first, s_t.second) <=
+            best_gains[s_t.first][s_t.second]) {
+          continue;
+        }
+
         for (unsigned s_rank = 0; s_rank < _sol[s_t.first].size(); ++s_rank) {
           const auto& s_job_rank = _sol[s_t.first].route[s_rank];
           if (_input.jobs[s_job_rank].type != JOB_TYPE::SINGLE or
@@ -558,6 +853,11 @@ void LocalSearch<Route,
               continue;
             }
 
+            if (!_input.jobs_are_neighbors(s_job_rank, t_job_rank)) {
+              // Swapping distant jobs is hopeless.
+              continue;
+            }
+
             Exchange r(_input,
                        _sol_state,
                        _sol[s_t.first],
@@ -567,7 +867,7 @@ void LocalSearch<Route,
                        s_t.second,
                        t_rank);
 
-            if (r.gain() > best_gains[s_t.first][s_t.second] and r.is_valid()) {
+            if (r.gain() > best_gains[s_t.first][s_t.second] and r.valid()) {
               best_gains[s_t.first][s_t.second] = r.gain();
               best_ops[s_t.first][s_t.second] = std::make_unique<Exchange>(r);
             }
@@ -577,13 +877,25 @@ void LocalSearch<Route,
     }
 
     // CROSS-exchange stuff
-    for (const auto& s_t : s_t_pairs) {
-      if (s_t.second <= s_t.first or // This operator is symmetric.
-          best_priorities[s_t.first] > 0 or best_priorities[s_t.second] > 0 or
+    for (const auto& s_t : pairs) {
+      if (!use_op(OPERATOR::CROSS_EXCHANGE) or
+          s_t.second <= s_t.first or // This operator is symmetric.
+          best_priorities[s_t.first] > 0 or start_priorities[s_t.second] > 0 or
           _sol[s_t.first].size() < 2 or _sol[s_t.second].size() < 2) {
         continue;
       }
 
+      // No pair of edges from those routes can be swapped with a
+      // higher gain than the summed removal bounds minus the four
+      // route-crossing edges the swap has to add, so the whole rank
+      // scan below is moot when they do not beat the incumbent.
+      if (_sol_state.max_edge_removal_bound[s_t.first] +
+            _sol_state.max_edge_removal_bound[s_t.second] -
+            crossing_edges_lb(s_t.first, s_t.second) <=
+          best_gains[s_t.first][s_t.second]) {
+        continue;
+      }
+
       for (unsigned s_rank = 0; s_rank < _sol[s_t.first].size() - 1; ++s_rank) {
         if (!_input.vehicle_ok_with_job(s_t.second,
                                         _sol[s_t.first].route[s_rank]) or
@@ -646,7 +958,7 @@ void LocalSearch<Route,
                           !is_t_pickup);
 
           auto& current_best = best_gains[s_t.first][s_t.second];
-          if (r.gain_upper_bound() > current_best and r.is_valid() and
+          if (r.gain_upper_bound() > current_best and r.valid() and
               r.gain() > current_best) {
             current_best = r.gain();
             best_ops[s_t.first][s_t.second] =
@@ -658,13 +970,24 @@ void LocalSearch<Route,
 
     if (_input.has_jobs()) {
       // Mixed-exchange stuff
-      for (const auto& s_t : s_t_pairs) {
-        if (s_t.first == s_t.second or best_priorities[s_t.first] > 0 or
-            best_priorities[s_t.second] > 0 or _sol[s_t.first].size() == 0 or
+      for (const auto& s_t : pairs) {
+        if (!use_op(OPERATOR::MIXED_EXCHANGE) or s_t.first == s_t.second or
+            best_priorities[s_t.first] > 0 or
+            start_priorities[s_t.second] > 0 or _sol[s_t.first].size() == 0 or
             _sol[s_t.second].size() < 2) {
           continue;
         }
 
+        // Exchanging a node of one route with an edge of the other
+        // cannot gain more than both removal bounds minus the four
+        // route-crossing edges the move has to add.
+        if (_sol_state.max_edge_costs_around_node[s_t.first] +
+              _sol_state.max_edge_removal_bound[s_t.second] -
+              crossing_edges_lb(s_t.first, s_t.second) <=
+            best_gains[s_t.first][s_t.second]) {
+          continue;
+        }
+
         for (unsigned s_rank = 0; s_rank < _sol[s_t.first].size(); ++s_rank) {
           const auto& s_job_rank = _sol[s_t.first].route[s_rank];
           if (_input.jobs[s_job_rank].type != JOB_TYPE::SINGLE or
@@ -712,7 +1035,7 @@ void LocalSearch<Route,
                             !is_t_pickup);
 
             auto& current_best = best_gains[s_t.first][s_t.second];
-            if (r.gain_upper_bound() > current_best and r.is_valid() and
+            if (r.gain_upper_bound() > current_best and r.valid() and
                 r.gain() > current_best) {
               current_best = r.gain();
               best_ops[s_t.first][s_t.second] =
@@ -724,9 +1047,10 @@ void LocalSearch<Route,
     }
 
     // 2-opt* stuff
-    for (const auto& s_t : s_t_pairs) {
-      if (s_t.second <= s_t.first or // This operator is symmetric.
-          best_priorities[s_t.first] > 0 or best_priorities[s_t.second] > 0) {
+    for (const auto& s_t : pairs) {
+      if (!use_op(OPERATOR::TWO_OPT) or
+          s_t.second <= s_t.first or // This operator is symmetric.
+          best_priorities[s_t.first] > 0 or start_priorities[s_t.second] > 0) {
         continue;
       }
 
@@ -767,7 +1091,7 @@ void LocalSearch<Route,
                    s_t.second,
                    t_rank);
 
-          if (r.gain() > best_gains[s_t.first][s_t.second] and r.is_valid()) {
+          if (r.gain() > best_gains[s_t.first][s_t.second] and r.valid()) {
             best_gains[s_t.first][s_t.second] = r.gain();
             best_ops[s_t.first][s_t.second] = std::make_unique<TwoOpt>(r);
           }
@@ -776,9 +1100,9 @@ void LocalSearch<Route,
     }
 
     // Reverse 2-opt* stuff
-    for (const auto& s_t : s_t_pairs) {
-      if (s_t.first == s_t.second or best_priorities[s_t.first] > 0 or
-          best_priorities[s_t.second] > 0) {
+    for (const auto& s_t : pairs) {
+      if (!use_op(OPERATOR::REVERSE_TWO_OPT) or s_t.first == s_t.second or
+          best_priorities[s_t.first] > 0 or start_priorities[s_t.second] > 0) {
         continue;
       }
 
@@ -813,7 +1137,7 @@ void LocalSearch<Route,
                           s_t.second,
                           t_rank);
 
-          if (r.gain() > best_gains[s_t.first][s_t.second] and r.is_valid()) {
+          if (r.gain() > best_gains[s_t.first][s_t.second] and r.valid()) {
             best_gains[s_t.first][s_t.second] = r.gain();
             best_ops[s_t.first][s_t.second] =
               std::make_unique<ReverseTwoOpt>(r);
@@ -826,9 +1150,10 @@ void LocalSearch<Route,
       // Move(s) that don't make sense for shipment-only instances.
 
       // Relocate stuff
-      for (const auto& s_t : s_t_pairs) {
-        if (s_t.first == s_t.second or best_priorities[s_t.first] > 0 or
-            best_priorities[s_t.second] > 0 or _sol[s_t.first].size() == 0) {
+      for (const auto& s_t : pairs) {
+        if (!use_op(OPERATOR::RELOCATE) or s_t.first == s_t.second or
+            best_priorities[s_t.first] > 0 or
+            start_priorities[s_t.second] > 0 or _sol[s_t.first].size() == 0) {
           continue;
         }
 
@@ -850,6 +1175,19 @@ void LocalSearch<Route,
 
           for (unsigned t_rank = 0; t_rank <= _sol[s_t.second].size();
                ++t_rank) {
+            if (_sol[s_t.second].size() != 0 and
+                !(t_rank > 0 and
+                  _input.jobs_are_neighbors(s_job_rank,
+                                            _sol[s_t.second]
+                                              .route[t_rank - 1])) and
+                !(t_rank < _sol[s_t.second].size() and
+                  _input.jobs_are_neighbors(s_job_rank,
+                                            _sol[s_t.second].route[t_rank]))) {
+              // Only try insertions next to a neighbor of the moved
+              // job.
+              continue;
+            }
+
             Relocate r(_input,
                        _sol_state,
                        _sol[s_t.first],
@@ -859,7 +1197,7 @@ void LocalSearch<Route,
                        s_t.second,
                        t_rank);
 
-            if (r.gain() > best_gains[s_t.first][s_t.second] and r.is_valid()) {
+            if (r.gain() > best_gains[s_t.first][s_t.second] and r.valid()) {
               best_gains[s_t.first][s_t.second] = r.gain();
               best_ops[s_t.first][s_t.second] = std::make_unique<Relocate>(r);
             }
@@ -868,9 +1206,10 @@ void LocalSearch<Route,
       }
 
       // Or-opt stuff
-      for (const auto& s_t : s_t_pairs) {
-        if (s_t.first == s_t.second or best_priorities[s_t.first] > 0 or
-            best_priorities[s_t.second] > 0 or _sol[s_t.first].size() < 2) {
+      for (const auto& s_t : pairs) {
+        if (!use_op(OPERATOR::OR_OPT) or s_t.first == s_t.second or
+            best_priorities[s_t.first] > 0 or
+            start_priorities[s_t.second] > 0 or _sol[s_t.first].size() < 2) {
           continue;
         }
 
@@ -900,8 +1239,24 @@ void LocalSearch<Route,
             continue;
           }
 
+          const auto& s_edge_first_rank = _sol[s_t.first].route[s_rank];
+          const auto& s_edge_last_rank = _sol[s_t.first].route[s_rank + 1];
+
           for (unsigned t_rank = 0; t_rank <= _sol[s_t.second].size();
                ++t_rank) {
+            if (_sol[s_t.second].size() != 0 and
+                !(t_rank > 0 and
+                  _input.jobs_are_neighbors(s_edge_first_rank,
+                                            _sol[s_t.second]
+                                              .route[t_rank - 1])) and
+                !(t_rank < _sol[s_t.second].size() and
+                  _input.jobs_are_neighbors(s_edge_last_rank,
+                                            _sol[s_t.second].route[t_rank]))) {
+              // Only try insertions next to a neighbor of the moved
+              // edge.
+              continue;
+            }
+
             OrOpt r(_input,
                     _sol_state,
                     _sol[s_t.first],
@@ -912,7 +1267,7 @@ void LocalSearch<Route,
                     t_rank);
 
             auto& current_best = best_gains[s_t.first][s_t.second];
-            if (r.gain_upper_bound() > current_best and r.is_valid() and
+            if (r.gain_upper_bound() > current_best and r.valid() and
                 r.gain() > current_best) {
               current_best = r.gain();
               best_ops[s_t.first][s_t.second] = std::make_unique<OrOpt>(r);
@@ -925,13 +1280,27 @@ void LocalSearch<Route,
     // Operators applied to a single route.
 
     // Intra exchange stuff
-    for (const auto& s_t : s_t_pairs) {
-      if (s_t.first != s_t.second or best_priorities[s_t.first] > 0 or
-          _sol[s_t.first].size() < 3) {
+    for (const auto& s_t : pairs) {
+      if (!use_op(OPERATOR::INTRA_EXCHANGE) or s_t.first != s_t.second or
+          best_priorities[s_t.first] > 0 or _sol[s_t.first].size() < 3) {
+        continue;
+      }
+
+      // Gain for swapping two nodes never exceeds the sum of their
+      // edge costs around, bounded per route by twice the maximum
+      // such cost.
+      const auto max_ecan = _sol_state.max_edge_costs_around_node[s_t.first];
+      if (2 * max_ecan <= best_gains[s_t.first][s_t.first]) {
         continue;
       }
 
       for (unsigned s_rank = 0; s_rank < _sol[s_t.first].size() - 2; ++s_rank) {
+        if (_sol_state.edge_costs_around_node[s_t.first][s_rank] + max_ecan <=
+            best_gains[s_t.first][s_t.first]) {
+          // No swap involving this node can beat the incumbent.
+          continue;
+        }
+
         unsigned max_t_rank = _sol[s_t.first].size() - 1;
         if (_input.jobs[_sol[s_t.first].route[s_rank]].type ==
             JOB_TYPE::PICKUP) {
@@ -947,6 +1316,13 @@ void LocalSearch<Route,
             continue;
           }
 
+          if (_sol_state.edge_costs_around_node[s_t.first][s_rank] +
+                _sol_state.edge_costs_around_node[s_t.first][t_rank] <=
+              best_gains[s_t.first][s_t.first]) {
+            // This node pair cannot beat the incumbent.
+            continue;
+          }
+
           IntraExchange r(_input,
                           _sol_state,
                           _sol[s_t.first],
@@ -954,7 +1330,7 @@ void LocalSearch<Route,
                           s_rank,
                           t_rank);
 
-          if (r.gain() > best_gains[s_t.first][s_t.first] and r.is_valid()) {
+          if (r.gain() > best_gains[s_t.first][s_t.first] and r.valid()) {
             best_gains[s_t.first][s_t.first] = r.gain();
             best_ops[s_t.first][s_t.first] = std::make_unique<IntraExchange>(r);
           }
@@ -963,12 +1339,20 @@ void LocalSearch<Route,
     }
 
     // Intra CROSS-exchange stuff
-    for (const auto& s_t : s_t_pairs) {
-      if (s_t.first != s_t.second or best_priorities[s_t.first] > 0 or
+    for (const auto& s_t : pairs) {
+      if (!use_op(OPERATOR::INTRA_CROSS_EXCHANGE) or
+          s_t.first != s_t.second or best_priorities[s_t.first] > 0 or
           _sol[s_t.first].size() < 5) {
         continue;
       }
 
+      // Swapping two edges of the route cannot gain more than twice
+      // its maximum edge removal bound.
+      if (2 * _sol_state.max_edge_removal_bound[s_t.first] <=
+          best_gains[s_t.first][s_t.first]) {
+        continue;
+      }
+
       for (unsigned s_rank = 0; s_rank <= _sol[s_t.first].size() - 4;
            ++s_rank) {
         const auto& job_s_type =
@@ -1016,7 +1400,7 @@ void LocalSearch<Route,
                                !is_t_pickup);
 
           auto& current_best = best_gains[s_t.first][s_t.second];
-          if (r.gain_upper_bound() > current_best and r.is_valid() and
+          if (r.gain_upper_bound() > current_best and r.valid() and
               r.gain() > current_best) {
             current_best = r.gain();
             best_ops[s_t.first][s_t.first] =
@@ -1027,12 +1411,21 @@ void LocalSearch<Route,
     }
 
     // Intra mixed-exchange stuff
-    for (const auto& s_t : s_t_pairs) {
-      if (s_t.first != s_t.second or best_priorities[s_t.first] > 0 or
+    for (const auto& s_t : pairs) {
+      if (!use_op(OPERATOR::INTRA_MIXED_EXCHANGE) or
+          s_t.first != s_t.second or best_priorities[s_t.first] > 0 or
           _sol[s_t.first].size() < 4) {
         continue;
       }
 
+      // Exchanging a node with an edge of the route cannot gain more
+      // than the node and edge removal bounds combined.
+      if (_sol_state.max_edge_costs_around_node[s_t.first] +
+            _sol_state.max_edge_removal_bound[s_t.first] <=
+          best_gains[s_t.first][s_t.first]) {
+        continue;
+      }
+
       for (unsigned s_rank = 0; s_rank < _sol[s_t.first].size(); ++s_rank) {
         if (_input.jobs[_sol[s_t.first].route[s_rank]].type !=
             JOB_TYPE::SINGLE) {
@@ -1070,7 +1463,7 @@ void LocalSearch<Route,
                                t_rank,
                                !is_t_pickup);
           auto& current_best = best_gains[s_t.first][s_t.second];
-          if (r.gain_upper_bound() > current_best and r.is_valid() and
+          if (r.gain_upper_bound() > current_best and r.valid() and
               r.gain() > current_best) {
             current_best = r.gain();
             best_ops[s_t.first][s_t.first] =
@@ -1081,9 +1474,16 @@ void LocalSearch<Route,
     }
 
     // Intra relocate stuff
-    for (const auto& s_t : s_t_pairs) {
-      if (s_t.first != s_t.second or best_priorities[s_t.first] > 0 or
-          _sol[s_t.first].size() < 2) {
+    for (const auto& s_t : pairs) {
+      if (!use_op(OPERATOR::INTRA_RELOCATE) or s_t.first != s_t.second or
+          best_priorities[s_t.first] > 0 or _sol[s_t.first].size() < 2) {
+        continue;
+      }
+
+      if (_sol_state.node_gains[s_t.first]
+                               [_sol_state.node_candidates[s_t.first]] <=
+          best_gains[s_t.first][s_t.first]) {
+        // Even the best node removal gain cannot beat the incumbent.
         continue;
       }
 
@@ -1121,7 +1521,7 @@ void LocalSearch<Route,
                           s_rank,
                           t_rank);
 
-          if (r.gain() > best_gains[s_t.first][s_t.first] and r.is_valid()) {
+          if (r.gain() > best_gains[s_t.first][s_t.first] and r.valid()) {
             best_gains[s_t.first][s_t.first] = r.gain();
             best_ops[s_t.first][s_t.first] = std::make_unique<IntraRelocate>(r);
           }
@@ -1130,9 +1530,9 @@ void LocalSearch<Route,
     }
 
     // Intra Or-opt stuff
-    for (const auto& s_t : s_t_pairs) {
-      if (s_t.first != s_t.second or best_priorities[s_t.first] > 0 or
-          _sol[s_t.first].size() < 4) {
+    for (const auto& s_t : pairs) {
+      if (!use_op(OPERATOR::INTRA_OR_OPT) or s_t.first != s_t.second or
+          best_priorities[s_t.first] > 0 or _sol[s_t.first].size() < 4) {
         continue;
       }
       for (unsigned s_rank = 0; s_rank < _sol[s_t.first].size() - 1; ++s_rank) {
@@ -1181,7 +1581,7 @@ void LocalSearch<Route,
                        t_rank,
                        !is_pickup);
           auto& current_best = best_gains[s_t.first][s_t.second];
-          if (r.gain_upper_bound() > current_best and r.is_valid() and
+          if (r.gain_upper_bound() > current_best and r.valid() and
               r.gain() > current_best) {
             current_best = r.gain();
             best_ops[s_t.first][s_t.first] = std::make_unique<IntraOrOpt>(r);
@@ -1194,9 +1594,10 @@ void LocalSearch<Route,
       // Move(s) that don't make sense for job-only instances.
 
       // P&D relocate stuff
-      for (const auto& s_t : s_t_pairs) {
-        if (s_t.first == s_t.second or best_priorities[s_t.first] > 0 or
-            best_priorities[s_t.second] > 0 or _sol[s_t.first].size() == 0) {
+      for (const auto& s_t : pairs) {
+        if (!use_op(OPERATOR::PD_SHIFT) or s_t.first == s_t.second or
+            best_priorities[s_t.first] > 0 or
+            start_priorities[s_t.second] > 0 or _sol[s_t.first].size() == 0) {
           // Don't try to put things from an empty vehicle.
           continue;
         }
@@ -1237,7 +1638,7 @@ void LocalSearch<Route,
                       best_gains[s_t.first][s_t.second]);
 
           if (pdr.gain() > best_gains[s_t.first][s_t.second] and
-              pdr.is_valid()) {
+              pdr.valid()) {
             best_gains[s_t.first][s_t.second] = pdr.gain();
             best_ops[s_t.first][s_t.second] = std::make_unique<PDShift>(pdr);
           }
@@ -1248,9 +1649,10 @@ void LocalSearch<Route,
     if (!_input.has_homogeneous_locations() or
         !_input.has_homogeneous_profiles()) {
       // Route exchange stuff
-      for (const auto& s_t : s_t_pairs) {
-        if (s_t.second <= s_t.first or best_priorities[s_t.first] > 0 or
-            best_priorities[s_t.second] > 0 or
+      for (const auto& s_t : pairs) {
+        if (!use_op(OPERATOR::ROUTE_EXCHANGE) or s_t.second <= s_t.first or
+            best_priorities[s_t.first] > 0 or
+            start_priorities[s_t.second] > 0 or
             (_sol[s_t.first].size() == 0 and _sol[s_t.second].size() == 0) or
             _sol_state.bwd_skill_rank[s_t.first][s_t.second] > 0 or
             _sol_state.bwd_skill_rank[s_t.second][s_t.first] > 0) {
@@ -1259,18 +1661,62 @@ void LocalSearch<Route,
           continue;
         }
 
-        RouteExchange re(_input,
-                         _sol_state,
-                         _sol[s_t.first],
-                         s_t.first,
-                         _sol[s_t.second],
-                         s_t.second);
+        // Exact gain from route-level aggregates, so the operator is
+        // only built for improving swaps.
+        const Gain gain = RouteExchange::swap_gain(_input,
+                                                   _sol_state,
+                                                   _sol[s_t.first].route,
+                                                   s_t.first,
+                                                   _sol[s_t.second].route,
+                                                   s_t.second);
+
+        if (gain > best_gains[s_t.first][s_t.second]) {
+          RouteExchange re(_input,
+                           _sol_state,
+                           _sol[s_t.first],
+                           s_t.first,
+                           _sol[s_t.second],
+                           s_t.second);
+
+          if (re.valid()) {
+            assert(re.gain() == gain);
+            best_gains[s_t.first][s_t.second] = gain;
+            best_ops[s_t.first][s_t.second] =
+              std::make_unique<RouteExchange>(re);
+          }
+        }
+      }
+    }
+  };
+
+  while ((best_gain > 0 or best_priority > 0) and
+         !utils::deadline_passed(_deadline) and !_input.solving_cancelled()) {
+    start_priorities = best_priorities;
+
+    if (_nb_ls_threads <= 1) {
+      evaluate_pairs(s_t_pairs);
+    } else {
+      // Partition pairs by source vehicle so that writes from
+      // evaluation threads never target the same row.
+      std::vector<std::vector<std::pair<Index, Index>>> thread_pairs(
+        _nb_ls_threads);
+      for (const auto& s_t : s_t_pairs) {
+        thread_pairs[s_t.first % _nb_ls_threads].push_back(s_t);
+      }
 
-        if (re.gain() > best_gains[s_t.first][s_t.second] and re.is_valid()) {
-          best_gains[s_t.first][s_t.second] = re.gain();
-          best_ops[s_t.first][s_t.second] = std::make_unique<RouteExchange>(re);
+      std::vector<std::function<void()>> evaluating_tasks;
+      for (std::size_t t = 0; t < thread_pairs.size(); ++t) {
+        if (!thread_pairs[t].empty()) {
+          evaluating_tasks.push_back([&evaluate_pairs, &thread_pairs, t] {
+            // Pairs are partitioned by source vehicle only, so
+            // several threads may run validity checks on the same
+            // target route: keep those checks free of memo writes.
+            const TWRoute::ScopedRecordingOff no_recording;
+            evaluate_pairs(thread_pairs[t]);
+          });
         }
       }
+      utils::ThreadPool::instance().run(std::move(evaluating_tasks));
     }
 
     // Find best overall move, first checking priority increase then
@@ -1301,17 +1747,103 @@ void LocalSearch<Route,
       }
     }
 
-    // Apply matching operator.
+    // Apply matching operator(s).
     if (best_priority > 0 or best_gain > 0) {
       assert(best_ops[best_source][best_target] != nullptr);
 
-      best_ops[best_source][best_target]->apply();
+      // The stored moves for other route pairs remain exact as long
+      // as their routes and required unassigned jobs are untouched
+      // by every move applied before them, so pick a maximal set of
+      // pairwise-disjoint improving moves by decreasing gain and
+      // apply them as one batch sharing a single state
+      // synchronization.
+      std::vector<std::pair<Index, Index>> picked;
+      std::unordered_set<Index> picked_routes;
+      std::unordered_set<Index> picked_unassigned;
+
+      auto try_pick = [&](Index s_v, Index t_v) {
+        const auto& op = best_ops[s_v][t_v];
+        assert(op != nullptr);
+
+        const auto routes = op->update_candidates();
+        const auto required = op->required_unassigned();
+        if (std::any_of(routes.begin(),
+                        routes.end(),
+                        [&](const auto v) {
+                          return picked_routes.find(v) != picked_routes.end();
+                        }) or
+            std::any_of(required.begin(), required.end(), [&](const auto u) {
+              return picked_unassigned.find(u) != picked_unassigned.end();
+            })) {
+          // Improving move discarded as conflicting with a better
+          // one picked earlier in this batch.
+          trace_move(static_cast<std::uint16_t>(op->name()),
+                     s_v,
+                     t_v,
+                     best_gains[s_v][t_v],
+                     false);
+          return;
+        }
+
+        picked.emplace_back(s_v, t_v);
+        picked_routes.insert(routes.begin(), routes.end());
+        picked_unassigned.insert(required.begin(), required.end());
+      };
 
-      auto update_candidates =
-        best_ops[best_source][best_target]->update_candidates();
+      try_pick(best_source, best_target);
+
+      std::vector<std::pair<Index, Index>> gain_moves;
+      for (unsigned s_v = 0; s_v < _nb_vehicles; ++s_v) {
+        if (best_priorities[s_v] > 0) {
+          // Moves raising assigned priority are only ever applied as
+          // the primary move.
+          continue;
+        }
+        for (unsigned t_v = 0; t_v < _nb_vehicles; ++t_v) {
+          if (best_gains[s_v][t_v] > 0 and
+              (s_v != best_source or t_v != best_target)) {
+            gain_moves.emplace_back(s_v, t_v);
+          }
+        }
+      }
+      std::sort(gain_moves.begin(),
+                gain_moves.end(),
+                [&](const auto& lhs, const auto& rhs) {
+                  return best_gains[rhs.first][rhs.second] <
+                         best_gains[lhs.first][lhs.second];
+                });
+      for (const auto& m : gain_moves) {
+        try_pick(m.first, m.second);
+      }
+
+#ifndef NDEBUG
+      Gain applied_gain = 0;
+#endif
+      std::vector<Index> update_candidates;
+      std::vector<Index> addition_candidates;
+      for (const auto& m : picked) {
+        auto& op = best_ops[m.first][m.second];
+        count_applied_move(op->name(), best_gains[m.first][m.second]);
+        trace_move(static_cast<std::uint16_t>(op->name()),
+                   m.first,
+                   m.second,
+                   best_gains[m.first][m.second],
+                   true);
+        ++_op_applied_moves[static_cast<std::size_t>(op->name())];
+        op->apply();
+
+#ifndef NDEBUG
+        applied_gain += best_gains[m.first][m.second];
+#endif
+        for (const auto v : op->update_candidates()) {
+          update_candidates.push_back(v);
+        }
+        for (const auto v : op->addition_candidates()) {
+          addition_candidates.push_back(v);
+        }
+      }
 
 #ifndef NDEBUG
-      // Update route costs.
       const auto previous_cost =
         std::accumulate(update_candidates.begin(),
                         update_candidates.end(),
@@ -1319,9 +1851,12 @@ void LocalSearch<Route,
                         [&](auto sum, auto c) {
                           return sum + _sol_state.route_costs[c];
                         });
+#endif
+      // Update route costs.
       for (auto v_rank : update_candidates) {
         _sol_state.update_route_cost(_sol[v_rank].route, v_rank);
       }
+#ifndef NDEBUG
       const auto new_cost =
         std::accumulate(update_candidates.begin(),
                         update_candidates.end(),
@@ -1329,28 +1864,38 @@ void LocalSearch<Route,
                         [&](auto sum, auto c) {
                           return sum + _sol_state.route_costs[c];
                         });
-      assert(new_cost + best_gain == previous_cost);
+      assert(new_cost + applied_gain == previous_cost);
 #endif
 
-      try_job_additions(best_ops[best_source][best_target]
-                          ->addition_candidates(),
-                        0);
+      try_job_additions(addition_candidates, 0);
 
       // Running update_costs only after try_job_additions is fine.
-      for (auto v_rank : update_candidates) {
+      // Picked moves are pairwise route-disjoint, so the per-route
+      // state refresh after a batch is split across threads like in
+      // SolutionState::setup. This removes the main sequential
+      // section of each round without resorting to speculative move
+      // application, which would make results timing-dependent.
+      const auto update_route_state = [&](const Index v_rank) {
+        _sol_state.bump_route_version(v_rank);
         _sol_state.update_costs(_sol[v_rank].route, v_rank);
-      }
-
-      for (auto v_rank : update_candidates) {
         _sol_state.update_skills(_sol[v_rank].route, v_rank);
-      }
-
-      // Update candidates.
-      for (auto v_rank : update_candidates) {
         _sol_state.set_node_gains(_sol[v_rank].route, v_rank);
         _sol_state.set_edge_gains(_sol[v_rank].route, v_rank);
         _sol_state.set_pd_matching_ranks(_sol[v_rank].route, v_rank);
         _sol_state.set_pd_gains(_sol[v_rank].route, v_rank);
+      };
+
+      if (_nb_ls_threads <= 1 or update_candidates.size() < 2) {
+        for (auto v_rank : update_candidates) {
+          update_route_state(v_rank);
+        }
+      } else {
+        std::vector<std::function<void()>> update_tasks;
+        for (auto v_rank : update_candidates) {
+          update_tasks.push_back(
+            [&update_route_state, v_rank] { update_route_state(v_rank); });
+        }
+        utils::ThreadPool::instance().run(std::move(update_tasks));
       }
 
       // Set gains to zero for what needs to be recomputed in the next
@@ -1363,13 +1908,18 @@ void LocalSearch<Route,
       }
 
       for (unsigned v = 0; v < _nb_vehicles; ++v) {
+        const bool v_updated = std::find(update_candidates.begin(),
+                                         update_candidates.end(),
+                                         v) != update_candidates.end();
         for (auto v_rank : update_candidates) {
           if (_input.vehicle_ok_with_vehicle(v, v_rank)) {
             best_gains[v][v_rank] = 0;
             best_ops[v][v_rank] = std::unique_ptr<Operator>();
 
             s_t_pairs.emplace_back(v, v_rank);
-            if (v != v_rank) {
+            if (v != v_rank and !v_updated) {
+              // Pairs with both sides updated are already added in
+              // both orders when iterating on source vehicles.
               s_t_pairs.emplace_back(v_rank, v);
             }
           }
@@ -1381,8 +1931,7 @@ void LocalSearch<Route,
           continue;
         }
         for (auto req_u : best_ops[v][v]->required_unassigned()) {
-          if (_sol_state.unassigned.find(req_u) ==
-              _sol_state.unassigned.end()) {
+          if (!_sol_state.unassigned.contains(req_u)) {
             // This move should be invalidated because a required
             // unassigned job has been added by try_job_additions in
             // the meantime.
@@ -1395,6 +1944,135 @@ void LocalSearch<Route,
       }
     }
   }
+
+  // Remember what the step converged on so the next one can skip
+  // whatever is left untouched in the meantime.
+  for (unsigned v = 0; v < _nb_vehicles; ++v) {
+    _last_step_versions[v] = _sol_state.route_version(v);
+  }
+  _last_step_unassigned =
+    std::unordered_set<Index>(_sol_state.unassigned.begin(),
+                              _sol_state.unassigned.end());
+}
+
+template <class Route,
+          class UnassignedExchange,
+          class Exchange,
+          class CrossExchange,
+          class MixedExchange,
+          class TwoOpt,
+          class ReverseTwoOpt,
+          class Relocate,
+          class OrOpt,
+          class IntraExchange,
+          class IntraCrossExchange,
+          class IntraMixedExchange,
+          class IntraRelocate,
+          class IntraOrOpt,
+          class PDShift,
+          class RouteExchange>
+void LocalSearch<Route,
+                 UnassignedExchange,
+                 Exchange,
+                 CrossExchange,
+                 MixedExchange,
+                 TwoOpt,
+                 ReverseTwoOpt,
+                 Relocate,
+                 OrOpt,
+                 IntraExchange,
+                 IntraCrossExchange,
+                 IntraMixedExchange,
+                 IntraRelocate,
+                 IntraOrOpt,
+                 PDShift,
+                 RouteExchange>::polish_settled_routes() {
+  if (utils::deadline_passed(_deadline)) {
+    return;
+  }
+
+  std::vector<Index> candidates;
+  for (unsigned v = 0; v < _nb_vehicles; ++v) {
+    if (_sol[v].size() < 4 or
+        _polished_versions[v] == _sol_state.route_version(v) + 1) {
+      continue;
+    }
+    // TSP re-sequencing is oblivious to pickup-delivery precedence,
+    // so only job-only routes are shipped out.
+    if (std::any_of(_sol[v].route.begin(),
+                    _sol[v].route.end(),
+                    [&](const auto j) {
+                      return _input.jobs[j].type != JOB_TYPE::SINGLE;
+                    })) {
+      continue;
+    }
+    candidates.push_back(v);
+  }
+
+  if (candidates.empty()) {
+    return;
+  }
+
+  // Re-sequence candidate routes with the TSP machinery, in parallel
+  // when several threads are available for this search. Each route
+  // is solved single-threaded so results do not depend on the thread
+  // budget.
+  std::vector<std::vector<Index>> new_orders(candidates.size());
+  auto solve_one = [&](std::size_t c) {
+    new_orders[c] =
+      TSP(_input, _sol[candidates[c]].route, candidates[c]).raw_solve(1);
+  };
+
+  if (_nb_ls_threads > 1 and candidates.size() > 1) {
+    std::vector<std::function<void()>> polishing_tasks;
+    for (std::size_t c = 0; c < candidates.size(); ++c) {
+      polishing_tasks.push_back([&solve_one, c]() { solve_one(c); });
+    }
+    utils::ThreadPool::instance().run(std::move(polishing_tasks));
+  } else {
+    for (std::size_t c = 0; c < candidates.size(); ++c) {
+      solve_one(c);
+    }
+  }
+
+  for (std::size_t c = 0; c < candidates.size(); ++c) {
+    const auto v = candidates[c];
+    auto& new_order = new_orders[c];
+    assert(new_order.size() == _sol[v].size());
+
+    _polished_versions[v] = _sol_state.route_version(v) + 1;
+
+    if (utils::route_cost_for_vehicle(_input, v, new_order) >=
+        _sol_state.route_costs[v]) {
+      continue;
+    }
+
+    // Splice the improved order back if it stays load- and TW-valid.
+    if (!_sol[v].is_valid_addition_for_capacity_inclusion(
+          _input,
+          _sol[v].delivery_in_range(0, _sol[v].size()),
+          new_order.begin(),
+          new_order.end(),
+          0,
+          _sol[v].size()) or
+        !_sol[v].is_valid_addition_for_tw(_input,
+                                          new_order.begin(),
+                                          new_order.end(),
+                                          0,
+                                          _sol[v].size())) {
+      continue;
+    }
+
+    _sol[v].replace(_input,
+                    new_order.begin(),
+                    new_order.end(),
+                    0,
+                    _sol[v].size());
+
+    _sol_state.bump_route_version(v);
+    _sol_state.setup(_sol[v].route, v);
+    _polished_versions[v] = _sol_state.route_version(v) + 1;
+  }
 }
 
 template <class Route,
@@ -1434,59 +2112,83 @@ void LocalSearch<Route,
 
   unsigned current_nb_removal = 1;
 
+  // Best cost at the end of each round, used for plateau detection.
+  std::vector<Cost> round_best_costs;
+
   while (try_ls_step) {
     // A round of local search.
+    VROOM_TRACE1(ls_round_start, current_nb_removal);
     run_ls_step();
 
+    // Once a step converged, inter-route structure is settled for
+    // the current route contents, but each route order can still be
+    // improved by the much stronger TSP machinery.
+    polish_settled_routes();
+
     // Indicators for current solution.
-    utils::SolutionIndicators current_sol_indicators;
-    current_sol_indicators.priority_sum =
-      std::accumulate(_sol.begin(),
-                      _sol.end(),
-                      0,
-                      [&](auto sum, const auto& r) {
-                        return sum +
-                               utils::priority_sum_for_route(_input, r.route);
-                      });
-
-    current_sol_indicators.unassigned = _sol_state.unassigned.size();
-
-    Index v_rank = 0;
-    current_sol_indicators.cost =
-      std::accumulate(_sol.begin(),
-                      _sol.end(),
-                      0,
-                      [&](auto sum, const auto& r) {
-                        return sum + utils::route_cost_for_vehicle(_input,
-                                                                   v_rank++,
-                                                                   r.route);
-                      });
-
-    current_sol_indicators.used_vehicles =
-      std::count_if(_sol.begin(), _sol.end(), [](const auto& r) {
-        return !r.empty();
-      });
+    const auto current_sol_indicators = current_indicators();
+    VROOM_TRACE2(ls_round_end,
+                 current_sol_indicators.cost,
+                 current_sol_indicators.unassigned);
+
+    _input.report_progress(SEARCH_EVENT::LS_STEP,
+                           current_sol_indicators.cost,
+                           current_sol_indicators.unassigned);
 
     if (current_sol_indicators < _best_sol_indicators) {
       _best_sol_indicators = current_sol_indicators;
       _best_sol = _sol;
+      _input.report_progress(SEARCH_EVENT::IMPROVEMENT,
+                             _best_sol_indicators.cost,
+                             _best_sol_indicators.unassigned);
     } else {
       if (!first_step) {
         ++current_nb_removal;
       }
       if (_best_sol_indicators < current_sol_indicators) {
-        // Back to best known solution for further steps.
+        // Back to best known solution for further steps. All route
+        // contents potentially change in the process.
         _sol = _best_sol;
+        for (std::size_t v = 0; v < _sol.size(); ++v) {
+          _sol_state.bump_route_version(v);
+        }
         _sol_state.setup(_sol);
       }
     }
 
+    // The depth schedule stopped paying for itself when the best
+    // cost barely moved over the last _plateau_window rounds.
+    round_best_costs.push_back(_best_sol_indicators.cost);
+    bool plateau_reached = false;
+    if (round_best_costs.size() > _plateau_window) {
+      const auto before_window =
+        round_best_costs[round_best_costs.size() - 1 - _plateau_window];
+      const auto window_improvement = before_window - round_best_costs.back();
+      plateau_reached =
+        window_improvement <= _plateau_threshold * before_window;
+    }
+    if (plateau_reached) {
+      VROOM_TRACE2(ls_plateau,
+                   _best_sol_indicators.cost,
+                   round_best_costs.size());
+      _input.report_progress(SEARCH_EVENT::PLATEAU,
+                             _best_sol_indicators.cost,
+                             _best_sol_indicators.unassigned);
+    }
+
     // Try again on each improvement until we reach last job removal
-    // level.
-    try_ls_step = (current_nb_removal <= _max_nb_jobs_removal);
+    // level, converge to a plateau, hit the deadline or get
+    // cancelled.
+    try_ls_step = !plateau_reached and
+                  (current_nb_removal <= _max_nb_jobs_removal) and
+                  !utils::deadline_passed(_deadline) and
+                  !_input.solving_cancelled();
 
     if (try_ls_step) {
       // Get a looser situation by removing jobs.
+      _input.report_progress(SEARCH_EVENT::JOB_REMOVAL,
+                             _best_sol_indicators.cost,
+                             _best_sol_indicators.unassigned);
       for (unsigned i = 0; i < current_nb_removal; ++i) {
         remove_from_routes();
         for (std::size_t v = 0; v < _sol.size(); ++v) {
@@ -1541,39 +2243,14 @@ Gain LocalSearch<Route,
                  RouteExchange>::job_route_cost(Index v_target,
                                                 Index v,
                                                 Index r) {
-  assert(v != v_target);
-
-  Gain cost = static_cast<Gain>(INFINITE_COST);
-  const auto job_index = _input.jobs[_sol[v].route[r]].index();
-
-  const auto& vehicle = _input.vehicles[v_target];
-  if (vehicle.has_start()) {
-    const auto start_index = vehicle.start.value().index();
-    const Gain start_cost = vehicle.cost(start_index, job_index);
-    cost = std::min(cost, start_cost);
-  }
-  if (vehicle.has_end()) {
-    const auto end_index = vehicle.end.value().index();
-    const Gain end_cost = vehicle.cost(job_index, end_index);
-    cost = std::min(cost, end_cost);
-  }
-  if (_sol[v_target].size() != 0) {
-    const auto cheapest_from_rank =
-      _sol_state.cheapest_job_rank_in_routes_from[v][v_target][r];
-    const auto cheapest_from_index =
-      _input.jobs[_sol[v_target].route[cheapest_from_rank]].index();
-    const Gain cost_from = vehicle.cost(cheapest_from_index, job_index);
-    cost = std::min(cost, cost_from);
-
-    const auto cheapest_to_rank =
-      _sol_state.cheapest_job_rank_in_routes_to[v][v_target][r];
-    const auto cheapest_to_index =
-      _input.jobs[_sol[v_target].route[cheapest_to_rank]].index();
-    const Gain cost_to = vehicle.cost(job_index, cheapest_to_index);
-    cost = std::min(cost, cost_to);
-  }
-
-  return cost;
+  // Delegates to the shared non-template kernel, see kernels.h.
+  return ls::job_route_cost(_input,
+                            _sol_state,
+                            _sol[v].route,
+                            _sol[v_target].route,
+                            v_target,
+                            v,
+                            r);
 }
 
 template <class Route,
@@ -1786,6 +2463,7 @@ void LocalSearch<Route,
     const auto v = r_r.first;
     const auto r = r_r.second;
 
+    _sol_state.bump_route_version(v);
     _sol_state.unassigned.insert(_sol[v].route[r]);
 
     const auto& current_job = _input.jobs[_sol[v].route[r]];
@@ -1808,6 +2486,397 @@ void LocalSearch<Route,
                         delivery_r + 1);
       }
     }
+
+    _sol_state.update_route_cost(_sol[v].route, v);
+  }
+}
+
+template <class Route,
+          class UnassignedExchange,
+          class Exchange,
+          class CrossExchange,
+          class MixedExchange,
+          class TwoOpt,
+          class ReverseTwoOpt,
+          class Relocate,
+          class OrOpt,
+          class IntraExchange,
+          class IntraCrossExchange,
+          class IntraMixedExchange,
+          class IntraRelocate,
+          class IntraOrOpt,
+          class PDShift,
+          class RouteExchange>
+utils::SolutionIndicators LocalSearch<Route,
+                                      UnassignedExchange,
+                                      Exchange,
+                                      CrossExchange,
+                                      MixedExchange,
+                                      TwoOpt,
+                                      ReverseTwoOpt,
+                                      Relocate,
+                                      OrOpt,
+                                      IntraExchange,
+                                      IntraCrossExchange,
+                                      IntraMixedExchange,
+                                      IntraRelocate,
+                                      IntraOrOpt,
+                                      PDShift,
+                                      RouteExchange>::current_indicators() const {
+  utils::SolutionIndicators indicators;
+
+  indicators.priority_sum =
+    std::accumulate(_sol.begin(), _sol.end(), 0, [&](auto sum, const auto& r) {
+      return sum + utils::priority_sum_for_route(_input, r.route);
+    });
+
+  indicators.unassigned = _sol_state.unassigned.size();
+
+  // Route costs are maintained at every mutation site, so the
+  // solution cost is a mere sum over vehicles here.
+  indicators.cost = std::accumulate(_sol_state.route_costs.begin(),
+                                    _sol_state.route_costs.end(),
+                                    0);
+#ifndef NDEBUG
+  for (std::size_t v = 0; v < _sol.size(); ++v) {
+    assert(_sol_state.route_costs[v] ==
+           utils::route_cost_for_vehicle(_input, v, _sol[v].route));
+  }
+#endif
+
+  indicators.used_vehicles =
+    std::count_if(_sol.begin(), _sol.end(), [](const auto& r) {
+      return !r.empty();
+    });
+
+  Index h_rank = 0;
+  indicators.hash =
+    std::accumulate(_sol.begin(),
+                    _sol.end(),
+                    uint64_t(0),
+                    [&](auto sum, const auto& r) {
+                      return sum + utils::route_hash(h_rank++, r.route);
+                    });
+
+  return indicators;
+}
+
+template <class Route,
+          class UnassignedExchange,
+          class Exchange,
+          class CrossExchange,
+          class MixedExchange,
+          class TwoOpt,
+          class ReverseTwoOpt,
+          class Relocate,
+          class OrOpt,
+          class IntraExchange,
+          class IntraCrossExchange,
+          class IntraMixedExchange,
+          class IntraRelocate,
+          class IntraOrOpt,
+          class PDShift,
+          class RouteExchange>
+void LocalSearch<Route,
+                 UnassignedExchange,
+                 Exchange,
+                 CrossExchange,
+                 MixedExchange,
+                 TwoOpt,
+                 ReverseTwoOpt,
+                 Relocate,
+                 OrOpt,
+                 IntraExchange,
+                 IntraCrossExchange,
+                 IntraMixedExchange,
+                 IntraRelocate,
+                 IntraOrOpt,
+                 PDShift,
+                 RouteExchange>::ruin_related(unsigned nb_removals,
+                               std::minstd_rand& rand_engine) {
+  // Make a random assigned job unassigned along with assigned jobs
+  // from its neighborhood.
+  std::vector<std::pair<Index, Index>> candidates;
+  for (std::size_t v = 0; v < _sol.size(); ++v) {
+    for (unsigned r = 0; r < _sol[v].size(); ++r) {
+      if (_input.jobs[_sol[v].route[r]].type == JOB_TYPE::SINGLE) {
+        candidates.emplace_back(v, r);
+      }
+    }
+  }
+  if (candidates.empty()) {
+    return;
+  }
+
+  std::uniform_int_distribution<std::size_t> pick(0, candidates.size() - 1);
+  const auto seed = candidates[pick(rand_engine)];
+  const auto seed_job_rank = _sol[seed.first].route[seed.second];
+
+  // Ranks to remove per route, in decreasing order so removals don't
+  // invalidate pending ranks.
+  std::vector<std::vector<Index>> ranks_per_route(_nb_vehicles);
+  ranks_per_route[seed.first].push_back(seed.second);
+
+  unsigned nb_marked = 1;
+  for (const auto& v_r : candidates) {
+    if (nb_marked == nb_removals) {
+      break;
+    }
+    const auto job_rank = _sol[v_r.first].route[v_r.second];
+    if (job_rank != seed_job_rank and
+        _input.jobs_are_neighbors(seed_job_rank, job_rank)) {
+      ranks_per_route[v_r.first].push_back(v_r.second);
+      ++nb_marked;
+    }
+  }
+
+  for (std::size_t v = 0; v < _nb_vehicles; ++v) {
+    if (ranks_per_route[v].empty()) {
+      continue;
+    }
+    _sol_state.bump_route_version(v);
+    std::sort(ranks_per_route[v].begin(),
+              ranks_per_route[v].end(),
+              std::greater<Index>());
+    for (const auto r : ranks_per_route[v]) {
+      _sol_state.unassigned.insert(_sol[v].route[r]);
+      _sol[v].remove(_input, r, 1);
+    }
+    _sol_state.update_route_cost(_sol[v].route, v);
+  }
+}
+
+template <class Route,
+          class UnassignedExchange,
+          class Exchange,
+          class CrossExchange,
+          class MixedExchange,
+          class TwoOpt,
+          class ReverseTwoOpt,
+          class Relocate,
+          class OrOpt,
+          class IntraExchange,
+          class IntraCrossExchange,
+          class IntraMixedExchange,
+          class IntraRelocate,
+          class IntraOrOpt,
+          class PDShift,
+          class RouteExchange>
+void LocalSearch<Route,
+                 UnassignedExchange,
+                 Exchange,
+                 CrossExchange,
+                 MixedExchange,
+                 TwoOpt,
+                 ReverseTwoOpt,
+                 Relocate,
+                 OrOpt,
+                 IntraExchange,
+                 IntraCrossExchange,
+                 IntraMixedExchange,
+                 IntraRelocate,
+                 IntraOrOpt,
+                 PDShift,
+                 RouteExchange>::ruin_route(std::minstd_rand& rand_engine) {
+  // Empty a random route entirely.
+  std::vector<Index> non_empty;
+  for (std::size_t v = 0; v < _sol.size(); ++v) {
+    if (_sol[v].size() != 0) {
+      non_empty.push_back(v);
+    }
+  }
+  if (non_empty.empty()) {
+    return;
+  }
+
+  std::uniform_int_distribution<std::size_t> pick(0, non_empty.size() - 1);
+  const auto v = non_empty[pick(rand_engine)];
+
+  _sol_state.bump_route_version(v);
+  for (const auto j : _sol[v].route) {
+    _sol_state.unassigned.insert(j);
+  }
+  _sol[v].remove(_input, 0, _sol[v].size());
+  _sol_state.update_route_cost(_sol[v].route, v);
+}
+
+template <class Route,
+          class UnassignedExchange,
+          class Exchange,
+          class CrossExchange,
+          class MixedExchange,
+          class TwoOpt,
+          class ReverseTwoOpt,
+          class Relocate,
+          class OrOpt,
+          class IntraExchange,
+          class IntraCrossExchange,
+          class IntraMixedExchange,
+          class IntraRelocate,
+          class IntraOrOpt,
+          class PDShift,
+          class RouteExchange>
+void LocalSearch<Route,
+                 UnassignedExchange,
+                 Exchange,
+                 CrossExchange,
+                 MixedExchange,
+                 TwoOpt,
+                 ReverseTwoOpt,
+                 Relocate,
+                 OrOpt,
+                 IntraExchange,
+                 IntraCrossExchange,
+                 IntraMixedExchange,
+                 IntraRelocate,
+                 IntraOrOpt,
+                 PDShift,
+                 RouteExchange>::ruin_worst(unsigned nb_removals) {
+  // Make the jobs whose removal gains the most unassigned, relying on
+  // node gains maintained in solution state.
+  std::vector<std::tuple<Gain, Index, Index>> candidates;
+  for (std::size_t v = 0; v < _sol.size(); ++v) {
+    for (unsigned r = 0; r < _sol[v].size(); ++r) {
+      if (_input.jobs[_sol[v].route[r]].type == JOB_TYPE::SINGLE) {
+        candidates.emplace_back(_sol_state.node_gains[v][r], v, r);
+      }
+    }
+  }
+
+  std::sort(candidates.begin(), candidates.end(), [](auto& lhs, auto& rhs) {
+    return std::get<0>(rhs) < std::get<0>(lhs);
+  });
+  if (candidates.size() > nb_removals) {
+    candidates.resize(nb_removals);
+  }
+
+  std::vector<std::vector<Index>> ranks_per_route(_nb_vehicles);
+  for (const auto& c : candidates) {
+    ranks_per_route[std::get<1>(c)].push_back(std::get<2>(c));
+  }
+
+  for (std::size_t v = 0; v < _nb_vehicles; ++v) {
+    if (ranks_per_route[v].empty()) {
+      continue;
+    }
+    _sol_state.bump_route_version(v);
+    std::sort(ranks_per_route[v].begin(),
+              ranks_per_route[v].end(),
+              std::greater<Index>());
+    for (const auto r : ranks_per_route[v]) {
+      _sol_state.unassigned.insert(_sol[v].route[r]);
+      _sol[v].remove(_input, r, 1);
+    }
+    _sol_state.update_route_cost(_sol[v].route, v);
+  }
+}
+
+template <class Route,
+          class UnassignedExchange,
+          class Exchange,
+          class CrossExchange,
+          class MixedExchange,
+          class TwoOpt,
+          class ReverseTwoOpt,
+          class Relocate,
+          class OrOpt,
+          class IntraExchange,
+          class IntraCrossExchange,
+          class IntraMixedExchange,
+          class IntraRelocate,
+          class IntraOrOpt,
+          class PDShift,
+          class RouteExchange>
+void LocalSearch<Route,
+                 UnassignedExchange,
+                 Exchange,
+                 CrossExchange,
+                 MixedExchange,
+                 TwoOpt,
+                 ReverseTwoOpt,
+                 Relocate,
+                 OrOpt,
+                 IntraExchange,
+                 IntraCrossExchange,
+                 IntraMixedExchange,
+                 IntraRelocate,
+                 IntraOrOpt,
+                 PDShift,
+                 RouteExchange>::run_lns() {
+  // Ruin-and-recreate iterations on top of the solution reached by
+  // run. Each iteration picks a ruin strategy by roulette, recreates
+  // with regret-based insertions, polishes with a local-search step
+  // and keeps the result iff it improves on the best known
+  // solution. Strategy weights adapt to reward whatever has been
+  // improving lately.
+  constexpr std::size_t NB_RUIN_STRATEGIES = 3;
+  std::array<double, NB_RUIN_STRATEGIES> ruin_weights;
+  ruin_weights.fill(1.0);
+
+  // Seeding with instance data keeps searches reproducible, while
+  // the user-provided seed allows varying them on purpose.
+  std::minstd_rand rand_engine(_input.seed() + _input.jobs.size());
+
+  const unsigned nb_iterations =
+    std::min<std::size_t>(500, 4 * _input.jobs.size());
+  const unsigned max_nb_removals =
+    std::max<unsigned>(2, _input.jobs.size() / 10);
+
+  _sol = _best_sol;
+  for (std::size_t v = 0; v < _sol.size(); ++v) {
+    _sol_state.bump_route_version(v);
+  }
+  _sol_state.setup(_sol);
+
+  for (unsigned i = 0; i < nb_iterations; ++i) {
+    if (utils::deadline_passed(_deadline) or _input.solving_cancelled()) {
+      break;
+    }
+
+    std::discrete_distribution<std::size_t> pick_strategy(ruin_weights.begin(),
+                                                          ruin_weights.end());
+    const auto strategy = pick_strategy(rand_engine);
+
+    std::uniform_int_distribution<unsigned> pick_nb(1, max_nb_removals);
+    const auto nb_removals = pick_nb(rand_engine);
+
+    switch (strategy) {
+    case 0:
+      ruin_related(nb_removals, rand_engine);
+      break;
+    case 1:
+      ruin_route(rand_engine);
+      break;
+    case 2:
+      ruin_worst(nb_removals);
+      break;
+    }
+
+    try_job_additions(_all_routes, 1.0);
+    _sol_state.setup(_sol);
+
+    run_ls_step();
+
+    const auto current_sol_indicators = current_indicators();
+
+    const bool improved = current_sol_indicators < _best_sol_indicators;
+    if (improved) {
+      _best_sol_indicators = current_sol_indicators;
+      _best_sol = _sol;
+      _input.report_progress(SEARCH_EVENT::IMPROVEMENT,
+                             _best_sol_indicators.cost,
+                             _best_sol_indicators.unassigned);
+    } else {
+      // Back to best known solution for the next iteration.
+      _sol = _best_sol;
+      for (std::size_t v = 0; v < _sol.size(); ++v) {
+        _sol_state.bump_route_version(v);
+      }
+      _sol_state.setup(_sol);
+    }
+
+    ruin_weights[strategy] =
+      std::max(0.05, 0.8 * ruin_weights[strategy] + (improved ? 1.0 : 0.0));
   }
 }
 
@@ -1846,39 +2915,7 @@ utils::SolutionIndicators LocalSearch<Route,
   return _best_sol_indicators;
 }
 
-template class LocalSearch<TWRoute,
-                           vrptw::UnassignedExchange,
-                           vrptw::Exchange,
-                           vrptw::CrossExchange,
-                           vrptw::MixedExchange,
-                           vrptw::TwoOpt,
-                           vrptw::ReverseTwoOpt,
-                           vrptw::Relocate,
-                           vrptw::OrOpt,
-                           vrptw::IntraExchange,
-                           vrptw::IntraCrossExchange,
-                           vrptw::IntraMixedExchange,
-                           vrptw::IntraRelocate,
-                           vrptw::IntraOrOpt,
-                           vrptw::PDShift,
-                           vrptw::RouteExchange>;
-
-template class LocalSearch<RawRoute,
-                           cvrp::UnassignedExchange,
-                           cvrp::Exchange,
-                           cvrp::CrossExchange,
-                           cvrp::MixedExchange,
-                           cvrp::TwoOpt,
-                           cvrp::ReverseTwoOpt,
-                           cvrp::Relocate,
-                           cvrp::OrOpt,
-                           cvrp::IntraExchange,
-                           cvrp::IntraCrossExchange,
-                           cvrp::IntraMixedExchange,
-                           cvrp::IntraRelocate,
-                           cvrp::IntraOrOpt,
-                           cvrp::PDShift,
-                           cvrp::RouteExchange>;
-
 } // namespace ls
 } // namespace vroom
+
+#endif
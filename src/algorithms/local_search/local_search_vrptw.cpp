@@ -0,0 +1,36 @@
+/*
+
+This file is part of VROOM.
+
+Copyright (c) 2015-2021, Julien Coupey.
+All rights reserved (see LICENSE).
+
+*/
+
+#include "algorithms/local_search/local_search_impl.h"
+
+// Dedicated instantiation unit for the VRPTW operator stack, see
+// local_search_cvrp.cpp.
+
+namespace vroom {
+namespace ls {
+
+template class LocalSearch<TWRoute,
+                           vrptw::UnassignedExchange,
+                           vrptw::Exchange,
+                           vrptw::CrossExchange,
+                           vrptw::MixedExchange,
+                           vrptw::TwoOpt,
+                           vrptw::ReverseTwoOpt,
+                           vrptw::Relocate,
+                           vrptw::OrOpt,
+                           vrptw::IntraExchange,
+                           vrptw::IntraCrossExchange,
+                           vrptw::IntraMixedExchange,
+                           vrptw::IntraRelocate,
+                           vrptw::IntraOrOpt,
+                           vrptw::PDShift,
+                           vrptw::RouteExchange>;
+
+} // namespace ls
+} // namespace vroom
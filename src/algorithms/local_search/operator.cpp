@@ -7,16 +7,255 @@ All rights reserved (see LICENSE).
 
 */
 
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+#include <vector>
+
 #include "algorithms/local_search/operator.h"
 
+namespace {
+
+struct Counters {
+  std::atomic<std::uint64_t> evaluations{0};
+  std::atomic<std::uint64_t> valid_moves{0};
+  std::atomic<std::uint64_t> applied_moves{0};
+  std::atomic<vroom::Gain> cumulated_gain{0};
+};
+
+std::array<Counters, vroom::ls::NB_OPERATOR_FAMILIES> counters;
+
+bool stats_enabled = false;
+
+// Indexed by the OPERATOR enum values.
+constexpr std::array<const char*, vroom::ls::NB_OPERATOR_FAMILIES> names =
+  {"unassigned_exchange",
+   "exchange",
+   "cross_exchange",
+   "mixed_exchange",
+   "two_opt",
+   "reverse_two_opt",
+   "relocate",
+   "or_opt",
+   "intra_exchange",
+   "intra_cross_exchange",
+   "intra_mixed_exchange",
+   "intra_relocate",
+   "intra_or_opt",
+   "pd_shift",
+   "route_exchange"};
+
+// Move-trace file layout: a magic/version header then fixed-size
+// records in host byte order, see scripts/read_ls_trace.py.
+constexpr std::uint32_t TRACE_MAGIC = 0x5652544c; // "VRTL"
+constexpr std::uint32_t TRACE_VERSION = 1;
+
+struct TraceRecord {
+  std::uint64_t timestamp_us;
+  vroom::Gain gain;
+  std::uint16_t op;
+  std::uint16_t s_route;
+  std::uint16_t t_route;
+  std::uint8_t accepted;
+  std::uint8_t padding;
+};
+
+constexpr std::size_t TRACE_BUFFER_SIZE = 4096;
+
+// Owns the trace file and the background flusher thread. Solving
+// threads fill thread-local buffers and only touch the shared queue
+// when handing over a full one.
+class MoveTracer {
+private:
+  FILE* _out = nullptr;
+  std::chrono::steady_clock::time_point _start;
+
+  std::mutex _mutex;
+  std::condition_variable _cv;
+  std::vector<std::vector<TraceRecord>> _pending;
+  bool _done = false;
+  std::thread _flusher;
+
+  void flush(const std::vector<std::vector<TraceRecord>>& buffers) {
+    for (const auto& records : buffers) {
+      fwrite(records.data(), sizeof(TraceRecord), records.size(), _out);
+    }
+  }
+
+public:
+  MoveTracer() {
+    const char* file = std::getenv("VROOM_LS_TRACE");
+    if (file == nullptr or *file == '\0') {
+      return;
+    }
+    _out = std::fopen(file, "wb");
+    if (_out == nullptr) {
+      return;
+    }
+    fwrite(&TRACE_MAGIC, sizeof(TRACE_MAGIC), 1, _out);
+    fwrite(&TRACE_VERSION, sizeof(TRACE_VERSION), 1, _out);
+    _start = std::chrono::steady_clock::now();
+
+    _flusher = std::thread([this]() {
+      std::vector<std::vector<TraceRecord>> buffers;
+      for (;;) {
+        {
+          std::unique_lock<std::mutex> lock(_mutex);
+          _cv.wait(lock, [this]() { return !_pending.empty() or _done; });
+          if (_pending.empty()) {
+            return;
+          }
+          buffers.swap(_pending);
+        }
+        flush(buffers);
+        buffers.clear();
+      }
+    });
+  }
+
+  ~MoveTracer() {
+    if (_out == nullptr) {
+      return;
+    }
+    {
+      std::lock_guard<std::mutex> guard(_mutex);
+      _done = true;
+    }
+    _cv.notify_all();
+    _flusher.join();
+    std::fclose(_out);
+  }
+
+  bool active() const {
+    return _out != nullptr;
+  }
+
+  std::uint64_t elapsed_us() const {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now() - _start)
+      .count();
+  }
+
+  void enqueue(std::vector<TraceRecord>&& records) {
+    {
+      std::lock_guard<std::mutex> guard(_mutex);
+      _pending.push_back(std::move(records));
+    }
+    _cv.notify_all();
+  }
+};
+
+MoveTracer& tracer() {
+  // Created on first use, before any thread-local buffer below, so
+  // it outlives them all and collects their remainders on exit.
+  static MoveTracer t;
+  return t;
+}
+
+// Hands any partially filled buffer over when its thread ends.
+struct ThreadTraceBuffer {
+  std::vector<TraceRecord> records;
+
+  ThreadTraceBuffer() {
+    records.reserve(TRACE_BUFFER_SIZE);
+  }
+
+  ~ThreadTraceBuffer() {
+    if (!records.empty()) {
+      tracer().enqueue(std::move(records));
+    }
+  }
+};
+
+} // namespace
+
 namespace vroom {
 namespace ls {
 
-Gain Operator::gain() {
-  if (!gain_computed) {
-    this->compute_gain();
+bool trace_enabled() {
+  return tracer().active();
+}
+
+void trace_move(std::uint16_t op,
+                Index s_route,
+                Index t_route,
+                Gain gain,
+                bool accepted) {
+  auto& t = tracer();
+  if (!t.active()) {
+    return;
+  }
+
+  thread_local ThreadTraceBuffer buffer;
+  buffer.records.push_back({t.elapsed_us(),
+                            gain,
+                            op,
+                            s_route,
+                            t_route,
+                            static_cast<std::uint8_t>(accepted ? 1 : 0),
+                            0});
+  if (buffer.records.size() == TRACE_BUFFER_SIZE) {
+    t.enqueue(std::move(buffer.records));
+    buffer.records = std::vector<TraceRecord>();
+    buffer.records.reserve(TRACE_BUFFER_SIZE);
+  }
+}
+
+void enable_operator_stats(bool enable) {
+  stats_enabled = enable;
+}
+
+void reset_operator_stats() {
+  for (auto& c : counters) {
+    c.evaluations.store(0, std::memory_order_relaxed);
+    c.valid_moves.store(0, std::memory_order_relaxed);
+    c.applied_moves.store(0, std::memory_order_relaxed);
+    c.cumulated_gain.store(0, std::memory_order_relaxed);
+  }
+}
+
+std::vector<OperatorStatsEntry> operator_stats_report() {
+  std::vector<OperatorStatsEntry> report;
+  report.reserve(NB_OPERATOR_FAMILIES);
+  for (std::size_t o = 0; o < NB_OPERATOR_FAMILIES; ++o) {
+    report.push_back(
+      {names[o],
+       counters[o].evaluations.load(std::memory_order_relaxed),
+       counters[o].valid_moves.load(std::memory_order_relaxed),
+       counters[o].applied_moves.load(std::memory_order_relaxed),
+       counters[o].cumulated_gain.load(std::memory_order_relaxed)});
+  }
+  return report;
+}
+
+void count_evaluation(OPERATOR op) {
+  if (!stats_enabled) {
+    return;
+  }
+  counters[static_cast<std::size_t>(op)].evaluations
+    .fetch_add(1, std::memory_order_relaxed);
+}
+
+void count_valid_move(OPERATOR op) {
+  if (!stats_enabled) {
+    return;
+  }
+  counters[static_cast<std::size_t>(op)].valid_moves
+    .fetch_add(1, std::memory_order_relaxed);
+}
+
+void count_applied_move(OPERATOR op, Gain gain) {
+  if (!stats_enabled) {
+    return;
   }
-  return stored_gain;
+  auto& c = counters[static_cast<std::size_t>(op)];
+  c.applied_moves.fetch_add(1, std::memory_order_relaxed);
+  c.cumulated_gain.fetch_add(gain, std::memory_order_relaxed);
 }
 
 std::vector<Index> Operator::required_unassigned() const {
@@ -10,6 +10,9 @@ All rights reserved (see LICENSE).
 
 */
 
+#include <algorithm>
+#include <cstdint>
+
 #include "structures/typedefs.h"
 #include "structures/vroom/input/input.h"
 #include "structures/vroom/solution_state.h"
@@ -17,6 +20,95 @@ All rights reserved (see LICENSE).
 namespace vroom {
 namespace ls {
 
+// Thread-local pool of reusable index buffers. Operators needing a
+// temporary job sequence borrow capacity here on construction and
+// hand it back on destruction, so repeatedly evaluating candidate
+// moves does not allocate once each thread is warmed up.
+namespace scratch {
+
+inline std::vector<std::vector<Index>>& pool() {
+  static thread_local std::vector<std::vector<Index>> p;
+  return p;
+}
+
+inline std::vector<Index> borrow(std::size_t size) {
+  auto& p = pool();
+  if (p.empty()) {
+    return std::vector<Index>(size);
+  }
+  auto buffer = std::move(p.back());
+  p.pop_back();
+  buffer.resize(size);
+  return buffer;
+}
+
+template <class InputIterator>
+inline std::vector<Index> borrow(InputIterator first, InputIterator last) {
+  auto buffer = borrow(std::distance(first, last));
+  std::copy(first, last, buffer.begin());
+  return buffer;
+}
+
+inline void give_back(std::vector<Index>&& buffer) {
+  constexpr std::size_t max_pool_size = 16;
+  auto& p = pool();
+  if (p.size() < max_pool_size) {
+    p.push_back(std::move(buffer));
+  }
+}
+
+} // namespace scratch
+
+constexpr std::size_t NB_OPERATOR_FAMILIES = 15;
+
+// Per-family effectiveness counters, gathered process-wide while
+// enabled. Used to spot operators that never pay off on a given
+// workload.
+struct OperatorStatsEntry {
+  const char* name;
+  std::uint64_t evaluations;
+  std::uint64_t valid_moves;
+  std::uint64_t applied_moves;
+  Gain cumulated_gain;
+};
+
+// Turn counting on or off, off by default. Cheap enough to leave on
+// for production profiling: hooks are relaxed atomic increments.
+void enable_operator_stats(bool enable);
+
+void reset_operator_stats();
+
+// Snapshot of current counters for all operator families.
+std::vector<OperatorStatsEntry> operator_stats_report();
+
+// Counting hooks used by Operator and LocalSearch, no-ops while
+// stats are disabled.
+void count_evaluation(OPERATOR op);
+void count_valid_move(OPERATOR op);
+void count_applied_move(OPERATOR op, Gain gain);
+
+// Opt-in binary move trace for offline tuning, written to the file
+// named by the VROOM_LS_TRACE environment variable. Each record
+// holds a timestamp (microseconds since tracing started), operator
+// family, source and target route, gain and whether the move was
+// applied. Records are buffered per thread and flushed from a
+// background thread so search loops only pay a few stores per
+// move. scripts/read_ls_trace.py is the matching reader.
+
+// Pseudo operator id used in trace records for job additions, one
+// past the regular families.
+constexpr std::uint16_t TRACE_OP_JOB_ADDITION = NB_OPERATOR_FAMILIES;
+
+// Whether a trace file is being written.
+bool trace_enabled();
+
+// Append one record, no-op while tracing is off.
+void trace_move(std::uint16_t op,
+                Index s_route,
+                Index t_route,
+                Gain gain,
+                bool accepted);
+
 class Operator {
 protected:
   const Input& _input;
@@ -61,10 +153,30 @@ public:
       stored_gain(0) {
   }
 
-  virtual Gain gain();
+  virtual OPERATOR name() const = 0;
+
+  // Never overridden and defined inline so that the memoization
+  // check disappears at call sites where the concrete operator type
+  // is known, i.e. all evaluation loops.
+  Gain gain() {
+    if (!gain_computed) {
+      this->compute_gain();
+      count_evaluation(name());
+    }
+    return stored_gain;
+  }
 
   virtual bool is_valid() = 0;
 
+  // is_valid wrapper feeding the effectiveness counters.
+  bool valid() {
+    const bool v = this->is_valid();
+    if (v) {
+      count_valid_move(name());
+    }
+    return v;
+  }
+
   virtual void apply() = 0;
 
   virtual std::vector<Index> addition_candidates() const = 0;
@@ -7,6 +7,7 @@ All rights reserved (see LICENSE).
 
 */
 
+#include <algorithm>
 #include <cassert>
 #include <limits>
 #include <set>
@@ -16,55 +17,111 @@ All rights reserved (see LICENSE).
 namespace vroom {
 namespace utils {
 
+namespace {
+
+// Flat scratch buffers for minimum_weight_perfect_matching, reused
+// across calls on each thread. Christofides runs one matching per TSP
+// subproblem and route polishing solves many of those concurrently,
+// so per-call node-based containers used to hammer the allocator.
+template <class T> struct MunkresWorkspace {
+  std::vector<T> labeling_x;
+  std::vector<T> labeling_y;
+  std::vector<T> slack;
+  // Matched counterpart of each x (resp. y), or NONE.
+  std::vector<Index> matching_xy;
+  std::vector<Index> matching_yx;
+  // Alternating tree, storing for each y the x it was reached from,
+  // or NONE.
+  std::vector<Index> tree_parent;
+  std::vector<bool> in_S;
+  std::vector<bool> in_T;
+  std::vector<Index> S_list;
+  std::vector<Index> T_list;
+};
+
+} // namespace
+
 template <class T>
 std::unordered_map<Index, Index>
-minimum_weight_perfect_matching(const Matrix<T>& m) {
-
-  // Trivial initial labeling.
-  std::vector<T> labeling_x(m.size(), 0);
-  std::vector<T> labeling_y(m.size(), 0);
-  for (Index i = 0; i < m.size(); ++i) {
+minimum_weight_perfect_matching(const MatrixView<T>& m) {
+  const Index n = m.size();
+  constexpr Index NONE = std::numeric_limits<Index>::max();
+
+  thread_local MunkresWorkspace<T> ws;
+  ws.labeling_x.assign(n, 0);
+  ws.labeling_y.assign(n, 0);
+  ws.slack.assign(n, 0);
+  ws.matching_xy.assign(n, NONE);
+  ws.matching_yx.assign(n, NONE);
+  ws.tree_parent.assign(n, NONE);
+  ws.in_S.assign(n, false);
+  ws.in_T.assign(n, false);
+
+  // Initial labeling from row reduction, then column reduction on the
+  // remaining reduced weights.
+  for (Index i = 0; i < n; ++i) {
     T min_weight = std::numeric_limits<T>::max();
-    for (Index j = 0; j < m.size(); ++j) {
-      if (m[i][j] < min_weight) {
-        min_weight = m[i][j];
+    for (Index j = 0; j < n; ++j) {
+      if (m(i, j) < min_weight) {
+        min_weight = m(i, j);
       }
     }
-    labeling_x[i] = min_weight;
+    ws.labeling_x[i] = min_weight;
+  }
+  for (Index j = 0; j < n; ++j) {
+    T min_weight = std::numeric_limits<T>::max();
+    for (Index i = 0; i < n; ++i) {
+      const T reduced = m(i, j) - ws.labeling_x[i];
+      if (reduced < min_weight) {
+        min_weight = reduced;
+      }
+    }
+    ws.labeling_y[j] = min_weight;
   }
 
-  // Initial empty matching.
-  std::unordered_map<Index, Index> matching_xy;
-  std::unordered_map<Index, Index> matching_yx;
-
-  // Alternating tree.
-  std::unordered_map<Index, Index> alternating_tree;
+  // Greedy initial matching on the equality graph. Near-diagonal
+  // structures often get a full assignment right away, terminating
+  // without ever growing an alternating tree.
+  Index nb_matched = 0;
+  for (Index x = 0; x < n; ++x) {
+    for (Index y = 0; y < n; ++y) {
+      if (ws.matching_yx[y] == NONE and
+          ws.labeling_x[x] + ws.labeling_y[y] == m(x, y)) {
+        ws.matching_xy[x] = y;
+        ws.matching_yx[y] = x;
+        ++nb_matched;
+        break;
+      }
+    }
+  }
 
-  while (matching_xy.size() < m.size()) {
+  while (nb_matched < n) {
     // Step 1.
 
-    alternating_tree.clear();
-    std::vector<Index> S_list;
-    std::unordered_set<Index> S;
-    std::unordered_set<Index> T_set;
+    std::fill(ws.tree_parent.begin(), ws.tree_parent.end(), NONE);
+    std::fill(ws.in_S.begin(), ws.in_S.end(), false);
+    std::fill(ws.in_T.begin(), ws.in_T.end(), false);
+    ws.S_list.clear();
+    ws.T_list.clear();
+    std::size_t tree_size = 0;
 
     // Finding any unmatched x.
     Index unmatched_x = 0;
-    while (matching_xy.find(unmatched_x) != matching_xy.end()) {
+    while (ws.matching_xy[unmatched_x] != NONE) {
       ++unmatched_x;
     }
-    S.insert(unmatched_x);
-    S_list.push_back(unmatched_x);
-
-    // Saving relevant neighbors in equality graph in alternating_tree
-    // and initializing slacks.
-    std::vector<T> slack;
-    slack.resize(m.size());
-    for (Index y = 0; y < m.size(); ++y) {
-      if (labeling_x[unmatched_x] + labeling_y[y] == m[unmatched_x][y]) {
-        alternating_tree.emplace(y, unmatched_x);
+    ws.in_S[unmatched_x] = true;
+    ws.S_list.push_back(unmatched_x);
+
+    // Saving relevant neighbors in equality graph in the alternating
+    // tree and initializing slacks.
+    for (Index y = 0; y < n; ++y) {
+      if (ws.labeling_x[unmatched_x] + ws.labeling_y[y] == m(unmatched_x, y)) {
+        ws.tree_parent[y] = unmatched_x;
+        ++tree_size;
       }
-      slack[y] = m[unmatched_x][y] - labeling_x[unmatched_x] - labeling_y[y];
+      ws.slack[y] =
+        m(unmatched_x, y) - ws.labeling_x[unmatched_x] - ws.labeling_y[y];
     }
 
     bool augmented_path = false;
@@ -72,39 +129,37 @@ minimum_weight_perfect_matching(const Matrix<T>& m) {
     while (!augmented_path) {
       // Test if neighbors of S in equality graph equals T_set or not
       // (note that T_set is included in S neighbors).
-      if (alternating_tree.size() == T_set.size()) {
+      if (tree_size == ws.T_list.size()) {
         // Step 2.
 
         T alpha = std::numeric_limits<T>::max();
-        for (Index y = 0; y < m.size(); ++y) {
+        for (Index y = 0; y < n; ++y) {
           // Computing alpha, the minimum of slack values over
           // complement of T_set.
-          if (T_set.find(y) == T_set.end()) {
-            T current_slack = slack[y];
-            if (current_slack < alpha) {
-              alpha = current_slack;
-            }
+          if (!ws.in_T[y] and ws.slack[y] < alpha) {
+            alpha = ws.slack[y];
           }
         }
 
         // Update labelings
-        for (auto const& x : S_list) {
-          labeling_x[x] = labeling_x[x] + alpha;
+        for (auto const x : ws.S_list) {
+          ws.labeling_x[x] = ws.labeling_x[x] + alpha;
         }
-        for (auto const& y : T_set) {
-          labeling_y[y] = labeling_y[y] - alpha;
+        for (auto const y : ws.T_list) {
+          ws.labeling_y[y] = ws.labeling_y[y] - alpha;
         }
 
         // Updating relevant neighbors in new equality graph and
         // updating slacks.
-        for (Index y = 0; y < m.size(); ++y) {
-          if (T_set.find(y) == T_set.end()) {
-            slack[y] = slack[y] - alpha;
-
-            if (alternating_tree.find(y) == alternating_tree.end()) {
-              for (auto const& x : S_list) {
-                if (labeling_x[x] + labeling_y[y] == m[x][y]) {
-                  alternating_tree.emplace(y, x);
+        for (Index y = 0; y < n; ++y) {
+          if (!ws.in_T[y]) {
+            ws.slack[y] = ws.slack[y] - alpha;
+
+            if (ws.tree_parent[y] == NONE) {
+              for (auto const x : ws.S_list) {
+                if (ws.labeling_x[x] + ws.labeling_y[y] == m(x, y)) {
+                  ws.tree_parent[y] = x;
+                  ++tree_size;
                   break;
                 }
               }
@@ -115,35 +170,32 @@ minimum_weight_perfect_matching(const Matrix<T>& m) {
 
       // Step 3.
 
-      // First y in equality neighbors not in T_set.
-      Index chosen_y;
-      for (auto const& edge : alternating_tree) {
-        if (T_set.find(edge.first) == T_set.end()) {
-          // MUST happen before endge reaches the end of
-          // alternating_tree.
-          chosen_y = edge.first;
-          break;
-        }
+      // First y in equality neighbors not in T_set. MUST exist as
+      // the tree is strictly bigger than T_set at this point.
+      Index chosen_y = 0;
+      while (ws.tree_parent[chosen_y] == NONE or ws.in_T[chosen_y]) {
+        ++chosen_y;
+        assert(chosen_y < n);
       }
 
-      auto matching_y = matching_yx.find(chosen_y);
-      if (matching_y != matching_yx.end()) {
+      if (ws.matching_yx[chosen_y] != NONE) {
         // Chosen y is actually matched in M, update S and T_set and
         // proceed to step 2.
-        Index matched_x = matching_y->second;
+        Index matched_x = ws.matching_yx[chosen_y];
 
-        auto p = S.insert(matched_x);
-        if (p.second) {
-          S_list.push_back(matched_x);
+        if (!ws.in_S[matched_x]) {
+          ws.in_S[matched_x] = true;
+          ws.S_list.push_back(matched_x);
         }
-        T_set.insert(chosen_y);
+        ws.in_T[chosen_y] = true;
+        ws.T_list.push_back(chosen_y);
 
         // Updating slacks.
-        for (Index y = 0; y < m.size(); ++y) {
-          T current_value = slack[y];
-          T new_value = m[matched_x][y] - labeling_x[matched_x] - labeling_y[y];
-          if (new_value < current_value) {
-            slack[y] = new_value;
+        for (Index y = 0; y < n; ++y) {
+          T new_value =
+            m(matched_x, y) - ws.labeling_x[matched_x] - ws.labeling_y[y];
+          if (new_value < ws.slack[y]) {
+            ws.slack[y] = new_value;
           }
         }
       } else {
@@ -156,37 +208,41 @@ minimum_weight_perfect_matching(const Matrix<T>& m) {
         // be removed and (chosen_x, chosen_y) is to be added.
 
         Index current_y = chosen_y;
-        Index current_x = alternating_tree.at(current_y);
+        Index current_x = ws.tree_parent[current_y];
 
         while (current_x != unmatched_x) {
-          Index next_y = matching_xy.at(current_x);
-
-          // Remove alternating edge from current matching.
-          matching_xy.erase(matching_xy.find(current_x));
-          matching_yx.erase(matching_yx.find(next_y));
+          Index next_y = ws.matching_xy[current_x];
 
-          // Add edge from alternating tree to matching.
-          matching_xy.emplace(current_x, current_y);
-          matching_yx.emplace(current_y, current_x);
+          // Replace alternating edge from current matching with edge
+          // from alternating tree.
+          ws.matching_xy[current_x] = current_y;
+          ws.matching_yx[current_y] = current_x;
 
           current_y = next_y;
-          current_x = alternating_tree.at(current_y);
+          current_x = ws.tree_parent[current_y];
         }
         // Adding last edge from alternating tree.
-        matching_xy.emplace(current_x, current_y);
-        matching_yx.emplace(current_y, current_x);
+        ws.matching_xy[current_x] = current_y;
+        ws.matching_yx[current_y] = current_x;
+        ++nb_matched;
 
         // Back to step 1.
         augmented_path = true;
       }
     }
   }
+
+  std::unordered_map<Index, Index> matching_xy;
+  matching_xy.reserve(n);
+  for (Index x = 0; x < n; ++x) {
+    matching_xy.emplace(x, ws.matching_xy[x]);
+  }
   return matching_xy;
 }
 
 template <class T>
 std::unordered_map<Index, Index>
-greedy_symmetric_approx_mwpm(const Matrix<T>& m) {
+greedy_symmetric_approx_mwpm(const MatrixView<T>& m) {
   // Fast greedy algorithm for finding a symmetric perfect matching,
   // choosing always smaller possible value, no minimality
   // assured. Matrix size should be even!
@@ -207,7 +263,7 @@ greedy_symmetric_approx_mwpm(const Matrix<T>& m) {
       auto j = i;
       ++j;
       for (; j != remaining_indices.end(); ++j) {
-        T current_weight = m[*i][*j];
+        T current_weight = m(*i, *j);
         if (current_weight < min_weight) {
           min_weight = current_weight;
           chosen_i = i;
@@ -223,11 +279,82 @@ greedy_symmetric_approx_mwpm(const Matrix<T>& m) {
   return matching;
 }
 
+template <class T>
+std::unordered_map<Index, Index>
+refined_symmetric_approx_mwpm(const MatrixView<T>& m) {
+  assert(m.size() % 2 == 0);
+
+  // Sorting all candidate edges by increasing weight, then greedily
+  // picking edges whose both ends are still unmatched. This is
+  // O(n².log(n)) against O(n³) for the plain greedy approach above.
+  std::vector<std::pair<Index, Index>> candidates;
+  candidates.reserve((m.size() * (m.size() - 1)) / 2);
+  for (Index i = 0; i < m.size(); ++i) {
+    for (Index j = i + 1; j < m.size(); ++j) {
+      candidates.emplace_back(i, j);
+    }
+  }
+  std::sort(candidates.begin(),
+            candidates.end(),
+            [&m](const auto& lhs, const auto& rhs) {
+              return m(lhs.first, lhs.second) < m(rhs.first, rhs.second);
+            });
+
+  std::vector<bool> is_matched(m.size(), false);
+  std::vector<std::pair<Index, Index>> matching_edges;
+  matching_edges.reserve(m.size() / 2);
+  for (const auto& edge : candidates) {
+    if (!is_matched[edge.first] and !is_matched[edge.second]) {
+      is_matched[edge.first] = true;
+      is_matched[edge.second] = true;
+      matching_edges.push_back(edge);
+    }
+  }
+
+  // Local improvement: re-pair the vertices of any two matching edges
+  // whenever this decreases total weight. Total weight strictly
+  // decreases with each exchange so this terminates.
+  bool improvement_found;
+  do {
+    improvement_found = false;
+    for (std::size_t e1 = 0; e1 < matching_edges.size(); ++e1) {
+      for (std::size_t e2 = e1 + 1; e2 < matching_edges.size(); ++e2) {
+        const Index a = matching_edges[e1].first;
+        const Index b = matching_edges[e1].second;
+        const Index c = matching_edges[e2].first;
+        const Index d = matching_edges[e2].second;
+
+        const T current_weight = m(a, b) + m(c, d);
+        if (m(a, c) + m(b, d) < current_weight) {
+          matching_edges[e1] = std::make_pair(a, c);
+          matching_edges[e2] = std::make_pair(b, d);
+          improvement_found = true;
+        } else if (m(a, d) + m(b, c) < current_weight) {
+          matching_edges[e1] = std::make_pair(a, d);
+          matching_edges[e2] = std::make_pair(b, c);
+          improvement_found = true;
+        }
+      }
+    }
+  } while (improvement_found);
+
+  std::unordered_map<Index, Index> matching;
+  for (const auto& edge : matching_edges) {
+    matching.emplace(std::min(edge.first, edge.second),
+                     std::max(edge.first, edge.second));
+  }
+
+  return matching;
+}
+
+template std::unordered_map<Index, Index>
+minimum_weight_perfect_matching(const MatrixView<Cost>& m);
+
 template std::unordered_map<Index, Index>
-minimum_weight_perfect_matching(const Matrix<Cost>& m);
+greedy_symmetric_approx_mwpm(const MatrixView<Cost>& m);
 
 template std::unordered_map<Index, Index>
-greedy_symmetric_approx_mwpm(const Matrix<Cost>& m);
+refined_symmetric_approx_mwpm(const MatrixView<Cost>& m);
 
 } // namespace utils
 } // namespace vroom
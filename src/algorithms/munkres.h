@@ -19,11 +19,19 @@ namespace utils {
 
 template <class T>
 std::unordered_map<Index, Index>
-minimum_weight_perfect_matching(const Matrix<T>& m);
+minimum_weight_perfect_matching(const MatrixView<T>& m);
 
 template <class T>
 std::unordered_map<Index, Index>
-greedy_symmetric_approx_mwpm(const Matrix<T>& m);
+greedy_symmetric_approx_mwpm(const MatrixView<T>& m);
+
+// Near-optimal symmetric perfect matching: greedy pick of edges by
+// increasing weight, then refined with pairwise exchanges until no
+// further improvement. Each matching edge is reported once with key
+// smaller than value.
+template <class T>
+std::unordered_map<Index, Index>
+refined_symmetric_approx_mwpm(const MatrixView<T>& m);
 
 } // namespace utils
 } // namespace vroom
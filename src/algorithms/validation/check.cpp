@@ -7,35 +7,28 @@ All rights reserved (see LICENSE).
 
 */
 
-#include <thread>
-#include <unordered_map>
+#include <atomic>
 #include <unordered_set>
 
+#include <glpk.h>
+
 #include "algorithms/validation/check.h"
 #include "algorithms/validation/choose_ETA.h"
 #include "structures/vroom/tw_route.h"
 #include "utils/exception.h"
 #include "utils/helpers.h"
+#include "utils/thread_pool.h"
 
 namespace vroom {
 namespace validation {
 
-Solution check_and_set_ETA(const Input& input, unsigned nb_thread) {
+Solution check_and_set_ETA(const Input& input,
+                           unsigned nb_thread,
+                           const Deadline& deadline) {
   // Keep track of assigned job ranks.
   std::unordered_set<Index> assigned_ranks;
 
-  // Split the work among threads.
-  const unsigned nb_vehicles_with_input =
-    std::count_if(input.vehicles.begin(),
-                  input.vehicles.end(),
-                  [](const auto& v) { return !v.steps.empty(); });
-  const auto nb_buckets = std::min(nb_thread, nb_vehicles_with_input);
-
-  std::vector<std::vector<Index>> thread_ranks(nb_buckets,
-                                               std::vector<Index>());
-
-  unsigned actual_route_rank = 0;
-  std::unordered_map<Index, Index> v_rank_to_actual_route_rank;
+  std::vector<Index> vehicles_with_steps;
   for (Index v = 0; v < input.vehicles.size(); ++v) {
     const auto& current_vehicle = input.vehicles[v];
     if (current_vehicle.steps.empty()) {
@@ -48,39 +41,51 @@ Solution check_and_set_ETA(const Input& input, unsigned nb_thread) {
       }
     }
 
-    thread_ranks[actual_route_rank % nb_buckets].push_back(v);
-    v_rank_to_actual_route_rank.insert({v, actual_route_rank});
-    ++actual_route_rank;
+    vehicles_with_steps.push_back(v);
   }
 
-  std::vector<Route> routes(actual_route_rank);
-  std::vector<std::exception_ptr> thread_exceptions(nb_buckets, nullptr);
+  const std::size_t nb_routes = vehicles_with_steps.size();
+  const auto nb_tasks = std::min(static_cast<std::size_t>(nb_thread), nb_routes);
+
+  std::vector<Route> routes(nb_routes);
+  std::vector<std::exception_ptr> task_exceptions(nb_tasks, nullptr);
 
-  auto run_check = [&](unsigned bucket,
-                       const std::vector<Index>& vehicle_ranks) {
-    for (auto v : vehicle_ranks) {
-      auto search = v_rank_to_actual_route_rank.find(v);
-      assert(search != v_rank_to_actual_route_rank.end());
-      const auto route_rank = search->second;
+  // Routes are pulled from a shared queue instead of being split
+  // upfront: solving times vary a lot between routes so a static
+  // split leaves threads idle on the small ones.
+  std::atomic<std::size_t> next_route(0);
 
+  auto run_check = [&](std::size_t t) {
+    while (true) {
+      const auto route_rank = next_route.fetch_add(1);
+      if (route_rank >= nb_routes) {
+        break;
+      }
+
+      const auto v = vehicles_with_steps[route_rank];
       try {
-        routes[route_rank] = choose_ETA(input, v, input.vehicles[v].steps);
+        routes[route_rank] =
+          choose_ETA(input, v, input.vehicles[v].steps, deadline);
       } catch (...) {
-        thread_exceptions[bucket] = std::current_exception();
+        task_exceptions[t] = std::current_exception();
       }
     }
+
+    // Release the thread-local model and GLPK environment that
+    // choose_ETA keeps across routes checked on this thread.
+    release_model_cache();
+    glp_free_env();
   };
-  std::vector<std::thread> solving_threads;
 
-  for (unsigned i = 0; i < nb_buckets; ++i) {
-    solving_threads.emplace_back(run_check, i, thread_ranks[i]);
+  std::vector<std::function<void()>> checking_tasks;
+  for (std::size_t t = 0; t < nb_tasks; ++t) {
+    checking_tasks.push_back([&run_check, t] { run_check(t); });
   }
+  utils::ThreadPool::instance().run(std::move(checking_tasks));
 
-  for (unsigned i = 0; i < nb_buckets; ++i) {
-    solving_threads[i].join();
-
-    if (thread_exceptions[i] != nullptr) {
-      std::rethrow_exception(thread_exceptions[i]);
+  for (std::size_t t = 0; t < nb_tasks; ++t) {
+    if (task_exceptions[t] != nullptr) {
+      std::rethrow_exception(task_exceptions[t]);
     }
   }
 
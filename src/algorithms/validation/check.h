@@ -16,7 +16,9 @@ All rights reserved (see LICENSE).
 namespace vroom {
 namespace validation {
 
-Solution check_and_set_ETA(const Input& input, unsigned nb_thread);
+Solution check_and_set_ETA(const Input& input,
+                           unsigned nb_thread,
+                           const Deadline& deadline);
 
 } // namespace validation
 } // namespace vroom
@@ -14,10 +14,57 @@ All rights reserved (see LICENSE).
 #include <glpk.h>
 
 #include "algorithms/validation/choose_ETA.h"
+#include "utils/helpers.h"
+#include "utils/tracepoints.h"
 
 namespace vroom {
 namespace validation {
 
+namespace {
+
+// Per-thread GLPK model reused across routes: consecutive routes
+// share the same constraint template and only differ in sizes,
+// bounds and coefficients, so rows, columns and triplet arrays are
+// recycled instead of being rebuilt from scratch every time.
+struct ModelCache {
+  glp_prob* lp = nullptr;
+  unsigned nb_rows = 0;
+  unsigned nb_cols = 0;
+
+  // Triplet arrays handed over to glp_load_matrix.
+  std::vector<int> ia;
+  std::vector<int> ja;
+  std::vector<double> ar;
+};
+
+thread_local ModelCache model_cache;
+
+// Cap branch-and-cut time on the remaining wall-clock budget, if
+// any. GLPK expects a value in milliseconds.
+void set_time_limit(glp_iocp& parm, const Deadline& deadline) {
+  if (deadline.has_value()) {
+    const auto remaining =
+      std::chrono::duration_cast<std::chrono::milliseconds>(
+        deadline.value() - std::chrono::high_resolution_clock::now())
+        .count();
+    parm.tm_lim = static_cast<int>(
+      std::clamp<int64_t>(remaining,
+                          1,
+                          std::numeric_limits<int>::max()));
+  }
+}
+
+} // namespace
+
+void release_model_cache() {
+  if (model_cache.lp != nullptr) {
+    glp_delete_prob(model_cache.lp);
+    model_cache.lp = nullptr;
+  }
+  model_cache.nb_rows = 0;
+  model_cache.nb_cols = 0;
+}
+
 inline Duration get_duration(double d) {
   return static_cast<Duration>(std::round(d));
 }
@@ -25,9 +72,7 @@ inline Duration get_duration(double d) {
 inline Duration get_violation(const std::vector<TimeWindow>& tws,
                               Duration arrival) {
   Duration violation = 0;
-  const auto tw = std::find_if(tws.begin(), tws.end(), [&](const auto& tw) {
-    return arrival <= tw.end;
-  });
+  const auto tw = utils::earliest_available_tw(tws, arrival);
   if (tw == tws.end()) {
     // Delay from last time window.
     violation = (arrival - tws.back().end);
@@ -51,8 +96,10 @@ inline Duration get_violation(const std::vector<TimeWindow>& tws,
 
 Route choose_ETA(const Input& input,
                  unsigned vehicle_rank,
-                 const std::vector<VehicleStep>& steps) {
+                 const std::vector<VehicleStep>& steps,
+                 const Deadline& deadline) {
   const auto& v = input.vehicles[vehicle_rank];
+  VROOM_TRACE2(choose_eta, v.id, steps.size());
 
   // Number of tasks except start and end.
   assert(2 < steps.size());
@@ -211,860 +258,995 @@ Route choose_ETA(const Input& input,
     }
   }
 
-  // Generate a sample solution yielding an upper bound for the sum of
-  // violations.
-  if (!v.tw.is_default()) {
-    // Start ASAP for vehicle with custom time window.
-    start_candidate = std::min(start_candidate, v.tw.start);
-  } else {
-    if (horizon_start == std::numeric_limits<Duration>::max()) {
-      // No real time window in problem input.
-      start_candidate = 0;
-    } else {
-      // Start ASAP based on other time windows.
-      start_candidate = std::min(start_candidate, horizon_start);
+  // Scheduling decisions, either from the direct approach below or
+  // from the MIP optimization.
+  Duration v_start = 0;
+  Duration v_end = 0;
+  Duration start_travel = 0;
+  std::vector<Duration> task_ETA;
+  std::vector<Duration> task_travels;
+  std::vector<Index> task_tw_ranks;
+  glp_prob* lp = nullptr;
+  // Set when the MIP optimization does not complete before deadline
+  // and scheduling decisions come from the greedy fallback instead.
+  bool approx_schedule = false;
+
+  // Fast path: for routes without breaks or user-enforced service
+  // dates, if starting at the vehicle's earliest date yields neither
+  // waiting time nor time window violation, then that schedule is
+  // optimal. The sum of violations (zero) and route makespan (travel
+  // and service times only) are at their absolute minimum, and all
+  // task start dates match their individual lower bounds. This
+  // covers the common case of plain routes with loose time windows
+  // and skips the whole MIP machinery.
+  bool direct_schedule =
+    std::all_of(B.begin(), B.end(), [](const auto b) { return b == 0; }) and
+    std::all_of(steps.begin(), steps.end(), [](const auto& step) {
+      return !step.forced_service.at.has_value() and
+             !step.forced_service.after.has_value() and
+             !step.forced_service.before.has_value();
+    }) and
+    v.tw.start + relative_ETA.back() <= v.tw.end;
+
+  if (direct_schedule) {
+    for (unsigned s = 0; s < steps.size(); ++s) {
+      if (steps[s].type != STEP_TYPE::JOB) {
+        continue;
+      }
+      const auto service_start = v.tw.start + relative_ETA[s];
+      const auto& tws = input.jobs[steps[s].rank].tws;
+      const auto tw =
+        utils::earliest_available_tw(tws, service_start);
+      if (tw == tws.end() or service_start < tw->start) {
+        // Delay, or waiting time required until next time window.
+        direct_schedule = false;
+        task_ETA.clear();
+        task_tw_ranks.clear();
+        break;
+      }
+      task_tw_ranks.push_back(std::distance(tws.begin(), tw));
+      task_ETA.push_back(service_start);
     }
   }
-  Duration sample_violations = 0;
-  // Store margin between current horizon start (resp. end) and first
-  // availability date (resp. deadline).
-  std::vector<Duration> horizon_start_lead_times(steps.size(), 0);
-  std::vector<Duration> horizon_end_delays(steps.size(), 0);
-  auto earliest_date = start_candidate;
-  for (unsigned s = 0; s < steps.size(); ++s) {
-    const auto& step = steps[s];
-    if (s > 0) {
-      earliest_date += (relative_ETA[s] - relative_ETA[s - 1]);
-    }
-    if (step.forced_service.at.has_value()) {
-      earliest_date = std::max(earliest_date, step.forced_service.at.value());
-    }
-    if (step.forced_service.after.has_value()) {
-      earliest_date =
-        std::max(earliest_date, step.forced_service.after.value());
-    }
-    if (earliest_date > latest_dates[s]) {
-      throw Exception(ERROR::INPUT,
-                      "Infeasible route for vehicle " + std::to_string(v.id) +
-                        ".");
-    }
 
-    switch (step.type) {
-    case STEP_TYPE::START:
-      if (earliest_date < v.tw.start) {
-        sample_violations += (v.tw.start - earliest_date);
-      }
-      if (!v.tw.is_default()) {
-        horizon_start_lead_times[s] = v.tw.start - horizon_start;
-      }
-      break;
-    case STEP_TYPE::JOB: {
-      sample_violations +=
-        get_violation(input.jobs[step.rank].tws, earliest_date);
+  if (direct_schedule) {
+    v_start = v.tw.start;
+    v_end = v.tw.start + relative_ETA.back();
+    start_travel = durations.front();
+    // Without breaks, all travel times are "split" trivially.
+    task_travels.assign(durations.begin() + 1, durations.end());
+    assert(task_ETA.size() == n and task_travels.size() == n);
+  } else {
 
-      const auto& tws = input.jobs[step.rank].tws;
-      if (!tws.front().is_default()) {
-        horizon_start_lead_times[s] = tws.front().start - horizon_start;
-      }
-      if (!tws.back().is_default()) {
-        horizon_end_delays[s] = horizon_end - tws.back().end;
+    // Generate a sample solution yielding an upper bound for the sum of
+    // violations.
+    if (!v.tw.is_default()) {
+      // Start ASAP for vehicle with custom time window.
+      start_candidate = std::min(start_candidate, v.tw.start);
+    } else {
+      if (horizon_start == std::numeric_limits<Duration>::max()) {
+        // No real time window in problem input.
+        start_candidate = 0;
+      } else {
+        // Start ASAP based on other time windows.
+        start_candidate = std::min(start_candidate, horizon_start);
       }
-      break;
     }
-    case STEP_TYPE::BREAK: {
-      sample_violations +=
-        get_violation(v.breaks[step.rank].tws, earliest_date);
-
-      const auto& tws = v.breaks[step.rank].tws;
-      if (!tws.front().is_default()) {
-        horizon_start_lead_times[s] = tws.front().start - horizon_start;
+    Duration sample_violations = 0;
+    // Store margin between current horizon start (resp. end) and first
+    // availability date (resp. deadline).
+    std::vector<Duration> horizon_start_lead_times(steps.size(), 0);
+    std::vector<Duration> horizon_end_delays(steps.size(), 0);
+    auto earliest_date = start_candidate;
+    for (unsigned s = 0; s < steps.size(); ++s) {
+      const auto& step = steps[s];
+      if (s > 0) {
+        earliest_date += (relative_ETA[s] - relative_ETA[s - 1]);
       }
-      if (!tws.back().is_default()) {
-        horizon_end_delays[s] = horizon_end - tws.back().end;
+      if (step.forced_service.at.has_value()) {
+        earliest_date = std::max(earliest_date, step.forced_service.at.value());
       }
-      break;
-    }
-    case STEP_TYPE::END:
-      if (v.tw.end < earliest_date) {
-        sample_violations += (earliest_date - v.tw.end);
+      if (step.forced_service.after.has_value()) {
+        earliest_date =
+          std::max(earliest_date, step.forced_service.after.value());
       }
-      if (!v.tw.is_default()) {
-        horizon_end_delays[s] = horizon_end - v.tw.end;
+      if (earliest_date > latest_dates[s]) {
+        throw Exception(ERROR::INPUT,
+                        "Infeasible route for vehicle " + std::to_string(v.id) +
+                          ".");
       }
-      break;
-    }
-  }
 
-  // Refine planning horizon.
-  auto makespan_estimate = duration_sum + service_sum;
+      switch (step.type) {
+      case STEP_TYPE::START:
+        if (earliest_date < v.tw.start) {
+          sample_violations += (v.tw.start - earliest_date);
+        }
+        if (!v.tw.is_default()) {
+          horizon_start_lead_times[s] = v.tw.start - horizon_start;
+        }
+        break;
+      case STEP_TYPE::JOB: {
+        sample_violations +=
+          get_violation(input.jobs[step.rank].tws, earliest_date);
 
-  if (horizon_start == std::numeric_limits<Duration>::max()) {
-    // No real time window in problem input, planning horizon will
-    // start at 0.
-    assert(horizon_end == 0);
-    horizon_start = 0;
-    horizon_end = std::numeric_limits<Duration>::max();
-  } else {
-    // Advance "absolute" planning horizon start so as to allow lead
-    // time at startup. Compute minimal delay values for possible start of
-    // steps at horizon_end. See when it goes over our total
-    // violations upper bound in order to reduce margin used after
-    // horizon_end.
-    Duration horizon_start_margin = 0;
-    for (unsigned s = 0; s < steps.size(); ++s) {
-      // Compute minimal delay value when step at rank s happens
-      // exactly at horizon_start.
-      if (relative_ETA[s] > horizon_start) {
-        // Not that much margin for horizon start anyway, no point in
-        // not starting at 0.
-        horizon_start_margin = 0;
+        const auto& tws = input.jobs[step.rank].tws;
+        if (!tws.front().is_default()) {
+          horizon_start_lead_times[s] = tws.front().start - horizon_start;
+        }
+        if (!tws.back().is_default()) {
+          horizon_end_delays[s] = horizon_end - tws.back().end;
+        }
         break;
       }
-      horizon_start_margin = relative_ETA[s];
-      Duration minimal_lead_time = 0;
-      for (unsigned t = 0; t <= s; ++t) {
-        minimal_lead_time += horizon_start_lead_times[t];
-        minimal_lead_time += relative_ETA[s] - relative_ETA[t];
-      }
+      case STEP_TYPE::BREAK: {
+        sample_violations +=
+          get_violation(v.breaks[step.rank].tws, earliest_date);
 
-      if (minimal_lead_time > sample_violations) {
+        const auto& tws = v.breaks[step.rank].tws;
+        if (!tws.front().is_default()) {
+          horizon_start_lead_times[s] = tws.front().start - horizon_start;
+        }
+        if (!tws.back().is_default()) {
+          horizon_end_delays[s] = horizon_end - tws.back().end;
+        }
+        break;
+      }
+      case STEP_TYPE::END:
+        if (v.tw.end < earliest_date) {
+          sample_violations += (earliest_date - v.tw.end);
+        }
+        if (!v.tw.is_default()) {
+          horizon_end_delays[s] = horizon_end - v.tw.end;
+        }
         break;
       }
     }
-    assert(horizon_start_margin <= horizon_start);
-    horizon_start -= horizon_start_margin;
-
-    // Push "absolute" planning horizon end so as to allow
-    // delays. Compute minimal delay values for possible start of
-    // steps at horizon_end. See when it goes over our total
-    // violations upper bound in order to reduce margin used after
-    // horizon_end.
-    Duration horizon_end_margin = 0;
-    for (unsigned s = 0; s < steps.size(); ++s) {
-      const auto rev_s = steps.size() - 1 - s;
-      // Compute minimal delay value when step at rank rev_s happens
-      // exactly at horizon_end.
-      horizon_end_margin = relative_ETA.back() - relative_ETA[rev_s];
-      Duration minimal_delay = 0;
-      for (unsigned t = rev_s; t < steps.size(); ++t) {
-        minimal_delay += horizon_end_delays[t];
-        minimal_delay += relative_ETA[t] - relative_ETA[rev_s];
+
+    // Refine planning horizon.
+    auto makespan_estimate = duration_sum + service_sum;
+
+    if (horizon_start == std::numeric_limits<Duration>::max()) {
+      // No real time window in problem input, planning horizon will
+      // start at 0.
+      assert(horizon_end == 0);
+      horizon_start = 0;
+      horizon_end = std::numeric_limits<Duration>::max();
+    } else {
+      // Advance "absolute" planning horizon start so as to allow lead
+      // time at startup. Compute minimal delay values for possible start of
+      // steps at horizon_end. See when it goes over our total
+      // violations upper bound in order to reduce margin used after
+      // horizon_end.
+      Duration horizon_start_margin = 0;
+      for (unsigned s = 0; s < steps.size(); ++s) {
+        // Compute minimal delay value when step at rank s happens
+        // exactly at horizon_start.
+        if (relative_ETA[s] > horizon_start) {
+          // Not that much margin for horizon start anyway, no point in
+          // not starting at 0.
+          horizon_start_margin = 0;
+          break;
+        }
+        horizon_start_margin = relative_ETA[s];
+        Duration minimal_lead_time = 0;
+        for (unsigned t = 0; t <= s; ++t) {
+          minimal_lead_time += horizon_start_lead_times[t];
+          minimal_lead_time += relative_ETA[s] - relative_ETA[t];
+        }
+
+        if (minimal_lead_time > sample_violations) {
+          break;
+        }
       }
+      assert(horizon_start_margin <= horizon_start);
+      horizon_start -= horizon_start_margin;
+
+      // Push "absolute" planning horizon end so as to allow
+      // delays. Compute minimal delay values for possible start of
+      // steps at horizon_end. See when it goes over our total
+      // violations upper bound in order to reduce margin used after
+      // horizon_end.
+      Duration horizon_end_margin = 0;
+      for (unsigned s = 0; s < steps.size(); ++s) {
+        const auto rev_s = steps.size() - 1 - s;
+        // Compute minimal delay value when step at rank rev_s happens
+        // exactly at horizon_end.
+        horizon_end_margin = relative_ETA.back() - relative_ETA[rev_s];
+        Duration minimal_delay = 0;
+        for (unsigned t = rev_s; t < steps.size(); ++t) {
+          minimal_delay += horizon_end_delays[t];
+          minimal_delay += relative_ETA[t] - relative_ETA[rev_s];
+        }
 
-      if (minimal_delay > sample_violations) {
-        break;
+        if (minimal_delay > sample_violations) {
+          break;
+        }
       }
-    }
-    horizon_end += horizon_end_margin;
+      horizon_end += horizon_end_margin;
 
-    if (makespan_estimate == 0) {
-      makespan_estimate = horizon_end - horizon_start;
+      if (makespan_estimate == 0) {
+        makespan_estimate = horizon_end - horizon_start;
+      }
     }
-  }
 
-  // Retrieve user-provided upper bounds for t_i values. Retrieve
-  // user-provided lower bounds for t_i values while propagating
-  // travel/service constraints. Along the way, we store the rank of
-  // the first relevant TW (used below to force some binary variables
-  // to zero).
-  std::vector<Duration> t_i_LB;
-  std::vector<Duration> t_i_UB;
-  Duration previous_LB = horizon_start;
-  Duration previous_service = 0;
-  Duration previous_travel = durations.front();
-  std::vector<unsigned> first_relevant_tw_rank;
-  Index rank_in_J = 0;
+    // Retrieve user-provided upper bounds for t_i values. Retrieve
+    // user-provided lower bounds for t_i values while propagating
+    // travel/service constraints. Along the way, we store the rank of
+    // the first relevant TW (used below to force some binary variables
+    // to zero).
+    std::vector<Duration> t_i_LB;
+    std::vector<Duration> t_i_UB;
+    Duration previous_LB = horizon_start;
+    Duration previous_service = 0;
+    Duration previous_travel = durations.front();
+    std::vector<unsigned> first_relevant_tw_rank;
+    Index rank_in_J = 0;
+
+    for (const auto& step : steps) {
+      // Derive basic bounds from user input.
+      Duration LB = horizon_start;
+      Duration UB = horizon_end;
+      if (step.forced_service.at.has_value()) {
+        const auto forced_at = step.forced_service.at.value();
+        horizon_start = std::min(horizon_start, forced_at);
+        horizon_end = std::max(horizon_end, forced_at);
+        LB = forced_at;
+        UB = forced_at;
+      }
+      if (step.forced_service.after.has_value()) {
+        const auto forced_after = step.forced_service.after.value();
+        horizon_start = std::min(horizon_start, forced_after);
+        horizon_end = std::max(horizon_end, forced_after);
+        LB = forced_after;
+      }
+      if (step.forced_service.before.has_value()) {
+        const auto forced_before = step.forced_service.before.value();
+        horizon_start = std::min(horizon_start, forced_before);
+        horizon_end = std::max(horizon_end, forced_before);
+        UB = forced_before;
+      }
 
-  for (const auto& step : steps) {
-    // Derive basic bounds from user input.
-    Duration LB = horizon_start;
-    Duration UB = horizon_end;
-    if (step.forced_service.at.has_value()) {
-      const auto forced_at = step.forced_service.at.value();
-      horizon_start = std::min(horizon_start, forced_at);
-      horizon_end = std::max(horizon_end, forced_at);
-      LB = forced_at;
-      UB = forced_at;
-    }
-    if (step.forced_service.after.has_value()) {
-      const auto forced_after = step.forced_service.after.value();
-      horizon_start = std::min(horizon_start, forced_after);
-      horizon_end = std::max(horizon_end, forced_after);
-      LB = forced_after;
-    }
-    if (step.forced_service.before.has_value()) {
-      const auto forced_before = step.forced_service.before.value();
-      horizon_start = std::min(horizon_start, forced_before);
-      horizon_end = std::max(horizon_end, forced_before);
-      UB = forced_before;
+      // Now propagate some timing constraints for tighter lower bounds.
+      switch (step.type) {
+      case STEP_TYPE::START:
+        previous_LB = LB;
+        ++rank_in_J;
+        break;
+      case STEP_TYPE::JOB: {
+        LB = std::max(LB, previous_LB + previous_service + previous_travel);
+        previous_LB = LB;
+        previous_service = input.jobs[step.rank].service;
+        previous_travel = durations[rank_in_J];
+        ++rank_in_J;
+        break;
+      }
+      case STEP_TYPE::BREAK: {
+        LB = std::max(LB, previous_LB + previous_service);
+        previous_LB = LB;
+        previous_service = v.breaks[step.rank].service;
+        break;
+      }
+      case STEP_TYPE::END:
+        LB = std::max(LB, previous_LB + previous_service + previous_travel);
+        break;
+      }
+      t_i_LB.push_back(LB);
+      t_i_UB.push_back(UB);
+
+      if (step.type == STEP_TYPE::JOB or step.type == STEP_TYPE::BREAK) {
+        // Determine rank of the first relevant TW.
+        const auto& tws = (step.type == STEP_TYPE::JOB)
+                            ? input.jobs[step.rank].tws
+                            : v.breaks[step.rank].tws;
+        unsigned tw_rank = 0;
+        const auto tw =
+          utils::latest_available_tw(tws, LB);
+        if (tw != tws.rend()) {
+          tw_rank = std::distance(tw, tws.rend()) - 1;
+
+          if (tw->end < LB and tw != tws.rbegin()) {
+            // Lower bound is between two time windows.
+            const auto next_tw = std::prev(tw, 1);
+            if ((next_tw->start - LB) < (LB - tw->end)) {
+              // Lead time to next time window will always be cheaper
+              // than delay from the current one, which can be
+              // discarded.
+              ++tw_rank;
+            }
+          }
+        }
+        first_relevant_tw_rank.push_back(tw_rank);
+      }
     }
+    assert(first_relevant_tw_rank.size() == n);
+    assert(rank_in_J == J.size());
+    assert(t_i_LB.size() == steps.size());
+    assert(t_i_UB.size() == steps.size());
+
+    // Backward propagation for upper bounds based on travel/service
+    // constraints. Along the way, we store the rank of the last
+    // relevant TW (used below to force some binary variables to zero).
+    std::vector<unsigned> last_relevant_tw_rank(n);
+    Duration next_UB = t_i_UB.back();
+    Duration break_travel_margin = 0;
+    for (unsigned i = 0; i < steps.size(); ++i) {
+      auto step_rank = steps.size() - 1 - i;
+      const auto& step = steps[step_rank];
+
+      switch (step.type) {
+      case STEP_TYPE::START:
+        assert(rank_in_J == 1);
+        t_i_UB[step_rank] = std::min(t_i_UB[step_rank], next_UB - durations[0]);
+        break;
+      case STEP_TYPE::JOB: {
+        --rank_in_J;
+        const auto service = input.jobs[step.rank].service;
+        const auto next_travel = (break_travel_margin < durations[rank_in_J])
+                                   ? durations[rank_in_J] - break_travel_margin
+                                   : 0;
+        assert(service + next_travel <= next_UB);
+        t_i_UB[step_rank] =
+          std::min(t_i_UB[step_rank], next_UB - next_travel - service);
+        next_UB = t_i_UB[step_rank];
+        break_travel_margin = 0;
+        break;
+      }
+      case STEP_TYPE::BREAK: {
+        const auto service = v.breaks[step.rank].service;
+        assert(service <= next_UB);
+        const auto candidate = next_UB - service;
+        if (t_i_UB[step_rank] < candidate) {
+          // User-provided constraints gives margin for travel after
+          // this break.
+          break_travel_margin += (candidate - t_i_UB[step_rank]);
+        } else {
+          t_i_UB[step_rank] = candidate;
+        }
+        next_UB = t_i_UB[step_rank];
+        break;
+      }
+      case STEP_TYPE::END:
+        break;
+      }
 
-    // Now propagate some timing constraints for tighter lower bounds.
-    switch (step.type) {
-    case STEP_TYPE::START:
-      previous_LB = LB;
-      ++rank_in_J;
-      break;
-    case STEP_TYPE::JOB: {
-      LB = std::max(LB, previous_LB + previous_service + previous_travel);
-      previous_LB = LB;
-      previous_service = input.jobs[step.rank].service;
-      previous_travel = durations[rank_in_J];
-      ++rank_in_J;
-      break;
-    }
-    case STEP_TYPE::BREAK: {
-      LB = std::max(LB, previous_LB + previous_service);
-      previous_LB = LB;
-      previous_service = v.breaks[step.rank].service;
-      break;
-    }
-    case STEP_TYPE::END:
-      LB = std::max(LB, previous_LB + previous_service + previous_travel);
-      break;
-    }
-    t_i_LB.push_back(LB);
-    t_i_UB.push_back(UB);
-
-    if (step.type == STEP_TYPE::JOB or step.type == STEP_TYPE::BREAK) {
-      // Determine rank of the first relevant TW.
-      const auto& tws = (step.type == STEP_TYPE::JOB)
-                          ? input.jobs[step.rank].tws
-                          : v.breaks[step.rank].tws;
-      unsigned tw_rank = 0;
-      const auto tw =
-        std::find_if(tws.rbegin(), tws.rend(), [&](const auto& tw) {
-          return tw.start <= LB;
-        });
-      if (tw != tws.rend()) {
-        tw_rank = std::distance(tw, tws.rend()) - 1;
-
-        if (tw->end < LB and tw != tws.rbegin()) {
-          // Lower bound is between two time windows.
-          const auto next_tw = std::prev(tw, 1);
-          if ((next_tw->start - LB) < (LB - tw->end)) {
-            // Lead time to next time window will always be cheaper
-            // than delay from the current one, which can be
-            // discarded.
-            ++tw_rank;
+      if (step.type == STEP_TYPE::JOB or step.type == STEP_TYPE::BREAK) {
+        // Determine rank of the last relevant TW.
+        const auto UB = t_i_UB[step_rank];
+        const auto& tws = (step.type == STEP_TYPE::JOB)
+                            ? input.jobs[step.rank].tws
+                            : v.breaks[step.rank].tws;
+        unsigned tw_rank = tws.size() - 1;
+        const auto tw = utils::earliest_available_tw(tws, UB);
+        if (tw != tws.end()) {
+          tw_rank -= (std::distance(tw, tws.end()) - 1);
+
+          if (UB < tw->start and tw != tws.begin()) {
+            // Lower bound is between two time windows.
+            auto prev_tw = std::prev(tw, 1);
+            if ((UB - prev_tw->end) < (tw->start - UB)) {
+              // Delay from the previous time window will always be
+              // cheaper than lead time to the current one, which can be
+              // discarded.
+              --tw_rank;
+            }
           }
         }
+        last_relevant_tw_rank[step_rank - 1] = tw_rank;
       }
-      first_relevant_tw_rank.push_back(tw_rank);
     }
-  }
-  assert(first_relevant_tw_rank.size() == n);
-  assert(rank_in_J == J.size());
-  assert(t_i_LB.size() == steps.size());
-  assert(t_i_UB.size() == steps.size());
-
-  // Backward propagation for upper bounds based on travel/service
-  // constraints. Along the way, we store the rank of the last
-  // relevant TW (used below to force some binary variables to zero).
-  std::vector<unsigned> last_relevant_tw_rank(n);
-  Duration next_UB = t_i_UB.back();
-  Duration break_travel_margin = 0;
-  for (unsigned i = 0; i < steps.size(); ++i) {
-    auto step_rank = steps.size() - 1 - i;
-    const auto& step = steps[step_rank];
 
-    switch (step.type) {
-    case STEP_TYPE::START:
-      assert(rank_in_J == 1);
-      t_i_UB[step_rank] = std::min(t_i_UB[step_rank], next_UB - durations[0]);
-      break;
-    case STEP_TYPE::JOB: {
-      --rank_in_J;
-      const auto service = input.jobs[step.rank].service;
-      const auto next_travel = (break_travel_margin < durations[rank_in_J])
-                                 ? durations[rank_in_J] - break_travel_margin
-                                 : 0;
-      assert(service + next_travel <= next_UB);
-      t_i_UB[step_rank] =
-        std::min(t_i_UB[step_rank], next_UB - next_travel - service);
-      next_UB = t_i_UB[step_rank];
-      break_travel_margin = 0;
-      break;
+    const unsigned nb_delta_constraints = J.size();
+    assert(B.size() == nb_delta_constraints);
+    assert(durations.size() == nb_delta_constraints);
+
+    // Constants and column indices.
+    const unsigned nb_constraints = 4 * n + 3 + nb_delta_constraints + 2;
+    const unsigned nb_non_zero =
+      2 * (3 * n + 3) + 3 * K + 2 * n + 2 - default_job_tw + 2 + n + 2;
+    const unsigned start_Y_col = n + 3;
+    const unsigned start_X_col = 2 * n + 4 + 1;
+    const unsigned start_delta_col = start_X_col + K;
+    const unsigned nb_var = start_delta_col + n;
+
+    // 1. Get problem skeleton, reusing the thread-local model built
+    // for previous routes when available. All bounds, kinds and
+    // objective coefficients are (re)set below so only sizes need to
+    // be adjusted here.
+    if (model_cache.lp == nullptr) {
+      model_cache.lp = glp_create_prob();
+      glp_set_prob_name(model_cache.lp, "choose_ETA");
+      glp_set_obj_dir(model_cache.lp, GLP_MIN);
     }
-    case STEP_TYPE::BREAK: {
-      const auto service = v.breaks[step.rank].service;
-      assert(service <= next_UB);
-      const auto candidate = next_UB - service;
-      if (t_i_UB[step_rank] < candidate) {
-        // User-provided constraints gives margin for travel after
-        // this break.
-        break_travel_margin += (candidate - t_i_UB[step_rank]);
-      } else {
-        t_i_UB[step_rank] = candidate;
-      }
-      next_UB = t_i_UB[step_rank];
-      break;
+    lp = model_cache.lp;
+
+    if (model_cache.nb_rows < nb_constraints) {
+      glp_add_rows(lp, nb_constraints - model_cache.nb_rows);
+    } else if (nb_constraints < model_cache.nb_rows) {
+      std::vector<int> del_rows(1 + model_cache.nb_rows - nb_constraints);
+      std::iota(del_rows.begin() + 1, del_rows.end(), nb_constraints + 1);
+      glp_del_rows(lp, model_cache.nb_rows - nb_constraints, del_rows.data());
     }
-    case STEP_TYPE::END:
-      break;
+    model_cache.nb_rows = nb_constraints;
+
+    if (model_cache.nb_cols < nb_var) {
+      glp_add_cols(lp, nb_var - model_cache.nb_cols);
+    } else if (nb_var < model_cache.nb_cols) {
+      std::vector<int> del_cols(1 + model_cache.nb_cols - nb_var);
+      std::iota(del_cols.begin() + 1, del_cols.end(), nb_var + 1);
+      glp_del_cols(lp, model_cache.nb_cols - nb_var, del_cols.data());
     }
+    model_cache.nb_cols = nb_var;
 
-    if (step.type == STEP_TYPE::JOB or step.type == STEP_TYPE::BREAK) {
-      // Determine rank of the last relevant TW.
-      const auto UB = t_i_UB[step_rank];
-      const auto& tws = (step.type == STEP_TYPE::JOB)
-                          ? input.jobs[step.rank].tws
-                          : v.breaks[step.rank].tws;
-      unsigned tw_rank = tws.size() - 1;
-      const auto tw = std::find_if(tws.begin(), tws.end(), [&](const auto& tw) {
-        return UB <= tw.end;
-      });
-      if (tw != tws.end()) {
-        tw_rank -= (std::distance(tw, tws.end()) - 1);
-
-        if (UB < tw->start and tw != tws.begin()) {
-          // Lower bound is between two time windows.
-          auto prev_tw = std::prev(tw, 1);
-          if ((UB - prev_tw->end) < (tw->start - UB)) {
-            // Delay from the previous time window will always be
-            // cheaper than lead time to the current one, which can be
-            // discarded.
-            --tw_rank;
-          }
-        }
-      }
-      last_relevant_tw_rank[step_rank - 1] = tw_rank;
+    // Clear kinds and objective coefficients possibly left over from
+    // the previous route's second solving phase.
+    for (unsigned i = 1; i <= nb_var; ++i) {
+      glp_set_col_kind(lp, i, GLP_CV);
+      glp_set_obj_coef(lp, i, 0);
     }
-  }
 
-  const unsigned nb_delta_constraints = J.size();
-  assert(B.size() == nb_delta_constraints);
-  assert(durations.size() == nb_delta_constraints);
-
-  // 1. create problem.
-  glp_prob* lp;
-  lp = glp_create_prob();
-  glp_set_prob_name(lp, "choose_ETA");
-  glp_set_obj_dir(lp, GLP_MIN);
-
-  // Constants and column indices.
-  const unsigned nb_constraints = 4 * n + 3 + nb_delta_constraints + 2;
-  const unsigned nb_non_zero =
-    2 * (3 * n + 3) + 3 * K + 2 * n + 2 - default_job_tw + 2 + n + 2;
-  const unsigned start_Y_col = n + 3;
-  const unsigned start_X_col = 2 * n + 4 + 1;
-  const unsigned start_delta_col = start_X_col + K;
-  const unsigned nb_var = start_delta_col + n;
-
-  // Set objective for first optimization round (violations and
-  // makespan).
-  glp_add_cols(lp, nb_var);
-  for (unsigned i = 0; i <= n + 1; ++i) {
-    glp_set_obj_coef(lp, start_Y_col + i, makespan_estimate);
-  }
-  glp_set_obj_coef(lp, n + 2, 1);
-  glp_set_obj_coef(lp, 1, -1);
-
-  // 2. handle constraints.
-  glp_add_rows(lp, nb_constraints);
-
-  unsigned current_row = 1;
-
-  // Precedence constraints.
-  glp_set_row_name(lp, current_row, "P0");
-  glp_set_row_bnds(lp, current_row, GLP_LO, 0.0, 0.0);
-  ++current_row;
-
-  for (unsigned i = 0; i < n; ++i) {
-    auto name = "P" + std::to_string(i + 1);
-    glp_set_row_name(lp, current_row, name.c_str());
-    double service;
-    const auto& step = steps[1 + i];
-    if (step.type == STEP_TYPE::JOB) {
-      service = input.jobs[step.rank].service;
-    } else {
-      assert(step.type == STEP_TYPE::BREAK);
-      service = v.breaks[step.rank].service;
+    // Set objective for first optimization round (violations and
+    // makespan).
+    for (unsigned i = 0; i <= n + 1; ++i) {
+      glp_set_obj_coef(lp, start_Y_col + i, makespan_estimate);
     }
-    glp_set_row_bnds(lp, current_row, GLP_LO, service, 0.0);
-    ++current_row;
-  }
-  assert(current_row == n + 2);
-
-  // Vehicle TW start violation constraint.
-  glp_set_row_name(lp, current_row, "L0");
-  const double start_LB = v.tw.is_default() ? 0 : v.tw.start - horizon_start;
-  glp_set_row_bnds(lp, current_row, GLP_LO, start_LB, 0.0);
-  ++current_row;
-
-  // Lead time ("earliest violation") constraints.
-  for (unsigned i = 0; i < n; ++i) {
-    auto name = "L" + std::to_string(i + 1);
-    glp_set_row_name(lp, current_row, name.c_str());
+    glp_set_obj_coef(lp, n + 2, 1);
+    glp_set_obj_coef(lp, 1, -1);
+
+    // 2. handle constraints.
+    unsigned current_row = 1;
+
+    // Precedence constraints.
     glp_set_row_bnds(lp, current_row, GLP_LO, 0.0, 0.0);
     ++current_row;
-  }
-  assert(current_row == 2 * n + 3);
 
-  // Delay ("latest violation") constraints.
-  for (unsigned i = 0; i < n; ++i) {
-    auto name = "D" + std::to_string(i + 1);
-    glp_set_row_name(lp, current_row, name.c_str());
-    glp_set_row_bnds(lp, current_row, GLP_UP, 0.0, 0.0);
-    ++current_row;
-  }
+    for (unsigned i = 0; i < n; ++i) {
+      double service;
+      const auto& step = steps[1 + i];
+      if (step.type == STEP_TYPE::JOB) {
+        service = input.jobs[step.rank].service;
+      } else {
+        assert(step.type == STEP_TYPE::BREAK);
+        service = v.breaks[step.rank].service;
+      }
+      glp_set_row_bnds(lp, current_row, GLP_LO, service, 0.0);
+      ++current_row;
+    }
+    assert(current_row == n + 2);
 
-  // Vehicle TW end violation constraint.
-  auto name = "D" + std::to_string(n + 1);
-  glp_set_row_name(lp, current_row, name.c_str());
-  // Using v.tw.end is fine too for a default time window.
-  glp_set_row_bnds(lp, current_row, GLP_UP, 0.0, v.tw.end - horizon_start);
-  ++current_row;
+    // Vehicle TW start violation constraint.
+    const double start_LB = v.tw.is_default() ? 0 : v.tw.start - horizon_start;
+    glp_set_row_bnds(lp, current_row, GLP_LO, start_LB, 0.0);
+    ++current_row;
 
-  assert(current_row == 3 * n + 4);
+    // Lead time ("earliest violation") constraints.
+    for (unsigned i = 0; i < n; ++i) {
+      glp_set_row_bnds(lp, current_row, GLP_LO, 0.0, 0.0);
+      ++current_row;
+    }
+    assert(current_row == 2 * n + 3);
 
-  // Binary variable decision constraints.
-  for (unsigned i = 1; i <= n; ++i) {
-    auto name = "S" + std::to_string(i);
-    glp_set_row_name(lp, current_row, name.c_str());
-    glp_set_row_bnds(lp, current_row, GLP_FX, 1.0, 1.0);
-    ++current_row;
-  }
-  assert(current_row == 4 * n + 4);
+    // Delay ("latest violation") constraints.
+    for (unsigned i = 0; i < n; ++i) {
+      glp_set_row_bnds(lp, current_row, GLP_UP, 0.0, 0.0);
+      ++current_row;
+    }
 
-  // Delta constraints.
-  for (unsigned r = 0; r < J.size(); ++r) {
-    auto name = "Delta" + std::to_string(J[r]);
-    glp_set_row_name(lp, current_row, name.c_str());
-    glp_set_row_bnds(lp, current_row, GLP_FX, durations[r], durations[r]);
+    // Vehicle TW end violation constraint.
+    // Using v.tw.end is fine too for a default time window.
+    glp_set_row_bnds(lp, current_row, GLP_UP, 0.0, v.tw.end - horizon_start);
     ++current_row;
-  }
-
-  // Makespan and \sum Y_i dummy constraints (used for second solving
-  // phase).
-  name = "Makespan";
-  glp_set_row_name(lp, current_row, name.c_str());
-  glp_set_row_bnds(lp, current_row, GLP_LO, 0, 0);
 
-  ++current_row;
-  assert(current_row == nb_constraints);
+    assert(current_row == 3 * n + 4);
 
-  name = "Sigma_Y";
-  glp_set_row_name(lp, current_row, name.c_str());
-  if (sample_violations == 0) {
-    glp_set_row_bnds(lp, current_row, GLP_FX, 0, 0);
-  } else {
-    glp_set_row_bnds(lp, current_row, GLP_DB, 0, sample_violations);
-  }
+    // Binary variable decision constraints.
+    for (unsigned i = 1; i <= n; ++i) {
+      glp_set_row_bnds(lp, current_row, GLP_FX, 1.0, 1.0);
+      ++current_row;
+    }
+    assert(current_row == 4 * n + 4);
 
-  // 3. set variables and coefficients.
-  unsigned current_col = 1;
-  // Variables for time of services (t_i values).
-  for (unsigned i = 0; i <= n + 1; ++i) {
-    auto name = "t" + std::to_string(i);
-    glp_set_col_name(lp, current_col, name.c_str());
+    // Delta constraints.
+    for (unsigned r = 0; r < J.size(); ++r) {
+      glp_set_row_bnds(lp, current_row, GLP_FX, durations[r], durations[r]);
+      ++current_row;
+    }
 
-    const Duration LB = t_i_LB[i];
-    const Duration UB = t_i_UB[i];
+    // Makespan and \sum Y_i dummy constraints (used for second solving
+    // phase).
+    glp_set_row_bnds(lp, current_row, GLP_LO, 0, 0);
 
-    if (UB < LB) {
-      throw Exception(ERROR::INPUT,
-                      "Infeasible route for vehicle " + std::to_string(v.id) +
-                        ".");
-    }
+    ++current_row;
+    assert(current_row == nb_constraints);
 
-    if (LB == UB) {
-      // Fixed t_i value.
-      double service_at = static_cast<double>(LB - horizon_start);
-      glp_set_col_bnds(lp, current_col, GLP_FX, service_at, service_at);
+    if (sample_violations == 0) {
+      glp_set_row_bnds(lp, current_row, GLP_FX, 0, 0);
     } else {
-      // t_i value has a lower bound, either 0 or user-defined.
-      double service_after = static_cast<double>(LB - horizon_start);
-      double service_before = static_cast<double>(UB - horizon_start);
-      glp_set_col_bnds(lp, current_col, GLP_DB, service_after, service_before);
+      glp_set_row_bnds(lp, current_row, GLP_DB, 0, sample_violations);
     }
-    ++current_col;
-  }
-  assert(current_col == start_Y_col);
-
-  // Define variables for measure of TW violation.
-  for (unsigned i = 0; i <= n + 1; ++i) {
-    auto name = "Y" + std::to_string(i);
-    glp_set_col_name(lp, current_col, name.c_str());
-    glp_set_col_bnds(lp, current_col, GLP_LO, 0.0, 0.0);
-    ++current_col;
-  }
-  assert(current_col == 2 * n + 5);
-
-  // Binary variables for job time window choice.
-  for (unsigned i = 0; i < n; ++i) {
-    const auto& step = steps[1 + i];
-    const auto& tws = (step.type == STEP_TYPE::JOB) ? input.jobs[step.rank].tws
-                                                    : v.breaks[step.rank].tws;
-    for (unsigned k = 0; k < tws.size(); ++k) {
-      auto name = "X" + std::to_string(i + 1) + "_" + std::to_string(k);
-      glp_set_col_name(lp, current_col, name.c_str());
-      glp_set_col_kind(lp, current_col, GLP_BV);
-      if (k < first_relevant_tw_rank[i] or k > last_relevant_tw_rank[i]) {
-        glp_set_col_bnds(lp, current_col, GLP_FX, 0, 0);
+
+    // 3. set variables and coefficients.
+    unsigned current_col = 1;
+    // Variables for time of services (t_i values).
+    for (unsigned i = 0; i <= n + 1; ++i) {
+      const Duration LB = t_i_LB[i];
+      const Duration UB = t_i_UB[i];
+
+      if (UB < LB) {
+        throw Exception(ERROR::INPUT,
+                        "Infeasible route for vehicle " + std::to_string(v.id) +
+                          ".");
+      }
+
+      if (LB == UB) {
+        // Fixed t_i value.
+        double service_at = static_cast<double>(LB - horizon_start);
+        glp_set_col_bnds(lp, current_col, GLP_FX, service_at, service_at);
+      } else {
+        // t_i value has a lower bound, either 0 or user-defined.
+        double service_after = static_cast<double>(LB - horizon_start);
+        double service_before = static_cast<double>(UB - horizon_start);
+        glp_set_col_bnds(lp, current_col, GLP_DB, service_after, service_before);
       }
       ++current_col;
     }
-  }
-  assert(current_col == start_delta_col);
-
-  // Delta variables.
-  for (unsigned i = 0; i <= n; ++i) {
-    auto name = "delta" + std::to_string(i);
-    glp_set_col_name(lp, current_col, name.c_str());
-    glp_set_col_bnds(lp, current_col, GLP_LO, 0.0, 0.0);
-    ++current_col;
-  }
-  assert(current_col == nb_var + 1);
-
-  // Define non-zero elements in matrix.
-  int* ia = new int[1 + nb_non_zero];
-  int* ja = new int[1 + nb_non_zero];
-  double* ar = new double[1 + nb_non_zero];
-
-  unsigned r = 1;
-  // Coefficients for precedence constraints.
-  for (unsigned i = 1; i <= n + 1; ++i) {
-    // a[i,i] = -1
-    ia[r] = i;
-    ja[r] = i;
-    ar[r] = -1;
-    ++r;
+    assert(current_col == start_Y_col);
 
-    // a[i,i + 1] = 1
-    ia[r] = i;
-    ja[r] = i + 1;
-    ar[r] = 1;
-    ++r;
-
-    // a[i, start_delta_col + i - 1] = -1
-    ia[r] = i;
-    ja[r] = start_delta_col + i - 1;
-    ar[r] = -1;
-    ++r;
-  }
+    // Define variables for measure of TW violation.
+    for (unsigned i = 0; i <= n + 1; ++i) {
+      glp_set_col_bnds(lp, current_col, GLP_LO, 0.0, 0.0);
+      ++current_col;
+    }
+    assert(current_col == 2 * n + 5);
+
+    // Binary variables for job time window choice.
+    for (unsigned i = 0; i < n; ++i) {
+      const auto& step = steps[1 + i];
+      const auto& tws = (step.type == STEP_TYPE::JOB) ? input.jobs[step.rank].tws
+                                                      : v.breaks[step.rank].tws;
+      for (unsigned k = 0; k < tws.size(); ++k) {
+        glp_set_col_kind(lp, current_col, GLP_BV);
+        if (k < first_relevant_tw_rank[i] or k > last_relevant_tw_rank[i]) {
+          glp_set_col_bnds(lp, current_col, GLP_FX, 0, 0);
+        }
+        ++current_col;
+      }
+    }
+    assert(current_col == start_delta_col);
 
-  unsigned constraint_rank = n + 2;
+    // Delta variables.
+    for (unsigned i = 0; i <= n; ++i) {
+      glp_set_col_bnds(lp, current_col, GLP_LO, 0.0, 0.0);
+      ++current_col;
+    }
+    assert(current_col == nb_var + 1);
+
+    // Define non-zero elements in matrix, assembled in place in the
+    // reused triplet arrays.
+    if (model_cache.ia.size() < 1 + nb_non_zero) {
+      model_cache.ia.resize(1 + nb_non_zero);
+      model_cache.ja.resize(1 + nb_non_zero);
+      model_cache.ar.resize(1 + nb_non_zero);
+    }
+    int* ia = model_cache.ia.data();
+    int* ja = model_cache.ja.data();
+    double* ar = model_cache.ar.data();
+
+    unsigned r = 1;
+    // Coefficients for precedence constraints.
+    for (unsigned i = 1; i <= n + 1; ++i) {
+      // a[i,i] = -1
+      ia[r] = i;
+      ja[r] = i;
+      ar[r] = -1;
+      ++r;
 
-  // Coefficients for L0 constraint.
-  // a[constraint_rank, 1] = 1
-  ia[r] = constraint_rank;
-  ja[r] = 1;
-  ar[r] = 1;
-  ++r;
+      // a[i,i + 1] = 1
+      ia[r] = i;
+      ja[r] = i + 1;
+      ar[r] = 1;
+      ++r;
 
-  // a[constraint_rank, start_Y_col] = 1
-  ia[r] = constraint_rank;
-  ja[r] = start_Y_col;
-  ar[r] = 1;
-  ++r;
-  ++constraint_rank;
+      // a[i, start_delta_col + i - 1] = -1
+      ia[r] = i;
+      ja[r] = start_delta_col + i - 1;
+      ar[r] = -1;
+      ++r;
+    }
 
-  // Coefficients for other L_i constraints. current_X_rank is the
-  // rank for binaries that describe the time window choices.
-  unsigned current_X_rank = start_X_col;
+    unsigned constraint_rank = n + 2;
 
-  for (unsigned i = 0; i < n; ++i) {
-    // a[constraint_rank, i + 2] = 1
+    // Coefficients for L0 constraint.
+    // a[constraint_rank, 1] = 1
     ia[r] = constraint_rank;
-    ja[r] = i + 2;
+    ja[r] = 1;
     ar[r] = 1;
     ++r;
 
-    // a[constraint_rank, n + 4 + i] = 1
+    // a[constraint_rank, start_Y_col] = 1
     ia[r] = constraint_rank;
-    ja[r] = n + 4 + i;
+    ja[r] = start_Y_col;
     ar[r] = 1;
     ++r;
+    ++constraint_rank;
 
-    const auto& step = steps[1 + i];
-    const auto& tws = (step.type == STEP_TYPE::JOB) ? input.jobs[step.rank].tws
-                                                    : v.breaks[step.rank].tws;
-    if (step.type == STEP_TYPE::JOB and tws.front().is_default()) {
-      // Not setting a value in this case means the constraint will
-      // always be met with matching Y set to 0.
-      ++current_X_rank;
-    } else {
-      for (const auto& tw : tws) {
-        // a[constraint_rank, current_X_rank] = - earliest_date for k-th
-        // TW of task.
+    // Coefficients for other L_i constraints. current_X_rank is the
+    // rank for binaries that describe the time window choices.
+    unsigned current_X_rank = start_X_col;
+
+    for (unsigned i = 0; i < n; ++i) {
+      // a[constraint_rank, i + 2] = 1
+      ia[r] = constraint_rank;
+      ja[r] = i + 2;
+      ar[r] = 1;
+      ++r;
+
+      // a[constraint_rank, n + 4 + i] = 1
+      ia[r] = constraint_rank;
+      ja[r] = n + 4 + i;
+      ar[r] = 1;
+      ++r;
+
+      const auto& step = steps[1 + i];
+      const auto& tws = (step.type == STEP_TYPE::JOB) ? input.jobs[step.rank].tws
+                                                      : v.breaks[step.rank].tws;
+      if (step.type == STEP_TYPE::JOB and tws.front().is_default()) {
+        // Not setting a value in this case means the constraint will
+        // always be met with matching Y set to 0.
+        ++current_X_rank;
+      } else {
+        for (const auto& tw : tws) {
+          // a[constraint_rank, current_X_rank] = - earliest_date for k-th
+          // TW of task.
+          ia[r] = constraint_rank;
+          ja[r] = current_X_rank;
+          ar[r] = -static_cast<double>(tw.start - horizon_start);
+          ++r;
+
+          ++current_X_rank;
+        }
+      }
+
+      ++constraint_rank;
+    }
+    assert(current_X_rank == start_delta_col);
+    assert(constraint_rank == 2 * n + 3);
+
+    // Coefficients for D_i constraints.
+    current_X_rank = start_X_col;
+
+    for (unsigned i = 0; i < n; ++i) {
+      // a[constraint_rank, i + 2] = 1
+      ia[r] = constraint_rank;
+      ja[r] = i + 2;
+      ar[r] = 1;
+      ++r;
+
+      // a[constraint_rank, n + 4 + i] = -1
+      ia[r] = constraint_rank;
+      ja[r] = n + 4 + i;
+      ar[r] = -1;
+      ++r;
+
+      const auto& step = steps[1 + i];
+      const auto& tws = (step.type == STEP_TYPE::JOB) ? input.jobs[step.rank].tws
+                                                      : v.breaks[step.rank].tws;
+      if (step.type == STEP_TYPE::JOB and tws.front().is_default()) {
+        // Set a value that makes sure this constraint is automatically
+        // met with matching Y value set to 0.
         ia[r] = constraint_rank;
         ja[r] = current_X_rank;
-        ar[r] = -static_cast<double>(tw.start - horizon_start);
+        ar[r] = -static_cast<double>(horizon_end);
         ++r;
 
         ++current_X_rank;
+      } else {
+        for (const auto& tw : tws) {
+          // a[constraint_rank, current_X_rank] = - latest_date for k-th
+          // TW of task.
+          ia[r] = constraint_rank;
+          ja[r] = current_X_rank;
+          ar[r] = -static_cast<double>(tw.end - horizon_start);
+          ++r;
+
+          ++current_X_rank;
+        }
       }
-    }
-
-    ++constraint_rank;
-  }
-  assert(current_X_rank == start_delta_col);
-  assert(constraint_rank == 2 * n + 3);
 
-  // Coefficients for D_i constraints.
-  current_X_rank = start_X_col;
+      ++constraint_rank;
+    }
+    assert(current_X_rank == 2 * n + 4 + K + 1);
 
-  for (unsigned i = 0; i < n; ++i) {
-    // a[constraint_rank, i + 2] = 1
+    // Coefficients D_{n + 1} constraint.
+    // a[constraint_rank, n + 2] = 1
     ia[r] = constraint_rank;
-    ja[r] = i + 2;
+    ja[r] = n + 2;
     ar[r] = 1;
     ++r;
 
-    // a[constraint_rank, n + 4 + i] = -1
+    // a[constraint_rank, 2 * n + 4] = -1
     ia[r] = constraint_rank;
-    ja[r] = n + 4 + i;
+    ja[r] = 2 * n + 4;
     ar[r] = -1;
     ++r;
+    ++constraint_rank;
 
-    const auto& step = steps[1 + i];
-    const auto& tws = (step.type == STEP_TYPE::JOB) ? input.jobs[step.rank].tws
-                                                    : v.breaks[step.rank].tws;
-    if (step.type == STEP_TYPE::JOB and tws.front().is_default()) {
-      // Set a value that makes sure this constraint is automatically
-      // met with matching Y value set to 0.
-      ia[r] = constraint_rank;
-      ja[r] = current_X_rank;
-      ar[r] = -static_cast<double>(horizon_end);
-      ++r;
+    assert(constraint_rank == 3 * n + 4);
 
-      ++current_X_rank;
-    } else {
-      for (const auto& tw : tws) {
-        // a[constraint_rank, current_X_rank] = - latest_date for k-th
-        // TW of task.
+    // Decision constraints S_i for binary variables.
+    current_X_rank = start_X_col;
+
+    for (unsigned i = 0; i < n; ++i) {
+      const auto& step = steps[1 + i];
+      const auto& tws = (step.type == STEP_TYPE::JOB) ? input.jobs[step.rank].tws
+                                                      : v.breaks[step.rank].tws;
+
+      for (unsigned k = 0; k < tws.size(); ++k) {
+        // a[constraint_rank, current_X_rank] = 1
         ia[r] = constraint_rank;
         ja[r] = current_X_rank;
-        ar[r] = -static_cast<double>(tw.end - horizon_start);
+        ar[r] = 1;
         ++r;
 
         ++current_X_rank;
       }
+      ++constraint_rank;
     }
+    assert(current_X_rank == start_delta_col);
+    assert(constraint_rank == 4 * n + 4);
 
-    ++constraint_rank;
-  }
-  assert(current_X_rank == 2 * n + 4 + K + 1);
-
-  // Coefficients D_{n + 1} constraint.
-  // a[constraint_rank, n + 2] = 1
-  ia[r] = constraint_rank;
-  ja[r] = n + 2;
-  ar[r] = 1;
-  ++r;
-
-  // a[constraint_rank, 2 * n + 4] = -1
-  ia[r] = constraint_rank;
-  ja[r] = 2 * n + 4;
-  ar[r] = -1;
-  ++r;
-  ++constraint_rank;
-
-  assert(constraint_rank == 3 * n + 4);
-
-  // Decision constraints S_i for binary variables.
-  current_X_rank = start_X_col;
-
-  for (unsigned i = 0; i < n; ++i) {
-    const auto& step = steps[1 + i];
-    const auto& tws = (step.type == STEP_TYPE::JOB) ? input.jobs[step.rank].tws
-                                                    : v.breaks[step.rank].tws;
-
-    for (unsigned k = 0; k < tws.size(); ++k) {
-      // a[constraint_rank, current_X_rank] = 1
-      ia[r] = constraint_rank;
-      ja[r] = current_X_rank;
-      ar[r] = 1;
-      ++r;
+    // Delta_i constraints. Going through all delta variables exactly
+    // once using B.
+    unsigned current_delta_rank = start_delta_col;
+    for (const auto Bi : B) {
+      const auto row_limit = current_delta_rank + 1 + Bi;
 
-      ++current_X_rank;
+      while (current_delta_rank < row_limit) {
+        // a[constraint_rank, current_delta_rank] = 1
+        ia[r] = constraint_rank;
+        ja[r] = current_delta_rank;
+        ar[r] = 1;
+        ++r;
+        ++current_delta_rank;
+      }
+      ++constraint_rank;
     }
-    ++constraint_rank;
-  }
-  assert(current_X_rank == start_delta_col);
-  assert(constraint_rank == 4 * n + 4);
+    assert(current_delta_rank = nb_var + 1);
+
+    // Makespan coefficients
+    // a[constraint_rank, 1] = -1
+    ia[r] = constraint_rank;
+    ja[r] = 1;
+    ar[r] = -1;
+    ++r;
+    // a[constraint_rank, n + 2] = 1
+    ia[r] = constraint_rank;
+    ja[r] = n + 2;
+    ar[r] = 1;
+    ++r;
 
-  // Delta_i constraints. Going through all delta variables exactly
-  // once using B.
-  unsigned current_delta_rank = start_delta_col;
-  for (const auto Bi : B) {
-    const auto row_limit = current_delta_rank + 1 + Bi;
+    ++constraint_rank;
+    assert(constraint_rank == nb_constraints);
 
-    while (current_delta_rank < row_limit) {
-      // a[constraint_rank, current_delta_rank] = 1
+    // \sum Y_i
+    for (unsigned i = start_Y_col; i < start_X_col; ++i) {
+      // a[constraint_rank, i] = 1
       ia[r] = constraint_rank;
-      ja[r] = current_delta_rank;
+      ja[r] = i;
       ar[r] = 1;
       ++r;
-      ++current_delta_rank;
-    }
-    ++constraint_rank;
-  }
-  assert(current_delta_rank = nb_var + 1);
-
-  // Makespan coefficients
-  // a[constraint_rank, 1] = -1
-  ia[r] = constraint_rank;
-  ja[r] = 1;
-  ar[r] = -1;
-  ++r;
-  // a[constraint_rank, n + 2] = 1
-  ia[r] = constraint_rank;
-  ja[r] = n + 2;
-  ar[r] = 1;
-  ++r;
-
-  ++constraint_rank;
-  assert(constraint_rank == nb_constraints);
-
-  // \sum Y_i
-  for (unsigned i = start_Y_col; i < start_X_col; ++i) {
-    // a[constraint_rank, i] = 1
-    ia[r] = constraint_rank;
-    ja[r] = i;
-    ar[r] = 1;
-    ++r;
-  }
-  assert(r == nb_non_zero + 1);
-
-  glp_load_matrix(lp, nb_non_zero, ia, ja, ar);
-
-  delete[] ia;
-  delete[] ja;
-  delete[] ar;
-
-  // 4. Solve for violations and makespan.
-  glp_term_out(GLP_OFF);
-  glp_iocp parm;
-  glp_init_iocp(&parm);
-  parm.presolve = GLP_ON;
-  // Adjust branching heuristic due to
-  // https://lists.gnu.org/archive/html/bug-glpk/2020-11/msg00001.html
-  parm.br_tech = GLP_BR_MFV;
-
-  glp_intopt(lp, &parm);
-
-  auto status = glp_mip_status(lp);
-  if (status == GLP_UNDEF or status == GLP_NOFEAS) {
-    throw Exception(ERROR::INPUT,
-                    "Infeasible route for vehicle " + std::to_string(v.id) +
-                      ".");
-  }
-  // We should not get GLP_FEAS.
-  assert(status == GLP_OPT);
-
-  // const auto v_str = std::to_string(v.id);
-  // glp_write_lp(lp, NULL, ("mip_1_v_" + v_str + ".lp").c_str());
-  // glp_print_mip(lp, ("mip_1_v_" + v_str + ".sol").c_str());
-
-  // 5. Solve for earliest start dates.
-  // Adjust objective.
-  Duration delta_sum_majorant = 0;
-  current_delta_rank = start_delta_col;
-  for (unsigned i = 0; i < B.size(); ++i) {
-    for (unsigned k = current_delta_rank + 1; k < current_delta_rank + 1 + B[i];
-         ++k) {
-      glp_set_obj_coef(lp, k, k - current_delta_rank);
     }
-    current_delta_rank += (1 + B[i]);
-    delta_sum_majorant += (B[i] * durations[i]);
-  }
-  assert(current_delta_rank = nb_var + 1);
+    assert(r == nb_non_zero + 1);
 
-  for (unsigned i = 0; i <= n + 1; ++i) {
-    glp_set_obj_coef(lp, start_Y_col + i, 0);
-  }
-  glp_set_obj_coef(lp, n + 2, 0);
-  glp_set_obj_coef(lp, 1, 0);
+    glp_load_matrix(lp, nb_non_zero, ia, ja, ar);
 
-  const auto M = (delta_sum_majorant == 0) ? 1 : delta_sum_majorant;
-  for (unsigned i = 2; i <= n + 1; ++i) {
-    glp_set_obj_coef(lp, i, M);
-  }
+    // 4. Solve for violations and makespan.
+    glp_term_out(GLP_OFF);
+    glp_iocp parm;
+    glp_init_iocp(&parm);
+    parm.presolve = GLP_ON;
+    // Adjust branching heuristic due to
+    // https://lists.gnu.org/archive/html/bug-glpk/2020-11/msg00001.html
+    parm.br_tech = GLP_BR_MFV;
+    set_time_limit(parm, deadline);
 
-  // Add constraint to fix makespan.
-  const Duration best_makespan = get_duration(glp_mip_col_val(lp, n + 2)) -
-                                 get_duration(glp_mip_col_val(lp, 1));
-  glp_set_row_bnds(lp,
-                   nb_constraints - 1,
-                   GLP_FX,
-                   best_makespan,
-                   best_makespan);
-  // Pin Y_i sum.
-  Duration sum_y_i = 0;
-  for (unsigned i = start_Y_col; i < start_X_col; ++i) {
-    sum_y_i += get_duration(glp_mip_col_val(lp, i));
-  }
-  glp_set_row_bnds(lp, nb_constraints, GLP_FX, sum_y_i, sum_y_i);
+    auto solve_rc = glp_intopt(lp, &parm);
+    bool out_of_time = (solve_rc == GLP_ETMLIM);
 
-  glp_intopt(lp, &parm);
-
-  // glp_write_lp(lp, NULL, ("mip_2_v_" + v_str + ".lp").c_str());
-  // glp_print_mip(lp, ("mip_2_v_" + v_str + ".sol").c_str());
+    auto status = glp_mip_status(lp);
+    if (!out_of_time and (status == GLP_UNDEF or status == GLP_NOFEAS)) {
+      throw Exception(ERROR::INPUT,
+                      "Infeasible route for vehicle " + std::to_string(v.id) +
+                        ".");
+    }
+    // We should not get GLP_FEAS when solving ran to completion.
+    assert(out_of_time or status == GLP_OPT);
+    approx_schedule = (status != GLP_OPT);
+
+    // const auto v_str = std::to_string(v.id);
+    // glp_write_lp(lp, NULL, ("mip_1_v_" + v_str + ".lp").c_str());
+    // glp_print_mip(lp, ("mip_1_v_" + v_str + ".sol").c_str());
+
+    if (!approx_schedule) {
+      // 5. Solve for earliest start dates.
+      // Adjust objective.
+      Duration delta_sum_majorant = 0;
+      current_delta_rank = start_delta_col;
+      for (unsigned i = 0; i < B.size(); ++i) {
+        for (unsigned k = current_delta_rank + 1; k < current_delta_rank + 1 + B[i];
+             ++k) {
+          glp_set_obj_coef(lp, k, k - current_delta_rank);
+        }
+        current_delta_rank += (1 + B[i]);
+        delta_sum_majorant += (B[i] * durations[i]);
+      }
+      assert(current_delta_rank = nb_var + 1);
 
-  status = glp_mip_status(lp);
-  if (status == GLP_UNDEF or status == GLP_NOFEAS) {
-    throw Exception(ERROR::INPUT,
-                    "Infeasible route for vehicle " + std::to_string(v.id) +
-                      ".");
-  }
-  // We should not get GLP_FEAS.
-  assert(status == GLP_OPT);
+      for (unsigned i = 0; i <= n + 1; ++i) {
+        glp_set_obj_coef(lp, start_Y_col + i, 0);
+      }
+      glp_set_obj_coef(lp, n + 2, 0);
+      glp_set_obj_coef(lp, 1, 0);
 
-  // Get output.
-  const Duration v_start = horizon_start + get_duration(glp_mip_col_val(lp, 1));
-  const Duration v_end =
-    horizon_start + get_duration(glp_mip_col_val(lp, n + 2));
-  const Duration start_travel =
-    get_duration(glp_mip_col_val(lp, start_delta_col));
+      const auto M = (delta_sum_majorant == 0) ? 1 : delta_sum_majorant;
+      for (unsigned i = 2; i <= n + 1; ++i) {
+        glp_set_obj_coef(lp, i, M);
+      }
 
-  std::vector<Duration> task_ETA;
-  std::vector<Duration> task_travels;
-  for (unsigned i = 0; i < n; ++i) {
-    task_ETA.push_back(horizon_start +
-                       get_duration(glp_mip_col_val(lp, i + 2)));
-    task_travels.push_back(
-      get_duration(glp_mip_col_val(lp, start_delta_col + 1 + i)));
-  }
+      // Add constraint to fix makespan.
+      const Duration best_makespan = get_duration(glp_mip_col_val(lp, n + 2)) -
+                                     get_duration(glp_mip_col_val(lp, 1));
+      glp_set_row_bnds(lp,
+                       nb_constraints - 1,
+                       GLP_FX,
+                       best_makespan,
+                       best_makespan);
+      // Pin Y_i sum.
+      Duration sum_y_i = 0;
+      for (unsigned i = start_Y_col; i < start_X_col; ++i) {
+        sum_y_i += get_duration(glp_mip_col_val(lp, i));
+      }
+      glp_set_row_bnds(lp, nb_constraints, GLP_FX, sum_y_i, sum_y_i);
 
-  // Populate vector storing picked time window ranks.
-  current_X_rank = start_X_col;
-  std::vector<Index> task_tw_ranks;
+      set_time_limit(parm, deadline);
+      solve_rc = glp_intopt(lp, &parm);
+      out_of_time = (solve_rc == GLP_ETMLIM);
 
-  for (const auto& step : steps) {
-    switch (step.type) {
-    case STEP_TYPE::START:
-      break;
-    case STEP_TYPE::JOB: {
-      const auto& job = input.jobs[step.rank];
-      for (unsigned k = 0; k < job.tws.size(); ++k) {
-        auto val = get_duration(glp_mip_col_val(lp, current_X_rank));
-        if (val == 1) {
-          task_tw_ranks.push_back(k);
-        }
+      // glp_write_lp(lp, NULL, ("mip_2_v_" + v_str + ".lp").c_str());
+      // glp_print_mip(lp, ("mip_2_v_" + v_str + ".sol").c_str());
 
-        ++current_X_rank;
+      status = glp_mip_status(lp);
+      if (!out_of_time and (status == GLP_UNDEF or status == GLP_NOFEAS)) {
+        throw Exception(ERROR::INPUT,
+                        "Infeasible route for vehicle " + std::to_string(v.id) +
+                          ".");
       }
-      break;
+      // We should not get GLP_FEAS when solving ran to completion.
+      assert(out_of_time or status == GLP_OPT);
+      approx_schedule = (status != GLP_OPT);
     }
-    case STEP_TYPE::BREAK: {
-      const auto& b = v.breaks[step.rank];
-      for (unsigned k = 0; k < b.tws.size(); ++k) {
-        auto val = get_duration(glp_mip_col_val(lp, current_X_rank));
-        if (val == 1) {
-          task_tw_ranks.push_back(k);
+
+    if (approx_schedule) {
+      // Solving did not complete before deadline for this route, so
+      // fall back to a greedy schedule: start ASAP and serve each
+      // task at the earliest date allowed by travel and service
+      // times, its time windows and forced service dates. Travel to
+      // the next non-break task happens eagerly, right after each
+      // non-break task. Resulting violations are an upper bound,
+      // flagged as approximate in the output.
+      task_ETA.clear();
+      task_travels.clear();
+      task_tw_ranks.clear();
+
+      unsigned leg_rank = 0;
+      Duration current_time = start_candidate;
+
+      for (const auto& step : steps) {
+        if (step.forced_service.at.has_value()) {
+          current_time = std::max(current_time, step.forced_service.at.value());
+        }
+        if (step.forced_service.after.has_value()) {
+          current_time =
+            std::max(current_time, step.forced_service.after.value());
         }
 
-        ++current_X_rank;
+        switch (step.type) {
+        case STEP_TYPE::START:
+          v_start = current_time;
+          start_travel = durations[leg_rank];
+          current_time += durations[leg_rank];
+          ++leg_rank;
+          break;
+        case STEP_TYPE::JOB: {
+          const auto& job = input.jobs[step.rank];
+          const auto tw =
+            utils::earliest_available_tw(job.tws, current_time);
+          if (tw == job.tws.end()) {
+            // Delay, reported against last time window.
+            task_tw_ranks.push_back(job.tws.size() - 1);
+          } else {
+            current_time = std::max(current_time, tw->start);
+            task_tw_ranks.push_back(std::distance(job.tws.begin(), tw));
+          }
+          task_ETA.push_back(current_time);
+          task_travels.push_back(durations[leg_rank]);
+          current_time += job.service + durations[leg_rank];
+          ++leg_rank;
+          break;
+        }
+        case STEP_TYPE::BREAK: {
+          const auto& b = v.breaks[step.rank];
+          const auto tw =
+            utils::earliest_available_tw(b.tws, current_time);
+          if (tw == b.tws.end()) {
+            task_tw_ranks.push_back(b.tws.size() - 1);
+          } else {
+            current_time = std::max(current_time, tw->start);
+            task_tw_ranks.push_back(std::distance(b.tws.begin(), tw));
+          }
+          task_ETA.push_back(current_time);
+          task_travels.push_back(0);
+          current_time += b.service;
+          break;
+        }
+        case STEP_TYPE::END:
+          v_end = current_time;
+          break;
+        }
       }
+      assert(leg_rank == durations.size());
+      assert(task_ETA.size() == n and task_tw_ranks.size() == n);
+    } else {
+      // Get output.
+      v_start = horizon_start + get_duration(glp_mip_col_val(lp, 1));
+      v_end = horizon_start + get_duration(glp_mip_col_val(lp, n + 2));
+      start_travel = get_duration(glp_mip_col_val(lp, start_delta_col));
+
+      for (unsigned i = 0; i < n; ++i) {
+        task_ETA.push_back(horizon_start +
+                           get_duration(glp_mip_col_val(lp, i + 2)));
+        task_travels.push_back(
+          get_duration(glp_mip_col_val(lp, start_delta_col + 1 + i)));
+      }
+
+      // Populate vector storing picked time window ranks.
+      current_X_rank = start_X_col;
+
+      for (const auto& step : steps) {
+        switch (step.type) {
+        case STEP_TYPE::START:
+          break;
+        case STEP_TYPE::JOB: {
+          const auto& job = input.jobs[step.rank];
+          for (unsigned k = 0; k < job.tws.size(); ++k) {
+            auto val = get_duration(glp_mip_col_val(lp, current_X_rank));
+            if (val == 1) {
+              task_tw_ranks.push_back(k);
+            }
+
+            ++current_X_rank;
+          }
+          break;
+        }
+        case STEP_TYPE::BREAK: {
+          const auto& b = v.breaks[step.rank];
+          for (unsigned k = 0; k < b.tws.size(); ++k) {
+            auto val = get_duration(glp_mip_col_val(lp, current_X_rank));
+            if (val == 1) {
+              task_tw_ranks.push_back(k);
+            }
+
+            ++current_X_rank;
+          }
+        }
+        case STEP_TYPE::END:
+          break;
+        }
+      }
+      assert(current_X_rank == start_delta_col);
+      assert(task_tw_ranks.size() == n);
     }
-    case STEP_TYPE::END:
-      break;
-    }
+
   }
-  assert(current_X_rank == start_delta_col);
-  assert(task_tw_ranks.size() == n);
 
   // Generate route.
   Cost duration = 0;
@@ -1112,7 +1294,8 @@ Route choose_ETA(const Input& input,
     Duration lt = v.tw.start - v_start;
     sol_steps.back().violations.lead_time = lt;
     lead_time += lt;
-    assert(lt == get_duration(glp_mip_col_val(lp, start_Y_col)));
+    assert(lp == nullptr or approx_schedule or
+           lt == get_duration(glp_mip_col_val(lp, n + 3)));
   }
 
   if (!(current_load <= v.capacity)) {
@@ -1121,8 +1304,8 @@ Route choose_ETA(const Input& input,
   }
 
   Duration previous_start = v_start;
-  previous_service = 0;
-  previous_travel = start_travel;
+  Duration previous_service = 0;
+  Duration previous_travel = start_travel;
   unsigned task_rank = 0;
 
   for (const auto& step : steps) {
@@ -1294,11 +1477,14 @@ Route choose_ETA(const Input& input,
     }
   }
 
-  assert(get_duration(glp_mip_col_val(lp, 2 * n + 4)) ==
-         sol_steps.back().violations.delay);
+  assert(lp == nullptr or approx_schedule or
+         get_duration(glp_mip_col_val(lp, 2 * n + 4)) ==
+           sol_steps.back().violations.delay);
 
-  glp_delete_prob(lp);
-  glp_free_env();
+  // The problem object and the thread-local GLPK environment are
+  // both kept alive for reuse by further routes checked on this
+  // thread, and released in check_and_set_ETA once all routes are
+  // done.
 
   // Precedence violations for pickups without a delivery.
   for (const auto d_rank : expected_delivery_ranks) {
@@ -1312,6 +1498,9 @@ Route choose_ETA(const Input& input,
     v_types.insert(VIOLATION::MISSING_BREAK);
   }
 
+  Violations violations(lead_time, delay, std::move(v_types));
+  violations.approximate = approx_schedule;
+
   return Route(v.id,
                std::move(sol_steps),
                duration,
@@ -1319,11 +1508,11 @@ Route choose_ETA(const Input& input,
                duration,
                forward_wt,
                priority,
-               sum_deliveries,
-               sum_pickups,
+               std::move(sum_deliveries),
+               std::move(sum_pickups),
                v.profile,
                v.description,
-               std::move(Violations(lead_time, delay, std::move(v_types))));
+               std::move(violations));
 }
 
 } // namespace validation
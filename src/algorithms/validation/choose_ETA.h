@@ -16,9 +16,19 @@ All rights reserved (see LICENSE).
 namespace vroom {
 namespace validation {
 
+// Compute task ETAs for given vehicle route. ETAs are optimal wrt
+// time window violations, except when solving does not complete
+// before deadline: a greedy schedule is then returned instead, with
+// its violations flagged as approximate.
 Route choose_ETA(const Input& input,
                  unsigned vehicle_rank,
-                 const std::vector<VehicleStep>& steps);
+                 const std::vector<VehicleStep>& steps,
+                 const Deadline& deadline);
+
+// Delete the thread-local GLPK model that choose_ETA keeps across
+// routes checked on the same thread. To be called once a thread is
+// done with all its routes, before releasing the GLPK environment.
+void release_model_cache();
 
 } // namespace validation
 } // namespace vroom
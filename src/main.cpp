@@ -7,10 +7,21 @@ All rights reserved (see LICENSE).
 
 */
 
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
 #include <fstream>
+#include <functional>
 #include <iostream>
-#include <sstream>
+#include <mutex>
+#include <thread>
 #ifndef _WIN32
+#include <atomic>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <unistd.h>
 #else
 #include "getopt_win.h"
@@ -22,11 +33,114 @@ All rights reserved (see LICENSE).
 
 #include "problems/vrp.h"
 #include "structures/cl_args.h"
+#include "utils/auto_tune.h"
+#include "utils/daemon.h"
 #include "utils/helpers.h"
 #include "utils/input_parser.h"
+#include "utils/numa.h"
+#include "utils/output_binary.h"
 #include "utils/output_json.h"
+#include "utils/thread_pool.h"
 #include "utils/version.h"
 
+namespace {
+
+// Size of the read chunks used for bulk input ingestion. Large
+// enough that reads from a pipe run at pipe bandwidth with one
+// syscall per chunk instead of streambuf per-character extraction.
+constexpr std::size_t INPUT_CHUNK_SIZE = 1 << 20;
+
+// Slurp a whole stream through large chunked reads directly into the
+// returned string, which then gets parsed in situ. This is the
+// single resulting buffer: no stringstream accumulation and no extra
+// copy on the way out.
+std::string read_all(std::istream& in) {
+  std::string content;
+  std::size_t size = 0;
+  for (;;) {
+    content.resize(size + INPUT_CHUNK_SIZE);
+    in.read(content.data() + size, INPUT_CHUNK_SIZE);
+    const auto nb_read = static_cast<std::size_t>(in.gcount());
+    size += nb_read;
+    if (nb_read < INPUT_CHUNK_SIZE) {
+      break;
+    }
+  }
+  content.resize(size);
+  return content;
+}
+
+// Newline-delimited reader for batch mode, pulling large chunks and
+// splitting them with memchr instead of per-character std::getline
+// extraction. Batch lines hold whole problems, so a line routinely
+// spans several chunks.
+class BulkLineReader {
+  std::istream& _in;
+  std::vector<char> _buffer;
+  std::size_t _next = 0;
+  std::size_t _available = 0;
+  bool _input_consumed = false;
+
+public:
+  BulkLineReader(std::istream& in) : _in(in), _buffer(INPUT_CHUNK_SIZE) {
+  }
+
+  bool next_line(std::string& line) {
+    line.clear();
+    for (;;) {
+      if (_next == _available) {
+        if (_input_consumed) {
+          // A trailing line without final newline still counts.
+          return !line.empty();
+        }
+        _in.read(_buffer.data(), _buffer.size());
+        _available = static_cast<std::size_t>(_in.gcount());
+        _next = 0;
+        _input_consumed = (_available < _buffer.size());
+        if (_available == 0) {
+          continue;
+        }
+      }
+      const char* start = _buffer.data() + _next;
+      const auto* newline = static_cast<const char*>(
+        memchr(start, '\n', _available - _next));
+      if (newline == nullptr) {
+        line.append(start, _available - _next);
+        _next = _available;
+        continue;
+      }
+      line.append(start, newline - start);
+      _next = (newline - _buffer.data()) + 1;
+      return true;
+    }
+  }
+};
+
+} // namespace
+
+void write_solution(const vroom::io::CLArgs& cl_args,
+                    const vroom::Solution& sol,
+                    bool geometry) {
+#ifndef _WIN32
+  if (!cl_args.shm_output_name.empty()) {
+    vroom::io::write_to_shm(sol,
+                            geometry,
+                            cl_args.shm_output_name,
+                            cl_args.output_file);
+    return;
+  }
+#endif
+  if (cl_args.binary_output) {
+    vroom::io::write_to_binary(sol, geometry, cl_args.output_file);
+  } else {
+    vroom::io::write_to_json(sol,
+                             geometry,
+                             cl_args.output_file,
+                             cl_args.geometry_output_file,
+                             cl_args.plan_diff);
+  }
+}
+
 void display_usage() {
   std::string usage = "VROOM Copyright (C) 2015-2021, Julien Coupey\n";
   usage += "Version: " + vroom::get_version() + "\n";
@@ -35,53 +149,152 @@ void display_usage() {
   usage += "\tvroom [OPTION]...\n";
   usage += "Options:\n";
   usage += "\t-a PROFILE:HOST (=" + vroom::DEFAULT_PROFILE +
-           ":0.0.0.0)\t routing server\n";
+           ":0.0.0.0)\t routing server (use a comma-separated host\n";
+  usage += "\t\t\t\t\t list for hedged requests to replicas)\n";
+  usage += "\t-A NUM,\t\t\t\t also report up to NUM runner-up\n";
+  usage += "\t\t\t\t\t assignments from the solving parameter\n";
+  usage += "\t\t\t\t\t sweep as fallback plans (json output)\n";
+  usage += "\t-b,\t\t\t\t batch mode: read newline-delimited problems\n";
+  usage += "\t\t\t\t\t and write one solution per line\n";
   usage += "\t-c,\t\t\t\t choose ETA for custom routes and report violations\n";
+  usage += "\t-C CPUS,\t\t\t pin solver threads to this CPU set\n";
+  usage += "\t\t\t\t\t (e.g. \"0-3,8\") to keep their cache\n";
+  usage += "\t\t\t\t\t residency away from other workloads\n";
+  usage += "\t-d PORT,\t\t\t run as a long-running http server on PORT,\n";
+  usage += "\t\t\t\t\t solving each posted problem\n";
+  usage += "\t-f FORMAT (=json),\t\t output format: json, binary, or\n";
+  usage += "\t\t\t\t\t shm:NAME to lay the binary solution out\n";
+  usage += "\t\t\t\t\t in a shared memory segment for zero-copy\n";
+  usage += "\t\t\t\t\t same-host consumers\n";
   usage += "\t-g,\t\t\t\t add detailed route geometry and indicators\n";
+  usage += "\t-G FILE,\t\t\t write route geometries to FILE instead of\n";
+  usage += "\t\t\t\t\t inlining them (implies -g)\n";
   usage += "\t-i FILE,\t\t\t read input from FILE rather than from stdin\n";
+  usage += "\t-k,\t\t\t\t cache solutions and reuse them on exact\n";
+  usage += "\t\t\t\t\t resubmissions (server and batch modes)\n";
+  usage += "\t-l LIMIT,\t\t\t stop solving after LIMIT seconds and return\n";
+  usage += "\t\t\t\t\t the best solution found so far\n";
+  usage += "\t-m,\t\t\t\t back large cost matrices with 2 MB huge\n";
+  usage += "\t\t\t\t\t pages when available (Linux)\n";
+  usage += "\t-M LIMIT,\t\t\t memory budget in megabytes for solving\n";
+  usage += "\t\t\t\t\t state caches, recompute on demand beyond it\n";
+  usage += "\t-n NICE,\t\t\t run solver threads at this niceness, or\n";
+  usage += "\t\t\t\t\t \"batch[:NICE]\" to also use SCHED_BATCH,\n";
+  usage += "\t\t\t\t\t so background solves yield to interactive\n";
+  usage += "\t\t\t\t\t ones (Linux)\n";
   usage += "\t-o OUTPUT,\t\t\t output file name\n";
   usage += "\t-p PROFILE:PORT (=" + vroom::DEFAULT_PROFILE +
            ":5000),\t routing server port\n";
-  usage += "\t-r ROUTER (=osrm),\t\t osrm, libosrm, ors or valhalla\n";
-  usage += "\t-t THREADS (=4),\t\t number of threads to use\n";
-  usage += "\t-x EXPLORE (=5),\t\t exploration level to use (0..5)";
+  usage += "\t-r ROUTER (=osrm),\t\t osrm, libosrm, ors, valhalla or\n";
+  usage += "\t\t\t\t\t haversine (local approximate durations)\n";
+  usage += "\t-s FILE,\t\t\t checkpoint the best solution to FILE while\n";
+  usage += "\t\t\t\t\t solving, and resume from it when present\n";
+  usage += "\t-t THREADS (=4),\t\t number of threads to use, \"auto\" for\n";
+  usage += "\t\t\t\t\t the effective CPU quota (cgroup-aware)\n";
+  usage += "\t-u,\t\t\t\t only output routes changed from the\n";
+  usage += "\t\t\t\t\t warm-start assignment (json output)\n";
+  usage += "\t-w RANK/COUNT,\t\t\t only run this rank's share of the\n";
+  usage += "\t\t\t\t\t heuristic parameter sweep, spreading one\n";
+  usage += "\t\t\t\t\t solve across COUNT processes\n";
+  usage += "\t-x EXPLORE (=5),\t\t exploration level to use (0..6, level 6\n";
+  usage += "\t\t\t\t\t adds a ruin-and-recreate phase), or\n";
+  usage += "\t\t\t\t\t \"auto:DEADLINE\" to pick the highest level\n";
+  usage += "\t\t\t\t\t expected to solve within DEADLINE\n";
+  usage += "\t\t\t\t\t milliseconds based on recorded history\n";
+  usage += "\t\t\t\t\t (see VROOM_TUNER_HISTORY)\n";
+  usage += "\t-z,\t\t\t\t store durations as 16-bit values when they\n";
+  usage += "\t\t\t\t\t all fit, halving matrix cache footprint";
   std::cout << usage << std::endl;
   exit(0);
 }
 
+#ifndef _WIN32
+namespace {
+// Solve to cancel when a termination signal arrives, nullptr once
+// solving completed. Exchanged to nullptr by the signal watcher on
+// first use so a second signal force-quits.
+std::atomic<vroom::Input*> signal_target(nullptr);
+} // namespace
+#endif
+
 int main(int argc, char** argv) {
   // Load default command-line options.
   vroom::io::CLArgs cl_args;
 
   // Parsing command-line arguments.
-  const char* optString = "a:ce:gi:o:p:r:t:x:h?";
+  const char* optString = "a:A:bcC:d:e:f:gG:i:kl:mM:n:o:p:r:s:t:uw:x:zh?";
   int opt = getopt(argc, argv, optString);
 
+  bool batch = false;
+  std::string daemon_port;
+  std::string format_arg;
   std::string router_arg;
   std::string nb_threads_arg = std::to_string(cl_args.nb_threads);
+  std::string timeout_arg = std::to_string(cl_args.timeout);
   std::string exploration_level_arg = std::to_string(cl_args.exploration_level);
+  std::string sweep_slice_arg;
+  std::string memory_budget_arg = std::to_string(cl_args.memory_budget);
+  std::string solver_cpus_arg;
+  std::string alternatives_arg;
+  std::string nice_arg;
   std::vector<std::string> heuristic_params_arg;
+  bool auto_exploration = false;
+  unsigned long tuner_deadline_ms = 0;
 
   while (opt != -1) {
     switch (opt) {
     case 'a':
       vroom::io::update_host(cl_args.servers, optarg);
       break;
+    case 'A':
+      alternatives_arg = optarg;
+      break;
+    case 'b':
+      batch = true;
+      break;
     case 'c':
       cl_args.check = true;
       break;
+    case 'C':
+      solver_cpus_arg = optarg;
+      break;
+    case 'd':
+      daemon_port = optarg;
+      break;
     case 'e':
       heuristic_params_arg.push_back(optarg);
       break;
+    case 'f':
+      format_arg = optarg;
+      break;
     case 'g':
       cl_args.geometry = true;
       break;
+    case 'G':
+      cl_args.geometry_output_file = optarg;
+      cl_args.geometry = true;
+      break;
     case 'h':
       display_usage();
       break;
     case 'i':
       cl_args.input_file = optarg;
       break;
+    case 'k':
+      cl_args.solution_cache = true;
+      break;
+    case 'l':
+      timeout_arg = optarg;
+      break;
+    case 'm':
+      cl_args.huge_pages = true;
+      break;
+    case 'M':
+      memory_budget_arg = optarg;
+      break;
+    case 'n':
+      nice_arg = optarg;
+      break;
     case 'o':
       cl_args.output_file = optarg;
       break;
@@ -91,12 +304,24 @@ int main(int argc, char** argv) {
     case 'r':
       router_arg = optarg;
       break;
+    case 's':
+      cl_args.checkpoint_file = optarg;
+      break;
     case 't':
       nb_threads_arg = optarg;
       break;
+    case 'u':
+      cl_args.plan_diff = true;
+      break;
+    case 'w':
+      sweep_slice_arg = optarg;
+      break;
     case 'x':
       exploration_level_arg = optarg;
       break;
+    case 'z':
+      cl_args.compact_matrices = true;
+      break;
     default:
       break;
     }
@@ -106,11 +331,87 @@ int main(int argc, char** argv) {
   try {
     // Needs to be done after previous switch to make sure the
     // appropriate output file is set.
-    cl_args.nb_threads = std::stoul(nb_threads_arg);
-    cl_args.exploration_level = std::stoul(exploration_level_arg);
+    if (!solver_cpus_arg.empty()) {
+      // Expand a "0-3,8"-like CPU list. Configured before the thread
+      // count below so "-t auto" caps at the size of the set.
+      std::size_t pos = 0;
+      while (pos < solver_cpus_arg.size()) {
+        std::size_t parsed;
+        const unsigned first =
+          std::stoul(solver_cpus_arg.substr(pos), &parsed);
+        pos += parsed;
+        unsigned last = first;
+        if (pos < solver_cpus_arg.size() and solver_cpus_arg[pos] == '-') {
+          ++pos;
+          last = std::stoul(solver_cpus_arg.substr(pos), &parsed);
+          pos += parsed;
+        }
+        if (last < first) {
+          throw std::invalid_argument("Inverted CPU range.");
+        }
+        for (unsigned cpu = first; cpu <= last; ++cpu) {
+          cl_args.solver_cpus.push_back(cpu);
+        }
+        if (pos < solver_cpus_arg.size()) {
+          if (solver_cpus_arg[pos] != ',') {
+            throw std::invalid_argument("Invalid CPU set.");
+          }
+          ++pos;
+        }
+      }
+      vroom::utils::set_solver_cpus(cl_args.solver_cpus);
+    }
+
+    cl_args.nb_threads = (nb_threads_arg == "auto")
+                           ? vroom::utils::effective_concurrency()
+                           : std::stoul(nb_threads_arg);
+    cl_args.timeout = std::stoul(timeout_arg);
+    if (exploration_level_arg.rfind("auto:", 0) == 0) {
+      // The actual level is predicted from recorded history once the
+      // instance is parsed, with the current default as fallback.
+      auto_exploration = true;
+      tuner_deadline_ms = std::stoul(exploration_level_arg.substr(5));
+    } else {
+      cl_args.exploration_level = std::stoul(exploration_level_arg);
+    }
+    cl_args.memory_budget = std::stoul(memory_budget_arg);
+    if (!alternatives_arg.empty()) {
+      cl_args.nb_alternatives = std::stoul(alternatives_arg);
+    }
 
     cl_args.exploration_level =
       std::min(cl_args.exploration_level, cl_args.max_exploration_level);
+
+    if (!sweep_slice_arg.empty()) {
+      const auto slash = sweep_slice_arg.find('/');
+      if (slash == std::string::npos) {
+        throw std::invalid_argument("Missing / in sweep slice.");
+      }
+      cl_args.sweep_rank = std::stoul(sweep_slice_arg.substr(0, slash));
+      cl_args.sweep_count = std::stoul(sweep_slice_arg.substr(slash + 1));
+      if (cl_args.sweep_count == 0 or
+          cl_args.sweep_count <= cl_args.sweep_rank) {
+        throw std::invalid_argument("Inconsistent sweep slice.");
+      }
+    }
+
+    if (!nice_arg.empty()) {
+      if (nice_arg == "batch") {
+        cl_args.batch_scheduling = true;
+      } else if (nice_arg.rfind("batch:", 0) == 0) {
+        cl_args.batch_scheduling = true;
+        cl_args.nice_value = std::stoi(nice_arg.substr(6));
+      } else {
+        cl_args.nice_value = std::stoi(nice_arg);
+      }
+    }
+
+    vroom::utils::enable_huge_pages(cl_args.huge_pages);
+    vroom::enable_compact_durations(cl_args.compact_matrices);
+    if (cl_args.batch_scheduling or cl_args.nice_value != 0) {
+      vroom::utils::set_solver_scheduling(cl_args.nice_value,
+                                          cl_args.batch_scheduling);
+    }
   } catch (const std::exception& e) {
     auto error_code = vroom::utils::get_code(vroom::ERROR::INPUT);
     std::string message = "Invalid numerical value in option.";
@@ -119,6 +420,22 @@ int main(int argc, char** argv) {
     exit(error_code);
   }
 
+  // Determine output format (defaults to json).
+  if (format_arg == "binary") {
+    cl_args.binary_output = true;
+#ifndef _WIN32
+  } else if (format_arg.rfind("shm:", 0) == 0 and format_arg.size() > 4) {
+    cl_args.binary_output = true;
+    cl_args.shm_output_name = format_arg.substr(4);
+#endif
+  } else if (!format_arg.empty() and format_arg != "json") {
+    auto error_code = vroom::utils::get_code(vroom::ERROR::INPUT);
+    std::string message = "Invalid output format: " + format_arg + ".";
+    std::cerr << "[Error] " << message << std::endl;
+    vroom::io::write_to_json({error_code, message}, false, cl_args.output_file);
+    exit(error_code);
+  }
+
   // Determine routing engine (defaults to ROUTER::OSRM).
   if (router_arg == "libosrm") {
     cl_args.router = vroom::ROUTER::LIBOSRM;
@@ -126,6 +443,8 @@ int main(int argc, char** argv) {
     cl_args.router = vroom::ROUTER::ORS;
   } else if (router_arg == "valhalla") {
     cl_args.router = vroom::ROUTER::VALHALLA;
+  } else if (router_arg == "haversine") {
+    cl_args.router = vroom::ROUTER::HAVERSINE;
   } else if (!router_arg.empty() and router_arg != "osrm") {
     auto error_code = vroom::utils::get_code(vroom::ERROR::INPUT);
     std::string message = "Invalid routing engine: " + router_arg + ".";
@@ -157,18 +476,135 @@ int main(int argc, char** argv) {
     cl_args.servers.emplace(vroom::DEFAULT_PROFILE, vroom::Server());
   }
 
+  if (!daemon_port.empty()) {
+    // Long-running server mode, solving incoming problems with warm
+    // process state instead of reading a single input.
+    try {
+      vroom::io::run_daemon(cl_args, daemon_port);
+    } catch (const vroom::Exception& e) {
+      auto error_code = vroom::utils::get_code(e.error);
+      std::cerr << "[Error] " << e.message << std::endl;
+      exit(error_code);
+    } catch (const std::exception& e) {
+      auto error_code = vroom::utils::get_code(vroom::ERROR::INTERNAL);
+      std::cerr << "[Error] " << e.what() << std::endl;
+      exit(error_code);
+    }
+    return 0;
+  }
+
+  if (batch) {
+    // Solve a stream of newline-delimited problems back-to-back,
+    // writing one solution per line. Each solve uses the configured
+    // number of threads, so problems are processed one at a time.
+    std::ifstream batch_file;
+    std::istream* in_stream = &std::cin;
+    if (!cl_args.input_file.empty()) {
+      batch_file.open(cl_args.input_file);
+      in_stream = &batch_file;
+    }
+
+    std::ofstream out_file;
+    std::ostream* out_stream = &std::cout;
+    if (!cl_args.output_file.empty()) {
+      out_file.open(cl_args.output_file, std::ofstream::out);
+      out_stream = &out_file;
+    }
+
+    // Serialization runs on a dedicated writer thread so formatting
+    // and writing a solved problem overlaps with solving the next
+    // one. The queue is double-buffered: solving only stalls when
+    // writing falls two problems behind.
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<std::function<std::string()>> pending;
+    bool done = false;
+
+    std::thread writer([&]() {
+      for (;;) {
+        std::function<std::string()> format;
+        {
+          std::unique_lock<std::mutex> lock(mutex);
+          cv.wait(lock, [&]() { return !pending.empty() or done; });
+          if (pending.empty()) {
+            return;
+          }
+          format = std::move(pending.front());
+          pending.pop_front();
+        }
+        cv.notify_all();
+
+        *out_stream << format() << "\n";
+        // Queue consumers typically read solutions line by line.
+        out_stream->flush();
+      }
+    });
+
+    BulkLineReader reader(*in_stream);
+    std::string line;
+    while (reader.next_line(line)) {
+      if (line.empty()) {
+        continue;
+      }
+      auto format = vroom::io::solve_to_json_deferred(cl_args,
+                                                      std::move(line));
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [&]() { return pending.size() < 2; });
+        pending.push_back(std::move(format));
+      }
+      cv.notify_all();
+    }
+
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      done = true;
+    }
+    cv.notify_all();
+    writer.join();
+
+    return 0;
+  }
+
   // Read input problem
   if (optind == argc) {
-    std::stringstream buffer;
-    if (cl_args.input_file.empty()) {
-      // Getting input from stdin.
-      buffer << std::cin.rdbuf();
-    } else {
-      // Getting input from provided file.
-      std::ifstream ifs(cl_args.input_file);
-      buffer << ifs.rdbuf();
+#ifndef _WIN32
+    if (!cl_args.input_file.empty()) {
+      // Map the input file copy-on-write and parse it in place, which
+      // avoids reading it into a buffer of its own entirely.
+      // In-situ parsing null-terminates strings
+      // inside the (private) mapping so we rely on the zero-padding
+      // of the last page for the final terminator, hence the size
+      // check below.
+      const auto fd = open(cl_args.input_file.c_str(), O_RDONLY);
+      if (fd >= 0) {
+        struct stat file_stat;
+        if (fstat(fd, &file_stat) == 0 and file_stat.st_size > 0 and
+            file_stat.st_size % sysconf(_SC_PAGESIZE) != 0) {
+          auto* mapping = static_cast<char*>(mmap(nullptr,
+                                                  file_stat.st_size,
+                                                  PROT_READ | PROT_WRITE,
+                                                  MAP_PRIVATE,
+                                                  fd,
+                                                  0));
+          if (mapping != MAP_FAILED) {
+            cl_args.mapped_input = mapping;
+          }
+        }
+        close(fd);
+      }
+    }
+#endif
+    if (cl_args.mapped_input == nullptr) {
+      if (cl_args.input_file.empty()) {
+        // Getting input from stdin, usually a pipe.
+        cl_args.input = read_all(std::cin);
+      } else {
+        // Getting input from provided file.
+        std::ifstream ifs(cl_args.input_file);
+        cl_args.input = read_all(ifs);
+      }
     }
-    cl_args.input = buffer.str();
   } else {
     // Getting input from command-line.
     cl_args.input = argv[optind];
@@ -178,20 +614,74 @@ int main(int argc, char** argv) {
     // Build problem.
     vroom::Input problem_instance = vroom::io::parse(cl_args);
 
+    const auto features = vroom::utils::instance_features(problem_instance);
+    if (auto_exploration) {
+      cl_args.exploration_level =
+        vroom::utils::predict_exploration_level(features,
+                                                tuner_deadline_ms,
+                                                cl_args.exploration_level);
+      // The deadline also acts as a timeout backstop in case the
+      // prediction turns out too optimistic.
+      if (cl_args.timeout == 0) {
+        cl_args.timeout = (tuner_deadline_ms + 999) / 1000;
+      }
+    }
+
+#ifndef _WIN32
+    // Turn SIGINT/SIGTERM into a cooperative cancellation so an
+    // interrupted run still emits its best solution so far through
+    // the normal output path; the periodic checkpoint file covers
+    // abrupt kills like the OOM reaper. Signals are blocked before
+    // solving threads are spawned and handled synchronously by a
+    // watcher thread.
+    signal_target.store(&problem_instance);
+
+    sigset_t termination_signals;
+    sigemptyset(&termination_signals);
+    sigaddset(&termination_signals, SIGINT);
+    sigaddset(&termination_signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &termination_signals, nullptr);
+
+    std::thread([termination_signals]() {
+      for (;;) {
+        int signal_number = 0;
+        sigwait(&termination_signals, &signal_number);
+        auto* target = signal_target.exchange(nullptr);
+        if (target == nullptr) {
+          std::_Exit(128 + signal_number);
+        }
+        target->cancel_solving();
+      }
+    }).detach();
+#endif
+
     vroom::Solution sol = (cl_args.check)
-                            ? problem_instance.check(cl_args.nb_threads)
+                            ? problem_instance.check(cl_args.nb_threads,
+                                                     cl_args.timeout)
                             : problem_instance.solve(cl_args.exploration_level,
                                                      cl_args.nb_threads,
+                                                     cl_args.timeout,
                                                      cl_args.h_params);
 
+#ifndef _WIN32
+    // Late signals should no longer reach into the solve.
+    signal_target.store(nullptr);
+#endif
+
+    if (!cl_args.check) {
+      vroom::utils::record_solve_history(features,
+                                         cl_args.exploration_level,
+                                         cl_args.nb_threads,
+                                         sol.summary.computing_times.solving,
+                                         sol.summary.cost);
+    }
+
     // Write solution.
-    vroom::io::write_to_json(sol, cl_args.geometry, cl_args.output_file);
+    write_solution(cl_args, sol, cl_args.geometry);
   } catch (const vroom::Exception& e) {
     auto error_code = vroom::utils::get_code(e.error);
     std::cerr << "[Error] " << e.message << std::endl;
-    vroom::io::write_to_json({error_code, e.message},
-                             false,
-                             cl_args.output_file);
+    write_solution(cl_args, {error_code, e.message}, false);
     exit(error_code);
   }
 #if USE_LIBOSRM
@@ -200,7 +690,7 @@ int main(int argc, char** argv) {
     auto error_code = vroom::utils::get_code(vroom::ERROR::ROUTING);
     auto message = "Routing problem: " + std::string(e.what());
     std::cerr << "[Error] " << message << std::endl;
-    vroom::io::write_to_json({error_code, message}, false, cl_args.output_file);
+    write_solution(cl_args, {error_code, message}, false);
     exit(error_code);
   }
 #endif
@@ -208,9 +698,7 @@ int main(int argc, char** argv) {
     // In case of an unhandled internal error.
     auto error_code = vroom::utils::get_code(vroom::ERROR::INTERNAL);
     std::cerr << "[Error] " << e.what() << std::endl;
-    vroom::io::write_to_json({error_code, e.what()},
-                             false,
-                             cl_args.output_file);
+    write_solution(cl_args, {error_code, e.what()}, false);
     exit(error_code);
   }
 
@@ -53,6 +53,10 @@ public:
   // precise gain requires validity information.
   Gain gain_upper_bound();
 
+  virtual OPERATOR name() const override {
+    return OPERATOR::CROSS_EXCHANGE;
+  }
+
   virtual bool is_valid() override;
 
   virtual void apply() override;
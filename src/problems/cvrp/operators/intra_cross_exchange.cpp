@@ -41,7 +41,7 @@ IntraCrossExchange::IntraCrossExchange(const Input& input,
     s_normal_t_reverse_is_valid(false),
     s_reverse_t_reverse_is_valid(false),
     s_reverse_t_normal_is_valid(false),
-    _moved_jobs(t_rank - s_rank + 2),
+    _moved_jobs(ls::scratch::borrow(t_rank - s_rank + 2)),
     _first_rank(s_rank),
     _last_rank(t_rank + 2) {
   // Use s_rank as smallest rank for symmetry reasons.
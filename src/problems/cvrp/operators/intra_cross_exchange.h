@@ -55,6 +55,10 @@ public:
   // precise gain requires validity information.
   Gain gain_upper_bound();
 
+  virtual OPERATOR name() const override {
+    return OPERATOR::INTRA_CROSS_EXCHANGE;
+  }
+
   virtual bool is_valid() override;
 
   virtual void apply() override;
@@ -62,6 +66,10 @@ public:
   virtual std::vector<Index> addition_candidates() const override;
 
   virtual std::vector<Index> update_candidates() const override;
+
+  virtual ~IntraCrossExchange() {
+    ls::scratch::give_back(std::move(_moved_jobs));
+  }
 };
 
 } // namespace cvrp
@@ -26,7 +26,7 @@ IntraExchange::IntraExchange(const Input& input,
              s_raw_route,
              s_vehicle,
              t_rank),
-    _moved_jobs(t_rank - s_rank + 1),
+    _moved_jobs(ls::scratch::borrow(t_rank - s_rank + 1)),
     _first_rank(s_rank),
     _last_rank(t_rank + 1) {
   // Assume s_rank < t_rank for symmetry reasons. Set aside cases
@@ -31,6 +31,10 @@ public:
                 Index s_rank,
                 Index t_rank);
 
+  virtual OPERATOR name() const override {
+    return OPERATOR::INTRA_EXCHANGE;
+  }
+
   virtual bool is_valid() override;
 
   virtual void apply() override;
@@ -38,6 +42,10 @@ public:
   virtual std::vector<Index> addition_candidates() const override;
 
   virtual std::vector<Index> update_candidates() const override;
+
+  virtual ~IntraExchange() {
+    ls::scratch::give_back(std::move(_moved_jobs));
+  }
 };
 
 } // namespace cvrp
@@ -35,7 +35,8 @@ IntraMixedExchange::IntraMixedExchange(const Input& input,
     check_t_reverse(check_t_reverse),
     s_is_normal_valid(false),
     s_is_reverse_valid(false),
-    _moved_jobs((s_rank < t_rank) ? t_rank - s_rank + 2 : s_rank - t_rank + 1),
+    _moved_jobs(ls::scratch::borrow((s_rank < t_rank) ? t_rank - s_rank + 2
+                                              : s_rank - t_rank + 1)),
     _first_rank(std::min(s_rank, t_rank)),
     _last_rank((t_rank < s_rank) ? s_rank + 1 : t_rank + 2) {
   // If node at s_rank is right before/after edge at t_rank, then the
@@ -35,7 +35,8 @@ IntraOrOpt::IntraOrOpt(const Input& input,
     is_normal_valid(false),
     is_reverse_valid(false),
     check_reverse(check_reverse),
-    _moved_jobs((s_rank < t_rank) ? t_rank - s_rank + 2 : s_rank - t_rank + 2),
+    _moved_jobs(ls::scratch::borrow((s_rank < t_rank) ? t_rank - s_rank + 2
+                                              : s_rank - t_rank + 2)),
     _first_rank(std::min(s_rank, t_rank)),
     _last_rank(std::max(s_rank, t_rank) + 2) {
   assert(s_route.size() >= 4);
@@ -207,15 +208,7 @@ void IntraOrOpt::apply() {
          (_input.jobs[s_route[s_rank]].type == JOB_TYPE::SINGLE and
           _input.jobs[s_route[s_rank + 1]].type == JOB_TYPE::SINGLE));
 
-  auto first_job_rank = s_route[s_rank];
-  auto second_job_rank = s_route[s_rank + 1];
-  s_route.erase(s_route.begin() + s_rank, s_route.begin() + s_rank + 2);
-  s_route.insert(s_route.begin() + t_rank, {first_job_rank, second_job_rank});
-  if (reverse_s_edge) {
-    std::swap(t_route[t_rank], t_route[t_rank + 1]);
-  }
-
-  source.update_amounts(_input);
+  source.move_segment(_input, s_rank, 2, t_rank, reverse_s_edge);
 }
 
 std::vector<Index> IntraOrOpt::addition_candidates() const {
@@ -51,6 +51,10 @@ public:
   // precise gain requires validity information.
   Gain gain_upper_bound();
 
+  virtual OPERATOR name() const override {
+    return OPERATOR::INTRA_OR_OPT;
+  }
+
   virtual bool is_valid() override;
 
   virtual void apply() override;
@@ -58,6 +62,10 @@ public:
   virtual std::vector<Index> addition_candidates() const override;
 
   virtual std::vector<Index> update_candidates() const override;
+
+  virtual ~IntraOrOpt() {
+    ls::scratch::give_back(std::move(_moved_jobs));
+  }
 };
 
 } // namespace cvrp
@@ -27,7 +27,8 @@ IntraRelocate::IntraRelocate(const Input& input,
              s_raw_route,
              s_vehicle,
              t_rank),
-    _moved_jobs((s_rank < t_rank) ? t_rank - s_rank + 1 : s_rank - t_rank + 1),
+    _moved_jobs(ls::scratch::borrow((s_rank < t_rank) ? t_rank - s_rank + 1
+                                              : s_rank - t_rank + 1)),
     _first_rank(std::min(s_rank, t_rank)),
     _last_rank(std::max(s_rank, t_rank) + 1) {
   assert(s_route.size() >= 2);
@@ -80,11 +81,7 @@ bool IntraRelocate::is_valid() {
 }
 
 void IntraRelocate::apply() {
-  auto relocate_job_rank = s_route[s_rank];
-  s_route.erase(s_route.begin() + s_rank);
-  s_route.insert(t_route.begin() + t_rank, relocate_job_rank);
-
-  source.update_amounts(_input);
+  source.move_segment(_input, s_rank, 1, t_rank, false);
 }
 
 std::vector<Index> IntraRelocate::addition_candidates() const {
@@ -31,6 +31,10 @@ public:
                 Index s_rank,
                 Index t_rank); // relocate rank *after* removal.
 
+  virtual OPERATOR name() const override {
+    return OPERATOR::INTRA_RELOCATE;
+  }
+
   virtual bool is_valid() override;
 
   virtual void apply() override;
@@ -38,6 +42,10 @@ public:
   virtual std::vector<Index> addition_candidates() const override;
 
   virtual std::vector<Index> update_candidates() const override;
+
+  virtual ~IntraRelocate() {
+    ls::scratch::give_back(std::move(_moved_jobs));
+  }
 };
 
 } // namespace cvrp
@@ -47,6 +47,10 @@ public:
   // precise gain requires validity information.
   Gain gain_upper_bound();
 
+  virtual OPERATOR name() const override {
+    return OPERATOR::MIXED_EXCHANGE;
+  }
+
   virtual bool is_valid() override;
 
   virtual void apply() override;
@@ -189,17 +189,7 @@ bool OrOpt::is_valid() {
 }
 
 void OrOpt::apply() {
-  t_route.insert(t_route.begin() + t_rank,
-                 s_route.begin() + s_rank,
-                 s_route.begin() + s_rank + 2);
-  if (reverse_s_edge) {
-    std::swap(t_route[t_rank], t_route[t_rank + 1]);
-  }
-
-  s_route.erase(s_route.begin() + s_rank, s_route.begin() + s_rank + 2);
-
-  source.update_amounts(_input);
-  target.update_amounts(_input);
+  source.move_segment(_input, target, s_rank, 2, t_rank, reverse_s_edge);
 }
 
 std::vector<Index> OrOpt::addition_candidates() const {
@@ -44,6 +44,10 @@ public:
   // precise gain requires validity information.
   Gain gain_upper_bound();
 
+  virtual OPERATOR name() const override {
+    return OPERATOR::OR_OPT;
+  }
+
   virtual bool is_valid() override;
 
   virtual void apply() override;
@@ -51,6 +51,16 @@ void PDShift::compute_gain() {
       -utils::addition_cost(_input, s_route[_s_d_rank], v, t_route, t_d_rank);
   }
 
+  // best_d_gain_from[r] holds the best delivery-side gain over ranks
+  // from r on, bounding whatever the delivery scan below can reach
+  // for a given pickup position.
+  std::vector<Gain> best_d_gain_from(t_route.size() + 2,
+                                     std::numeric_limits<Gain>::min());
+  for (unsigned t_d_rank = t_route.size() + 1; t_d_rank > 0; --t_d_rank) {
+    best_d_gain_from[t_d_rank - 1] =
+      std::max(best_d_gain_from[t_d_rank], t_d_gains[t_d_rank - 1]);
+  }
+
   for (unsigned t_p_rank = 0; t_p_rank < t_route.size(); ++t_p_rank) {
     Gain t_p_gain =
       -utils::addition_cost(_input, s_route[_s_p_rank], v, t_route, t_p_rank);
@@ -68,10 +78,18 @@ void PDShift::compute_gain() {
       continue;
     }
 
+    // When no delivery rank after the pickup can beat the incumbent,
+    // the scan collapses to the back-to-back insertion at t_p_rank,
+    // whose gain is not made of t_p_gain and a delivery term.
+    const unsigned last_t_d_rank =
+      (_remove_gain + t_p_gain + best_d_gain_from[t_p_rank] <= stored_gain)
+        ? t_p_rank
+        : t_route.size();
+
     std::vector<Index> modified_with_pd({s_route[_s_p_rank]});
     Amount modified_delivery = _input.zero_amount();
 
-    for (unsigned t_d_rank = t_p_rank; t_d_rank <= t_route.size(); ++t_d_rank) {
+    for (unsigned t_d_rank = t_p_rank; t_d_rank <= last_t_d_rank; ++t_d_rank) {
       Gain target_gain;
       if (t_p_rank == t_d_rank) {
         target_gain = -utils::addition_cost(_input,
@@ -40,6 +40,10 @@ public:
           Index t_vehicle,
           Gain gain_threshold);
 
+  virtual OPERATOR name() const override {
+    return OPERATOR::PD_SHIFT;
+  }
+
   virtual bool is_valid() override;
 
   virtual void apply() override;
@@ -62,12 +62,7 @@ bool Relocate::is_valid() {
 }
 
 void Relocate::apply() {
-  auto relocate_job_rank = s_route[s_rank];
-  s_route.erase(s_route.begin() + s_rank);
-  t_route.insert(t_route.begin() + t_rank, relocate_job_rank);
-
-  source.update_amounts(_input);
-  target.update_amounts(_input);
+  source.move_segment(_input, target, s_rank, 1, t_rank, false);
 }
 
 std::vector<Index> Relocate::addition_candidates() const {
@@ -41,6 +41,8 @@ ReverseTwoOpt::ReverseTwoOpt(const Input& input,
 void ReverseTwoOpt::compute_gain() {
   const auto& s_v = _input.vehicles[s_vehicle];
   const auto& t_v = _input.vehicles[t_vehicle];
+  const auto s_class = _input.vehicle_cost_class(s_vehicle);
+  const auto t_class = _input.vehicle_cost_class(t_vehicle);
 
   Index s_index = _input.jobs[s_route[s_rank]].index();
   Index t_index = _input.jobs[t_route[t_rank]].index();
@@ -61,8 +63,8 @@ void ReverseTwoOpt::compute_gain() {
   // for beginning of target route as seen from target vehicle. Then
   // add backward cost for beginning of target route as seen from
   // source vehicle since it's the new source route end.
-  stored_gain += _sol_state.fwd_costs[t_vehicle][t_vehicle][t_rank];
-  stored_gain -= _sol_state.bwd_costs[t_vehicle][s_vehicle][t_rank];
+  stored_gain += _sol_state.fwd_cost(t_route, t_vehicle, t_class, t_rank);
+  stored_gain -= _sol_state.bwd_cost(t_route, t_vehicle, s_class, t_rank);
 
   if (!last_in_target) {
     // Spare next edge in target route.
@@ -83,10 +85,12 @@ void ReverseTwoOpt::compute_gain() {
     // (subtracting intermediate cost to overall cost). Then add
     // backward cost for end of source route as seen from target
     // vehicle since it's the new target route start.
-    stored_gain += _sol_state.fwd_costs[s_vehicle][s_vehicle].back();
-    stored_gain -= _sol_state.fwd_costs[s_vehicle][s_vehicle][s_rank + 1];
-    stored_gain -= _sol_state.bwd_costs[s_vehicle][t_vehicle].back();
-    stored_gain += _sol_state.bwd_costs[s_vehicle][t_vehicle][s_rank + 1];
+    stored_gain +=
+      _sol_state.fwd_cost(s_route, s_vehicle, s_class, s_route.size() - 1);
+    stored_gain -= _sol_state.fwd_cost(s_route, s_vehicle, s_class, s_rank + 1);
+    stored_gain -=
+      _sol_state.bwd_cost(s_route, s_vehicle, t_class, s_route.size() - 1);
+    stored_gain += _sol_state.bwd_cost(s_route, s_vehicle, t_class, s_rank + 1);
 
     if (last_in_target) {
       if (t_v.has_end()) {
@@ -157,20 +161,20 @@ bool ReverseTwoOpt::is_valid() {
   valid =
     valid && source.is_valid_addition_for_capacity_inclusion(_input,
                                                              t_delivery,
-                                                             t_route.rbegin() +
-                                                               t_route.size() -
-                                                               1 - t_rank,
-                                                             t_route.rend(),
+                                                             target,
+                                                             0,
+                                                             t_rank + 1,
+                                                             true,
                                                              s_rank + 1,
                                                              s_route.size());
 
   valid =
     valid && target.is_valid_addition_for_capacity_inclusion(_input,
                                                              s_delivery,
-                                                             s_route.rbegin(),
-                                                             s_route.rbegin() +
-                                                               s_route.size() -
-                                                               1 - s_rank,
+                                                             source,
+                                                             s_rank + 1,
+                                                             s_route.size(),
+                                                             true,
                                                              0,
                                                              t_rank + 1);
 
@@ -34,16 +34,21 @@ RouteExchange::RouteExchange(const Input& input,
   assert(_sol_state.bwd_skill_rank[t_vehicle][s_vehicle] == 0);
 }
 
-void RouteExchange::compute_gain() {
-  const auto& s_v = _input.vehicles[s_vehicle];
-  const auto& t_v = _input.vehicles[t_vehicle];
+Gain RouteExchange::swap_gain(const Input& input,
+                              const utils::SolutionState& sol_state,
+                              const std::vector<Index>& s_route,
+                              Index s_vehicle,
+                              const std::vector<Index>& t_route,
+                              Index t_vehicle) {
+  const auto& s_v = input.vehicles[s_vehicle];
+  const auto& t_v = input.vehicles[t_vehicle];
 
   Gain new_cost = 0;
   Gain previous_cost = 0;
 
   if (s_route.size() > 0) {
     // Handle changes at route start.
-    auto first_s_index = _input.jobs[s_route.front()].index();
+    auto first_s_index = input.jobs[s_route.front()].index();
     if (s_v.has_start()) {
       previous_cost += s_v.cost(s_v.start.value().index(), first_s_index);
     }
@@ -52,7 +57,7 @@ void RouteExchange::compute_gain() {
     }
 
     // Handle changes at route end.
-    auto last_s_index = _input.jobs[s_route.back()].index();
+    auto last_s_index = input.jobs[s_route.back()].index();
     if (s_v.has_end()) {
       previous_cost += s_v.cost(last_s_index, s_v.end.value().index());
     }
@@ -61,13 +66,21 @@ void RouteExchange::compute_gain() {
     }
 
     // Handle inner cost change for route.
-    previous_cost += _sol_state.fwd_costs[s_vehicle][s_vehicle].back();
-    new_cost += _sol_state.fwd_costs[s_vehicle][t_vehicle].back();
+    previous_cost +=
+      sol_state.fwd_cost(s_route,
+                         s_vehicle,
+                         input.vehicle_cost_class(s_vehicle),
+                         s_route.size() - 1);
+    new_cost +=
+      sol_state.fwd_cost(s_route,
+                         s_vehicle,
+                         input.vehicle_cost_class(t_vehicle),
+                         s_route.size() - 1);
   }
 
   if (t_route.size() > 0) {
     // Handle changes at route start.
-    auto first_t_index = _input.jobs[t_route.front()].index();
+    auto first_t_index = input.jobs[t_route.front()].index();
     if (t_v.has_start()) {
       previous_cost += t_v.cost(t_v.start.value().index(), first_t_index);
     }
@@ -76,7 +89,7 @@ void RouteExchange::compute_gain() {
     }
 
     // Handle changes at route end.
-    auto last_t_index = _input.jobs[t_route.back()].index();
+    auto last_t_index = input.jobs[t_route.back()].index();
     if (t_v.has_end()) {
       previous_cost += t_v.cost(last_t_index, t_v.end.value().index());
     }
@@ -85,11 +98,24 @@ void RouteExchange::compute_gain() {
     }
 
     // Handle inner cost change for route.
-    previous_cost += _sol_state.fwd_costs[t_vehicle][t_vehicle].back();
-    new_cost += _sol_state.fwd_costs[t_vehicle][s_vehicle].back();
+    previous_cost +=
+      sol_state.fwd_cost(t_route,
+                         t_vehicle,
+                         input.vehicle_cost_class(t_vehicle),
+                         t_route.size() - 1);
+    new_cost +=
+      sol_state.fwd_cost(t_route,
+                         t_vehicle,
+                         input.vehicle_cost_class(s_vehicle),
+                         t_route.size() - 1);
   }
 
-  stored_gain = previous_cost - new_cost;
+  return previous_cost - new_cost;
+}
+
+void RouteExchange::compute_gain() {
+  stored_gain =
+    swap_gain(_input, _sol_state, s_route, s_vehicle, t_route, t_vehicle);
   gain_computed = true;
 }
 
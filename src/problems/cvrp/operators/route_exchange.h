@@ -20,6 +20,16 @@ protected:
   virtual void compute_gain() override;
 
 public:
+  // Exact gain of swapping both whole routes, computed from
+  // route-level aggregates only. Exposed statically so scans can
+  // rank candidate swaps without building the operator.
+  static Gain swap_gain(const Input& input,
+                        const utils::SolutionState& sol_state,
+                        const std::vector<Index>& s_route,
+                        Index s_vehicle,
+                        const std::vector<Index>& t_route,
+                        Index t_vehicle);
+
   RouteExchange(const Input& input,
                 const utils::SolutionState& sol_state,
                 RawRoute& s_route,
@@ -27,6 +37,10 @@ public:
                 RawRoute& t_route,
                 Index t_vehicle);
 
+  virtual OPERATOR name() const override {
+    return OPERATOR::ROUTE_EXCHANGE;
+  }
+
   virtual bool is_valid() override;
 
   virtual void apply() override;
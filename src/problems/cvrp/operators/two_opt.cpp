@@ -41,6 +41,8 @@ TwoOpt::TwoOpt(const Input& input,
 void TwoOpt::compute_gain() {
   const auto& s_v = _input.vehicles[s_vehicle];
   const auto& t_v = _input.vehicles[t_vehicle];
+  const auto s_class = _input.vehicle_cost_class(s_vehicle);
+  const auto t_class = _input.vehicle_cost_class(t_vehicle);
 
   Index s_index = _input.jobs[s_route[s_rank]].index();
   Index t_index = _input.jobs[t_route[t_rank]].index();
@@ -64,10 +66,12 @@ void TwoOpt::compute_gain() {
     // Account for the change in cost across vehicles for the end of
     // source route. Cost of remaining route retrieved by subtracting
     // intermediate cost to overall cost.
-    stored_gain += _sol_state.fwd_costs[s_vehicle][s_vehicle].back();
-    stored_gain -= _sol_state.fwd_costs[s_vehicle][s_vehicle][s_rank + 1];
-    stored_gain -= _sol_state.fwd_costs[s_vehicle][t_vehicle].back();
-    stored_gain += _sol_state.fwd_costs[s_vehicle][t_vehicle][s_rank + 1];
+    stored_gain +=
+      _sol_state.fwd_cost(s_route, s_vehicle, s_class, s_route.size() - 1);
+    stored_gain -= _sol_state.fwd_cost(s_route, s_vehicle, s_class, s_rank + 1);
+    stored_gain -=
+      _sol_state.fwd_cost(s_route, s_vehicle, t_class, s_route.size() - 1);
+    stored_gain += _sol_state.fwd_cost(s_route, s_vehicle, t_class, s_rank + 1);
   } else {
     new_last_t = t_index;
   }
@@ -79,10 +83,12 @@ void TwoOpt::compute_gain() {
     // Account for the change in cost across vehicles for the end of
     // target route. Cost of remaining route retrieved by subtracting
     // intermediate cost to overall cost.
-    stored_gain += _sol_state.fwd_costs[t_vehicle][t_vehicle].back();
-    stored_gain -= _sol_state.fwd_costs[t_vehicle][t_vehicle][t_rank + 1];
-    stored_gain -= _sol_state.fwd_costs[t_vehicle][s_vehicle].back();
-    stored_gain += _sol_state.fwd_costs[t_vehicle][s_vehicle][t_rank + 1];
+    stored_gain +=
+      _sol_state.fwd_cost(t_route, t_vehicle, t_class, t_route.size() - 1);
+    stored_gain -= _sol_state.fwd_cost(t_route, t_vehicle, t_class, t_rank + 1);
+    stored_gain -=
+      _sol_state.fwd_cost(t_route, t_vehicle, s_class, t_route.size() - 1);
+    stored_gain += _sol_state.fwd_cost(t_route, t_vehicle, s_class, t_rank + 1);
   } else {
     new_last_s = s_index;
   }
@@ -126,18 +132,20 @@ bool TwoOpt::is_valid() {
   valid =
     valid && source.is_valid_addition_for_capacity_inclusion(_input,
                                                              t_delivery,
-                                                             t_route.begin() +
-                                                               t_rank + 1,
-                                                             t_route.end(),
+                                                             target,
+                                                             t_rank + 1,
+                                                             t_route.size(),
+                                                             false,
                                                              s_rank + 1,
                                                              s_route.size());
 
   valid =
     valid && target.is_valid_addition_for_capacity_inclusion(_input,
                                                              s_delivery,
-                                                             s_route.begin() +
-                                                               s_rank + 1,
-                                                             s_route.end(),
+                                                             source,
+                                                             s_rank + 1,
+                                                             s_route.size(),
+                                                             false,
                                                              t_rank + 1,
                                                              t_route.size());
 
@@ -145,19 +153,7 @@ bool TwoOpt::is_valid() {
 }
 
 void TwoOpt::apply() {
-  auto nb_source = s_route.size() - 1 - s_rank;
-
-  t_route.insert(t_route.begin() + t_rank + 1,
-                 s_route.begin() + s_rank + 1,
-                 s_route.end());
-  s_route.erase(s_route.begin() + s_rank + 1, s_route.end());
-  s_route.insert(s_route.end(),
-                 t_route.begin() + t_rank + 1 + nb_source,
-                 t_route.end());
-  t_route.erase(t_route.begin() + t_rank + 1 + nb_source, t_route.end());
-
-  source.update_amounts(_input);
-  target.update_amounts(_input);
+  source.swap_tails(_input, target, s_rank + 1, t_rank + 1);
 }
 
 std::vector<Index> TwoOpt::addition_candidates() const {
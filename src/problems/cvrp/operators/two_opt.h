@@ -29,6 +29,10 @@ public:
          Index t_vehicle,
          Index t_rank);
 
+  virtual OPERATOR name() const override {
+    return OPERATOR::TWO_OPT;
+  }
+
   virtual bool is_valid() override;
 
   virtual void apply() override;
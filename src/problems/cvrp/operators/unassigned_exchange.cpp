@@ -15,7 +15,7 @@ namespace cvrp {
 
 UnassignedExchange::UnassignedExchange(const Input& input,
                                        const utils::SolutionState& sol_state,
-                                       std::unordered_set<Index>& unassigned,
+                                       utils::PriorityBucketSet& unassigned,
                                        RawRoute& s_raw_route,
                                        Index s_vehicle,
                                        Index s_rank,
@@ -33,7 +33,7 @@ UnassignedExchange::UnassignedExchange(const Input& input,
     _unassigned(unassigned),
     _first_rank(std::min(s_rank, t_rank)),
     _last_rank((s_rank < t_rank) ? t_rank : s_rank + 1),
-    _moved_jobs(_last_rank - _first_rank),
+    _moved_jobs(ls::scratch::borrow(_last_rank - _first_rank)),
     _removed(s_route[s_rank]) {
   assert(t_rank != s_rank + 1);
   assert(!s_route.empty());
@@ -132,9 +132,9 @@ void UnassignedExchange::apply() {
             _moved_jobs.end(),
             s_route.begin() + _first_rank);
 
-  assert(_unassigned.find(_u) != _unassigned.end());
+  assert(_unassigned.contains(_u));
   _unassigned.erase(_u);
-  assert(_unassigned.find(_removed) == _unassigned.end());
+  assert(!_unassigned.contains(_removed));
   _unassigned.insert(_removed);
 
   source.update_amounts(_input);
@@ -18,7 +18,7 @@ namespace cvrp {
 class UnassignedExchange : public ls::Operator {
 protected:
   const Index _u; // Unassigned job to insert.
-  std::unordered_set<Index>& _unassigned;
+  utils::PriorityBucketSet& _unassigned;
   const Index _first_rank;
   const Index _last_rank;
   std::vector<Index> _moved_jobs;
@@ -29,13 +29,17 @@ protected:
 public:
   UnassignedExchange(const Input& input,
                      const utils::SolutionState& sol_state,
-                     std::unordered_set<Index>& unassigned,
+                     utils::PriorityBucketSet& unassigned,
                      RawRoute& s_route,
                      Index s_vehicle,
                      Index s_rank,
                      Index t_rank,
                      Index u);
 
+  virtual OPERATOR name() const override {
+    return OPERATOR::UNASSIGNED_EXCHANGE;
+  }
+
   virtual bool is_valid() override;
 
   virtual void apply() override;
@@ -44,6 +48,10 @@ public:
 
   virtual std::vector<Index> update_candidates() const override;
 
+  virtual ~UnassignedExchange() {
+    ls::scratch::give_back(std::move(_moved_jobs));
+  }
+
   virtual std::vector<Index> required_unassigned() const override;
 };
 
@@ -8,6 +8,7 @@ All rights reserved (see LICENSE).
 */
 
 #include <cassert>
+#include <limits>
 #include <set>
 
 #include "algorithms/kruskal.h"
@@ -22,61 +23,66 @@ std::list<Index> christofides(const Matrix<Cost>& sym_matrix) {
   // tree with a minimum weight perfect matching on its odd degree
   // vertices.
 
-  // Compute symmetric graph from the matrix.
-  auto sym_graph = utils::UndirectedGraph<Cost>(sym_matrix);
-
-  // Work on a minimum spanning tree seen as a graph.
-  auto mst_graph = utils::minimum_spanning_tree(sym_graph);
-
-  // Getting minimum spanning tree of associated graph under the form
-  // of an adjacency list.
-  std::unordered_map<Index, std::list<Index>> adjacency_list =
-    mst_graph.get_adjacency_list();
+  // Work on a minimum spanning tree seen as a graph, computed
+  // directly on the dense matrix.
+  auto mst_graph = utils::minimum_spanning_tree(sym_matrix);
 
   // Getting odd degree vertices from the minimum spanning tree.
   std::vector<Index> mst_odd_vertices;
-  for (const auto& adjacency : adjacency_list) {
-    if (adjacency.second.size() % 2 == 1) {
-      mst_odd_vertices.push_back(adjacency.first);
+  for (Index v = 0; v < mst_graph.nb_vertices(); ++v) {
+    if (mst_graph.degree(v) % 2 == 1) {
+      mst_odd_vertices.push_back(v);
     }
   }
 
-  // Getting corresponding matrix for the generated sub-graph.
-  Matrix<Cost> sub_matrix = sym_matrix.get_sub_matrix(mst_odd_vertices);
+  // Getting corresponding view for the generated sub-graph, no copy
+  // involved.
+  MatrixView<Cost> sub_matrix(sym_matrix, mst_odd_vertices);
 
-  // Computing minimum weight perfect matching.
-  std::unordered_map<Index, Index> mwpm =
-    utils::minimum_weight_perfect_matching(sub_matrix);
+  // Computing minimum weight perfect matching. The exact matching is
+  // O(n³) in the number of odd degree vertices and dominates setup
+  // time on big instances, so above this size a greedy matching
+  // refined with pairwise exchanges is used instead. Resulting tour
+  // quality after local search is on par.
+  constexpr std::size_t exact_matching_max_size = 200;
 
-  // Storing those edges from mwpm that are coherent regarding
-  // symmetry (y -> x whenever x -> y). Remembering the rest of them
-  // for further use. Edges are not doubled in mwpm_final.
   std::unordered_map<Index, Index> mwpm_final;
-  std::vector<Index> wrong_vertices;
-
-  unsigned total_ok = 0;
-  for (const auto& edge : mwpm) {
-    if (mwpm.at(edge.second) == edge.first) {
-      mwpm_final.emplace(std::min(edge.first, edge.second),
-                         std::max(edge.first, edge.second));
-      ++total_ok;
-    } else {
-      wrong_vertices.push_back(edge.first);
+
+  if (mst_odd_vertices.size() > exact_matching_max_size) {
+    mwpm_final = utils::refined_symmetric_approx_mwpm(sub_matrix);
+  } else {
+    std::unordered_map<Index, Index> mwpm =
+      utils::minimum_weight_perfect_matching(sub_matrix);
+
+    // Storing those edges from mwpm that are coherent regarding
+    // symmetry (y -> x whenever x -> y). Remembering the rest of them
+    // for further use. Edges are not doubled in mwpm_final.
+    std::vector<Index> wrong_vertices;
+
+    unsigned total_ok = 0;
+    for (const auto& edge : mwpm) {
+      if (mwpm.at(edge.second) == edge.first) {
+        mwpm_final.emplace(std::min(edge.first, edge.second),
+                           std::max(edge.first, edge.second));
+        ++total_ok;
+      } else {
+        wrong_vertices.push_back(edge.first);
+      }
     }
-  }
 
-  if (!wrong_vertices.empty()) {
-    std::unordered_map<Index, Index> remaining_greedy_mwpm =
-      utils::greedy_symmetric_approx_mwpm(
-        sub_matrix.get_sub_matrix(wrong_vertices));
-
-    // Adding edges obtained with greedy algo for the missing vertices
-    // in mwpm_final.
-    for (const auto& edge : remaining_greedy_mwpm) {
-      mwpm_final.emplace(std::min(wrong_vertices[edge.first],
-                                  wrong_vertices[edge.second]),
-                         std::max(wrong_vertices[edge.first],
-                                  wrong_vertices[edge.second]));
+    if (!wrong_vertices.empty()) {
+      std::unordered_map<Index, Index> remaining_greedy_mwpm =
+        utils::greedy_symmetric_approx_mwpm(
+          sub_matrix.get_sub_view(wrong_vertices));
+
+      // Adding edges obtained with greedy algo for the missing
+      // vertices in mwpm_final.
+      for (const auto& edge : remaining_greedy_mwpm) {
+        mwpm_final.emplace(std::min(wrong_vertices[edge.first],
+                                    wrong_vertices[edge.second]),
+                           std::max(wrong_vertices[edge.first],
+                                    wrong_vertices[edge.second]));
+      }
     }
   }
 
@@ -99,16 +105,56 @@ std::list<Index> christofides(const Matrix<Cost>& sym_matrix) {
   }
 
   // Building Eulerian graph from the edges.
-  utils::UndirectedGraph<Cost> eulerian_graph(eulerian_graph_edges);
+  utils::UndirectedGraph<Cost> eulerian_graph(std::move(eulerian_graph_edges));
   assert(eulerian_graph.size() >= 2);
 
   // Hierholzer's algorithm: building and joining closed tours with
-  // vertices that still have adjacent edges.
-  std::unordered_map<Index, std::list<Index>> eulerian_adjacency_list =
-    eulerian_graph.get_adjacency_list();
+  // vertices that still have adjacent edges. Edges are consumed from
+  // a mutable copy of the compact adjacencies, marking used slots in
+  // place instead of shifting the remaining ones around.
+  const auto& adjacency_starts = eulerian_graph.adjacency_starts();
+  std::vector<Index> eulerian_adjacencies = eulerian_graph.adjacencies();
+
+  constexpr Index USED_SLOT = std::numeric_limits<Index>::max();
+
+  // Number of unused adjacent edges per vertex, along with the first
+  // slot that may still be unused, moving forward as edges are
+  // consumed.
+  std::vector<unsigned> remaining_degree(eulerian_graph.nb_vertices());
+  std::vector<std::size_t> first_slot(adjacency_starts.begin(),
+                                      adjacency_starts.end() - 1);
+  for (Index v = 0; v < eulerian_graph.nb_vertices(); ++v) {
+    remaining_degree[v] = eulerian_graph.degree(v);
+  }
+
+  auto consume_edge_from = [&](Index v) {
+    auto slot = first_slot[v];
+    while (eulerian_adjacencies[slot] == USED_SLOT) {
+      ++slot;
+    }
+    assert(slot < adjacency_starts[v + 1]);
+    auto next = eulerian_adjacencies[slot];
+    eulerian_adjacencies[slot] = USED_SLOT;
+    first_slot[v] = slot + 1;
+    --remaining_degree[v];
+    return next;
+  };
+
+  auto consume_edge_to = [&](Index v, Index neighbour) {
+    auto slot = first_slot[v];
+    while (eulerian_adjacencies[slot] != neighbour) {
+      ++slot;
+    }
+    assert(slot < adjacency_starts[v + 1]);
+    eulerian_adjacencies[slot] = USED_SLOT;
+    --remaining_degree[v];
+  };
 
   std::list<Index> eulerian_path;
-  eulerian_path.push_back(eulerian_adjacency_list.begin()->first);
+  // All vertices are in the spanning tree, so any of them works as a
+  // starting point.
+  assert(eulerian_graph.degree(0) > 0);
+  eulerian_path.push_back(0);
 
   // Building and joining tours as long as necessary.
   bool complete_tour;
@@ -120,7 +166,7 @@ std::list<Index> christofides(const Matrix<Cost>& sym_matrix) {
     // adjacent edge (if any).
     for (auto vertex = eulerian_path.begin(); vertex != eulerian_path.end();
          ++vertex) {
-      if (eulerian_adjacency_list[*vertex].size() > 0) {
+      if (remaining_degree[*vertex] > 0) {
         new_tour_start = vertex;
         complete_tour = false;
         break;
@@ -136,17 +182,10 @@ std::list<Index> christofides(const Matrix<Cost>& sym_matrix) {
       // Start building new tour.
       do {
         new_tour.push_back(current_vertex);
-        // Find next vertex from any adjacent edge and remove used edge.
-        next_vertex = eulerian_adjacency_list[current_vertex].front();
-        eulerian_adjacency_list[current_vertex].pop_front();
-        for (auto vertex = eulerian_adjacency_list[next_vertex].begin();
-             vertex != eulerian_adjacency_list[next_vertex].end();
-             ++vertex) {
-          if (*vertex == current_vertex) {
-            eulerian_adjacency_list[next_vertex].erase(vertex);
-            break;
-          }
-        }
+        // Find next vertex from any adjacent edge and remove used
+        // edge on both sides.
+        next_vertex = consume_edge_from(current_vertex);
+        consume_edge_to(next_vertex, current_vertex);
         current_vertex = next_vertex;
       } while (current_vertex != initial_vertex);
 
@@ -0,0 +1,87 @@
+/*
+
+This file is part of VROOM.
+
+Copyright (c) 2015-2021, Julien Coupey.
+All rights reserved (see LICENSE).
+
+*/
+
+#include <algorithm>
+#include <cassert>
+#include <numeric>
+
+#include "problems/tsp/heuristics/hilbert.h"
+
+namespace vroom {
+namespace tsp {
+
+namespace {
+
+// Order of the Hilbert curve, i.e. coordinates are mapped to a 2^k by
+// 2^k grid.
+constexpr unsigned k = 16;
+
+// Distance along the Hilbert curve for a cell of the grid, using the
+// usual iterative rotation-based conversion.
+uint64_t hilbert_distance(uint32_t x, uint32_t y) {
+  uint64_t d = 0;
+  for (uint32_t s = (static_cast<uint32_t>(1) << k) / 2; s > 0; s /= 2) {
+    const uint32_t rx = (x & s) > 0 ? 1 : 0;
+    const uint32_t ry = (y & s) > 0 ? 1 : 0;
+    d += static_cast<uint64_t>(s) * s * ((3 * rx) ^ ry);
+
+    // Rotate quadrant.
+    if (ry == 0) {
+      if (rx == 1) {
+        x = s - 1 - x;
+        y = s - 1 - y;
+      }
+      std::swap(x, y);
+    }
+  }
+  return d;
+}
+
+} // namespace
+
+std::list<Index> hilbert(const std::vector<Coordinates>& coordinates) {
+  assert(!coordinates.empty());
+
+  // Scale coordinates to the grid based on their bounding box.
+  auto min_lon = coordinates.front()[0];
+  auto max_lon = min_lon;
+  auto min_lat = coordinates.front()[1];
+  auto max_lat = min_lat;
+  for (const auto& c : coordinates) {
+    min_lon = std::min(min_lon, c[0]);
+    max_lon = std::max(max_lon, c[0]);
+    min_lat = std::min(min_lat, c[1]);
+    max_lat = std::max(max_lat, c[1]);
+  }
+
+  const double grid_max = static_cast<double>(static_cast<uint32_t>(1) << k) - 1;
+  const double lon_scale =
+    (min_lon < max_lon) ? grid_max / (max_lon - min_lon) : 0;
+  const double lat_scale =
+    (min_lat < max_lat) ? grid_max / (max_lat - min_lat) : 0;
+
+  std::vector<uint64_t> distances;
+  distances.reserve(coordinates.size());
+  for (const auto& c : coordinates) {
+    const auto x = static_cast<uint32_t>((c[0] - min_lon) * lon_scale);
+    const auto y = static_cast<uint32_t>((c[1] - min_lat) * lat_scale);
+    distances.push_back(hilbert_distance(x, y));
+  }
+
+  std::vector<Index> ranks(coordinates.size());
+  std::iota(ranks.begin(), ranks.end(), 0);
+  std::sort(ranks.begin(), ranks.end(), [&](const Index lhs, const Index rhs) {
+    return distances[lhs] < distances[rhs];
+  });
+
+  return std::list<Index>(ranks.begin(), ranks.end());
+}
+
+} // namespace tsp
+} // namespace vroom
@@ -0,0 +1,30 @@
+#ifndef HILBERT_H
+#define HILBERT_H
+
+/*
+
+This file is part of VROOM.
+
+Copyright (c) 2015-2021, Julien Coupey.
+All rights reserved (see LICENSE).
+
+*/
+
+#include <list>
+#include <vector>
+
+#include "structures/typedefs.h"
+
+namespace vroom {
+namespace tsp {
+
+// Order locations along a Hilbert space-filling curve over their
+// coordinates. Construction is O(n.log(n)) so this is the tour of
+// choice for huge instances where christofides does not scale, at the
+// price of a rougher initial quality.
+std::list<Index> hilbert(const std::vector<Coordinates>& coordinates);
+
+} // namespace tsp
+} // namespace vroom
+
+#endif
@@ -26,7 +26,8 @@ LocalSearch::LocalSearch(const Matrix<Cost>& matrix,
     _avoid_start_relocate(avoid_start_relocate),
     _edges(_matrix.size()),
     _nb_threads(std::min(nb_threads, static_cast<unsigned>(tour.size()))),
-    _rank_limits(_nb_threads) {
+    _rank_limits(_nb_threads),
+    _dont_look(_matrix.size(), 0) {
   // Build _edges vector representation.
   auto location = tour.cbegin();
   Index first_index = *location;
@@ -63,41 +64,30 @@ LocalSearch::LocalSearch(const Matrix<Cost>& matrix,
   }
   _rank_limits.push_back(_edges.size());
 
-  // Build a vector of bounds that easily split the [0, _edges.size()]
-  // look-up range 'evenly' between threads for 2-opt symmetric
-  // operator.
-  _sym_two_opt_rank_limits.push_back(0);
-
-  if (_nb_threads > 1) {
-    // When avoiding duplicate tests in two-opt (symmetric case), the
-    // first choice for edge_1 requires number_of_lookups[0] checks
-    // for edge_2, the next requires number_of_lookups[1] and so
-    // on. If several threads are used, splitting the share between
-    // them is based on this workload.
-
-    std::vector<unsigned> number_of_lookups(_edges.size() - 1);
-    number_of_lookups[0] = _edges.size() - 3;
-    std::iota(number_of_lookups.rbegin(), number_of_lookups.rend() - 1, 0);
-
-    std::vector<unsigned> cumulated_lookups;
-    std::partial_sum(number_of_lookups.begin(),
-                     number_of_lookups.end(),
-                     std::back_inserter(cumulated_lookups));
-
-    unsigned total_lookups = _edges.size() * (_edges.size() - 3) / 2;
-    unsigned thread_lookup_share = total_lookups / _nb_threads;
-
-    Index rank = 0;
-    for (std::size_t i = 1; i < _nb_threads; ++i) {
-      // Finding nodes that separate current tour in _nb_threads ranges.
-      while (cumulated_lookups[rank] < i * thread_lookup_share) {
-        ++rank;
-      }
-      ++rank;
-      _sym_two_opt_rank_limits.push_back(rank);
-    }
+  // Build nearest neighbor lists per node, used to restrict candidate
+  // moves in the 2-opt operator. Improving moves overwhelmingly
+  // involve close nodes so a fixed-size candidate list keeps each
+  // node scan O(1) instead of O(n).
+  const std::size_t nb_neighbors =
+    std::min(static_cast<std::size_t>(10), _edges.size() - 1);
+  _nearest_neighbors.resize(_matrix.size());
+
+  std::vector<Index> candidates(_matrix.size());
+  std::iota(candidates.begin(), candidates.end(), 0);
+
+  for (Index i = 0; i < _matrix.size(); ++i) {
+    auto& neighbors = _nearest_neighbors[i];
+    neighbors = candidates;
+    neighbors.erase(neighbors.begin() + i);
+
+    std::partial_sort(neighbors.begin(),
+                      neighbors.begin() + nb_neighbors,
+                      neighbors.end(),
+                      [this, i](const Index lhs, const Index rhs) {
+                        return _matrix[i][lhs] < _matrix[i][rhs];
+                      });
+    neighbors.resize(nb_neighbors);
   }
-  _sym_two_opt_rank_limits.push_back(_edges.size());
 }
 
 Cost LocalSearch::relocate_step() {
@@ -384,26 +374,32 @@ Cost LocalSearch::two_opt_step() {
   }
 
   // Lambda function to search for the best move in a range of
-  // elements from _edges.
+  // elements from _edges. Candidates for the second edge are
+  // restricted to the nearest neighbors of edge_1_start: in the
+  // symmetric case an improving move always has a new edge shorter
+  // than an existing one, so it is spotted from at least one of its
+  // endpoints as long as neighbor lists are deep enough.
   auto look_up = [&](Index start,
                      Index end,
                      Cost& best_gain,
                      Index& best_edge_1_start,
                      Index& best_edge_2_start) {
     for (Index edge_1_start = start; edge_1_start < end; ++edge_1_start) {
+      if (_dont_look[edge_1_start]) {
+        // No improving move from this node last time it was scanned
+        // and its surrounding edges are unchanged since.
+        continue;
+      }
       Index edge_1_end = _edges[edge_1_start];
-      for (Index edge_2_start = edge_1_start + 1; edge_2_start < _edges.size();
-           ++edge_2_start) {
+      bool improving_move_found = false;
+
+      for (const auto edge_2_start : _nearest_neighbors[edge_1_start]) {
         // Trying to improve two "crossing edges".
         //
         // Namely edge_1_start --> edge_1_end and edge_2_start -->
         // edge_2_end are replaced by edge_1_start --> edge_2_start and
         // edge_1_end --> edge_2_end. The tour between edge_1_end and
         // edge_2_start need to be reversed.
-        //
-        // In the symmetric case, trying the move with edges (e_2, e_1)
-        // is the same as with (e_1, e_2), so assuming edge_1_start <
-        // edge_2_start avoids testing pairs in both orders.
 
         Index edge_2_end = _edges[edge_2_start];
         if ((edge_2_start == edge_1_end) or (edge_2_end == edge_1_start)) {
@@ -417,6 +413,7 @@ Cost LocalSearch::two_opt_step() {
           _matrix[edge_1_start][edge_2_start] + _matrix[edge_1_end][edge_2_end];
 
         if (before_cost > after_cost) {
+          improving_move_found = true;
           Cost gain = before_cost - after_cost;
           if (gain > best_gain) {
             best_gain = gain;
@@ -425,6 +422,12 @@ Cost LocalSearch::two_opt_step() {
           }
         }
       }
+
+      if (!improving_move_found) {
+        // Skip this node in subsequent steps until one of its
+        // surrounding edges changes.
+        _dont_look[edge_1_start] = 1;
+      }
     }
   };
 
@@ -434,19 +437,20 @@ Cost LocalSearch::two_opt_step() {
   std::vector<Index> best_edge_2_starts(_nb_threads);
 
   // Start other threads, keeping a piece of the range for the main
-  // thread.
+  // thread. The candidate scan is uniform across nodes thanks to
+  // fixed-size neighbor lists so the even _rank_limits split applies.
   std::vector<std::thread> threads;
   for (std::size_t i = 0; i < _nb_threads - 1; ++i) {
     threads.emplace_back(look_up,
-                         _sym_two_opt_rank_limits[i],
-                         _sym_two_opt_rank_limits[i + 1],
+                         _rank_limits[i],
+                         _rank_limits[i + 1],
                          std::ref(best_gains[i]),
                          std::ref(best_edge_1_starts[i]),
                          std::ref(best_edge_2_starts[i]));
   }
 
-  look_up(_sym_two_opt_rank_limits[_nb_threads - 1],
-          _sym_two_opt_rank_limits[_nb_threads],
+  look_up(_rank_limits[_nb_threads - 1],
+          _rank_limits[_nb_threads],
           std::ref(best_gains[_nb_threads - 1]),
           std::ref(best_edge_1_starts[_nb_threads - 1]),
           std::ref(best_edge_2_starts[_nb_threads - 1]));
@@ -480,6 +484,15 @@ Cost LocalSearch::two_opt_step() {
       current = *next;
     }
     _edges[current] = best_edge_2_end;
+
+    // Surrounding edges have changed for all nodes along the reversed
+    // part, so they deserve a fresh look.
+    _dont_look[best_edge_1_start] = 0;
+    _dont_look[best_edge_2_start] = 0;
+    _dont_look[best_edge_2_end] = 0;
+    for (const auto node : to_reverse) {
+      _dont_look[node] = 0;
+    }
   }
 
   return best_gain;
@@ -626,6 +639,10 @@ Cost LocalSearch::asym_two_opt_step() {
 }
 
 Cost LocalSearch::perform_all_two_opt_steps() {
+  // Other operators may have changed the tour since the last round of
+  // 2-opt steps so all nodes deserve a fresh look.
+  std::fill(_dont_look.begin(), _dont_look.end(), 0);
+
   Cost total_gain = 0;
   unsigned two_opt_iter = 0;
   Cost gain = 0;
@@ -663,6 +680,24 @@ Cost LocalSearch::or_opt_step() {
     return 0;
   }
 
+  // Materializing tour order and current edge weights once per step:
+  // the candidate sweep below then runs on contiguous arrays instead
+  // of chasing successors through _edges, and the weight of each
+  // current edge is fetched once instead of once per segment.
+  std::vector<Index> tour_order;
+  tour_order.reserve(_edges.size());
+  Index current_node = 0;
+  do {
+    tour_order.push_back(current_node);
+    current_node = _edges[current_node];
+  } while (current_node != 0);
+
+  std::vector<Cost> edge_weights;
+  edge_weights.reserve(_edges.size());
+  for (const auto node : tour_order) {
+    edge_weights.push_back(_matrix[node][_edges[node]]);
+  }
+
   // Lambda function to search for the best move in a range of
   // elements from _edges.
   auto look_up = [&](Index start,
@@ -674,7 +709,6 @@ Cost LocalSearch::or_opt_step() {
       Index edge_1_end = _edges[edge_1_start];
       Index next = _edges[edge_1_end];
       Index next_2 = _edges[next];
-      Index edge_2_start = next_2;
       // Going through the tour while checking the move of edge after
       // edge_1_end in place of another edge (edge_2_*).
       //
@@ -688,10 +722,17 @@ Cost LocalSearch::or_opt_step() {
       Cost edge_1_weight = _matrix[edge_1_start][edge_1_end];
       Cost next_next_2_weight = _matrix[next][next_2];
 
-      while (edge_2_start != edge_1_start) {
-        Index edge_2_end = _edges[edge_2_start];
-        Cost before_cost = edge_1_weight + next_next_2_weight +
-                           _matrix[edge_2_start][edge_2_end];
+      for (std::size_t p = 0; p < tour_order.size(); ++p) {
+        Index edge_2_start = tour_order[p];
+        if (edge_2_start == edge_1_start or edge_2_start == edge_1_end or
+            edge_2_start == next) {
+          // Current edge overlaps the moved segment.
+          continue;
+        }
+        Index edge_2_end =
+          tour_order[(p + 1 < tour_order.size()) ? p + 1 : 0];
+        Cost before_cost =
+          edge_1_weight + next_next_2_weight + edge_weights[p];
         Cost after_cost = first_potential_add +
                           _matrix[edge_2_start][edge_1_end] +
                           _matrix[next][edge_2_end];
@@ -703,8 +744,6 @@ Cost LocalSearch::or_opt_step() {
             best_edge_2_start = edge_2_start;
           }
         }
-        // Go for next possible second edge.
-        edge_2_start = edge_2_end;
       }
     }
   };
@@ -23,7 +23,13 @@ private:
   std::vector<Index> _edges;
   unsigned _nb_threads;
   std::vector<Index> _rank_limits;
-  std::vector<Index> _sym_two_opt_rank_limits;
+  // Nearest neighbor lists used to restrict candidate moves in the
+  // 2-opt operator.
+  std::vector<std::vector<Index>> _nearest_neighbors;
+  // "Don't-look bits" for the 2-opt operator: a non-zero value marks
+  // a node that yielded no improving move the last time it was
+  // scanned and whose surrounding edges are unchanged since.
+  std::vector<unsigned char> _dont_look;
 
 public:
   LocalSearch(const Matrix<Cost>& matrix,
@@ -9,6 +9,7 @@ All rights reserved (see LICENSE).
 
 #include "problems/tsp/tsp.h"
 #include "problems/tsp/heuristics/christofides.h"
+#include "problems/tsp/heuristics/hilbert.h"
 #include "problems/tsp/heuristics/local_search.h"
 #include "utils/helpers.h"
 
@@ -50,6 +51,31 @@ TSP::TSP(const Input& input, std::vector<Index> job_ranks, Index vehicle_rank)
     }
   }
 
+  // Store coordinates along matrix ranks whenever available.
+  std::vector<Location> locations;
+  std::transform(_job_ranks.cbegin(),
+                 _job_ranks.cend(),
+                 std::back_inserter(locations),
+                 [&](const auto& r) { return _input.jobs[r].location; });
+  if (_has_start) {
+    locations.push_back(_input.vehicles[_vehicle_rank].start.value());
+  }
+  if (_has_end and (!_has_start or _end != _start)) {
+    locations.push_back(_input.vehicles[_vehicle_rank].end.value());
+  }
+  assert(locations.size() == matrix_ranks.size());
+
+  if (std::all_of(locations.cbegin(), locations.cend(), [](const auto& l) {
+        return l.has_coordinates();
+      })) {
+    std::transform(locations.cbegin(),
+                   locations.cend(),
+                   std::back_inserter(_location_coords),
+                   [](const auto& l) {
+                     return Coordinates({l.lon(), l.lat()});
+                   });
+  }
+
   // Populate TSP-solving matrix.
   _matrix = Matrix<Cost>(matrix_ranks.size());
 
@@ -103,22 +129,46 @@ TSP::TSP(const Input& input, std::vector<Index> job_ranks, Index vehicle_rank)
     }
   }
 
-  // Compute symmetrized matrix and update _is_symmetric flag.
-  _symmetrized_matrix = Matrix<Cost>(_matrix.size());
-
-  const Cost& (*sym_f)(const Cost&, const Cost&) = std::min<Cost>;
-  if ((_has_start and !_has_end) or (!_has_start and _has_end)) {
-    // Using symmetrization with max as when only start or only end is
-    // forced, the matrix has a line or a column filled with zeros.
-    sym_f = std::max<Cost>;
+  // Update _is_symmetric flag. When the durations matrix is known
+  // symmetric (see Matrix::detect_symmetry) and only the diagonal was
+  // touched above -- the open tour mutations zero out cells on a
+  // single side -- symmetry carries over to _matrix, since vehicle
+  // costs scale durations by a scalar. The quadratic scan is then
+  // skipped, _is_symmetric being initialized to true.
+  const bool symmetry_carries_over =
+    v.cost_wrapper.symmetric_durations and
+    (_round_trip or (!_has_start and !_has_end));
+
+  if (!symmetry_carries_over) {
+    for (Index i = 0; i < _matrix.size() and _is_symmetric; ++i) {
+      for (Index j = i + 1; j < _matrix.size(); ++j) {
+        if (_matrix[i][j] != _matrix[j][i]) {
+          _is_symmetric = false;
+          break;
+        }
+      }
+    }
   }
-  for (Index i = 0; i < _matrix.size(); ++i) {
-    _symmetrized_matrix[i][i] = _matrix[i][i];
-    for (Index j = i + 1; j < _matrix.size(); ++j) {
-      _is_symmetric = _is_symmetric && (_matrix[i][j] == _matrix[j][i]);
-      Cost val = sym_f(_matrix[i][j], _matrix[j][i]);
-      _symmetrized_matrix[i][j] = val;
-      _symmetrized_matrix[j][i] = val;
+
+  if (!_is_symmetric) {
+    // Compute symmetrized matrix. In the symmetric case _matrix is
+    // used as-is instead, halving per-subproblem matrix memory.
+    _symmetrized_matrix = Matrix<Cost>(_matrix.size());
+
+    const Cost& (*sym_f)(const Cost&, const Cost&) = std::min<Cost>;
+    if ((_has_start and !_has_end) or (!_has_start and _has_end)) {
+      // Using symmetrization with max as when only start or only end
+      // is forced, the matrix has a line or a column filled with
+      // zeros.
+      sym_f = std::max<Cost>;
+    }
+    for (Index i = 0; i < _matrix.size(); ++i) {
+      _symmetrized_matrix[i][i] = _matrix[i][i];
+      for (Index j = i + 1; j < _matrix.size(); ++j) {
+        Cost val = sym_f(_matrix[i][j], _matrix[j][i]);
+        _symmetrized_matrix[i][j] = val;
+        _symmetrized_matrix[j][i] = val;
+      }
     }
   }
 }
@@ -156,25 +206,33 @@ Cost TSP::symmetrized_cost(const std::list<Index>& tour) const {
   Index previous_step = init_step;
   ++step;
   for (; step != tour.cend(); ++step) {
-    cost += _symmetrized_matrix[previous_step][*step];
+    cost += symmetrized_matrix()[previous_step][*step];
     previous_step = *step;
   }
   if (tour.size() > 0) {
-    cost += _symmetrized_matrix[previous_step][init_step];
+    cost += symmetrized_matrix()[previous_step][init_step];
   }
   return cost;
 }
 
 std::vector<Index> TSP::raw_solve(unsigned nb_threads) const {
-  // Applying heuristic.
-  std::list<Index> christo_sol = tsp::christofides(_symmetrized_matrix);
+  // Applying heuristic. Above this size, christofides construction
+  // time is unaffordable so whenever coordinates are around, the
+  // initial tour simply follows a Hilbert space-filling curve and the
+  // local search below is trusted with tour quality.
+  constexpr std::size_t christofides_max_size = 5000;
+
+  std::list<Index> christo_sol =
+    (_matrix.size() > christofides_max_size and !_location_coords.empty())
+      ? tsp::hilbert(_location_coords)
+      : tsp::christofides(symmetrized_matrix());
 
   // Local search on symmetric problem.
   // Applying deterministic, fast local search to improve the current
   // solution in a small amount of time. All possible moves for the
   // different neighbourhoods are performed, stopping when reaching a
   // local minima.
-  tsp::LocalSearch sym_ls(_symmetrized_matrix,
+  tsp::LocalSearch sym_ls(symmetrized_matrix(),
                           std::make_pair(!_round_trip and _has_start and
                                            _has_end,
                                          _start),
@@ -278,6 +336,7 @@ std::vector<Index> TSP::raw_solve(unsigned nb_threads) const {
 
 Solution TSP::solve(unsigned,
                     unsigned nb_threads,
+                    const Deadline&,
                     const std::vector<HeuristicParameters>&) const {
   RawRoute r(_input, 0);
   r.set_route(_input, raw_solve(nb_threads));
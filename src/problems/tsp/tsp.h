@@ -31,9 +31,19 @@ private:
   bool _has_end;
   Index _end;
   Matrix<Cost> _matrix;
+  // Coordinates matching ranks in _matrix, only filled when all
+  // involved locations have coordinates. Used by the space-filling
+  // curve heuristic on huge instances.
+  std::vector<Coordinates> _location_coords;
+  // Only materialized when _matrix is asymmetric, access through
+  // symmetrized_matrix() instead.
   Matrix<Cost> _symmetrized_matrix;
   bool _round_trip;
 
+  const Matrix<Cost>& symmetrized_matrix() const {
+    return _is_symmetric ? _matrix : _symmetrized_matrix;
+  }
+
 public:
   TSP(const Input& input, std::vector<Index> job_ranks, Index vehicle_rank);
 
@@ -46,6 +56,7 @@ public:
   virtual Solution
   solve(unsigned,
         unsigned nb_threads,
+        const Deadline&,
         const std::vector<HeuristicParameters>&) const override;
 };
 
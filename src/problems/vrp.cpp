@@ -19,4 +19,18 @@ VRP::VRP(const Input& input) : _input(input) {
 VRP::~VRP() {
 }
 
+bool VRP::giant_tour_candidate() const {
+  if (_input.vehicles.size() < 2 or _input.has_shipments() or
+      _input.zero_amount().size() == 0) {
+    return false;
+  }
+
+  for (Index v = 1; v < _input.vehicles.size(); ++v) {
+    if (!_input.vehicles_interchangeable(0, v)) {
+      return false;
+    }
+  }
+  return true;
+}
+
 } // namespace vroom
@@ -21,6 +21,12 @@ class VRP {
 protected:
   const Input& _input;
 
+  // Whether current instance is a good fit for the order-first,
+  // split-second construction (see heuristics::giant_tour): a
+  // capacitated, shipment-free problem on a fleet of fully
+  // interchangeable vehicles.
+  bool giant_tour_candidate() const;
+
 public:
   VRP(const Input& input);
 
@@ -29,6 +35,7 @@ public:
   virtual Solution
   solve(unsigned exploration_level,
         unsigned nb_threads,
+        const Deadline& deadline,
         const std::vector<HeuristicParameters>& h_param) const = 0;
 };
 
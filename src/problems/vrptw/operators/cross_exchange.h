@@ -15,7 +15,7 @@ All rights reserved (see LICENSE).
 namespace vroom {
 namespace vrptw {
 
-class CrossExchange : public cvrp::CrossExchange {
+class CrossExchange final : public cvrp::CrossExchange {
 private:
   TWRoute& _tw_s_route;
   TWRoute& _tw_t_route;
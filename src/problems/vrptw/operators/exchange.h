@@ -15,7 +15,7 @@ All rights reserved (see LICENSE).
 namespace vroom {
 namespace vrptw {
 
-class Exchange : public cvrp::Exchange {
+class Exchange final : public cvrp::Exchange {
 private:
   TWRoute& _tw_s_route;
   TWRoute& _tw_t_route;
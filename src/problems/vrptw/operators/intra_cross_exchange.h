@@ -15,7 +15,7 @@ All rights reserved (see LICENSE).
 namespace vroom {
 namespace vrptw {
 
-class IntraCrossExchange : public cvrp::IntraCrossExchange {
+class IntraCrossExchange final : public cvrp::IntraCrossExchange {
 private:
   TWRoute& _tw_s_route;
 
@@ -15,7 +15,7 @@ All rights reserved (see LICENSE).
 namespace vroom {
 namespace vrptw {
 
-class IntraExchange : public cvrp::IntraExchange {
+class IntraExchange final : public cvrp::IntraExchange {
 private:
   TWRoute& _tw_s_route;
 
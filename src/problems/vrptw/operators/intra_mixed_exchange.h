@@ -15,7 +15,7 @@ All rights reserved (see LICENSE).
 namespace vroom {
 namespace vrptw {
 
-class IntraMixedExchange : public cvrp::IntraMixedExchange {
+class IntraMixedExchange final : public cvrp::IntraMixedExchange {
 private:
   TWRoute& _tw_s_route;
 
@@ -15,7 +15,7 @@ All rights reserved (see LICENSE).
 namespace vroom {
 namespace vrptw {
 
-class IntraRelocate : public cvrp::IntraRelocate {
+class IntraRelocate final : public cvrp::IntraRelocate {
 private:
   TWRoute& _tw_s_route;
 
@@ -15,7 +15,7 @@ All rights reserved (see LICENSE).
 namespace vroom {
 namespace vrptw {
 
-class MixedExchange : public cvrp::MixedExchange {
+class MixedExchange final : public cvrp::MixedExchange {
 private:
   TWRoute& _tw_s_route;
   TWRoute& _tw_t_route;
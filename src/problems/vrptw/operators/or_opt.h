@@ -15,7 +15,7 @@ All rights reserved (see LICENSE).
 namespace vroom {
 namespace vrptw {
 
-class OrOpt : public cvrp::OrOpt {
+class OrOpt final : public cvrp::OrOpt {
 private:
   TWRoute& _tw_s_route;
   TWRoute& _tw_t_route;
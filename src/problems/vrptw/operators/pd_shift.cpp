@@ -32,8 +32,8 @@ PDShift::PDShift(const Input& input,
                   t_vehicle,
                   gain_threshold),
     _is_valid_removal(true),
-    _source_without_pd(s_route.begin() + _s_p_rank + 1,
-                       s_route.begin() + _s_d_rank),
+    _source_without_pd(ls::scratch::borrow(s_route.begin() + _s_p_rank + 1,
+                                           s_route.begin() + _s_d_rank)),
     _tw_s_route(tw_s_route),
     _tw_t_route(tw_t_route) {
 }
@@ -75,6 +75,22 @@ void PDShift::compute_gain() {
       target.is_valid_addition_for_tw(_input, s_route[_s_d_rank], t_d_rank);
   }
 
+  // best_d_gain_from[r] holds the best delivery-side gain over
+  // TW-valid ranks from r on, and last_valid_d_rank the last of
+  // those ranks. Together they bound the feasible delivery band the
+  // scan below has to cover for a given pickup position.
+  std::vector<Gain> best_d_gain_from(t_route.size() + 2,
+                                     std::numeric_limits<Gain>::min());
+  unsigned last_valid_d_rank = 0;
+  for (unsigned t_d_rank = t_route.size() + 1; t_d_rank > 0; --t_d_rank) {
+    best_d_gain_from[t_d_rank - 1] = best_d_gain_from[t_d_rank];
+    if ((bool)valid_delivery_insertions[t_d_rank - 1]) {
+      best_d_gain_from[t_d_rank - 1] =
+        std::max(best_d_gain_from[t_d_rank - 1], t_d_gains[t_d_rank - 1]);
+      last_valid_d_rank = std::max(last_valid_d_rank, t_d_rank - 1);
+    }
+  }
+
   for (unsigned t_p_rank = 0; t_p_rank <= t_route.size(); ++t_p_rank) {
     Gain t_p_gain =
       -utils::addition_cost(_input, s_route[_s_p_rank], v, t_route, t_p_rank);
@@ -95,10 +111,20 @@ void PDShift::compute_gain() {
       continue;
     }
 
+    // Restrict the scan to the feasible delivery band. When no valid
+    // rank after the pickup can beat the incumbent, it collapses to
+    // the back-to-back insertion at t_p_rank, whose gain is not made
+    // of t_p_gain and a delivery term.
+    const bool band_beats_incumbent =
+      best_d_gain_from[t_p_rank] != std::numeric_limits<Gain>::min() and
+      stored_gain < _remove_gain + t_p_gain + best_d_gain_from[t_p_rank];
+    const unsigned last_t_d_rank =
+      band_beats_incumbent ? last_valid_d_rank : t_p_rank;
+
     std::vector<Index> modified_with_pd({s_route[_s_p_rank]});
     Amount modified_delivery = _input.zero_amount();
 
-    for (unsigned t_d_rank = t_p_rank; t_d_rank <= t_route.size(); ++t_d_rank) {
+    for (unsigned t_d_rank = t_p_rank; t_d_rank <= last_t_d_rank; ++t_d_rank) {
       // Update state variables along the way before potential early
       // abort.
       if (t_p_rank < t_d_rank) {
@@ -142,15 +168,8 @@ void PDShift::compute_gain() {
                                                      t_p_rank,
                                                      t_d_rank);
 
-        // Checking for removal validity is like checking insertion of
-        // source portion without P&D in place.
-        valid =
-          valid &&
-          _tw_s_route.is_valid_addition_for_tw(_input,
-                                               s_route.begin() + _s_p_rank + 1,
-                                               s_route.begin() + _s_d_rank,
-                                               _s_p_rank,
-                                               _s_d_rank + 1);
+        // Removal validity on the source route does not depend on the
+        // insertion ranks, it already held through _is_valid_removal.
 
         modified_with_pd.pop_back();
 
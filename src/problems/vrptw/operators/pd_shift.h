@@ -15,7 +15,7 @@ All rights reserved (see LICENSE).
 namespace vroom {
 namespace vrptw {
 
-class PDShift : public cvrp::PDShift {
+class PDShift final : public cvrp::PDShift {
 private:
   bool _is_valid_removal;
   std::vector<Index> _source_without_pd;
@@ -38,6 +38,10 @@ public:
   void log_route(const std::vector<Index>& route) const;
 
   virtual void apply() override;
+
+  virtual ~PDShift() {
+    ls::scratch::give_back(std::move(_source_without_pd));
+  }
 };
 
 } // namespace vrptw
@@ -15,7 +15,7 @@ All rights reserved (see LICENSE).
 namespace vroom {
 namespace vrptw {
 
-class Relocate : public cvrp::Relocate {
+class Relocate final : public cvrp::Relocate {
 private:
   TWRoute& _tw_s_route;
   TWRoute& _tw_t_route;
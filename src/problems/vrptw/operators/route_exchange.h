@@ -15,7 +15,7 @@ All rights reserved (see LICENSE).
 namespace vroom {
 namespace vrptw {
 
-class RouteExchange : public cvrp::RouteExchange {
+class RouteExchange final : public cvrp::RouteExchange {
 private:
   TWRoute& _tw_s_route;
   TWRoute& _tw_t_route;
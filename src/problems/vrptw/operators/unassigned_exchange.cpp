@@ -14,7 +14,7 @@ namespace vrptw {
 
 UnassignedExchange::UnassignedExchange(const Input& input,
                                        const utils::SolutionState& sol_state,
-                                       std::unordered_set<Index>& unassigned,
+                                       utils::PriorityBucketSet& unassigned,
                                        TWRoute& tw_s_route,
                                        Index s_vehicle,
                                        Index s_rank,
@@ -47,9 +47,9 @@ void UnassignedExchange::apply() {
                       _first_rank,
                       _last_rank);
 
-  assert(_unassigned.find(_u) != _unassigned.end());
+  assert(_unassigned.contains(_u));
   _unassigned.erase(_u);
-  assert(_unassigned.find(_removed) == _unassigned.end());
+  assert(!_unassigned.contains(_removed));
   _unassigned.insert(_removed);
 }
 
@@ -15,14 +15,14 @@ All rights reserved (see LICENSE).
 namespace vroom {
 namespace vrptw {
 
-class UnassignedExchange : public cvrp::UnassignedExchange {
+class UnassignedExchange final : public cvrp::UnassignedExchange {
 private:
   TWRoute& _tw_s_route;
 
 public:
   UnassignedExchange(const Input& input,
                      const utils::SolutionState& sol_state,
-                     std::unordered_set<Index>& unassigned,
+                     utils::PriorityBucketSet& unassigned,
                      TWRoute& tw_s_route,
                      Index s_vehicle,
                      Index s_rank,
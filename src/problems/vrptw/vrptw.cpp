@@ -7,7 +7,12 @@ All rights reserved (see LICENSE).
 
 */
 
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <numeric>
 #include <thread>
+#include <unordered_set>
 
 #include "algorithms/heuristics/heuristics.h"
 #include "algorithms/local_search/local_search.h"
@@ -27,7 +32,10 @@ All rights reserved (see LICENSE).
 #include "problems/vrptw/operators/two_opt.h"
 #include "problems/vrptw/operators/unassigned_exchange.h"
 #include "problems/vrptw/vrptw.h"
+#include "utils/checkpoint.h"
 #include "utils/helpers.h"
+#include "utils/solution_pool.h"
+#include "utils/thread_pool.h"
 
 namespace vroom {
 
@@ -137,14 +145,20 @@ VRPTW::VRPTW(const Input& input) : VRP(input) {
 
 Solution VRPTW::solve(unsigned exploration_level,
                       unsigned nb_threads,
+                      const Deadline& deadline,
                       const std::vector<HeuristicParameters>& h_param) const {
   // Use vector of parameters when passed for debugging, else use
   // predefined parameter set.
-  const auto& parameters = (!h_param.empty())
-                             ? h_param
-                             : (_input.has_homogeneous_locations())
-                                 ? homogeneous_parameters
-                                 : heterogeneous_parameters;
+  std::vector<HeuristicParameters> parameters =
+    (!h_param.empty()) ? h_param
+                       : (_input.has_homogeneous_locations())
+                           ? homogeneous_parameters
+                           : heterogeneous_parameters;
+  // Exploration levels beyond 5 keep the level-5 parameter set and
+  // add a ruin-and-recreate phase after the operator sweep.
+  const bool use_lns = (exploration_level > 5);
+  exploration_level = std::min(exploration_level, 5u);
+
   unsigned max_nb_jobs_removal = exploration_level;
   unsigned nb_init_solutions = h_param.size();
 
@@ -160,58 +174,266 @@ Solution VRPTW::solve(unsigned exploration_level,
   }
   assert(nb_init_solutions <= parameters.size());
 
+  if (h_param.empty() and
+      std::any_of(_input.jobs.begin(), _input.jobs.end(), [](const auto& j) {
+        return j.priority != 0;
+      })) {
+    // Add a beam construction run on instances with job priorities,
+    // where the greedy regret-based seeds can strand high-priority
+    // jobs and leave local search to rescue them.
+    parameters.insert(parameters.begin() + nb_init_solutions,
+                      HeuristicParameters(HEURISTIC::BEAM, INIT::NONE, 0.3));
+    ++nb_init_solutions;
+  }
+
+  if (h_param.empty() and giant_tour_candidate()) {
+    // Add an order-first, split-second construction run on
+    // homogeneous-fleet instances, where it yields a good seed for a
+    // fraction of the insertion heuristics cost. Time windows are
+    // not part of the split model so the seed degrades with TW
+    // tightness, but dominated seeds are discarded anyway.
+    parameters.insert(parameters.begin() + nb_init_solutions,
+                      HeuristicParameters(HEURISTIC::GIANT_TOUR,
+                                          INIT::NONE,
+                                          0));
+    ++nb_init_solutions;
+  }
+
+  if (_input.sweep_count() > 1) {
+    // Distributed parameter sweep: only run this process share of
+    // the parameter set, interleaved so every process gets a mix of
+    // cheap and expensive settings. The coordinator picks the best
+    // reported solution across processes.
+    std::vector<HeuristicParameters> slice;
+    for (std::size_t r = _input.sweep_rank(); r < nb_init_solutions;
+         r += _input.sweep_count()) {
+      slice.push_back(parameters[r]);
+    }
+    if (slice.empty()) {
+      slice.push_back(parameters.front());
+    }
+    parameters = std::move(slice);
+    nb_init_solutions = parameters.size();
+  }
+
   std::vector<TWSolution> tw_solutions(nb_init_solutions);
   std::vector<utils::SolutionIndicators> sol_indicators(nb_init_solutions);
 
-  // Split the work among threads.
-  std::vector<std::vector<std::size_t>>
-    thread_ranks(nb_threads, std::vector<std::size_t>());
-  for (std::size_t i = 0; i < nb_init_solutions; ++i) {
-    thread_ranks[i % nb_threads].push_back(i);
+  // Shared counter from which solving threads pull the next
+  // parameter rank to handle. Runtimes vary a lot between parameter
+  // sets, so a static split would leave cores idling while the
+  // unlucky thread drains its share.
+  std::atomic<std::size_t> next_rank(0);
+
+  // Shared pool holding the best solution found so far across
+  // threads, consulted between heuristic and local-search phases so
+  // no thread burns its budget polishing a dominated seed. Dominance
+  // checks are lock-free and publication never stalls readers, see
+  // utils::SolutionPool.
+  utils::SolutionPool<TWSolution> pool;
+
+  // Hashes of states already used as local search starting points.
+  // Heuristic runs and pool restarts routinely produce identical
+  // seeds, and descents from them too.
+  std::mutex explored_mutex;
+  std::unordered_set<uint64_t> explored_seeds;
+
+  if (_input.has_initial_routes()) {
+    // Seed the pool with the routes provided in input so incremental
+    // re-solves start from the previous assignment instead of from
+    // scratch.
+    const auto initial = heuristics::initial_routes<TWSolution>(_input);
+    pool.try_publish(utils::solution_indicators(_input, initial), initial);
   }
 
-  auto run_solve = [&](const std::vector<std::size_t>& param_ranks) {
-    for (auto rank : param_ranks) {
+  // Threads left over after assigning one per heuristic parameter
+  // are used inside the local search itself.
+  const unsigned nb_ls_threads =
+    std::max<unsigned>(1,
+                       nb_threads /
+                         std::min<unsigned>(nb_threads, nb_init_solutions));
+
+  // Invariant data built once and shared read-only by all heuristic
+  // runs.
+  const heuristics::SharedHeuristicData heuristic_data(_input);
+
+  auto run_solve = [&]() {
+    while (true) {
+      const auto rank = next_rank.fetch_add(1);
+      if (rank >= nb_init_solutions or utils::deadline_passed(deadline) or
+          _input.solving_cancelled()) {
+        break;
+      }
       auto& p = parameters[rank];
       switch (p.heuristic) {
       case HEURISTIC::BASIC:
         tw_solutions[rank] =
-          heuristics::basic<TWSolution>(_input, p.init, p.regret_coeff);
+          heuristics::basic<TWSolution>(_input,
+                                       heuristic_data,
+                                       p.init,
+                                       p.regret_coeff);
         break;
       case HEURISTIC::DYNAMIC:
         tw_solutions[rank] =
           heuristics::dynamic_vehicle_choice<TWSolution>(_input,
+                                                         heuristic_data,
                                                          p.init,
                                                          p.regret_coeff);
         break;
+      case HEURISTIC::BEAM:
+        tw_solutions[rank] = heuristics::beam<TWSolution>(_input,
+                                                          heuristic_data,
+                                                          p.regret_coeff);
+        break;
+      case HEURISTIC::GIANT_TOUR:
+        tw_solutions[rank] = heuristics::giant_tour<TWSolution>(_input);
+        break;
+      }
+
+      auto seed_indicators =
+        utils::solution_indicators(_input, tw_solutions[rank]);
+
+      // Restart from the pool best whenever it dominates the current
+      // heuristic seed.
+      if (pool.dominates(seed_indicators)) {
+        const auto best = pool.snapshot();
+        if (best != nullptr and best->indicators < seed_indicators) {
+          tw_solutions[rank] = best->solution;
+          seed_indicators = best->indicators;
+        }
+      }
+
+      if (!_input.deterministic()) {
+        std::lock_guard<std::mutex> guard(explored_mutex);
+        if (!explored_seeds.insert(seed_indicators.hash).second) {
+          // Another thread already ran a descent from this very
+          // state and its outcome is on record, so re-polishing the
+          // seed would only duplicate it. Skipped in deterministic
+          // mode, same as pool sharing below.
+          sol_indicators[rank] = seed_indicators;
+          continue;
+        }
       }
 
       // Local search phase.
-      LocalSearch ls(_input, tw_solutions[rank], max_nb_jobs_removal);
+      LocalSearch ls(_input,
+                     tw_solutions[rank],
+                     max_nb_jobs_removal,
+                     nb_ls_threads,
+                     deadline);
       ls.run();
+      if (use_lns) {
+        ls.run_lns();
+      }
 
       // Store solution indicators.
       sol_indicators[rank] = ls.indicators();
+
+      if (!_input.deterministic()) {
+        // Share with other threads. Skipped in deterministic mode as
+        // the pool content would then depend on thread completion
+        // order, so the pool only ever holds the initial routes seed.
+        pool.try_publish(sol_indicators[rank], tw_solutions[rank]);
+      }
     }
   };
 
-  std::vector<std::thread> solving_threads;
-
-  for (std::size_t i = 0; i < nb_threads; ++i) {
-    solving_threads.emplace_back(run_solve, thread_ranks[i]);
+  std::vector<std::function<void()>> solving_tasks(nb_threads, run_solve);
+
+  // Watcher thread handling background work on the pool best:
+  // periodic checkpoint writes so an interrupted run can resume (see
+  // Input::set_checkpoint), and speculative geometry fetches for a
+  // best solution that survived a full polling interval, overlapping
+  // the routing phase with solving (see Input::prefetch_geometry). A
+  // best solution displaced after its fetch just leaves unused cache
+  // entries behind.
+  std::atomic<bool> solving_done(false);
+  std::thread watcher_thread;
+  const bool write_checkpoints = !_input.checkpoint_file().empty();
+  if (write_checkpoints or _input.geometry()) {
+    watcher_thread = std::thread([&]() {
+      const std::chrono::seconds interval(_input.checkpoint_interval());
+      auto next_write = std::chrono::steady_clock::now() + interval;
+      std::shared_ptr<const utils::SolutionPool<TWSolution>::Entry> previous;
+      std::shared_ptr<const utils::SolutionPool<TWSolution>::Entry> prefetched;
+      while (!solving_done.load()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+        // Snapshots are immutable, so no copy is needed even if a
+        // better solution gets published while one is in use here.
+        const auto best = pool.snapshot();
+
+        if (_input.geometry() and best != nullptr and best == previous and
+            best != prefetched) {
+          auto speculative = utils::format_solution(_input, best->solution);
+          _input.prefetch_geometry(speculative.routes);
+          prefetched = best;
+        }
+        previous = best;
+
+        if (!write_checkpoints or
+            std::chrono::steady_clock::now() < next_write) {
+          continue;
+        }
+        next_write = std::chrono::steady_clock::now() + interval;
+
+        if (best == nullptr) {
+          continue;
+        }
+        utils::write_checkpoint(_input.checkpoint_file(),
+                                utils::checkpoint_routes(_input,
+                                                         best->solution));
+      }
+    });
   }
 
-  for (auto& t : solving_threads) {
-    t.join();
+  try {
+    utils::ThreadPool::instance().run(std::move(solving_tasks));
+  } catch (...) {
+    solving_done.store(true);
+    if (watcher_thread.joinable()) {
+      watcher_thread.join();
+    }
+    throw;
+  }
+  solving_done.store(true);
+  if (watcher_thread.joinable()) {
+    watcher_thread.join();
   }
 
   auto best_indic =
     std::min_element(sol_indicators.cbegin(), sol_indicators.cend());
+  const auto best_rank = static_cast<std::size_t>(
+    std::distance(sol_indicators.cbegin(), best_indic));
+
+  auto sol = utils::format_solution(_input, tw_solutions[best_rank]);
+
+  if (_input.nb_alternatives() > 0) {
+    // The parameter sweep above produced many distinct high-quality
+    // assignments that would otherwise be discarded: rank them and
+    // keep the next nb_alternatives ones as ready-made fallback
+    // plans. The order-independent fingerprint filters out ranks
+    // that converged to an already retained assignment.
+    std::vector<std::size_t> ranking(sol_indicators.size());
+    std::iota(ranking.begin(), ranking.end(), 0);
+    std::sort(ranking.begin(), ranking.end(), [&](const auto lhs,
+                                                  const auto rhs) {
+      return sol_indicators[lhs] < sol_indicators[rhs];
+    });
+
+    std::unordered_set<uint64_t> retained({sol_indicators[best_rank].hash});
+    for (const auto rank : ranking) {
+      if (sol.alternatives.size() == _input.nb_alternatives()) {
+        break;
+      }
+      if (retained.insert(sol_indicators[rank].hash).second) {
+        sol.alternatives.push_back(
+          utils::format_solution(_input, tw_solutions[rank]));
+      }
+    }
+  }
 
-  return utils::format_solution(_input,
-                                tw_solutions[std::distance(sol_indicators
-                                                             .cbegin(),
-                                                           best_indic)]);
+  return sol;
 }
 
 } // namespace vroom
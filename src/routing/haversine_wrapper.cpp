@@ -0,0 +1,120 @@
+/*
+
+This file is part of VROOM.
+
+Copyright (c) 2015-2021, Julien Coupey.
+All rights reserved (see LICENSE).
+
+*/
+
+#include <cmath>
+#include <thread>
+
+#include "routing/haversine_wrapper.h"
+#include "utils/cpu_dispatch.h"
+#include "utils/thread_pool.h"
+
+namespace {
+
+// Mean earth radius in meters.
+constexpr double EARTH_RADIUS = 6371000.;
+constexpr double DEG_TO_RAD = M_PI / 180.;
+
+// Fill durations from one source to all targets, reading
+// pre-computed per-location trigonometry. Flat-loop leaf function so
+// per-target clones can vectorize it.
+VROOM_TARGET_CLONES
+void fill_source_row(vroom::Cost* row,
+                     const double* lat_rad,
+                     const double* lon_rad,
+                     const double* cos_lat,
+                     vroom::Index s,
+                     const vroom::Index* targets,
+                     std::size_t nb_targets) {
+  for (std::size_t r = 0; r < nb_targets; ++r) {
+    const auto t = targets[r];
+    const double sin_dlat = std::sin((lat_rad[t] - lat_rad[s]) / 2);
+    const double sin_dlon = std::sin((lon_rad[t] - lon_rad[s]) / 2);
+    const double a =
+      sin_dlat * sin_dlat + cos_lat[s] * cos_lat[t] * sin_dlon * sin_dlon;
+    const double meters =
+      2 * EARTH_RADIUS * std::asin(std::min(1., std::sqrt(a)));
+
+    row[t] = static_cast<vroom::Cost>(
+      meters / vroom::routing::HaversineWrapper::DEFAULT_SPEED + 0.5);
+  }
+}
+
+} // namespace
+
+namespace vroom {
+namespace routing {
+
+HaversineWrapper::HaversineWrapper(const std::string& profile)
+  : Wrapper(profile) {
+}
+
+Matrix<Cost> HaversineWrapper::get_matrix(const std::vector<Location>& locs,
+                                          const std::vector<Index>& sources,
+                                          const std::vector<Index>& targets)
+  const {
+  // Per-location trigonometry is computed once upfront so the
+  // per-cell work reduces to the haversine combination.
+  std::vector<double> lat_rad(locs.size());
+  std::vector<double> lon_rad(locs.size());
+  std::vector<double> cos_lat(locs.size());
+  for (std::size_t i = 0; i < locs.size(); ++i) {
+    if (!locs[i].has_coordinates()) {
+      throw Exception(ERROR::INPUT,
+                      "Missing coordinates for haversine profile " + profile +
+                        ".");
+    }
+    lat_rad[i] = DEG_TO_RAD * locs[i].lat();
+    lon_rad[i] = DEG_TO_RAD * locs[i].lon();
+    cos_lat[i] = std::cos(lat_rad[i]);
+  }
+
+  Matrix<Cost> m(locs.size());
+
+  auto run_on_sources = [&](std::size_t first, std::size_t stride) {
+    for (std::size_t s = first; s < sources.size(); s += stride) {
+      fill_source_row(m[sources[s]],
+                      lat_rad.data(),
+                      lon_rad.data(),
+                      cos_lat.data(),
+                      sources[s],
+                      targets.data(),
+                      targets.size());
+    }
+  };
+
+  // Rows are independent, so split sources across available threads.
+  const auto nb_buckets =
+    std::min(sources.size(),
+             static_cast<std::size_t>(
+               std::max(1u, std::thread::hardware_concurrency())));
+
+  if (nb_buckets < 2) {
+    run_on_sources(0, 1);
+  } else {
+    std::vector<std::function<void()>> filling_tasks;
+    for (std::size_t bucket = 0; bucket < nb_buckets; ++bucket) {
+      filling_tasks.push_back(
+        [&run_on_sources, bucket, nb_buckets] {
+          run_on_sources(bucket, nb_buckets);
+        });
+    }
+    utils::ThreadPool::instance().run(std::move(filling_tasks));
+  }
+
+  return m;
+}
+
+void HaversineWrapper::add_route_info(Route&) const {
+  // No underlying road network to get geometry from.
+  throw Exception(ERROR::INPUT,
+                  "Route geometry is not available with haversine routing.");
+}
+
+} // namespace routing
+} // namespace vroom
@@ -0,0 +1,42 @@
+#ifndef HAVERSINE_WRAPPER_H
+#define HAVERSINE_WRAPPER_H
+
+/*
+
+This file is part of VROOM.
+
+Copyright (c) 2015-2021, Julien Coupey.
+All rights reserved (see LICENSE).
+
+*/
+
+#include "routing/wrapper.h"
+
+namespace vroom {
+namespace routing {
+
+// Serverless matrix engine for approximate planning: durations are
+// great-circle distances computed straight from location
+// coordinates, turned into seconds with a flat speed. No routing
+// server or caller-supplied matrix is required. Speed models other
+// than the default are expressed as derived profiles scaling this
+// baseline, see Input::add_derived_profile.
+class HaversineWrapper : public Wrapper {
+public:
+  // Flat speed used to turn great-circle meters into seconds.
+  static constexpr double DEFAULT_SPEED = 50. / 3.6; // 50 km/h.
+
+  HaversineWrapper(const std::string& profile);
+
+  virtual Matrix<Cost> get_matrix(const std::vector<Location>& locs,
+                                  const std::vector<Index>& sources,
+                                  const std::vector<Index>& targets)
+    const override;
+
+  virtual void add_route_info(Route& route) const override;
+};
+
+} // namespace routing
+} // namespace vroom
+
+#endif
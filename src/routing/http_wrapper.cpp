@@ -7,18 +7,436 @@ All rights reserved (see LICENSE).
 
 */
 
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <condition_variable>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
 #include <asio.hpp>
 #include <asio/ssl.hpp>
+#include <zlib.h>
+
+#include "../include/rapidjson/reader.h"
 
 #include "routing/http_wrapper.h"
+#include "utils/metrics.h"
+#include "utils/thread_pool.h"
 
 using asio::ip::tcp;
+using SslStream = asio::ssl::stream<tcp::socket>;
 
 namespace vroom {
 namespace routing {
 
 const std::string HttpWrapper::HTTPS_PORT = "443";
 
+namespace {
+
+// Offset one past the terminating CRLF of a chunked body starting at
+// body_start, or npos while the body is still incomplete (or its
+// framing is invalid, in which case only a connection close can
+// delimit the response).
+std::size_t chunked_end(const std::string& response,
+                        const std::size_t body_start) {
+  std::size_t pos = body_start;
+
+  while (true) {
+    const auto size_end = response.find("\r\n", pos);
+    if (size_end == std::string::npos) {
+      return std::string::npos;
+    }
+    // Hex chunk size, possibly followed by chunk extensions.
+    std::size_t chunk_size = 0;
+    const auto [ptr, ec] = std::from_chars(response.data() + pos,
+                                           response.data() + size_end,
+                                           chunk_size,
+                                           16);
+    if (ec != std::errc()) {
+      return std::string::npos;
+    }
+    pos = size_end + 2;
+    if (chunk_size == 0) {
+      break;
+    }
+    if (response.size() < pos + chunk_size + 2) {
+      return std::string::npos;
+    }
+    pos += chunk_size + 2;
+  }
+
+  // Skip optional trailer lines up to the terminating blank line.
+  while (true) {
+    const auto line_end = response.find("\r\n", pos);
+    if (line_end == std::string::npos) {
+      return std::string::npos;
+    }
+    if (line_end == pos) {
+      return pos + 2;
+    }
+    pos = line_end + 2;
+  }
+}
+
+// Whether response is complete based on the Content-Length header or
+// its chunk framing, setting keep_alive accordingly and reporting
+// the expected total response size once known so the caller can
+// reserve room for it upfront. Responses delimited neither way only
+// end with the server closing the connection. A Content-Length value
+// that does not parse as a size sets malformed instead, in which
+// case the connection should be dropped.
+bool response_complete(const std::string& response,
+                       bool& keep_alive,
+                       std::size_t& expected_size,
+                       bool& malformed) {
+  const auto headers_end = response.find("\r\n\r\n");
+  if (headers_end == std::string::npos) {
+    return false;
+  }
+
+  std::string headers = response.substr(0, headers_end + 4);
+  std::transform(headers.begin(), headers.end(), headers.begin(), ::tolower);
+
+  if (headers.find("transfer-encoding: chunked") != std::string::npos) {
+    // The last chunk has size zero, the total size is only known
+    // once it shows up.
+    if (chunked_end(response, headers_end + 4) == std::string::npos) {
+      return false;
+    }
+    keep_alive = (headers.find("connection: close") == std::string::npos);
+    return true;
+  }
+
+  const auto content_length = headers.find("content-length:");
+  if (content_length == std::string::npos) {
+    return false;
+  }
+
+  const char* first = headers.data() + content_length + 15;
+  const char* const last = headers.data() + headers.size();
+  while (first != last and *first == ' ') {
+    ++first;
+  }
+  std::size_t body_size = 0;
+  const auto [ptr, ec] = std::from_chars(first, last, body_size);
+  if (ec != std::errc()) {
+    malformed = true;
+    return false;
+  }
+
+  expected_size = headers_end + 4 + body_size;
+  if (response.size() < expected_size) {
+    return false;
+  }
+
+  keep_alive = (headers.find("connection: close") == std::string::npos);
+  return true;
+}
+
+// Read a whole response from given stream, returning whether the
+// connection can be reused afterwards.
+template <class Stream>
+bool receive_response(Stream& stream, std::string& response) {
+  // Large read chunks keep the number of syscalls low on big table
+  // responses.
+  char buf[16384];
+  std::error_code error;
+  bool keep_alive = false;
+  std::size_t expected_size = 0;
+
+  for (;;) {
+    std::size_t len = stream.read_some(asio::buffer(buf), error);
+    response.append(buf, len);
+    if (error == asio::error::eof) {
+      // Connection closed cleanly.
+      return false;
+    }
+    if (error) {
+      throw std::system_error(error);
+    }
+    bool malformed = false;
+    if (response_complete(response, keep_alive, expected_size, malformed)) {
+      return keep_alive;
+    }
+    if (malformed) {
+      // Drop the connection rather than waiting for more of a
+      // response whose framing cannot be trusted.
+      throw std::system_error(std::make_error_code(std::errc::protocol_error));
+    }
+    if (expected_size != 0 and response.capacity() < expected_size) {
+      // Content-Length is known, grow the buffer to its final size
+      // in one go instead of reallocating along the way.
+      response.reserve(expected_size);
+    }
+  }
+}
+
+// Resolution results are cached per host:port with a TTL so the
+// per-tile parallel fetch does not hit the resolver again for every
+// single connection.
+std::vector<tcp::endpoint> resolve_server(asio::io_service& io_service,
+                                          const Server& server) {
+  constexpr auto TTL = std::chrono::seconds(60);
+
+  static std::mutex cache_mutex;
+  static std::unordered_map<std::string,
+                            std::pair<std::chrono::steady_clock::time_point,
+                                      std::vector<tcp::endpoint>>>
+    cache;
+
+  const auto key = server.host + ":" + server.port;
+  const auto now = std::chrono::steady_clock::now();
+
+  {
+    std::lock_guard<std::mutex> guard(cache_mutex);
+    const auto search = cache.find(key);
+    if (search != cache.end() and now < search->second.first) {
+      return search->second.second;
+    }
+  }
+
+  tcp::resolver r(io_service);
+  tcp::resolver::query q(server.host, server.port);
+
+  // Interleave address families, IPv6 first, so the connect race
+  // below gets both in play early.
+  std::vector<tcp::endpoint> v6;
+  std::vector<tcp::endpoint> v4;
+  for (auto it = r.resolve(q); it != tcp::resolver::iterator(); ++it) {
+    const tcp::endpoint endpoint = *it;
+    (endpoint.address().is_v6() ? v6 : v4).push_back(endpoint);
+  }
+
+  std::vector<tcp::endpoint> endpoints;
+  endpoints.reserve(v6.size() + v4.size());
+  for (std::size_t i = 0; i < std::max(v6.size(), v4.size()); ++i) {
+    if (i < v6.size()) {
+      endpoints.push_back(v6[i]);
+    }
+    if (i < v4.size()) {
+      endpoints.push_back(v4[i]);
+    }
+  }
+
+  std::lock_guard<std::mutex> guard(cache_mutex);
+  cache[key] = std::make_pair(now + TTL, endpoints);
+  return endpoints;
+}
+
+// Staggered non-blocking connect race across endpoints (happy
+// eyeballs): each attempt gets a head start before the next one
+// joins and the first established connection wins. Returns the
+// connected native socket, switched back to blocking mode, along
+// with the rank of the winning endpoint; a negated errno value on
+// failure.
+std::pair<int, std::size_t>
+connect_race(const std::vector<tcp::endpoint>& endpoints) {
+  constexpr auto stagger = std::chrono::milliseconds(250);
+  constexpr auto overall = std::chrono::seconds(10);
+
+  std::vector<pollfd> pending;
+  std::vector<std::size_t> pending_ranks;
+  int last_error = ECONNREFUSED;
+
+  auto won = [&](int fd, std::size_t rank) {
+    for (const auto& p : pending) {
+      if (p.fd != fd) {
+        ::close(p.fd);
+      }
+    }
+    ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) & ~O_NONBLOCK);
+    return std::make_pair(fd, rank);
+  };
+
+  const auto give_up = std::chrono::steady_clock::now() + overall;
+  auto next_start = std::chrono::steady_clock::now();
+  std::size_t next = 0;
+
+  while (true) {
+    const auto now = std::chrono::steady_clock::now();
+    if (give_up <= now) {
+      last_error = ETIMEDOUT;
+      break;
+    }
+
+    if (next < endpoints.size() and (pending.empty() or next_start <= now)) {
+      const auto& endpoint = endpoints[next];
+      const int fd = ::socket(endpoint.protocol().family(),
+                              SOCK_STREAM | SOCK_NONBLOCK,
+                              0);
+      if (fd >= 0) {
+        if (::connect(fd, endpoint.data(), endpoint.size()) == 0) {
+          return won(fd, next);
+        }
+        if (errno == EINPROGRESS) {
+          pending.push_back({fd, POLLOUT, 0});
+          pending_ranks.push_back(next);
+        } else {
+          last_error = errno;
+          ::close(fd);
+        }
+      }
+      ++next;
+      next_start = now + stagger;
+      continue;
+    }
+
+    if (pending.empty()) {
+      // Every attempt failed straight away.
+      break;
+    }
+
+    auto wait_until = give_up;
+    if (next < endpoints.size()) {
+      wait_until = std::min(wait_until, next_start);
+    }
+    const auto wait_ms = std::max<long>(
+      1,
+      std::chrono::duration_cast<std::chrono::milliseconds>(wait_until - now)
+        .count());
+    if (::poll(pending.data(), pending.size(), static_cast<int>(wait_ms)) <=
+        0) {
+      continue;
+    }
+
+    for (std::size_t i = 0; i < pending.size();) {
+      if (pending[i].revents == 0) {
+        ++i;
+        continue;
+      }
+      int so_error = 0;
+      socklen_t len = sizeof(so_error);
+      ::getsockopt(pending[i].fd, SOL_SOCKET, SO_ERROR, &so_error, &len);
+      if (so_error == 0) {
+        return won(pending[i].fd, pending_ranks[i]);
+      }
+      last_error = so_error;
+      ::close(pending[i].fd);
+      pending.erase(pending.begin() + i);
+      pending_ranks.erase(pending_ranks.begin() + i);
+    }
+
+    if (pending.empty() and next == endpoints.size()) {
+      break;
+    }
+  }
+
+  for (const auto& p : pending) {
+    ::close(p.fd);
+  }
+  return std::make_pair(-last_error, 0);
+}
+
+std::unique_ptr<tcp::socket> open_connection(asio::io_service& io_service,
+                                             const Server& server) {
+  const auto endpoints = resolve_server(io_service, server);
+
+  const auto winner = connect_race(endpoints);
+  if (winner.first < 0) {
+    throw std::system_error(
+      std::error_code(-winner.first, std::generic_category()));
+  }
+
+  auto socket = std::make_unique<tcp::socket>(io_service);
+  socket->assign(endpoints[winner.second].protocol(), winner.first);
+
+  return socket;
+}
+
+std::unique_ptr<SslStream> open_ssl_connection(asio::io_service& io_service,
+                                               asio::ssl::context& ctx,
+                                               const Server& server) {
+  const auto endpoints = resolve_server(io_service, server);
+
+  const auto winner = connect_race(endpoints);
+  if (winner.first < 0) {
+    throw std::system_error(
+      std::error_code(-winner.first, std::generic_category()));
+  }
+
+  auto stream = std::make_unique<SslStream>(io_service, ctx);
+  stream->lowest_layer().assign(endpoints[winner.second].protocol(),
+                                winner.first);
+  stream->handshake(asio::ssl::stream_base::handshake_type::client);
+
+  return stream;
+}
+
+// Primary replica for a possibly comma-separated host list.
+Server primary_server(const Server& server) {
+  const auto comma = server.host.find(',');
+  return (comma == std::string::npos)
+           ? server
+           : Server(server.host.substr(0, comma), server.port);
+}
+
+// Remaining replicas for a possibly comma-separated host list.
+std::vector<Server> backup_servers(const Server& server) {
+  std::vector<Server> backups;
+
+  auto start = server.host.find(',');
+  while (start != std::string::npos) {
+    const auto end = server.host.find(',', start + 1);
+    backups.emplace_back(server.host.substr(start + 1, end - start - 1),
+                         server.port);
+    start = end;
+  }
+
+  return backups;
+}
+
+std::chrono::milliseconds get_hedge_delay() {
+  const char* delay = std::getenv("VROOM_HEDGE_DELAY_MS");
+  return std::chrono::milliseconds(
+    (delay != nullptr and *delay != '\0') ? std::stoul(delay) : 100);
+}
+
+} // namespace
+
+struct HttpWrapper::ConnectionPool {
+  asio::io_service io_service;
+  asio::ssl::context ssl_context;
+  std::mutex mutex;
+  std::vector<std::unique_ptr<tcp::socket>> plain_connections;
+  std::vector<std::unique_ptr<SslStream>> ssl_connections;
+
+  static constexpr std::size_t max_idle_connections = 16;
+
+  ConnectionPool() : ssl_context(asio::ssl::context::method::sslv23_client) {
+  }
+
+  template <class Connection>
+  std::unique_ptr<Connection>
+  take(std::vector<std::unique_ptr<Connection>>& idle) {
+    std::lock_guard<std::mutex> guard(mutex);
+    if (idle.empty()) {
+      return nullptr;
+    }
+    auto connection = std::move(idle.back());
+    idle.pop_back();
+    return connection;
+  }
+
+  template <class Connection>
+  void give_back(std::vector<std::unique_ptr<Connection>>& idle,
+                 std::unique_ptr<Connection>&& connection) {
+    std::lock_guard<std::mutex> guard(mutex);
+    if (idle.size() < max_idle_connections) {
+      idle.push_back(std::move(connection));
+    }
+  }
+};
+
 HttpWrapper::HttpWrapper(const std::string& profile,
                          const Server& server,
                          const std::string& matrix_service,
@@ -26,137 +444,811 @@ HttpWrapper::HttpWrapper(const std::string& profile,
                          const std::string& route_service,
                          const std::string& extra_args)
   : Wrapper(profile),
-    _server(server),
+    _connection_pool(std::make_shared<ConnectionPool>()),
+    _backup_servers(backup_servers(server)),
+    _hedge_delay(get_hedge_delay()),
+    _server(primary_server(server)),
     _matrix_service(matrix_service),
     _matrix_durations_key(matrix_durations_key),
     _route_service(route_service),
     _extra_args(extra_args) {
 }
 
-std::string HttpWrapper::send_then_receive(const std::string& query) const {
-  std::string response;
+HttpWrapper::~HttpWrapper() = default;
 
-  try {
-    asio::io_service io_service;
+namespace {
 
-    tcp::resolver r(io_service);
+// Inflate a gzip or deflate compressed body. windowBits is set to
+// auto-detect gzip and zlib wrappers, with a second raw-deflate pass
+// for servers sending "deflate" without the zlib header.
+std::string inflate_body(const char* body, std::size_t size) {
+  std::string inflated;
+  // Table responses typically compress around tenfold.
+  inflated.reserve(10 * size);
 
-    tcp::resolver::query q(_server.host, _server.port);
+  z_stream strm{};
+  if (inflateInit2(&strm, 15 + 32) != Z_OK) {
+    throw Exception(ERROR::ROUTING, "Failed to init decompression.");
+  }
+  strm.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(body));
+  strm.avail_in = static_cast<uInt>(size);
 
-    tcp::socket s(io_service);
-    asio::connect(s, r.resolve(q));
+  char out[16384];
+  int ret;
+  bool raw_retried = false;
+  do {
+    strm.next_out = reinterpret_cast<Bytef*>(out);
+    strm.avail_out = sizeof(out);
+    ret = inflate(&strm, Z_NO_FLUSH);
+    if (ret == Z_DATA_ERROR and inflated.empty() and !raw_retried) {
+      inflateEnd(&strm);
+      strm = z_stream{};
+      if (inflateInit2(&strm, -15) != Z_OK) {
+        throw Exception(ERROR::ROUTING, "Failed to init decompression.");
+      }
+      strm.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(body));
+      strm.avail_in = static_cast<uInt>(size);
+      raw_retried = true;
+      continue;
+    }
+    if (ret != Z_OK and ret != Z_STREAM_END) {
+      inflateEnd(&strm);
+      throw Exception(ERROR::ROUTING, "Invalid compressed response.");
+    }
+    inflated.append(out, sizeof(out) - strm.avail_out);
+  } while (ret != Z_STREAM_END);
 
-    asio::write(s, asio::buffer(query));
+  inflateEnd(&strm);
+  return inflated;
+}
 
-    char buf[512];
-    std::error_code error;
-    for (;;) {
-      std::size_t len = s.read_some(asio::buffer(buf), error);
-      response.append(buf, len);
-      if (error == asio::error::eof) {
-        // Connection closed cleanly.
-        break;
-      } else {
-        if (error) {
-          throw std::system_error(error);
-        }
+// Concatenated chunk payloads of a chunked body starting at
+// body_start. Invalid framing can reach this point on a response
+// delimited by connection close, so it is reported as a routing
+// error rather than asserted away.
+std::string dechunk_body(const std::string& response,
+                         const std::size_t body_start) {
+  std::string body;
+  body.reserve(response.size() - body_start);
+
+  std::size_t pos = body_start;
+  while (true) {
+    const auto size_end = response.find("\r\n", pos);
+    if (size_end == std::string::npos) {
+      throw Exception(ERROR::ROUTING, "Invalid chunked response.");
+    }
+    std::size_t chunk_size = 0;
+    const auto [ptr, ec] = std::from_chars(response.data() + pos,
+                                           response.data() + size_end,
+                                           chunk_size,
+                                           16);
+    if (ec != std::errc()) {
+      throw Exception(ERROR::ROUTING, "Invalid chunked response.");
+    }
+    pos = size_end + 2;
+    if (chunk_size == 0) {
+      break;
+    }
+    if (response.size() < pos + chunk_size + 2) {
+      throw Exception(ERROR::ROUTING, "Invalid chunked response.");
+    }
+    body.append(response, pos, chunk_size);
+    pos += chunk_size + 2;
+  }
+
+  return body;
+}
+
+} // namespace
+
+std::string HttpWrapper::json_from_response(std::string&& response) {
+  // A compressed body has to be inflated before any trimming.
+  const auto headers_end = response.find("\r\n\r\n");
+  if (headers_end != std::string::npos) {
+    std::string headers = response.substr(0, headers_end + 4);
+    std::transform(headers.begin(), headers.end(), headers.begin(), ::tolower);
+
+    if (headers.find("transfer-encoding: chunked") != std::string::npos) {
+      // Strip the chunk framing before any decompression or
+      // trimming.
+      const auto body = dechunk_body(response, headers_end + 4);
+      response.resize(headers_end + 4);
+      response.append(body);
+    }
+
+    const auto encoding = headers.find("content-encoding:");
+    if (encoding != std::string::npos) {
+      const auto eol = headers.find("\r\n", encoding);
+      const auto value = headers.substr(encoding + 17, eol - encoding - 17);
+      if (value.find("gzip") != std::string::npos or
+          value.find("deflate") != std::string::npos) {
+        return inflate_body(response.data() + headers_end + 4,
+                            response.size() - headers_end - 4);
       }
     }
-  } catch (std::system_error& e) {
-    throw Exception(ERROR::ROUTING,
-                    "Failed to connect to " + _server.host + ":" +
-                      _server.port);
   }
 
-  // Removing headers.
+  // Trim headers and anything trailing the JSON body in place
+  // instead of copying the whole payload out.
   auto start = response.find("{");
   assert(start != std::string::npos);
   auto end = response.rfind("}");
   assert(end != std::string::npos);
 
-  std::string json_string = response.substr(start, end - start + 1);
+  response.erase(end + 1);
+  response.erase(0, start);
 
-  return json_string;
+  return std::move(response);
 }
 
-std::string HttpWrapper::ssl_send_then_receive(const std::string& query) const {
+std::string HttpWrapper::exchange(ConnectionPool& pool,
+                                  const Server& server,
+                                  const std::string& query) {
   std::string response;
 
   try {
-    asio::io_service io_service;
+    auto socket = pool.take(pool.plain_connections);
+    const bool reused = (socket != nullptr);
+
+    if (!reused) {
+      socket = open_connection(pool.io_service, server);
+    }
+
+    bool keep_alive = false;
+    try {
+      asio::write(*socket, asio::buffer(query));
+      keep_alive = receive_response(*socket, response);
+      if (reused and response.empty()) {
+        throw std::system_error(
+          std::make_error_code(std::errc::connection_reset));
+      }
+    } catch (const std::system_error&) {
+      if (!reused) {
+        throw;
+      }
+      // Idle connection had been closed by the server, retry on a
+      // fresh one.
+      utils::metrics::routing_retry();
+      response.clear();
+      socket = open_connection(pool.io_service, server);
+      asio::write(*socket, asio::buffer(query));
+      keep_alive = receive_response(*socket, response);
+    }
+
+    if (keep_alive) {
+      pool.give_back(pool.plain_connections, std::move(socket));
+    }
+  } catch (std::system_error& e) {
+    utils::metrics::routing_error();
+    throw Exception(ERROR::ROUTING,
+                    "Failed to connect to " + server.host + ":" + server.port);
+  }
 
-    asio::ssl::context ctx(asio::ssl::context::method::sslv23_client);
-    asio::ssl::stream<asio::ip::tcp::socket> ssock(io_service, ctx);
+  return json_from_response(std::move(response));
+}
 
-    tcp::resolver r(io_service);
+std::string HttpWrapper::send_then_receive(const std::string& query) const {
+  return exchange(*_connection_pool, _server, query);
+}
 
-    tcp::resolver::query q(_server.host, _server.port);
+std::exception_ptr HttpWrapper::send_then_receive_many(
+  const std::vector<std::string>& queries,
+  std::vector<std::string>& responses,
+  std::vector<bool>& done) const {
+  std::exception_ptr failure = nullptr;
 
-    asio::connect(ssock.lowest_layer(), r.resolve(q));
-    ssock.handshake(asio::ssl::stream_base::handshake_type::client);
+  // One connection per query, all driven concurrently by the
+  // single-threaded io_service run below. Pooled connections are
+  // reused first.
+  struct Connection {
+    std::unique_ptr<tcp::socket> socket;
+    bool reused = false;
+    bool keep_alive = false;
+    bool failed = false;
+    std::size_t expected_size = 0;
+    char buf[16384];
+  };
 
-    asio::write(ssock, asio::buffer(query));
+  std::vector<Connection> connections(queries.size());
 
-    char buf[512];
-    std::error_code error;
-    for (;;) {
-      std::size_t len = ssock.read_some(asio::buffer(buf), error);
-      response.append(buf, len);
-      if (error == asio::error::eof) {
-        // Connection closed cleanly.
-        break;
+  try {
+    auto& io_service = _connection_pool->io_service;
+    io_service.reset();
+
+    const auto endpoints = resolve_server(io_service, _server);
+
+    std::function<void(Connection&, std::string&)> receive =
+      [&](Connection& c, std::string& response) {
+        c.socket->async_read_some(asio::buffer(c.buf),
+                                  [&c, &response, &receive](std::error_code ec,
+                                                            std::size_t len) {
+                                    response.append(c.buf, len);
+                                    if (ec == asio::error::eof) {
+                                      // Connection closed cleanly.
+                                      return;
+                                    }
+                                    if (ec) {
+                                      c.failed = true;
+                                      return;
+                                    }
+                                    bool malformed = false;
+                                    if (response_complete(response,
+                                                          c.keep_alive,
+                                                          c.expected_size,
+                                                          malformed)) {
+                                      return;
+                                    }
+                                    if (malformed) {
+                                      // Untrusted framing, drop the
+                                      // connection and let the retry
+                                      // logic below kick in.
+                                      c.failed = true;
+                                      return;
+                                    }
+                                    if (c.expected_size != 0 and
+                                        response.capacity() <
+                                          c.expected_size) {
+                                      response.reserve(c.expected_size);
+                                    }
+                                    receive(c, response);
+                                  });
+      };
+
+    auto send = [&receive](Connection& c,
+                           const std::string& query,
+                           std::string& response) {
+      asio::async_write(*c.socket,
+                        asio::buffer(query),
+                        [&c, &response, &receive](std::error_code ec,
+                                                  std::size_t) {
+                          if (ec) {
+                            c.failed = true;
+                            return;
+                          }
+                          receive(c, response);
+                        });
+    };
+
+    for (std::size_t i = 0; i < queries.size(); ++i) {
+      if (done[i]) {
+        continue;
+      }
+      auto& c = connections[i];
+      const auto& query = queries[i];
+      auto& response = responses[i];
+      // Drop any partial data from a previous attempt.
+      response.clear();
+
+      c.socket = _connection_pool->take(_connection_pool->plain_connections);
+      if (c.socket != nullptr) {
+        c.reused = true;
+        send(c, query, response);
       } else {
-        if (error) {
-          throw std::system_error(error);
-        }
+        c.socket = std::make_unique<tcp::socket>(io_service);
+        asio::async_connect(*c.socket,
+                            endpoints.begin(),
+                            endpoints.end(),
+                            [&c, &query, &response, &send](
+                              std::error_code ec,
+                              std::vector<tcp::endpoint>::const_iterator) {
+                              if (ec) {
+                                c.failed = true;
+                                return;
+                              }
+                              send(c, query, response);
+                            });
+      }
+    }
+
+    io_service.run();
+
+    for (std::size_t i = 0; i < queries.size(); ++i) {
+      if (done[i]) {
+        continue;
+      }
+      auto& c = connections[i];
+      if (c.failed or responses[i].empty()) {
+        // Likely a stale pooled connection closed by the server,
+        // handled below with a fresh one.
+        continue;
+      }
+      try {
+        responses[i] = json_from_response(std::move(responses[i]));
+        done[i] = true;
+      } catch (const Exception&) {
+        // Mangled body, e.g. a response truncated in flight. Leave
+        // the chunk pending for the caller to retry.
+        utils::metrics::routing_retry();
+        failure = std::current_exception();
+        responses[i].clear();
+        continue;
+      }
+      if (c.keep_alive) {
+        _connection_pool->give_back(_connection_pool->plain_connections,
+                                    std::move(c.socket));
       }
     }
   } catch (std::system_error& e) {
+    utils::metrics::routing_error();
+    return std::make_exception_ptr(
+      Exception(ERROR::ROUTING,
+                "Failed to connect to " + _server.host + ":" + _server.port));
+  }
+
+  for (std::size_t i = 0; i < queries.size(); ++i) {
+    if (done[i]) {
+      continue;
+    }
+    try {
+      responses[i] = send_then_receive(queries[i]);
+      done[i] = true;
+    } catch (const Exception&) {
+      failure = std::current_exception();
+    }
+  }
+
+  return failure;
+}
+
+std::string HttpWrapper::ssl_exchange(ConnectionPool& pool,
+                                      const Server& server,
+                                      const std::string& query) {
+  std::string response;
+
+  try {
+    auto stream = pool.take(pool.ssl_connections);
+    const bool reused = (stream != nullptr);
+
+    if (!reused) {
+      stream = open_ssl_connection(pool.io_service, pool.ssl_context, server);
+    }
+
+    bool keep_alive = false;
+    try {
+      asio::write(*stream, asio::buffer(query));
+      keep_alive = receive_response(*stream, response);
+      if (reused and response.empty()) {
+        throw std::system_error(
+          std::make_error_code(std::errc::connection_reset));
+      }
+    } catch (const std::system_error&) {
+      if (!reused) {
+        throw;
+      }
+      // Idle connection had been closed by the server, retry on a
+      // fresh one with a new handshake.
+      response.clear();
+      stream = open_ssl_connection(pool.io_service, pool.ssl_context, server);
+      asio::write(*stream, asio::buffer(query));
+      keep_alive = receive_response(*stream, response);
+    }
+
+    if (keep_alive) {
+      pool.give_back(pool.ssl_connections, std::move(stream));
+    }
+  } catch (std::system_error& e) {
+    utils::metrics::routing_error();
     throw Exception(ERROR::ROUTING,
-                    "Failed to connect to " + _server.host + ":" +
-                      _server.port);
+                    "Failed to connect to " + server.host + ":" + server.port);
   }
 
-  // Removing headers.
-  auto start = response.find("{");
-  assert(start != std::string::npos);
-  auto end = response.rfind("}");
-  assert(end != std::string::npos);
+  return json_from_response(std::move(response));
+}
+
+std::string HttpWrapper::ssl_send_then_receive(const std::string& query) const {
+  return ssl_exchange(*_connection_pool, _server, query);
+}
+
+std::string HttpWrapper::hedged_send_then_receive(
+  const std::string& query) const {
+  // Shared with detached replica threads: a straggler may still be
+  // reading its (discarded) response after the winning one returned,
+  // possibly after the wrapper itself is gone, so everything the
+  // threads touch lives here, including a handle keeping the
+  // connection pool alive.
+  struct HedgeState {
+    std::mutex mutex;
+    std::condition_variable cv;
+    unsigned nb_pending = 0;
+    bool has_result = false;
+    std::string result;
+    std::exception_ptr ep = nullptr;
+    std::string query;
+    std::shared_ptr<ConnectionPool> pool;
+    Server primary_server;
+    bool use_ssl;
+  };
 
-  std::string json_string = response.substr(start, end - start + 1);
+  auto state = std::make_shared<HedgeState>();
+  state->query = query;
+  state->pool = _connection_pool;
+  state->primary_server = _server;
+  state->use_ssl = (_server.port == HTTPS_PORT);
+
+  auto run = [state](bool primary, const Server server) {
+    std::string result;
+    std::exception_ptr ep = nullptr;
+    try {
+      if (primary) {
+        // The primary replica benefits from pooled connections.
+        result = state->use_ssl
+                   ? ssl_exchange(*state->pool,
+                                  state->primary_server,
+                                  state->query)
+                   : exchange(*state->pool,
+                              state->primary_server,
+                              state->query);
+      } else {
+        // Hedged duplicate on a one-shot connection.
+        std::string response;
+        asio::io_service io_service;
+        if (state->use_ssl) {
+          asio::ssl::context ctx(asio::ssl::context::method::sslv23_client);
+          auto stream = open_ssl_connection(io_service, ctx, server);
+          asio::write(*stream, asio::buffer(state->query));
+          receive_response(*stream, response);
+        } else {
+          auto socket = open_connection(io_service, server);
+          asio::write(*socket, asio::buffer(state->query));
+          receive_response(*socket, response);
+        }
+        result = json_from_response(std::move(response));
+      }
+    } catch (const std::system_error&) {
+      utils::metrics::routing_error();
+      ep = std::make_exception_ptr(
+        Exception(ERROR::ROUTING,
+                  "Failed to connect to " + server.host + ":" + server.port));
+    } catch (...) {
+      ep = std::current_exception();
+    }
 
-  return json_string;
+    std::lock_guard<std::mutex> guard(state->mutex);
+    --state->nb_pending;
+    if (ep == nullptr and !state->has_result) {
+      state->has_result = true;
+      state->result = std::move(result);
+    }
+    if (ep != nullptr and state->ep == nullptr) {
+      state->ep = ep;
+    }
+    state->cv.notify_all();
+  };
+
+  std::unique_lock<std::mutex> lock(state->mutex);
+  ++state->nb_pending;
+  std::thread(run, true, _server).detach();
+
+  for (const auto& backup : _backup_servers) {
+    // Hedge to the next replica once the current attempts stayed
+    // silent for the whole delay (or all failed already).
+    state->cv.wait_for(lock, _hedge_delay, [&]() {
+      return state->has_result or state->nb_pending == 0;
+    });
+    if (state->has_result) {
+      return state->result;
+    }
+    ++state->nb_pending;
+    std::thread(run, false, backup).detach();
+  }
+
+  state->cv.wait(lock, [&]() {
+    return state->has_result or state->nb_pending == 0;
+  });
+
+  if (!state->has_result) {
+    assert(state->ep != nullptr);
+    std::rethrow_exception(state->ep);
+  }
+
+  return state->result;
 }
 
 std::string HttpWrapper::run_query(const std::string& query) const {
+  if (!_backup_servers.empty()) {
+    return hedged_send_then_receive(query);
+  }
+
   return (_server.port == HTTPS_PORT) ? ssl_send_then_receive(query)
                                       : send_then_receive(query);
 }
 
+std::vector<std::string>
+HttpWrapper::run_queries(const std::vector<std::string>& queries) const {
+  if (queries.size() == 1) {
+    // Single queries go through run_query so they get hedged to
+    // backup replicas when those are configured.
+    return {run_query(queries.front())};
+  }
+
+  // Completed chunks are kept across attempts so a transient backend
+  // error only costs refetching the chunks it actually hit, not the
+  // whole batch.
+  std::vector<std::string> responses(queries.size());
+  std::vector<bool> done(queries.size(), false);
+
+  std::exception_ptr last_failure = nullptr;
+  auto backoff = CHUNK_RETRY_DELAY;
+
+  for (unsigned attempt = 0; attempt < MAX_CHUNK_ATTEMPTS; ++attempt) {
+    if (attempt != 0) {
+      std::this_thread::sleep_for(backoff);
+      backoff *= 2;
+    }
+
+    if (_server.port == HTTPS_PORT) {
+      // TLS connections keep the sequential path.
+      for (std::size_t i = 0; i < queries.size(); ++i) {
+        if (done[i]) {
+          continue;
+        }
+        try {
+          responses[i] = ssl_send_then_receive(queries[i]);
+          done[i] = true;
+        } catch (const Exception&) {
+          last_failure = std::current_exception();
+        }
+      }
+    } else {
+      last_failure = send_then_receive_many(queries, responses, done);
+    }
+
+    if (std::all_of(done.begin(), done.end(), [](bool d) { return d; })) {
+      return responses;
+    }
+  }
+
+  assert(last_failure != nullptr);
+  std::rethrow_exception(last_failure);
+}
+
 void HttpWrapper::parse_response(rapidjson::Document& json_result,
-                                 const std::string& json_content) const {
+                                 std::string& json_content) const {
+  // Parse in situ straight out of the receive buffer: string values
+  // in json_result point into json_content, which therefore has to
+  // outlive it.
 #ifdef NDEBUG
-  json_result.Parse(json_content.c_str());
+  json_result.ParseInsitu(json_content.data());
 #else
-  assert(!json_result.Parse(json_content.c_str()).HasParseError());
+  assert(!json_result.ParseInsitu(json_content.data()).HasParseError());
 #endif
 }
 
-Matrix<Cost> HttpWrapper::get_matrix(const std::vector<Location>& locs) const {
-  std::string query = this->build_query(locs, _matrix_service);
-  std::string json_string = this->run_query(query);
+namespace {
+
+// SAX handler streaming the durations rows of a table response
+// straight into the final matrix, skipping DOM construction for the
+// (potentially huge) table payload. Only fit for backends whose
+// matrix entries are plain scalars, see
+// HttpWrapper::durations_are_scalar.
+class TableHandler
+  : public rapidjson::BaseReaderHandler<rapidjson::UTF8<>, TableHandler> {
+private:
+  Matrix<Cost>& _m;
+  // Global location ranks for the rows and columns of this tile, rows
+  // starting at rank first_source in sources.
+  const std::vector<Index>& _sources;
+  const std::vector<Index>& _targets;
+  const std::size_t _first_source;
+  const std::size_t _m_size;
+  const std::string& _durations_key;
+
+  // Parsing state: absolute nesting depth, whether the last key seen
+  // at root level is the durations one, and the depth of the
+  // durations array once entered (zero while outside). Rows then live
+  // at _durations_depth + 1 and their scalar cells at that same
+  // depth.
+  unsigned _depth = 0;
+  bool _expect_durations = false;
+  unsigned _durations_depth = 0;
+  std::size_t _rows = 0;
+  std::size_t _col = 0;
+
+  // Null cells are counted locally and only merged by the caller on a
+  // fully successful parse, so falling back to the DOM path does not
+  // count them twice.
+  std::vector<unsigned> _unfound_from_loc;
+  std::vector<unsigned> _unfound_to_loc;
+
+  // Cells are staged as doubles and narrowed to Cost one full row at
+  // a time: the round-and-narrow loop over the staging buffer is
+  // data-parallel and vectorizes, unlike per-cell conversion buried
+  // in the parser callbacks. Null cells hold a negative sentinel and
+  // are skipped when scattering the row to the matrix.
+  std::vector<double> _row_buffer;
+  std::vector<Cost> _cost_buffer;
+
+  bool stage_cell(double d) {
+    if (_durations_depth == 0 or _depth != _durations_depth + 1) {
+      // Scalar unrelated to the durations rows.
+      return true;
+    }
+    if (_col == _targets.size()) {
+      return false;
+    }
+    _row_buffer.push_back(d);
+    ++_col;
+    return true;
+  }
+
+  void flush_row() {
+    // Same rounding as Wrapper::round_cost, applied to the whole row
+    // at once. The sentinel is clamped to zero to keep the narrowing
+    // conversion defined, its cells are skipped below anyway.
+    for (std::size_t j = 0; j < _row_buffer.size(); ++j) {
+      _cost_buffer[j] =
+        static_cast<Cost>(std::max(_row_buffer[j], 0.) + 0.5);
+    }
+
+    Cost* row = _m[_sources[_first_source + _rows]];
+    for (std::size_t j = 0; j < _row_buffer.size(); ++j) {
+      if (_row_buffer[j] >= 0) {
+        row[_targets[j]] = _cost_buffer[j];
+      }
+    }
+  }
+
+public:
+  TableHandler(Matrix<Cost>& m,
+               const std::vector<Index>& sources,
+               const std::vector<Index>& targets,
+               std::size_t first_source,
+               std::size_t m_size,
+               const std::string& durations_key)
+    : _m(m),
+      _sources(sources),
+      _targets(targets),
+      _first_source(first_source),
+      _m_size(m_size),
+      _durations_key(durations_key),
+      _unfound_from_loc(m_size, 0),
+      _unfound_to_loc(m_size, 0) {
+    _row_buffer.reserve(targets.size());
+    _cost_buffer.resize(targets.size());
+  }
+
+  std::size_t rows() const {
+    return _rows;
+  }
+
+  void merge_unfound(std::vector<unsigned>& nb_unfound_from_loc,
+                     std::vector<unsigned>& nb_unfound_to_loc) const {
+    for (std::size_t i = 0; i < _m_size; ++i) {
+      nb_unfound_from_loc[i] += _unfound_from_loc[i];
+      nb_unfound_to_loc[i] += _unfound_to_loc[i];
+    }
+  }
+
+  bool StartObject() {
+    ++_depth;
+    return !_expect_durations;
+  }
+
+  bool EndObject(rapidjson::SizeType) {
+    --_depth;
+    return true;
+  }
+
+  bool Key(const char* str, rapidjson::SizeType length, bool) {
+    if (_depth == 1) {
+      _expect_durations =
+        (_durations_key.compare(0, std::string::npos, str, length) == 0);
+    }
+    return true;
+  }
+
+  bool StartArray() {
+    ++_depth;
+    if (_expect_durations) {
+      _durations_depth = _depth;
+      _expect_durations = false;
+    } else if (_durations_depth != 0) {
+      if (_depth > _durations_depth + 1) {
+        // Nested value in a cell, entries are not scalar after all.
+        return false;
+      }
+      _col = 0;
+      _row_buffer.clear();
+    }
+    return true;
+  }
+
+  bool EndArray(rapidjson::SizeType) {
+    if (_depth == _durations_depth + 1) {
+      // End of a durations row.
+      if (_col != _targets.size()) {
+        return false;
+      }
+      flush_row();
+      ++_rows;
+    } else if (_depth == _durations_depth and _durations_depth != 0) {
+      _durations_depth = 0;
+    }
+    --_depth;
+    return true;
+  }
+
+  bool Null() {
+    if (_durations_depth != 0 and _depth == _durations_depth + 1) {
+      if (_col == _targets.size()) {
+        return false;
+      }
+      // No route found between source and target, just storing info
+      // as we don't know yet which location is responsible.
+      ++_unfound_from_loc[_sources[_first_source + _rows]];
+      ++_unfound_to_loc[_targets[_col++]];
+      _row_buffer.push_back(-1.);
+    }
+    return true;
+  }
+
+  bool Double(double d) {
+    return (d >= 0) and stage_cell(d);
+  }
+
+  bool Uint(unsigned u) {
+    return stage_cell(static_cast<double>(u));
+  }
+
+  bool Int(int i) {
+    return (i >= 0) and stage_cell(static_cast<double>(i));
+  }
+
+  bool Uint64(uint64_t u) {
+    return stage_cell(static_cast<double>(u));
+  }
+
+  bool Int64(int64_t i) {
+    return (i >= 0) and stage_cell(static_cast<double>(i));
+  }
+};
+
+} // namespace
+
+bool HttpWrapper::durations_are_scalar() const {
+  return false;
+}
+
+bool HttpWrapper::wants_hint_collection(const std::vector<Location>&) const {
+  return false;
+}
 
+void HttpWrapper::collect_hints(const rapidjson::Document&,
+                                const std::vector<Location>&,
+                                const std::vector<Index>&,
+                                const std::vector<Index>&,
+                                std::size_t) const {
+}
+
+Matrix<Cost> HttpWrapper::get_matrix(const std::vector<Location>& locs,
+                                     const std::vector<Index>& sources,
+                                     const std::vector<Index>& targets) const {
   // Expected matrix size.
   std::size_t m_size = locs.size();
+  const bool square = (sources.size() == m_size and targets.size() == m_size);
 
-  rapidjson::Document json_result;
-  this->parse_response(json_result, json_string);
-  this->check_response(json_result, _matrix_service);
+  // A single monolithic table query is kept for moderate square
+  // cases, rectangular or larger fetches are tiled into blocks of
+  // source locations dispatched concurrently and assembled directly
+  // in the final matrix.
+  std::vector<std::string> queries;
+  std::vector<std::size_t> first_sources;
 
-  if (!json_result.HasMember(_matrix_durations_key.c_str())) {
-    throw Exception(ERROR::ROUTING, "Missing " + _matrix_durations_key + ".");
+  if (square and m_size <= MAX_SINGLE_TABLE_SIZE) {
+    queries.push_back(this->build_query(locs, _matrix_service));
+    first_sources.push_back(0);
+  } else {
+    for (std::size_t first = 0; first < sources.size();
+         first += TABLE_SOURCES_BLOCK_SIZE) {
+      const auto nb_sources =
+        std::min(TABLE_SOURCES_BLOCK_SIZE, sources.size() - first);
+      queries.push_back(
+        this->build_table_query(locs, sources, targets, first, nb_sources));
+      first_sources.push_back(first);
+    }
   }
-  assert(json_result[_matrix_durations_key.c_str()].Size() == m_size);
+
+  auto json_strings = this->run_queries(queries);
 
   // Build matrix while checking for unfound routes ('null' values) to
   // avoid unexpected behavior.
@@ -165,18 +1257,61 @@ Matrix<Cost> HttpWrapper::get_matrix(const std::vector<Location>& locs) const {
   std::vector<unsigned> nb_unfound_from_loc(m_size, 0);
   std::vector<unsigned> nb_unfound_to_loc(m_size, 0);
 
-  for (rapidjson::SizeType i = 0; i < m_size; ++i) {
-    const auto& line = json_result[_matrix_durations_key.c_str()][i];
-    assert(line.Size() == m_size);
-    for (rapidjson::SizeType j = 0; j < line.Size(); ++j) {
-      if (duration_value_is_null(line[j])) {
-        // No route found between i and j. Just storing info as we
-        // don't know yet which location is responsible between i
-        // and j.
-        ++nb_unfound_from_loc[i];
-        ++nb_unfound_to_loc[j];
-      } else {
-        m[i][j] = get_duration_value(line[j]);
+  // Collecting snapping hints requires a DOM, so streaming is only
+  // used once known locations are all covered.
+  const bool streaming =
+    this->durations_are_scalar() and !this->wants_hint_collection(locs);
+
+  for (std::size_t q = 0; q < json_strings.size(); ++q) {
+    const auto first_source = first_sources[q];
+    const auto expected_rows =
+      std::min(sources.size() - first_source,
+               (queries.size() == 1) ? sources.size()
+                                     : TABLE_SOURCES_BLOCK_SIZE);
+
+    if (streaming) {
+      // Stream durations rows straight into the matrix with a SAX
+      // parse. Anything unexpected -- error payloads in particular --
+      // falls through to the DOM path below for proper reporting.
+      TableHandler handler(m,
+                           sources,
+                           targets,
+                           first_source,
+                           m_size,
+                           _matrix_durations_key);
+      rapidjson::Reader reader;
+      rapidjson::StringStream ss(json_strings[q].c_str());
+      if (reader.Parse(ss, handler) and handler.rows() == expected_rows) {
+        handler.merge_unfound(nb_unfound_from_loc, nb_unfound_to_loc);
+        continue;
+      }
+    }
+
+    rapidjson::Document json_result;
+    this->parse_response(json_result, json_strings[q]);
+    this->check_response(json_result, _matrix_service);
+    this->collect_hints(json_result, locs, sources, targets, first_source);
+
+    if (!json_result.HasMember(_matrix_durations_key.c_str())) {
+      throw Exception(ERROR::ROUTING, "Missing " + _matrix_durations_key + ".");
+    }
+    const auto& durations = json_result[_matrix_durations_key.c_str()];
+    assert(durations.Size() == expected_rows);
+
+    for (rapidjson::SizeType i = 0; i < durations.Size(); ++i) {
+      const auto& line = durations[i];
+      assert(line.Size() == targets.size());
+      const auto source_rank = sources[first_source + i];
+      for (rapidjson::SizeType j = 0; j < line.Size(); ++j) {
+        if (duration_value_is_null(line[j])) {
+          // No route found between source_rank and targets[j]. Just
+          // storing info as we don't know yet which location is
+          // responsible.
+          ++nb_unfound_from_loc[source_rank];
+          ++nb_unfound_to_loc[targets[j]];
+        } else {
+          m[source_rank][targets[j]] = get_duration_value(line[j]);
+        }
       }
     }
   }
@@ -187,28 +1322,137 @@ Matrix<Cost> HttpWrapper::get_matrix(const std::vector<Location>& locs) const {
 }
 
 void HttpWrapper::add_route_info(Route& route) const {
-  // Ordering locations for the given steps, excluding
+  std::vector<std::reference_wrapper<Route>> routes({std::ref(route)});
+  add_route_infos(routes);
+}
+
+std::vector<std::string> HttpWrapper::route_queries(
+  const std::vector<std::reference_wrapper<Route>>& routes,
+  std::vector<std::vector<unsigned>>& number_breaks_after) const {
+  // Ordering locations for the steps of each route, excluding
   // breaks.
-  std::vector<Location> non_break_locations;
-  std::vector<unsigned> number_breaks_after;
+  std::vector<std::string> queries;
+  queries.reserve(routes.size());
+
+  for (std::size_t i = 0; i < routes.size(); ++i) {
+    const Route& route = routes[i];
+    std::vector<Location> non_break_locations;
 
-  for (const auto& step : route.steps) {
-    if (step.step_type == STEP_TYPE::BREAK) {
-      if (!number_breaks_after.empty()) {
-        ++(number_breaks_after.back());
+    for (const auto& step : route.steps) {
+      if (step.step_type == STEP_TYPE::BREAK) {
+        if (!number_breaks_after[i].empty()) {
+          ++(number_breaks_after[i].back());
+        }
+      } else {
+        non_break_locations.push_back(step.location);
+        number_breaks_after[i].push_back(0);
+      }
+    }
+    assert(!non_break_locations.empty());
+
+    queries.push_back(
+      build_query(non_break_locations, _route_service, _extra_args));
+  }
+
+  return queries;
+}
+
+void HttpWrapper::prefetch_route_infos(
+  const std::vector<std::reference_wrapper<Route>>& routes) const {
+  std::vector<std::vector<unsigned>> number_breaks_after(routes.size());
+  const auto queries = route_queries(routes, number_breaks_after);
+
+  std::vector<std::string> pending_queries;
+  {
+    std::lock_guard<std::mutex> guard(_route_cache_mutex);
+    for (const auto& query : queries) {
+      if (_route_cache.find(query) == _route_cache.end()) {
+        pending_queries.push_back(query);
+      }
+    }
+  }
+  if (pending_queries.empty()) {
+    return;
+  }
+
+  auto responses = run_queries(pending_queries);
+
+  std::lock_guard<std::mutex> guard(_route_cache_mutex);
+  if (_route_cache.size() + pending_queries.size() > ROUTE_CACHE_MAX_SIZE) {
+    // Stale entries from earlier solves are worthless anyway.
+    _route_cache.clear();
+  }
+  for (std::size_t i = 0; i < pending_queries.size(); ++i) {
+    _route_cache.emplace(std::move(pending_queries[i]),
+                         std::move(responses[i]));
+  }
+}
+
+void HttpWrapper::add_route_infos(
+  std::vector<std::reference_wrapper<Route>>& routes) const {
+  std::vector<std::vector<unsigned>> number_breaks_after(routes.size());
+  const auto queries = route_queries(routes, number_breaks_after);
+
+  // Reuse responses fetched speculatively while solving was still
+  // running, then run the remaining route queries concurrently
+  // against the backend. Responses are copied out of the cache as
+  // applying a response parses it in situ.
+  std::vector<std::string> json_strings(routes.size());
+  std::vector<std::string> pending_queries;
+  std::vector<std::size_t> pending_ranks;
+  {
+    std::lock_guard<std::mutex> guard(_route_cache_mutex);
+    for (std::size_t i = 0; i < queries.size(); ++i) {
+      const auto search = _route_cache.find(queries[i]);
+      if (search != _route_cache.end()) {
+        json_strings[i] = search->second;
+      } else {
+        pending_queries.push_back(queries[i]);
+        pending_ranks.push_back(i);
       }
-    } else {
-      non_break_locations.push_back(step.location);
-      number_breaks_after.push_back(0);
     }
   }
-  assert(!non_break_locations.empty());
 
-  std::string query =
-    build_query(non_break_locations, _route_service, _extra_args);
+  if (!pending_queries.empty()) {
+    auto responses = run_queries(pending_queries);
+    for (std::size_t k = 0; k < pending_ranks.size(); ++k) {
+      json_strings[pending_ranks[k]] = std::move(responses[k]);
+    }
+  }
+
+  if (routes.size() == 1) {
+    apply_route_info(routes[0], number_breaks_after[0], json_strings[0]);
+    return;
+  }
+
+  // Parsing responses and re-encoding geometries is independent
+  // across routes.
+  std::exception_ptr ep = nullptr;
+  std::mutex ep_mutex;
+
+  std::vector<std::function<void()>> tasks;
+  tasks.reserve(routes.size());
+  for (std::size_t i = 0; i < routes.size(); ++i) {
+    tasks.push_back([&, i]() {
+      try {
+        apply_route_info(routes[i], number_breaks_after[i], json_strings[i]);
+      } catch (...) {
+        std::lock_guard<std::mutex> guard(ep_mutex);
+        ep = std::current_exception();
+      }
+    });
+  }
+  utils::ThreadPool::instance().run(std::move(tasks));
 
-  std::string json_string = this->run_query(query);
+  if (ep != nullptr) {
+    std::rethrow_exception(ep);
+  }
+}
 
+void HttpWrapper::apply_route_info(
+  Route& route,
+  const std::vector<unsigned>& number_breaks_after,
+  std::string& json_string) const {
   rapidjson::Document json_result;
   parse_response(json_result, json_string);
   this->check_response(json_result, _route_service);
@@ -218,7 +1462,7 @@ void HttpWrapper::add_route_info(Route& route) const {
   route.geometry = get_geometry(json_result);
 
   auto nb_legs = get_legs_number(json_result);
-  assert(nb_legs == non_break_locations.size() - 1);
+  assert(nb_legs == number_breaks_after.size() - 1);
 
   double sum_distance = 0;
 
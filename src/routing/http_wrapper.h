@@ -9,6 +9,12 @@ Copyright (c) 2015-2021, Julien Coupey.
 All rights reserved (see LICENSE).
 
 */
+#include <chrono>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
 #include "../include/rapidjson/document.h"
 
 #include "routing/wrapper.h"
@@ -19,10 +25,74 @@ namespace routing {
 
 class HttpWrapper : public Wrapper {
 private:
+  // Pool of idle keep-alive connections to the server, shared across
+  // queries. Kept behind a pointer so asio types stay out of this
+  // header; shared ownership because detached hedge threads may
+  // still be using the pool after the wrapper is destroyed, see
+  // hedged_send_then_receive.
+  struct ConnectionPool;
+  const std::shared_ptr<ConnectionPool> _connection_pool;
+
+  // Extra replicas for the same profile, defined with a
+  // comma-separated host list. A query is duplicated to a backup
+  // whenever the current replica has not answered after _hedge_delay,
+  // and the first complete response wins.
+  const std::vector<Server> _backup_servers;
+  const std::chrono::milliseconds _hedge_delay;
+
+  // Single plain/TLS HTTP exchange against server, reusing and
+  // replenishing pooled connections. Static and parameterized so
+  // hedge threads outliving the wrapper can keep working off their
+  // own shared pool handle.
+  static std::string exchange(ConnectionPool& pool,
+                              const Server& server,
+                              const std::string& query);
+  static std::string ssl_exchange(ConnectionPool& pool,
+                                  const Server& server,
+                                  const std::string& query);
+
   std::string send_then_receive(const std::string& query) const;
 
+  std::string hedged_send_then_receive(const std::string& query) const;
+
+  // Run all pending queries (done[i] false) concurrently from a
+  // single thread against the same backend, each one on its own
+  // connection driven by async I/O. Completed responses are stored in
+  // query order and flagged in done; chunks left pending can be
+  // retried by the caller, see the returned failure (nullptr when
+  // everything pending succeeded).
+  std::exception_ptr
+  send_then_receive_many(const std::vector<std::string>& queries,
+                         std::vector<std::string>& responses,
+                         std::vector<bool>& done) const;
+
   std::string ssl_send_then_receive(const std::string& query) const;
 
+  // Trims the response down to its JSON body in place.
+  static std::string json_from_response(std::string&& response);
+
+  // Fill route geometry and distances from the json content answering
+  // the matching route query, parsed in situ.
+  void apply_route_info(Route& route,
+                        const std::vector<unsigned>& number_breaks_after,
+                        std::string& json_string) const;
+
+  // Route queries for all routes, also filling the number of break
+  // steps following each non-break step per route, needed to apply
+  // the matching responses.
+  std::vector<std::string>
+  route_queries(const std::vector<std::reference_wrapper<Route>>& routes,
+                std::vector<std::vector<unsigned>>& number_breaks_after) const;
+
+  // Raw responses of route queries fetched speculatively while
+  // solving still runs, keyed by full query string and consulted in
+  // add_route_infos. A route whose sequence changed since the fetch
+  // builds a different query and simply misses, so invalidation is
+  // implicit. Capped to keep long-running server processes bounded.
+  static constexpr std::size_t ROUTE_CACHE_MAX_SIZE = 1000;
+  mutable std::mutex _route_cache_mutex;
+  mutable std::unordered_map<std::string, std::string> _route_cache;
+
   static const std::string HTTPS_PORT;
 
 protected:
@@ -41,22 +111,68 @@ protected:
 
   std::string run_query(const std::string& query) const;
 
+  std::vector<std::string>
+  run_queries(const std::vector<std::string>& queries) const;
+
+  // Parses in situ: string values in json_result point into
+  // json_content, which has to outlive it.
   void parse_response(rapidjson::Document& json_result,
-                      const std::string& json_content) const;
+                      std::string& json_content) const;
+
+  // Matrix queries are tiled into blocks of source locations once a
+  // single monolithic table request would get too big.
+  static constexpr std::size_t MAX_SINGLE_TABLE_SIZE = 2000;
+  static constexpr std::size_t TABLE_SOURCES_BLOCK_SIZE = 500;
+
+  // Chunks hit by a transient failure are retried with exponential
+  // backoff while completed ones are kept, see run_queries.
+  static constexpr unsigned MAX_CHUNK_ATTEMPTS = 3;
+  static constexpr std::chrono::milliseconds CHUNK_RETRY_DELAY{200};
 
   virtual std::string build_query(const std::vector<Location>& locations,
                                   const std::string& service,
                                   const std::string& extra_args = "") const = 0;
 
+  // Build a matrix query relating the nb_sources source ranks
+  // starting at first_source in sources to all ranks in targets.
+  virtual std::string
+  build_table_query(const std::vector<Location>& locations,
+                    const std::vector<Index>& sources,
+                    const std::vector<Index>& targets,
+                    std::size_t first_source,
+                    std::size_t nb_sources) const = 0;
+
   virtual void check_response(const rapidjson::Document& json_result,
                               const std::string& service) const = 0;
 
-  virtual Matrix<Cost>
-  get_matrix(const std::vector<Location>& locs) const override;
+  virtual Matrix<Cost> get_matrix(const std::vector<Location>& locs,
+                                  const std::vector<Index>& sources,
+                                  const std::vector<Index>& targets)
+    const override;
 
   virtual bool
   duration_value_is_null(const rapidjson::Value& matrix_entry) const = 0;
 
+  // Whether matrix entries in a table response are plain scalar
+  // durations (or null). Such responses can be streamed straight into
+  // the matrix without building a DOM, see get_matrix.
+  virtual bool durations_are_scalar() const;
+
+  // Whether the backend wants the next table response DOM-parsed so
+  // it can pick snapping handles for some of locs out of it, see
+  // collect_hints.
+  virtual bool wants_hint_collection(const std::vector<Location>& locs) const;
+
+  // Give backends a chance to store snapped location handles found in
+  // a DOM-parsed table response for reuse in later queries. Rows
+  // relate to the nb_sources ranks starting at first_source in
+  // sources and columns to targets, as in build_table_query.
+  virtual void collect_hints(const rapidjson::Document& json_result,
+                             const std::vector<Location>& locs,
+                             const std::vector<Index>& sources,
+                             const std::vector<Index>& targets,
+                             std::size_t first_source) const;
+
   virtual Cost
   get_duration_value(const rapidjson::Value& matrix_entry) const = 0;
 
@@ -70,6 +186,15 @@ protected:
   virtual std::string get_geometry(rapidjson::Value& result) const = 0;
 
   virtual void add_route_info(Route& route) const override;
+
+  virtual void add_route_infos(
+    std::vector<std::reference_wrapper<Route>>& routes) const override;
+
+  virtual void prefetch_route_infos(
+    const std::vector<std::reference_wrapper<Route>>& routes) const override;
+
+public:
+  virtual ~HttpWrapper();
 };
 
 } // namespace routing
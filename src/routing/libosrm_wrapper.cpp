@@ -7,6 +7,9 @@ All rights reserved (see LICENSE).
 
 */
 
+#include <mutex>
+#include <thread>
+
 #include "osrm/coordinate.hpp"
 #include "osrm/json_container.hpp"
 #include "osrm/route_parameters.hpp"
@@ -14,6 +17,7 @@ All rights reserved (see LICENSE).
 #include "osrm/table_parameters.hpp"
 
 #include "routing/libosrm_wrapper.h"
+#include "utils/thread_pool.h"
 
 namespace vroom {
 namespace routing {
@@ -33,7 +37,10 @@ LibosrmWrapper::LibosrmWrapper(const std::string& profile)
 }
 
 Matrix<Cost>
-LibosrmWrapper::get_matrix(const std::vector<Location>& locs) const {
+LibosrmWrapper::get_matrix(const std::vector<Location>& locs,
+                           const std::vector<Index>& sources,
+                           const std::vector<Index>& targets) const {
+  // Coordinates and targets shared by all table calls.
   osrm::TableParameters params;
   for (auto const& location : locs) {
     assert(location.has_coordinates());
@@ -41,23 +48,14 @@ LibosrmWrapper::get_matrix(const std::vector<Location>& locs) const {
       .emplace_back(osrm::util::FloatLongitude({location.lon()}),
                     osrm::util::FloatLatitude({location.lat()}));
   }
-
-  osrm::json::Object result;
-  osrm::Status status = _osrm.Table(params, result);
-
-  if (status == osrm::Status::Error) {
-    throw Exception(ERROR::ROUTING,
-                    "libOSRM: " +
-                      result.values["code"].get<osrm::json::String>().value +
-                      ": " +
-                      result.values["message"].get<osrm::json::String>().value);
+  if (targets.size() != locs.size()) {
+    for (const auto t : targets) {
+      params.destinations.push_back(t);
+    }
   }
 
-  auto& table = result.values["durations"].get<osrm::json::Array>();
-
   // Expected matrix size.
   std::size_t m_size = locs.size();
-  assert(table.values.size() == m_size);
 
   // Build matrix while checking for unfound routes to avoid
   // unexpected behavior (OSRM raises 'null').
@@ -66,23 +64,98 @@ LibosrmWrapper::get_matrix(const std::vector<Location>& locs) const {
   std::vector<unsigned> nb_unfound_from_loc(m_size, 0);
   std::vector<unsigned> nb_unfound_to_loc(m_size, 0);
 
-  std::string reason;
-  for (std::size_t i = 0; i < m_size; ++i) {
-    const auto& line = table.values.at(i).get<osrm::json::Array>();
-    assert(line.values.size() == m_size);
-    for (std::size_t j = 0; j < m_size; ++j) {
-      const auto& el = line.values.at(j);
-      if (el.is<osrm::json::Null>()) {
-        // No route found between i and j. Just storing info as we
-        // don't know yet which location is responsible between i
-        // and j.
-        ++nb_unfound_from_loc[i];
-        ++nb_unfound_to_loc[j];
-      } else {
-        auto cost = round_cost(el.get<osrm::json::Number>().value);
-        m[i][j] = cost;
+  // A monolithic Table call only gets limited internal parallelism
+  // from OSRM, so large matrices are sharded into blocks of source
+  // rows computed concurrently on the shared thread pool and
+  // assembled in place, the way remote backends get their tables in
+  // chunks.
+  constexpr std::size_t min_block_rows = 50;
+  const auto nb_blocks =
+    std::max<std::size_t>(1,
+                          std::min(static_cast<std::size_t>(
+                                     std::thread::hardware_concurrency()),
+                                   sources.size() / min_block_rows));
+
+  std::exception_ptr ep = nullptr;
+  std::mutex merge_mutex;
+
+  auto run_block = [&](std::size_t first, std::size_t nb) {
+    try {
+      osrm::TableParameters block_params = params;
+      if (nb_blocks > 1 or sources.size() != m_size) {
+        // Empty sources stand for all coordinates in the monolithic
+        // square case.
+        for (std::size_t s = first; s < first + nb; ++s) {
+          block_params.sources.push_back(sources[s]);
+        }
+      }
+
+      osrm::json::Object result;
+      osrm::Status status = _osrm.Table(block_params, result);
+
+      if (status == osrm::Status::Error) {
+        throw Exception(
+          ERROR::ROUTING,
+          "libOSRM: " +
+            result.values["code"].get<osrm::json::String>().value + ": " +
+            result.values["message"].get<osrm::json::String>().value);
+      }
+
+      auto& table = result.values["durations"].get<osrm::json::Array>();
+      assert(table.values.size() == nb);
+
+      // Target rows are exclusive to this block so they are filled
+      // lock-free, only the shared per-target counters need merging.
+      std::vector<unsigned> block_unfound_to_loc(m_size, 0);
+      bool any_unfound = false;
+
+      for (std::size_t i = 0; i < nb; ++i) {
+        const auto& line = table.values[i].get<osrm::json::Array>().values;
+        assert(line.size() == targets.size());
+        // Round-and-narrow straight into the flat matrix row, with
+        // the bounds-checked accessors out of the way.
+        Cost* row = m[sources[first + i]];
+        for (std::size_t j = 0; j < targets.size(); ++j) {
+          const auto& el = line[j];
+          if (!el.is<osrm::json::Null>()) {
+            row[targets[j]] = round_cost(el.get<osrm::json::Number>().value);
+          } else {
+            // No route found between sources[first + i] and
+            // targets[j]. Just storing info as we don't know yet
+            // which location is responsible.
+            ++nb_unfound_from_loc[sources[first + i]];
+            ++block_unfound_to_loc[targets[j]];
+            any_unfound = true;
+          }
+        }
+      }
+
+      if (any_unfound) {
+        std::lock_guard<std::mutex> guard(merge_mutex);
+        for (std::size_t j = 0; j < m_size; ++j) {
+          nb_unfound_to_loc[j] += block_unfound_to_loc[j];
+        }
       }
+    } catch (...) {
+      std::lock_guard<std::mutex> guard(merge_mutex);
+      ep = std::current_exception();
     }
+  };
+
+  if (nb_blocks < 2) {
+    run_block(0, sources.size());
+  } else {
+    const auto block_size = 1 + (sources.size() - 1) / nb_blocks;
+    std::vector<std::function<void()>> tasks;
+    for (std::size_t first = 0; first < sources.size(); first += block_size) {
+      const auto nb = std::min(block_size, sources.size() - first);
+      tasks.push_back([&run_block, first, nb]() { run_block(first, nb); });
+    }
+    utils::ThreadPool::instance().run(std::move(tasks));
+  }
+
+  if (ep != nullptr) {
+    std::rethrow_exception(ep);
   }
 
   check_unfound(locs, nb_unfound_from_loc, nb_unfound_to_loc);
@@ -187,5 +260,50 @@ void LibosrmWrapper::add_route_info(Route& route) const {
   }
 }
 
+void LibosrmWrapper::add_route_infos(
+  std::vector<std::reference_wrapper<Route>>& routes) const {
+  // The libosrm engine supports concurrent queries so geometries for
+  // a wide fleet can be retrieved in parallel instead of running one
+  // route query per vehicle in sequence.
+  const auto nb_buckets =
+    std::min(routes.size(),
+             static_cast<std::size_t>(std::thread::hardware_concurrency()));
+
+  if (nb_buckets < 2) {
+    for (auto& route : routes) {
+      add_route_info(route);
+    }
+    return;
+  }
+
+  std::exception_ptr ep = nullptr;
+  std::mutex ep_m;
+
+  auto run_on_bucket = [&](std::size_t bucket) {
+    try {
+      for (std::size_t i = bucket; i < routes.size(); i += nb_buckets) {
+        add_route_info(routes[i]);
+      }
+    } catch (...) {
+      ep_m.lock();
+      ep = std::current_exception();
+      ep_m.unlock();
+    }
+  };
+
+  std::vector<std::thread> route_threads;
+  for (std::size_t bucket = 0; bucket < nb_buckets; ++bucket) {
+    route_threads.emplace_back(run_on_bucket, bucket);
+  }
+
+  for (auto& t : route_threads) {
+    t.join();
+  }
+
+  if (ep != nullptr) {
+    std::rethrow_exception(ep);
+  }
+}
+
 } // namespace routing
 } // namespace vroom
@@ -29,10 +29,15 @@ private:
 public:
   LibosrmWrapper(const std::string& profile);
 
-  virtual Matrix<Cost>
-  get_matrix(const std::vector<Location>& locs) const override;
+  virtual Matrix<Cost> get_matrix(const std::vector<Location>& locs,
+                                  const std::vector<Index>& sources,
+                                  const std::vector<Index>& targets)
+    const override;
 
   virtual void add_route_info(Route& route) const override;
+
+  virtual void add_route_infos(
+    std::vector<std::reference_wrapper<Route>>& routes) const override;
 };
 
 } // namespace routing
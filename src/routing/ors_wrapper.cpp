@@ -49,10 +49,55 @@ std::string OrsWrapper::build_query(const std::vector<Location>& locations,
 
   query += " HTTP/1.0\r\n";
   query += "Accept: */*\r\n";
+  query += "Accept-Encoding: gzip, deflate\r\n";
   query += "Content-Type: application/json\r\n";
   query += "Content-Length: " + std::to_string(body.size()) + "\r\n";
   query += "Host: " + _server.host + ":" + _server.port + "\r\n";
-  query += "Connection: close\r\n";
+  query += "Connection: keep-alive\r\n";
+  query += "\r\n" + body;
+
+  return query;
+}
+
+std::string OrsWrapper::build_table_query(const std::vector<Location>& locations,
+                                          const std::vector<Index>& sources,
+                                          const std::vector<Index>& targets,
+                                          std::size_t first_source,
+                                          std::size_t nb_sources) const {
+  // Adding locations.
+  std::string body = "{\"locations\":[";
+  for (auto const& location : locations) {
+    body += "[" + std::to_string(location.lon()) + "," +
+            std::to_string(location.lat()) + "],";
+  }
+  body.pop_back(); // Remove trailing ','.
+
+  // Restrict sources to the current block.
+  body += "],\"sources\":[";
+  for (std::size_t s = first_source; s < first_source + nb_sources; ++s) {
+    body += std::to_string(sources[s]) + ",";
+  }
+  body.pop_back(); // Remove trailing ','.
+
+  if (targets.size() != locations.size()) {
+    body += "],\"destinations\":[";
+    for (const auto t : targets) {
+      body += std::to_string(t) + ",";
+    }
+    body.pop_back(); // Remove trailing ','.
+  }
+  body += "]}";
+
+  // Building query for ORS
+  std::string query = "POST /ors/v2/" + _matrix_service + "/" + profile;
+
+  query += " HTTP/1.0\r\n";
+  query += "Accept: */*\r\n";
+  query += "Accept-Encoding: gzip, deflate\r\n";
+  query += "Content-Type: application/json\r\n";
+  query += "Content-Length: " + std::to_string(body.size()) + "\r\n";
+  query += "Host: " + _server.host + ":" + _server.port + "\r\n";
+  query += "Connection: keep-alive\r\n";
   query += "\r\n" + body;
 
   return query;
@@ -76,6 +121,10 @@ Cost OrsWrapper::get_duration_value(
   return round_cost(matrix_entry.GetDouble());
 }
 
+bool OrsWrapper::durations_are_scalar() const {
+  return true;
+}
+
 double OrsWrapper::get_total_distance(const rapidjson::Value& result) const {
   return result["routes"][0]["summary"]["distance"].GetDouble();
 }
@@ -21,12 +21,20 @@ private:
                                   const std::string& service,
                                   const std::string& extra_args) const override;
 
+  virtual std::string build_table_query(const std::vector<Location>& locations,
+                                        const std::vector<Index>& sources,
+                                        const std::vector<Index>& targets,
+                                        std::size_t first_source,
+                                        std::size_t nb_sources) const override;
+
   virtual void check_response(const rapidjson::Document& json_result,
                               const std::string& service) const override;
 
   virtual bool
   duration_value_is_null(const rapidjson::Value& matrix_entry) const override;
 
+  virtual bool durations_are_scalar() const override;
+
   virtual Cost
   get_duration_value(const rapidjson::Value& matrix_entry) const override;
 
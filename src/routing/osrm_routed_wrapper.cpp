@@ -7,11 +7,40 @@ All rights reserved (see LICENSE).
 
 */
 
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+
 #include "routing/osrm_routed_wrapper.h"
 
 namespace vroom {
 namespace routing {
 
+namespace {
+
+// Hints are base64 and have to be percent-encoded to survive as a
+// query argument.
+std::string url_encode(const std::string& value) {
+  std::string encoded;
+  encoded.reserve(value.size());
+  for (const char c : value) {
+    if (std::isalnum(static_cast<unsigned char>(c)) or c == '-' or c == '_' or
+        c == '.' or c == '~') {
+      encoded += c;
+    } else {
+      char buf[4];
+      std::snprintf(buf,
+                    sizeof(buf),
+                    "%%%02X",
+                    static_cast<unsigned char>(c));
+      encoded += buf;
+    }
+  }
+  return encoded;
+}
+
+} // namespace
+
 OsrmRoutedWrapper::OsrmRoutedWrapper(const std::string& profile,
                                      const Server& server)
   : HttpWrapper(profile,
@@ -21,6 +50,83 @@ OsrmRoutedWrapper::OsrmRoutedWrapper(const std::string& profile,
                 "route",
                 "alternatives=false&steps=false&overview=full&continue_"
                 "straight=true") {
+  for (auto& entry : utils::load_cached_hints(profile)) {
+    _hints.emplace(entry.first, std::move(entry.second));
+  }
+}
+
+std::string
+OsrmRoutedWrapper::hints_arg(const std::vector<Location>& locations) const {
+  std::lock_guard<std::mutex> guard(_hints_mutex);
+
+  // The hints argument has to provide one (possibly empty) entry per
+  // coordinate.
+  bool any_hint = false;
+  std::string arg = "hints=";
+  for (const auto& location : locations) {
+    const auto search =
+      _hints.find(Coordinates({location.lon(), location.lat()}));
+    if (search != _hints.end()) {
+      arg += url_encode(search->second);
+      any_hint = true;
+    }
+    arg += ";";
+  }
+  arg.pop_back(); // Remove trailing ';'.
+
+  return any_hint ? arg : "";
+}
+
+bool OsrmRoutedWrapper::wants_hint_collection(
+  const std::vector<Location>& locs) const {
+  std::lock_guard<std::mutex> guard(_hints_mutex);
+  return std::any_of(locs.begin(), locs.end(), [&](const auto& location) {
+    return _hints.find(Coordinates({location.lon(), location.lat()})) ==
+           _hints.end();
+  });
+}
+
+void OsrmRoutedWrapper::collect_hints(const rapidjson::Document& json_result,
+                                      const std::vector<Location>& locs,
+                                      const std::vector<Index>& sources,
+                                      const std::vector<Index>& targets,
+                                      std::size_t first_source) const {
+  bool new_hints = false;
+
+  std::lock_guard<std::mutex> guard(_hints_mutex);
+
+  auto store = [&](const rapidjson::Value& waypoints,
+                   const auto& rank_of_entry) {
+    for (rapidjson::SizeType i = 0; i < waypoints.Size(); ++i) {
+      const auto& waypoint = waypoints[i];
+      if (!waypoint.IsObject() or !waypoint.HasMember("hint")) {
+        continue;
+      }
+      const auto& location = locs[rank_of_entry(i)];
+      new_hints |= _hints
+                     .emplace(Coordinates({location.lon(), location.lat()}),
+                              waypoint["hint"].GetString())
+                     .second;
+    }
+  };
+
+  if (json_result.HasMember("sources") and json_result["sources"].IsArray() and
+      json_result["sources"].Size() + first_source <= sources.size()) {
+    store(json_result["sources"],
+          [&](rapidjson::SizeType i) { return sources[first_source + i]; });
+  }
+  if (json_result.HasMember("destinations") and
+      json_result["destinations"].IsArray() and
+      json_result["destinations"].Size() <= targets.size()) {
+    store(json_result["destinations"],
+          [&](rapidjson::SizeType i) { return targets[i]; });
+  }
+
+  if (new_hints) {
+    std::vector<std::pair<Coordinates, std::string>> entries(_hints.begin(),
+                                                             _hints.end());
+    utils::save_cached_hints(profile, entries);
+  }
 }
 
 std::string
@@ -39,14 +145,70 @@ OsrmRoutedWrapper::build_query(const std::vector<Location>& locations,
   }
   query.pop_back(); // Remove trailing ';'.
 
-  if (!extra_args.empty()) {
-    query += "?" + extra_args;
+  std::string args = extra_args;
+  const auto hints = hints_arg(locations);
+  if (!hints.empty()) {
+    if (!args.empty()) {
+      args += "&";
+    }
+    args += hints;
+  }
+
+  if (!args.empty()) {
+    query += "?" + args;
   }
 
   query += " HTTP/1.1\r\n";
   query += "Host: " + _server.host + "\r\n";
   query += "Accept: */*\r\n";
-  query += "Connection: close\r\n\r\n";
+  query += "Accept-Encoding: gzip, deflate\r\n";
+  query += "Connection: keep-alive\r\n\r\n";
+
+  return query;
+}
+
+std::string
+OsrmRoutedWrapper::build_table_query(const std::vector<Location>& locations,
+                                     const std::vector<Index>& sources,
+                                     const std::vector<Index>& targets,
+                                     std::size_t first_source,
+                                     std::size_t nb_sources) const {
+  std::string query = "GET /" + _matrix_service;
+
+  query += "/v1/" + profile + "/";
+
+  // Adding locations.
+  for (auto const& location : locations) {
+    query += std::to_string(location.lon()) + "," +
+             std::to_string(location.lat()) + ";";
+  }
+  query.pop_back(); // Remove trailing ';'.
+
+  // Restrict sources to the current block.
+  query += "?sources=";
+  for (std::size_t s = first_source; s < first_source + nb_sources; ++s) {
+    query += std::to_string(sources[s]) + ";";
+  }
+  query.pop_back(); // Remove trailing ';'.
+
+  if (targets.size() != locations.size()) {
+    query += "&destinations=";
+    for (const auto t : targets) {
+      query += std::to_string(t) + ";";
+    }
+    query.pop_back(); // Remove trailing ';'.
+  }
+
+  const auto hints = hints_arg(locations);
+  if (!hints.empty()) {
+    query += "&" + hints;
+  }
+
+  query += " HTTP/1.1\r\n";
+  query += "Host: " + _server.host + "\r\n";
+  query += "Accept: */*\r\n";
+  query += "Accept-Encoding: gzip, deflate\r\n";
+  query += "Connection: keep-alive\r\n\r\n";
 
   return query;
 }
@@ -70,6 +232,10 @@ Cost OsrmRoutedWrapper::get_duration_value(
   return round_cost(matrix_entry.GetDouble());
 }
 
+bool OsrmRoutedWrapper::durations_are_scalar() const {
+  return true;
+}
+
 double
 OsrmRoutedWrapper::get_total_distance(const rapidjson::Value& result) const {
   return result["routes"][0]["distance"].GetDouble();
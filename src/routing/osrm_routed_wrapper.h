@@ -10,23 +10,56 @@ All rights reserved (see LICENSE).
 
 */
 
+#include <mutex>
+#include <unordered_map>
+
 #include "routing/http_wrapper.h"
+#include "utils/matrix_cache.h"
 
 namespace vroom {
 namespace routing {
 
 class OsrmRoutedWrapper : public HttpWrapper {
 private:
+  // Snapping hints keyed by coordinates, loaded from the persistent
+  // store next to the matrix cache and fed from table responses.
+  // Queries attach them so the server skips re-snapping known
+  // locations.
+  mutable std::mutex _hints_mutex;
+  mutable std::unordered_map<Coordinates, std::string, utils::CoordinatesHash>
+    _hints;
+
+  // Percent-encoded hints query argument covering all of locations,
+  // or an empty string when no hint is known yet.
+  std::string hints_arg(const std::vector<Location>& locations) const;
+
   virtual std::string build_query(const std::vector<Location>& locations,
                                   const std::string& service,
                                   const std::string& extra_args) const override;
 
+  virtual std::string build_table_query(const std::vector<Location>& locations,
+                                        const std::vector<Index>& sources,
+                                        const std::vector<Index>& targets,
+                                        std::size_t first_source,
+                                        std::size_t nb_sources) const override;
+
   virtual void check_response(const rapidjson::Document& json_result,
                               const std::string& service) const override;
 
   virtual bool
   duration_value_is_null(const rapidjson::Value& matrix_entry) const override;
 
+  virtual bool durations_are_scalar() const override;
+
+  virtual bool
+  wants_hint_collection(const std::vector<Location>& locs) const override;
+
+  virtual void collect_hints(const rapidjson::Document& json_result,
+                             const std::vector<Location>& locs,
+                             const std::vector<Index>& sources,
+                             const std::vector<Index>& targets,
+                             std::size_t first_source) const override;
+
   virtual Cost
   get_duration_value(const rapidjson::Value& matrix_entry) const override;
 
@@ -7,9 +7,8 @@ All rights reserved (see LICENSE).
 
 */
 
-#include "../../include/polylineencoder.h"
-
 #include "routing/valhalla_wrapper.h"
+#include "utils/polyline.h"
 
 namespace vroom {
 namespace routing {
@@ -44,7 +43,8 @@ std::string ValhallaWrapper::get_matrix_query(
   query += " HTTP/1.1\r\n";
   query += "Host: " + _server.host + "\r\n";
   query += "Accept: */*\r\n";
-  query += "Connection: Close\r\n\r\n";
+  query += "Accept-Encoding: gzip, deflate\r\n";
+  query += "Connection: keep-alive\r\n\r\n";
 
   return query;
 }
@@ -71,7 +71,48 @@ ValhallaWrapper::get_route_query(const std::vector<Location>& locations,
   query += " HTTP/1.1\r\n";
   query += "Host: " + _server.host + "\r\n";
   query += "Accept: */*\r\n";
-  query += "Connection: Close\r\n\r\n";
+  query += "Accept-Encoding: gzip, deflate\r\n";
+  query += "Connection: keep-alive\r\n\r\n";
+
+  return query;
+}
+
+std::string
+ValhallaWrapper::build_table_query(const std::vector<Location>& locations,
+                                   const std::vector<Index>& sources,
+                                   const std::vector<Index>& targets,
+                                   std::size_t first_source,
+                                   std::size_t nb_sources) const {
+  // Building matrix query restricted to a block of sources for
+  // Valhalla, which natively takes distinct source and target
+  // coordinate lists.
+  std::string query = "GET /" + _matrix_service + "?json=";
+
+  std::string target_locations;
+  for (const auto t : targets) {
+    target_locations += "{\"lon\":" + std::to_string(locations[t].lon()) +
+                        "," + "\"lat\":" + std::to_string(locations[t].lat()) +
+                        "},";
+  }
+  target_locations.pop_back(); // Remove trailing ','.
+
+  std::string source_locations;
+  for (std::size_t s = first_source; s < first_source + nb_sources; ++s) {
+    const auto& source = locations[sources[s]];
+    source_locations += "{\"lon\":" + std::to_string(source.lon()) + "," +
+                        "\"lat\":" + std::to_string(source.lat()) + "},";
+  }
+  source_locations.pop_back(); // Remove trailing ','.
+
+  query += "{\"sources\":[" + source_locations;
+  query += "],\"targets\":[" + target_locations;
+  query += "],\"costing\":\"" + profile + "\"}";
+
+  query += " HTTP/1.1\r\n";
+  query += "Host: " + _server.host + "\r\n";
+  query += "Accept: */*\r\n";
+  query += "Accept-Encoding: gzip, deflate\r\n";
+  query += "Connection: keep-alive\r\n\r\n";
 
   return query;
 }
@@ -155,27 +196,20 @@ std::string ValhallaWrapper::get_geometry(rapidjson::Value& result) const {
   // values, then we have to force allowing u-turns in order to get
   // consistent time/distance values between matrix and route request.
 
-  auto full_polyline = gepaf::PolylineEncoder<6>::decode(
-    result["trip"]["legs"][0]["shape"].GetString());
-
-  for (rapidjson::SizeType i = 1; i < result["trip"]["legs"].Size(); ++i) {
-    auto decoded_pts = gepaf::PolylineEncoder<6>::decode(
-      result["trip"]["legs"][i]["shape"].GetString());
-
-    if (!full_polyline.empty()) {
+  std::vector<std::array<int32_t, 2>> full_polyline;
+  const auto& legs = result["trip"]["legs"];
+  for (rapidjson::SizeType i = 0; i < legs.Size(); ++i) {
+    if (i > 0 and !full_polyline.empty()) {
+      // Consecutive legs share their joint point.
       full_polyline.pop_back();
     }
-    full_polyline.insert(full_polyline.end(),
-                         std::make_move_iterator(decoded_pts.begin()),
-                         std::make_move_iterator(decoded_pts.end()));
+    utils::polyline::decode(legs[i]["shape"].GetString(), full_polyline);
   }
 
-  gepaf::PolylineEncoder<5> encoder;
-  for (const auto& p : full_polyline) {
-    encoder.addPoint(p.latitude(), p.longitude());
-  }
+  // Switch from Valhalla's 6-digit precision to 5 digits.
+  utils::polyline::rescale(full_polyline, 10);
 
-  return encoder.encode();
+  return utils::polyline::encode(full_polyline);
 }
 
 } // namespace routing
@@ -26,6 +26,12 @@ private:
                                   const std::string& service,
                                   const std::string& extra_args) const override;
 
+  virtual std::string build_table_query(const std::vector<Location>& locations,
+                                        const std::vector<Index>& sources,
+                                        const std::vector<Index>& targets,
+                                        std::size_t first_source,
+                                        std::size_t nb_sources) const override;
+
   virtual void check_response(const rapidjson::Document& input,
                               const std::string& service) const override;
 
@@ -10,6 +10,7 @@ All rights reserved (see LICENSE).
 
 */
 
+#include <functional>
 #include <vector>
 
 #include "structures/generic/matrix.h"
@@ -25,10 +26,35 @@ class Wrapper {
 public:
   std::string profile;
 
-  virtual Matrix<Cost> get_matrix(const std::vector<Location>& locs) const = 0;
+  // Fetch a square locs-sized matrix, only filling rows for sources
+  // and columns for targets (both given as ranks in locs). Cells
+  // outside the requested rectangle are left zeroed and expected to
+  // never be read, e.g. rows departing from pure vehicle end
+  // locations.
+  virtual Matrix<Cost> get_matrix(const std::vector<Location>& locs,
+                                  const std::vector<Index>& sources,
+                                  const std::vector<Index>& targets) const = 0;
 
   virtual void add_route_info(Route& route) const = 0;
 
+  // Add route info for several routes at once. Implementations can
+  // override this to run the underlying queries concurrently.
+  virtual void
+  add_route_infos(std::vector<std::reference_wrapper<Route>>& routes) const {
+    for (auto& route : routes) {
+      add_route_info(route);
+    }
+  }
+
+  // Speculatively warm whatever add_route_infos will need for these
+  // routes, while solving still runs. Routes are left untouched. The
+  // default is a no-op, suitable for wrappers whose route queries
+  // are local and cheap.
+  virtual void prefetch_route_infos(
+    const std::vector<std::reference_wrapper<Route>>& routes) const {
+    (void)routes;
+  }
+
   virtual ~Wrapper() {
   }
 
@@ -14,15 +14,27 @@ All rights reserved (see LICENSE).
 namespace vroom {
 namespace io {
 
-const unsigned CLArgs::max_exploration_level = 5;
+const unsigned CLArgs::max_exploration_level = 6;
 
 // Default values.
 CLArgs::CLArgs()
-  : check(false),
+  : nb_alternatives(0),
+    check(false),
     geometry(false),
+    binary_output(false),
+    solution_cache(false),
     router(ROUTER::OSRM),
+    huge_pages(false),
+    memory_budget(0),
+    nice_value(0),
+    batch_scheduling(false),
     nb_threads(4),
-    exploration_level(5) {
+    plan_diff(false),
+    timeout(0),
+    sweep_rank(0),
+    sweep_count(1),
+    exploration_level(5),
+    compact_matrices(false) {
 }
 
 void update_host(Servers& servers, const std::string& value) {
@@ -24,15 +24,56 @@ using Servers = std::unordered_map<std::string, Server>;
 struct CLArgs {
   // Listing command-line options.
   Servers servers;                           // -a and -p
+  // Number of runner-up assignments to report next to the best
+  // solution as ready-made fallback plans, see
+  // Input::set_nb_alternatives.
+  unsigned nb_alternatives;                  // -A
   bool check;                                // -c
+  // Pin solver threads to these CPUs instead of spreading them over
+  // the whole machine, see utils::set_solver_cpus.
+  std::vector<unsigned> solver_cpus;         // -C
   std::vector<HeuristicParameters> h_params; // -e
   bool geometry;                             // -g
+  // Write route geometries to this separate file instead of inlining
+  // them in the solution document (implies -g).
+  std::string geometry_output_file;          // -G
+  // Write solutions in the compact binary format instead of json.
+  bool binary_output;                        // -f
+  // When not empty, lay the binary solution out in this POSIX shared
+  // memory segment and only write a descriptor to the output file.
+  std::string shm_output_name;               // -f shm:NAME
   std::string input_file;                    // -i
+  // Cache solutions by canonical input hash and reuse them on exact
+  // resubmissions, in server and batch modes.
+  bool solution_cache;                       // -k
   std::string output_file;                   // -o
   ROUTER router;                             // -r
+  // Checkpoint file making long solves restartable, see
+  // Input::set_checkpoint.
+  std::string checkpoint_file;               // -s
   std::string input;                         // cl arg
+  // Mutable buffer holding a memory-mapped input file, parsed in
+  // place when set instead of copying through input above.
+  char* mapped_input = nullptr;
+  bool huge_pages;                           // -m
+  // Memory budget in megabytes for solving state caches, zero
+  // meaning no limit. See Input::set_memory_budget.
+  unsigned memory_budget;                    // -M
+  // Niceness and scheduling class for solver threads, so background
+  // batch solves yield to interactive ones. See
+  // utils::set_solver_scheduling.
+  int nice_value;                            // -n
+  bool batch_scheduling;                     // -n batch[:NICE]
   unsigned nb_threads;                       // -t
+  // Only output routes changed from the warm-start assignment.
+  bool plan_diff;                            // -u
+  unsigned timeout;                          // -l, in seconds
+  // Rank of this process in a distributed parameter sweep and total
+  // number of participating processes, see scripts/sweep_solve.py.
+  unsigned sweep_rank;                       // -w RANK/COUNT
+  unsigned sweep_count;                      // -w RANK/COUNT
   unsigned exploration_level;                // -x
+  bool compact_matrices;                     // -z
 
   static const unsigned max_exploration_level;
 
@@ -0,0 +1,107 @@
+/*
+
+This file is part of VROOM.
+
+Copyright (c) 2015-2021, Julien Coupey.
+All rights reserved (see LICENSE).
+
+*/
+
+#include "structures/generic/flat_map.h"
+#include "structures/vroom/location.h"
+
+namespace vroom {
+
+template <class K, class V, class H> FlatMap<K, V, H>::FlatMap() : _size(0) {
+}
+
+template <class K, class V, class H>
+void FlatMap<K, V, H>::grow(std::size_t min_slots) {
+  std::size_t nb_slots = 8;
+  while (nb_slots < min_slots) {
+    nb_slots *= 2;
+  }
+  if (nb_slots <= _slots.size()) {
+    return;
+  }
+
+  auto previous_slots = std::move(_slots);
+  _slots = std::vector<std::optional<std::pair<K, V>>>(nb_slots);
+
+  for (auto& slot : previous_slots) {
+    if (slot.has_value()) {
+      auto rank = first_slot(slot.value().first);
+      while (_slots[rank].has_value()) {
+        rank = (rank + 1) & (_slots.size() - 1);
+      }
+      _slots[rank] = std::move(slot);
+    }
+  }
+}
+
+template <class K, class V, class H>
+void FlatMap<K, V, H>::reserve(std::size_t size) {
+  // Slot count covering size keys within the target load factor.
+  grow((10 * size) / 7 + 1);
+}
+
+template <class K, class V, class H>
+const std::pair<K, V>* FlatMap<K, V, H>::find(const K& key) const {
+  if (_slots.empty()) {
+    return nullptr;
+  }
+
+  auto rank = first_slot(key);
+  while (_slots[rank].has_value()) {
+    if (_slots[rank].value().first == key) {
+      return &_slots[rank].value();
+    }
+    rank = (rank + 1) & (_slots.size() - 1);
+  }
+  return nullptr;
+}
+
+template <class K, class V, class H>
+void FlatMap<K, V, H>::insert(std::pair<K, V> key_value) {
+  if (10 * (_size + 1) > 7 * _slots.size()) {
+    grow(2 * _slots.size());
+  }
+
+  auto rank = first_slot(key_value.first);
+  while (_slots[rank].has_value()) {
+    if (_slots[rank].value().first == key_value.first) {
+      // Matching std::unordered_map::insert, the mapped value is
+      // left untouched when the key is already present.
+      return;
+    }
+    rank = (rank + 1) & (_slots.size() - 1);
+  }
+
+  _slots[rank] = std::move(key_value);
+  ++_size;
+}
+
+template <class K, class V, class H>
+V& FlatMap<K, V, H>::operator[](const K& key) {
+  if (10 * (_size + 1) > 7 * _slots.size()) {
+    grow(2 * _slots.size());
+  }
+
+  auto rank = first_slot(key);
+  while (_slots[rank].has_value()) {
+    if (_slots[rank].value().first == key) {
+      return _slots[rank].value().second;
+    }
+    rank = (rank + 1) & (_slots.size() - 1);
+  }
+
+  _slots[rank] = std::make_pair(key, V());
+  ++_size;
+  return _slots[rank].value().second;
+}
+
+template class FlatMap<Id, Index>;
+template class FlatMap<Location, Index>;
+template class FlatMap<Skill, unsigned>;
+
+} // namespace vroom
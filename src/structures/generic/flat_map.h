@@ -0,0 +1,68 @@
+#ifndef FLAT_MAP_H
+#define FLAT_MAP_H
+
+/*
+
+This file is part of VROOM.
+
+Copyright (c) 2015-2021, Julien Coupey.
+All rights reserved (see LICENSE).
+
+*/
+
+#include <functional>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "structures/typedefs.h"
+
+namespace vroom {
+
+// Hash map with open addressing and linear probing. All slots live in
+// a single flat array, so lookups touch contiguous memory instead of
+// chasing one heap-allocated node per key like std::unordered_map
+// buckets do. Erasure is not supported, which is fine for the
+// write-once id-to-rank and location deduplication tables it backs.
+template <class K, class V, class H = std::hash<K>> class FlatMap {
+  // Power-of-two number of slots, grown whenever the load factor
+  // would exceed 70%.
+  std::vector<std::optional<std::pair<K, V>>> _slots;
+  std::size_t _size;
+
+  std::size_t first_slot(const K& key) const {
+    return H()(key) & (_slots.size() - 1);
+  }
+
+  void grow(std::size_t min_slots);
+
+public:
+  FlatMap();
+
+  // Pre-size the slot array for the expected number of keys so
+  // insertions don't trigger intermediate rehashes.
+  void reserve(std::size_t size);
+
+  // Pointer to the matching key/value pair, or end() if key is
+  // absent.
+  const std::pair<K, V>* find(const K& key) const;
+
+  const std::pair<K, V>* end() const {
+    return nullptr;
+  }
+
+  // Insert key/value pair unless key is already present, mirroring
+  // std::unordered_map::insert.
+  void insert(std::pair<K, V> key_value);
+
+  // Value for key, default-constructed on first access.
+  V& operator[](const K& key);
+
+  std::size_t size() const {
+    return _size;
+  }
+};
+
+} // namespace vroom
+
+#endif
@@ -7,38 +7,150 @@ All rights reserved (see LICENSE).
 
 */
 
+#include <algorithm>
+#include <cassert>
+
 #include "structures/generic/matrix.h"
+#include "utils/numa.h"
 
 namespace vroom {
 
-template <class T> Line<T>::Line(std::size_t n) : parent(n) {
+template <class T> Matrix<T>::Matrix(std::size_t n) : n(n), data(n * n) {
+  // Large matrices are randomly accessed all over during solving, so
+  // huge-page backing (when enabled) takes pressure off the dTLB.
+  utils::advise_huge_pages(data.data(), data.size() * sizeof(T));
 }
 
-template <class T> Line<T>::Line(std::initializer_list<T> l) : parent(l) {
+template <class T> Matrix<T>::Matrix() : Matrix(0) {
 }
 
-template <class T> Matrix<T>::Matrix(std::size_t n) : parent(n, Line<T>(n)) {
+template <class T>
+Matrix<T>::Matrix(std::initializer_list<std::initializer_list<T>> l)
+  : Matrix(l.size()) {
+  std::size_t i = 0;
+  for (const auto& line : l) {
+    assert(line.size() == n);
+    std::copy(line.begin(), line.end(), data.begin() + i * n);
+    ++i;
+  }
 }
 
-template <class T> Matrix<T>::Matrix() : Matrix(0) {
+template <class T>
+Matrix<T>::Matrix(const T* view_data,
+                  std::size_t n,
+                  std::shared_ptr<const void> backing)
+  : n(n), _view(view_data), _backing(std::move(backing)) {
 }
 
-template <class T>
-Matrix<T>::Matrix(std::initializer_list<Line<T>> l) : parent(l) {
+template <class T> void Matrix<T>::grow(std::size_t new_n) {
+  assert(n <= new_n);
+  if (new_n == n) {
+    return;
+  }
+
+  // New cells are zeroed until the caller fills them, so any previous
+  // symmetry detection no longer holds.
+  _symmetric = false;
+
+  if (_view != nullptr) {
+    // Copy-on-write: detach from the shared (or external) storage by
+    // re-materializing an owned copy before changing the layout.
+    data.assign(_view, _view + n * n);
+    _view = nullptr;
+    _backing.reset();
+  }
+
+  const std::size_t old_n = n;
+
+  if (data.capacity() < new_n * new_n) {
+    // Pad the fresh allocation so the next growth cycles relayout in
+    // place instead of copying everything again.
+    const std::size_t padded_n = new_n + new_n / 8;
+    std::vector<T> grown;
+    grown.reserve(padded_n * padded_n);
+    grown.resize(new_n * new_n);
+    for (std::size_t i = 0; i < old_n; ++i) {
+      std::copy(data.begin() + i * old_n,
+                data.begin() + (i + 1) * old_n,
+                grown.begin() + i * new_n);
+    }
+    data = std::move(grown);
+    utils::advise_huge_pages(data.data(), data.capacity() * sizeof(T));
+  } else {
+    data.resize(new_n * new_n);
+    // Relocate rows to the wider pitch from the last one down, so
+    // lower rows are still at their old offsets when read. Each
+    // destination row overlaps at most its own source, which
+    // copy_backward handles, and its zeroed tail stops right before
+    // the next relocated row.
+    for (std::size_t i = old_n; i-- > 0;) {
+      if (i > 0) {
+        std::copy_backward(data.begin() + i * old_n,
+                           data.begin() + (i + 1) * old_n,
+                           data.begin() + i * new_n + old_n);
+      }
+      std::fill(data.begin() + i * new_n + old_n,
+                data.begin() + (i + 1) * new_n,
+                T());
+    }
+  }
+
+  n = new_n;
 }
 
-template <class T>
-Matrix<T> Matrix<T>::get_sub_matrix(const std::vector<Index>& indices) const {
-  Matrix<T> sub_matrix(indices.size());
-  for (std::size_t i = 0; i < indices.size(); ++i) {
-    for (std::size_t j = 0; j < indices.size(); ++j) {
-      sub_matrix[i][j] = (*this)[indices[i]][indices[j]];
+template <class T> void Matrix<T>::detect_symmetry() {
+  const T* values = (_view != nullptr) ? _view : data.data();
+
+  _symmetric = true;
+  for (std::size_t i = 0; i < n and _symmetric; ++i) {
+    for (std::size_t j = i + 1; j < n; ++j) {
+      if (values[i * n + j] != values[j * n + i]) {
+        _symmetric = false;
+        break;
+      }
     }
   }
-  return sub_matrix;
 }
 
-template class Line<Cost>;
+template <class T> Matrix<T> Matrix<T>::share() {
+  if (_view == nullptr) {
+    // Promote owned storage to a shared buffer the first time, then
+    // read through it like any other sharer.
+    auto buffer = std::make_shared<std::vector<T>>(std::move(data));
+    data = std::vector<T>();
+    _view = buffer->data();
+    _backing = std::move(buffer);
+  }
+  auto shared = Matrix<T>(_view, n, _backing);
+  shared._symmetric = _symmetric;
+  return shared;
+}
+
+template <class T>
+MatrixView<T>::MatrixView(const Matrix<T>& parent, std::vector<Index> indices)
+  : _data(parent[0]), _parent_size(parent.size()), _indices(std::move(indices)) {
+}
+
+template <class T>
+MatrixView<T>::MatrixView(const T* data,
+                          std::size_t parent_size,
+                          std::vector<Index> indices)
+  : _data(data), _parent_size(parent_size), _indices(std::move(indices)) {
+}
+
+template <class T>
+MatrixView<T>
+MatrixView<T>::get_sub_view(const std::vector<Index>& indices) const {
+  std::vector<Index> remapped_indices;
+  std::transform(indices.cbegin(),
+                 indices.cend(),
+                 std::back_inserter(remapped_indices),
+                 [&](const auto i) { return _indices[i]; });
+  return MatrixView<T>(_data, _parent_size, std::move(remapped_indices));
+}
+
 template class Matrix<Cost>;
+template class Matrix<CompactCost>;
+template class MatrixView<Cost>;
 
 } // namespace vroom
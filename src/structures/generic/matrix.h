@@ -10,40 +10,116 @@ All rights reserved (see LICENSE).
 
 */
 
+#include <cassert>
 #include <initializer_list>
+#include <memory>
 
 #include "structures/typedefs.h"
 
 namespace vroom {
 
-template <class T> class Line : private std::vector<T> {
-
-  using parent = std::vector<T>;
+template <class T> class Matrix {
+  // Matrix data is stored in a flat row-major array: a single
+  // allocation keeps rows contiguous and cache-friendly. A matrix can
+  // alternatively wrap external read-only storage (e.g. a
+  // memory-mapped file): data is then left empty and _view points to
+  // the external array, kept alive by _backing.
+  std::size_t n;
+  std::vector<T> data;
+  const T* _view = nullptr;
+  std::shared_ptr<const void> _backing;
+  // Set by detect_symmetry, conservatively false until then. Mutating
+  // cells afterwards does not invalidate the flag, so callers writing
+  // to the matrix are expected to run the detection again.
+  bool _symmetric = false;
 
 public:
-  using parent::size;
-  using parent::operator[];
+  Matrix();
 
-  Line(std::size_t n);
+  Matrix(std::size_t n);
 
-  Line(std::initializer_list<T> l);
+  Matrix(std::initializer_list<std::initializer_list<T>> l);
+
+  // Read-only matrix on external row-major storage holding n * n
+  // values. The backing pointer owns whatever keeps view_data valid.
+  Matrix(const T* view_data, std::size_t n, std::shared_ptr<const void> backing);
+
+  T* operator[](std::size_t i) {
+    assert(_view == nullptr);
+    return data.data() + (i * n);
+  }
+  const T* operator[](std::size_t i) const {
+    return (_view != nullptr ? _view : data.data()) + (i * n);
+  }
+
+  T& operator()(std::size_t i, std::size_t j) {
+    assert(_view == nullptr);
+    return data[i * n + j];
+  }
+  const T& operator()(std::size_t i, std::size_t j) const {
+    return (_view != nullptr ? _view : data.data())[i * n + j];
+  }
+
+  std::size_t size() const {
+    return n;
+  }
+
+  bool is_view() const {
+    return _view != nullptr;
+  }
+
+  bool is_symmetric() const {
+    return _symmetric;
+  }
+
+  // Scan the matrix once and update the is_symmetric flag, run right
+  // after the values are set or fetched. Downstream users read the
+  // flag instead of re-deriving symmetry per subproblem, see the TSP
+  // constructor.
+  void detect_symmetry();
+
+  // Grow to new_n rows and columns in place, preserving existing
+  // values and zeroing new cells. Capacity headroom is reserved so
+  // repeated small growths (rolling-horizon inputs) do not
+  // reallocate every time. A view re-materializes owned storage
+  // first, so shared matrices grow copy-on-write.
+  void grow(std::size_t new_n);
+
+  // Move owned storage into a shared buffer, become a view of it and
+  // return a second view on the same buffer. Lets several Input
+  // instances read one fetched matrix without copying it, see
+  // Input::clone_with.
+  Matrix<T> share();
 };
 
-template <class T> class Matrix : private std::vector<Line<T>> {
-
-  using parent = std::vector<Line<T>>;
+// Non-owning view on a square sub-matrix of a parent Matrix<T>. Reads
+// go straight through to the parent data using an index remap, so no
+// copy is ever materialized. The parent matrix is expected to outlive
+// the view.
+template <class T> class MatrixView {
+  const T* _data;
+  std::size_t _parent_size;
+  std::vector<Index> _indices;
 
 public:
-  using parent::size;
-  using parent::operator[];
+  MatrixView(const Matrix<T>& parent, std::vector<Index> indices);
 
-  Matrix();
+  const T& operator()(std::size_t i, std::size_t j) const {
+    return _data[_indices[i] * _parent_size + _indices[j]];
+  }
 
-  Matrix(std::size_t n);
+  std::size_t size() const {
+    return _indices.size();
+  }
 
-  Matrix(std::initializer_list<Line<T>> l);
+  // Compose remaps so a view on a view still reads directly from the
+  // original parent data.
+  MatrixView<T> get_sub_view(const std::vector<Index>& indices) const;
 
-  Matrix<T> get_sub_matrix(const std::vector<Index>& indices) const;
+private:
+  MatrixView(const T* data,
+             std::size_t parent_size,
+             std::vector<Index> indices);
 };
 
 } // namespace vroom
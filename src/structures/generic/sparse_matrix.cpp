@@ -0,0 +1,58 @@
+/*
+
+This file is part of VROOM.
+
+Copyright (c) 2015-2021, Julien Coupey.
+All rights reserved (see LICENSE).
+
+*/
+
+#include <algorithm>
+#include <cassert>
+
+#include "structures/generic/sparse_matrix.h"
+
+namespace vroom {
+
+template <class T>
+SparseMatrix<T>::SparseMatrix() : n(0), _row_offsets(1, 0), _fallback(0) {
+}
+
+template <class T>
+SparseMatrix<T>::SparseMatrix(std::size_t size,
+                              T fallback,
+                              std::vector<std::tuple<Index, Index, T>>&&
+                                entries)
+  : n(size), _fallback(fallback) {
+  std::sort(entries.begin(), entries.end(), [](const auto& lhs,
+                                               const auto& rhs) {
+    return std::tie(std::get<0>(lhs), std::get<1>(lhs)) <
+           std::tie(std::get<0>(rhs), std::get<1>(rhs));
+  });
+
+  assert(std::adjacent_find(entries.begin(),
+                            entries.end(),
+                            [](const auto& lhs, const auto& rhs) {
+                              return std::get<0>(lhs) == std::get<0>(rhs) and
+                                     std::get<1>(lhs) == std::get<1>(rhs);
+                            }) == entries.end());
+
+  _row_offsets.assign(n + 1, 0);
+  _columns.reserve(entries.size());
+  _values.reserve(entries.size());
+
+  for (const auto& [i, j, value] : entries) {
+    assert(i < n and j < n);
+    ++_row_offsets[i + 1];
+    _columns.push_back(j);
+    _values.push_back(value);
+  }
+
+  for (std::size_t i = 0; i < n; ++i) {
+    _row_offsets[i + 1] += _row_offsets[i];
+  }
+}
+
+template class SparseMatrix<Cost>;
+
+} // namespace vroom
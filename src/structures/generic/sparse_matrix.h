@@ -0,0 +1,107 @@
+#ifndef SPARSE_MATRIX_H
+#define SPARSE_MATRIX_H
+
+/*
+
+This file is part of VROOM.
+
+Copyright (c) 2015-2021, Julien Coupey.
+All rights reserved (see LICENSE).
+
+*/
+
+#include <tuple>
+#include <vector>
+
+#include "structures/typedefs.h"
+
+namespace vroom {
+
+// Square matrix storing only explicitly provided cells, meant for
+// depot-centric instances where depot<->job and job<->near-job values
+// are known but the full n^2 table would not fit in memory. Cells are
+// held in compressed sparse row form with columns sorted per row, and
+// reading an absent pair returns a caller-provided fallback bound, so
+// lookups outside the provided neighborhoods stay valid (if
+// pessimistic) instead of being undefined.
+template <class T> class SparseMatrix {
+  std::size_t n;
+  // Row i spans ranks [_row_offsets[i], _row_offsets[i + 1]) in the
+  // flat column and value arrays.
+  std::vector<std::size_t> _row_offsets;
+  std::vector<Index> _columns;
+  std::vector<T> _values;
+  T _fallback;
+
+public:
+  SparseMatrix();
+
+  // Build from explicit (i, j, value) entries, consumed and sorted
+  // into row-major form. Any pair not listed reads back as fallback.
+  // Entry indices are expected to be lower than n and duplicate
+  // pairs are not allowed.
+  SparseMatrix(std::size_t n,
+               T fallback,
+               std::vector<std::tuple<Index, Index, T>>&& entries);
+
+  T operator()(Index i, Index j) const {
+    // Binary search within the row neighborhood: provided rows are
+    // expected to be short relative to n, so the search stays within
+    // a cache line or two.
+    std::size_t low = _row_offsets[i];
+    std::size_t high = _row_offsets[i + 1];
+    while (low < high) {
+      const std::size_t mid = (low + high) / 2;
+      if (_columns[mid] < j) {
+        low = mid + 1;
+      } else {
+        high = mid;
+      }
+    }
+    return (low < _row_offsets[i + 1] and _columns[low] == j) ? _values[low]
+                                                              : _fallback;
+  }
+
+  std::size_t size() const {
+    return n;
+  }
+
+  std::size_t nb_entries() const {
+    return _values.size();
+  }
+
+  T fallback() const {
+    return _fallback;
+  }
+
+  bool row_is_full(Index i) const {
+    return _row_offsets[i + 1] - _row_offsets[i] == n;
+  }
+
+  // Hint the cache to pull in the row descriptor and the start of its
+  // neighborhood.
+  void prefetch_row(Index i) const {
+#ifdef __GNUC__
+    __builtin_prefetch(_row_offsets.data() + i, 0);
+    __builtin_prefetch(_columns.data() + _row_offsets[i], 0);
+#else
+    (void)i;
+#endif
+  }
+
+  const std::vector<std::size_t>& row_offsets() const {
+    return _row_offsets;
+  }
+
+  const std::vector<Index>& columns() const {
+    return _columns;
+  }
+
+  const std::vector<T>& values() const {
+    return _values;
+  }
+};
+
+} // namespace vroom
+
+#endif
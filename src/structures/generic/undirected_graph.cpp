@@ -6,15 +6,15 @@ Copyright (c) 2015-2021, Julien Coupey.
 All rights reserved (see LICENSE).
 
 */
+#include <algorithm>
 #include <cassert>
-#include <iterator>
 
 #include "structures/generic/undirected_graph.h"
 
 namespace vroom {
 namespace utils {
 
-template <class T> UndirectedGraph<T>::UndirectedGraph() {
+template <class T> UndirectedGraph<T>::UndirectedGraph() : _size(0) {
 }
 
 template <class T>
@@ -22,11 +22,7 @@ UndirectedGraph<T>::UndirectedGraph(const Matrix<T>& m) : _size(m.size()) {
 #ifndef NDEBUG
   bool matrix_ok = true;
 #endif
-  _edges.reserve(_size * _size);
-  _adjacency_list.reserve(_size);
-  for (Index i = 0; i < _size; ++i) {
-    _adjacency_list[i].reserve(_size);
-  }
+  _edges.reserve((_size * (_size - 1)) / 2);
   for (Index i = 0; i < _size; ++i) {
 #ifndef NDEBUG
     matrix_ok = matrix_ok && (m[i][i] == INFINITE_COST);
@@ -36,44 +32,82 @@ UndirectedGraph<T>::UndirectedGraph(const Matrix<T>& m) : _size(m.size()) {
       matrix_ok = matrix_ok && (m[i][j] == m[j][i]);
 #endif
       _edges.emplace_back(i, j, m[i][j]);
-      _adjacency_list[i].push_back(j);
-      _adjacency_list[j].push_back(i);
     }
   }
   assert(matrix_ok);
+
+  build_adjacencies();
 }
 
 template <class T>
 UndirectedGraph<T>::UndirectedGraph(std::vector<Edge<T>> edges)
   : _edges{std::move(edges)} {
-  for (auto const& edge : _edges) {
+  build_adjacencies();
+
+  _size = 0;
+  for (Index v = 0; v < nb_vertices(); ++v) {
+    if (degree(v) > 0) {
+      ++_size;
+    }
+  }
+}
+
+template <class T> void UndirectedGraph<T>::build_adjacencies() {
+  std::size_t nb_slots = 0;
+  for (const auto& edge : _edges) {
+    // Relies on first_vertex < second_vertex (see edge ctor).
+    nb_slots = std::max<std::size_t>(nb_slots, edge.get_second_vertex() + 1);
+  }
+
+  // Counting pass, then turning degrees into start offsets so filling
+  // happens in a single allocation-free pass over the edges.
+  _adjacency_starts.assign(nb_slots + 1, 0);
+  for (const auto& edge : _edges) {
+    ++_adjacency_starts[edge.get_first_vertex() + 1];
+    ++_adjacency_starts[edge.get_second_vertex() + 1];
+  }
+  for (std::size_t v = 1; v <= nb_slots; ++v) {
+    _adjacency_starts[v] += _adjacency_starts[v - 1];
+  }
+
+  _adjacencies.resize(2 * _edges.size());
+  std::vector<std::size_t> next_slot(_adjacency_starts.begin(),
+                                     _adjacency_starts.end() - 1);
+  for (const auto& edge : _edges) {
     Index first = edge.get_first_vertex();
     Index second = edge.get_second_vertex();
 
-    _adjacency_list[first].push_back(second);
-    _adjacency_list[second].push_back(first);
+    _adjacencies[next_slot[first]++] = second;
+    _adjacencies[next_slot[second]++] = first;
   }
-  _size = _adjacency_list.size();
 }
 
 template <class T> std::size_t UndirectedGraph<T>::size() const {
   return _size;
 }
 
-template <class T> std::vector<Edge<T>> UndirectedGraph<T>::get_edges() const {
+template <class T> std::size_t UndirectedGraph<T>::nb_vertices() const {
+  return _adjacency_starts.size() - 1;
+}
+
+template <class T> unsigned UndirectedGraph<T>::degree(Index v) const {
+  assert(static_cast<std::size_t>(v) + 1 < _adjacency_starts.size());
+  return _adjacency_starts[v + 1] - _adjacency_starts[v];
+}
+
+template <class T>
+const std::vector<Edge<T>>& UndirectedGraph<T>::get_edges() const {
   return _edges;
 }
 
 template <class T>
-std::unordered_map<Index, std::list<Index>>
-UndirectedGraph<T>::get_adjacency_list() const {
-  std::unordered_map<Index, std::list<Index>> result;
-  for (const auto& pair : _adjacency_list) {
-    std::copy(pair.second.begin(),
-              pair.second.end(),
-              std::back_inserter(result[pair.first]));
-  }
-  return result;
+const std::vector<std::size_t>& UndirectedGraph<T>::adjacency_starts() const {
+  return _adjacency_starts;
+}
+
+template <class T>
+const std::vector<Index>& UndirectedGraph<T>::adjacencies() const {
+  return _adjacencies;
 }
 
 template class UndirectedGraph<Cost>;
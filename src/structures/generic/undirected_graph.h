@@ -10,8 +10,6 @@ All rights reserved (see LICENSE).
 
 */
 
-#include <unordered_map>
-
 #include "structures/generic/edge.h"
 #include "structures/generic/matrix.h"
 
@@ -25,7 +23,14 @@ private:
   // Embedding two representations for different uses depending on
   // context.
   std::vector<Edge<T>> _edges;
-  std::unordered_map<Index, std::vector<Index>> _adjacency_list;
+  // Compact adjacency storage: neighbours of vertex v are
+  // _adjacencies[_adjacency_starts[v]; _adjacency_starts[v + 1]), in
+  // edge insertion order. Both vectors are allocated in one shot from
+  // the known degrees.
+  std::vector<std::size_t> _adjacency_starts;
+  std::vector<Index> _adjacencies;
+
+  void build_adjacencies();
 
 public:
   UndirectedGraph();
@@ -34,11 +39,20 @@ public:
 
   UndirectedGraph(std::vector<Edge<T>> edges);
 
+  // Number of non-isolated vertices.
   std::size_t size() const;
 
-  std::vector<Edge<T>> get_edges() const;
+  // Number of adjacency slots, covering all vertices up to the
+  // biggest one mentioned in an edge.
+  std::size_t nb_vertices() const;
+
+  unsigned degree(Index v) const;
+
+  const std::vector<Edge<T>>& get_edges() const;
+
+  const std::vector<std::size_t>& adjacency_starts() const;
 
-  std::unordered_map<Index, std::list<Index>> get_adjacency_list() const;
+  const std::vector<Index>& adjacencies() const;
 };
 
 } // namespace utils
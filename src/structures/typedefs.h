@@ -11,6 +11,8 @@ All rights reserved (see LICENSE).
 */
 
 #include <array>
+#include <chrono>
+#include <functional>
 #include <limits>
 #include <list>
 #include <optional>
@@ -27,10 +29,25 @@ namespace vroom {
 
 // To easily differentiate variable types.
 using Id = uint64_t;
+// 16-bit indices keep matrices and routes compact for the common
+// case. Building with LARGER_INDICES=true lifts the 65,535 locations
+// limit for national-scale instances.
+#ifdef LARGER_INDICES
+using Index = uint32_t;
+#else
 using Index = uint16_t;
+#endif
 using Cost = uint32_t;
+// Cell type of compressed duration matrices, see CostWrapper.
+using CompactCost = uint16_t;
 using Gain = int64_t;
+// Gain type of the narrow scan kernels, usable when checked input
+// bounds guarantee intermediate gains fit, see
+// Input::gains_fit_32bit.
+using NarrowGain = int32_t;
 using Distance = uint32_t;
+// Optional wall-clock limit for the solving phase.
+using Deadline = std::optional<std::chrono::high_resolution_clock::time_point>;
 using Duration = uint32_t;
 using Coordinate = double;
 using Capacity = int64_t;
@@ -42,6 +59,38 @@ using Coordinates = std::array<Coordinate, 2>;
 using OptionalCoordinates = std::optional<Coordinates>;
 using Skills = std::unordered_set<Skill>;
 
+// Local search operator families, used for effectiveness counters.
+enum class OPERATOR {
+  UNASSIGNED_EXCHANGE,
+  EXCHANGE,
+  CROSS_EXCHANGE,
+  MIXED_EXCHANGE,
+  TWO_OPT,
+  REVERSE_TWO_OPT,
+  RELOCATE,
+  OR_OPT,
+  INTRA_EXCHANGE,
+  INTRA_CROSS_EXCHANGE,
+  INTRA_MIXED_EXCHANGE,
+  INTRA_RELOCATE,
+  INTRA_OR_OPT,
+  PD_SHIFT,
+  ROUTE_EXCHANGE
+};
+
+// Live search progress reporting.
+enum class SEARCH_EVENT { IMPROVEMENT, LS_STEP, JOB_REMOVAL, PLATEAU };
+
+struct SearchProgress {
+  SEARCH_EVENT event;
+  Cost cost;
+  unsigned unassigned;
+  // Elapsed time since input loading started.
+  std::chrono::milliseconds elapsed;
+};
+
+using ProgressCallback = std::function<void(const SearchProgress&)>;
+
 // Setting max value would cause trouble with further additions.
 constexpr Cost INFINITE_COST = 3 * (std::numeric_limits<Cost>::max() / 4);
 
@@ -50,7 +99,7 @@ const std::string DEFAULT_PROFILE = "car";
 constexpr Priority MAX_PRIORITY = 100;
 
 // Available routing engines.
-enum class ROUTER { OSRM, LIBOSRM, ORS, VALHALLA };
+enum class ROUTER { OSRM, LIBOSRM, ORS, VALHALLA, HAVERSINE };
 
 // Used to describe a routing server.
 struct Server {
@@ -76,7 +125,7 @@ enum class JOB_TYPE { SINGLE, PICKUP, DELIVERY };
 enum class STEP_TYPE { START, JOB, BREAK, END };
 
 // Heuristic options.
-enum class HEURISTIC { BASIC, DYNAMIC };
+enum class HEURISTIC { BASIC, DYNAMIC, BEAM, GIANT_TOUR };
 enum class INIT { NONE, HIGHER_AMOUNT, NEAREST, FURTHEST, EARLIEST_DEADLINE };
 
 struct HeuristicParameters {
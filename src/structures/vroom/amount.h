@@ -13,6 +13,10 @@ All rights reserved (see LICENSE).
 #include <cassert>
 #include <vector>
 
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
 #include "structures/typedefs.h"
 
 namespace vroom {
@@ -56,6 +60,9 @@ bool operator<=(const AmountExpression<E1>& lhs,
                 const AmountExpression<E2>& rhs) {
   bool is_inf = true;
   assert(lhs.size() == rhs.size());
+  if (lhs.size() == 1) {
+    return lhs[0] <= rhs[0];
+  }
   for (std::size_t i = 0; i < lhs.size(); ++i) {
     if (lhs[i] > rhs[i]) {
       is_inf = false;
@@ -82,39 +89,76 @@ bool operator==(const AmountExpression<E1>& lhs,
 }
 
 class Amount : public AmountExpression<Amount> {
-
-  std::vector<Capacity> elems;
+  // Amounts are small (a handful of components in practice) and are
+  // created in bulk inside insertion-evaluation loops, so components
+  // are stored in-object up to INLINE_SIZE and only spill to a
+  // heap-backed vector beyond that.
+  static constexpr std::size_t INLINE_SIZE = 4;
+
+  std::size_t _size;
+  std::array<Capacity, INLINE_SIZE> _inline_elems;
+  std::vector<Capacity> _spilled_elems;
+
+  bool is_inline() const {
+    return _size <= INLINE_SIZE;
+  }
 
 public:
-  Amount() = default;
+  Amount() : _size(0), _inline_elems{} {
+  }
 
-  Amount(std::size_t size) : elems(size, 0){};
+  Amount(std::size_t size) : _size(size), _inline_elems{} {
+    if (!is_inline()) {
+      _spilled_elems.assign(_size, 0);
+    }
+  }
 
-  template <typename E> Amount(const AmountExpression<E>& u) {
-    elems.resize(u.size());
-    for (std::size_t i = 0; i < u.size(); ++i) {
+  template <typename E> Amount(const AmountExpression<E>& u) : Amount(u.size()) {
+    auto* elems = is_inline() ? _inline_elems.data() : _spilled_elems.data();
+    for (std::size_t i = 0; i < _size; ++i) {
       elems[i] = u[i];
     }
   }
 
   void push_back(Capacity c) {
-    elems.push_back(c);
+    if (_size < INLINE_SIZE) {
+      _inline_elems[_size] = c;
+    } else {
+      if (_size == INLINE_SIZE) {
+        // Spill inline components on first growth beyond the inline
+        // buffer.
+        _spilled_elems.assign(_inline_elems.begin(), _inline_elems.end());
+      }
+      _spilled_elems.push_back(c);
+    }
+    ++_size;
   };
 
   Capacity operator[](std::size_t i) const {
-    return elems[i];
+    return is_inline() ? _inline_elems[i] : _spilled_elems[i];
   };
 
   Capacity& operator[](std::size_t i) {
-    return elems[i];
+    return is_inline() ? _inline_elems[i] : _spilled_elems[i];
+  };
+
+  const Capacity* data() const {
+    return is_inline() ? _inline_elems.data() : _spilled_elems.data();
   };
 
   std::size_t size() const {
-    return elems.size();
+    return _size;
   };
 
+  // In-place updates mirror the single-component fast path of the
+  // comparison kernels below: one add with no loop setup for the
+  // common one-dimension case.
   Amount& operator+=(const Amount& rhs) {
     assert(this->size() == rhs.size());
+    if (_size == 1) {
+      _inline_elems[0] += rhs._inline_elems[0];
+      return *this;
+    }
     for (std::size_t i = 0; i < this->size(); ++i) {
       (*this)[i] += rhs[i];
     }
@@ -123,6 +167,10 @@ public:
 
   Amount& operator-=(const Amount& rhs) {
     assert(this->size() == rhs.size());
+    if (_size == 1) {
+      _inline_elems[0] -= rhs._inline_elems[0];
+      return *this;
+    }
     for (std::size_t i = 0; i < this->size(); ++i) {
       (*this)[i] -= rhs[i];
     }
@@ -130,6 +178,70 @@ public:
   }
 };
 
+// Comparisons on concrete amounts are hot in capacity feasibility
+// checks, so they get a vectorized kernel handling 4 components per
+// iteration when AVX2 is available at build time. The trailing (or
+// non-AVX2) components use the scalar loop. Single-component amounts
+// are by far the most common case in practice and branch straight to
+// one integer compare, skipping the loop setup entirely.
+inline bool operator<=(const Amount& lhs, const Amount& rhs) {
+  assert(lhs.size() == rhs.size());
+  if (lhs.size() == 1) {
+    return lhs.data()[0] <= rhs.data()[0];
+  }
+  std::size_t i = 0;
+#ifdef __AVX2__
+  for (; i + 4 <= lhs.size(); i += 4) {
+    const __m256i l =
+      _mm256_loadu_si256(reinterpret_cast<const __m256i*>(lhs.data() + i));
+    const __m256i r =
+      _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rhs.data() + i));
+    if (_mm256_movemask_epi8(_mm256_cmpgt_epi64(l, r)) != 0) {
+      return false;
+    }
+  }
+#endif
+  for (; i < lhs.size(); ++i) {
+    if (lhs[i] > rhs[i]) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+// Fused check for lhs + delta <= bound, avoiding a temporary sum in
+// capacity checks against vehicle capacity.
+inline bool add_le(const Amount& lhs, const Amount& delta, const Amount& bound) {
+  assert(lhs.size() == delta.size());
+  assert(lhs.size() == bound.size());
+  if (lhs.size() == 1) {
+    return lhs.data()[0] + delta.data()[0] <= bound.data()[0];
+  }
+  std::size_t i = 0;
+#ifdef __AVX2__
+  for (; i + 4 <= lhs.size(); i += 4) {
+    const __m256i l =
+      _mm256_loadu_si256(reinterpret_cast<const __m256i*>(lhs.data() + i));
+    const __m256i d =
+      _mm256_loadu_si256(reinterpret_cast<const __m256i*>(delta.data() + i));
+    const __m256i b =
+      _mm256_loadu_si256(reinterpret_cast<const __m256i*>(bound.data() + i));
+    if (_mm256_movemask_epi8(_mm256_cmpgt_epi64(_mm256_add_epi64(l, d), b)) !=
+        0) {
+      return false;
+    }
+  }
+#endif
+  for (; i < lhs.size(); ++i) {
+    if (lhs[i] + delta[i] > bound[i]) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
 template <typename E1, typename E2>
 class AmountSum : public AmountExpression<AmountSum<E1, E2>> {
   const E1& lhs;
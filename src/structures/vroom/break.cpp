@@ -15,7 +15,7 @@ namespace vroom {
 Break::Break(Id id,
              const std::vector<TimeWindow>& tws,
              Duration service,
-             const std::string& description)
+             std::string_view description)
   : id(id), tws(tws), service(service), description(description) {
   utils::check_tws(tws);
 }
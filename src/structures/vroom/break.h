@@ -10,7 +10,7 @@ All rights reserved (see LICENSE).
 
 */
 
-#include <string>
+#include <string_view>
 
 #include "structures/typedefs.h"
 #include "structures/vroom/time_window.h"
@@ -21,12 +21,14 @@ struct Break {
   Id id;
   std::vector<TimeWindow> tws;
   Duration service;
-  std::string description;
+  // Non-owning view into the input buffer, which outlives the
+  // problem instance, see io::parse.
+  std::string_view description;
 
   Break(Id id,
         const std::vector<TimeWindow>& tws,
         Duration service = 0,
-        const std::string& description = "");
+        std::string_view description = "");
 
   bool is_valid_start(Duration time) const;
 };
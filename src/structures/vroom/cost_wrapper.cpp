@@ -15,8 +15,42 @@ CostWrapper::CostWrapper(double speed_factor)
   : durations_factor(1. / speed_factor) {
 }
 
+namespace {
+bool compact_durations = false;
+} // namespace
+
+void enable_compact_durations(bool enable) {
+  compact_durations = enable;
+}
+
+bool compact_durations_enabled() {
+  return compact_durations;
+}
+
 void CostWrapper::set_durations_matrix(const Matrix<Cost>* matrix) {
-  durations_matrix = matrix;
+  durations_matrix_size = matrix->size();
+  durations_data = (*matrix)[0];
+  symmetric_durations = matrix->is_symmetric();
+}
+
+void CostWrapper::set_compact_durations_matrix(
+  const Matrix<CompactCost>* matrix) {
+  assert(matrix->size() == durations_matrix_size);
+  compact_durations_data = (*matrix)[0];
+}
+
+void CostWrapper::set_duration_rows(const Cost* const* rows) {
+  duration_rows = rows;
+  symmetric_durations = false;
+}
+
+void CostWrapper::set_sparse_durations_matrix(
+  const SparseMatrix<Cost>* matrix) {
+  durations_matrix_size = matrix->size();
+  sparse_durations = matrix;
+  // Absent pairs read back as an asymmetric mix of stored values and
+  // the fallback bound, so no symmetry is ever assumed.
+  symmetric_durations = false;
 }
 
 } // namespace vroom
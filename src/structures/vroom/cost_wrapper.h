@@ -11,17 +11,106 @@ All rights reserved (see LICENSE).
 */
 
 #include "structures/generic/matrix.h"
+#include "structures/generic/sparse_matrix.h"
 #include "structures/typedefs.h"
 
 namespace vroom {
 
+// Process-wide opt-in for 16-bit duration storage, off by default
+// (see -z command-line flag).
+void enable_compact_durations(bool enable);
+bool compact_durations_enabled();
+
 struct CostWrapper {
-  const double durations_factor;
-  const Matrix<Cost>* durations_matrix;
+  double durations_factor;
+
+  std::size_t durations_matrix_size;
+  const Cost* durations_data;
+  // When not null, points to a 16-bit copy of the durations matrix
+  // halving the cache footprint of cost lookups. Only set when all
+  // matrix values fit, see Input::compact_matrices.
+  const CompactCost* compact_durations_data = nullptr;
+  // When not null, a per-row view of the durations matrix with
+  // sparse cell replacements applied once up front, so lookups stay a
+  // single fused access. Only set for vehicles on a derived profile
+  // with overrides, see Input::DerivedProfile.
+  const Cost* const* duration_rows = nullptr;
+  // When not null, durations come from a sparse matrix storing only
+  // the provided neighborhoods and answering absent pairs with a
+  // fallback bound, see Input::set_sparse_matrix. Exclusive with the
+  // dense layouts above.
+  const SparseMatrix<Cost>* sparse_durations = nullptr;
+  // Whether durations are known symmetric, taken from the durations
+  // matrix detection flag. The scalar factor above preserves
+  // symmetry but sparse overrides do not, so setting override rows
+  // clears the flag. Lets TSP skip its per-subproblem symmetry scan,
+  // see the TSP constructor.
+  bool symmetric_durations = false;
 
   CostWrapper(double speed_factor);
 
   void set_durations_matrix(const Matrix<Cost>* matrix);
+
+  void set_compact_durations_matrix(const Matrix<CompactCost>* matrix);
+
+  void set_duration_rows(const Cost* const* rows);
+
+  void set_sparse_durations_matrix(const SparseMatrix<Cost>* matrix);
+
+  // Fold a derived-profile scale on top of the speed factor.
+  void scale_durations(double factor) {
+    durations_factor *= factor;
+  }
+
+  bool is_compact() const {
+    return compact_durations_data != nullptr;
+  }
+
+  bool has_overrides() const {
+    return duration_rows != nullptr;
+  }
+
+  bool is_sparse() const {
+    return sparse_durations != nullptr;
+  }
+
+  // Hint the cache to pull in the line holding duration(i, j). Route
+  // scans chase job indices the hardware prefetcher cannot predict,
+  // so they prefetch the rows for a few ranks ahead while computing
+  // the current one. No-op without a prefetch builtin.
+  void prefetch_duration(Index i, Index j) const {
+#ifdef __GNUC__
+    if (duration_rows != nullptr) {
+      __builtin_prefetch(duration_rows[i] + j, 0);
+      return;
+    }
+    if (sparse_durations != nullptr) {
+      sparse_durations->prefetch_row(i);
+      return;
+    }
+    const std::size_t offset = i * durations_matrix_size + j;
+    if (compact_durations_data != nullptr) {
+      __builtin_prefetch(compact_durations_data + offset, 0);
+    } else {
+      __builtin_prefetch(durations_data + offset, 0);
+    }
+#else
+    (void)i;
+    (void)j;
+#endif
+  }
+
+  Cost duration(Index i, Index j) const {
+    if (duration_rows != nullptr) {
+      return duration_rows[i][j];
+    }
+    if (sparse_durations != nullptr) {
+      return (*sparse_durations)(i, j);
+    }
+    const std::size_t offset = i * durations_matrix_size + j;
+    return compact_durations_data != nullptr ? compact_durations_data[offset]
+                                             : durations_data[offset];
+  }
 };
 
 } // namespace vroom
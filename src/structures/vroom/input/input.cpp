@@ -7,7 +7,13 @@ All rights reserved (see LICENSE).
 
 */
 
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <functional>
 #include <mutex>
+#include <numeric>
 #include <thread>
 
 #include "algorithms/validation/check.h"
@@ -16,11 +22,18 @@ All rights reserved (see LICENSE).
 #if USE_LIBOSRM
 #include "routing/libosrm_wrapper.h"
 #endif
+#include "routing/haversine_wrapper.h"
 #include "routing/ors_wrapper.h"
 #include "routing/osrm_routed_wrapper.h"
 #include "routing/valhalla_wrapper.h"
 #include "structures/vroom/input/input.h"
 #include "utils/helpers.h"
+#include "utils/checkpoint.h"
+#include "utils/matrix_cache.h"
+#include "utils/metrics.h"
+#include "utils/numa.h"
+#include "utils/thread_pool.h"
+#include "utils/tracepoints.h"
 
 namespace vroom {
 
@@ -31,6 +44,18 @@ Input::Input(unsigned amount_size, const io::Servers& servers, ROUTER router)
     _homogeneous_locations(true),
     _homogeneous_profiles(true),
     _geometry(false),
+    _trusted(false),
+    _deterministic(false),
+    _seed(0),
+    _checkpoint_interval(60),
+    _sweep_rank(0),
+    _sweep_count(1),
+    _nb_alternatives(0),
+    _matrices_cost_bound(0),
+    _gains_fit_32bit(false),
+    _memory_budget(0),
+    _report_memory_stats(false),
+    _start_alloc(utils::allocation_snapshot()),
     _has_jobs(false),
     _has_shipments(false),
     _max_matrices_used_index(0),
@@ -38,36 +63,153 @@ Input::Input(unsigned amount_size, const io::Servers& servers, ROUTER router)
     _amount_size(amount_size),
     _zero(_amount_size),
     _servers(servers),
-    _router(router) {
+    _router(router),
+    _solving_cancelled(std::make_shared<std::atomic<bool>>(false)),
+    _pause_gate(std::make_shared<PauseGate>()) {
 }
 
 void Input::set_geometry(bool geometry) {
   _geometry = geometry;
 }
 
+void Input::prefetch_geometry(std::vector<Route>& routes) const {
+  if (!_geometry) {
+    return;
+  }
+
+  try {
+    // Group routes per profile, as in the final routing phase.
+    std::unordered_map<std::string, std::vector<std::reference_wrapper<Route>>>
+      routes_per_profile;
+    for (auto& route : routes) {
+      routes_per_profile[route.profile].push_back(std::ref(route));
+    }
+
+    for (auto& [profile, profile_routes] : routes_per_profile) {
+      auto rw =
+        std::find_if(_routing_wrappers.begin(),
+                     _routing_wrappers.end(),
+                     [&](const auto& wr) { return wr->profile == profile; });
+      if (rw == _routing_wrappers.end()) {
+        // The final routing phase raises the proper error.
+        continue;
+      }
+      (*rw)->prefetch_route_infos(profile_routes);
+    }
+  } catch (...) {
+    // This is speculative work: a flaky backend must not take down a
+    // solve that can still complete, and a persistent failure shows
+    // up in the final routing phase anyway.
+  }
+}
+
+void Input::set_trusted(bool trusted) {
+  _trusted = trusted;
+}
+
+void Input::set_deterministic(bool deterministic) {
+  _deterministic = deterministic;
+}
+
+void Input::set_seed(unsigned seed) {
+  _seed = seed;
+}
+
+void Input::set_checkpoint(const std::string& file, unsigned interval) {
+  _checkpoint_file = file;
+  _checkpoint_interval = std::max(1u, interval);
+}
+
+void Input::set_sweep_slice(unsigned rank, unsigned count) {
+  assert(count > 0 and rank < count);
+  _sweep_rank = rank;
+  _sweep_count = count;
+}
+
+void Input::set_nb_alternatives(unsigned nb_alternatives) {
+  _nb_alternatives = nb_alternatives;
+}
+
+void Input::set_memory_budget(unsigned megabytes) {
+  _memory_budget = static_cast<std::size_t>(megabytes) << 20;
+}
+
+void Input::set_memory_stats(bool report_memory_stats) {
+  _report_memory_stats = report_memory_stats;
+}
+
+void Input::set_progress_callback(ProgressCallback progress_callback) {
+  _progress_callback = std::move(progress_callback);
+}
+
+void Input::report_progress(SEARCH_EVENT event,
+                            Cost cost,
+                            unsigned unassigned) const {
+  if (!_progress_callback) {
+    return;
+  }
+  const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+    std::chrono::high_resolution_clock::now() - _start_loading);
+  _progress_callback({event, cost, unassigned, elapsed});
+}
+
+void Input::reserve(std::size_t nb_jobs, std::size_t nb_vehicles) {
+  jobs.reserve(nb_jobs);
+  job_id_to_rank.reserve(nb_jobs);
+  pickup_id_to_rank.reserve(nb_jobs);
+  delivery_id_to_rank.reserve(nb_jobs);
+  vehicles.reserve(nb_vehicles);
+  // Upper bound assuming all locations are distinct.
+  _locations.reserve(nb_jobs + 2 * nb_vehicles);
+  _locations_to_index.reserve(nb_jobs + 2 * nb_vehicles);
+}
+
 void Input::add_routing_wrapper(const std::string& profile) {
   assert(std::find_if(_routing_wrappers.begin(),
                       _routing_wrappers.end(),
                       [&](const auto& wr) { return wr->profile == profile; }) ==
          _routing_wrappers.end());
 
-  auto& routing_wrapper = _routing_wrappers.emplace_back();
+  // Wrappers are stateless apart from their connection pools, so
+  // they are cached process-wide: a long-running process keeps warm
+  // connections to the routing servers across successive solves.
+  static std::unordered_map<std::string, std::shared_ptr<routing::Wrapper>>
+    wrapper_cache;
+  static std::mutex wrapper_cache_m;
 
-  switch (_router) {
-  case ROUTER::OSRM: {
-    // Use osrm-routed.
+  Server server;
+  if (_router != ROUTER::LIBOSRM and _router != ROUTER::HAVERSINE) {
     auto search = _servers.find(profile);
     if (search == _servers.end()) {
       throw Exception(ERROR::INPUT, "Invalid profile: " + profile + ".");
     }
+    server = search->second;
+  }
+
+  const auto cache_key = std::to_string(static_cast<unsigned>(_router)) + "/" +
+                         profile + "@" + server.host + ":" + server.port;
+
+  std::lock_guard<std::mutex> guard(wrapper_cache_m);
+
+  auto cached = wrapper_cache.find(cache_key);
+  if (cached != wrapper_cache.end()) {
+    _routing_wrappers.push_back(cached->second);
+    return;
+  }
+
+  std::shared_ptr<routing::Wrapper> routing_wrapper;
+
+  switch (_router) {
+  case ROUTER::OSRM:
+    // Use osrm-routed.
     routing_wrapper =
-      std::make_unique<routing::OsrmRoutedWrapper>(profile, search->second);
-  } break;
+      std::make_shared<routing::OsrmRoutedWrapper>(profile, server);
+    break;
   case ROUTER::LIBOSRM:
 #if USE_LIBOSRM
     // Use libosrm.
     try {
-      routing_wrapper = std::make_unique<routing::LibosrmWrapper>(profile);
+      routing_wrapper = std::make_shared<routing::LibosrmWrapper>(profile);
     } catch (const osrm::exception& e) {
       throw Exception(ERROR::ROUTING, "Invalid profile: " + profile);
     }
@@ -77,44 +219,44 @@ void Input::add_routing_wrapper(const std::string& profile) {
                     "VROOM compiled without libosrm installed.");
 #endif
     break;
-  case ROUTER::ORS: {
+  case ROUTER::ORS:
     // Use ORS http wrapper.
-    auto search = _servers.find(profile);
-    if (search == _servers.end()) {
-      throw Exception(ERROR::INPUT, "Invalid profile: " + profile + ".");
-    }
-    routing_wrapper =
-      std::make_unique<routing::OrsWrapper>(profile, search->second);
-  } break;
-  case ROUTER::VALHALLA: {
+    routing_wrapper = std::make_shared<routing::OrsWrapper>(profile, server);
+    break;
+  case ROUTER::VALHALLA:
     // Use Valhalla http wrapper.
-    auto search = _servers.find(profile);
-    if (search == _servers.end()) {
-      throw Exception(ERROR::INPUT, "Invalid profile: " + profile + ".");
-    }
     routing_wrapper =
-      std::make_unique<routing::ValhallaWrapper>(profile, search->second);
-  } break;
+      std::make_shared<routing::ValhallaWrapper>(profile, server);
+    break;
+  case ROUTER::HAVERSINE:
+    // Compute approximate great-circle durations locally.
+    routing_wrapper = std::make_shared<routing::HaversineWrapper>(profile);
+    break;
   }
+
+  wrapper_cache.emplace(cache_key, routing_wrapper);
+  _routing_wrappers.push_back(std::move(routing_wrapper));
 }
 
 void Input::check_job(Job& job) {
-  // Ensure delivery size consistency.
-  const auto& delivery_size = job.delivery.size();
-  if (delivery_size != _amount_size) {
-    throw Exception(ERROR::INPUT,
-                    "Inconsistent delivery length: " +
-                      std::to_string(delivery_size) + " instead of " +
-                      std::to_string(_amount_size) + '.');
-  }
+  if (!_trusted) {
+    // Ensure delivery size consistency.
+    const auto& delivery_size = job.delivery.size();
+    if (delivery_size != _amount_size) {
+      throw Exception(ERROR::INPUT,
+                      "Inconsistent delivery length: " +
+                        std::to_string(delivery_size) + " instead of " +
+                        std::to_string(_amount_size) + '.');
+    }
 
-  // Ensure pickup size consistency.
-  const auto& pickup_size = job.pickup.size();
-  if (pickup_size != _amount_size) {
-    throw Exception(ERROR::INPUT,
-                    "Inconsistent pickup length: " +
-                      std::to_string(pickup_size) + " instead of " +
-                      std::to_string(_amount_size) + '.');
+    // Ensure pickup size consistency.
+    const auto& pickup_size = job.pickup.size();
+    if (pickup_size != _amount_size) {
+      throw Exception(ERROR::INPUT,
+                      "Inconsistent pickup length: " +
+                        std::to_string(pickup_size) + " instead of " +
+                        std::to_string(_amount_size) + '.');
+    }
   }
 
   // Ensure that skills or location index are either always or never
@@ -124,7 +266,7 @@ void Input::check_job(Job& job) {
     _has_skills = !job.skills.empty();
     _no_addition_yet = false;
     _has_custom_location_index = has_location_index;
-  } else {
+  } else if (!_trusted) {
     if (_has_skills != !job.skills.empty()) {
       throw Exception(ERROR::INPUT, "Missing skills.");
     }
@@ -166,71 +308,131 @@ void Input::check_job(Job& job) {
   _max_matrices_used_index = std::max(_max_matrices_used_index, job.index());
   _all_locations_have_coords =
     _all_locations_have_coords && job.location.has_coordinates();
+
+  check_index_range();
+
+  _job_skills_masks.push_back(intern_skills(job.skills));
 }
 
-void Input::add_job(const Job& job) {
-  if (job.type != JOB_TYPE::SINGLE) {
-    throw Exception(ERROR::INPUT, "Wrong job type.");
+Input::SkillMask Input::intern_skills(const Skills& skills) {
+  SkillMask mask;
+  for (const auto s : skills) {
+    unsigned rank;
+    auto search = _skill_ranks.find(s);
+    if (search != _skill_ranks.end()) {
+      rank = search->second;
+    } else {
+      rank = _skill_ranks.size();
+      _skill_ranks[s] = rank;
+    }
+
+    if (rank < 64) {
+      mask.fast |= (1ULL << rank);
+    } else {
+      const unsigned word = (rank >> 6) - 1;
+      if (mask.spill.size() <= word) {
+        mask.spill.resize(word + 1, 0);
+      }
+      mask.spill[word] |= (1ULL << (rank & 63));
+    }
   }
-  if (job_id_to_rank.find(job.id) != job_id_to_rank.end()) {
+  return mask;
+}
+
+void Input::check_index_range() const {
+  // Number of locations an Index can address, depending on the width
+  // picked at build time.
+  constexpr auto max_locations =
+    static_cast<std::size_t>(std::numeric_limits<Index>::max()) + 1;
+  if (_locations.size() > max_locations) {
     throw Exception(ERROR::INPUT,
-                    "Duplicate job id: " + std::to_string(job.id) + ".");
+                    "Too many locations (" + std::to_string(_locations.size()) +
+                      "), maximum is " + std::to_string(max_locations) +
+                      " with current index width.");
+  }
+}
+
+void Input::add_job(const Job& job) {
+  add_job(Job(job));
+}
+
+void Input::add_job(Job&& job) {
+  if (!_trusted) {
+    if (job.type != JOB_TYPE::SINGLE) {
+      throw Exception(ERROR::INPUT, "Wrong job type.");
+    }
+    if (job_id_to_rank.find(job.id) != job_id_to_rank.end()) {
+      throw Exception(ERROR::INPUT,
+                      "Duplicate job id: " + std::to_string(job.id) + ".");
+    }
   }
   job_id_to_rank[job.id] = jobs.size();
-  jobs.push_back(job);
+  jobs.push_back(std::move(job));
   check_job(jobs.back());
   _has_jobs = true;
 }
 
 void Input::add_shipment(const Job& pickup, const Job& delivery) {
-  if (pickup.priority != delivery.priority) {
-    throw Exception(ERROR::INPUT, "Inconsistent shipment priority.");
-  }
-  if (!(pickup.pickup == delivery.delivery)) {
-    throw Exception(ERROR::INPUT, "Inconsistent shipment amount.");
-  }
-  if (pickup.skills.size() != delivery.skills.size()) {
-    throw Exception(ERROR::INPUT, "Inconsistent shipment skills.");
-  }
-  for (const auto s : pickup.skills) {
-    if (delivery.skills.find(s) == delivery.skills.end()) {
+  add_shipment(Job(pickup), Job(delivery));
+}
+
+void Input::add_shipment(Job&& pickup, Job&& delivery) {
+  if (!_trusted) {
+    if (pickup.priority != delivery.priority) {
+      throw Exception(ERROR::INPUT, "Inconsistent shipment priority.");
+    }
+    if (!(pickup.pickup == delivery.delivery)) {
+      throw Exception(ERROR::INPUT, "Inconsistent shipment amount.");
+    }
+    if (pickup.skills.size() != delivery.skills.size()) {
       throw Exception(ERROR::INPUT, "Inconsistent shipment skills.");
     }
-  }
+    for (const auto s : pickup.skills) {
+      if (delivery.skills.find(s) == delivery.skills.end()) {
+        throw Exception(ERROR::INPUT, "Inconsistent shipment skills.");
+      }
+    }
 
-  if (pickup.type != JOB_TYPE::PICKUP) {
-    throw Exception(ERROR::INPUT, "Wrong pickup type.");
-  }
-  if (pickup_id_to_rank.find(pickup.id) != pickup_id_to_rank.end()) {
-    throw Exception(ERROR::INPUT,
-                    "Duplicate pickup id: " + std::to_string(pickup.id) + ".");
+    if (pickup.type != JOB_TYPE::PICKUP) {
+      throw Exception(ERROR::INPUT, "Wrong pickup type.");
+    }
+    if (pickup_id_to_rank.find(pickup.id) != pickup_id_to_rank.end()) {
+      throw Exception(ERROR::INPUT,
+                      "Duplicate pickup id: " + std::to_string(pickup.id) +
+                        ".");
+    }
+    if (delivery.type != JOB_TYPE::DELIVERY) {
+      throw Exception(ERROR::INPUT, "Wrong delivery type.");
+    }
+    if (delivery_id_to_rank.find(delivery.id) != delivery_id_to_rank.end()) {
+      throw Exception(ERROR::INPUT,
+                      "Duplicate delivery id: " + std::to_string(delivery.id) +
+                        ".");
+    }
   }
+
   pickup_id_to_rank[pickup.id] = jobs.size();
-  jobs.push_back(pickup);
+  jobs.push_back(std::move(pickup));
   check_job(jobs.back());
 
-  if (delivery.type != JOB_TYPE::DELIVERY) {
-    throw Exception(ERROR::INPUT, "Wrong delivery type.");
-  }
-  if (delivery_id_to_rank.find(delivery.id) != delivery_id_to_rank.end()) {
-    throw Exception(ERROR::INPUT,
-                    "Duplicate delivery id: " + std::to_string(delivery.id) +
-                      ".");
-  }
   delivery_id_to_rank[delivery.id] = jobs.size();
-  jobs.push_back(delivery);
+  jobs.push_back(std::move(delivery));
   check_job(jobs.back());
   _has_shipments = true;
 }
 
 void Input::add_vehicle(const Vehicle& vehicle) {
-  vehicles.push_back(vehicle);
+  add_vehicle(Vehicle(vehicle));
+}
+
+void Input::add_vehicle(Vehicle&& vehicle) {
+  vehicles.push_back(std::move(vehicle));
 
   auto& current_v = vehicles.back();
 
   // Ensure amount size consistency.
   const auto& vehicle_amount_size = current_v.capacity.size();
-  if (vehicle_amount_size != _amount_size) {
+  if (!_trusted and vehicle_amount_size != _amount_size) {
     throw Exception(ERROR::INPUT,
                     "Inconsistent capacity length: " +
                       std::to_string(vehicle_amount_size) + " instead of " +
@@ -238,7 +440,7 @@ void Input::add_vehicle(const Vehicle& vehicle) {
   }
 
   // Check for time-windows.
-  _has_TW = _has_TW || !vehicle.tw.is_default();
+  _has_TW = _has_TW || !current_v.tw.is_default();
 
   bool has_location_index = false;
   if (current_v.has_start()) {
@@ -283,7 +485,7 @@ void Input::add_vehicle(const Vehicle& vehicle) {
   if (current_v.has_end()) {
     auto& end_loc = current_v.end.value();
 
-    if (current_v.has_start() and
+    if (!_trusted and current_v.has_start() and
         (has_location_index != end_loc.user_index())) {
       // Start and end provided in a non-consistent manner with regard
       // to location index definition.
@@ -326,13 +528,15 @@ void Input::add_vehicle(const Vehicle& vehicle) {
       _all_locations_have_coords && end_loc.has_coordinates();
   }
 
+  check_index_range();
+
   // Ensure that skills or location index are either always or never
   // provided.
   if (_no_addition_yet) {
     _has_skills = !current_v.skills.empty();
     _no_addition_yet = false;
     _has_custom_location_index = has_location_index;
-  } else {
+  } else if (!_trusted) {
     if (_has_skills != !current_v.skills.empty()) {
       throw Exception(ERROR::INPUT, "Missing skills.");
     }
@@ -351,13 +555,285 @@ void Input::add_vehicle(const Vehicle& vehicle) {
   }
 
   _profiles.insert(current_v.profile);
+
+  _vehicle_skills_masks.push_back(intern_skills(current_v.skills));
 }
 
 void Input::set_matrix(const std::string& profile, Matrix<Cost>&& m) {
+  if (_derived_profiles.find(profile) != _derived_profiles.end()) {
+    throw Exception(ERROR::INPUT,
+                    "Profile " + profile +
+                      " is derived and cannot get its own matrix.");
+  }
+  if (_sparse_matrices.find(profile) != _sparse_matrices.end()) {
+    throw Exception(ERROR::INPUT,
+                    "Profile " + profile + " already has a sparse matrix.");
+  }
   _custom_matrices.insert(profile);
+  // Detect symmetry once at load: straight-line or symmetric-network
+  // custom matrices are common and the flag saves downstream scans.
+  m.detect_symmetry();
   _matrices.insert_or_assign(profile, m);
 }
 
+void Input::set_sparse_matrix(const std::string& profile,
+                              SparseMatrix<Cost>&& m) {
+  if (_derived_profiles.find(profile) != _derived_profiles.end()) {
+    throw Exception(ERROR::INPUT,
+                    "Profile " + profile +
+                      " is derived and cannot get its own matrix.");
+  }
+  if (_matrices.find(profile) != _matrices.end()) {
+    throw Exception(ERROR::INPUT,
+                    "Profile " + profile + " already has a dense matrix.");
+  }
+  _custom_matrices.insert(profile);
+  _sparse_matrices.insert_or_assign(profile, std::move(m));
+}
+
+void Input::add_derived_profile(
+  const std::string& profile,
+  const std::string& base,
+  double factor,
+  std::vector<std::tuple<Index, Index, Cost>> overrides) {
+  if (factor <= 0) {
+    throw Exception(ERROR::INPUT,
+                    "Invalid factor for derived profile " + profile + ".");
+  }
+  if (profile == base or
+      _derived_profiles.find(base) != _derived_profiles.end()) {
+    throw Exception(ERROR::INPUT,
+                    "Derived profile " + profile +
+                      " must derive from a plain profile.");
+  }
+  if (_custom_matrices.find(profile) != _custom_matrices.end()) {
+    throw Exception(ERROR::INPUT,
+                    "Profile " + profile +
+                      " already has its own matrix and cannot be derived.");
+  }
+
+  DerivedProfile derived;
+  derived.base = base;
+  derived.factor = factor;
+  derived.overrides = std::move(overrides);
+  const auto added = _derived_profiles.emplace(profile, std::move(derived));
+  if (!added.second) {
+    throw Exception(ERROR::INPUT,
+                    "Duplicate derived profile " + profile + ".");
+  }
+}
+
+namespace {
+
+// FNV-1a over explicit values, used to build the canonical input
+// hash below.
+constexpr uint64_t HASH_SEED = 0xcbf29ce484222325ULL;
+constexpr uint64_t HASH_PRIME = 0x100000001b3ULL;
+
+uint64_t hash_mix(uint64_t h, uint64_t value) {
+  for (unsigned i = 0; i < sizeof(value); ++i) {
+    h = (h ^ (value & 0xff)) * HASH_PRIME;
+    value >>= 8;
+  }
+  return h;
+}
+
+uint64_t hash_mix(uint64_t h, double value) {
+  uint64_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  return hash_mix(h, bits);
+}
+
+uint64_t hash_mix(uint64_t h, std::string_view str) {
+  for (const char c : str) {
+    h = (h ^ static_cast<unsigned char>(c)) * HASH_PRIME;
+  }
+  return hash_mix(h, static_cast<uint64_t>(str.size()));
+}
+
+uint64_t hash_mix(uint64_t h, const Location& location) {
+  // Only hash user-provided data: internal indices assigned to
+  // coordinate-only locations depend on the order of appearance.
+  if (location.user_index()) {
+    h = hash_mix(h, static_cast<uint64_t>(location.index()));
+  }
+  if (location.has_coordinates()) {
+    h = hash_mix(h, location.lon());
+    h = hash_mix(h, location.lat());
+  }
+  return h;
+}
+
+template <typename E>
+uint64_t hash_mix(uint64_t h, const AmountExpression<E>& amount) {
+  for (std::size_t i = 0; i < amount.size(); ++i) {
+    h = hash_mix(h, static_cast<uint64_t>(amount[i]));
+  }
+  return h;
+}
+
+uint64_t hash_mix(uint64_t h, const Skills& skills) {
+  std::vector<Skill> sorted_skills(skills.begin(), skills.end());
+  std::sort(sorted_skills.begin(), sorted_skills.end());
+  for (const auto skill : sorted_skills) {
+    h = hash_mix(h, static_cast<uint64_t>(skill));
+  }
+  return hash_mix(h, static_cast<uint64_t>(skills.size()));
+}
+
+uint64_t hash_mix(uint64_t h, const std::vector<TimeWindow>& tws) {
+  for (const auto& tw : tws) {
+    h = hash_mix(h, static_cast<uint64_t>(tw.start));
+    h = hash_mix(h, static_cast<uint64_t>(tw.end));
+  }
+  return hash_mix(h, static_cast<uint64_t>(tws.size()));
+}
+
+uint64_t hash_mix(uint64_t h, const std::optional<Duration>& value) {
+  return value.has_value()
+           ? hash_mix(h, static_cast<uint64_t>(value.value()) + 1)
+           : hash_mix(h, uint64_t(0));
+}
+
+uint64_t job_hash(const Job& job) {
+  uint64_t h = HASH_SEED;
+  h = hash_mix(h, job.id);
+  h = hash_mix(h, static_cast<uint64_t>(job.type));
+  h = hash_mix(h, job.location);
+  h = hash_mix(h, static_cast<uint64_t>(job.service));
+  h = hash_mix(h, job.delivery);
+  h = hash_mix(h, job.pickup);
+  h = hash_mix(h, job.skills);
+  h = hash_mix(h, static_cast<uint64_t>(job.priority));
+  h = hash_mix(h, job.tws);
+  h = hash_mix(h, job.description);
+  return h;
+}
+
+uint64_t vehicle_hash(const Vehicle& vehicle) {
+  uint64_t h = HASH_SEED;
+  h = hash_mix(h, vehicle.id);
+  if (vehicle.has_start()) {
+    h = hash_mix(h, vehicle.start.value());
+  }
+  if (vehicle.has_end()) {
+    h = hash_mix(h, vehicle.end.value());
+  }
+  h = hash_mix(h, vehicle.profile);
+  h = hash_mix(h, vehicle.cost_wrapper.durations_factor);
+  h = hash_mix(h, vehicle.capacity);
+  h = hash_mix(h, vehicle.skills);
+  h = hash_mix(h, static_cast<uint64_t>(vehicle.tw.start));
+  h = hash_mix(h, static_cast<uint64_t>(vehicle.tw.end));
+  for (const auto& b : vehicle.breaks) {
+    h = hash_mix(h, b.id);
+    h = hash_mix(h, b.tws);
+    h = hash_mix(h, static_cast<uint64_t>(b.service));
+    h = hash_mix(h, b.description);
+  }
+  h = hash_mix(h, static_cast<uint64_t>(vehicle.breaks.size()));
+  for (const auto& step : vehicle.steps) {
+    h = hash_mix(h, static_cast<uint64_t>(step.type));
+    h = hash_mix(h, static_cast<uint64_t>(step.job_type));
+    h = hash_mix(h, step.id);
+    h = hash_mix(h, step.forced_service.at);
+    h = hash_mix(h, step.forced_service.after);
+    h = hash_mix(h, step.forced_service.before);
+  }
+  h = hash_mix(h, static_cast<uint64_t>(vehicle.steps.size()));
+  h = hash_mix(h, vehicle.description);
+  return h;
+}
+
+} // namespace
+
+uint64_t Input::canonical_hash() const {
+  uint64_t h = HASH_SEED;
+  h = hash_mix(h, static_cast<uint64_t>(_amount_size));
+
+  // Jobs and vehicles are combined commutatively so resubmissions
+  // listing the same entities in a different order hash the same. A
+  // pickup is hashed together with its matching delivery (stored at
+  // the next rank) to retain the pairing.
+  uint64_t jobs_hash = 0;
+  for (std::size_t i = 0; i < jobs.size(); ++i) {
+    if (jobs[i].type == JOB_TYPE::PICKUP) {
+      assert(i + 1 < jobs.size() and
+             jobs[i + 1].type == JOB_TYPE::DELIVERY);
+      jobs_hash += hash_mix(job_hash(jobs[i]), job_hash(jobs[i + 1]));
+      ++i;
+    } else {
+      jobs_hash += job_hash(jobs[i]);
+    }
+  }
+  h = hash_mix(h, jobs_hash);
+
+  uint64_t vehicles_hash = 0;
+  for (const auto& vehicle : vehicles) {
+    vehicles_hash += vehicle_hash(vehicle);
+  }
+  h = hash_mix(h, vehicles_hash);
+
+  // Matrices and derived profiles are keyed by unordered profile
+  // name, sorted here for a stable traversal.
+  std::vector<std::string> profiles;
+  for (const auto& m : _matrices) {
+    profiles.push_back(m.first);
+  }
+  std::sort(profiles.begin(), profiles.end());
+  for (const auto& profile : profiles) {
+    const auto& matrix = _matrices.at(profile);
+    h = hash_mix(h, profile);
+    h = hash_mix(h, static_cast<uint64_t>(matrix.size()));
+    for (std::size_t i = 0; i < matrix.size(); ++i) {
+      for (std::size_t j = 0; j < matrix.size(); ++j) {
+        h = hash_mix(h, static_cast<uint64_t>(matrix[i][j]));
+      }
+    }
+  }
+
+  profiles.clear();
+  for (const auto& m : _sparse_matrices) {
+    profiles.push_back(m.first);
+  }
+  std::sort(profiles.begin(), profiles.end());
+  for (const auto& profile : profiles) {
+    const auto& matrix = _sparse_matrices.at(profile);
+    h = hash_mix(h, profile);
+    h = hash_mix(h, static_cast<uint64_t>(matrix.size()));
+    h = hash_mix(h, static_cast<uint64_t>(matrix.fallback()));
+    for (const auto offset : matrix.row_offsets()) {
+      h = hash_mix(h, static_cast<uint64_t>(offset));
+    }
+    for (const auto column : matrix.columns()) {
+      h = hash_mix(h, static_cast<uint64_t>(column));
+    }
+    for (const auto value : matrix.values()) {
+      h = hash_mix(h, static_cast<uint64_t>(value));
+    }
+  }
+
+  profiles.clear();
+  for (const auto& d : _derived_profiles) {
+    profiles.push_back(d.first);
+  }
+  std::sort(profiles.begin(), profiles.end());
+  for (const auto& profile : profiles) {
+    const auto& derived = _derived_profiles.at(profile);
+    h = hash_mix(h, profile);
+    h = hash_mix(h, derived.base);
+    h = hash_mix(h, derived.factor);
+    for (const auto& [i, j, duration] : derived.overrides) {
+      h = hash_mix(h, static_cast<uint64_t>(i));
+      h = hash_mix(h, static_cast<uint64_t>(j));
+      h = hash_mix(h, static_cast<uint64_t>(duration));
+    }
+    h = hash_mix(h, static_cast<uint64_t>(derived.overrides.size()));
+  }
+
+  return h;
+}
+
 bool Input::has_skills() const {
   return _has_skills;
 }
@@ -382,20 +858,130 @@ bool Input::vehicle_ok_with_vehicle(Index v1_index, Index v2_index) const {
   return _vehicle_to_vehicle_compatibility[v1_index][v2_index];
 }
 
-void Input::check_cost_bound(const Matrix<Cost>& matrix) const {
+Cost Input::check_cost_bound(const Matrix<Cost>& matrix) const {
   // Check that we don't have any overflow while computing an upper
   // bound for solution cost.
 
-  std::vector<Cost> max_cost_per_line(matrix.size(), 0);
-  std::vector<Cost> max_cost_per_column(matrix.size(), 0);
+  const std::size_t n = matrix.size();
+
+  std::vector<Cost> max_cost_per_line(n, 0);
+  std::vector<Cost> max_cost_per_column(n, 0);
+
+  // Row maxima for a row range, folding column maxima into the
+  // caller-provided partial along the way. Row-major storage makes
+  // both reductions stream the flat store exactly once.
+  auto scan_rows = [&matrix, &max_cost_per_line, n](std::size_t first,
+                                                    std::size_t last,
+                                                    std::vector<Cost>&
+                                                      col_max) {
+    for (std::size_t i = first; i < last; ++i) {
+      const Cost* row = matrix[i];
+      Cost row_max = 0;
+      std::size_t j = 0;
+#ifdef __AVX2__
+      __m256i row_max_v = _mm256_setzero_si256();
+      for (; j + 8 <= n; j += 8) {
+        const __m256i values =
+          _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + j));
+        row_max_v = _mm256_max_epu32(row_max_v, values);
+        const __m256i col = _mm256_loadu_si256(
+          reinterpret_cast<const __m256i*>(col_max.data() + j));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(col_max.data() + j),
+                            _mm256_max_epu32(col, values));
+      }
+      alignas(32) Cost lanes[8];
+      _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), row_max_v);
+      for (const auto lane : lanes) {
+        row_max = std::max(row_max, lane);
+      }
+#endif
+      for (; j < n; ++j) {
+        row_max = std::max(row_max, row[j]);
+        col_max[j] = std::max(col_max[j], row[j]);
+      }
+      max_cost_per_line[i] = row_max;
+    }
+  };
+
+  if (_matrices_used_index.size() == n) {
+    // All ranks are used so the maxima reduce over whole rows. Rows
+    // are chunked across the pool for big matrices, each worker
+    // folding its own column partial merged below; nested run calls
+    // are fine since the calling thread takes part in the work.
+    const auto nb_workers =
+      std::max(1u, std::thread::hardware_concurrency());
+    const std::size_t chunk = std::max<std::size_t>(64, n / nb_workers + 1);
+
+    std::vector<std::vector<Cost>> col_partials;
+    for (std::size_t first = 0; first < n; first += chunk) {
+      col_partials.emplace_back(n, 0);
+    }
+
+    if (col_partials.size() == 1) {
+      scan_rows(0, n, col_partials.front());
+    } else {
+      std::vector<std::function<void()>> bound_tasks;
+      for (std::size_t t = 0; t < col_partials.size(); ++t) {
+        const std::size_t first = t * chunk;
+        const std::size_t last = std::min(first + chunk, n);
+        auto& col_max = col_partials[t];
+        bound_tasks.push_back([&scan_rows, first, last, &col_max]() {
+          scan_rows(first, last, col_max);
+        });
+      }
+      utils::ThreadPool::instance().run(std::move(bound_tasks));
+    }
+
+    for (const auto& col_max : col_partials) {
+      for (std::size_t j = 0; j < n; ++j) {
+        max_cost_per_column[j] = std::max(max_cost_per_column[j], col_max[j]);
+      }
+    }
+  } else {
+    // Sparse used ranks, e.g. a custom matrix bigger than the
+    // locations at hand: stick to the indexed scan.
+    for (const auto i : _matrices_used_index) {
+      for (const auto j : _matrices_used_index) {
+        max_cost_per_line[i] = std::max(max_cost_per_line[i], matrix[i][j]);
+        max_cost_per_column[j] = std::max(max_cost_per_column[j], matrix[i][j]);
+      }
+    }
+  }
+
+  return check_cost_bound_with(max_cost_per_line, max_cost_per_column);
+}
 
-  for (const auto i : _matrices_used_index) {
-    for (const auto j : _matrices_used_index) {
-      max_cost_per_line[i] = std::max(max_cost_per_line[i], matrix[i][j]);
-      max_cost_per_column[j] = std::max(max_cost_per_column[j], matrix[i][j]);
+Cost Input::check_cost_bound(const SparseMatrix<Cost>& matrix) const {
+  const std::size_t n = matrix.size();
+
+  // Absent pairs read back as the fallback bound, folded into every
+  // row and column maximum unless the matrix is actually full: cheap
+  // and conservative, which is all the overflow check needs.
+  const bool any_absent = (matrix.nb_entries() < n * n);
+
+  std::vector<Cost> max_cost_per_line(n, 0);
+  std::vector<Cost> max_cost_per_column(n,
+                                        any_absent ? matrix.fallback() : 0);
+
+  const auto& row_offsets = matrix.row_offsets();
+  const auto& columns = matrix.columns();
+  const auto& values = matrix.values();
+  for (std::size_t i = 0; i < n; ++i) {
+    Cost row_max = matrix.row_is_full(i) ? 0 : matrix.fallback();
+    for (std::size_t r = row_offsets[i]; r < row_offsets[i + 1]; ++r) {
+      row_max = std::max(row_max, values[r]);
+      max_cost_per_column[columns[r]] =
+        std::max(max_cost_per_column[columns[r]], values[r]);
     }
+    max_cost_per_line[i] = row_max;
   }
 
+  return check_cost_bound_with(max_cost_per_line, max_cost_per_column);
+}
+
+Cost Input::check_cost_bound_with(const std::vector<Cost>& max_cost_per_line,
+                                  const std::vector<Cost>&
+                                    max_cost_per_column) const {
   Cost jobs_departure_bound = 0;
   Cost jobs_arrival_bound = 0;
   for (const auto& j : jobs) {
@@ -425,31 +1011,89 @@ void Input::check_cost_bound(const Matrix<Cost>& matrix) const {
   }
 
   Cost bound = utils::add_without_overflow(start_bound, jobs_bound);
-  bound = utils::add_without_overflow(bound, end_bound);
+  return utils::add_without_overflow(bound, end_bound);
+}
+
+void Input::run_on_vehicles(
+  const std::function<void(Index)>& vehicle_setup) {
+  const auto nb_buckets =
+    std::min(vehicles.size(),
+             static_cast<std::size_t>(
+               std::max(1u, std::thread::hardware_concurrency())));
+
+  if (nb_buckets < 2) {
+    for (std::size_t v = 0; v < vehicles.size(); ++v) {
+      vehicle_setup(static_cast<Index>(v));
+    }
+    return;
+  }
+
+  std::exception_ptr ep = nullptr;
+  std::mutex ep_m;
+
+  auto run_on_bucket = [&](std::size_t bucket) {
+    try {
+      for (std::size_t v = bucket; v < vehicles.size(); v += nb_buckets) {
+        vehicle_setup(static_cast<Index>(v));
+      }
+    } catch (...) {
+      std::lock_guard<std::mutex> lock(ep_m);
+      ep = std::current_exception();
+    }
+  };
+
+  std::vector<std::function<void()>> setup_tasks;
+  for (std::size_t bucket = 0; bucket < nb_buckets; ++bucket) {
+    setup_tasks.push_back([&run_on_bucket, bucket] { run_on_bucket(bucket); });
+  }
+  utils::ThreadPool::instance().run(std::move(setup_tasks));
+
+  if (ep != nullptr) {
+    std::rethrow_exception(ep);
+  }
 }
 
 void Input::set_skills_compatibility() {
-  // Default to no restriction when no skills are provided.
-  _vehicle_to_job_compatibility = std::vector<
-    std::vector<unsigned char>>(vehicles.size(),
-                                std::vector<unsigned char>(jobs.size(), true));
+  // Default to no restriction when no skills are provided. Unused
+  // bits in the last word are kept clear since rows are AND-ed
+  // together in set_vehicles_compatibility.
+  const std::size_t nb_words = (jobs.size() + 63) / 64;
+  _vehicle_to_job_compatibility =
+    std::vector<std::vector<uint64_t>>(vehicles.size(),
+                                       std::vector<uint64_t>(nb_words, ~0ULL));
+  if (jobs.size() % 64 != 0) {
+    const uint64_t trailing_mask = (1ULL << (jobs.size() % 64)) - 1;
+    for (auto& compatible_jobs : _vehicle_to_job_compatibility) {
+      compatible_jobs.back() &= trailing_mask;
+    }
+  }
+
   if (_has_skills) {
-    for (std::size_t v = 0; v < vehicles.size(); ++v) {
-      const auto& v_skills = vehicles[v].skills;
-      assert(!v_skills.empty());
+    assert(_job_skills_masks.size() == jobs.size() and
+           _vehicle_skills_masks.size() == vehicles.size());
+
+    // Each task only writes its own compatibility row.
+    run_on_vehicles([this](Index v) {
+      const auto& v_mask = _vehicle_skills_masks[v];
+      assert(!vehicles[v].skills.empty());
 
       for (std::size_t j = 0; j < jobs.size(); ++j) {
-        bool is_compatible = true;
+        const auto& j_mask = _job_skills_masks[j];
         assert(!jobs[j].skills.empty());
-        for (const auto& s : jobs[j].skills) {
-          if (v_skills.find(s) == v_skills.end()) {
-            is_compatible = false;
-            break;
-          }
+
+        bool is_compatible = ((j_mask.fast & ~v_mask.fast) == 0);
+        for (std::size_t w = 0; is_compatible and w < j_mask.spill.size();
+             ++w) {
+          const uint64_t v_word =
+            (w < v_mask.spill.size()) ? v_mask.spill[w] : 0;
+          is_compatible = ((j_mask.spill[w] & ~v_word) == 0);
+        }
+
+        if (!is_compatible) {
+          _vehicle_to_job_compatibility[v][j >> 6] &= ~(1ULL << (j & 63));
         }
-        _vehicle_to_job_compatibility[v][j] = is_compatible;
       }
-    }
+    });
   }
 }
 
@@ -457,11 +1101,13 @@ void Input::set_extra_compatibility() {
   // Derive potential extra incompatibilities : jobs or shipments with
   // amount that does not fit into vehicle or that cannot be added to
   // an empty route for vehicle based on the timing constraints (when
-  // they apply).
-  for (std::size_t v = 0; v < vehicles.size(); ++v) {
+  // they apply). The per-pair TW reachability checks make this the
+  // most expensive compatibility pass, and rows are per-vehicle so
+  // vehicles are handled in parallel.
+  run_on_vehicles([this](Index v) {
     TWRoute empty_route(*this, v);
     for (Index j = 0; j < jobs.size(); ++j) {
-      if (_vehicle_to_job_compatibility[v][j]) {
+      if (vehicle_ok_with_job(v, j)) {
         bool is_compatible =
           empty_route.is_valid_addition_for_capacity(*this,
                                                      jobs[j].pickup,
@@ -486,43 +1132,383 @@ void Input::set_extra_compatibility() {
           }
         }
 
-        _vehicle_to_job_compatibility[v][j] = is_compatible;
+        if (!is_compatible) {
+          _vehicle_to_job_compatibility[v][j >> 6] &= ~(1ULL << (j & 63));
+        }
         if (is_shipment_pickup) {
           // Skipping matching delivery which is next in line in jobs.
-          _vehicle_to_job_compatibility[v][j + 1] = is_compatible;
+          if (!is_compatible) {
+            _vehicle_to_job_compatibility[v][(j + 1) >> 6] &=
+              ~(1ULL << ((j + 1) & 63));
+          }
           ++j;
         }
       }
     }
-  }
+  });
 }
 
 void Input::set_vehicles_compatibility() {
   _vehicle_to_vehicle_compatibility =
     std::vector<std::vector<bool>>(vehicles.size(),
                                    std::vector<bool>(vehicles.size(), false));
-  for (std::size_t v1 = 0; v1 < vehicles.size(); ++v1) {
+  _vehicle_ok_with_all_jobs = std::vector<bool>(vehicles.size(), false);
+  // Each task fills the full row for its vehicle: the symmetric
+  // halving would have two tasks write bits in the same packed
+  // vector<bool> row.
+  run_on_vehicles([this](Index v1) {
     _vehicle_to_vehicle_compatibility[v1][v1] = true;
-    for (std::size_t v2 = v1 + 1; v2 < vehicles.size(); ++v2) {
-      for (std::size_t j = 0; j < jobs.size(); ++j) {
-        if (_vehicle_to_job_compatibility[v1][j] and
-            _vehicle_to_job_compatibility[v2][j]) {
+    const auto& v1_compatible_jobs = _vehicle_to_job_compatibility[v1];
+
+    // Compatibility rows are final at this point, flag full rows.
+    std::size_t nb_compatible = 0;
+    for (const auto word : v1_compatible_jobs) {
+      nb_compatible += __builtin_popcountll(word);
+    }
+    _vehicle_ok_with_all_jobs[v1] = (nb_compatible == jobs.size());
+    for (std::size_t v2 = 0; v2 < vehicles.size(); ++v2) {
+      if (v2 == v1) {
+        continue;
+      }
+      // Vehicles share a candidate job iff their compatibility rows
+      // have a common bit set.
+      const auto& v2_compatible_jobs = _vehicle_to_job_compatibility[v2];
+      for (std::size_t w = 0; w < v1_compatible_jobs.size(); ++w) {
+        if (v1_compatible_jobs[w] & v2_compatible_jobs[w]) {
           _vehicle_to_vehicle_compatibility[v1][v2] = true;
-          _vehicle_to_vehicle_compatibility[v2][v1] = true;
           break;
         }
       }
     }
-  }
+  });
 }
 
 void Input::set_vehicles_costs() {
+  // Turn (i, j, duration) override lists into maps keyed by flat
+  // matrix offset, now matrix sizes are known.
+  for (auto& derived_entry : _derived_profiles) {
+    auto& derived = derived_entry.second;
+    const auto search = _matrices.find(derived.base);
+    if (search == _matrices.end() and
+        _sparse_matrices.find(derived.base) != _sparse_matrices.end()) {
+      throw Exception(ERROR::INPUT,
+                      "Derived profile " + derived_entry.first +
+                        " cannot derive from sparse profile " + derived.base +
+                        ".");
+    }
+    assert(search != _matrices.end());
+    const auto matrix_size = search->second.size();
+
+    for (const auto& [i, j, value] : derived.overrides) {
+      if (matrix_size <= i or matrix_size <= j) {
+        throw Exception(ERROR::INPUT,
+                        "Override index exceeding matrix size for " +
+                          derived_entry.first + " profile.");
+      }
+      derived.override_map.emplace(static_cast<uint64_t>(i) * matrix_size + j,
+                                   value);
+    }
+
+    if (!derived.overrides.empty()) {
+      // Per-row view with overrides applied once: rows without any
+      // override point straight into the base matrix, the few
+      // touched rows get a patched copy.
+      const auto& matrix = search->second;
+      derived.duration_rows.resize(matrix_size);
+      for (std::size_t i = 0; i < matrix_size; ++i) {
+        derived.duration_rows[i] = matrix[i];
+      }
+
+      std::unordered_map<Index, std::size_t> patched_row_rank;
+      for (const auto& [i, j, value] : derived.overrides) {
+        auto patched = patched_row_rank.find(i);
+        if (patched == patched_row_rank.end()) {
+          patched = patched_row_rank
+                      .emplace(i, derived.patched_rows.size())
+                      .first;
+          derived.patched_rows.emplace_back(matrix[i], matrix[i] + matrix_size);
+        }
+        derived.patched_rows[patched->second][j] = value;
+      }
+      for (const auto& [i, rank] : patched_row_rank) {
+        derived.duration_rows[i] = derived.patched_rows[rank].data();
+      }
+    }
+  }
+
   for (std::size_t v = 0; v < vehicles.size(); ++v) {
     auto& vehicle = vehicles[v];
+
+    const auto derived = _derived_profiles.find(vehicle.profile);
+    if (derived != _derived_profiles.end()) {
+      auto search = _matrices.find(derived->second.base);
+      assert(search != _matrices.end());
+      vehicle.cost_wrapper.set_durations_matrix(&(search->second));
+      vehicle.cost_wrapper.scale_durations(derived->second.factor);
+      if (!derived->second.duration_rows.empty()) {
+        vehicle.cost_wrapper.set_duration_rows(
+          derived->second.duration_rows.data());
+      }
+      continue;
+    }
+
     auto search = _matrices.find(vehicle.profile);
-    assert(search != _matrices.end());
+    if (search == _matrices.end()) {
+      const auto sparse = _sparse_matrices.find(vehicle.profile);
+      assert(sparse != _sparse_matrices.end());
+      vehicle.cost_wrapper.set_sparse_durations_matrix(&(sparse->second));
+      continue;
+    }
     vehicle.cost_wrapper.set_durations_matrix(&(search->second));
   }
+
+  // With speed factors known, decide whether intermediate gains
+  // provably fit NarrowGain: any gain expression combines partial
+  // route cost sums, each below the checked bound scaled by the
+  // largest duration factor in the fleet.
+  double max_durations_factor = 0.;
+  for (const auto& vehicle : vehicles) {
+    max_durations_factor =
+      std::max(max_durations_factor, vehicle.cost_wrapper.durations_factor);
+  }
+  _gains_fit_32bit =
+    !_trusted and !vehicles.empty() and
+    static_cast<double>(_matrices_cost_bound) * max_durations_factor <=
+      static_cast<double>(std::numeric_limits<NarrowGain>::max());
+}
+
+void Input::set_vehicle_classes() {
+  // Group vehicles into equivalence classes, lowest rank first so a
+  // class is always represented by its first vehicle. Large fleets
+  // of interchangeable vehicles collapse to a handful of classes,
+  // which both shrinks per-vehicle cost planes in SolutionState and
+  // lets local search skip symmetric moves. Quadratic in the number
+  // of classes only.
+  _vehicle_class.assign(vehicles.size(), 0);
+  _vehicle_cost_class.assign(vehicles.size(), 0);
+  _vehicle_cost_class_reps.clear();
+
+  std::vector<Index> class_reps;
+
+  for (std::size_t v = 0; v < vehicles.size(); ++v) {
+    const auto& vehicle = vehicles[v];
+
+    auto cost_rep =
+      std::find_if(_vehicle_cost_class_reps.begin(),
+                   _vehicle_cost_class_reps.end(),
+                   [&](const Index rep) {
+                     return vehicle.has_same_profile(vehicles[rep]);
+                   });
+    _vehicle_cost_class[v] = static_cast<Index>(
+      std::distance(_vehicle_cost_class_reps.begin(), cost_rep));
+    if (cost_rep == _vehicle_cost_class_reps.end()) {
+      _vehicle_cost_class_reps.push_back(static_cast<Index>(v));
+    }
+
+    auto rep = std::find_if(class_reps.begin(),
+                            class_reps.end(),
+                            [&](const Index r) {
+                              return vehicle
+                                .is_interchangeable_with(vehicles[r]);
+                            });
+    _vehicle_class[v] =
+      static_cast<Index>(std::distance(class_reps.begin(), rep));
+    if (rep == class_reps.end()) {
+      class_reps.push_back(static_cast<Index>(v));
+    }
+  }
+}
+
+void Input::compact_matrices() {
+  if (!compact_durations_enabled()) {
+    return;
+  }
+
+  for (const auto& m : _matrices) {
+    const auto& matrix = m.second;
+    const std::size_t nb_values = matrix.size() * matrix.size();
+    if (nb_values == 0) {
+      continue;
+    }
+
+    const auto existing = _compact_matrices.find(m.first);
+    if (existing != _compact_matrices.end()) {
+      if (existing->second.size() == matrix.size()) {
+        // Already compacted on a previous solve.
+        continue;
+      }
+      // The duration matrix grew since the last solve, so the compact
+      // copy is stale and must be rebuilt at the new size.
+      _compact_matrices.erase(existing);
+    }
+
+    const Cost* data = matrix[0];
+    const bool fits =
+      std::all_of(data, data + nb_values, [](const Cost c) {
+        return c <= std::numeric_limits<CompactCost>::max();
+      });
+    if (!fits) {
+      // Matrix kept as 32-bit, e.g. long-haul durations past 18 hours.
+      continue;
+    }
+
+    Matrix<CompactCost> compact(matrix.size());
+    std::transform(data, data + nb_values, compact[0], [](const Cost c) {
+      return static_cast<CompactCost>(c);
+    });
+    _compact_matrices.emplace(m.first, std::move(compact));
+  }
+
+  for (auto& vehicle : vehicles) {
+    const auto derived = _derived_profiles.find(vehicle.profile);
+    const auto& profile = (derived != _derived_profiles.end())
+                            ? derived->second.base
+                            : vehicle.profile;
+    auto search = _compact_matrices.find(profile);
+    if (search != _compact_matrices.end()) {
+      vehicle.cost_wrapper.set_compact_durations_matrix(&(search->second));
+    }
+  }
+}
+
+void Input::set_cluster_bounds() {
+  if (_matrices.empty() or _locations.empty()) {
+    return;
+  }
+
+  const std::size_t idx_size =
+    static_cast<std::size_t>(_max_matrices_used_index) + 1;
+  if (_location_cluster.size() == idx_size) {
+    // Already built for the current locations on a previous solve.
+    return;
+  }
+
+  const std::size_t nb_clusters = std::min<std::size_t>(64, _locations.size());
+
+  // Cluster leaders are the first locations in input order, then
+  // every location joins the leader it is closest to in the first
+  // matrix. Coarse on purpose: only the min inter-cluster durations
+  // below matter, and a slightly off assignment just weakens bounds.
+  const auto& first_m = _matrices.begin()->second;
+  std::vector<Index> leaders(nb_clusters);
+  for (std::size_t c = 0; c < nb_clusters; ++c) {
+    leaders[c] = _locations[c].index();
+  }
+
+  _location_cluster.assign(idx_size, 0);
+  for (const auto& loc : _locations) {
+    const auto i = loc.index();
+    Cost best_d = std::numeric_limits<Cost>::max();
+    for (std::size_t c = 0; c < nb_clusters; ++c) {
+      const Cost d = first_m[leaders[c]][i] + first_m[i][leaders[c]];
+      if (d < best_d) {
+        best_d = d;
+        _location_cluster[i] = static_cast<Index>(c);
+      }
+    }
+  }
+
+  _cluster_duration_lb = Matrix<Cost>(nb_clusters);
+  for (std::size_t c1 = 0; c1 < nb_clusters; ++c1) {
+    std::fill_n(_cluster_duration_lb[c1],
+                nb_clusters,
+                std::numeric_limits<Cost>::max());
+  }
+
+  for (const auto& m : _matrices) {
+    const auto& matrix = m.second;
+    for (const auto& loc_i : _locations) {
+      const auto i = loc_i.index();
+      const auto c1 = _location_cluster[i];
+      auto* lb_row = _cluster_duration_lb[c1];
+      const auto* m_row = matrix[i];
+      for (const auto& loc_j : _locations) {
+        const auto j = loc_j.index();
+        lb_row[_location_cluster[j]] =
+          std::min(lb_row[_location_cluster[j]], m_row[j]);
+      }
+    }
+  }
+
+  // Derived profile overrides replace base cells before scaling and
+  // may undercut them, so they enter the min as well. The scaling
+  // factors themselves are folded into vehicle durations_factor, see
+  // set_vehicles_costs, hence the global vehicle minimum below.
+  for (const auto& derived : _derived_profiles) {
+    for (const auto& [i, j, d] : derived.second.overrides) {
+      auto& lb = _cluster_duration_lb[_location_cluster[i]]
+                                     [_location_cluster[j]];
+      lb = std::min(lb, d);
+    }
+  }
+
+  double factor_min = 1.;
+  for (const auto& vehicle : vehicles) {
+    factor_min = std::min(factor_min, vehicle.cost_wrapper.durations_factor);
+  }
+  if (factor_min < 1.) {
+    for (std::size_t c1 = 0; c1 < nb_clusters; ++c1) {
+      for (std::size_t c2 = 0; c2 < nb_clusters; ++c2) {
+        _cluster_duration_lb[c1][c2] = static_cast<Cost>(
+          factor_min * static_cast<double>(_cluster_duration_lb[c1][c2]));
+      }
+    }
+  }
+}
+
+void Input::set_jobs_neighborhood(unsigned exploration_level) {
+  // Only mark for each job its nearest other jobs duration-wise, in
+  // either direction and for any profile. A deeper exploration level
+  // buys wider neighborhoods, hence more candidate moves in local
+  // search.
+  const std::size_t nb_neighbors =
+    std::min<std::size_t>(jobs.size(), 10 * (exploration_level + 1));
+
+  const std::size_t nb_words = (jobs.size() + 63) / 64;
+  _jobs_neighborhood =
+    std::vector<std::vector<uint64_t>>(jobs.size(),
+                                       std::vector<uint64_t>(nb_words, 0));
+
+  if (nb_neighbors == jobs.size()) {
+    // No pruning possible.
+    for (auto& neighbors : _jobs_neighborhood) {
+      std::fill(neighbors.begin(), neighbors.end(), ~0ULL);
+    }
+    return;
+  }
+
+  std::vector<Index> ranks_by_duration(jobs.size());
+  std::vector<Cost> durations(jobs.size());
+
+  for (Index j1 = 0; j1 < jobs.size(); ++j1) {
+    for (Index j2 = 0; j2 < jobs.size(); ++j2) {
+      Cost duration = std::numeric_limits<Cost>::max();
+      for (const auto& m : _matrices) {
+        duration =
+          std::min(duration, m.second(jobs[j1].index(), jobs[j2].index()));
+        duration =
+          std::min(duration, m.second(jobs[j2].index(), jobs[j1].index()));
+      }
+      durations[j2] = duration;
+    }
+
+    std::iota(ranks_by_duration.begin(), ranks_by_duration.end(), 0);
+    std::partial_sort(ranks_by_duration.begin(),
+                      ranks_by_duration.begin() + nb_neighbors + 1,
+                      ranks_by_duration.end(),
+                      [&](Index lhs, Index rhs) {
+                        return durations[lhs] < durations[rhs];
+                      });
+
+    // Mark neighbors both ways so the relation is symmetric. Job j1
+    // itself is trivially first in the sorted ranks and marking it is
+    // harmless.
+    for (std::size_t n = 0; n <= nb_neighbors; ++n) {
+      const auto j2 = ranks_by_duration[n];
+      _jobs_neighborhood[j1][j2 >> 6] |= 1ULL << (j2 & 63);
+      _jobs_neighborhood[j2][j1 >> 6] |= 1ULL << (j1 & 63);
+    }
+  }
 }
 
 void Input::set_matrices(unsigned nb_thread) {
@@ -530,33 +1516,122 @@ void Input::set_matrices(unsigned nb_thread) {
     throw Exception(ERROR::INPUT, "Missing location index.");
   }
 
+  // Derived profiles read from their base matrix, so only plain
+  // profiles get a matrix of their own.
+  std::unordered_set<std::string> plain_profiles;
+  for (const auto& profile : _profiles) {
+    const auto derived = _derived_profiles.find(profile);
+    if (derived == _derived_profiles.end()) {
+      plain_profiles.insert(profile);
+    } else {
+      plain_profiles.insert(derived->second.base);
+    }
+  }
+
   // Split computing matrices across threads based on number of
   // profiles.
   const auto nb_buckets =
-    std::min(nb_thread, static_cast<unsigned>(_profiles.size()));
+    std::min(nb_thread, static_cast<unsigned>(plain_profiles.size()));
 
   std::vector<std::vector<std::string>>
     thread_profiles(nb_buckets, std::vector<std::string>());
 
   std::size_t t_rank = 0;
-  for (const auto& profile : _profiles) {
+  for (const auto& profile : plain_profiles) {
     thread_profiles[t_rank % nb_buckets].push_back(profile);
     ++t_rank;
     if (_custom_matrices.find(profile) == _custom_matrices.end()) {
       // Matrix has not been manually set, create routing wrapper and
-      // empty matrix to allow for concurrent modification later on.
-      add_routing_wrapper(profile);
-      assert(_matrices.find(profile) == _matrices.end());
-      _matrices.emplace(profile, Matrix<Cost>());
+      // empty matrix to allow for concurrent modification later
+      // on. Both survive across solves on the same Input so they are
+      // only created once, and a clone sharing an already fetched
+      // matrix still gets its own wrapper for incremental fetches.
+      if (std::none_of(_routing_wrappers.begin(),
+                       _routing_wrappers.end(),
+                       [&](const auto& wr) {
+                         return wr->profile == profile;
+                       })) {
+        add_routing_wrapper(profile);
+      }
+      if (_matrices.find(profile) == _matrices.end()) {
+        _matrices.emplace(profile, Matrix<Cost>());
+      }
     }
   }
 
   std::exception_ptr ep = nullptr;
   std::mutex ep_m;
 
+  // Largest checked cost bound across profiles, merged from the
+  // concurrent overflow scans below.
+  std::atomic<Cost> checked_bound(0);
+
+  // Location ranks actually needed as sources and targets for a
+  // plain profile: job locations count both ways, while vehicle
+  // start locations are never arrived at and end locations never
+  // departed from. Rows and columns only used by vehicles of other
+  // profiles are skipped altogether.
+  auto used_ranks = [this](const std::string& plain_profile) {
+    std::vector<bool> is_source(_locations.size(), false);
+    std::vector<bool> is_target(_locations.size(), false);
+
+    for (const auto& job : jobs) {
+      const auto rank = _locations_to_index.find(job.location)->second;
+      is_source[rank] = true;
+      is_target[rank] = true;
+    }
+    for (const auto& vehicle : vehicles) {
+      const auto derived = _derived_profiles.find(vehicle.profile);
+      const auto& base = (derived != _derived_profiles.end())
+                           ? derived->second.base
+                           : vehicle.profile;
+      if (base != plain_profile) {
+        continue;
+      }
+      if (vehicle.has_start()) {
+        is_source[_locations_to_index.find(vehicle.start.value())->second] =
+          true;
+      }
+      if (vehicle.has_end()) {
+        is_target[_locations_to_index.find(vehicle.end.value())->second] =
+          true;
+      }
+    }
+
+    std::pair<std::vector<Index>, std::vector<Index>> ranks;
+    for (Index i = 0; i < _locations.size(); ++i) {
+      if (is_source[i]) {
+        ranks.first.push_back(i);
+      }
+      if (is_target[i]) {
+        ranks.second.push_back(i);
+      }
+    }
+    return ranks;
+  };
+
   auto run_on_profiles = [&](const std::vector<std::string>& profiles) {
     try {
       for (const auto& profile : profiles) {
+        const auto sparse = _sparse_matrices.find(profile);
+        if (sparse != _sparse_matrices.end()) {
+          // Nothing to fetch or grow: just run the checks their
+          // dense counterparts get below.
+          if (sparse->second.size() <= _max_matrices_used_index) {
+            throw Exception(ERROR::INPUT,
+                            "location_index exceeding matrix size for " +
+                              profile + " profile.");
+          }
+          if (!_trusted) {
+            const auto bound = check_cost_bound(sparse->second);
+            auto current = checked_bound.load();
+            while (current < bound and
+                   !checked_bound.compare_exchange_weak(current, bound)) {
+            }
+          }
+          continue;
+        }
+
         auto p_m = _matrices.find(profile);
         assert(p_m != _matrices.end());
 
@@ -572,25 +1647,95 @@ void Input::set_matrices(unsigned nb_thread) {
                                    });
             assert(rw != _routing_wrappers.end());
 
+            const auto ranks = used_ranks(profile);
+            const bool square_fetch =
+              (ranks.first.size() == _locations.size() and
+               ranks.second.size() == _locations.size());
+
+            // Check the on-disk cache before hitting the routing
+            // server, then store whatever we fetched for later
+            // runs. Rectangular fetches are not cached since their
+            // skipped cells would read back as valid zeros.
+            auto m = utils::load_cached_matrix(profile, _locations);
+            if (!m.has_value()) {
+              if (ranks.first.empty() or ranks.second.empty()) {
+                // No cell of this matrix is ever read.
+                m = Matrix<Cost>(_locations.size());
+              } else {
+                m = (*rw)->get_matrix(_locations, ranks.first, ranks.second);
+                if (square_fetch) {
+                  utils::save_cached_matrix(profile, _locations, m.value());
+                }
+              }
+            }
+
             if (!_has_custom_location_index) {
               // Location indices are set based on order in _locations.
-              p_m->second = (*rw)->get_matrix(_locations);
+              p_m->second = std::move(m.value());
             } else {
               // Location indices are provided in input so we need an
               // indirection based on order in _locations.
-              auto m = (*rw)->get_matrix(_locations);
 
+              const auto& sorted_m = m.value();
               Matrix<Cost> full_m(_max_matrices_used_index + 1);
               for (Index i = 0; i < _locations.size(); ++i) {
                 const auto& loc_i = _locations[i];
                 for (Index j = 0; j < _locations.size(); ++j) {
-                  full_m[loc_i.index()][_locations[j].index()] = m[i][j];
+                  full_m[loc_i.index()][_locations[j].index()] = sorted_m[i][j];
                 }
               }
 
               p_m->second = std::move(full_m);
             }
+
+            p_m->second.detect_symmetry();
+          }
+        } else if (_custom_matrices.find(profile) == _custom_matrices.end() and
+                   !_has_custom_location_index and
+                   p_m->second.size() < _locations.size()) {
+          // Matrix fetched on a previous solve and locations were
+          // added since, as in rolling-horizon workflows feeding the
+          // same Input. Only fetch the new rows and the new columns
+          // for existing rows instead of the whole matrix again.
+          auto rw = std::find_if(_routing_wrappers.begin(),
+                                 _routing_wrappers.end(),
+                                 [&](const auto& wr) {
+                                   return wr->profile == profile;
+                                 });
+          assert(rw != _routing_wrappers.end());
+
+          const std::size_t old_size = p_m->second.size();
+          std::vector<Index> old_ranks(old_size);
+          std::iota(old_ranks.begin(), old_ranks.end(), 0);
+          std::vector<Index> new_ranks(_locations.size() - old_size);
+          std::iota(new_ranks.begin(),
+                    new_ranks.end(),
+                    static_cast<Index>(old_size));
+          std::vector<Index> all_ranks(_locations.size());
+          std::iota(all_ranks.begin(), all_ranks.end(), 0);
+
+          // Two rectangular table queries cover all missing cells:
+          // new sources to everything, then existing sources to new
+          // targets. Partial fetches are never written to the disk
+          // cache, consistent with rectangular fetches above.
+          const auto new_rows =
+            (*rw)->get_matrix(_locations, new_ranks, all_ranks);
+          const auto new_cols =
+            (*rw)->get_matrix(_locations, old_ranks, new_ranks);
+
+          p_m->second.grow(_locations.size());
+          for (const auto i : new_ranks) {
+            std::copy(new_rows[i],
+                      new_rows[i] + _locations.size(),
+                      p_m->second[i]);
+          }
+          for (const auto i : old_ranks) {
+            for (const auto j : new_ranks) {
+              p_m->second[i][j] = new_cols[i][j];
+            }
           }
+
+          p_m->second.detect_symmetry();
         }
 
         if (p_m->second.size() <= _max_matrices_used_index) {
@@ -599,8 +1744,16 @@ void Input::set_matrices(unsigned nb_thread) {
                             profile + " profile.");
         }
 
-        // Check for potential overflow in solution cost.
-        check_cost_bound(p_m->second);
+        if (!_trusted) {
+          // Check for potential overflow in solution cost.
+          const auto bound = check_cost_bound(p_m->second);
+          auto current = checked_bound.load();
+          while (current < bound and
+                 !checked_bound.compare_exchange_weak(current, bound)) {
+          }
+        }
+
+        VROOM_TRACE2(matrix_ready, profile.c_str(), p_m->second.size());
       }
     } catch (...) {
       ep_m.lock();
@@ -609,103 +1762,82 @@ void Input::set_matrices(unsigned nb_thread) {
     }
   };
 
-  std::vector<std::thread> matrix_threads;
+  std::vector<std::function<void()>> matrix_tasks;
 
   for (const auto& profiles : thread_profiles) {
-    matrix_threads.emplace_back(run_on_profiles, profiles);
+    matrix_tasks.push_back([&run_on_profiles, profiles]() {
+      run_on_profiles(profiles);
+    });
   }
 
-  for (auto& t : matrix_threads) {
-    t.join();
-  }
+  utils::ThreadPool::instance().run(std::move(matrix_tasks));
 
   if (ep != nullptr) {
     std::rethrow_exception(ep);
   }
-}
 
-std::unique_ptr<VRP> Input::get_problem() const {
-  if (_has_TW) {
-    return std::make_unique<VRPTW>(*this);
-  } else {
-    return std::make_unique<CVRP>(*this);
-  }
+  _matrices_cost_bound = std::max(_matrices_cost_bound, checked_bound.load());
+
+  interleave_matrices();
 }
 
-Solution Input::solve(unsigned exploration_level,
-                      unsigned nb_thread,
-                      const std::vector<HeuristicParameters>& h_param) {
-  if (_geometry and !_all_locations_have_coords) {
-    // Early abort when info is required with missing coordinates.
-    throw Exception(ERROR::INPUT,
-                    "Route geometry request with missing coordinates.");
+void Input::interleave_matrices() {
+  if (!utils::has_multiple_numa_nodes()) {
+    return;
   }
 
-  set_matrices(nb_thread);
-  set_vehicles_costs();
-
-  // Fill vehicle/job compatibility matrices.
-  set_skills_compatibility();
-  set_extra_compatibility();
-  set_vehicles_compatibility();
-
-  // Load relevant problem.
-  auto instance = get_problem();
-  _end_loading = std::chrono::high_resolution_clock::now();
-
-  auto loading = std::chrono::duration_cast<std::chrono::milliseconds>(
-                   _end_loading - _start_loading)
-                   .count();
-
-  // Solve.
-  auto sol = instance->solve(exploration_level, nb_thread, h_param);
-
-  // Update timing info.
-  sol.summary.computing_times.loading = loading;
-
-  _end_solving = std::chrono::high_resolution_clock::now();
-  sol.summary.computing_times.solving =
-    std::chrono::duration_cast<std::chrono::milliseconds>(_end_solving -
-                                                          _end_loading)
-      .count();
+  for (auto& m : _matrices) {
+    auto& matrix = m.second;
+    const std::size_t nb_values = matrix.size() * matrix.size();
 
-  if (_geometry) {
-    for (auto& route : sol.routes) {
-      const auto& profile = route.profile;
-      auto rw =
-        std::find_if(_routing_wrappers.begin(),
-                     _routing_wrappers.end(),
-                     [&](const auto& wr) { return wr->profile == profile; });
-      if (rw == _routing_wrappers.end()) {
-        throw Exception(ERROR::INPUT,
-                        "Route geometry request with non-routable profile " +
-                          profile + ".");
-      }
-      (*rw)->add_route_info(route);
-
-      sol.summary.distance += route.distance;
+    // Views wrap external storage we do not own, and matrices below a
+    // handful of pages are not worth a pass.
+    if (matrix.is_view() or nb_values * sizeof(Cost) < (1 << 20)) {
+      continue;
     }
 
-    _end_routing = std::chrono::high_resolution_clock::now();
-    auto routing = std::chrono::duration_cast<std::chrono::milliseconds>(
-                     _end_routing - _end_solving)
-                     .count();
-
-    sol.summary.computing_times.routing = routing;
+    Cost* data = matrix[0];
+
+    // Save content, then drop the backing pages so the parallel
+    // copy-back below re-faults each page on the node of the pinned
+    // worker touching it first.
+    std::vector<Cost> values(data, data + nb_values);
+    utils::drop_pages(data, nb_values * sizeof(Cost));
+
+    const auto nb_workers =
+      std::max(1u, std::thread::hardware_concurrency());
+    // Chunks are page-sized multiples so workers mostly fault
+    // distinct pages.
+    constexpr std::size_t granularity = 4096 / sizeof(Cost);
+    const std::size_t chunk =
+      ((nb_values / nb_workers) / granularity + 1) * granularity;
+
+    std::vector<std::function<void()>> interleave_tasks;
+    for (std::size_t start = 0; start < nb_values; start += chunk) {
+      const auto end = std::min(start + chunk, nb_values);
+      interleave_tasks.push_back([data, &values, start, end]() {
+        std::copy(values.begin() + start, values.begin() + end, data + start);
+      });
+    }
+    utils::ThreadPool::instance().run(std::move(interleave_tasks));
   }
-
-  return sol;
 }
 
-Solution Input::check(unsigned nb_thread) {
-#if USE_LIBGLPK
-  if (_geometry and !_all_locations_have_coords) {
-    // Early abort when info is required with missing coordinates.
-    throw Exception(ERROR::INPUT,
-                    "Route geometry request with missing coordinates.");
+std::unique_ptr<VRP> Input::get_problem() const {
+  if (_has_TW) {
+    return std::make_unique<VRPTW>(*this);
+  } else {
+    return std::make_unique<CVRP>(*this);
   }
+}
+
+bool Input::has_initial_routes() const {
+  return std::any_of(vehicles.begin(), vehicles.end(), [](const auto& v) {
+    return !v.steps.empty();
+  });
+}
 
-  // Set all ranks for vehicles steps.
+void Input::set_vehicle_steps_ranks() {
   std::unordered_set<Id> planned_job_ids;
   std::unordered_set<Id> planned_pickup_ids;
   std::unordered_set<Id> planned_delivery_ids;
@@ -791,13 +1923,984 @@ Solution Input::check(unsigned nb_thread) {
       }
     }
   }
+}
+
+std::vector<std::vector<Index>>
+Input::sweep_job_clusters(std::size_t nb_clusters) const {
+  assert(_all_locations_have_coords);
+  assert(nb_clusters > 0);
+
+  double lon_sum = 0;
+  double lat_sum = 0;
+  for (const auto& job : jobs) {
+    lon_sum += job.location.lon();
+    lat_sum += job.location.lat();
+  }
+  const double lon_center = lon_sum / jobs.size();
+  const double lat_center = lat_sum / jobs.size();
+
+  auto job_angle = [&](Index j) {
+    return std::atan2(jobs[j].location.lat() - lat_center,
+                      jobs[j].location.lon() - lon_center);
+  };
+
+  // Only single jobs and pickups seed the sweep, a delivery follows
+  // its matching pickup.
+  std::vector<Index> seed_ranks;
+  for (Index j = 0; j < jobs.size(); ++j) {
+    if (jobs[j].type != JOB_TYPE::DELIVERY) {
+      seed_ranks.push_back(j);
+    }
+  }
+
+  std::sort(seed_ranks.begin(), seed_ranks.end(), [&](Index a, Index b) {
+    return job_angle(a) < job_angle(b);
+  });
+
+  // Slice the sweep into contiguous sectors holding the same number
+  // of seeds.
+  std::vector<std::vector<Index>> clusters(nb_clusters);
+  const std::size_t seeds_per_cluster =
+    (seed_ranks.size() + nb_clusters - 1) / nb_clusters;
+
+  for (std::size_t s = 0; s < seed_ranks.size(); ++s) {
+    auto& cluster = clusters[s / seeds_per_cluster];
+    cluster.push_back(seed_ranks[s]);
+    if (jobs[seed_ranks[s]].type == JOB_TYPE::PICKUP) {
+      // Matching delivery is stored next in jobs.
+      cluster.push_back(seed_ranks[s] + 1);
+    }
+  }
+
+  return clusters;
+}
+
+void Input::apply_decomposition(unsigned exploration_level,
+                                unsigned nb_thread,
+                                const Deadline& deadline) {
+  // Target subproblems of around a thousand jobs, bounded by the
+  // number of available vehicles.
+  const auto nb_clusters =
+    std::min<std::size_t>(vehicles.size(), (jobs.size() + 999) / 1000);
+  if (nb_clusters < 2) {
+    return;
+  }
+
+  unsigned sub_timeout = 0;
+  if (deadline.has_value()) {
+    const auto remaining =
+      std::chrono::duration_cast<std::chrono::seconds>(
+        deadline.value() - std::chrono::high_resolution_clock::now())
+        .count();
+    if (remaining <= 0) {
+      return;
+    }
+    // Leave half the remaining budget for the final pass across
+    // clusters.
+    sub_timeout = std::max<long>(1, remaining / 2);
+  }
+
+  auto clusters = sweep_job_clusters(nb_clusters);
+
+  // Mean coordinates per cluster, used to dispatch vehicles.
+  std::vector<Coordinates> centers(nb_clusters, {0, 0});
+  for (std::size_t c = 0; c < nb_clusters; ++c) {
+    for (const auto j : clusters[c]) {
+      centers[c][0] += jobs[j].location.lon();
+      centers[c][1] += jobs[j].location.lat();
+    }
+    if (!clusters[c].empty()) {
+      centers[c][0] /= clusters[c].size();
+      centers[c][1] /= clusters[c].size();
+    }
+  }
+
+  // Assign each vehicle to the cluster whose center is closest to
+  // its start (or end) location.
+  std::vector<std::vector<Index>> cluster_vehicles(nb_clusters);
+  for (Index v = 0; v < vehicles.size(); ++v) {
+    const auto& loc =
+      vehicles[v].has_start() ? vehicles[v].start.value()
+                              : vehicles[v].end.value();
+    std::size_t best_cluster = 0;
+    double best_distance = std::numeric_limits<double>::max();
+    for (std::size_t c = 0; c < nb_clusters; ++c) {
+      const double lon_diff = loc.lon() - centers[c][0];
+      const double lat_diff = loc.lat() - centers[c][1];
+      const double distance = lon_diff * lon_diff + lat_diff * lat_diff;
+      if (distance < best_distance) {
+        best_distance = distance;
+        best_cluster = c;
+      }
+    }
+    cluster_vehicles[best_cluster].push_back(v);
+  }
+
+  // Make sure each cluster gets at least one vehicle, taking from
+  // the most crowded cluster.
+  for (std::size_t c = 0; c < nb_clusters; ++c) {
+    while (cluster_vehicles[c].empty()) {
+      auto biggest =
+        std::max_element(cluster_vehicles.begin(),
+                         cluster_vehicles.end(),
+                         [](const auto& lhs, const auto& rhs) {
+                           return lhs.size() < rhs.size();
+                         });
+      assert(biggest->size() > 1);
+      cluster_vehicles[c].push_back(biggest->back());
+      biggest->pop_back();
+    }
+  }
+
+  std::unordered_map<Id, Index> vehicle_id_to_rank;
+  for (Index v = 0; v < vehicles.size(); ++v) {
+    vehicle_id_to_rank.emplace(vehicles[v].id, v);
+  }
+
+  auto solve_cluster = [&](std::size_t c, unsigned sub_nb_thread) {
+    Input sub_input(_amount_size);
+    // Subproblems are derived from an already validated instance.
+    sub_input.set_trusted(true);
+    sub_input.reserve(clusters[c].size(), cluster_vehicles[c].size());
+
+    // Map matrix indices in current instance to their rank in the
+    // subproblem matrices.
+    std::unordered_map<Index, Index> sub_location_rank;
+    auto sub_location = [&](const Location& loc) {
+      auto search = sub_location_rank.find(loc.index());
+      if (search == sub_location_rank.end()) {
+        const Index sub_rank = sub_location_rank.size();
+        search = sub_location_rank.emplace(loc.index(), sub_rank).first;
+      }
+      return Location(search->second,
+                      Coordinates({loc.lon(), loc.lat()}));
+    };
+
+    std::unordered_set<std::string> sub_profiles;
+    for (const auto v : cluster_vehicles[c]) {
+      const auto& vehicle = vehicles[v];
+      std::optional<Location> start;
+      if (vehicle.has_start()) {
+        start = sub_location(vehicle.start.value());
+      }
+      std::optional<Location> end;
+      if (vehicle.has_end()) {
+        end = sub_location(vehicle.end.value());
+      }
+      sub_input.add_vehicle(Vehicle(vehicle.id,
+                                    start,
+                                    end,
+                                    vehicle.profile,
+                                    vehicle.capacity,
+                                    vehicle.skills,
+                                    vehicle.tw,
+                                    vehicle.breaks,
+                                    vehicle.description,
+                                    1. /
+                                      vehicle.cost_wrapper.durations_factor));
+      sub_profiles.insert(vehicle.profile);
+    }
+
+    for (const auto j : clusters[c]) {
+      const auto& job = jobs[j];
+      switch (job.type) {
+      case JOB_TYPE::SINGLE:
+        sub_input.add_job(Job(job.id,
+                              sub_location(job.location),
+                              job.service,
+                              job.delivery,
+                              job.pickup,
+                              job.skills,
+                              job.priority,
+                              job.tws,
+                              job.description));
+        break;
+      case JOB_TYPE::PICKUP: {
+        // Matching delivery is stored next in jobs.
+        const auto& d_job = jobs[j + 1];
+        sub_input.add_shipment(Job(job.id,
+                                   JOB_TYPE::PICKUP,
+                                   sub_location(job.location),
+                                   job.service,
+                                   job.pickup,
+                                   job.skills,
+                                   job.priority,
+                                   job.tws,
+                                   job.description),
+                               Job(d_job.id,
+                                   JOB_TYPE::DELIVERY,
+                                   sub_location(d_job.location),
+                                   d_job.service,
+                                   d_job.delivery,
+                                   d_job.skills,
+                                   d_job.priority,
+                                   d_job.tws,
+                                   d_job.description));
+        break;
+      }
+      case JOB_TYPE::DELIVERY:
+        // Already added along with its pickup.
+        break;
+      }
+    }
+
+    // Materialize submatrices from the already computed matrices.
+    // Derived profiles get their transform baked into the (small)
+    // submatrix copy so sub-solving treats them as plain profiles.
+    for (const auto& profile : sub_profiles) {
+      const auto derived = _derived_profiles.find(profile);
+      const bool is_derived = (derived != _derived_profiles.end());
+
+      const auto sparse = _sparse_matrices.find(profile);
+      if (!is_derived and sparse != _sparse_matrices.end()) {
+        // Materialize a small dense submatrix out of the sparse
+        // store, absent pairs keeping their fallback bound.
+        Matrix<Cost> sub_matrix(sub_location_rank.size());
+        for (const auto& [i, sub_i] : sub_location_rank) {
+          for (const auto& [j, sub_j] : sub_location_rank) {
+            sub_matrix[sub_i][sub_j] = sparse->second(i, j);
+          }
+        }
+        sub_input.set_matrix(profile, std::move(sub_matrix));
+        continue;
+      }
+
+      const auto& matrix =
+        _matrices.at(is_derived ? derived->second.base : profile);
+
+      Matrix<Cost> sub_matrix(sub_location_rank.size());
+      for (const auto& [i, sub_i] : sub_location_rank) {
+        for (const auto& [j, sub_j] : sub_location_rank) {
+          Cost value = matrix[i][j];
+          if (is_derived) {
+            const auto search = derived->second.override_map.find(
+              static_cast<uint64_t>(i) * matrix.size() + j);
+            if (search != derived->second.override_map.end()) {
+              value = search->second;
+            }
+            value = static_cast<Cost>(derived->second.factor *
+                                      static_cast<double>(value));
+          }
+          sub_matrix[sub_i][sub_j] = value;
+        }
+      }
+      sub_input.set_matrix(profile, std::move(sub_matrix));
+    }
+
+    auto sub_sol = sub_input.solve(exploration_level,
+                                   sub_nb_thread,
+                                   sub_timeout);
+
+    // Store subproblem routes as vehicle steps. Each vehicle belongs
+    // to a single cluster so no two threads ever write to the same
+    // vehicle.
+    for (const auto& route : sub_sol.routes) {
+      auto& steps = vehicles[vehicle_id_to_rank.at(route.vehicle)].steps;
+      assert(steps.empty());
+      for (const auto& step : route.steps) {
+        if (step.step_type == STEP_TYPE::JOB) {
+          steps.emplace_back(step.job_type, step.id, ForcedService());
+        }
+      }
+    }
+  };
+
+  // Solve clusters in parallel, splitting available threads across
+  // concurrent subproblems.
+  const auto nb_buckets =
+    std::min(nb_thread, static_cast<unsigned>(nb_clusters));
+  const auto sub_nb_thread = std::max<unsigned>(1, nb_thread / nb_buckets);
+
+  std::atomic<std::size_t> next_cluster(0);
+
+  std::exception_ptr ep = nullptr;
+  std::mutex ep_m;
+
+  auto run_clusters = [&]() {
+    try {
+      while (true) {
+        const auto c = next_cluster.fetch_add(1);
+        if (c >= nb_clusters) {
+          break;
+        }
+        solve_cluster(c, sub_nb_thread);
+      }
+    } catch (...) {
+      ep_m.lock();
+      ep = std::current_exception();
+      ep_m.unlock();
+    }
+  };
+
+  std::vector<std::function<void()>> cluster_tasks(nb_buckets, run_clusters);
+  utils::ThreadPool::instance().run(std::move(cluster_tasks));
+
+  if (ep != nullptr) {
+    std::rethrow_exception(ep);
+  }
+}
+
+void Input::merge_colocated_jobs() {
+  // Bucket single-job ranks per matrix index.
+  std::unordered_map<Index, std::vector<Index>> ranks_at_location;
+  for (std::size_t j = 0; j < jobs.size(); ++j) {
+    if (jobs[j].type == JOB_TYPE::SINGLE) {
+      ranks_at_location[jobs[j].index()].push_back(static_cast<Index>(j));
+    }
+  }
+
+  const auto same_tws = [](const std::vector<TimeWindow>& lhs,
+                           const std::vector<TimeWindow>& rhs) {
+    return lhs.size() == rhs.size() and
+           std::equal(lhs.begin(),
+                      lhs.end(),
+                      rhs.begin(),
+                      [](const auto& l, const auto& r) {
+                        return l.start == r.start and l.end == r.end;
+                      });
+  };
+
+  // Partition each bucket into groups sharing time windows and
+  // skills, in input order.
+  std::unordered_map<Index, Job> merged_at_rank;
+  std::unordered_set<Index> absorbed;
+  for (const auto& [location, ranks] : ranks_at_location) {
+    if (ranks.size() < 2) {
+      continue;
+    }
+    std::vector<std::vector<Index>> groups;
+    for (const auto j : ranks) {
+      auto group =
+        std::find_if(groups.begin(), groups.end(), [&](const auto& g) {
+          const auto& first = jobs[g.front()];
+          return first.skills == jobs[j].skills and
+                 same_tws(first.tws, jobs[j].tws);
+        });
+      if (group != groups.end()) {
+        group->push_back(j);
+      } else {
+        groups.push_back({j});
+      }
+    }
+
+    for (const auto& group : groups) {
+      if (group.size() < 2) {
+        continue;
+      }
+
+      Duration total_service = 0;
+      Amount delivery(_zero);
+      Amount pickup(_zero);
+      Priority priority = 0;
+      for (const auto j : group) {
+        total_service += jobs[j].service;
+        delivery += jobs[j].delivery;
+        pickup += jobs[j].pickup;
+        priority += jobs[j].priority;
+      }
+
+      // Inside the super-job, job k starts its service right after
+      // job k - 1, so shrinking the time window ends by the service
+      // time piled up before the last job keeps every original start
+      // within its own window.
+      const Duration shrink = total_service - jobs[group.back()].service;
+      std::vector<TimeWindow> tws;
+      bool tws_valid = true;
+      for (const auto& tw : jobs[group.front()].tws) {
+        if (tw.end < tw.start + shrink) {
+          tws_valid = false;
+          break;
+        }
+        tws.emplace_back(tw.start, tw.end - shrink);
+      }
+      if (!tws_valid) {
+        continue;
+      }
+
+      const auto& first = jobs[group.front()];
+      std::vector<Job> originals;
+      originals.reserve(group.size());
+      for (const auto j : group) {
+        originals.push_back(jobs[j]);
+      }
+      _merged_jobs.emplace(first.id, std::move(originals));
+      merged_at_rank.emplace(group.front(),
+                             Job(first.id,
+                                 first.location,
+                                 total_service,
+                                 delivery,
+                                 pickup,
+                                 first.skills,
+                                 priority,
+                                 tws,
+                                 first.description));
+      absorbed.insert(group.begin() + 1, group.end());
+    }
+  }
+
+  if (merged_at_rank.empty()) {
+    return;
+  }
+
+  // Rewrite jobs with each super-job at its leading rank, rebuilding
+  // the rank-dependent tables along the way. Pickup and delivery
+  // pairs keep adjacent ranks as only single jobs are removed.
+  std::vector<Job> new_jobs;
+  new_jobs.reserve(jobs.size() - absorbed.size());
+  job_id_to_rank = FlatMap<Id, Index>();
+  pickup_id_to_rank = FlatMap<Id, Index>();
+  delivery_id_to_rank = FlatMap<Id, Index>();
+  _job_skills_masks.clear();
+
+  for (std::size_t j = 0; j < jobs.size(); ++j) {
+    if (absorbed.find(static_cast<Index>(j)) != absorbed.end()) {
+      continue;
+    }
+    const auto search = merged_at_rank.find(static_cast<Index>(j));
+    Job job =
+      (search != merged_at_rank.end()) ? search->second : std::move(jobs[j]);
+
+    const Index rank = static_cast<Index>(new_jobs.size());
+    switch (job.type) {
+    case JOB_TYPE::SINGLE:
+      job_id_to_rank[job.id] = rank;
+      break;
+    case JOB_TYPE::PICKUP:
+      pickup_id_to_rank[job.id] = rank;
+      break;
+    case JOB_TYPE::DELIVERY:
+      delivery_id_to_rank[job.id] = rank;
+      break;
+    }
+    _job_skills_masks.push_back(intern_skills(job.skills));
+    new_jobs.push_back(std::move(job));
+  }
+  jobs = std::move(new_jobs);
+}
+
+void Input::expand_merged_jobs(Solution& sol) const {
+  for (auto& route : sol.routes) {
+    if (std::none_of(route.steps.begin(), route.steps.end(), [&](const auto& step) {
+          return step.step_type == STEP_TYPE::JOB and
+                 step.job_type == JOB_TYPE::SINGLE and
+                 _merged_jobs.find(step.id) != _merged_jobs.end();
+        })) {
+      continue;
+    }
+
+    std::vector<Step> steps;
+    steps.reserve(route.steps.size());
+    for (const auto& step : route.steps) {
+      const auto search = (step.step_type == STEP_TYPE::JOB and
+                           step.job_type == JOB_TYPE::SINGLE)
+                            ? _merged_jobs.find(step.id)
+                            : _merged_jobs.end();
+      if (search == _merged_jobs.end()) {
+        steps.push_back(step);
+        continue;
+      }
+
+      const auto& originals = search->second;
+      Amount total_delivery(_zero);
+      Amount total_pickup(_zero);
+      for (const auto& job : originals) {
+        total_delivery += job.delivery;
+        total_pickup += job.pickup;
+      }
+
+      // step.load holds the load after the whole super-job, walk the
+      // original jobs forward from the load before it. Zero travel
+      // between them: each next service starts when the previous one
+      // ends.
+      Amount current_load = step.load + total_delivery - total_pickup;
+      Duration arrival = step.arrival;
+      for (std::size_t k = 0; k < originals.size(); ++k) {
+        const auto& job = originals[k];
+        current_load += job.pickup;
+        current_load -= job.delivery;
+
+        steps.emplace_back(job, current_load);
+        auto& current = steps.back();
+        current.arrival = arrival;
+        current.duration = step.duration;
+        current.distance = step.distance;
+        if (k == 0) {
+          current.waiting_time = step.waiting_time;
+          current.violations = step.violations;
+        }
+        arrival += current.waiting_time + job.service;
+      }
+    }
+    route.steps = std::move(steps);
+  }
+
+  std::vector<Job> unassigned;
+  unassigned.reserve(sol.unassigned.size());
+  for (const auto& job : sol.unassigned) {
+    const auto search = (job.type == JOB_TYPE::SINGLE)
+                          ? _merged_jobs.find(job.id)
+                          : _merged_jobs.end();
+    if (search == _merged_jobs.end()) {
+      unassigned.push_back(job);
+    } else {
+      for (const auto& original : search->second) {
+        unassigned.push_back(original);
+      }
+    }
+  }
+  sol.summary.unassigned = unassigned.size();
+  sol.unassigned = std::move(unassigned);
+}
+
+Input Input::clone_with(const InputDelta& delta) {
+  Input clone(_amount_size, _servers, _router);
+  clone._trusted = _trusted;
+  clone._geometry = _geometry;
+  clone._deterministic = _deterministic;
+  clone._seed = _seed;
+  clone._memory_budget = _memory_budget;
+  clone._report_memory_stats = _report_memory_stats;
+  clone._derived_profiles = _derived_profiles;
+  clone._custom_matrices = _custom_matrices;
+  clone._has_custom_location_index = _has_custom_location_index;
+
+  // Seed the location maps with the current ranks so shared matrix
+  // cells keep their meaning in the clone. Locations only referenced
+  // by removed jobs keep their rank and simply go unread.
+  clone._locations = _locations;
+  clone._locations_to_index = _locations_to_index;
+
+  // Share every matrix copy-on-write: both instances read the same
+  // buffer, and a clone bringing new locations detaches on its own
+  // grown copy in set_matrices.
+  for (auto& m : _matrices) {
+    clone._matrices.emplace(m.first, m.second.share());
+  }
+
+  // Sparse matrices are already ~100x smaller than their dense
+  // counterpart would be, so a plain copy is affordable.
+  clone._sparse_matrices = _sparse_matrices;
+
+  const std::unordered_set<Id> removed(delta.removed_job_ids.begin(),
+                                       delta.removed_job_ids.end());
+
+  const auto add_if_kept = [&](const Job& job) {
+    if (removed.find(job.id) == removed.end()) {
+      clone.add_job(job);
+    }
+  };
+
+  for (std::size_t j = 0; j < jobs.size(); ++j) {
+    const auto& job = jobs[j];
+    if (job.type == JOB_TYPE::SINGLE) {
+      const auto merged = _merged_jobs.find(job.id);
+      if (merged == _merged_jobs.end()) {
+        add_if_kept(job);
+      } else {
+        // Re-add the original jobs hidden behind a co-located
+        // super-job so removal ids keep matching user-facing ids.
+        for (const auto& original : merged->second) {
+          add_if_kept(original);
+        }
+      }
+    } else if (job.type == JOB_TYPE::PICKUP) {
+      // Its delivery is stored right behind, see add_shipment.
+      assert(j + 1 < jobs.size() and jobs[j + 1].type == JOB_TYPE::DELIVERY);
+      const auto& matching_delivery = jobs[j + 1];
+      if (removed.find(job.id) == removed.end() and
+          removed.find(matching_delivery.id) == removed.end()) {
+        clone.add_shipment(job, matching_delivery);
+      }
+      ++j;
+    }
+  }
+
+  for (std::size_t j = 0; j < delta.added_jobs.size(); ++j) {
+    const auto& job = delta.added_jobs[j];
+    switch (job.type) {
+    case JOB_TYPE::SINGLE:
+      clone.add_job(job);
+      break;
+    case JOB_TYPE::PICKUP:
+      if (j + 1 == delta.added_jobs.size() or
+          delta.added_jobs[j + 1].type != JOB_TYPE::DELIVERY) {
+        throw Exception(ERROR::INPUT,
+                        "Pickup in delta without matching delivery.");
+      }
+      clone.add_shipment(job, delta.added_jobs[j + 1]);
+      ++j;
+      break;
+    case JOB_TYPE::DELIVERY:
+      throw Exception(ERROR::INPUT,
+                      "Delivery in delta without matching pickup.");
+    }
+  }
+
+  std::unordered_map<Id, const Vehicle*> updated;
+  for (const auto& vehicle : delta.updated_vehicles) {
+    updated.emplace(vehicle.id, &vehicle);
+  }
+  for (const auto& vehicle : vehicles) {
+    const auto search = updated.find(vehicle.id);
+    if (search == updated.end()) {
+      clone.add_vehicle(vehicle);
+    } else {
+      clone.add_vehicle(*search->second);
+      updated.erase(search);
+    }
+  }
+  // Remaining updated vehicles have new ids and are plain additions.
+  for (const auto& vehicle : delta.updated_vehicles) {
+    if (updated.find(vehicle.id) != updated.end()) {
+      clone.add_vehicle(vehicle);
+    }
+  }
+
+  return clone;
+}
+
+Solution Input::solve(unsigned exploration_level,
+                      unsigned nb_thread,
+                      unsigned timeout,
+                      const std::vector<HeuristicParameters>& h_param) {
+  _solving_cancelled->store(false);
+  _pause_gate->paused.store(false, std::memory_order_relaxed);
+
+  const utils::metrics::SolveScope metrics_scope;
+
+  // Derive an absolute deadline from the wall-clock budget, matrix
+  // computations included.
+  Deadline deadline;
+  if (timeout != 0) {
+    deadline =
+      std::chrono::high_resolution_clock::now() + std::chrono::seconds(timeout);
+  }
+
+  if (_geometry and !_all_locations_have_coords) {
+    // Early abort when info is required with missing coordinates.
+    throw Exception(ERROR::INPUT,
+                    "Route geometry request with missing coordinates.");
+  }
+
+  if (_has_jobs and !has_initial_routes()) {
+    // Collapse co-located compatible jobs before any size-dependent
+    // precomputation, see merge_colocated_jobs.
+    merge_colocated_jobs();
+  }
+
+  // Skills compatibility only depends on input data, so it is
+  // computed on a spare thread while matrix responses stream in. The
+  // extra compatibility pass is not moved as TW feasibility checks
+  // need the durations.
+  std::exception_ptr compatibility_ep = nullptr;
+  std::thread skills_compatibility_thread([&]() {
+    try {
+      set_skills_compatibility();
+    } catch (...) {
+      compatibility_ep = std::current_exception();
+    }
+  });
+
+  try {
+    set_matrices(nb_thread);
+  } catch (...) {
+    skills_compatibility_thread.join();
+    throw;
+  }
+  skills_compatibility_thread.join();
+  if (compatibility_ep != nullptr) {
+    std::rethrow_exception(compatibility_ep);
+  }
 
-  // TODO we don't need the whole matrix here.
-  set_matrices(nb_thread);
   set_vehicles_costs();
 
-  // Fill basic skills compatibility matrix.
-  set_skills_compatibility();
+  // The remaining precomputations split into two independent chains
+  // run as overlapping stages. The first one finalizes the cost
+  // wrappers (compact copies wired in) before anything reads
+  // durations through them, then derives vehicle classes and the
+  // compatibility matrices. The second one only reads the raw
+  // matrices, so it streams them while the TW feasibility checks of
+  // the first chain run.
+  std::exception_ptr precompute_ep = nullptr;
+  std::mutex precompute_m;
+  std::vector<std::function<void()>> precompute_tasks;
+  precompute_tasks.push_back([&]() {
+    try {
+      compact_matrices();
+      set_vehicle_classes();
+
+      // Fill remaining vehicle/job compatibility matrices.
+      set_extra_compatibility();
+      set_vehicles_compatibility();
+    } catch (...) {
+      std::lock_guard<std::mutex> lock(precompute_m);
+      precompute_ep = std::current_exception();
+    }
+  });
+  precompute_tasks.push_back([&]() {
+    try {
+      set_cluster_bounds();
+      set_jobs_neighborhood(exploration_level);
+    } catch (...) {
+      std::lock_guard<std::mutex> lock(precompute_m);
+      precompute_ep = std::current_exception();
+    }
+  });
+  utils::ThreadPool::instance().run(std::move(precompute_tasks));
+  if (precompute_ep != nullptr) {
+    std::rethrow_exception(precompute_ep);
+  }
+
+  if (!_checkpoint_file.empty() and !has_initial_routes()) {
+    // Resume an interrupted run from its last checkpoint, when the
+    // file exists and matches current input. Loaded routes seed the
+    // heuristic pool exactly like initial routes provided in input.
+    utils::load_checkpoint(_checkpoint_file, *this);
+  }
+
+  bool decomposed = false;
+  if (h_param.empty() and !has_initial_routes() and
+      _all_locations_have_coords and jobs.size() >= 2000 and
+      vehicles.size() >= 2) {
+    // Very large instance: solve geographical subproblems first and
+    // start the full solving phase from the combined routes. The
+    // regular heuristic and local search then act as a cross-cluster
+    // pass fixing boundary jobs.
+    apply_decomposition(exploration_level, nb_thread, deadline);
+    decomposed = has_initial_routes();
+  }
+
+  if (has_initial_routes()) {
+    // Resolve ids in vehicle steps so solving can start from the
+    // routes provided in input.
+    set_vehicle_steps_ranks();
+  }
+
+  // Load relevant problem.
+  auto instance = get_problem();
+  _end_loading = std::chrono::high_resolution_clock::now();
+  const auto end_loading_alloc = utils::allocation_snapshot();
+
+  auto loading = std::chrono::duration_cast<std::chrono::milliseconds>(
+                   _end_loading - _start_loading)
+                   .count();
+
+  // Solve. After a decomposition phase the initial routes already
+  // provide a good starting point, so a single heuristic run is
+  // enough and all threads go to local search.
+  auto h_param_used = h_param;
+  if (decomposed) {
+    h_param_used = {HeuristicParameters(HEURISTIC::BASIC, INIT::NONE, 0.3)};
+  }
+  auto sol =
+    instance->solve(exploration_level, nb_thread, deadline, h_param_used);
+
+  if (!_merged_jobs.empty()) {
+    expand_merged_jobs(sol);
+  }
+
+  if (has_initial_routes() and !decomposed) {
+    // Flag routes whose job sequence matches the warm-start
+    // assignment provided in input, picked up by the plan-diff
+    // output mode. Skipped after a decomposition phase, whose seed
+    // routes are internal and unknown to the caller.
+    std::unordered_map<Id, std::vector<Id>> input_sequences;
+    for (const auto& vehicle : vehicles) {
+      if (!vehicle.steps.empty()) {
+        auto& sequence = input_sequences[vehicle.id];
+        for (const auto& step : vehicle.steps) {
+          if (step.type == STEP_TYPE::JOB) {
+            sequence.push_back(step.id);
+          }
+        }
+      }
+    }
+
+    std::vector<Id> sequence;
+    for (auto& route : sol.routes) {
+      const auto search = input_sequences.find(route.vehicle);
+      if (search == input_sequences.end()) {
+        continue;
+      }
+      sequence.clear();
+      for (const auto& step : route.steps) {
+        if (step.step_type == STEP_TYPE::JOB) {
+          sequence.push_back(step.id);
+        }
+      }
+      route.unchanged = (sequence == search->second);
+    }
+  }
+
+  // Update timing info.
+  sol.summary.computing_times.loading = loading;
+
+  _end_solving = std::chrono::high_resolution_clock::now();
+  const auto end_solving_alloc = utils::allocation_snapshot();
+  sol.summary.computing_times.solving =
+    std::chrono::duration_cast<std::chrono::milliseconds>(_end_solving -
+                                                          _end_loading)
+      .count();
+
+  if (_geometry) {
+    // Group routes per profile so wrappers can run the underlying
+    // queries concurrently.
+    std::unordered_map<std::string, std::vector<std::reference_wrapper<Route>>>
+      routes_per_profile;
+    for (auto& route : sol.routes) {
+      routes_per_profile[route.profile].push_back(std::ref(route));
+    }
+
+    // Resolve wrappers up front so input errors surface before any
+    // fetching starts, then let profiles fetch their route overlays
+    // concurrently: each wrapper only touches its own routes.
+    std::vector<std::function<void()>> routing_tasks;
+    std::exception_ptr routing_ep = nullptr;
+    std::mutex routing_m;
+    for (auto& profile_routes : routes_per_profile) {
+      const auto& profile = profile_routes.first;
+      auto rw =
+        std::find_if(_routing_wrappers.begin(),
+                     _routing_wrappers.end(),
+                     [&](const auto& wr) { return wr->profile == profile; });
+      if (rw == _routing_wrappers.end()) {
+        throw Exception(ERROR::INPUT,
+                        "Route geometry request with non-routable profile " +
+                          profile + ".");
+      }
+      routing_tasks.push_back([&routing_ep, &routing_m, rw, &profile_routes]() {
+        try {
+          (*rw)->add_route_infos(profile_routes.second);
+        } catch (...) {
+          std::lock_guard<std::mutex> lock(routing_m);
+          routing_ep = std::current_exception();
+        }
+      });
+    }
+    utils::ThreadPool::instance().run(std::move(routing_tasks));
+    if (routing_ep != nullptr) {
+      std::rethrow_exception(routing_ep);
+    }
+
+    for (const auto& route : sol.routes) {
+      sol.summary.distance += route.distance;
+    }
+
+    _end_routing = std::chrono::high_resolution_clock::now();
+    auto routing = std::chrono::duration_cast<std::chrono::milliseconds>(
+                     _end_routing - _end_solving)
+                     .count();
+
+    sol.summary.computing_times.routing = routing;
+  }
+
+  if (_report_memory_stats) {
+    const auto final_alloc = utils::allocation_snapshot();
+    MemoryStats stats;
+    stats.peak_rss_kb = utils::peak_rss_kb();
+    stats.allocated_bytes =
+      final_alloc.allocated_bytes - _start_alloc.allocated_bytes;
+    stats.loading_allocations =
+      end_loading_alloc.nb_allocations - _start_alloc.nb_allocations;
+    stats.solving_allocations =
+      end_solving_alloc.nb_allocations - end_loading_alloc.nb_allocations;
+    stats.routing_allocations =
+      final_alloc.nb_allocations - end_solving_alloc.nb_allocations;
+    sol.summary.memory_stats = stats;
+  }
+
+  utils::metrics::observe_solve(sol.summary.computing_times);
+
+  return sol;
+}
+
+std::future<Solution>
+Input::solve_async(unsigned exploration_level,
+                   unsigned nb_thread,
+                   unsigned timeout,
+                   const std::vector<HeuristicParameters>& h_param) {
+  return std::async(std::launch::async,
+                    [this, exploration_level, nb_thread, timeout, h_param]() {
+                      return this->solve(exploration_level,
+                                         nb_thread,
+                                         timeout,
+                                         h_param);
+                    });
+}
+
+void Input::cancel_solving() {
+  {
+    // Store under the gate lock so it cannot slip between a paused
+    // waiter's predicate check and its sleep, then wake any thread
+    // blocked on a pause so it can wrap up.
+    std::lock_guard<std::mutex> guard(_pause_gate->mutex);
+    _solving_cancelled->store(true);
+  }
+  _pause_gate->cv.notify_all();
+}
+
+void Input::pause_solving() {
+  _pause_gate->paused.store(true, std::memory_order_relaxed);
+}
+
+void Input::resume_solving() {
+  {
+    std::lock_guard<std::mutex> guard(_pause_gate->mutex);
+    _pause_gate->paused.store(false, std::memory_order_relaxed);
+  }
+  _pause_gate->cv.notify_all();
+}
+
+void Input::wait_while_paused() const {
+  std::unique_lock<std::mutex> lock(_pause_gate->mutex);
+  _pause_gate->cv.wait(lock, [this]() {
+    return !_pause_gate->paused.load(std::memory_order_relaxed) or
+           _solving_cancelled->load(std::memory_order_relaxed);
+  });
+}
+
+Solution Input::check(unsigned nb_thread, unsigned timeout) {
+#if USE_LIBGLPK
+  // Derive an absolute deadline from the wall-clock budget, as in
+  // solve.
+  Deadline deadline;
+  if (timeout != 0) {
+    deadline =
+      std::chrono::high_resolution_clock::now() + std::chrono::seconds(timeout);
+  }
+
+  if (_geometry and !_all_locations_have_coords) {
+    // Early abort when info is required with missing coordinates.
+    throw Exception(ERROR::INPUT,
+                    "Route geometry request with missing coordinates.");
+  }
+
+  set_vehicle_steps_ranks();
+
+  // Fill basic skills compatibility matrix while matrix responses
+  // stream in.
+  std::exception_ptr compatibility_ep = nullptr;
+  std::thread skills_compatibility_thread([&]() {
+    try {
+      set_skills_compatibility();
+    } catch (...) {
+      compatibility_ep = std::current_exception();
+    }
+  });
+
+  // TODO we don't need the whole matrix here.
+  try {
+    set_matrices(nb_thread);
+  } catch (...) {
+    skills_compatibility_thread.join();
+    throw;
+  }
+  skills_compatibility_thread.join();
+  if (compatibility_ep != nullptr) {
+    std::rethrow_exception(compatibility_ep);
+  }
+
+  set_vehicles_costs();
 
   _end_loading = std::chrono::high_resolution_clock::now();
 
@@ -806,7 +2909,39 @@ Solution Input::check(unsigned nb_thread) {
                    .count();
 
   // Check.
-  auto sol = validation::check_and_set_ETA(*this, nb_thread);
+  auto sol = validation::check_and_set_ETA(*this, nb_thread, deadline);
+
+  if (has_initial_routes()) {
+    // Flag routes whose job sequence matches the warm-start
+    // assignment provided in input, picked up by the plan-diff
+    // output mode.
+    std::unordered_map<Id, std::vector<Id>> input_sequences;
+    for (const auto& vehicle : vehicles) {
+      if (!vehicle.steps.empty()) {
+        auto& sequence = input_sequences[vehicle.id];
+        for (const auto& step : vehicle.steps) {
+          if (step.type == STEP_TYPE::JOB) {
+            sequence.push_back(step.id);
+          }
+        }
+      }
+    }
+
+    std::vector<Id> sequence;
+    for (auto& route : sol.routes) {
+      const auto search = input_sequences.find(route.vehicle);
+      if (search == input_sequences.end()) {
+        continue;
+      }
+      sequence.clear();
+      for (const auto& step : route.steps) {
+        if (step.step_type == STEP_TYPE::JOB) {
+          sequence.push_back(step.id);
+        }
+      }
+      route.unchanged = (sequence == search->second);
+    }
+  }
 
   // Update timing info.
   sol.summary.computing_times.loading = loading;
@@ -818,8 +2953,15 @@ Solution Input::check(unsigned nb_thread) {
       .count();
 
   if (_geometry) {
+    // Group routes per profile so wrappers can run the underlying
+    // queries concurrently.
+    std::unordered_map<std::string, std::vector<std::reference_wrapper<Route>>>
+      routes_per_profile;
     for (auto& route : sol.routes) {
-      const auto& profile = route.profile;
+      routes_per_profile[route.profile].push_back(std::ref(route));
+    }
+
+    for (auto& [profile, routes] : routes_per_profile) {
       auto rw =
         std::find_if(_routing_wrappers.begin(),
                      _routing_wrappers.end(),
@@ -829,8 +2971,10 @@ Solution Input::check(unsigned nb_thread) {
                         "Route geometry request with non-routable profile " +
                           profile + ".");
       }
-      (*rw)->add_route_info(route);
+      (*rw)->add_route_infos(routes);
+    }
 
+    for (const auto& route : sol.routes) {
       sol.summary.distance += route.distance;
     }
 
@@ -848,6 +2992,7 @@ Solution Input::check(unsigned nb_thread) {
   throw Exception(ERROR::INPUT, "VROOM compiled without libglpk installed.");
   // Silence -Wunused-parameter warning.
   (void)nb_thread;
+  (void)timeout;
 #endif
 }
 
@@ -10,12 +10,21 @@ All rights reserved (see LICENSE).
 
 */
 
+#include <atomic>
 #include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <future>
 #include <memory>
+#include <mutex>
+#include <tuple>
 #include <unordered_map>
 
 #include "routing/wrapper.h"
+#include "structures/generic/flat_map.h"
 #include "structures/generic/matrix.h"
+#include "structures/generic/sparse_matrix.h"
+#include "utils/memory_usage.h"
 #include "structures/typedefs.h"
 #include "structures/vroom/solution/solution.h"
 #include "structures/vroom/vehicle.h"
@@ -27,6 +36,18 @@ namespace io {
 using Servers = std::unordered_map<std::string, Server>;
 } // namespace io
 
+// Changes between two rolling-horizon episodes, applied by
+// Input::clone_with.
+struct InputDelta {
+  std::vector<Job> added_jobs;
+  // Jobs now completed or cancelled. Ids may also name one half of a
+  // shipment, which drops the whole shipment.
+  std::vector<Id> removed_job_ids;
+  // Vehicles replacing the current vehicle with the same id, e.g.
+  // with an updated start position, or appended when the id is new.
+  std::vector<Vehicle> updated_vehicles;
+};
+
 class VRP;
 
 class Input {
@@ -36,7 +57,7 @@ private:
   std::chrono::high_resolution_clock::time_point _end_solving;
   std::chrono::high_resolution_clock::time_point _end_routing;
   std::unordered_set<std::string> _profiles;
-  std::vector<std::unique_ptr<routing::Wrapper>> _routing_wrappers;
+  std::vector<std::shared_ptr<routing::Wrapper>> _routing_wrappers;
   bool _no_addition_yet;
   bool _has_skills;
   bool _has_TW;
@@ -44,14 +65,106 @@ private:
   bool _homogeneous_locations;
   bool _homogeneous_profiles;
   bool _geometry;
+  bool _trusted;
+  bool _deterministic;
+  unsigned _seed;
+  std::string _checkpoint_file;
+  unsigned _checkpoint_interval;
+  unsigned _sweep_rank;
+  unsigned _sweep_count;
+  unsigned _nb_alternatives;
+  // Largest solution cost upper bound over all checked matrices,
+  // kept from the overflow scans in set_matrices. Zero in trusted
+  // mode where the scans are skipped.
+  Cost _matrices_cost_bound;
+  // Whether intermediate gain values provably fit NarrowGain, see
+  // gains_fit_32bit.
+  bool _gains_fit_32bit;
+  std::size_t _memory_budget;
+  bool _report_memory_stats;
+  // Heap counters as they were on input creation, used as the origin
+  // for per-phase allocation stats.
+  const utils::AllocationSnapshot _start_alloc;
+  ProgressCallback _progress_callback;
   bool _has_jobs;
   bool _has_shipments;
   std::unordered_map<std::string, Matrix<Cost>> _matrices;
+  // 16-bit copies of matrices whose values all fit, built on demand,
+  // see compact_matrices.
+  std::unordered_map<std::string, Matrix<CompactCost>> _compact_matrices;
   std::unordered_set<std::string> _custom_matrices;
+  // Sparse custom matrices, stored next to the dense ones and wired
+  // into vehicle cost wrappers the same way. A profile gets either a
+  // dense or a sparse matrix, never both.
+  std::unordered_map<std::string, SparseMatrix<Cost>> _sparse_matrices;
+  // Profiles defined as a transform of another profile's matrix:
+  // scale factor plus sparse cell replacements, evaluated on the fly
+  // in CostWrapper so no full matrix copy is ever stored.
+  struct DerivedProfile {
+    std::string base;
+    double factor;
+    // Sparse (i, j, duration) replacements at base-matrix scale.
+    std::vector<std::tuple<Index, Index, Cost>> overrides;
+    // Same replacements keyed by flat offset in the base matrix,
+    // built in set_vehicles_costs once matrix sizes are known. Only
+    // used on cold paths (get_duration and sub-instance extraction).
+    std::unordered_map<uint64_t, Cost> override_map;
+    // Hot-path view built in set_vehicles_costs: one pointer per
+    // base-matrix row, pointing either straight into the base matrix
+    // or at a row copy with overrides applied once, so CostWrapper
+    // lookups stay a single fused access.
+    std::vector<std::vector<Cost>> patched_rows;
+    std::vector<const Cost*> duration_rows;
+  };
+  std::unordered_map<std::string, DerivedProfile> _derived_profiles;
   std::vector<Location> _locations;
-  std::unordered_map<Location, Index> _locations_to_index;
-  std::vector<std::vector<unsigned char>> _vehicle_to_job_compatibility;
+  FlatMap<Location, Index> _locations_to_index;
+  // Interned skills: each distinct skill value is assigned a bit
+  // rank in order of appearance. A mask holds one bit per interned
+  // skill, with a single word covering the first 64 distinct values
+  // and spillover words for exotic instances using more. Vehicle/job
+  // skill inclusion is then a handful of AND/compare.
+  struct SkillMask {
+    uint64_t fast = 0;
+    std::vector<uint64_t> spill;
+  };
+  FlatMap<Skill, unsigned> _skill_ranks;
+  std::vector<SkillMask> _job_skills_masks;
+  std::vector<SkillMask> _vehicle_skills_masks;
+  // Per-vehicle job compatibility stored as packed 64-bit words so
+  // single bits can be tested in vehicle_ok_with_job and whole rows
+  // combined word-wise in set_vehicles_compatibility.
+  std::vector<std::vector<uint64_t>> _vehicle_to_job_compatibility;
   std::vector<std::vector<bool>> _vehicle_to_vehicle_compatibility;
+  // Whether a vehicle is compatible with every job. True for all
+  // vehicles on uniform fleets, where compatibility-driven scans can
+  // then short-circuit.
+  std::vector<bool> _vehicle_ok_with_all_jobs;
+  // Vehicle equivalence classes for symmetry reduction, see
+  // set_vehicle_classes. _vehicle_class groups fully interchangeable
+  // vehicles while _vehicle_cost_class only groups vehicles sharing
+  // the exact same cost model, which is enough to share per-vehicle
+  // cost planes in SolutionState.
+  std::vector<Index> _vehicle_class;
+  std::vector<Index> _vehicle_cost_class;
+  // Lowest vehicle rank in each cost class, indexed by class.
+  std::vector<Index> _vehicle_cost_class_reps;
+  // Symmetric job neighborhood relation stored as packed 64-bit
+  // words, marking for each job its nearest neighbors duration-wise
+  // in any profile. Used to restrict candidate moves in local search
+  // to geographically sensible pairs.
+  std::vector<std::vector<uint64_t>> _jobs_neighborhood;
+  // Coarse cluster tier over locations: _location_cluster maps a
+  // location index to one of at most 64 clusters and
+  // _cluster_duration_lb[c1][c2] lower-bounds any vehicle's duration
+  // from a location of c1 to a location of c2. The whole bound matrix
+  // fits in L1 even when the full matrices do not, so local search
+  // reads it to discard candidates whose best-case gain cannot beat
+  // the incumbent before touching exact costs.
+  std::vector<Index> _location_cluster;
+  Matrix<Cost> _cluster_duration_lb;
+
+  void set_cluster_bounds();
   std::unordered_set<Index> _matrices_used_index;
   Index _max_matrices_used_index;
   bool _all_locations_have_coords;
@@ -62,28 +175,105 @@ private:
   const io::Servers _servers;
   const ROUTER _router;
 
+  // Held through a shared_ptr so Input remains movable and a handle
+  // obtained before solving stays valid.
+  std::shared_ptr<std::atomic<bool>> _solving_cancelled;
+
+  // Cooperative pause gate shared with solving threads, same
+  // lifetime handling as the cancellation flag above.
+  struct PauseGate {
+    std::atomic<bool> paused{false};
+    std::mutex mutex;
+    std::condition_variable cv;
+  };
+  std::shared_ptr<PauseGate> _pause_gate;
+
+  // Block the calling solving thread until resumed or cancelled.
+  void wait_while_paused() const;
+
   std::unique_ptr<VRP> get_problem() const;
 
   void check_job(Job& job);
 
-  void check_cost_bound(const Matrix<Cost>& matrix) const;
+  // Assign a bit rank to any new skill value and return the matching
+  // mask, see SkillMask.
+  SkillMask intern_skills(const Skills& skills);
+
+  void check_index_range() const;
+
+  Cost check_cost_bound(const Matrix<Cost>& matrix) const;
+
+  Cost check_cost_bound(const SparseMatrix<Cost>& matrix) const;
+
+  // Overflow scan shared by the dense and sparse variants above,
+  // returning the checked solution cost upper bound.
+  Cost check_cost_bound_with(const std::vector<Cost>& max_cost_per_line,
+                             const std::vector<Cost>& max_cost_per_column)
+    const;
+
+  // Apply per-vehicle setup for all vehicles, split across pool
+  // threads. Tasks must only write state owned by their vehicle rank
+  // and any exception is rethrown once all tasks completed.
+  void run_on_vehicles(const std::function<void(Index)>& vehicle_setup);
 
   void set_skills_compatibility();
   void set_extra_compatibility();
   void set_vehicles_compatibility();
   void set_vehicles_costs();
+  void set_vehicle_classes();
+  void set_jobs_neighborhood(unsigned exploration_level);
+  void set_vehicle_steps_ranks();
   void set_matrices(unsigned nb_thread);
 
+  // Spread pages of the now read-only matrices across NUMA nodes by
+  // re-faulting them from worker threads pinned on all nodes, so
+  // solving threads do not all read cross-socket.
+  void interleave_matrices();
+
+  // When compact durations are enabled, build 16-bit copies of the
+  // matrices whose values all fit and point vehicle cost wrappers at
+  // them, halving the cache footprint of solving-phase lookups.
+  void compact_matrices();
+
+  // Sweep jobs into nb_clusters angular sectors around their
+  // centroid. A delivery always ends up in the same cluster as its
+  // matching pickup.
+  std::vector<std::vector<Index>>
+  sweep_job_clusters(std::size_t nb_clusters) const;
+
+  // Split current instance into geographical subproblems sharing the
+  // already computed matrices, solve them in parallel and store the
+  // resulting routes as vehicle steps so the subsequent full solving
+  // phase starts from them.
+  void apply_decomposition(unsigned exploration_level,
+                           unsigned nb_thread,
+                           const Deadline& deadline);
+
   void add_routing_wrapper(const std::string& profile);
 
+  // Original jobs hidden behind each co-located super-job, keyed by
+  // super-job id, see merge_colocated_jobs.
+  std::unordered_map<Id, std::vector<Job>> _merged_jobs;
+
+  // Merge single jobs sharing a location, time windows and skills
+  // into super-jobs with summed amounts, service and priority, so
+  // the solver sees one node per address. Quadratic local search
+  // cost makes this a large win on instances with many co-located
+  // jobs. Solutions are expanded back in expand_merged_jobs.
+  void merge_colocated_jobs();
+
+  // Substitute each super-job step and unassigned entry in sol with
+  // its original jobs.
+  void expand_merged_jobs(Solution& sol) const;
+
 public:
   std::vector<Job> jobs;
   std::vector<Vehicle> vehicles;
 
   // Store rank in jobs accessible from job/pickup/delivery id.
-  std::unordered_map<Id, Index> job_id_to_rank;
-  std::unordered_map<Id, Index> pickup_id_to_rank;
-  std::unordered_map<Id, Index> delivery_id_to_rank;
+  FlatMap<Id, Index> job_id_to_rank;
+  FlatMap<Id, Index> pickup_id_to_rank;
+  FlatMap<Id, Index> delivery_id_to_rank;
 
   Input(unsigned amount_size,
         const io::Servers& servers = {},
@@ -91,18 +281,161 @@ public:
 
   void set_geometry(bool geometry);
 
+  bool geometry() const {
+    return _geometry;
+  }
+
+  // Speculatively fetch route geometry for routes while solving
+  // still runs, warming the per-wrapper response cache consulted
+  // when the final solution gets its geometry. Best effort: failures
+  // are dropped, since the final routing phase surfaces them if they
+  // persist. No-op unless geometry output was requested.
+  void prefetch_geometry(std::vector<Route>& routes) const;
+
+  // Skip input validation on additions (duplicate ids, amount length
+  // and shipment consistency checks) and the cost bound scan on
+  // provided matrices, for callers that already validated their model
+  // upstream. Must be set before the first addition.
+  void set_trusted(bool trusted);
+
+  // Pre-allocate internal containers for a model of known size.
+  void reserve(std::size_t nb_jobs, std::size_t nb_vehicles);
+
+  // Make solving reproducible across runs with identical input:
+  // cross-thread sharing of intermediate solutions, which depends on
+  // thread completion order, is disabled. Solutions may be slightly
+  // worse on average.
+  void set_deterministic(bool deterministic);
+
+  bool deterministic() const {
+    return _deterministic;
+  }
+
+  // Seed for randomized solving components (currently the
+  // ruin-and-recreate phase). Defaults to zero, so identical inputs
+  // give identical random sequences unless explicitly varied.
+  void set_seed(unsigned seed);
+
+  unsigned seed() const {
+    return _seed;
+  }
+
+  // Periodically write the best known solution to file while solving
+  // (every interval seconds), and resume from that file when it
+  // exists and matches current input. Makes long solves restartable
+  // after a crash or deploy, see utils/checkpoint.h.
+  void set_checkpoint(const std::string& file, unsigned interval = 60);
+
+  const std::string& checkpoint_file() const {
+    return _checkpoint_file;
+  }
+
+  unsigned checkpoint_interval() const {
+    return _checkpoint_interval;
+  }
+
+  // Distributed parameter sweep: this process is worker rank among
+  // count identical processes fed the same input, and only runs its
+  // interleaved share of the heuristic parameter set. Final
+  // selection across the reported solutions happens on the
+  // coordinator side, see scripts/sweep_solve.py.
+  void set_sweep_slice(unsigned rank, unsigned count);
+
+  unsigned sweep_rank() const {
+    return _sweep_rank;
+  }
+
+  unsigned sweep_count() const {
+    return _sweep_count;
+  }
+
+  // Also retain up to nb_alternatives distinct runner-up assignments
+  // from the solving parameter sweep, reported best first in the
+  // alternatives field of the returned solution. Dispatchers get
+  // fallback plans out of a single solve instead of perturbed
+  // re-solves, at formatting cost only. Alternatives skip the
+  // routing phase, so they carry no geometry detail.
+  void set_nb_alternatives(unsigned nb_alternatives);
+
+  unsigned nb_alternatives() const {
+    return _nb_alternatives;
+  }
+
+  // Soft limit in megabytes on solving state caches. When the
+  // estimated footprint of the per-class prefix cost planes in
+  // SolutionState exceeds the budget, only the own-class view is
+  // materialized per route and foreign-class views are recomputed on
+  // demand, trading bounded CPU for bounded memory on big
+  // heterogeneous fleets. Zero means no limit.
+  void set_memory_budget(unsigned megabytes);
+
+  std::size_t memory_budget() const {
+    return _memory_budget;
+  }
+
+  // Whether the checked matrix bounds guarantee that intermediate
+  // gain values fit NarrowGain for this instance, vehicle speed
+  // factors included. Lets gain scan kernels run on narrow lanes
+  // with fallback to the wide Gain pipeline, see
+  // utils::addition_costs. Always false in trusted mode since the
+  // bounds are not established there.
+  bool gains_fit_32bit() const {
+    return _gains_fit_32bit;
+  }
+
+  // Report peak RSS and per-phase heap allocation stats in the
+  // solution summary, next to computing times.
+  void set_memory_stats(bool report_memory_stats);
+
+  // Register a callback receiving live search progress events:
+  // best-solution improvements, completed local-search steps and job
+  // removal phases. The callback is invoked concurrently from
+  // solving threads so it must be thread-safe, and it should return
+  // quickly not to stall the search.
+  void set_progress_callback(ProgressCallback progress_callback);
+
+  // Report a search event to the registered callback, if any.
+  void
+  report_progress(SEARCH_EVENT event, Cost cost, unsigned unassigned) const;
+
   void add_job(const Job& job);
+  void add_job(Job&& job);
 
   void add_shipment(const Job& pickup, const Job& delivery);
+  void add_shipment(Job&& pickup, Job&& delivery);
 
   void add_vehicle(const Vehicle& vehicle);
+  void add_vehicle(Vehicle&& vehicle);
 
   void set_matrix(const std::string& profile, Matrix<Cost>&& m);
 
+  // Sparse alternative to set_matrix for depot-centric instances
+  // where a dense n^2 table would not fit in memory: only provided
+  // pairs are stored and any other lookup answers m's fallback
+  // bound. Not usable as the base of a derived profile, and exempt
+  // from 16-bit compaction (-z).
+  void set_sparse_matrix(const std::string& profile, SparseMatrix<Cost>&& m);
+
+  // Define profile as base profile durations scaled by factor, with
+  // optional sparse (i, j, duration) cell replacements applied before
+  // scaling. No matrix is stored for such a profile.
+  void add_derived_profile(const std::string& profile,
+                           const std::string& base,
+                           double factor,
+                           std::vector<std::tuple<Index, Index, Cost>>
+                             overrides = {});
+
   const Amount& zero_amount() const {
     return _zero;
   }
 
+  // Order-normalized hash over the problem definition (jobs,
+  // vehicles, matrices and derived profiles), identical for
+  // resubmissions listing the same entities in a different order.
+  // Used as a memoization key for solutions, see the -k command-line
+  // flag.
+  uint64_t canonical_hash() const;
+
   bool has_skills() const;
 
   bool has_jobs() const;
@@ -113,24 +446,135 @@ public:
 
   bool has_homogeneous_profiles() const;
 
+  // Whether any vehicle has predefined steps in input.
+  bool has_initial_routes() const;
+
   bool vehicle_ok_with_job(size_t v_index, size_t j_index) const {
-    return (bool)_vehicle_to_job_compatibility[v_index][j_index];
+    return (_vehicle_to_job_compatibility[v_index][j_index >> 6] >>
+            (j_index & 63)) &
+           1;
+  }
+
+  bool vehicle_ok_with_all_jobs(Index v_index) const {
+    return _vehicle_ok_with_all_jobs[v_index];
   }
 
   // Returns true iff both vehicles have common job candidates.
   bool vehicle_ok_with_vehicle(Index v1_index, Index v2_index) const;
 
+  // Whether swapping both vehicles can never change a solution cost
+  // or feasibility, see Vehicle::is_interchangeable_with.
+  bool vehicles_interchangeable(Index v1_index, Index v2_index) const {
+    return _vehicle_class[v1_index] == _vehicle_class[v2_index];
+  }
+
+  // Equivalence class for symmetry reduction, identical for fully
+  // interchangeable vehicles and keyed by the lowest rank in class.
+  Index vehicle_class(Index v_index) const { return _vehicle_class[v_index]; }
+
+  // Cost-model equivalence classes, used to share cost planes across
+  // vehicles with identical durations in SolutionState.
+  std::size_t nb_vehicle_cost_classes() const {
+    return _vehicle_cost_class_reps.size();
+  }
+
+  Index vehicle_cost_class(Index v_index) const {
+    return _vehicle_cost_class[v_index];
+  }
+
+  Index vehicle_cost_class_rep(Index c) const {
+    return _vehicle_cost_class_reps[c];
+  }
+
+  bool jobs_are_neighbors(Index j1_rank, Index j2_rank) const {
+    return (_jobs_neighborhood[j1_rank][j2_rank >> 6] >> (j2_rank & 63)) & 1;
+  }
+
+  bool has_cluster_bounds() const {
+    return !_location_cluster.empty();
+  }
+
+  Index location_cluster(Index i) const {
+    return _location_cluster[i];
+  }
+
+  // Lower bound on any vehicle's duration from a location of cluster
+  // c1 to a location of cluster c2.
+  Cost cluster_duration_lb(Index c1, Index c2) const {
+    return _cluster_duration_lb[c1][c2];
+  }
+
   Cost get_duration(const std::string& profile, Index i, Index j) const {
+    const auto derived = _derived_profiles.find(profile);
+    if (derived != _derived_profiles.end()) {
+      const auto& matrix = _matrices.at(derived->second.base);
+      const auto search =
+        derived->second.override_map.find(static_cast<uint64_t>(i) *
+                                            matrix.size() +
+                                          j);
+      const Cost base_duration = (search != derived->second.override_map.end())
+                                   ? search->second
+                                   : matrix[i][j];
+      return static_cast<Cost>(derived->second.factor *
+                               static_cast<double>(base_duration));
+    }
     assert(_matrices.find(profile) != _matrices.end());
     return _matrices.at(profile)[i][j];
   }
 
+  // Build a new solvable instance applying delta to the current
+  // problem. Fetched matrices are shared with this instance instead
+  // of being refetched or copied: the clone reads the same buffers
+  // and only pays for new rows and columns if added jobs bring new
+  // locations. Updated vehicles keep whatever steps they carry, so
+  // routes from the previous episode can be passed back as initial
+  // routes for warm-started solving.
+  Input clone_with(const InputDelta& delta);
+
   Solution solve(unsigned exploration_level,
                  unsigned nb_thread,
+                 unsigned timeout = 0,
                  const std::vector<HeuristicParameters>& h_param =
                    std::vector<HeuristicParameters>());
 
-  Solution check(unsigned nb_thread);
+  // Checking shares the solving timeout: past the deadline,
+  // remaining route ETAs are approximated instead of optimized so
+  // overall latency stays bounded.
+  Solution check(unsigned nb_thread, unsigned timeout = 0);
+
+  // Same as solve, except solving happens on a separate thread and
+  // the call returns immediately. Combined with cancel_solving this
+  // allows aborting a search in flight while still harvesting its
+  // best solution so far from the returned future.
+  std::future<Solution> solve_async(unsigned exploration_level,
+                                    unsigned nb_thread,
+                                    unsigned timeout = 0,
+                                    const std::vector<HeuristicParameters>&
+                                      h_param =
+                                        std::vector<HeuristicParameters>());
+
+  // Ask a running solve to wrap up at the next iteration boundary. It
+  // then returns the best solution found so far, exactly as if the
+  // timeout had been reached.
+  void cancel_solving();
+
+  // Suspend a running solve: solving threads block at their next
+  // iteration boundary -- the same poll points cancellation uses --
+  // until resume_solving, so an embedding service can reclaim the
+  // cores between slices without OS-level priority tricks. Bounded
+  // stepping composes from these over solve_async: resume, wait for
+  // the slice budget, pause. The solving timeout keeps ticking while
+  // paused and cancel_solving also lifts the gate.
+  void pause_solving();
+
+  void resume_solving();
+
+  bool solving_cancelled() const {
+    if (_pause_gate->paused.load(std::memory_order_relaxed)) {
+      wait_while_paused();
+    }
+    return _solving_cancelled->load(std::memory_order_relaxed);
+  }
 };
 
 } // namespace vroom
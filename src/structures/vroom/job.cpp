@@ -29,7 +29,7 @@ Job::Job(Id id,
          const Skills& skills,
          Priority priority,
          const std::vector<TimeWindow>& tws,
-         const std::string& description)
+         std::string_view description)
   : location(location),
     id(id),
     type(JOB_TYPE::SINGLE),
@@ -52,7 +52,7 @@ Job::Job(Id id,
          const Skills& skills,
          Priority priority,
          const std::vector<TimeWindow>& tws,
-         const std::string& description)
+         std::string_view description)
   : location(location),
     id(id),
     type(type),
@@ -10,7 +10,7 @@ All rights reserved (see LICENSE).
 
 */
 
-#include <string>
+#include <string_view>
 
 #include "structures/typedefs.h"
 #include "structures/vroom/amount.h"
@@ -29,7 +29,9 @@ struct Job {
   const Skills skills;
   const Priority priority;
   const std::vector<TimeWindow> tws;
-  const std::string description;
+  // Non-owning view into the input buffer, which outlives the
+  // problem instance, see io::parse.
+  const std::string_view description;
   const Duration tw_length;
 
   // Constructor for regular one-stop job (JOB_TYPE::SINGLE).
@@ -42,7 +44,7 @@ struct Job {
       Priority priority = 0,
       const std::vector<TimeWindow>& tws =
         std::vector<TimeWindow>(1, TimeWindow()),
-      const std::string& description = "");
+      std::string_view description = "");
 
   // Constructor for pickup and delivery jobs (JOB_TYPE::PICKUP or
   // JOB_TYPE::DELIVERY).
@@ -55,7 +57,7 @@ struct Job {
       Priority priority = 0,
       const std::vector<TimeWindow>& tws =
         std::vector<TimeWindow>(1, TimeWindow()),
-      const std::string& description = "");
+      std::string_view description = "");
 
   Index index() const {
     return location.index();
@@ -7,6 +7,8 @@ All rights reserved (see LICENSE).
 
 */
 
+#include <algorithm>
+
 #include "structures/vroom/raw_route.h"
 
 namespace vroom {
@@ -14,10 +16,15 @@ namespace vroom {
 RawRoute::RawRoute(const Input& input, Index i)
   : _fwd_peaks(2, input.zero_amount()),
     _bwd_peaks(2, input.zero_amount()),
+    _fwd_lows(2, input.zero_amount()),
+    _bwd_lows(2, input.zero_amount()),
     vehicle_rank(i),
     has_start(input.vehicles[i].has_start()),
     has_end(input.vehicles[i].has_end()),
     capacity(input.vehicles[i].capacity) {
+  // Reserve up front so route splices during local search don't
+  // reallocate.
+  route.reserve(input.jobs.size());
 }
 
 void RawRoute::set_route(const Input& input, const std::vector<Index>& r) {
@@ -44,12 +51,16 @@ void RawRoute::update_amounts(const Input& input) {
   _current_loads.resize(step_size);
   _fwd_peaks.resize(step_size);
   _bwd_peaks.resize(step_size);
+  _fwd_lows.resize(step_size);
+  _bwd_lows.resize(step_size);
 
   if (route.empty()) {
     // So that check in is_valid_addition_for_capacity is consistent
     // with empty routes.
     std::fill(_fwd_peaks.begin(), _fwd_peaks.end(), input.zero_amount());
     std::fill(_bwd_peaks.begin(), _bwd_peaks.end(), input.zero_amount());
+    std::fill(_fwd_lows.begin(), _fwd_lows.end(), input.zero_amount());
+    std::fill(_bwd_lows.begin(), _bwd_lows.end(), input.zero_amount());
     return;
   }
 
@@ -100,24 +111,32 @@ void RawRoute::update_amounts(const Input& input) {
   _current_loads[0] = current_deliveries;
 
   auto peak = _current_loads[0];
+  auto low = _current_loads[0];
   _fwd_peaks[0] = peak;
+  _fwd_lows[0] = low;
   for (std::size_t s = 1; s < _fwd_peaks.size(); ++s) {
-    // Handle max component-wise.
+    // Handle max and min component-wise.
     for (std::size_t r = 0; r < input.zero_amount().size(); ++r) {
       peak[r] = std::max(peak[r], _current_loads[s][r]);
+      low[r] = std::min(low[r], _current_loads[s][r]);
     }
     _fwd_peaks[s] = peak;
+    _fwd_lows[s] = low;
   }
 
   peak = _current_loads.back();
+  low = _current_loads.back();
   _bwd_peaks.back() = peak;
+  _bwd_lows.back() = low;
   for (std::size_t s = 1; s < _bwd_peaks.size(); ++s) {
     auto bwd_s = _bwd_peaks.size() - s - 1;
-    // Handle max component-wise.
+    // Handle max and min component-wise.
     for (std::size_t r = 0; r < input.zero_amount().size(); ++r) {
       peak[r] = std::max(peak[r], _current_loads[bwd_s][r]);
+      low[r] = std::min(low[r], _current_loads[bwd_s][r]);
     }
     _bwd_peaks[bwd_s] = peak;
+    _bwd_lows[bwd_s] = low;
   }
 }
 
@@ -145,8 +164,8 @@ bool RawRoute::is_valid_addition_for_capacity(const Input&,
                                               const Index rank) const {
   assert(rank <= route.size());
 
-  return (_fwd_peaks[rank] + delivery <= capacity) and
-         (_bwd_peaks[rank] + pickup <= capacity);
+  return add_le(_fwd_peaks[rank], delivery, capacity) and
+         add_le(_bwd_peaks[rank], pickup, capacity);
 }
 
 bool RawRoute::is_valid_addition_for_load(const Input& input,
@@ -155,7 +174,7 @@ bool RawRoute::is_valid_addition_for_load(const Input& input,
   assert(rank <= route.size());
 
   auto& load = route.empty() ? input.zero_amount() : _current_loads[rank];
-  return load + pickup <= capacity;
+  return add_le(load, pickup, capacity);
 }
 
 bool RawRoute::is_valid_addition_for_capacity_margins(
@@ -219,6 +238,65 @@ bool RawRoute::is_valid_addition_for_capacity_inclusion(
   return valid;
 }
 
+bool RawRoute::is_valid_addition_for_capacity_inclusion(
+  const Input& input,
+  const Amount& delivery,
+  const RawRoute& other,
+  const Index other_first_rank,
+  const Index other_last_rank,
+  const bool reversed,
+  const Index first_rank,
+  const Index last_rank) const {
+  assert(first_rank <= last_rank);
+  assert(last_rank <= route.size() + 1);
+  assert(other_first_rank <= other_last_rank);
+  assert(other_last_rank <= other.route.size());
+  // Restricting to heads and tails of other is what makes the cached
+  // peaks and lows match the requested range.
+  assert(other_first_rank == 0 or other_last_rank == other.route.size());
+
+  auto& init_load = (route.empty()) ? input.zero_amount() : _current_loads[0];
+
+  auto& first_deliveries =
+    (first_rank == 0) ? init_load : _bwd_deliveries[first_rank - 1];
+
+  auto& last_deliveries =
+    (last_rank == 0) ? init_load : _bwd_deliveries[last_rank - 1];
+
+  auto replaced_deliveries = first_deliveries - last_deliveries;
+
+  Amount current_load =
+    ((route.empty()) ? input.zero_amount() : _current_loads[first_rank]) -
+    replaced_deliveries + delivery;
+
+  if (!(current_load <= capacity)) {
+    return false;
+  }
+  if (other_first_rank == other_last_rank) {
+    return true;
+  }
+
+  // Biggest load change (component-wise) while traversing the
+  // included range, relative to the load right before it. The peaks
+  // and lows spuriously covering the steps around the range only ever
+  // add a zero component, which the check on current_load above
+  // already accounts for.
+  Amount max_net_load(input.zero_amount().size());
+  if (reversed) {
+    const auto& lows = (other_first_rank == 0)
+                         ? other._fwd_lows[other_last_rank - 1]
+                         : other._bwd_lows[other_first_rank];
+    max_net_load = other._current_loads[other_last_rank] - lows;
+  } else {
+    const auto& peaks = (other_last_rank == other.route.size())
+                          ? other._bwd_peaks[other_first_rank + 1]
+                          : other._fwd_peaks[other_last_rank];
+    max_net_load = peaks - other._current_loads[other_first_rank];
+  }
+
+  return add_le(current_load, max_net_load, capacity);
+}
+
 Amount RawRoute::get_startup_load() const {
   return _current_loads[0];
 }
@@ -255,6 +333,90 @@ void RawRoute::remove(const Input& input,
   update_amounts(input);
 }
 
+void RawRoute::move_segment(const Input& input,
+                            RawRoute& target_route,
+                            const Index s_rank,
+                            const unsigned count,
+                            const Index t_rank,
+                            const bool reverse) {
+  assert(s_rank + count <= route.size());
+  assert(t_rank <= target_route.route.size());
+
+  auto& t_r = target_route.route;
+  const auto old_t_size = t_r.size();
+
+  // Single backward shift opening count slots at t_rank.
+  t_r.resize(old_t_size + count);
+  std::move_backward(t_r.begin() + t_rank, t_r.begin() + old_t_size, t_r.end());
+
+  if (reverse) {
+    std::reverse_copy(route.begin() + s_rank,
+                      route.begin() + s_rank + count,
+                      t_r.begin() + t_rank);
+  } else {
+    std::copy(route.begin() + s_rank,
+              route.begin() + s_rank + count,
+              t_r.begin() + t_rank);
+  }
+
+  route.erase(route.begin() + s_rank, route.begin() + s_rank + count);
+
+  update_amounts(input);
+  target_route.update_amounts(input);
+}
+
+void RawRoute::move_segment(const Input& input,
+                            const Index s_rank,
+                            const unsigned count,
+                            const Index t_rank,
+                            const bool reverse) {
+  assert(s_rank + count <= route.size());
+  assert(t_rank + count <= route.size());
+
+  if (t_rank < s_rank) {
+    std::rotate(route.begin() + t_rank,
+                route.begin() + s_rank,
+                route.begin() + s_rank + count);
+  } else {
+    std::rotate(route.begin() + s_rank,
+                route.begin() + s_rank + count,
+                route.begin() + t_rank + count);
+  }
+
+  if (reverse) {
+    std::reverse(route.begin() + t_rank, route.begin() + t_rank + count);
+  }
+
+  update_amounts(input);
+}
+
+void RawRoute::swap_tails(const Input& input,
+                          RawRoute& target_route,
+                          const Index s_rank,
+                          const Index t_rank) {
+  auto& t_r = target_route.route;
+  const auto nb_s = route.size() - s_rank;
+  const auto nb_t = t_r.size() - t_rank;
+  const auto common = std::min(nb_s, nb_t);
+
+  std::swap_ranges(route.begin() + s_rank,
+                   route.begin() + s_rank + common,
+                   t_r.begin() + t_rank);
+
+  // Whatever tail part is left over only has to be appended to the
+  // shorter route, no shifting involved.
+  if (nb_t < nb_s) {
+    t_r.insert(t_r.end(), route.begin() + s_rank + common, route.end());
+    route.erase(route.begin() + s_rank + common, route.end());
+  } else if (nb_s < nb_t) {
+    route.insert(route.end(), t_r.begin() + t_rank + common, t_r.end());
+    t_r.erase(t_r.begin() + t_rank + common, t_r.end());
+  }
+
+  update_amounts(input);
+  target_route.update_amounts(input);
+}
+
 template <class InputIterator>
 void RawRoute::replace(const Input& input,
                        const InputIterator first_job,
@@ -44,6 +44,13 @@ private:
   std::vector<Amount> _fwd_peaks;
   std::vector<Amount> _bwd_peaks;
 
+  // Component-wise counterparts of the peaks above holding the lowest
+  // load up to (resp. after) each step. They allow expressing the
+  // peak load of a route segment traversed in reverse as a couple of
+  // lookups.
+  std::vector<Amount> _fwd_lows;
+  std::vector<Amount> _bwd_lows;
+
 public:
   Index vehicle_rank;
   bool has_start;
@@ -105,6 +112,20 @@ public:
                                                 const Index first_rank,
                                                 const Index last_rank) const;
 
+  // Same check for the case where the included jobs are the range
+  // [other_first_rank; other_last_rank) of another route, possibly
+  // reversed. The range has to be a head or a tail of other, so that
+  // its load profile boils down to lookups in the cached peaks and
+  // lows instead of a rank-by-rank scan.
+  bool is_valid_addition_for_capacity_inclusion(const Input& input,
+                                                const Amount& delivery,
+                                                const RawRoute& other,
+                                                const Index other_first_rank,
+                                                const Index other_last_rank,
+                                                const bool reversed,
+                                                const Index first_rank,
+                                                const Index last_rank) const;
+
   Amount get_startup_load() const;
 
   // Get sum of pickups (resp. deliveries) for all jobs in the range
@@ -133,6 +154,36 @@ public:
 
   void remove(const Input& input, const Index rank, const unsigned count);
 
+  // Splice primitives below shift route contents in a single pass
+  // and update amounts for all touched routes exactly once. They
+  // only maintain raw amount data, so time-window routes are
+  // expected to go through the TWRoute members instead.
+
+  // Move the count jobs starting at s_rank into target_route at
+  // t_rank, optionally reversing the segment on the way.
+  void move_segment(const Input& input,
+                    RawRoute& target_route,
+                    const Index s_rank,
+                    const unsigned count,
+                    const Index t_rank,
+                    const bool reverse);
+
+  // Move the count jobs starting at s_rank to rank t_rank in this
+  // route, t_rank being expressed with the segment taken out, as
+  // with an erase/insert sequence.
+  void move_segment(const Input& input,
+                    const Index s_rank,
+                    const unsigned count,
+                    const Index t_rank,
+                    const bool reverse);
+
+  // Exchange the tail starting at s_rank in this route with the tail
+  // starting at t_rank in target_route.
+  void swap_tails(const Input& input,
+                  RawRoute& target_route,
+                  const Index s_rank,
+                  const Index t_rank);
+
   // Add the range [first_job; last_job) in the existing route at rank
   // first_rank and before last_rank *in place of* the current jobs
   // that may be there.
@@ -0,0 +1,33 @@
+#ifndef MEMORY_STATS_H
+#define MEMORY_STATS_H
+
+/*
+
+This file is part of VROOM.
+
+Copyright (c) 2015-2021, Julien Coupey.
+All rights reserved (see LICENSE).
+
+*/
+
+#include <cstddef>
+#include <cstdint>
+
+namespace vroom {
+
+// Opt-in memory instrumentation reported next to computing times in
+// the summary.
+struct MemoryStats {
+  // Peak resident set size in kilobytes, zero when unsupported.
+  std::size_t peak_rss_kb;
+  // Heap volume allocated over the whole run.
+  std::uint64_t allocated_bytes;
+  // Allocation counts per phase.
+  std::uint64_t loading_allocations;
+  std::uint64_t solving_allocations;
+  std::uint64_t routing_allocations;
+};
+
+} // namespace vroom
+
+#endif
@@ -21,11 +21,11 @@ Route::Route(Id vehicle,
              Duration duration,
              Duration waiting_time,
              Priority priority,
-             const Amount& delivery,
-             const Amount& pickup,
+             Amount delivery,
+             Amount pickup,
              const std::string& profile,
-             const std::string& description,
-             const Violations&& violations)
+             std::string_view description,
+             Violations&& violations)
   : vehicle(vehicle),
     steps(std::move(steps)),
     cost(cost),
@@ -33,8 +33,8 @@ Route::Route(Id vehicle,
     duration(duration),
     waiting_time(waiting_time),
     priority(priority),
-    delivery(delivery),
-    pickup(pickup),
+    delivery(std::move(delivery)),
+    pickup(std::move(pickup)),
     profile(profile),
     description(description),
     violations(std::move(violations)),
@@ -11,6 +11,7 @@ All rights reserved (see LICENSE).
 */
 
 #include <string>
+#include <string_view>
 
 #include "structures/vroom/solution/step.h"
 #include "structures/vroom/solution/violations.h"
@@ -28,12 +29,18 @@ struct Route {
   Amount delivery;
   Amount pickup;
   std::string profile;
-  std::string description;
+  // Non-owning view into the input buffer, which outlives the
+  // problem instance, see io::parse.
+  std::string_view description;
   Violations violations;
 
   std::string geometry;
   Distance distance;
 
+  // Whether the job sequence matches the warm-start assignment
+  // provided in input, see the plan-diff output mode.
+  bool unchanged = false;
+
   Route();
 
   Route(Id vehicle,
@@ -43,11 +50,11 @@ struct Route {
         Duration duration,
         Duration waiting_time,
         Priority priority,
-        const Amount& delivery,
-        const Amount& pickup,
+        Amount delivery,
+        Amount pickup,
         const std::string& profile,
-        const std::string& description,
-        const Violations&& violations = Violations(0, 0));
+        std::string_view description,
+        Violations&& violations = Violations(0, 0));
 };
 
 } // namespace vroom
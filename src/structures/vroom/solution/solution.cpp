@@ -12,7 +12,11 @@ All rights reserved (see LICENSE).
 namespace vroom {
 
 Solution::Solution(unsigned code, std::string error)
-  : code(code), error(error) {
+  : code(code), error(std::move(error)) {
+}
+
+Solution::Solution(unsigned code, unsigned amount_size)
+  : code(code), summary(0, amount_size) {
 }
 
 Solution::Solution(unsigned code,
@@ -36,4 +40,22 @@ Solution::Solution(unsigned code,
   }
 }
 
+void Solution::add_route(Route&& route) {
+  summary.cost += route.cost;
+  summary.delivery += route.delivery;
+  summary.pickup += route.pickup;
+  summary.service += route.service;
+  summary.priority += route.priority;
+  summary.duration += route.duration;
+  summary.waiting_time += route.waiting_time;
+  summary.violations += route.violations;
+
+  routes.push_back(std::move(route));
+}
+
+void Solution::add_unassigned(const Job& job) {
+  unassigned.push_back(job);
+  ++summary.unassigned;
+}
+
 } // namespace vroom
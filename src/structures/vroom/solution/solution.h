@@ -24,13 +24,27 @@ struct Solution {
   Summary summary;
   std::vector<Route> routes;
   std::vector<Job> unassigned;
+  // Distinct runner-up assignments retained from the solving
+  // parameter sweep as fallback plans, best first. Only filled when
+  // requested with Input::set_nb_alternatives.
+  std::vector<Solution> alternatives;
 
   Solution(unsigned code, std::string error);
 
+  // Empty solution meant to be filled incrementally with add_route
+  // and add_unassigned, which keep the summary in sync as content is
+  // appended.
+  Solution(unsigned code, unsigned amount_size);
+
   Solution(unsigned code,
            unsigned amount_size,
            std::vector<Route>&& routes,
            std::vector<Job>&& unassigned);
+
+  // Append route, folding its indicators into the summary.
+  void add_route(Route&& route);
+
+  void add_unassigned(const Job& job);
 };
 
 } // namespace vroom
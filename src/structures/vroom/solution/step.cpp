@@ -12,37 +12,37 @@ All rights reserved (see LICENSE).
 namespace vroom {
 
 // Used for start and end steps.
-Step::Step(STEP_TYPE type, Location location, const Amount& load)
+Step::Step(STEP_TYPE type, Location location, Amount load)
   : step_type(type),
     job_type(JOB_TYPE::SINGLE), // Dummy init.
     location(location),
     id(0),
     service(0),
-    load(load),
+    load(std::move(load)),
     arrival(0),
     duration(0),
     waiting_time(0) {
   assert(step_type == STEP_TYPE::START or step_type == STEP_TYPE::END);
 }
 
-Step::Step(const Job& job, const Amount& load)
+Step::Step(const Job& job, Amount load)
   : step_type(STEP_TYPE::JOB),
     job_type(job.type),
     location(job.location),
     id(job.id),
     service(job.service),
-    load(load),
+    load(std::move(load)),
     description(job.description),
     waiting_time(0) {
 }
 
-Step::Step(const Break& b, const Amount& load)
+Step::Step(const Break& b, Amount load)
   : step_type(STEP_TYPE::BREAK),
     job_type(JOB_TYPE::SINGLE), // Dummy value.
     location(0),                // Dummy value.
     id(b.id),
     service(b.service),
-    load(load),
+    load(std::move(load)),
     description(b.description),
     waiting_time(0) {
 }
@@ -10,7 +10,7 @@ All rights reserved (see LICENSE).
 
 */
 
-#include <string>
+#include <string_view>
 
 #include "structures/vroom/break.h"
 #include "structures/vroom/job.h"
@@ -26,7 +26,9 @@ struct Step {
   const Id id;
   const Duration service;
   const Amount load;
-  const std::string description;
+  // Non-owning view into the input buffer, which outlives the
+  // problem instance, see io::parse.
+  const std::string_view description;
 
   Duration arrival;
   Duration duration;
@@ -35,11 +37,11 @@ struct Step {
 
   Violations violations;
 
-  Step(STEP_TYPE type, Location location, const Amount& load);
+  Step(STEP_TYPE type, Location location, Amount load);
 
-  Step(const Job& job, const Amount& load);
+  Step(const Job& job, Amount load);
 
-  Step(const Break& b, const Amount& load);
+  Step(const Break& b, Amount load);
 };
 
 } // namespace vroom
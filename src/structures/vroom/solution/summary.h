@@ -10,15 +10,18 @@ All rights reserved (see LICENSE).
 
 */
 
+#include <optional>
+
 #include "structures/vroom/amount.h"
 #include "structures/vroom/solution/computing_times.h"
+#include "structures/vroom/solution/memory_stats.h"
 #include "structures/vroom/solution/violations.h"
 
 namespace vroom {
 
 struct Summary {
   Cost cost;
-  const unsigned unassigned;
+  unsigned unassigned;
   Amount delivery;
   Amount pickup;
   Duration service;
@@ -29,6 +32,9 @@ struct Summary {
   Distance distance;
   ComputingTimes computing_times;
 
+  // Only set when memory stats reporting is enabled on input.
+  std::optional<MemoryStats> memory_stats;
+
   Violations violations;
 
   Summary();
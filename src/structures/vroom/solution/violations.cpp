@@ -13,18 +13,22 @@ All rights reserved (see LICENSE).
 
 namespace vroom {
 
-Violations::Violations() : lead_time(0), delay(0) {
+Violations::Violations() : lead_time(0), delay(0), approximate(false) {
 }
 
 Violations::Violations(const Duration lead_time,
                        const Duration delay,
                        const std::unordered_set<VIOLATION>&& types)
-  : lead_time(lead_time), delay(delay), types(std::move(types)) {
+  : lead_time(lead_time),
+    delay(delay),
+    types(std::move(types)),
+    approximate(false) {
 }
 
 Violations& Violations::operator+=(const Violations& rhs) {
   this->lead_time += rhs.lead_time;
   this->delay += rhs.delay;
+  this->approximate = this->approximate or rhs.approximate;
 
   for (const auto t : rhs.types) {
     this->types.insert(t);
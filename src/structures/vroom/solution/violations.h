@@ -20,6 +20,11 @@ struct Violations {
 
   std::unordered_set<VIOLATION> types;
 
+  // Whether above values are only an upper bound, obtained from the
+  // greedy scheduling fallback when optimal ETA computation did not
+  // fit in the validation time budget.
+  bool approximate;
+
   // Used for steps.
   Violations();
 
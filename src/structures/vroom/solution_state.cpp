@@ -7,35 +7,126 @@ All rights reserved (see LICENSE).
 
 */
 
+
 #include "structures/vroom/solution_state.h"
+#include "utils/cpu_dispatch.h"
+#include "utils/thread_pool.h"
 #include "utils/helpers.h"
 
+namespace {
+
+using vroom::Cost;
+using vroom::Index;
+using vroom::Vehicle;
+
+// Ranks in indices holding the cheapest connection from,
+// respectively to, location index. Flat min-reduction kept as a leaf
+// function so per-target clones can vectorize it.
+VROOM_TARGET_CLONES
+std::pair<Index, Index> cheapest_connection_ranks(
+  const Vehicle& vehicle,
+  Index index,
+  const std::vector<Index>& indices) {
+  auto min_from = std::numeric_limits<Cost>::max();
+  auto min_to = std::numeric_limits<Cost>::max();
+  Index best_from_rank = 0;
+  Index best_to_rank = 0;
+
+  for (std::size_t r = 0; r < indices.size(); ++r) {
+    const auto cost_from = vehicle.cost(index, indices[r]);
+    if (cost_from < min_from) {
+      min_from = cost_from;
+      best_from_rank = r;
+    }
+    const auto cost_to = vehicle.cost(indices[r], index);
+    if (cost_to < min_to) {
+      min_to = cost_to;
+      best_to_rank = r;
+    }
+  }
+
+  return std::make_pair(best_from_rank, best_to_rank);
+}
+
+// Whether materializing all per-class prefix cost planes would
+// overshoot the memory budget. Upper bound: two directions, one
+// plane per cost class, jobs spread across the routes.
+bool over_cost_planes_budget(const vroom::Input& input) {
+  return input.memory_budget() != 0 and
+         input.memory_budget() < 2 * input.nb_vehicle_cost_classes() *
+                                   input.jobs.size() * sizeof(Cost);
+}
+
+} // namespace
+
 namespace vroom {
 namespace utils {
 
-SolutionState::SolutionState(const Input& input)
+SolutionState::SolutionState(const Input& input, unsigned nb_threads)
   : _input(input),
     _nb_vehicles(_input.vehicles.size()),
-    fwd_costs(_nb_vehicles, std::vector<std::vector<Cost>>(_nb_vehicles)),
-    bwd_costs(_nb_vehicles, std::vector<std::vector<Cost>>(_nb_vehicles)),
+    _nb_threads(nb_threads),
+    _reduced_cost_planes(over_cost_planes_budget(input)),
+    _symmetric_class(input.nb_vehicle_cost_classes()),
+    _route_versions(_nb_vehicles, 1),
+    _cheapest_rank_versions(_nb_vehicles * _nb_vehicles, {0, 0}),
+    unassigned(input.jobs),
+    fwd_costs(_nb_vehicles,
+              Planes<Cost>(_reduced_cost_planes
+                             ? 1
+                             : input.nb_vehicle_cost_classes())),
+    bwd_costs(_nb_vehicles,
+              Planes<Cost>(_reduced_cost_planes
+                             ? 1
+                             : input.nb_vehicle_cost_classes())),
     fwd_skill_rank(_nb_vehicles, std::vector<Index>(_nb_vehicles)),
     bwd_skill_rank(_nb_vehicles, std::vector<Index>(_nb_vehicles)),
     edge_costs_around_node(_nb_vehicles),
     node_gains(_nb_vehicles),
     node_candidates(_nb_vehicles),
+    max_edge_costs_around_node(_nb_vehicles),
     edge_costs_around_edge(_nb_vehicles),
     edge_gains(_nb_vehicles),
     edge_candidates(_nb_vehicles),
+    max_edge_removal_bound(_nb_vehicles),
     pd_gains(_nb_vehicles),
     matching_delivery_rank(_nb_vehicles),
     matching_pickup_rank(_nb_vehicles),
-    cheapest_job_rank_in_routes_from(_nb_vehicles,
-                                     std::vector<std::vector<Index>>(
-                                       _nb_vehicles)),
-    cheapest_job_rank_in_routes_to(_nb_vehicles,
-                                   std::vector<std::vector<Index>>(
-                                     _nb_vehicles)),
+    cheapest_job_rank_in_routes_from(_nb_vehicles),
+    cheapest_job_rank_in_routes_to(_nb_vehicles),
     route_costs(_nb_vehicles) {
+  for (std::size_t c = 0; c < _symmetric_class.size(); ++c) {
+    _symmetric_class[c] = _input.vehicles[_input.vehicle_cost_class_rep(c)]
+                            .cost_wrapper.symmetric_durations;
+  }
+}
+
+void SolutionState::setup_vehicles(
+  const std::function<void(Index)>& vehicle_setup) {
+  const auto nb_buckets =
+    std::min(_nb_threads, static_cast<unsigned>(_nb_vehicles));
+
+  if (nb_buckets < 2) {
+    for (std::size_t v = 0; v < _nb_vehicles; ++v) {
+      vehicle_setup(v);
+    }
+    return;
+  }
+
+  // Split per-vehicle computations across available threads, all
+  // vehicles being independent.
+  auto run_on_bucket = [&](unsigned bucket) {
+    for (std::size_t v = bucket; v < _nb_vehicles; v += nb_buckets) {
+      vehicle_setup(v);
+    }
+  };
+
+  std::vector<std::function<void()>> setup_tasks;
+  for (unsigned bucket = 0; bucket < nb_buckets; ++bucket) {
+    setup_tasks.push_back([&run_on_bucket, bucket]() { run_on_bucket(bucket); });
+  }
+
+  utils::ThreadPool::instance().run(std::move(setup_tasks));
 }
 
 void SolutionState::setup(const std::vector<Index>& r, Index v) {
@@ -45,21 +136,16 @@ void SolutionState::setup(const std::vector<Index>& r, Index v) {
   set_edge_gains(r, v);
   set_pd_matching_ranks(r, v);
   set_pd_gains(r, v);
-#ifndef NDEBUG
   update_route_cost(r, v);
-#endif
 }
 
 void SolutionState::setup(const RawSolution& sol) {
-  for (std::size_t v = 0; v < _nb_vehicles; ++v) {
-    setup(sol[v].route, v);
-  }
+  setup_vehicles([&](Index v) { setup(sol[v].route, v); });
 
   // Initialize unassigned jobs.
-  Index x = 0;
-  std::generate_n(std::inserter(unassigned, unassigned.end()),
-                  _input.jobs.size(),
-                  [&] { return x++; });
+  for (Index j = 0; j < _input.jobs.size(); ++j) {
+    unassigned.insert(j);
+  }
 
   for (const auto& s : sol) {
     for (const auto i : s.route) {
@@ -69,15 +155,12 @@ void SolutionState::setup(const RawSolution& sol) {
 }
 
 void SolutionState::setup(const TWSolution& tw_sol) {
-  for (std::size_t v = 0; v < _nb_vehicles; ++v) {
-    setup(tw_sol[v].route, v);
-  }
+  setup_vehicles([&](Index v) { setup(tw_sol[v].route, v); });
 
   // Initialize unassigned jobs.
-  Index x = 0;
-  std::generate_n(std::inserter(unassigned, unassigned.end()),
-                  _input.jobs.size(),
-                  [&] { return x++; });
+  for (Index j = 0; j < _input.jobs.size(); ++j) {
+    unassigned.insert(j);
+  }
 
   for (const auto& tw_r : tw_sol) {
     for (const auto i : tw_r.route) {
@@ -86,43 +169,125 @@ void SolutionState::setup(const TWSolution& tw_sol) {
   }
 }
 
+void SolutionState::bump_route_version(Index v) {
+  ++_route_versions[v];
+}
+
+unsigned SolutionState::route_version(Index v) const {
+  return _route_versions[v];
+}
+
 void SolutionState::update_costs(const std::vector<Index>& route, Index v) {
-  fwd_costs[v] =
-    std::vector<std::vector<Cost>>(_nb_vehicles,
-                                   std::vector<Cost>(route.size()));
-  bwd_costs[v] =
-    std::vector<std::vector<Cost>>(_nb_vehicles,
-                                   std::vector<Cost>(route.size()));
+  fwd_costs[v].reset(route.size());
+  bwd_costs[v].reset(route.size());
+
+  // One plane per vehicle cost class is enough, vehicles sharing a
+  // cost model see the exact same costs. With reduced cost planes
+  // only the own class view is materialized, see fwd_cost/bwd_cost.
+  const auto nb_planes =
+    _reduced_cost_planes ? static_cast<Index>(1)
+                         : static_cast<Index>(_input.nb_vehicle_cost_classes());
 
   Index previous_index = 0; // dummy init
   if (!route.empty()) {
     previous_index = _input.jobs[route[0]].index();
-    for (Index v_rank = 0; v_rank < _nb_vehicles; ++v_rank) {
-      fwd_costs[v][v_rank][0] = 0;
-      bwd_costs[v][v_rank][0] = 0;
+    for (Index p = 0; p < nb_planes; ++p) {
+      fwd_costs[v][p][0] = 0;
+      bwd_costs[v][p][0] = 0;
     }
   }
 
+  // Prefetch the matrix rows involved a few ranks ahead of the scan,
+  // they are index-chased so the hardware prefetcher cannot predict
+  // them.
+  constexpr std::size_t prefetch_distance = 4;
   for (std::size_t i = 1; i < route.size(); ++i) {
     const auto current_index = _input.jobs[route[i]].index();
-    for (Index v_rank = 0; v_rank < _nb_vehicles; ++v_rank) {
-      const auto& other_v = _input.vehicles[v_rank];
-      fwd_costs[v][v_rank][i] = fwd_costs[v][v_rank][i - 1] +
-                                other_v.duration(previous_index, current_index);
-
-      bwd_costs[v][v_rank][i] = bwd_costs[v][v_rank][i - 1] +
-                                other_v.duration(current_index, previous_index);
+    for (Index p = 0; p < nb_planes; ++p) {
+      const auto c = _reduced_cost_planes ? _input.vehicle_cost_class(v) : p;
+      const auto& other_v = _input.vehicles[_input.vehicle_cost_class_rep(c)];
+      if (i + prefetch_distance < route.size()) {
+        const auto ahead = _input.jobs[route[i + prefetch_distance]].index();
+        const auto before_ahead =
+          _input.jobs[route[i + prefetch_distance - 1]].index();
+        other_v.cost_wrapper.prefetch_duration(before_ahead, ahead);
+        other_v.cost_wrapper.prefetch_duration(ahead, before_ahead);
+      }
+      fwd_costs[v][p][i] = fwd_costs[v][p][i - 1] +
+                           other_v.duration(previous_index, current_index);
+
+      // Symmetric planes skip the backward accumulation altogether,
+      // bwd_cost redirects their reads to the forward data.
+      if (!_symmetric_class[c]) {
+        bwd_costs[v][p][i] = bwd_costs[v][p][i - 1] +
+                             other_v.duration(current_index, previous_index);
+      }
     }
     previous_index = current_index;
   }
 }
 
+Cost SolutionState::fwd_cost(const std::vector<Index>& route,
+                             Index v,
+                             Index c,
+                             std::size_t i) const {
+  if (!_reduced_cost_planes) {
+    return fwd_costs[v][c][i];
+  }
+  if (c == _input.vehicle_cost_class(v)) {
+    return fwd_costs[v][0][i];
+  }
+
+  // Foreign-class view, recompute the prefix on demand.
+  const auto& other_v = _input.vehicles[_input.vehicle_cost_class_rep(c)];
+  Cost cost = 0;
+  for (std::size_t r = 1; r <= i; ++r) {
+    cost += other_v.duration(_input.jobs[route[r - 1]].index(),
+                             _input.jobs[route[r]].index());
+  }
+  return cost;
+}
+
+Cost SolutionState::bwd_cost(const std::vector<Index>& route,
+                             Index v,
+                             Index c,
+                             std::size_t i) const {
+  if (_symmetric_class[c]) {
+    // Reversing edges leaves prefixes untouched and the backward
+    // plane is not even filled, read the forward side.
+    return fwd_cost(route, v, c, i);
+  }
+  if (!_reduced_cost_planes) {
+    return bwd_costs[v][c][i];
+  }
+  if (c == _input.vehicle_cost_class(v)) {
+    return bwd_costs[v][0][i];
+  }
+
+  // Foreign-class view, recompute the prefix with reversed edges.
+  const auto& other_v = _input.vehicles[_input.vehicle_cost_class_rep(c)];
+  Cost cost = 0;
+  for (std::size_t r = 1; r <= i; ++r) {
+    cost += other_v.duration(_input.jobs[route[r]].index(),
+                             _input.jobs[route[r - 1]].index());
+  }
+  return cost;
+}
+
 void SolutionState::update_skills(const std::vector<Index>& route, Index v1) {
   for (std::size_t v2 = 0; v2 < _nb_vehicles; ++v2) {
     if (v1 == v2) {
       continue;
     }
 
+    if (_input.vehicle_ok_with_all_jobs(v2)) {
+      // Trivial ranks without scanning the route, the usual case on
+      // uniform fleets.
+      fwd_skill_rank[v1][v2] = route.size();
+      bwd_skill_rank[v1][v2] = 0;
+      continue;
+    }
+
     auto fwd = std::find_if_not(route.begin(), route.end(), [&](auto j_rank) {
       return _input.vehicle_ok_with_job(v2, j_rank);
     });
@@ -138,6 +303,7 @@ void SolutionState::update_skills(const std::vector<Index>& route, Index v1) {
 void SolutionState::set_node_gains(const std::vector<Index>& route, Index v) {
   node_gains[v] = std::vector<Gain>(route.size());
   edge_costs_around_node[v] = std::vector<Gain>(route.size());
+  max_edge_costs_around_node[v] = 0;
 
   if (route.size() == 0) {
     return;
@@ -183,6 +349,7 @@ void SolutionState::set_node_gains(const std::vector<Index>& route, Index v) {
 
   Gain edges_costs_around = previous_cost + next_cost;
   edge_costs_around_node[v][0] = edges_costs_around;
+  max_edge_costs_around_node[v] = edges_costs_around;
 
   Gain current_gain = edges_costs_around - new_edge_cost;
   node_gains[v][0] = current_gain;
@@ -204,6 +371,8 @@ void SolutionState::set_node_gains(const std::vector<Index>& route, Index v) {
     edges_costs_around =
       vehicle.cost(p_index, c_index) + vehicle.cost(c_index, n_index);
     edge_costs_around_node[v][i] = edges_costs_around;
+    max_edge_costs_around_node[v] =
+      std::max(max_edge_costs_around_node[v], edges_costs_around);
 
     current_gain = edges_costs_around - vehicle.cost(p_index, n_index);
     node_gains[v][i] = current_gain;
@@ -246,6 +415,8 @@ void SolutionState::set_node_gains(const std::vector<Index>& route, Index v) {
 
   edges_costs_around = previous_cost + next_cost;
   edge_costs_around_node[v][last_rank] = edges_costs_around;
+  max_edge_costs_around_node[v] =
+    std::max(max_edge_costs_around_node[v], edges_costs_around);
 
   current_gain = edges_costs_around - new_edge_cost;
   node_gains[v][last_rank] = current_gain;
@@ -260,6 +431,7 @@ void SolutionState::set_edge_gains(const std::vector<Index>& route, Index v) {
 
   edge_gains[v] = std::vector<Gain>(nb_edges);
   edge_costs_around_edge[v] = std::vector<Gain>(nb_edges);
+  max_edge_removal_bound[v] = 0;
 
   if (route.size() < 2) {
     return;
@@ -306,6 +478,8 @@ void SolutionState::set_edge_gains(const std::vector<Index>& route, Index v) {
 
   Gain edges_costs_around = previous_cost + next_cost;
   edge_costs_around_edge[v][0] = edges_costs_around;
+  max_edge_removal_bound[v] =
+    edges_costs_around + vehicle.cost(c_index, after_c_index);
 
   Gain current_gain = edges_costs_around - new_edge_cost;
   edge_gains[v][0] = current_gain;
@@ -329,6 +503,9 @@ void SolutionState::set_edge_gains(const std::vector<Index>& route, Index v) {
     edges_costs_around =
       vehicle.cost(p_index, c_index) + vehicle.cost(after_c_index, n_index);
     edge_costs_around_edge[v][i] = edges_costs_around;
+    max_edge_removal_bound[v] =
+      std::max(max_edge_removal_bound[v],
+               edges_costs_around + vehicle.cost(c_index, after_c_index));
 
     current_gain = edges_costs_around - vehicle.cost(p_index, n_index);
     edge_gains[v][i] = current_gain;
@@ -372,6 +549,9 @@ void SolutionState::set_edge_gains(const std::vector<Index>& route, Index v) {
 
   edges_costs_around = previous_cost + next_cost;
   edge_costs_around_edge[v][last_edge_rank] = edges_costs_around;
+  max_edge_removal_bound[v] =
+    std::max(max_edge_removal_bound[v],
+             edges_costs_around + vehicle.cost(c_index, after_c_index));
 
   current_gain = edges_costs_around - new_edge_cost;
   edge_gains[v][last_edge_rank] = current_gain;
@@ -493,34 +673,34 @@ void SolutionState::update_cheapest_job_rank_in_routes(
   const std::vector<Index>& route_2,
   Index v1,
   Index v2) {
-  cheapest_job_rank_in_routes_from[v1][v2].assign(route_1.size(), 0);
-  cheapest_job_rank_in_routes_to[v1][v2].assign(route_1.size(), 0);
+  auto& seen_versions = _cheapest_rank_versions[v1 * _nb_vehicles + v2];
+  const auto current_versions =
+    std::make_pair(_route_versions[v1], _route_versions[v2]);
+  if (seen_versions == current_versions) {
+    // Neither route changed since last update for this pair.
+    return;
+  }
+  seen_versions = current_versions;
+
+  cheapest_job_rank_in_routes_from(v1, v2).assign(route_1.size(), 0);
+  cheapest_job_rank_in_routes_to(v1, v2).assign(route_1.size(), 0);
 
+  // Gather matrix indices once instead of per route_1 rank.
+  std::vector<Index> indices_2(route_2.size());
+  std::transform(route_2.begin(),
+                 route_2.end(),
+                 indices_2.begin(),
+                 [&](Index r2) { return _input.jobs[r2].index(); });
+
+  const auto& vehicle = _input.vehicles[v2];
   for (std::size_t r1 = 0; r1 < route_1.size(); ++r1) {
-    Index index_r1 = _input.jobs[route_1[r1]].index();
-
-    auto min_from = std::numeric_limits<Cost>::max();
-    auto min_to = std::numeric_limits<Cost>::max();
-    Index best_from_rank = 0;
-    Index best_to_rank = 0;
-
-    const auto& vehicle = _input.vehicles[v2];
-    for (std::size_t r2 = 0; r2 < route_2.size(); ++r2) {
-      const Index index_r2 = _input.jobs[route_2[r2]].index();
-      const auto cost_from = vehicle.cost(index_r1, index_r2);
-      if (cost_from < min_from) {
-        min_from = cost_from;
-        best_from_rank = r2;
-      }
-      const auto cost_to = vehicle.cost(index_r2, index_r1);
-      if (cost_to < min_to) {
-        min_to = cost_to;
-        best_to_rank = r2;
-      }
-    }
+    const Index index_r1 = _input.jobs[route_1[r1]].index();
+
+    const auto best_ranks =
+      cheapest_connection_ranks(vehicle, index_r1, indices_2);
 
-    cheapest_job_rank_in_routes_from[v1][v2][r1] = best_from_rank;
-    cheapest_job_rank_in_routes_to[v1][v2][r1] = best_to_rank;
+    cheapest_job_rank_in_routes_from(v1, v2)[r1] = best_ranks.first;
+    cheapest_job_rank_in_routes_to(v1, v2)[r1] = best_ranks.second;
   }
 }
 
@@ -10,6 +10,9 @@ All rights reserved (see LICENSE).
 
 */
 
+#include <functional>
+#include <utility>
+
 #include "structures/typedefs.h"
 #include "structures/vroom/input/input.h"
 #include "structures/vroom/tw_route.h"
@@ -20,32 +23,225 @@ namespace utils {
 using RawSolution = std::vector<RawRoute>;
 using TWSolution = std::vector<TWRoute>;
 
+// Mutable view over a single plane in a Planes<T> collection.
+template <class T> class PlaneView {
+  T* _data;
+  std::size_t _size;
+
+public:
+  PlaneView(T* data, std::size_t size) : _data(data), _size(size) {
+  }
+
+  T& operator[](std::size_t i) const {
+    return _data[i];
+  }
+
+  T& back() const {
+    return _data[_size - 1];
+  }
+
+  std::size_t size() const {
+    return _size;
+  }
+};
+
+// Fixed number of equally-sized planes stored in a single contiguous
+// allocation, reused across resets. Used to flatten the per-vehicle
+// cost caches that are rebuilt whenever a route changes.
+template <class T> class Planes {
+  std::size_t _nb_planes;
+  std::size_t _plane_size;
+  std::vector<T> _data;
+
+public:
+  Planes() : Planes(0) {
+  }
+
+  Planes(std::size_t nb_planes) : _nb_planes(nb_planes), _plane_size(0) {
+  }
+
+  // Resize all planes and zero them out, reusing the current
+  // allocation whenever big enough.
+  void reset(std::size_t plane_size) {
+    _plane_size = plane_size;
+    _data.assign(_nb_planes * plane_size, T());
+  }
+
+  PlaneView<T> operator[](std::size_t p) {
+    return PlaneView<T>(_data.data() + p * _plane_size, _plane_size);
+  }
+
+  PlaneView<const T> operator[](std::size_t p) const {
+    return PlaneView<const T>(_data.data() + p * _plane_size, _plane_size);
+  }
+};
+
+// Per-(v1, v2) vectors flattened to a single pair-indexed collection
+// so lookups only chase one level of indirection.
+template <class T> class VehiclePairVectors {
+  std::size_t _nb_vehicles;
+  std::vector<std::vector<T>> _data;
+
+public:
+  VehiclePairVectors(std::size_t nb_vehicles)
+    : _nb_vehicles(nb_vehicles), _data(nb_vehicles * nb_vehicles) {
+  }
+
+  std::vector<T>& operator()(Index v1, Index v2) {
+    return _data[v1 * _nb_vehicles + v2];
+  }
+
+  const std::vector<T>& operator()(Index v1, Index v2) const {
+    return _data[v1 * _nb_vehicles + v2];
+  }
+};
+
 struct SolutionIndicators {
   Priority priority_sum;
   unsigned unassigned;
   Cost cost;
   unsigned used_vehicles;
+  // Order-independent combination of per-route job sequence hashes,
+  // identifying the underlying assignment in O(1). See
+  // utils::solution_indicators.
+  uint64_t hash;
+
+  // All four 32-bit fields packed into a (high, low) pair of 64-bit
+  // words ordered from most to least significant criterion, turning
+  // the nested branch chain of the comparison into two integer
+  // compares. priority_sum is bitwise-inverted since a higher
+  // priority sum is better while all other fields are minimized.
+  std::pair<uint64_t, uint64_t> packed_key() const {
+    return {(static_cast<uint64_t>(~priority_sum) << 32) |
+              static_cast<uint64_t>(unassigned),
+            (static_cast<uint64_t>(cost) << 32) |
+              static_cast<uint64_t>(used_vehicles)};
+  }
 
   friend bool operator<(const SolutionIndicators& lhs,
                         const SolutionIndicators& rhs) {
-    if (lhs.priority_sum > rhs.priority_sum) {
-      return true;
+    return lhs.packed_key() < rhs.packed_key();
+  }
+
+  friend bool operator==(const SolutionIndicators& lhs,
+                         const SolutionIndicators& rhs) {
+    return lhs.hash == rhs.hash and lhs.priority_sum == rhs.priority_sum and
+           lhs.unassigned == rhs.unassigned and lhs.cost == rhs.cost and
+           lhs.used_vehicles == rhs.used_vehicles;
+  }
+};
+
+// Set of unassigned job ranks bucketed by job priority: dense
+// per-priority lists with O(1) insertion and swap-removal, iterated
+// strictly from the highest priority stratum down so that insertion
+// scans can stop at a stratum boundary instead of filtering a flat
+// set on every pass.
+class PriorityBucketSet {
+private:
+  // _buckets[p] holds the ranks of priority p jobs currently in the
+  // set, located through their bucket position for O(1) removal.
+  std::vector<std::vector<Index>> _buckets;
+  std::vector<Priority> _job_priority;
+  std::vector<std::size_t> _position;
+  std::vector<bool> _present;
+  std::size_t _size = 0;
+
+public:
+  PriorityBucketSet() = default;
+
+  explicit PriorityBucketSet(const std::vector<Job>& jobs)
+    : _buckets(MAX_PRIORITY + 1),
+      _job_priority(jobs.size()),
+      _position(jobs.size(), 0),
+      _present(jobs.size(), false) {
+    for (std::size_t j = 0; j < jobs.size(); ++j) {
+      _job_priority[j] = jobs[j].priority;
+    }
+  }
+
+  std::size_t size() const {
+    return _size;
+  }
+
+  bool contains(Index j) const {
+    return _present[j];
+  }
+
+  void insert(Index j) {
+    if (_present[j]) {
+      return;
     }
-    if (lhs.priority_sum == rhs.priority_sum) {
-      if (lhs.unassigned < rhs.unassigned) {
-        return true;
+    auto& bucket = _buckets[_job_priority[j]];
+    _position[j] = bucket.size();
+    bucket.push_back(j);
+    _present[j] = true;
+    ++_size;
+  }
+
+  void erase(Index j) {
+    if (!_present[j]) {
+      return;
+    }
+    auto& bucket = _buckets[_job_priority[j]];
+    const auto pos = _position[j];
+    bucket[pos] = bucket.back();
+    _position[bucket[pos]] = pos;
+    bucket.pop_back();
+    _present[j] = false;
+    --_size;
+  }
+
+  // Walks buckets by decreasing priority. _bucket is offset by one so
+  // that 0 doubles as the end sentinel.
+  class const_iterator {
+  private:
+    const std::vector<std::vector<Index>>* _all_buckets;
+    std::size_t _bucket;
+    std::size_t _pos;
+
+    void advance_to_non_empty() {
+      while (_bucket > 0 and _pos == (*_all_buckets)[_bucket - 1].size()) {
+        --_bucket;
+        _pos = 0;
       }
-      if (lhs.unassigned == rhs.unassigned) {
-        if (lhs.cost < rhs.cost) {
-          return true;
-        }
-        if (lhs.cost == rhs.cost and lhs.used_vehicles < rhs.used_vehicles) {
-          return true;
-        }
+    }
+
+  public:
+    const_iterator(const std::vector<std::vector<Index>>& all_buckets,
+                   bool at_end)
+      : _all_buckets(&all_buckets),
+        _bucket(at_end ? 0 : all_buckets.size()),
+        _pos(0) {
+      if (!at_end) {
+        advance_to_non_empty();
       }
     }
 
-    return false;
+    Index operator*() const {
+      return (*_all_buckets)[_bucket - 1][_pos];
+    }
+
+    const_iterator& operator++() {
+      ++_pos;
+      advance_to_non_empty();
+      return *this;
+    }
+
+    bool operator!=(const const_iterator& other) const {
+      return _bucket != other._bucket or _pos != other._pos;
+    }
+
+    bool operator==(const const_iterator& other) const {
+      return !(*this != other);
+    }
+  };
+
+  const_iterator begin() const {
+    return const_iterator(_buckets, false);
+  }
+
+  const_iterator end() const {
+    return const_iterator(_buckets, true);
   }
 };
 
@@ -53,19 +249,50 @@ class SolutionState {
 private:
   const Input& _input;
   const std::size_t _nb_vehicles;
+  // Number of threads used for per-vehicle computations in setup.
+  const unsigned _nb_threads;
+
+  // Whether the per-class cost planes are materialized for the own
+  // cost class only, because filling them all would overshoot
+  // Input::memory_budget. Foreign-class views then go through
+  // fwd_cost/bwd_cost which recompute the prefix on demand.
+  const bool _reduced_cost_planes;
+
+  // Per cost class, whether durations are known symmetric. Backward
+  // cost prefixes then exactly match the forward ones, so
+  // update_costs skips the backward accumulation for those planes
+  // and bwd_cost reads the forward data instead. This halves the
+  // prefix scans for the common distance-matrix case, where the
+  // reverse-orientation machinery (ReverseTwoOpt and the reversed
+  // arms of the cross-exchanges) pays no extra state upkeep.
+  std::vector<bool> _symmetric_class;
+
+  // Route versions are bumped on every route content change and
+  // compared against the versions seen at the last
+  // update_cheapest_job_rank_in_routes call for each pair, so that
+  // unchanged pairs are not recomputed.
+  std::vector<unsigned> _route_versions;
+  std::vector<std::pair<unsigned, unsigned>> _cheapest_rank_versions;
+
+  // Apply per-vehicle setup for all vehicles, in parallel whenever
+  // several threads are available.
+  void setup_vehicles(const std::function<void(Index)>& vehicle_setup);
 
 public:
-  // Store unassigned jobs.
-  std::unordered_set<Index> unassigned;
-
-  // fwd_costs[v][new_v][i] stores the total cost from job at rank 0
-  // to job at rank i in the route for vehicle v, from the point of
-  // view of a vehicle new_v. bwd_costs[v][new_v][i] stores the total
-  // cost from job at rank i to job at rank 0 (i.e. when *reversing*
-  // all edges) in the route for vehicle v, from the point of view of
-  // a vehicle new_v.
-  std::vector<std::vector<std::vector<Cost>>> fwd_costs;
-  std::vector<std::vector<std::vector<Cost>>> bwd_costs;
+  // Store unassigned jobs, bucketed by priority and iterated from
+  // the highest stratum down.
+  PriorityBucketSet unassigned;
+
+  // fwd_costs[v][c][i] stores the total cost from job at rank 0 to
+  // job at rank i in the route for vehicle v, from the point of view
+  // of any vehicle in cost class c (vehicles with identical cost
+  // models share a plane, see Input::vehicle_cost_class). bwd_costs
+  // [v][c][i] stores the total cost from job at rank i to job at
+  // rank 0 (i.e. when *reversing* all edges) in the route for
+  // vehicle v, from the same point of view. All planes for a given v
+  // live in a single contiguous allocation.
+  std::vector<Planes<Cost>> fwd_costs;
+  std::vector<Planes<Cost>> bwd_costs;
 
   // fwd_skill_rank[v1][v2] stores the maximum rank r for a step in
   // route for vehicle v1 such that v2 can handle all jobs from step 0
@@ -87,6 +314,13 @@ public:
   std::vector<std::vector<Gain>> node_gains;
   std::vector<Index> node_candidates;
 
+  // max_edge_costs_around_node[v] is the maximum of
+  // edge_costs_around_node[v][i] over all ranks, an upper bound on
+  // the gain available from swapping out any single node of the
+  // route. See max_edge_removal_bound for the matching edge-level
+  // bound and intended pruning use.
+  std::vector<Gain> max_edge_costs_around_node;
+
   // edge_costs_around_edge[v][i] stores the sum of costs for edges
   // that appear before and after edge starting at rank i in route for
   // vehicle v (handling cases where those edges are absent or linked
@@ -98,6 +332,14 @@ public:
   std::vector<std::vector<Gain>> edge_gains;
   std::vector<Index> edge_candidates;
 
+  // max_edge_removal_bound[v] is an upper bound on the gain available
+  // on the route for vehicle v from swapping out any of its edges:
+  // the maximum over ranks of edge_costs_around_edge[v][i] plus the
+  // cost of the edge itself. Whatever replaces the edge costs a
+  // non-negative amount, so pairs of routes whose summed bounds do
+  // not beat the incumbent gain can be pruned upfront.
+  std::vector<Gain> max_edge_removal_bound;
+
   // pd_gains[v][i] stores potential gain when removing pickup at rank
   // i in route for vehicle v along with it's associated delivery.
   std::vector<std::vector<Gain>> pd_gains;
@@ -109,19 +351,21 @@ public:
   std::vector<std::vector<Index>> matching_delivery_rank;
   std::vector<std::vector<Index>> matching_pickup_rank;
 
-  // cheapest_job_rank_in_routes_from[v1][v2][r1] stores the rank of
+  // cheapest_job_rank_in_routes_from(v1, v2)[r1] stores the rank of
   // job in route v2 that minimize cost (as seen from the v2
   // perspective) from job at rank r1 in v1.
-  std::vector<std::vector<std::vector<Index>>> cheapest_job_rank_in_routes_from;
-  // cheapest_job_rank_in_routes_to[v1][v2][r1] stores the rank of job
+  VehiclePairVectors<Index> cheapest_job_rank_in_routes_from;
+  // cheapest_job_rank_in_routes_to(v1, v2)[r1] stores the rank of job
   // in route v2 that minimize cost (as seen from the v2 perspective)
   // to job at rank r1 in v1.
-  std::vector<std::vector<std::vector<Index>>> cheapest_job_rank_in_routes_to;
+  VehiclePairVectors<Index> cheapest_job_rank_in_routes_to;
 
-  // Only used for assertions in debug mode.
+  // Per-route costs, refreshed at every route mutation site so
+  // solution-level cost aggregates in one pass over vehicles instead
+  // of a full re-summation over jobs.
   std::vector<Cost> route_costs;
 
-  SolutionState(const Input& input);
+  SolutionState(const Input& input, unsigned nb_threads = 1);
 
   void setup(const std::vector<Index>& r, Index v);
 
@@ -131,6 +375,20 @@ public:
 
   void update_costs(const std::vector<Index>& route, Index v);
 
+  // Accessors matching fwd_costs[v][c][i] and bwd_costs[v][c][i] on
+  // the route for vehicle v. They read the planes when materialized
+  // and recompute the prefix through the cost class representative
+  // when running with reduced cost planes, see _reduced_cost_planes.
+  Cost fwd_cost(const std::vector<Index>& route,
+                Index v,
+                Index c,
+                std::size_t i) const;
+
+  Cost bwd_cost(const std::vector<Index>& route,
+                Index v,
+                Index c,
+                std::size_t i) const;
+
   void update_skills(const std::vector<Index>& route, Index v1);
 
   void set_node_gains(const std::vector<Index>& route, Index v);
@@ -141,6 +399,13 @@ public:
 
   void set_pd_matching_ranks(const std::vector<Index>& route, Index v);
 
+  // Signal a content change for route of vehicle v. Required at all
+  // route mutation sites so that version-based caches and don't-look
+  // marks stay in sync.
+  void bump_route_version(Index v);
+
+  unsigned route_version(Index v) const;
+
   void update_cheapest_job_rank_in_routes(const std::vector<Index>& route_1,
                                           const std::vector<Index>& route_2,
                                           Index v1,
@@ -10,9 +10,12 @@ All rights reserved (see LICENSE).
 #include <algorithm>
 
 #include "structures/vroom/tw_route.h"
+#include "utils/helpers.h"
 
 namespace vroom {
 
+thread_local bool TWRoute::_recording_enabled = true;
+
 TWRoute::TWRoute(const Input& input, Index v)
   : RawRoute(input, v),
     v_start(input.vehicles[v].tw.start),
@@ -28,14 +31,18 @@ TWRoute::TWRoute(const Input& input, Index v)
 
   const auto& breaks = input.vehicles[v].breaks;
 
+  break_service_sums.reserve(breaks.size() + 1);
+  break_service_sums.push_back(0);
+  for (const auto& b : breaks) {
+    break_service_sums.push_back(break_service_sums.back() + b.service);
+  }
+
   Duration previous_earliest = v_start;
 
   for (Index i = 0; i < breaks.size(); ++i) {
     const auto& b = breaks[i];
     const auto b_tw =
-      std::find_if(b.tws.begin(), b.tws.end(), [&](const auto& tw) {
-        return previous_earliest <= tw.end;
-      });
+      utils::earliest_available_tw(b.tws, previous_earliest);
     if (b_tw == b.tws.end()) {
       throw Exception(ERROR::INPUT, break_error);
     }
@@ -57,9 +64,7 @@ TWRoute::TWRoute(const Input& input, Index v)
     next_latest -= b.service;
 
     const auto b_tw =
-      std::find_if(b.tws.rbegin(), b.tws.rend(), [&](const auto& tw) {
-        return tw.start <= next_latest;
-      });
+      utils::latest_available_tw(b.tws, next_latest);
     if (b_tw == b.tws.rend()) {
       throw Exception(ERROR::INPUT, break_error);
     }
@@ -85,10 +90,9 @@ Duration TWRoute::previous_earliest_end(const Input& input,
   Duration previous_earliest = v_start;
   Duration previous_service = 0;
   if (rank > 0) {
-    const auto& previous_job = input.jobs[route[rank - 1]];
     previous_earliest = earliest[rank - 1];
-    previous_service = previous_job.service;
-    previous_travel = v.duration(previous_job.index(), j.index());
+    previous_service = action_times[rank - 1];
+    previous_travel = v.duration(job_indices[rank - 1], j.index());
   } else {
     if (has_start) {
       previous_travel = v.duration(v.start.value().index(), j.index());
@@ -112,13 +116,14 @@ Duration TWRoute::next_latest_start(const Input& input,
     }
   } else {
     next_latest = latest[rank];
-    next_travel = v.duration(j.index(), input.jobs[route[rank]].index());
+    next_travel = v.duration(j.index(), job_indices[rank]);
   }
 
   return next_latest;
 }
 
 void TWRoute::fwd_update_earliest_from(const Input& input, Index rank) {
+  assert(job_indices.size() == route.size());
   const auto& v = input.vehicles[vehicle_rank];
 
   Duration current_earliest = earliest[rank];
@@ -127,8 +132,8 @@ void TWRoute::fwd_update_earliest_from(const Input& input, Index rank) {
   for (Index i = rank + 1; i < route.size(); ++i) {
     const auto& next_j = input.jobs[route[i]];
     Duration remaining_travel_time =
-      v.duration(input.jobs[route[i - 1]].index(), next_j.index());
-    Duration previous_service = input.jobs[route[i - 1]].service;
+      v.duration(job_indices[i - 1], job_indices[i]);
+    Duration previous_service = action_times[i - 1];
 
     // Update earliest dates and margins for breaks.
     assert(breaks_at_rank[i] <= breaks_counts[i]);
@@ -140,9 +145,7 @@ void TWRoute::fwd_update_earliest_from(const Input& input, Index rank) {
       current_earliest += previous_service;
 
       const auto b_tw =
-        std::find_if(b.tws.begin(), b.tws.end(), [&](const auto& tw) {
-          return current_earliest <= tw.end;
-        });
+        utils::earliest_available_tw(b.tws, current_earliest);
       assert(b_tw != b.tws.end());
 
       if (current_earliest < b_tw->start) {
@@ -167,9 +170,7 @@ void TWRoute::fwd_update_earliest_from(const Input& input, Index rank) {
     current_earliest += previous_service + remaining_travel_time;
 
     const auto j_tw =
-      std::find_if(next_j.tws.begin(), next_j.tws.end(), [&](const auto& tw) {
-        return current_earliest <= tw.end;
-      });
+      utils::earliest_available_tw(next_j.tws, current_earliest);
     assert(j_tw != next_j.tws.end());
 
     current_earliest = std::max(current_earliest, j_tw->start);
@@ -190,11 +191,10 @@ void TWRoute::fwd_update_earliest_from(const Input& input, Index rank) {
     // before route end.
     Index i = route.size();
     Duration remaining_travel_time =
-      (v.has_end())
-        ? v.duration(input.jobs[route[i - 1]].index(), v.end.value().index())
-        : 0;
+      (v.has_end()) ? v.duration(job_indices[i - 1], v.end.value().index())
+                    : 0;
 
-    Duration previous_service = input.jobs[route[i - 1]].service;
+    Duration previous_service = action_times[i - 1];
 
     assert(breaks_at_rank[i] <= breaks_counts[i]);
     Index break_rank = breaks_counts[i] - breaks_at_rank[i];
@@ -204,9 +204,7 @@ void TWRoute::fwd_update_earliest_from(const Input& input, Index rank) {
       current_earliest += previous_service;
 
       const auto b_tw =
-        std::find_if(b.tws.begin(), b.tws.end(), [&](const auto& tw) {
-          return current_earliest <= tw.end;
-        });
+        utils::earliest_available_tw(b.tws, current_earliest);
       assert(b_tw != b.tws.end());
 
       if (current_earliest < b_tw->start) {
@@ -233,6 +231,7 @@ void TWRoute::fwd_update_earliest_from(const Input& input, Index rank) {
 }
 
 void TWRoute::bwd_update_latest_from(const Input& input, Index rank) {
+  assert(job_indices.size() == route.size());
   const auto& v = input.vehicles[vehicle_rank];
 
   Duration current_latest = latest[rank];
@@ -241,7 +240,7 @@ void TWRoute::bwd_update_latest_from(const Input& input, Index rank) {
   for (Index next_i = rank; next_i > 0; --next_i) {
     const auto& previous_j = input.jobs[route[next_i - 1]];
     Duration remaining_travel_time =
-      v.duration(previous_j.index(), input.jobs[route[next_i]].index());
+      v.duration(job_indices[next_i - 1], job_indices[next_i]);
 
     // Update latest dates and margins for breaks.
     assert(breaks_at_rank[next_i] <= breaks_counts[next_i]);
@@ -255,9 +254,7 @@ void TWRoute::bwd_update_latest_from(const Input& input, Index rank) {
       current_latest -= b.service;
 
       const auto b_tw =
-        std::find_if(b.tws.rbegin(), b.tws.rend(), [&](const auto& tw) {
-          return tw.start <= current_latest;
-        });
+        utils::latest_available_tw(b.tws, current_latest);
       assert(b_tw != b.tws.rend());
 
       if (b_tw->end < current_latest) {
@@ -278,14 +275,12 @@ void TWRoute::bwd_update_latest_from(const Input& input, Index rank) {
     }
 
     // Back to the job after breaks.
-    auto gap = previous_j.service + remaining_travel_time;
+    auto gap = action_times[next_i - 1] + remaining_travel_time;
     assert(gap <= current_latest);
     current_latest -= gap;
 
     const auto j_tw =
-      std::find_if(previous_j.tws.rbegin(),
-                   previous_j.tws.rend(),
-                   [&](const auto& tw) { return tw.start <= current_latest; });
+      utils::latest_available_tw(previous_j.tws, current_latest);
     assert(j_tw != previous_j.tws.rend());
 
     current_latest = std::min(current_latest, j_tw->end);
@@ -317,9 +312,7 @@ void TWRoute::bwd_update_latest_from(const Input& input, Index rank) {
       current_latest -= b.service;
 
       const auto b_tw =
-        std::find_if(b.tws.rbegin(), b.tws.rend(), [&](const auto& tw) {
-          return tw.start <= current_latest;
-        });
+        utils::latest_available_tw(b.tws, current_latest);
       assert(b_tw != b.tws.rend());
       if (b_tw->end < current_latest) {
         breaks_travel_margin_after[break_rank] = current_latest - b_tw->end;
@@ -343,14 +336,9 @@ OrderChoice::OrderChoice(const Input& input,
     job_rank(job_rank),
     add_job_first(false),
     add_break_first(false),
-    j_tw(std::find_if(input.jobs[job_rank].tws.begin(),
-                      input.jobs[job_rank].tws.end(),
-                      [&](const auto& tw) {
-                        return current_earliest + previous_travel <= tw.end;
-                      })),
-    b_tw(std::find_if(b.tws.begin(), b.tws.end(), [&](const auto& tw) {
-      return current_earliest <= tw.end;
-    })) {
+    j_tw(utils::earliest_available_tw(input.jobs[job_rank].tws,
+                                      current_earliest + previous_travel)),
+    b_tw(utils::earliest_available_tw(b.tws, current_earliest)) {
 }
 
 OrderChoice TWRoute::order_choice(const Input& input,
@@ -379,9 +367,7 @@ OrderChoice TWRoute::order_choice(const Input& input,
   Duration job_then_break_margin = 0;
 
   const auto new_b_tw =
-    std::find_if(b.tws.begin(), b.tws.end(), [&](const auto& tw) {
-      return earliest_job_end <= tw.end;
-    });
+    utils::earliest_available_tw(b.tws, earliest_job_end);
   if (new_b_tw == b.tws.end()) {
     // Break does not fit after job due to its time windows. Only
     // option is to choose break first.
@@ -427,9 +413,7 @@ OrderChoice TWRoute::order_choice(const Input& input,
   earliest_job_start += b.service + travel_after_break;
 
   const auto new_j_tw =
-    std::find_if(j.tws.begin(), j.tws.end(), [&](const auto& tw) {
-      return earliest_job_start <= tw.end;
-    });
+    utils::earliest_available_tw(j.tws, earliest_job_start);
   if (new_j_tw == j.tws.end()) {
     // Job does not fit after break due to its time windows. Only
     // option is to choose job first.
@@ -465,9 +449,7 @@ OrderChoice TWRoute::order_choice(const Input& input,
     }
     const Duration pb_d_candidate = job_then_break_end + delivery_travel;
     const auto pb_d_tw =
-      std::find_if(matching_d.tws.begin(),
-                   matching_d.tws.end(),
-                   [&](const auto& tw) { return pb_d_candidate <= tw.end; });
+      utils::earliest_available_tw(matching_d.tws, pb_d_candidate);
     if (pb_d_tw != matching_d.tws.end()) {
       // pickup -> break -> delivery is doable, choose pickup first.
       oc.add_job_first = true;
@@ -477,20 +459,15 @@ OrderChoice TWRoute::order_choice(const Input& input,
     // Previous order not doable, so try pickup -> delivery -> break.
     const Duration delivery_candidate =
       earliest_job_end + v.duration(j.index(), matching_d.index());
-    const auto d_tw = std::find_if(matching_d.tws.begin(),
-                                   matching_d.tws.end(),
-                                   [&](const auto& tw) {
-                                     return delivery_candidate <= tw.end;
-                                   });
+    const auto d_tw =
+      utils::earliest_available_tw(matching_d.tws, delivery_candidate);
 
     if (d_tw != matching_d.tws.end()) {
       const Duration break_candidate =
         std::max(delivery_candidate, d_tw->start) + matching_d.service;
 
       const auto after_d_b_tw =
-        std::find_if(b.tws.begin(), b.tws.end(), [&](const auto& tw) {
-          return break_candidate <= tw.end;
-        });
+        utils::earliest_available_tw(b.tws, break_candidate);
       if (after_d_b_tw != b.tws.end()) {
         // pickup -> delivery -> break is doable, choose pickup first.
         oc.add_job_first = true;
@@ -527,6 +504,10 @@ OrderChoice TWRoute::order_choice(const Input& input,
 bool TWRoute::is_valid_addition_for_tw(const Input& input,
                                        const Index job_rank,
                                        const Index rank) const {
+  if (!addition_fits_bounds(input, job_rank, job_rank, rank, rank)) {
+    return false;
+  }
+
   const auto& v = input.vehicles[vehicle_rank];
   const auto& j = input.jobs[job_rank];
 
@@ -538,6 +519,8 @@ bool TWRoute::is_valid_addition_for_tw(const Input& input,
   Duration next_start = next_latest_start(input, job_rank, rank, next_travel);
 
   bool job_added = false;
+  Duration job_earliest = 0;
+  unsigned breaks_before = 0;
 
   assert(breaks_at_rank[rank] <= breaks_counts[rank]);
 
@@ -545,19 +528,29 @@ bool TWRoute::is_valid_addition_for_tw(const Input& input,
   Index current_break = breaks_counts[rank] - breaks_at_rank[rank];
   const Index last_break = breaks_counts[rank];
 
+  if (current_break != last_break) {
+    // Adding a job in the slot can only delay the breaks in there,
+    // so their stored earliest dates bound the slot completion from
+    // below. Most infeasible candidates stop on this lookup without
+    // simulating break placement.
+    const auto& last_b = v.breaks[last_break - 1];
+    if (next_start < break_earliest[last_break - 1] + last_b.service) {
+      return false;
+    }
+  }
+
   while (!job_added or current_break != last_break) {
     if (current_break == last_break) {
       // Done with all breaks and job not added yet.
       current_earliest += previous_travel;
       const auto j_tw =
-        std::find_if(j.tws.begin(), j.tws.end(), [&](const auto& tw) {
-          return current_earliest <= tw.end;
-        });
+        utils::earliest_available_tw(j.tws, current_earliest);
       if (j_tw == j.tws.end()) {
         return false;
       }
 
-      current_earliest = std::max(current_earliest, j_tw->start) + j.service;
+      job_earliest = std::max(current_earliest, j_tw->start);
+      current_earliest = job_earliest + j.service;
       break;
     }
 
@@ -567,9 +560,7 @@ bool TWRoute::is_valid_addition_for_tw(const Input& input,
     if (job_added) {
       // Compute earliest end date for current break.
       const auto b_tw =
-        std::find_if(b.tws.begin(), b.tws.end(), [&](const auto& tw) {
-          return current_earliest <= tw.end;
-        });
+        utils::earliest_available_tw(b.tws, current_earliest);
 
       if (b_tw == b.tws.end()) {
         // Break does not fit due to its time windows.
@@ -624,17 +615,28 @@ bool TWRoute::is_valid_addition_for_tw(const Input& input,
 
       current_earliest += b.service;
 
+      ++breaks_before;
       ++current_break;
     }
     if (oc.add_job_first) {
-      current_earliest =
-        std::max(current_earliest + previous_travel, oc.j_tw->start) +
-        j.service;
+      job_earliest =
+        std::max(current_earliest + previous_travel, oc.j_tw->start);
+      current_earliest = job_earliest + j.service;
       job_added = true;
     }
   }
 
-  return current_earliest + next_travel <= next_start;
+  const bool valid = current_earliest + next_travel <= next_start;
+
+  if (valid and _recording_enabled and
+      _single_records.size() < MAX_SINGLE_RECORDS) {
+    // Record the insertion decision so a matching add call skips the
+    // simulation above.
+    _single_records.emplace(single_record_key(job_rank, rank),
+                            std::make_pair(breaks_before, job_earliest));
+  }
+
+  return valid;
 }
 
 template <class InputIterator>
@@ -646,6 +648,15 @@ bool TWRoute::is_valid_addition_for_tw(const Input& input,
   assert(first_job <= last_job);
   assert(first_rank <= last_rank);
 
+  if (first_job < last_job and
+      !addition_fits_bounds(input,
+                            *first_job,
+                            *(last_job - 1),
+                            first_rank,
+                            last_rank)) {
+    return false;
+  }
+
   const auto& v = input.vehicles[vehicle_rank];
 
   Duration previous_travel = 0;
@@ -668,24 +679,25 @@ bool TWRoute::is_valid_addition_for_tw(const Input& input,
     current_latest = v_end;
 
     if (first_rank > 0) {
-      const auto& previous_job = input.jobs[route[first_rank - 1]];
-      current_earliest = earliest[first_rank - 1] + previous_job.service;
+      current_earliest =
+        earliest[first_rank - 1] + action_times[first_rank - 1];
 
       if (last_rank < route.size()) {
         current_latest = latest[last_rank];
-        next_travel = v.duration(previous_job.index(),
-                                 input.jobs[route[last_rank]].index());
+        next_travel =
+          v.duration(job_indices[first_rank - 1], job_indices[last_rank]);
       } else {
         if (has_end) {
-          next_travel = v.duration(previous_job.index(), v.end.value().index());
+          next_travel =
+            v.duration(job_indices[first_rank - 1], v.end.value().index());
         }
       }
     } else {
       if (last_rank < route.size()) {
         current_latest = latest[last_rank];
         if (has_start) {
-          next_travel = v.duration(v.start.value().index(),
-                                   input.jobs[route[last_rank]].index());
+          next_travel =
+            v.duration(v.start.value().index(), job_indices[last_rank]);
         }
       } else {
         // Emptying the whole route is valid.
@@ -698,6 +710,30 @@ bool TWRoute::is_valid_addition_for_tw(const Input& input,
   Index current_break = breaks_counts[first_rank] - breaks_at_rank[first_rank];
   const Index last_break = breaks_counts[last_rank];
 
+  if (first_rank == last_rank and current_break != last_break) {
+    // Pure insertion: breaks in the slot can only be delayed by the
+    // added jobs, so their stored earliest dates bound the slot
+    // completion from below. Does not hold when jobs are removed as
+    // breaks may then shift earlier.
+    const auto& last_b = v.breaks[last_break - 1];
+    if (current_latest < break_earliest[last_break - 1] + last_b.service) {
+      return false;
+    }
+  }
+
+  // Record the simulated schedule along the way so a replace call
+  // committing this exact splice replays it, see SpliceRecord.
+  // Skipped while recording is off for this thread as concurrent
+  // evaluations share routes.
+  auto* record = _recording_enabled ? &_splice_record : nullptr;
+  if (record != nullptr) {
+    record->set = false;
+    record->first_rank = first_rank;
+    record->last_rank = last_rank;
+    record->jobs.assign(first_job, last_job);
+    record->events.clear();
+  }
+
   // Propagate earliest dates for all jobs and breaks in their
   // respective addition ranges.
   auto current_job = first_job;
@@ -707,17 +743,16 @@ bool TWRoute::is_valid_addition_for_tw(const Input& input,
       const auto& b = v.breaks[current_break];
 
       const auto b_tw =
-        std::find_if(b.tws.begin(), b.tws.end(), [&](const auto& tw) {
-          return current_earliest <= tw.end;
-        });
+        utils::earliest_available_tw(b.tws, current_earliest);
 
       if (b_tw == b.tws.end()) {
         // Break does not fit due to its time windows.
         return false;
       }
 
+      Duration margin = 0;
       if (current_earliest < b_tw->start) {
-        auto margin = b_tw->start - current_earliest;
+        margin = b_tw->start - current_earliest;
         if (margin < next_travel) {
           next_travel -= margin;
         } else {
@@ -726,6 +761,9 @@ bool TWRoute::is_valid_addition_for_tw(const Input& input,
 
         current_earliest = b_tw->start;
       }
+      if (record != nullptr) {
+        record->events.push_back({true, current_earliest, margin});
+      }
 
       current_earliest += b.service;
 
@@ -740,14 +778,16 @@ bool TWRoute::is_valid_addition_for_tw(const Input& input,
       current_earliest += previous_travel;
 
       const auto j_tw =
-        std::find_if(j.tws.begin(), j.tws.end(), [&](const auto& tw) {
-          return current_earliest <= tw.end;
-        });
+        utils::earliest_available_tw(j.tws, current_earliest);
       if (j_tw == j.tws.end()) {
         return false;
       }
 
-      current_earliest = std::max(current_earliest, j_tw->start) + j.service;
+      current_earliest = std::max(current_earliest, j_tw->start);
+      if (record != nullptr) {
+        record->events.push_back({false, current_earliest, 0});
+      }
+      current_earliest += j.service;
 
       ++current_job;
       if (current_job != last_job) {
@@ -780,8 +820,9 @@ bool TWRoute::is_valid_addition_for_tw(const Input& input,
     // time with given insertion choice.
     assert(oc.add_job_first xor oc.add_break_first);
     if (oc.add_break_first) {
+      Duration margin = 0;
       if (current_earliest < oc.b_tw->start) {
-        auto margin = oc.b_tw->start - current_earliest;
+        margin = oc.b_tw->start - current_earliest;
         if (margin < previous_travel) {
           previous_travel -= margin;
         } else {
@@ -790,6 +831,9 @@ bool TWRoute::is_valid_addition_for_tw(const Input& input,
 
         current_earliest = oc.b_tw->start;
       }
+      if (record != nullptr) {
+        record->events.push_back({true, current_earliest, margin});
+      }
 
       current_earliest += b.service;
 
@@ -797,8 +841,11 @@ bool TWRoute::is_valid_addition_for_tw(const Input& input,
     }
     if (oc.add_job_first) {
       current_earliest =
-        std::max(current_earliest + previous_travel, oc.j_tw->start) +
-        j.service;
+        std::max(current_earliest + previous_travel, oc.j_tw->start);
+      if (record != nullptr) {
+        record->events.push_back({false, current_earliest, 0});
+      }
+      current_earliest += j.service;
 
       ++current_job;
       if (current_job != last_job) {
@@ -809,7 +856,15 @@ bool TWRoute::is_valid_addition_for_tw(const Input& input,
     }
   }
 
-  return current_earliest + next_travel <= current_latest;
+  const bool valid = current_earliest + next_travel <= current_latest;
+
+  if (valid and record != nullptr) {
+    record->final_earliest = current_earliest;
+    record->final_next_travel = next_travel;
+    record->set = true;
+  }
+
+  return valid;
 }
 
 void TWRoute::add(const Input& input, const Index job_rank, const Index rank) {
@@ -831,7 +886,17 @@ void TWRoute::add(const Input& input, const Index job_rank, const Index rank) {
 
   assert(breaks_at_rank[rank] <= breaks_counts[rank]);
 
-  for (Index r = 0; r < breaks_at_rank[rank]; ++r) {
+  const auto record = _single_records.find(single_record_key(job_rank, rank));
+  if (record != _single_records.end()) {
+    // This exact insertion passed a validity check since the last
+    // route modification, so replay the recorded decision instead of
+    // redoing the break ordering simulation.
+    breaks_before = record->second.first;
+    earliest.insert(earliest.begin() + rank, record->second.second);
+    job_added = true;
+  }
+
+  for (Index r = 0; !job_added and r < breaks_at_rank[rank]; ++r) {
     Index break_rank = (breaks_counts[rank] + r) - breaks_at_rank[rank];
     const auto& b = v.breaks[break_rank];
 
@@ -879,9 +944,7 @@ void TWRoute::add(const Input& input, const Index job_rank, const Index rank) {
   if (!job_added) {
     current_earliest += previous_travel;
     const auto j_tw =
-      std::find_if(j.tws.begin(), j.tws.end(), [&](const auto& tw) {
-        return current_earliest <= tw.end;
-      });
+      utils::earliest_available_tw(j.tws, current_earliest);
     assert(j_tw != j.tws.end());
 
     current_earliest = std::max(current_earliest, j_tw->start);
@@ -907,9 +970,7 @@ void TWRoute::add(const Input& input, const Index job_rank, const Index rank) {
     current_latest -= b.service;
 
     const auto b_tw =
-      std::find_if(b.tws.rbegin(), b.tws.rend(), [&](const auto& tw) {
-        return tw.start <= current_latest;
-      });
+      utils::latest_available_tw(b.tws, current_latest);
     assert(b_tw != b.tws.rend());
 
     if (b_tw->end < current_latest) {
@@ -934,9 +995,7 @@ void TWRoute::add(const Input& input, const Index job_rank, const Index rank) {
   current_latest -= (j.service + next_travel);
 
   const auto j_tw =
-    std::find_if(j.tws.rbegin(), j.tws.rend(), [&](const auto& tw) {
-      return tw.start <= current_latest;
-    });
+    utils::latest_available_tw(j.tws, current_latest);
   assert(j_tw != j.tws.rend());
 
   current_latest = std::min(current_latest, j_tw->end);
@@ -947,11 +1006,15 @@ void TWRoute::add(const Input& input, const Index job_rank, const Index rank) {
   // before addition ; but before earliest/latest date propagation
   // that rely on route structure after addition.
   route.insert(route.begin() + rank, job_rank);
+  job_indices.insert(job_indices.begin() + rank, j.index());
+  action_times.insert(action_times.begin() + rank, j.service);
 
   fwd_update_earliest_from(input, rank);
   bwd_update_latest_from(input, rank);
 
   update_amounts(input);
+
+  clear_records();
 }
 
 bool TWRoute::is_valid_removal(const Input& input,
@@ -1006,24 +1069,25 @@ void TWRoute::replace(const Input& input,
     current_latest = v_end;
 
     if (first_rank > 0) {
-      const auto& previous_job = input.jobs[route[first_rank - 1]];
-      current_earliest = earliest[first_rank - 1] + previous_job.service;
+      current_earliest =
+        earliest[first_rank - 1] + action_times[first_rank - 1];
 
       if (last_rank < route.size()) {
         current_latest = latest[last_rank];
-        next_travel = v.duration(previous_job.index(),
-                                 input.jobs[route[last_rank]].index());
+        next_travel =
+          v.duration(job_indices[first_rank - 1], job_indices[last_rank]);
       } else {
         if (has_end) {
-          next_travel = v.duration(previous_job.index(), v.end.value().index());
+          next_travel =
+            v.duration(job_indices[first_rank - 1], v.end.value().index());
         }
       }
     } else {
       if (last_rank < route.size()) {
         current_latest = latest[last_rank];
         if (has_start) {
-          next_travel = v.duration(v.start.value().index(),
-                                   input.jobs[route[last_rank]].index());
+          next_travel =
+            v.duration(v.start.value().index(), job_indices[last_rank]);
         }
       }
     }
@@ -1051,6 +1115,10 @@ void TWRoute::replace(const Input& input,
     auto to_erase = erase_count - add_count;
     route.erase(route.begin() + first_rank,
                 route.begin() + first_rank + to_erase);
+    job_indices.erase(job_indices.begin() + first_rank,
+                      job_indices.begin() + first_rank + to_erase);
+    action_times.erase(action_times.begin() + first_rank,
+                       action_times.begin() + first_rank + to_erase);
     earliest.erase(earliest.begin() + first_rank,
                    earliest.begin() + first_rank + to_erase);
     latest.erase(latest.begin() + first_rank,
@@ -1076,6 +1144,8 @@ void TWRoute::replace(const Input& input,
 
     auto to_insert = add_count - erase_count;
     route.insert(route.begin() + first_rank, to_insert, 0);
+    job_indices.insert(job_indices.begin() + first_rank, to_insert, 0);
+    action_times.insert(action_times.begin() + first_rank, to_insert, 0);
     earliest.insert(earliest.begin() + first_rank, to_insert, 0);
     latest.insert(latest.begin() + first_rank, to_insert, 0);
     breaks_at_rank.insert(breaks_at_rank.begin() + first_rank, to_insert, 0);
@@ -1089,15 +1159,51 @@ void TWRoute::replace(const Input& input,
   // Propagate earliest dates for all jobs and breaks in their
   // respective addition ranges.
   auto current_job = first_job;
+
+  if (_splice_record.set and _splice_record.first_rank == first_rank and
+      _splice_record.last_rank == last_rank and
+      _splice_record.jobs.size() == add_count and
+      std::equal(_splice_record.jobs.begin(),
+                 _splice_record.jobs.end(),
+                 first_job)) {
+    // This exact splice passed a validity check since the last route
+    // modification, so replay the recorded schedule instead of
+    // rerunning order choices and time window scans.
+    for (const auto& event : _splice_record.events) {
+      if (event.is_break) {
+        breaks_travel_margin_before[current_break] = event.margin_before;
+        break_earliest[current_break] = event.earliest;
+        ++breaks_before;
+        ++current_break;
+      } else {
+        const auto& j = input.jobs[*current_job];
+        route[current_job_rank] = *current_job;
+        job_indices[current_job_rank] = j.index();
+        action_times[current_job_rank] = j.service;
+        earliest[current_job_rank] = event.earliest;
+        breaks_at_rank[current_job_rank] = breaks_before;
+        breaks_counts[current_job_rank] =
+          previous_breaks_counts + breaks_before;
+        ++current_job_rank;
+        previous_breaks_counts += breaks_before;
+        breaks_before = 0;
+        ++current_job;
+      }
+    }
+    assert(current_job == last_job);
+
+    current_earliest = _splice_record.final_earliest;
+    next_travel = _splice_record.final_next_travel;
+    current_break = last_break;
+  }
+
   while (current_job != last_job or current_break != last_break) {
     if (current_job == last_job) {
       // Compute earliest end date for break after last inserted jobs.
       const auto& b = v.breaks[current_break];
 
       const auto b_tw =
-        std::find_if(b.tws.begin(), b.tws.end(), [&](const auto& tw) {
-          return current_earliest <= tw.end;
-        });
+        utils::earliest_available_tw(b.tws, current_earliest);
       assert(b_tw != b.tws.end());
 
       if (current_earliest < b_tw->start) {
@@ -1129,14 +1235,14 @@ void TWRoute::replace(const Input& input,
       current_earliest += previous_travel;
 
       const auto j_tw =
-        std::find_if(j.tws.begin(), j.tws.end(), [&](const auto& tw) {
-          return current_earliest <= tw.end;
-        });
+        utils::earliest_available_tw(j.tws, current_earliest);
       assert(j_tw != j.tws.end());
 
       current_earliest = std::max(current_earliest, j_tw->start);
 
       route[current_job_rank] = *current_job;
+      job_indices[current_job_rank] = j.index();
+      action_times[current_job_rank] = j.service;
       earliest[current_job_rank] = current_earliest;
       breaks_at_rank[current_job_rank] = breaks_before;
       breaks_counts[current_job_rank] = previous_breaks_counts + breaks_before;
@@ -1194,6 +1300,8 @@ void TWRoute::replace(const Input& input,
         std::max(current_earliest + previous_travel, oc.j_tw->start);
 
       route[current_job_rank] = *current_job;
+      job_indices[current_job_rank] = j.index();
+      action_times[current_job_rank] = j.service;
       earliest[current_job_rank] = current_earliest;
       breaks_at_rank[current_job_rank] = breaks_before;
       breaks_counts[current_job_rank] = previous_breaks_counts + breaks_before;
@@ -1227,9 +1335,7 @@ void TWRoute::replace(const Input& input,
 
       current_earliest += next_travel;
       const auto j_tw =
-        std::find_if(j.tws.begin(), j.tws.end(), [&](const auto& tw) {
-          return current_earliest <= tw.end;
-        });
+        utils::earliest_available_tw(j.tws, current_earliest);
       assert(j_tw != j.tws.end());
 
       earliest[0] = std::max(current_earliest, j_tw->start);
@@ -1258,9 +1364,7 @@ void TWRoute::replace(const Input& input,
           current_latest -= b.service;
 
           const auto b_tw =
-            std::find_if(b.tws.rbegin(), b.tws.rend(), [&](const auto& tw) {
-              return tw.start <= current_latest;
-            });
+            utils::latest_available_tw(b.tws, current_latest);
           assert(b_tw != b.tws.rend());
 
           if (b_tw->end < current_latest) {
@@ -1287,9 +1391,7 @@ void TWRoute::replace(const Input& input,
         current_latest -= gap;
 
         const auto j_tw =
-          std::find_if(j.tws.rbegin(), j.tws.rend(), [&](const auto& tw) {
-            return tw.start <= current_latest;
-          });
+          utils::latest_available_tw(j.tws, current_latest);
         assert(j_tw != j.tws.rend());
 
         latest.back() = std::min(current_latest, j_tw->end);
@@ -1305,6 +1407,8 @@ void TWRoute::replace(const Input& input,
   }
 
   update_amounts(input);
+
+  clear_records();
 }
 
 template bool
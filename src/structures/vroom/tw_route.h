@@ -10,6 +10,9 @@ All rights reserved (see LICENSE).
 
 */
 
+#include <algorithm>
+#include <unordered_map>
+
 #include "structures/typedefs.h"
 #include "structures/vroom/input/input.h"
 #include "structures/vroom/raw_route.h"
@@ -49,6 +52,115 @@ private:
   void fwd_update_earliest_from(const Input& input, Index rank);
   void bwd_update_latest_from(const Input& input, Index rank);
 
+  // Per-rank caches for matrix index and action (service) time of
+  // jobs in route, kept in sync with route content. Earliest/latest
+  // date propagation only requires those scalar values so storing
+  // them contiguously avoids fetching whole Job objects from
+  // scattered memory in the propagation loops.
+  std::vector<Index> job_indices;
+  std::vector<Duration> action_times;
+
+  // break_service_sums[i] is the total service time for vehicle
+  // breaks at ranks below i, fixed at construction. Lets candidate
+  // checks account for the time the breaks in an insertion slot are
+  // bound to consume without iterating on them.
+  std::vector<Duration> break_service_sums;
+
+  // Total service time for breaks due between positions first_rank
+  // and last_rank in route.
+  Duration break_services_between(const Index first_rank,
+                                  const Index last_rank) const {
+    return break_service_sums[breaks_counts[last_rank]] -
+           break_service_sums[breaks_counts[first_rank] -
+                              breaks_at_rank[first_rank]];
+  }
+
+  // O(1) necessary condition for inclusion of jobs in place of ranks
+  // [first_rank, last_rank), derived from stored earliest/latest
+  // dates while ignoring travel times and break waiting times (both
+  // can only make the insertion worse). Break service times in the
+  // replaced range do count as they have to fit in the same slack.
+  // On tight-TW instances this rules out most candidates without
+  // running the full insertion simulation.
+  bool addition_fits_bounds(const Input& input,
+                            const Index first_job_rank,
+                            const Index last_job_rank,
+                            const Index first_rank,
+                            const Index last_rank) const {
+    const Duration earliest_start =
+      (first_rank > 0) ? earliest[first_rank - 1] + action_times[first_rank - 1]
+                       : v_start;
+    const Duration latest_next =
+      (last_rank < route.size()) ? latest[last_rank] : v_end;
+
+    // First inserted job can't start before earliest_start, last
+    // inserted job has to be done in time for next step.
+    const auto& first_j = input.jobs[first_job_rank];
+    if (first_j.tws.back().end < earliest_start) {
+      return false;
+    }
+
+    const auto& last_j = input.jobs[last_job_rank];
+    return std::max(earliest_start, last_j.tws.front().start) +
+             last_j.service + break_services_between(first_rank, last_rank) <=
+           latest_next;
+  }
+
+  // Validity checks simulate the exact timing data a matching commit
+  // then recomputes, so successful checks record their outcome and
+  // add/replace replay it when handed the very same change instead
+  // of redoing the simulation. Any route modification invalidates
+  // all records, so stale replays are impossible.
+
+  // Single-job insertions that passed the check, keyed by packed
+  // job_rank and rank: number of slot breaks scheduled before the
+  // job, and the job earliest date. Covers the
+  // check-all-candidates-then-add-the-best pattern of the insertion
+  // heuristics, where the winning candidate is always on record.
+  static constexpr std::size_t MAX_SINGLE_RECORDS = 4096;
+  mutable std::unordered_map<uint64_t, std::pair<unsigned, Duration>>
+    _single_records;
+
+  static uint64_t single_record_key(const Index job_rank, const Index rank) {
+    return (static_cast<uint64_t>(job_rank) << 32) |
+           static_cast<uint64_t>(rank);
+  }
+
+  // Simulation outcome of the latest successful range check: one
+  // event per splice step in schedule order, holding the computed
+  // earliest date (and travel margin for break steps), plus the
+  // loop exit state. A replace call matching the recorded splice
+  // replays the events instead of rerunning order choices and time
+  // window scans.
+  struct SpliceRecord {
+    bool set = false;
+    Index first_rank;
+    Index last_rank;
+    std::vector<Index> jobs;
+
+    struct Event {
+      bool is_break;
+      Duration earliest;
+      Duration margin_before; // Break steps only.
+    };
+    std::vector<Event> events;
+
+    Duration final_earliest;
+    Duration final_next_travel;
+  };
+  mutable SpliceRecord _splice_record;
+
+  // Whether validity checks running on the current thread may write
+  // the above records. Parallel local search evaluations share
+  // target routes across threads, so their checks must leave routes
+  // untouched; see ScopedRecordingOff.
+  static thread_local bool _recording_enabled;
+
+  void clear_records() {
+    _single_records.clear();
+    _splice_record.set = false;
+  }
+
   // Define global policy wrt job/break respective insertion rule.
   OrderChoice order_choice(const Input& input,
                            Index job_rank,
@@ -59,6 +171,18 @@ private:
                            const Duration next_start) const;
 
 public:
+  // Disables validity-check record writes on the current thread for
+  // its own lifetime. Scoped around concurrent evaluations so const
+  // checks on shared routes stay free of side effects.
+  struct ScopedRecordingOff {
+    ScopedRecordingOff() {
+      _recording_enabled = false;
+    }
+    ~ScopedRecordingOff() {
+      _recording_enabled = true;
+    }
+  };
+
   Duration v_start;
   Duration v_end;
 
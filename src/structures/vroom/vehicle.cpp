@@ -20,7 +20,7 @@ Vehicle::Vehicle(Id id,
                  const Skills& skills,
                  const TimeWindow& tw,
                  const std::vector<Break>& breaks,
-                 const std::string& description,
+                 std::string_view description,
                  double speed_factor,
                  const std::vector<VehicleStep>& input_steps)
   : id(id),
@@ -110,4 +110,31 @@ bool Vehicle::has_same_profile(const Vehicle& other) const {
           other.cost_wrapper.durations_factor);
 }
 
+bool Vehicle::is_interchangeable_with(const Vehicle& other) const {
+  if (!this->has_same_profile(other) or
+      !this->has_same_locations(other) or
+      !(this->capacity == other.capacity) or this->skills != other.skills or
+      this->tw.start != other.tw.start or this->tw.end != other.tw.end or
+      !this->steps.empty() or !other.steps.empty() or
+      this->breaks.size() != other.breaks.size()) {
+    return false;
+  }
+
+  for (std::size_t i = 0; i < breaks.size(); ++i) {
+    const auto& b = this->breaks[i];
+    const auto& other_b = other.breaks[i];
+    if (b.service != other_b.service or b.tws.size() != other_b.tws.size()) {
+      return false;
+    }
+    for (std::size_t t = 0; t < b.tws.size(); ++t) {
+      if (b.tws[t].start != other_b.tws[t].start or
+          b.tws[t].end != other_b.tws[t].end) {
+        return false;
+      }
+    }
+  }
+
+  return true;
+}
+
 } // namespace vroom
@@ -11,6 +11,7 @@ All rights reserved (see LICENSE).
 */
 
 #include <string>
+#include <string_view>
 #include <unordered_map>
 
 #include "structures/typedefs.h"
@@ -32,7 +33,9 @@ struct Vehicle {
   const Skills skills;
   const TimeWindow tw;
   const std::vector<Break> breaks;
-  const std::string description;
+  // Non-owning view into the input buffer, which outlives the
+  // problem instance, see io::parse.
+  const std::string_view description;
   CostWrapper cost_wrapper;
   std::vector<VehicleStep> steps;
   std::unordered_map<Id, Index> break_id_to_rank;
@@ -46,7 +49,7 @@ struct Vehicle {
     const Skills& skills = Skills(),
     const TimeWindow& tw = TimeWindow(),
     const std::vector<Break>& breaks = std::vector<Break>(),
-    const std::string& description = "",
+    std::string_view description = "",
     double speed_factor = 1.,
     const std::vector<VehicleStep>& input_steps = std::vector<VehicleStep>());
 
@@ -58,16 +61,19 @@ struct Vehicle {
 
   bool has_same_profile(const Vehicle& other) const;
 
+  // Whether swapping this vehicle with other can never change a
+  // solution cost or feasibility, i.e. all solving-relevant fields
+  // match and neither vehicle carries input steps.
+  bool is_interchangeable_with(const Vehicle& other) const;
+
   Cost duration(Index i, Index j) const {
-    return static_cast<Cost>(
-      cost_wrapper.durations_factor *
-      static_cast<double>((*(cost_wrapper.durations_matrix))[i][j]));
+    return static_cast<Cost>(cost_wrapper.durations_factor *
+                             static_cast<double>(cost_wrapper.duration(i, j)));
   }
 
   Cost cost(Index i, Index j) const {
-    return static_cast<Cost>(
-      cost_wrapper.durations_factor *
-      static_cast<double>((*(cost_wrapper.durations_matrix))[i][j]));
+    return static_cast<Cost>(cost_wrapper.durations_factor *
+                             static_cast<double>(cost_wrapper.duration(i, j)));
   }
 };
 
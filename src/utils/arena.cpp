@@ -0,0 +1,53 @@
+/*
+
+This file is part of VROOM.
+
+Copyright (c) 2015-2021, Julien Coupey.
+All rights reserved (see LICENSE).
+
+*/
+
+#include <algorithm>
+#include <cassert>
+
+#include "utils/arena.h"
+
+namespace vroom {
+namespace utils {
+
+ScratchArena::ScratchArena() : _current(0), _offset(0) {
+  _chunks.push_back(
+    {std::make_unique<char[]>(first_chunk_size), first_chunk_size});
+}
+
+void* ScratchArena::do_allocate(std::size_t bytes, std::size_t alignment) {
+  // Chunks come from operator new[], aligned for any fundamental
+  // type.
+  assert(alignment <= alignof(std::max_align_t));
+
+  while (true) {
+    const auto& chunk = _chunks[_current];
+    const std::size_t aligned = (_offset + alignment - 1) & ~(alignment - 1);
+
+    if (aligned + bytes <= chunk.size) {
+      _offset = aligned + bytes;
+      return chunk.data.get() + aligned;
+    }
+
+    if (_current + 1 == _chunks.size()) {
+      const std::size_t next_size =
+        std::max(2 * _chunks.back().size, bytes + alignment);
+      _chunks.push_back({std::make_unique<char[]>(next_size), next_size});
+    }
+    ++_current;
+    _offset = 0;
+  }
+}
+
+ScratchArena& thread_arena() {
+  static thread_local ScratchArena arena;
+  return arena;
+}
+
+} // namespace utils
+} // namespace vroom
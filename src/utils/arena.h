@@ -0,0 +1,93 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+/*
+
+This file is part of VROOM.
+
+Copyright (c) 2015-2021, Julien Coupey.
+All rights reserved (see LICENSE).
+
+*/
+
+#include <memory>
+#include <memory_resource>
+#include <vector>
+
+namespace vroom {
+namespace utils {
+
+// Monotonic bump arena backing short-lived containers on hot search
+// paths. Allocation just advances a cursor inside reusable chunks
+// and deallocation is a no-op: memory is reclaimed wholesale when an
+// ArenaScope unwinds back to its watermark. Chunks are kept around
+// between scopes, so steady-state evaluation does not touch the
+// global heap at all. Each thread uses its own arena (see
+// thread_arena), keeping solving threads from contending on malloc.
+class ScratchArena : public std::pmr::memory_resource {
+  struct Chunk {
+    std::unique_ptr<char[]> data;
+    std::size_t size;
+  };
+
+  // Chunk sizes grow geometrically from the first one.
+  static constexpr std::size_t first_chunk_size = 1 << 16;
+
+  std::vector<Chunk> _chunks;
+  // Bump position as rank of current chunk and used bytes within.
+  std::size_t _current;
+  std::size_t _offset;
+
+protected:
+  void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+
+  void do_deallocate(void*, std::size_t, std::size_t) override {
+    // Memory is reclaimed by ArenaScope unwinding.
+  }
+
+  bool do_is_equal(
+    const std::pmr::memory_resource& other) const noexcept override {
+    return this == &other;
+  }
+
+public:
+  ScratchArena();
+
+  struct Watermark {
+    std::size_t chunk;
+    std::size_t offset;
+  };
+
+  Watermark mark() const {
+    return {_current, _offset};
+  }
+
+  void rewind(const Watermark& watermark) {
+    _current = watermark.chunk;
+    _offset = watermark.offset;
+  }
+};
+
+// Arena for current thread, created on first use.
+ScratchArena& thread_arena();
+
+// Guard rolling the thread arena back to where it stood on creation,
+// releasing in one go everything allocated in between. Scopes have
+// to be strictly nested, which block scoping guarantees.
+class ArenaScope {
+  ScratchArena& _arena;
+  const ScratchArena::Watermark _mark;
+
+public:
+  ArenaScope() : _arena(thread_arena()), _mark(_arena.mark()) {
+  }
+
+  ~ArenaScope() {
+    _arena.rewind(_mark);
+  }
+};
+
+} // namespace utils
+} // namespace vroom
+
+#endif
@@ -0,0 +1,163 @@
+/*
+
+This file is part of VROOM.
+
+Copyright (c) 2015-2021, Julien Coupey.
+All rights reserved (see LICENSE).
+
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "structures/cl_args.h"
+#include "utils/auto_tune.h"
+
+namespace vroom {
+namespace utils {
+
+namespace {
+
+struct HistoryRecord {
+  InstanceFeatures features;
+  unsigned exploration_level;
+  unsigned nb_threads;
+  unsigned long solving_ms;
+  Cost cost;
+};
+
+std::string history_file() {
+  const char* path = std::getenv("VROOM_TUNER_HISTORY");
+  return (path == nullptr) ? "" : std::string(path);
+}
+
+// History records are plain space-separated lines, one per solve.
+// Unparsable lines (e.g. from a mixed-version file) are skipped as
+// the history is best-effort only.
+std::vector<HistoryRecord> load_history(const std::string& path) {
+  std::vector<HistoryRecord> records;
+
+  std::ifstream in(path);
+  HistoryRecord r;
+  while (in >> r.features.nb_jobs >> r.features.nb_vehicles >>
+         r.features.amount_size >> r.features.tw_share >>
+         r.exploration_level >> r.nb_threads >> r.solving_ms >> r.cost) {
+    records.push_back(r);
+  }
+
+  return records;
+}
+
+// Whether a recorded instance is close enough in shape to transfer
+// its timings: sizes within a factor of two, same amount dimensions
+// and comparable time window tightness.
+bool comparable(const InstanceFeatures& a, const InstanceFeatures& b) {
+  return 2 * a.nb_jobs >= b.nb_jobs and a.nb_jobs <= 2 * b.nb_jobs and
+         2 * a.nb_vehicles >= b.nb_vehicles and
+         a.nb_vehicles <= 2 * b.nb_vehicles and
+         a.amount_size == b.amount_size and
+         std::abs(a.tw_share - b.tw_share) <= 0.25;
+}
+
+} // namespace
+
+InstanceFeatures instance_features(const Input& input) {
+  std::size_t nb_constrained = 0;
+  for (const auto& job : input.jobs) {
+    if (job.tws.size() > 1 or !job.tws.front().is_default()) {
+      ++nb_constrained;
+    }
+  }
+
+  return {input.jobs.size(),
+          input.vehicles.size(),
+          static_cast<unsigned>(input.zero_amount().size()),
+          input.jobs.empty()
+            ? 0.
+            : static_cast<double>(nb_constrained) / input.jobs.size()};
+}
+
+unsigned predict_exploration_level(const InstanceFeatures& features,
+                                   unsigned long deadline_ms,
+                                   unsigned fallback) {
+  const auto path = history_file();
+  if (path.empty()) {
+    return fallback;
+  }
+
+  // Per-level solving time predictions, scaled linearly with the job
+  // count ratio to account for size differences within the
+  // comparable range.
+  const unsigned max_level = io::CLArgs::max_exploration_level;
+  std::vector<std::vector<double>> scaled_times(max_level + 1);
+  for (const auto& r : load_history(path)) {
+    if (r.exploration_level <= max_level and
+        r.features.nb_jobs > 0 and comparable(features, r.features)) {
+      const double ratio = static_cast<double>(features.nb_jobs) /
+                           static_cast<double>(r.features.nb_jobs);
+      scaled_times[r.exploration_level].push_back(ratio * r.solving_ms);
+    }
+  }
+
+  // Pick the highest level whose median predicted time fits the
+  // deadline. Levels without history are skipped so the prediction
+  // never extrapolates beyond what has actually been observed.
+  bool any_history = false;
+  bool any_fit = false;
+  unsigned lowest_observed = 0;
+  unsigned best_level = 0;
+  for (unsigned level = 0; level <= max_level; ++level) {
+    auto& times = scaled_times[level];
+    if (times.empty()) {
+      continue;
+    }
+    if (!any_history) {
+      lowest_observed = level;
+    }
+    any_history = true;
+    std::nth_element(times.begin(),
+                     times.begin() + times.size() / 2,
+                     times.end());
+    if (times[times.size() / 2] <= static_cast<double>(deadline_ms)) {
+      best_level = level;
+      any_fit = true;
+    }
+  }
+
+  if (!any_history) {
+    return fallback;
+  }
+  if (!any_fit) {
+    // Even the cheapest observed level is expected to miss the
+    // deadline, so at least pick the one closest to it.
+    return lowest_observed;
+  }
+
+  return best_level;
+}
+
+void record_solve_history(const InstanceFeatures& features,
+                          unsigned exploration_level,
+                          unsigned nb_threads,
+                          unsigned long solving_ms,
+                          Cost cost) {
+  const auto path = history_file();
+  if (path.empty()) {
+    return;
+  }
+
+  // Failures (e.g. history file not writable) are silently ignored
+  // as the tuner is best-effort only.
+  std::ofstream out(path, std::ios::app);
+  out << features.nb_jobs << ' ' << features.nb_vehicles << ' '
+      << features.amount_size << ' ' << features.tw_share << ' '
+      << exploration_level << ' ' << nb_threads << ' ' << solving_ms << ' '
+      << cost << '\n';
+}
+
+} // namespace utils
+} // namespace vroom
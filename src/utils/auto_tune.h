@@ -0,0 +1,55 @@
+#ifndef AUTO_TUNE_H
+#define AUTO_TUNE_H
+
+/*
+
+This file is part of VROOM.
+
+Copyright (c) 2015-2021, Julien Coupey.
+All rights reserved (see LICENSE).
+
+*/
+
+#include "structures/typedefs.h"
+#include "structures/vroom/input/input.h"
+
+namespace vroom {
+namespace utils {
+
+// Quality/time auto-tuner for the exploration level, enabled
+// whenever the VROOM_TUNER_HISTORY environment variable points to a
+// writable file. Every solve appends its instance shape and outcome
+// there, and -x auto:<deadline> picks the highest exploration level
+// whose predicted solving time fits the deadline, based on recorded
+// solves of comparable shape. Like the matrix cache this is
+// best-effort only: without usable history the default level is
+// kept.
+
+// Instance shape used to match history records.
+struct InstanceFeatures {
+  std::size_t nb_jobs;
+  std::size_t nb_vehicles;
+  unsigned amount_size;
+  // Share of jobs with a non-default time window.
+  double tw_share;
+};
+
+InstanceFeatures instance_features(const Input& input);
+
+// Highest exploration level expected to solve an instance with those
+// features within deadline_ms, or fallback without usable history.
+unsigned predict_exploration_level(const InstanceFeatures& features,
+                                   unsigned long deadline_ms,
+                                   unsigned fallback);
+
+// Append the observed outcome of a solve to the history file.
+void record_solve_history(const InstanceFeatures& features,
+                          unsigned exploration_level,
+                          unsigned nb_threads,
+                          unsigned long solving_ms,
+                          Cost cost);
+
+} // namespace utils
+} // namespace vroom
+
+#endif
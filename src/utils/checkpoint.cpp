@@ -0,0 +1,129 @@
+/*
+
+This file is part of VROOM.
+
+Copyright (c) 2015-2021, Julien Coupey.
+All rights reserved (see LICENSE).
+
+*/
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <unordered_map>
+
+#include "../include/rapidjson/document.h"
+#include "../include/rapidjson/stringbuffer.h"
+#include "../include/rapidjson/writer.h"
+
+#include "utils/checkpoint.h"
+
+namespace vroom {
+namespace utils {
+
+void write_checkpoint(
+  const std::string& file,
+  const std::vector<std::pair<Id, std::vector<Id>>>& routes) {
+  rapidjson::StringBuffer s;
+  rapidjson::Writer<rapidjson::StringBuffer> r(s);
+
+  r.StartObject();
+  r.Key("routes");
+  r.StartObject();
+  for (const auto& [vehicle_id, job_ids] : routes) {
+    r.Key(std::to_string(vehicle_id).c_str());
+    r.StartArray();
+    for (const auto job_id : job_ids) {
+      r.Uint64(job_id);
+    }
+    r.EndArray();
+  }
+  r.EndObject();
+  r.EndObject();
+
+  // Write to a temporary name then rename so a crash mid-write never
+  // leaves a truncated checkpoint behind. Failures are silently
+  // ignored as checkpoints are best-effort only.
+  const std::string tmp_file = file + ".tmp";
+  {
+    std::ofstream out(tmp_file, std::ios::trunc);
+    if (!out) {
+      return;
+    }
+    out.write(s.GetString(), s.GetSize());
+    if (!out) {
+      return;
+    }
+  }
+  std::rename(tmp_file.c_str(), file.c_str());
+}
+
+bool load_checkpoint(const std::string& file, Input& input) {
+  std::ifstream in(file);
+  if (!in) {
+    return false;
+  }
+  std::stringstream buffer;
+  buffer << in.rdbuf();
+  const std::string content = buffer.str();
+
+  rapidjson::Document json_checkpoint;
+  if (json_checkpoint.Parse(content.c_str()).HasParseError() or
+      !json_checkpoint.IsObject() or !json_checkpoint.HasMember("routes") or
+      !json_checkpoint["routes"].IsObject()) {
+    return false;
+  }
+
+  std::unordered_map<Id, Index> vehicle_id_to_rank;
+  for (Index v = 0; v < input.vehicles.size(); ++v) {
+    vehicle_id_to_rank.emplace(input.vehicles[v].id, v);
+  }
+
+  // Resolve all ids before touching input so a checkpoint written
+  // for another problem is discarded as a whole.
+  std::unordered_map<Index, std::vector<VehicleStep>> steps_per_vehicle;
+  for (const auto& route : json_checkpoint["routes"].GetObject()) {
+    Id vehicle_id;
+    try {
+      vehicle_id = std::stoull(route.name.GetString());
+    } catch (const std::exception&) {
+      return false;
+    }
+    const auto vehicle = vehicle_id_to_rank.find(vehicle_id);
+    if (vehicle == vehicle_id_to_rank.end() or !route.value.IsArray() or
+        !input.vehicles[vehicle->second].steps.empty()) {
+      return false;
+    }
+
+    auto& steps = steps_per_vehicle[vehicle->second];
+    for (rapidjson::SizeType i = 0; i < route.value.Size(); ++i) {
+      if (!route.value[i].IsUint64()) {
+        return false;
+      }
+      const Id job_id = route.value[i].GetUint64();
+      if (input.job_id_to_rank.find(job_id) != input.job_id_to_rank.end()) {
+        steps.emplace_back(JOB_TYPE::SINGLE, job_id, ForcedService());
+      } else if (input.pickup_id_to_rank.find(job_id) !=
+                 input.pickup_id_to_rank.end()) {
+        steps.emplace_back(JOB_TYPE::PICKUP, job_id, ForcedService());
+      } else if (input.delivery_id_to_rank.find(job_id) !=
+                 input.delivery_id_to_rank.end()) {
+        steps.emplace_back(JOB_TYPE::DELIVERY, job_id, ForcedService());
+      } else {
+        return false;
+      }
+    }
+  }
+
+  if (steps_per_vehicle.empty()) {
+    return false;
+  }
+
+  for (auto& [rank, steps] : steps_per_vehicle) {
+    input.vehicles[rank].steps = std::move(steps);
+  }
+  return true;
+}
+
+} // namespace utils
+} // namespace vroom
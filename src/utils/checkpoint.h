@@ -0,0 +1,66 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+/*
+
+This file is part of VROOM.
+
+Copyright (c) 2015-2021, Julien Coupey.
+All rights reserved (see LICENSE).
+
+*/
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "structures/vroom/input/input.h"
+
+namespace vroom {
+namespace utils {
+
+// Periodic on-disk checkpoints of the best known solution during long
+// solves, see Input::set_checkpoint. A checkpoint holds assigned job
+// ids per vehicle id, so it survives restarts and is loaded back as
+// vehicle steps seeding the heuristic pool. Search positions beyond
+// the best known solution (per-thread descents, ruin state) are
+// deliberately not stored: they are cheap to rebuild from a good
+// seed.
+
+// Store job ids per vehicle id in file. The file is written to a
+// temporary name then renamed so a crash mid-write never leaves a
+// truncated checkpoint behind.
+void write_checkpoint(const std::string& file,
+                      const std::vector<std::pair<Id, std::vector<Id>>>& routes);
+
+// Load the checkpoint in file as vehicle steps of input, returning
+// whether anything was loaded. A checkpoint referring to unknown
+// vehicle or job ids does not match current input (e.g. the problem
+// changed since it was written) and is discarded as a whole.
+bool load_checkpoint(const std::string& file, Input& input);
+
+// Map solver routes (job ranks per vehicle rank) to the id-based
+// checkpoint representation. Route is any type derived from
+// RawRoute.
+template <class Route>
+std::vector<std::pair<Id, std::vector<Id>>>
+checkpoint_routes(const Input& input, const std::vector<Route>& sol) {
+  std::vector<std::pair<Id, std::vector<Id>>> routes;
+  for (std::size_t v = 0; v < sol.size(); ++v) {
+    if (sol[v].empty()) {
+      continue;
+    }
+    std::vector<Id> job_ids;
+    job_ids.reserve(sol[v].route.size());
+    for (const auto r : sol[v].route) {
+      job_ids.push_back(input.jobs[r].id);
+    }
+    routes.emplace_back(input.vehicles[v].id, std::move(job_ids));
+  }
+  return routes;
+}
+
+} // namespace utils
+} // namespace vroom
+
+#endif
@@ -0,0 +1,32 @@
+#ifndef CPU_DISPATCH_H
+#define CPU_DISPATCH_H
+
+/*
+
+This file is part of VROOM.
+
+Copyright (c) 2015-2021, Julien Coupey.
+All rights reserved (see LICENSE).
+
+*/
+
+// Runtime CPU-feature dispatch for vector-friendly kernels, so one
+// binary runs everywhere while still using wide instructions where
+// available. Functions marked with VROOM_TARGET_CLONES are compiled
+// once per listed target plus a default version, and the dynamic
+// linker resolves the best one at load time through an ifunc. Apply
+// it to flat-loop leaf functions only: each clone duplicates code
+// size and the indirection defeats inlining at call sites.
+//
+// On non-x86 architectures the attribute expands to nothing. NEON is
+// part of the aarch64 baseline, so the default codegen already uses
+// it there.
+#if defined(__x86_64__) and defined(__gnu_linux__) and                         \
+  (defined(__GNUC__) or defined(__clang__))
+#define VROOM_TARGET_CLONES                                                    \
+  __attribute__((target_clones("avx512f", "avx2", "default")))
+#else
+#define VROOM_TARGET_CLONES
+#endif
+
+#endif
@@ -0,0 +1,234 @@
+/*
+
+This file is part of VROOM.
+
+Copyright (c) 2015-2021, Julien Coupey.
+All rights reserved (see LICENSE).
+
+*/
+
+#include <algorithm>
+#include <charconv>
+#include <iostream>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+
+#include <asio.hpp>
+
+#include "utils/daemon.h"
+#include "utils/helpers.h"
+#include "utils/input_parser.h"
+#include "utils/metrics.h"
+#include "utils/output_json.h"
+
+using asio::ip::tcp;
+
+namespace vroom {
+namespace io {
+
+namespace {
+
+// Whether buffer holds a complete request, setting body_start (first
+// byte past the blank line) and body_size from the Content-Length
+// header. A Content-Length value that does not parse as a size sets
+// malformed instead, in which case the connection should be dropped.
+bool request_complete(const std::string& request,
+                      std::size_t& body_start,
+                      std::size_t& body_size,
+                      bool& malformed) {
+  const auto headers_end = request.find("\r\n\r\n");
+  if (headers_end == std::string::npos) {
+    return false;
+  }
+  body_start = headers_end + 4;
+
+  std::string headers = request.substr(0, body_start);
+  std::transform(headers.begin(), headers.end(), headers.begin(), ::tolower);
+
+  body_size = 0;
+  const auto content_length = headers.find("content-length:");
+  if (content_length != std::string::npos) {
+    const char* first = headers.data() + content_length + 15;
+    const char* const last = headers.data() + headers.size();
+    while (first != last and *first == ' ') {
+      ++first;
+    }
+    const auto [ptr, ec] = std::from_chars(first, last, body_size);
+    if (ec != std::errc()) {
+      malformed = true;
+      return false;
+    }
+  }
+
+  return request.size() >= body_start + body_size;
+}
+
+// Process-local LRU cache over serialized solutions, keyed by the
+// canonical hash of the parsed problem (opt-in, see -k). A large
+// share of server traffic is exact resubmissions from retries and
+// idempotent workflows, and those skip solving entirely on a hit.
+class SolutionCache {
+private:
+  static constexpr std::size_t MAX_ENTRIES = 64;
+
+  std::mutex _mutex;
+  // Most recently used entry first.
+  std::list<std::pair<uint64_t, std::string>> _entries;
+  std::unordered_map<uint64_t, decltype(_entries)::iterator> _ranks;
+
+public:
+  std::optional<std::string> find(uint64_t key) {
+    std::lock_guard<std::mutex> guard(_mutex);
+    const auto search = _ranks.find(key);
+    if (search == _ranks.end()) {
+      utils::metrics::solution_cache_miss();
+      return std::nullopt;
+    }
+    utils::metrics::solution_cache_hit();
+    _entries.splice(_entries.begin(), _entries, search->second);
+    return _entries.front().second;
+  }
+
+  void store(uint64_t key, const std::string& json) {
+    std::lock_guard<std::mutex> guard(_mutex);
+    if (_ranks.find(key) != _ranks.end()) {
+      return;
+    }
+    _entries.emplace_front(key, json);
+    _ranks.emplace(key, _entries.begin());
+    if (_entries.size() > MAX_ENTRIES) {
+      _ranks.erase(_entries.back().first);
+      _entries.pop_back();
+    }
+  }
+};
+
+SolutionCache solution_cache;
+
+} // namespace
+
+std::string solve_to_json(const CLArgs& base_args, std::string&& input) {
+  return solve_to_json_deferred(base_args, std::move(input))();
+}
+
+std::function<std::string()> solve_to_json_deferred(const CLArgs& base_args,
+                                                    std::string&& input) {
+  // The input buffer is parsed in place and descriptions are carried
+  // as views into it, so the whole problem state has to stay alive
+  // until the closure ran.
+  auto cl_args = std::make_shared<CLArgs>(base_args);
+  cl_args->input = std::move(input);
+  cl_args->mapped_input = nullptr;
+
+  try {
+    auto problem_instance = std::make_shared<Input>(parse(*cl_args));
+
+    std::optional<uint64_t> cache_key;
+    if (cl_args->solution_cache) {
+      cache_key = problem_instance->canonical_hash();
+      auto cached = solution_cache.find(cache_key.value());
+      if (cached.has_value()) {
+        return [json = std::move(cached.value())]() { return json; };
+      }
+    }
+
+    auto sol = std::make_shared<Solution>(
+      (cl_args->check) ? problem_instance->check(cl_args->nb_threads,
+                                                 cl_args->timeout)
+                       : problem_instance->solve(cl_args->exploration_level,
+                                                 cl_args->nb_threads,
+                                                 cl_args->timeout,
+                                                 cl_args->h_params));
+
+    return [cl_args, problem_instance, sol, cache_key]() {
+      auto json =
+        solution_to_json(*sol, cl_args->geometry, cl_args->plan_diff);
+      if (cache_key.has_value()) {
+        solution_cache.store(cache_key.value(), json);
+      }
+      return json;
+    };
+  } catch (const Exception& e) {
+    auto sol = std::make_shared<Solution>(utils::get_code(e.error), e.message);
+    return [sol]() { return solution_to_json(*sol, false); };
+  } catch (const std::exception& e) {
+    auto sol =
+      std::make_shared<Solution>(utils::get_code(ERROR::INTERNAL), e.what());
+    return [sol]() { return solution_to_json(*sol, false); };
+  }
+}
+
+void run_daemon(const CLArgs& cl_args, const std::string& port) {
+  uint16_t port_number = 0;
+  const auto [ptr, ec] =
+    std::from_chars(port.data(), port.data() + port.size(), port_number);
+  if (ec != std::errc() or ptr != port.data() + port.size()) {
+    throw Exception(ERROR::INPUT, "Invalid daemon port: " + port + ".");
+  }
+
+  asio::io_service io_service;
+  tcp::acceptor acceptor(io_service, tcp::endpoint(tcp::v4(), port_number));
+
+  std::cout << "[Info] Listening on port " << port << "." << std::endl;
+
+  for (;;) {
+    tcp::socket socket(io_service);
+    acceptor.accept(socket);
+
+    // Handle consecutive requests on this connection until the
+    // client closes it. Solving itself uses the configured number of
+    // threads so requests are processed one at a time.
+    std::string buffer;
+    char chunk[4096];
+    std::error_code error;
+
+    for (;;) {
+      std::size_t body_start = 0;
+      std::size_t body_size = 0;
+      bool malformed = false;
+      while (!request_complete(buffer, body_start, body_size, malformed)) {
+        if (malformed) {
+          break;
+        }
+        const auto len = socket.read_some(asio::buffer(chunk), error);
+        if (error) {
+          break;
+        }
+        buffer.append(chunk, len);
+      }
+      if (error or malformed) {
+        break;
+      }
+
+      std::string body;
+      std::string content_type;
+      if (buffer.rfind("GET /metrics", 0) == 0) {
+        // Observability endpoint, served from the process-wide
+        // lock-free counters without touching the solving path.
+        body = vroom::utils::metrics::render_prometheus();
+        content_type = "text/plain; version=0.0.4";
+      } else {
+        body = solve_to_json(cl_args, buffer.substr(body_start, body_size));
+        content_type = "application/json";
+      }
+      buffer.erase(0, body_start + body_size);
+
+      std::string response = "HTTP/1.1 200 OK\r\n";
+      response += "Content-Type: " + content_type + "\r\n";
+      response += "Content-Length: " + std::to_string(body.size()) + "\r\n";
+      response += "Connection: keep-alive\r\n\r\n";
+      response += body;
+
+      asio::write(socket, asio::buffer(response), error);
+      if (error) {
+        break;
+      }
+    }
+  }
+}
+
+} // namespace io
+} // namespace vroom
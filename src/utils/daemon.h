@@ -0,0 +1,43 @@
+#ifndef DAEMON_H
+#define DAEMON_H
+
+/*
+
+This file is part of VROOM.
+
+Copyright (c) 2015-2021, Julien Coupey.
+All rights reserved (see LICENSE).
+
+*/
+
+#include <functional>
+#include <string>
+
+#include "structures/cl_args.h"
+
+namespace vroom {
+namespace io {
+
+// Solve the problem described in input with the options from
+// cl_args, returning the solution (or error report) as a json
+// string.
+std::string solve_to_json(const CLArgs& cl_args, std::string&& input);
+
+// Same, but solving eagerly and deferring serialization: the
+// returned closure owns the problem state and formats the solution
+// when invoked, so a writer thread can serialize one problem while
+// the next one is being solved.
+std::function<std::string()> solve_to_json_deferred(const CLArgs& cl_args,
+                                                    std::string&& input);
+
+// Long-running server mode: listen for http requests on port and
+// solve each posted problem with the options in cl_args, keeping
+// process-level state (pooled routing connections, the on-disk
+// matrix cache, warm allocator) alive across requests. Never
+// returns.
+void run_daemon(const CLArgs& cl_args, const std::string& port);
+
+} // namespace io
+} // namespace vroom
+
+#endif
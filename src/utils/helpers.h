@@ -16,8 +16,11 @@ All rights reserved (see LICENSE).
 
 #include "structures/typedefs.h"
 #include "structures/vroom/raw_route.h"
+#include "structures/vroom/solution_state.h"
 #include "structures/vroom/tw_route.h"
+#include "utils/arena.h"
 #include "utils/exception.h"
+#include "utils/thread_pool.h"
 
 namespace vroom {
 namespace utils {
@@ -25,6 +28,11 @@ namespace utils {
 using RawSolution = std::vector<RawRoute>;
 using TWSolution = std::vector<TWRoute>;
 
+inline bool deadline_passed(const Deadline& deadline) {
+  return deadline.has_value() and
+         deadline.value() <= std::chrono::high_resolution_clock::now();
+}
+
 inline Cost add_without_overflow(Cost a, Cost b) {
   if (a > std::numeric_limits<Cost>::max() - b) {
     throw Exception(ERROR::INPUT,
@@ -141,6 +149,137 @@ inline Gain addition_cost(const Input& input,
   return previous_cost + next_cost - old_edge_cost;
 }
 
+// Compute costs of adding job with rank job_rank in given route at
+// all insertion ranks from 0 to route.size() in a single pass. Call
+// sites keep their own scan over the returned range so validity
+// checks only run for candidate ranks beating the current best. G is
+// the stored gain type: NarrowGain doubles the SIMD lane count below
+// and is only sound when Input::gains_fit_32bit holds, callers keep
+// the default wide pipeline otherwise. The returned vector lives in
+// the thread scratch arena, so callers are expected to hold an
+// ArenaScope spanning its use.
+template <typename G = Gain>
+inline std::pmr::vector<G> addition_costs(const Input& input,
+                                          Index job_rank,
+                                          const Vehicle& v,
+                                          const std::vector<Index>& route) {
+  std::pmr::vector<G> costs(route.size() + 1, &thread_arena());
+
+  // Insertions at route ends additionally depend on vehicle start
+  // and end.
+  costs[0] = static_cast<G>(addition_cost(input, job_rank, v, route, 0));
+  if (route.empty()) {
+    return costs;
+  }
+  costs[route.size()] =
+    static_cast<G>(addition_cost(input, job_rank, v, route, route.size()));
+
+  const Index job_index = input.jobs[job_rank].index();
+
+  std::size_t r = 1;
+#ifdef __AVX2__
+  const auto& cw = v.cost_wrapper;
+  if (cw.durations_factor == 1. and !cw.is_compact() and
+      !cw.has_overrides() and !cw.is_sparse() and
+      cw.durations_matrix_size <= (1 << 15)) {
+    // Durations can be gathered as-is and all matrix offsets fit in
+    // the signed 32-bit gather indices.
+    std::pmr::vector<int32_t> route_indices(route.size(), &thread_arena());
+    for (std::size_t i = 0; i < route.size(); ++i) {
+      route_indices[i] = input.jobs[route[i]].index();
+    }
+
+    const auto* data = reinterpret_cast<const int*>(cw.durations_data);
+    const __m256i size_v =
+      _mm256_set1_epi32(static_cast<int32_t>(cw.durations_matrix_size));
+    const __m256i job_v = _mm256_set1_epi32(job_index);
+    const __m256i job_row_v = _mm256_mullo_epi32(job_v, size_v);
+
+    for (; r + 8 <= route.size(); r += 8) {
+      // Gather previous->job, job->next and previous->next durations
+      // for 8 consecutive insertion ranks.
+      const __m256i p = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i*>(route_indices.data() + r - 1));
+      const __m256i n = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i*>(route_indices.data() + r));
+      const __m256i p_row = _mm256_mullo_epi32(p, size_v);
+
+      const __m256i previous =
+        _mm256_i32gather_epi32(data, _mm256_add_epi32(p_row, job_v), 4);
+      const __m256i next =
+        _mm256_i32gather_epi32(data, _mm256_add_epi32(job_row_v, n), 4);
+      const __m256i old_edge =
+        _mm256_i32gather_epi32(data, _mm256_add_epi32(p_row, n), 4);
+
+      if constexpr (sizeof(G) == sizeof(NarrowGain)) {
+        // Checked bounds guarantee previous + next fits 32 bits, so
+        // gains combine and store on full-width narrow lanes.
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(costs.data() + r),
+                            _mm256_sub_epi32(_mm256_add_epi32(previous, next),
+                                             old_edge));
+      } else {
+        // Widen to 64-bit gains before combining.
+        const __m256i gains_low = _mm256_sub_epi64(
+          _mm256_add_epi64(_mm256_cvtepu32_epi64(
+                             _mm256_castsi256_si128(previous)),
+                           _mm256_cvtepu32_epi64(
+                             _mm256_castsi256_si128(next))),
+          _mm256_cvtepu32_epi64(_mm256_castsi256_si128(old_edge)));
+        const __m256i gains_high = _mm256_sub_epi64(
+          _mm256_add_epi64(_mm256_cvtepu32_epi64(
+                             _mm256_extracti128_si256(previous, 1)),
+                           _mm256_cvtepu32_epi64(
+                             _mm256_extracti128_si256(next, 1))),
+          _mm256_cvtepu32_epi64(_mm256_extracti128_si256(old_edge, 1)));
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(costs.data() + r),
+                            gains_low);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(costs.data() + r + 4),
+                            gains_high);
+      }
+    }
+  }
+#endif
+  // Prefetch the matrix rows involved a few ranks ahead of the scan,
+  // they are index-chased so the hardware prefetcher cannot predict
+  // them.
+  constexpr std::size_t prefetch_distance = 4;
+  for (; r < route.size(); ++r) {
+    if (r + prefetch_distance < route.size()) {
+      const auto f_index = input.jobs[route[r + prefetch_distance]].index();
+      v.cost_wrapper.prefetch_duration(f_index, job_index);
+      v.cost_wrapper.prefetch_duration(job_index, f_index);
+    }
+
+    const auto p_index = input.jobs[route[r - 1]].index();
+    const auto n_index = input.jobs[route[r]].index();
+    costs[r] =
+      static_cast<G>(static_cast<Gain>(v.cost(p_index, job_index)) +
+                     static_cast<Gain>(v.cost(job_index, n_index)) -
+                     static_cast<Gain>(v.cost(p_index, n_index)));
+  }
+
+  return costs;
+}
+
+// Rank insertion slots by increasing addition cost. Scanning slots in
+// this order lets call sites run their expensive validity checks
+// best-first and stop at the first valid slot, which is then optimal
+// by construction. Ties keep ascending rank order so selection matches
+// a plain scan. The returned vector lives in the thread scratch arena,
+// so callers are expected to hold an ArenaScope spanning its use.
+template <class Costs>
+inline std::pmr::vector<Index> ranked_addition_ranks(const Costs& costs) {
+  std::pmr::vector<Index> ranks(costs.size(), &thread_arena());
+  std::iota(ranks.begin(), ranks.end(), 0);
+  std::stable_sort(ranks.begin(), ranks.end(), [&](const auto lhs,
+                                                   const auto rhs) {
+    return costs[lhs] < costs[rhs];
+  });
+
+  return ranks;
+}
+
 // Compute cost of adding pickup with rank job_rank and associated
 // delivery (with rank job_rank + 1) in given route for vehicle
 // v. Pickup is inserted at pickup_rank in route and delivery is
@@ -225,6 +364,60 @@ inline Cost route_cost_for_vehicle(const Input& input,
   return cost;
 }
 
+// FNV-1a hash of the job sequence in a route, seeded with the vehicle
+// rank so the same sequence assigned to different vehicles hashes
+// differently.
+inline uint64_t route_hash(Index vehicle_rank,
+                           const std::vector<Index>& route) {
+  uint64_t h = 0xcbf29ce484222325ULL ^ vehicle_rank;
+  for (const auto job_rank : route) {
+    h = (h ^ job_rank) * 0x100000001b3ULL;
+  }
+
+  return h;
+}
+
+template <class Route>
+SolutionIndicators solution_indicators(const Input& input,
+                                       const std::vector<Route>& sol) {
+  SolutionIndicators indicators;
+
+  indicators.priority_sum =
+    std::accumulate(sol.begin(), sol.end(), 0, [&](auto sum, const auto& r) {
+      return sum + priority_sum_for_route(input, r.route);
+    });
+
+  // Every job is either assigned in a route or unassigned.
+  indicators.unassigned =
+    input.jobs.size() -
+    std::accumulate(sol.begin(), sol.end(), 0, [](auto sum, const auto& r) {
+      return sum + r.route.size();
+    });
+
+  Index v_rank = 0;
+  indicators.cost =
+    std::accumulate(sol.begin(), sol.end(), 0, [&](auto sum, const auto& r) {
+      return sum + route_cost_for_vehicle(input, v_rank++, r.route);
+    });
+
+  indicators.used_vehicles =
+    std::count_if(sol.begin(), sol.end(), [](const auto& r) {
+      return !r.empty();
+    });
+
+  // Per-route hashes are combined with a plain sum so the result does
+  // not depend on the order routes are visited in.
+  Index h_rank = 0;
+  indicators.hash = std::accumulate(sol.begin(),
+                                    sol.end(),
+                                    uint64_t(0),
+                                    [&](auto sum, const auto& r) {
+                                      return sum + route_hash(h_rank++, r.route);
+                                    });
+
+  return indicators;
+}
+
 inline void check_precedence(const Input& input,
                              std::unordered_set<Index>& expected_delivery_ranks,
                              Index job_rank) {
@@ -243,6 +436,45 @@ inline void check_precedence(const Input& input,
   }
 }
 
+// Iterator to the first time window not closed at date t, i.e. the
+// earliest one able to hold t or any later date (tws.end() if t is
+// past all windows). Windows are sorted and disjoint (see check_tws)
+// so this is the number of windows already closed at t. Counting is
+// branchless and vectorizes on the short lists that dominate,
+// longer lists fall back to binary search.
+inline std::vector<TimeWindow>::const_iterator
+earliest_available_tw(const std::vector<TimeWindow>& tws, const Duration t) {
+  if (tws.size() > 16) {
+    return std::partition_point(tws.begin(),
+                                tws.end(),
+                                [&](const auto& tw) { return tw.end < t; });
+  }
+
+  std::size_t closed = 0;
+  for (const auto& tw : tws) {
+    closed += (tw.end < t);
+  }
+  return tws.begin() + closed;
+}
+
+// Reverse iterator to the last time window started at date t,
+// i.e. the latest one able to hold t or any earlier date (tws.rend()
+// if t is ahead of all windows).
+inline std::vector<TimeWindow>::const_reverse_iterator
+latest_available_tw(const std::vector<TimeWindow>& tws, const Duration t) {
+  if (tws.size() > 16) {
+    return std::partition_point(tws.rbegin(),
+                                tws.rend(),
+                                [&](const auto& tw) { return t < tw.start; });
+  }
+
+  std::size_t not_started = 0;
+  for (const auto& tw : tws) {
+    not_started += (t < tw.start);
+  }
+  return tws.rbegin() + not_started;
+}
+
 inline void check_tws(const std::vector<TimeWindow>& tws) {
   if (tws.size() == 0) {
     throw Exception(ERROR::INPUT, "Empty time-windows.");
@@ -257,144 +489,174 @@ inline void check_tws(const std::vector<TimeWindow>& tws) {
   }
 }
 
-inline Solution format_solution(const Input& input,
-                                const RawSolution& raw_routes) {
-  std::vector<Route> routes;
+inline Route format_route(const Input& input,
+                          const RawRoute& raw_route,
+                          const Index vehicle_rank) {
+  const auto& route = raw_route.route;
+  const auto& v = input.vehicles[vehicle_rank];
 
-  // All job ranks start with unassigned status.
-  std::unordered_set<Index> unassigned_ranks;
-  for (unsigned i = 0; i < input.jobs.size(); ++i) {
-    unassigned_ranks.insert(i);
+  Duration duration = 0;
+  Duration service = 0;
+  Priority priority = 0;
+  Amount sum_pickups(input.zero_amount());
+  Amount sum_deliveries(input.zero_amount());
+#ifndef NDEBUG
+  std::unordered_set<Index> expected_delivery_ranks;
+#endif
+  Amount current_load = raw_route.get_startup_load();
+  assert(current_load <= v.capacity);
+
+  // Steps for current route.
+  std::vector<Step> steps;
+  steps.reserve(route.size() + 2);
+
+  Duration ETA = 0;
+  const auto& first_job = input.jobs[route.front()];
+
+  // Handle start.
+  const auto start_loc = v.has_start() ? v.start.value() : first_job.location;
+  steps.emplace_back(STEP_TYPE::START, start_loc, current_load);
+  if (v.has_start()) {
+    const auto travel = v.duration(v.start.value().index(), first_job.index());
+    ETA += travel;
+    duration += travel;
   }
 
-  for (std::size_t i = 0; i < raw_routes.size(); ++i) {
-    const auto& route = raw_routes[i].route;
-    if (route.empty()) {
-      continue;
-    }
-    const auto& v = input.vehicles[i];
+  // Handle jobs.
+  assert(input.vehicle_ok_with_job(vehicle_rank, route.front()));
+  service += first_job.service;
+  priority += first_job.priority;
+
+  current_load += first_job.pickup;
+  current_load -= first_job.delivery;
+  sum_pickups += first_job.pickup;
+  sum_deliveries += first_job.delivery;
+  assert(current_load <= v.capacity);
 
-    Duration duration = 0;
-    Duration service = 0;
-    Priority priority = 0;
-    Amount sum_pickups(input.zero_amount());
-    Amount sum_deliveries(input.zero_amount());
 #ifndef NDEBUG
-    std::unordered_set<Index> expected_delivery_ranks;
+  check_precedence(input, expected_delivery_ranks, route.front());
 #endif
-    Amount current_load = raw_routes[i].get_startup_load();
-    assert(current_load <= v.capacity);
 
-    // Steps for current route.
-    std::vector<Step> steps;
+  steps.emplace_back(first_job, current_load);
+  auto& first = steps.back();
+  first.duration = ETA;
+  first.arrival = ETA;
+  ETA += first.service;
 
-    Duration ETA = 0;
-    const auto& first_job = input.jobs[route.front()];
+  for (std::size_t r = 0; r < route.size() - 1; ++r) {
+    assert(input.vehicle_ok_with_job(vehicle_rank, route[r + 1]));
+    Duration travel = v.duration(input.jobs[route[r]].index(),
+                                 input.jobs[route[r + 1]].index());
+    ETA += travel;
+    duration += travel;
 
-    // Handle start.
-    const auto start_loc = v.has_start() ? v.start.value() : first_job.location;
-    steps.emplace_back(STEP_TYPE::START, start_loc, current_load);
-    if (v.has_start()) {
-      const auto travel =
-        v.duration(v.start.value().index(), first_job.index());
-      ETA += travel;
-      duration += travel;
-    }
-
-    // Handle jobs.
-    assert(input.vehicle_ok_with_job(i, route.front()));
-    service += first_job.service;
-    priority += first_job.priority;
+    auto& current_job = input.jobs[route[r + 1]];
+    service += current_job.service;
+    priority += current_job.priority;
 
-    current_load += first_job.pickup;
-    current_load -= first_job.delivery;
-    sum_pickups += first_job.pickup;
-    sum_deliveries += first_job.delivery;
+    current_load += current_job.pickup;
+    current_load -= current_job.delivery;
+    sum_pickups += current_job.pickup;
+    sum_deliveries += current_job.delivery;
     assert(current_load <= v.capacity);
 
 #ifndef NDEBUG
-    check_precedence(input, expected_delivery_ranks, route.front());
+    check_precedence(input, expected_delivery_ranks, route[r + 1]);
 #endif
 
-    steps.emplace_back(first_job, current_load);
-    auto& first = steps.back();
-    first.duration = ETA;
-    first.arrival = ETA;
-    ETA += first.service;
-    unassigned_ranks.erase(route.front());
-
-    for (std::size_t r = 0; r < route.size() - 1; ++r) {
-      assert(input.vehicle_ok_with_job(i, route[r + 1]));
-      Duration travel = v.duration(input.jobs[route[r]].index(),
-                                   input.jobs[route[r + 1]].index());
-      ETA += travel;
-      duration += travel;
-
-      auto& current_job = input.jobs[route[r + 1]];
-      service += current_job.service;
-      priority += current_job.priority;
-
-      current_load += current_job.pickup;
-      current_load -= current_job.delivery;
-      sum_pickups += current_job.pickup;
-      sum_deliveries += current_job.delivery;
-      assert(current_load <= v.capacity);
+    steps.emplace_back(current_job, current_load);
+    auto& current = steps.back();
+    current.duration = duration;
+    current.arrival = ETA;
+    ETA += current.service;
+  }
 
-#ifndef NDEBUG
-      check_precedence(input, expected_delivery_ranks, route[r + 1]);
-#endif
+  // Handle end.
+  const auto& last_job = input.jobs[route.back()];
+  const auto end_loc = v.has_end() ? v.end.value() : last_job.location;
+  steps.emplace_back(STEP_TYPE::END, end_loc, std::move(current_load));
+  if (v.has_end()) {
+    const auto travel = v.duration(last_job.index(), v.end.value().index());
+    ETA += travel;
+    duration += travel;
+  }
+  steps.back().duration = duration;
+  steps.back().arrival = ETA;
 
-      steps.emplace_back(current_job, current_load);
-      auto& current = steps.back();
-      current.duration = duration;
-      current.arrival = ETA;
-      ETA += current.service;
-      unassigned_ranks.erase(route[r + 1]);
-    }
+  assert(expected_delivery_ranks.empty());
 
-    // Handle end.
-    const auto& last_job = input.jobs[route.back()];
-    const auto end_loc = v.has_end() ? v.end.value() : last_job.location;
-    steps.emplace_back(STEP_TYPE::END, end_loc, current_load);
-    if (v.has_end()) {
-      const auto travel = v.duration(last_job.index(), v.end.value().index());
-      ETA += travel;
-      duration += travel;
+  return Route(v.id,
+               std::move(steps),
+               duration,
+               service,
+               duration,
+               0,
+               priority,
+               std::move(sum_deliveries),
+               std::move(sum_pickups),
+               v.profile,
+               v.description);
+}
+
+inline Solution format_solution(const Input& input,
+                                const RawSolution& raw_routes) {
+  Solution sol(0, input.zero_amount().size());
+  sol.routes.reserve(raw_routes.size());
+
+  // All job ranks start with unassigned status.
+  std::unordered_set<Index> unassigned_ranks;
+  for (unsigned i = 0; i < input.jobs.size(); ++i) {
+    unassigned_ranks.insert(i);
+  }
+
+  std::vector<Index> non_empty;
+  for (std::size_t i = 0; i < raw_routes.size(); ++i) {
+    if (!raw_routes[i].route.empty()) {
+      non_empty.push_back(i);
     }
-    steps.back().duration = duration;
-    steps.back().arrival = ETA;
+  }
 
-    assert(expected_delivery_ranks.empty());
+  // Per-route step expansion is independent by construction, so
+  // routes are built in parallel, then merged back in vehicle order
+  // so output never depends on scheduling. This formatting tail is
+  // all that remains after solving and used to add up on solutions
+  // with many routes.
+  std::vector<Route> routes(non_empty.size());
+  auto format_one = [&](std::size_t r) {
+    routes[r] = format_route(input, raw_routes[non_empty[r]], non_empty[r]);
+  };
+
+  if (non_empty.size() > 1 and effective_concurrency() > 1) {
+    std::vector<std::function<void()>> formatting_tasks;
+    formatting_tasks.reserve(non_empty.size());
+    for (std::size_t r = 0; r < non_empty.size(); ++r) {
+      formatting_tasks.push_back([&format_one, r]() { format_one(r); });
+    }
+    ThreadPool::instance().run(std::move(formatting_tasks));
+  } else {
+    for (std::size_t r = 0; r < non_empty.size(); ++r) {
+      format_one(r);
+    }
+  }
 
-    routes.emplace_back(v.id,
-                        std::move(steps),
-                        duration,
-                        service,
-                        duration,
-                        0,
-                        priority,
-                        sum_deliveries,
-                        sum_pickups,
-                        v.profile,
-                        v.description);
+  // Ordered merge, folding each route into the summary.
+  for (std::size_t r = 0; r < non_empty.size(); ++r) {
+    for (const auto j : raw_routes[non_empty[r]].route) {
+      unassigned_ranks.erase(j);
+    }
+    sol.add_route(std::move(routes[r]));
   }
 
   // Handle unassigned jobs.
-  std::vector<Job> unassigned_jobs;
-  std::transform(unassigned_ranks.begin(),
-                 unassigned_ranks.end(),
-                 std::back_inserter(unassigned_jobs),
-                 [&](auto j) { return input.jobs[j]; });
-
-  return Solution(0,
-                  input.zero_amount().size(),
-                  std::move(routes),
-                  std::move(unassigned_jobs));
+  sol.unassigned.reserve(unassigned_ranks.size());
+  for (const auto j : unassigned_ranks) {
+    sol.add_unassigned(input.jobs[j]);
+  }
+
+  return sol;
 }
 
-inline Route format_route(const Input& input,
-                          const TWRoute& tw_r,
-                          std::unordered_set<Index>& unassigned_ranks) {
+inline Route format_route(const Input& input, const TWRoute& tw_r) {
   const auto& v = input.vehicles[tw_r.vehicle_rank];
 
   // ETA logic: aim at earliest possible arrival then determine latest
@@ -483,6 +745,7 @@ inline Route format_route(const Input& input,
 
   // Steps for current route.
   std::vector<Step> steps;
+  steps.reserve(tw_r.route.size() + v.breaks.size() + 2);
 
   // Now pack everything ASAP based on first job start date.
   Duration remaining_travel_time =
@@ -648,8 +911,6 @@ inline Route format_route(const Input& input,
     assert(current_job.is_valid_start(current.arrival + current.waiting_time));
 
     step_start += current_job.service;
-
-    unassigned_ranks.erase(tw_r.route[r]);
   }
 
   // Handle breaks after last job.
@@ -711,7 +972,9 @@ inline Route format_route(const Input& input,
     step_start += current_service;
   }
 
-  steps.emplace_back(STEP_TYPE::END, last_location.value(), current_load);
+  steps.emplace_back(STEP_TYPE::END,
+                     last_location.value(),
+                     std::move(current_load));
   if (v.has_end()) {
     duration += travel_time;
     step_start += travel_time;
@@ -736,15 +999,16 @@ inline Route format_route(const Input& input,
                duration,
                forward_wt,
                priority,
-               sum_deliveries,
-               sum_pickups,
+               std::move(sum_deliveries),
+               std::move(sum_pickups),
                v.profile,
                v.description);
 }
 
 inline Solution format_solution(const Input& input,
                                 const TWSolution& tw_routes) {
-  std::vector<Route> routes;
+  Solution sol(0, input.zero_amount().size());
+  sol.routes.reserve(tw_routes.size());
 
   // All job ranks start with unassigned status.
   std::unordered_set<Index> unassigned_ranks;
@@ -752,23 +1016,49 @@ inline Solution format_solution(const Input& input,
     unassigned_ranks.insert(i);
   }
 
-  for (const auto& tw_route : tw_routes) {
-    if (!tw_route.empty()) {
-      routes.push_back(format_route(input, tw_route, unassigned_ranks));
+  std::vector<Index> non_empty;
+  for (std::size_t i = 0; i < tw_routes.size(); ++i) {
+    if (!tw_routes[i].empty()) {
+      non_empty.push_back(i);
     }
   }
 
+  // Build routes in parallel then merge them back in vehicle order,
+  // as in the raw overload above. The timing back-propagation in
+  // format_route makes this version the more expensive of the two.
+  std::vector<Route> routes(non_empty.size());
+  auto format_one = [&](std::size_t r) {
+    routes[r] = format_route(input, tw_routes[non_empty[r]]);
+  };
+
+  if (non_empty.size() > 1 and effective_concurrency() > 1) {
+    std::vector<std::function<void()>> formatting_tasks;
+    formatting_tasks.reserve(non_empty.size());
+    for (std::size_t r = 0; r < non_empty.size(); ++r) {
+      formatting_tasks.push_back([&format_one, r]() { format_one(r); });
+    }
+    ThreadPool::instance().run(std::move(formatting_tasks));
+  } else {
+    for (std::size_t r = 0; r < non_empty.size(); ++r) {
+      format_one(r);
+    }
+  }
+
+  // Ordered merge, folding each route into the summary.
+  for (std::size_t r = 0; r < non_empty.size(); ++r) {
+    for (const auto j : tw_routes[non_empty[r]].route) {
+      unassigned_ranks.erase(j);
+    }
+    sol.add_route(std::move(routes[r]));
+  }
+
   // Handle unassigned jobs.
-  std::vector<Job> unassigned_jobs;
-  std::transform(unassigned_ranks.begin(),
-                 unassigned_ranks.end(),
-                 std::back_inserter(unassigned_jobs),
-                 [&](auto j) { return input.jobs[j]; });
-
-  return Solution(0,
-                  input.zero_amount().size(),
-                  std::move(routes),
-                  std::move(unassigned_jobs));
+  sol.unassigned.reserve(unassigned_ranks.size());
+  for (const auto j : unassigned_ranks) {
+    sol.add_unassigned(input.jobs[j]);
+  }
+
+  return sol;
 }
 
 inline unsigned get_code(ERROR e) {
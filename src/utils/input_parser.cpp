@@ -8,6 +8,14 @@ All rights reserved (see LICENSE).
 */
 
 #include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #if USE_LIBOSRM
 #include "osrm/exception.hpp"
@@ -17,6 +25,7 @@ All rights reserved (see LICENSE).
 #include "../include/rapidjson/error/en.h"
 
 #include "structures/cl_args.h"
+#include "structures/generic/sparse_matrix.h"
 #include "utils/input_parser.h"
 
 namespace vroom {
@@ -32,13 +41,17 @@ inline Coordinates parse_coordinates(const rapidjson::Value& object,
   return {{object[key][0].GetDouble(), object[key][1].GetDouble()}};
 }
 
-inline std::string get_string(const rapidjson::Value& object, const char* key) {
-  std::string value;
+// The returned view points into the in-situ parsed input buffer, see
+// parse below.
+inline std::string_view get_string(const rapidjson::Value& object,
+                                   const char* key) {
+  std::string_view value;
   if (object.HasMember(key)) {
     if (!object[key].IsString()) {
       throw Exception(ERROR::INPUT, "Invalid " + std::string(key) + " value.");
     }
-    value = object[key].GetString();
+    value =
+      std::string_view(object[key].GetString(), object[key].GetStringLength());
   }
   return value;
 }
@@ -383,7 +396,7 @@ inline Vehicle get_vehicle(const rapidjson::Value& json_vehicle,
     }
   }
 
-  std::string profile = get_string(json_vehicle, "profile");
+  std::string profile(get_string(json_vehicle, "profile"));
   if (profile.empty()) {
     profile = DEFAULT_PROFILE;
   }
@@ -472,12 +485,79 @@ inline Matrix<Cost> get_matrix(rapidjson::Value& m) {
   return matrix;
 }
 
-Input parse(const CLArgs& cl_args) {
+// Binary matrix files hold this header followed by a flat row-major
+// Cost array with nb_locations * nb_locations entries.
+struct MatrixFileHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint64_t nb_locations;
+};
+
+constexpr uint32_t MATRIX_FILE_MAGIC = 0x56524d58; // "VRMX"
+constexpr uint32_t MATRIX_FILE_VERSION = 1;
+
+inline Matrix<Cost> get_matrix_from_file(const std::string& file_path) {
+  // Map the file read-only and use the mapping directly as matrix
+  // backing store, so loading involves no parsing and no copy.
+  const auto fd = open(file_path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw Exception(ERROR::INPUT,
+                    "Could not open matrix file " + file_path + ".");
+  }
+
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) < 0 or
+      static_cast<std::size_t>(file_stat.st_size) < sizeof(MatrixFileHeader)) {
+    close(fd);
+    throw Exception(ERROR::INPUT, "Invalid matrix file " + file_path + ".");
+  }
+  const std::size_t file_size = file_stat.st_size;
+
+  const auto* mapping = static_cast<const char*>(
+    mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE, fd, 0));
+  close(fd);
+  if (mapping == MAP_FAILED) {
+    throw Exception(ERROR::INPUT,
+                    "Could not map matrix file " + file_path + ".");
+  }
+
+  // Keep the mapping alive for as long as any matrix copy points
+  // into it.
+  std::shared_ptr<const void> backing(static_cast<const void*>(mapping),
+                                      [file_size](const void* m) {
+                                        munmap(const_cast<void*>(m), file_size);
+                                      });
+
+  MatrixFileHeader header;
+  std::memcpy(&header, mapping, sizeof(header));
+
+  if (header.magic != MATRIX_FILE_MAGIC or
+      header.version != MATRIX_FILE_VERSION or
+      file_size != sizeof(MatrixFileHeader) +
+                     header.nb_locations * header.nb_locations * sizeof(Cost)) {
+    throw Exception(ERROR::INPUT, "Invalid matrix file " + file_path + ".");
+  }
+
+  return Matrix<Cost>(reinterpret_cast<const Cost*>(mapping +
+                                                    sizeof(MatrixFileHeader)),
+                      header.nb_locations,
+                      std::move(backing));
+}
+
+Input parse(CLArgs& cl_args) {
   // Input json object.
   rapidjson::Document json_input;
 
-  // Parsing input string to populate the input object.
-  if (json_input.Parse(cl_args.input.c_str()).HasParseError()) {
+  // Parsing in place: string values point straight into the caller's
+  // buffer (memory-mapped input file or cl_args.input) instead of
+  // being copied into the document, and descriptions are carried
+  // further as views. The buffer is mangled by the parse and has to
+  // outlive the returned Input.
+  const bool has_parse_error =
+    (cl_args.mapped_input != nullptr)
+      ? json_input.ParseInsitu(cl_args.mapped_input).HasParseError()
+      : json_input.ParseInsitu(cl_args.input.data()).HasParseError();
+  if (has_parse_error) {
     std::string error_msg =
       std::string(rapidjson::GetParseError_En(json_input.GetParseError())) +
       " (offset: " + std::to_string(json_input.GetErrorOffset()) + ")";
@@ -509,6 +589,18 @@ Input parse(const CLArgs& cl_args) {
   // Custom input object embedding jobs, vehicles and matrices.
   Input input(amount_size, cl_args.servers, cl_args.router);
   input.set_geometry(cl_args.geometry);
+  if (!cl_args.checkpoint_file.empty()) {
+    input.set_checkpoint(cl_args.checkpoint_file);
+  }
+  if (cl_args.sweep_count > 1) {
+    input.set_sweep_slice(cl_args.sweep_rank, cl_args.sweep_count);
+  }
+  if (cl_args.memory_budget > 0) {
+    input.set_memory_budget(cl_args.memory_budget);
+  }
+  if (cl_args.nb_alternatives > 0) {
+    input.set_nb_alternatives(cl_args.nb_alternatives);
+  }
 
   // Add all vehicles.
   for (rapidjson::SizeType i = 0; i < json_input["vehicles"].Size(); ++i) {
@@ -573,10 +665,96 @@ Input parse(const CLArgs& cl_args) {
       throw Exception(ERROR::INPUT, "Unexpected matrices value.");
     }
     for (auto& profile_entry : json_input["matrices"].GetObject()) {
-      if (profile_entry.value.IsObject() and
-          profile_entry.value.HasMember("durations")) {
-        input.set_matrix(profile_entry.name.GetString(),
-                         get_matrix(profile_entry.value["durations"]));
+      if (profile_entry.value.IsObject()) {
+        if (profile_entry.value.HasMember("durations")) {
+          input.set_matrix(profile_entry.name.GetString(),
+                           get_matrix(profile_entry.value["durations"]));
+        } else if (profile_entry.value.HasMember("durations_file")) {
+          // Out-of-band binary matrix file, way cheaper than a huge
+          // embedded json array.
+          if (!profile_entry.value["durations_file"].IsString()) {
+            throw Exception(ERROR::INPUT, "Invalid durations_file value.");
+          }
+          input.set_matrix(profile_entry.name.GetString(),
+                           get_matrix_from_file(
+                             profile_entry.value["durations_file"]
+                               .GetString()));
+        } else if (profile_entry.value.HasMember("sparse_durations")) {
+          // Sparse matrix for depot-centric instances: only listed
+          // (i, j, duration) pairs are stored and any other lookup
+          // answers the fallback bound, see Input::set_sparse_matrix.
+          const auto& sparse = profile_entry.value["sparse_durations"];
+          if (!sparse.IsObject() or !sparse.HasMember("size") or
+              !sparse["size"].IsUint() or !sparse.HasMember("fallback") or
+              !sparse["fallback"].IsUint() or !sparse.HasMember("entries") or
+              !sparse["entries"].IsArray()) {
+            throw Exception(ERROR::INPUT, "Invalid sparse_durations value.");
+          }
+          const std::size_t size = sparse["size"].GetUint();
+
+          std::vector<std::tuple<Index, Index, Cost>> entries;
+          entries.reserve(sparse["entries"].Size());
+          for (auto& entry : sparse["entries"].GetArray()) {
+            if (!entry.IsArray() or entry.Size() != 3 or !entry[0].IsUint() or
+                !entry[1].IsUint() or !entry[2].IsUint()) {
+              throw Exception(ERROR::INPUT,
+                              "Invalid sparse_durations entry.");
+            }
+            if (size <= entry[0].GetUint() or size <= entry[1].GetUint()) {
+              throw Exception(ERROR::INPUT,
+                              "sparse_durations entry exceeding size.");
+            }
+            entries.emplace_back(entry[0].GetUint(),
+                                 entry[1].GetUint(),
+                                 entry[2].GetUint());
+          }
+
+          input.set_sparse_matrix(profile_entry.name.GetString(),
+                                  SparseMatrix<Cost>(size,
+                                                     sparse["fallback"]
+                                                       .GetUint(),
+                                                     std::move(entries)));
+        } else if (profile_entry.value.HasMember("derived_from")) {
+          // Profile defined as a transform of another profile's
+          // matrix instead of a matrix of its own.
+          if (!profile_entry.value["derived_from"].IsString()) {
+            throw Exception(ERROR::INPUT, "Invalid derived_from value.");
+          }
+
+          double factor = 1.;
+          if (profile_entry.value.HasMember("durations_factor")) {
+            if (!profile_entry.value["durations_factor"].IsNumber()) {
+              throw Exception(ERROR::INPUT, "Invalid durations_factor value.");
+            }
+            factor = profile_entry.value["durations_factor"].GetDouble();
+          }
+
+          std::vector<std::tuple<Index, Index, Cost>> overrides;
+          if (profile_entry.value.HasMember("duration_overrides")) {
+            if (!profile_entry.value["duration_overrides"].IsArray()) {
+              throw Exception(ERROR::INPUT,
+                              "Invalid duration_overrides value.");
+            }
+            for (auto& entry :
+                 profile_entry.value["duration_overrides"].GetArray()) {
+              if (!entry.IsArray() or entry.Size() != 3 or
+                  !entry[0].IsUint() or !entry[1].IsUint() or
+                  !entry[2].IsUint()) {
+                throw Exception(ERROR::INPUT,
+                                "Invalid duration_overrides entry.");
+              }
+              overrides.emplace_back(entry[0].GetUint(),
+                                     entry[1].GetUint(),
+                                     entry[2].GetUint());
+            }
+          }
+
+          input.add_derived_profile(profile_entry.name.GetString(),
+                                    profile_entry.value["derived_from"]
+                                      .GetString(),
+                                    factor,
+                                    std::move(overrides));
+        }
       }
     }
   } else {
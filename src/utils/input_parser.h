@@ -18,7 +18,10 @@ namespace io {
 
 struct CLArgs;
 
-Input parse(const CLArgs& cl_args);
+// Parses the problem in place over the caller-owned input buffer,
+// which is mangled in the process and has to outlive the returned
+// Input (descriptions are carried as views into it).
+Input parse(CLArgs& cl_args);
 
 } // namespace io
 } // namespace vroom
@@ -0,0 +1,285 @@
+/*
+
+This file is part of VROOM.
+
+Copyright (c) 2015-2021, Julien Coupey.
+All rights reserved (see LICENSE).
+
+*/
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <unordered_map>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "utils/matrix_cache.h"
+#include "utils/metrics.h"
+
+namespace vroom {
+namespace utils {
+
+namespace {
+
+// Bumped whenever the file layout below changes so stale files from
+// previous versions are simply ignored.
+constexpr uint32_t CACHE_MAGIC = 0x56524d43; // "VRMC"
+constexpr uint32_t CACHE_VERSION = 1;
+
+struct CacheHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint64_t nb_locations;
+};
+
+// Header, then nb_locations (lon, lat) coordinate pairs, then the
+// row-major matrix data.
+
+std::string cache_file_name(const std::string& profile) {
+  const char* cache_dir = std::getenv("VROOM_MATRIX_CACHE");
+  if (cache_dir == nullptr or *cache_dir == '\0') {
+    return "";
+  }
+
+  return std::string(cache_dir) + "/" + profile + ".matrix";
+}
+
+// Hints get their own file per profile: header, then nb_entries
+// blocks each holding a coordinate pair, the hint length and the hint
+// bytes.
+constexpr uint32_t HINTS_MAGIC = 0x56524843; // "VRHC"
+constexpr uint32_t HINTS_VERSION = 1;
+
+struct HintsHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint64_t nb_entries;
+};
+
+std::string hints_file_name(const std::string& profile) {
+  const auto file_name = cache_file_name(profile);
+  return file_name.empty() ? file_name : file_name + ".hints";
+}
+
+} // namespace
+
+std::optional<Matrix<Cost>>
+load_cached_matrix(const std::string& profile,
+                   const std::vector<Location>& locations) {
+  const auto file_name = cache_file_name(profile);
+  if (file_name.empty()) {
+    // Cache disabled, not counted as a miss.
+    return std::nullopt;
+  }
+
+  const auto fd = open(file_name.c_str(), O_RDONLY);
+  if (fd < 0) {
+    metrics::matrix_cache_miss();
+    return std::nullopt;
+  }
+
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) < 0 or
+      static_cast<std::size_t>(file_stat.st_size) < sizeof(CacheHeader)) {
+    close(fd);
+    metrics::matrix_cache_miss();
+    return std::nullopt;
+  }
+  const std::size_t file_size = file_stat.st_size;
+
+  const auto* mapping = static_cast<const char*>(
+    mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE, fd, 0));
+  close(fd);
+  if (mapping == MAP_FAILED) {
+    metrics::matrix_cache_miss();
+    return std::nullopt;
+  }
+
+  std::optional<Matrix<Cost>> matrix;
+
+  CacheHeader header;
+  std::memcpy(&header, mapping, sizeof(header));
+
+  const std::size_t cached_size = header.nb_locations;
+  const std::size_t expected_size =
+    sizeof(CacheHeader) + cached_size * sizeof(Coordinates) +
+    cached_size * cached_size * sizeof(Cost);
+
+  if (header.magic == CACHE_MAGIC and header.version == CACHE_VERSION and
+      file_size == expected_size) {
+    const auto* cached_coordinates =
+      reinterpret_cast<const Coordinates*>(mapping + sizeof(CacheHeader));
+    const auto* cached_data = reinterpret_cast<const Cost*>(
+      mapping + sizeof(CacheHeader) + cached_size * sizeof(Coordinates));
+
+    std::unordered_map<Coordinates, std::size_t, CoordinatesHash> cached_ranks;
+    for (std::size_t i = 0; i < cached_size; ++i) {
+      cached_ranks.emplace(cached_coordinates[i], i);
+    }
+
+    // Match current locations against the cached coordinate
+    // list. Only the relevant rows and columns are extracted so
+    // dropping locations between runs does not invalidate the cache.
+    std::vector<std::size_t> ranks;
+    ranks.reserve(locations.size());
+    for (const auto& location : locations) {
+      if (!location.has_coordinates()) {
+        break;
+      }
+      const auto search =
+        cached_ranks.find(Coordinates({location.lon(), location.lat()}));
+      if (search == cached_ranks.end()) {
+        break;
+      }
+      ranks.push_back(search->second);
+    }
+
+    if (ranks.size() == locations.size()) {
+      Matrix<Cost> m(locations.size());
+      for (std::size_t i = 0; i < locations.size(); ++i) {
+        const auto* cached_row = cached_data + ranks[i] * cached_size;
+        for (std::size_t j = 0; j < locations.size(); ++j) {
+          m[i][j] = cached_row[ranks[j]];
+        }
+      }
+      matrix = std::move(m);
+    }
+  }
+
+  munmap(const_cast<char*>(mapping), file_size);
+
+  if (matrix.has_value()) {
+    metrics::matrix_cache_hit();
+  } else {
+    metrics::matrix_cache_miss();
+  }
+
+  return matrix;
+}
+
+void save_cached_matrix(const std::string& profile,
+                        const std::vector<Location>& locations,
+                        const Matrix<Cost>& matrix) {
+  const auto file_name = cache_file_name(profile);
+  if (file_name.empty() or matrix.size() != locations.size()) {
+    return;
+  }
+
+  std::vector<Coordinates> coordinates;
+  coordinates.reserve(locations.size());
+  for (const auto& location : locations) {
+    if (!location.has_coordinates()) {
+      return;
+    }
+    coordinates.push_back(Coordinates({location.lon(), location.lat()}));
+  }
+
+  // Write to a temporary file first so a concurrent run never maps a
+  // partially written cache.
+  const auto tmp_file_name = file_name + ".tmp";
+  {
+    std::ofstream out(tmp_file_name, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) {
+      return;
+    }
+
+    CacheHeader header{CACHE_MAGIC, CACHE_VERSION, locations.size()};
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(coordinates.data()),
+              coordinates.size() * sizeof(Coordinates));
+    out.write(reinterpret_cast<const char*>(matrix[0]),
+              matrix.size() * matrix.size() * sizeof(Cost));
+    if (!out.good()) {
+      out.close();
+      std::remove(tmp_file_name.c_str());
+      return;
+    }
+  }
+
+  std::rename(tmp_file_name.c_str(), file_name.c_str());
+}
+
+std::vector<std::pair<Coordinates, std::string>>
+load_cached_hints(const std::string& profile) {
+  std::vector<std::pair<Coordinates, std::string>> hints;
+
+  const auto file_name = hints_file_name(profile);
+  if (file_name.empty()) {
+    return hints;
+  }
+
+  std::ifstream in(file_name, std::ios::binary);
+  if (!in.is_open()) {
+    return hints;
+  }
+
+  HintsHeader header;
+  in.read(reinterpret_cast<char*>(&header), sizeof(header));
+  if (!in.good() or header.magic != HINTS_MAGIC or
+      header.version != HINTS_VERSION) {
+    return hints;
+  }
+
+  hints.reserve(header.nb_entries);
+  for (uint64_t i = 0; i < header.nb_entries; ++i) {
+    Coordinates coordinates;
+    uint32_t length;
+    in.read(reinterpret_cast<char*>(&coordinates), sizeof(coordinates));
+    in.read(reinterpret_cast<char*>(&length), sizeof(length));
+    std::string hint(length, '\0');
+    in.read(hint.data(), length);
+    if (!in.good()) {
+      // Truncated or corrupt file, drop everything.
+      hints.clear();
+      break;
+    }
+    hints.emplace_back(coordinates, std::move(hint));
+  }
+
+  return hints;
+}
+
+void save_cached_hints(
+  const std::string& profile,
+  const std::vector<std::pair<Coordinates, std::string>>& hints) {
+  const auto file_name = hints_file_name(profile);
+  if (file_name.empty()) {
+    return;
+  }
+
+  // Write to a temporary file first so a concurrent run never reads a
+  // partially written store.
+  const auto tmp_file_name = file_name + ".tmp";
+  {
+    std::ofstream out(tmp_file_name, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) {
+      return;
+    }
+
+    HintsHeader header{HINTS_MAGIC, HINTS_VERSION, hints.size()};
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    for (const auto& entry : hints) {
+      const uint32_t length = entry.second.size();
+      out.write(reinterpret_cast<const char*>(&entry.first),
+                sizeof(entry.first));
+      out.write(reinterpret_cast<const char*>(&length), sizeof(length));
+      out.write(entry.second.data(), length);
+    }
+    if (!out.good()) {
+      out.close();
+      std::remove(tmp_file_name.c_str());
+      return;
+    }
+  }
+
+  std::rename(tmp_file_name.c_str(), file_name.c_str());
+}
+
+} // namespace utils
+} // namespace vroom
@@ -0,0 +1,65 @@
+#ifndef MATRIX_CACHE_H
+#define MATRIX_CACHE_H
+
+/*
+
+This file is part of VROOM.
+
+Copyright (c) 2015-2021, Julien Coupey.
+All rights reserved (see LICENSE).
+
+*/
+
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "structures/generic/matrix.h"
+#include "structures/vroom/location.h"
+
+namespace vroom {
+namespace utils {
+
+struct CoordinatesHash {
+  std::size_t operator()(const Coordinates& c) const {
+    return std::hash<Coordinate>()(c[0]) ^
+           (std::hash<Coordinate>()(c[1]) << 1);
+  }
+};
+
+// Persistent on-disk cache for duration matrices fetched from a
+// routing server, enabled whenever the VROOM_MATRIX_CACHE environment
+// variable points to a writable directory. One file is kept per
+// profile, holding the coordinate list along with the matrix data so
+// a later run can check what it can reuse.
+
+// Return a matrix for locations based on the cached file for profile,
+// if any. The cached locations do not have to match exactly: as long
+// as every location is found in the cached list, the relevant rows
+// and columns are extracted from a memory-mapped view of the file.
+std::optional<Matrix<Cost>>
+load_cached_matrix(const std::string& profile,
+                   const std::vector<Location>& locations);
+
+// Store matrix for locations as the cached file for profile,
+// replacing any previous content. Failures (e.g. cache dir not
+// writable) are silently ignored as the cache is best-effort only.
+void save_cached_matrix(const std::string& profile,
+                        const std::vector<Location>& locations,
+                        const Matrix<Cost>& matrix);
+
+// Persistent per-profile store of snapped location handles (e.g. OSRM
+// hints) keyed by coordinates, living next to the matrix cache in the
+// same directory. Attaching them to later queries spares the backend
+// the coordinate-to-graph snapping work for repeated locations.
+std::vector<std::pair<Coordinates, std::string>>
+load_cached_hints(const std::string& profile);
+
+void save_cached_hints(
+  const std::string& profile,
+  const std::vector<std::pair<Coordinates, std::string>>& hints);
+
+} // namespace utils
+} // namespace vroom
+
+#endif
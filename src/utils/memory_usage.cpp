@@ -0,0 +1,86 @@
+/*
+
+This file is part of VROOM.
+
+Copyright (c) 2015-2021, Julien Coupey.
+All rights reserved (see LICENSE).
+
+*/
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+#include "utils/memory_usage.h"
+
+namespace {
+
+// Relaxed ordering is enough: snapshots are only compared across
+// phase boundaries, not used for synchronization.
+std::atomic<std::uint64_t> nb_allocations(0);
+std::atomic<std::uint64_t> allocated_bytes(0);
+
+void* counted_alloc(std::size_t size) {
+  auto* p = std::malloc(size);
+  if (p == nullptr) {
+    throw std::bad_alloc();
+  }
+  nb_allocations.fetch_add(1, std::memory_order_relaxed);
+  allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+  return p;
+}
+
+} // namespace
+
+// Global overrides counting all heap traffic. The two relaxed atomic
+// increments are cheap enough to keep unconditionally, reporting
+// remains opt-in.
+void* operator new(std::size_t size) {
+  return counted_alloc(size);
+}
+
+void* operator new[](std::size_t size) {
+  return counted_alloc(size);
+}
+
+void operator delete(void* p) noexcept {
+  std::free(p);
+}
+
+void operator delete[](void* p) noexcept {
+  std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+  std::free(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept {
+  std::free(p);
+}
+
+namespace vroom {
+namespace utils {
+
+AllocationSnapshot allocation_snapshot() {
+  return {nb_allocations.load(std::memory_order_relaxed),
+          allocated_bytes.load(std::memory_order_relaxed)};
+}
+
+std::size_t peak_rss_kb() {
+#ifndef _WIN32
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) == 0) {
+    // ru_maxrss is expressed in kilobytes on Linux.
+    return static_cast<std::size_t>(usage.ru_maxrss);
+  }
+#endif
+  return 0;
+}
+
+} // namespace utils
+} // namespace vroom
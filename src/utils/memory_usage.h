@@ -0,0 +1,35 @@
+#ifndef MEMORY_USAGE_H
+#define MEMORY_USAGE_H
+
+/*
+
+This file is part of VROOM.
+
+Copyright (c) 2015-2021, Julien Coupey.
+All rights reserved (see LICENSE).
+
+*/
+
+#include <cstddef>
+#include <cstdint>
+
+namespace vroom {
+namespace utils {
+
+// Snapshot of the process-wide heap counters maintained by the
+// operator new overrides in memory_usage.cpp. Differences between two
+// snapshots give allocation count and volume for the code in between.
+struct AllocationSnapshot {
+  std::uint64_t nb_allocations;
+  std::uint64_t allocated_bytes;
+};
+
+AllocationSnapshot allocation_snapshot();
+
+// Peak resident set size in kilobytes, zero when unsupported.
+std::size_t peak_rss_kb();
+
+} // namespace utils
+} // namespace vroom
+
+#endif
@@ -0,0 +1,182 @@
+/*
+
+This file is part of VROOM.
+
+Copyright (c) 2015-2021, Julien Coupey.
+All rights reserved (see LICENSE).
+
+*/
+
+#include <array>
+#include <atomic>
+#include <sstream>
+
+#include "utils/metrics.h"
+
+namespace vroom {
+namespace utils {
+namespace metrics {
+
+namespace {
+
+// Shared latency bucket bounds for the per-phase histograms, in
+// milliseconds.
+constexpr std::array<uint64_t, 10>
+  BOUNDS_MS = {10, 25, 50, 100, 250, 500, 1000, 2500, 5000, 10000};
+
+struct Histogram {
+  // One extra bucket for the +Inf bound.
+  std::array<std::atomic<uint64_t>, BOUNDS_MS.size() + 1> buckets{};
+  std::atomic<uint64_t> sum_ms{0};
+  std::atomic<uint64_t> count{0};
+
+  void observe(uint64_t ms) {
+    std::size_t b = 0;
+    while (b < BOUNDS_MS.size() and BOUNDS_MS[b] < ms) {
+      ++b;
+    }
+    buckets[b].fetch_add(1, std::memory_order_relaxed);
+    sum_ms.fetch_add(ms, std::memory_order_relaxed);
+    count.fetch_add(1, std::memory_order_relaxed);
+  }
+};
+
+Histogram phase_histograms[3];
+const char* const PHASE_NAMES[3] = {"loading", "solving", "routing"};
+
+std::atomic<uint64_t> solves_in_flight{0};
+std::atomic<uint64_t> solves_total{0};
+std::atomic<uint64_t> matrix_cache_hits{0};
+std::atomic<uint64_t> matrix_cache_misses{0};
+std::atomic<uint64_t> solution_cache_hits{0};
+std::atomic<uint64_t> solution_cache_misses{0};
+std::atomic<uint64_t> routing_errors{0};
+std::atomic<uint64_t> routing_retries{0};
+std::atomic<uint64_t> pool_tasks_total{0};
+std::atomic<uint64_t> pool_busy_ms_total{0};
+
+void render_counter(std::ostringstream& out,
+                    const char* name,
+                    const char* type,
+                    uint64_t value) {
+  out << "# TYPE " << name << ' ' << type << '\n'
+      << name << ' ' << value << '\n';
+}
+
+} // namespace
+
+SolveScope::SolveScope() {
+  solves_in_flight.fetch_add(1, std::memory_order_relaxed);
+}
+
+SolveScope::~SolveScope() {
+  solves_in_flight.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void observe_solve(const ComputingTimes& computing_times) {
+  solves_total.fetch_add(1, std::memory_order_relaxed);
+  phase_histograms[0].observe(computing_times.loading);
+  phase_histograms[1].observe(computing_times.solving);
+  phase_histograms[2].observe(computing_times.routing);
+}
+
+void matrix_cache_hit() {
+  matrix_cache_hits.fetch_add(1, std::memory_order_relaxed);
+}
+
+void matrix_cache_miss() {
+  matrix_cache_misses.fetch_add(1, std::memory_order_relaxed);
+}
+
+void solution_cache_hit() {
+  solution_cache_hits.fetch_add(1, std::memory_order_relaxed);
+}
+
+void solution_cache_miss() {
+  solution_cache_misses.fetch_add(1, std::memory_order_relaxed);
+}
+
+void routing_error() {
+  routing_errors.fetch_add(1, std::memory_order_relaxed);
+}
+
+void routing_retry() {
+  routing_retries.fetch_add(1, std::memory_order_relaxed);
+}
+
+void pool_tasks(std::size_t nb_tasks, uint64_t busy_ms) {
+  pool_tasks_total.fetch_add(nb_tasks, std::memory_order_relaxed);
+  pool_busy_ms_total.fetch_add(busy_ms, std::memory_order_relaxed);
+}
+
+std::string render_prometheus() {
+  std::ostringstream out;
+
+  render_counter(out,
+                 "vroom_solves_in_flight",
+                 "gauge",
+                 solves_in_flight.load(std::memory_order_relaxed));
+  render_counter(out,
+                 "vroom_solves_total",
+                 "counter",
+                 solves_total.load(std::memory_order_relaxed));
+
+  out << "# TYPE vroom_phase_duration_milliseconds histogram\n";
+  for (std::size_t p = 0; p < 3; ++p) {
+    const auto& h = phase_histograms[p];
+    uint64_t cumulated = 0;
+    for (std::size_t b = 0; b < BOUNDS_MS.size(); ++b) {
+      cumulated += h.buckets[b].load(std::memory_order_relaxed);
+      out << "vroom_phase_duration_milliseconds_bucket{phase=\""
+          << PHASE_NAMES[p] << "\",le=\"" << BOUNDS_MS[b] << "\"} "
+          << cumulated << '\n';
+    }
+    cumulated += h.buckets[BOUNDS_MS.size()].load(std::memory_order_relaxed);
+    out << "vroom_phase_duration_milliseconds_bucket{phase=\""
+        << PHASE_NAMES[p] << "\",le=\"+Inf\"} " << cumulated << '\n';
+    out << "vroom_phase_duration_milliseconds_sum{phase=\"" << PHASE_NAMES[p]
+        << "\"} " << h.sum_ms.load(std::memory_order_relaxed) << '\n';
+    out << "vroom_phase_duration_milliseconds_count{phase=\""
+        << PHASE_NAMES[p] << "\"} "
+        << h.count.load(std::memory_order_relaxed) << '\n';
+  }
+
+  render_counter(out,
+                 "vroom_matrix_cache_hits_total",
+                 "counter",
+                 matrix_cache_hits.load(std::memory_order_relaxed));
+  render_counter(out,
+                 "vroom_matrix_cache_misses_total",
+                 "counter",
+                 matrix_cache_misses.load(std::memory_order_relaxed));
+  render_counter(out,
+                 "vroom_solution_cache_hits_total",
+                 "counter",
+                 solution_cache_hits.load(std::memory_order_relaxed));
+  render_counter(out,
+                 "vroom_solution_cache_misses_total",
+                 "counter",
+                 solution_cache_misses.load(std::memory_order_relaxed));
+  render_counter(out,
+                 "vroom_routing_errors_total",
+                 "counter",
+                 routing_errors.load(std::memory_order_relaxed));
+  render_counter(out,
+                 "vroom_routing_retries_total",
+                 "counter",
+                 routing_retries.load(std::memory_order_relaxed));
+  render_counter(out,
+                 "vroom_threadpool_tasks_total",
+                 "counter",
+                 pool_tasks_total.load(std::memory_order_relaxed));
+  render_counter(out,
+                 "vroom_threadpool_busy_milliseconds_total",
+                 "counter",
+                 pool_busy_ms_total.load(std::memory_order_relaxed));
+
+  return out.str();
+}
+
+} // namespace metrics
+} // namespace utils
+} // namespace vroom
@@ -0,0 +1,57 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+/*
+
+This file is part of VROOM.
+
+Copyright (c) 2015-2021, Julien Coupey.
+All rights reserved (see LICENSE).
+
+*/
+
+#include <cstdint>
+#include <string>
+
+#include "structures/vroom/solution/computing_times.h"
+
+namespace vroom {
+namespace utils {
+namespace metrics {
+
+// Process-wide counters behind the daemon /metrics endpoint
+// (Prometheus text exposition format). Updates are relaxed atomic
+// increments at existing phase boundaries, cheap enough to stay on
+// in every mode.
+
+// RAII over the solves-in-flight gauge, alive for the duration of
+// Input::solve including error paths.
+struct SolveScope {
+  SolveScope();
+  ~SolveScope();
+};
+
+// Record a completed solve in the per-phase latency histograms.
+void observe_solve(const ComputingTimes& computing_times);
+
+void matrix_cache_hit();
+void matrix_cache_miss();
+
+void solution_cache_hit();
+void solution_cache_miss();
+
+void routing_error();
+void routing_retry();
+
+// Thread pool accounting: number of tasks run and the total worker
+// time spent in them.
+void pool_tasks(std::size_t nb_tasks, uint64_t busy_ms);
+
+// Render all counters in the Prometheus text exposition format.
+std::string render_prometheus();
+
+} // namespace metrics
+} // namespace utils
+} // namespace vroom
+
+#endif
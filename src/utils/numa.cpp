@@ -0,0 +1,150 @@
+/*
+
+This file is part of VROOM.
+
+Copyright (c) 2015-2021, Julien Coupey.
+All rights reserved (see LICENSE).
+
+*/
+
+#include <algorithm>
+#include <cstdint>
+#include <thread>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "utils/numa.h"
+
+namespace vroom {
+namespace utils {
+
+bool has_multiple_numa_nodes() {
+#ifdef __linux__
+  return ::access("/sys/devices/system/node/node1", F_OK) == 0;
+#else
+  return false;
+#endif
+}
+
+namespace {
+std::vector<unsigned> solver_cpus;
+int solver_niceness = 0;
+bool solver_batch_class = false;
+bool solver_scheduling_set = false;
+} // namespace
+
+void set_solver_cpus(const std::vector<unsigned>& cpus) {
+  solver_cpus = cpus;
+}
+
+std::size_t nb_solver_cpus() {
+  return solver_cpus.size();
+}
+
+void set_solver_scheduling(int niceness, bool batch_class) {
+  solver_niceness = niceness;
+  solver_batch_class = batch_class;
+  solver_scheduling_set = true;
+}
+
+void pin_thread_to_cpu(unsigned rank) {
+#ifdef __linux__
+  unsigned cpu;
+  if (!solver_cpus.empty()) {
+    cpu = solver_cpus[rank % solver_cpus.size()];
+  } else {
+    const unsigned nb_cpus = std::max(1u, std::thread::hardware_concurrency());
+    cpu = rank % nb_cpus;
+  }
+  cpu_set_t cpus;
+  CPU_ZERO(&cpus);
+  CPU_SET(cpu, &cpus);
+  // Failure just keeps default scheduling.
+  pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpus);
+#else
+  (void)rank;
+#endif
+}
+
+void apply_solver_scheduling() {
+#ifdef __linux__
+  if (!solver_scheduling_set) {
+    return;
+  }
+  if (solver_batch_class) {
+    // With pid 0, sched_setscheduler only affects the calling thread
+    // on Linux. SCHED_BATCH keeps the static priority at 0.
+    struct sched_param param = {};
+    sched_setscheduler(0, SCHED_BATCH, &param);
+  }
+  if (solver_niceness != 0) {
+    // Same per-thread scope: niceness applies to the kernel task for
+    // the calling thread, not the whole process. Failure (e.g. a
+    // negative value without the privilege for it) just keeps the
+    // inherited niceness.
+    setpriority(PRIO_PROCESS,
+                static_cast<id_t>(syscall(SYS_gettid)),
+                solver_niceness);
+  }
+#endif
+}
+
+void drop_pages(void* data, std::size_t bytes) {
+#ifdef __linux__
+  const std::size_t page = sysconf(_SC_PAGESIZE);
+  const auto addr = reinterpret_cast<std::uintptr_t>(data);
+  const auto first_page = (addr + page - 1) & ~(page - 1);
+  const auto last_page = (addr + bytes) & ~(page - 1);
+
+  if (first_page < last_page) {
+    ::madvise(reinterpret_cast<void*>(first_page),
+              last_page - first_page,
+              MADV_DONTNEED);
+  }
+#else
+  (void)data;
+  (void)bytes;
+#endif
+}
+
+namespace {
+bool huge_pages_enabled = false;
+} // namespace
+
+void enable_huge_pages(bool enable) {
+  huge_pages_enabled = enable;
+}
+
+void advise_huge_pages(void* data, std::size_t bytes) {
+#ifdef __linux__
+  if (!huge_pages_enabled) {
+    return;
+  }
+
+  constexpr std::size_t huge_page = 2 * 1024 * 1024;
+  const auto addr = reinterpret_cast<std::uintptr_t>(data);
+  const auto first_page = (addr + huge_page - 1) & ~(huge_page - 1);
+  const auto last_page = (addr + bytes) & ~(huge_page - 1);
+
+  if (first_page < last_page) {
+#ifdef MADV_HUGEPAGE
+    ::madvise(reinterpret_cast<void*>(first_page),
+              last_page - first_page,
+              MADV_HUGEPAGE);
+#endif
+  }
+#else
+  (void)data;
+  (void)bytes;
+#endif
+}
+
+} // namespace utils
+} // namespace vroom
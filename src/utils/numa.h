@@ -0,0 +1,71 @@
+#ifndef NUMA_H
+#define NUMA_H
+
+/*
+
+This file is part of VROOM.
+
+Copyright (c) 2015-2021, Julien Coupey.
+All rights reserved (see LICENSE).
+
+*/
+
+#include <cstddef>
+#include <vector>
+
+namespace vroom {
+namespace utils {
+
+// Whether the machine exposes more than one NUMA node. Always false
+// on platforms where we cannot tell.
+bool has_multiple_numa_nodes();
+
+// Pin calling thread to a single CPU, spreading ranks round-robin
+// over the machine so pinned threads end up on all nodes. When a
+// solver CPU set is configured below, ranks cycle over that set
+// instead. Best effort and a no-op outside Linux.
+void pin_thread_to_cpu(unsigned rank);
+
+// Restrict solver threads to this CPU set instead of spreading them
+// over the whole machine, keeping their cache residency away from
+// other workloads sharing the box. An empty set restores the
+// default. Call before the first solve: the worker pool pins its
+// threads once on startup (see -C command-line flag).
+void set_solver_cpus(const std::vector<unsigned>& cpus);
+
+// Number of CPUs in the configured solver CPU set, zero when unset.
+std::size_t nb_solver_cpus();
+
+// Niceness and scheduling class for solver threads, so background
+// batch solves yield the CPU to interactive ones. SCHED_BATCH also
+// hints the kernel that the threads are CPU-bound, trading wake-up
+// latency for longer undisturbed slices. Call before the first
+// solve (see -n command-line flag).
+void set_solver_scheduling(int niceness, bool batch_class);
+
+// Apply the configured niceness and scheduling class to the calling
+// thread. Does nothing unless set above. Best effort and a no-op
+// outside Linux.
+void apply_solver_scheduling();
+
+// Drop resident pages backing the given range, discarding their
+// content: the next write re-faults each page on the node of the
+// touching thread. Only acts on whole pages within the range. Best
+// effort and a no-op outside Linux.
+void drop_pages(void* data, std::size_t bytes);
+
+// Process-wide opt-in for huge-page backing of large cost matrices,
+// off by default (see -m command-line flag).
+void enable_huge_pages(bool enable);
+
+// Ask the kernel for transparent 2 MB pages on the given range, so
+// random matrix lookups stop thrashing the dTLB. Does nothing unless
+// enabled above and the range spans at least one huge page. Best
+// effort (the kernel falls back to regular pages) and a no-op
+// outside Linux.
+void advise_huge_pages(void* data, std::size_t bytes);
+
+} // namespace utils
+} // namespace vroom
+
+#endif
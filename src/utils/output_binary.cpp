@@ -0,0 +1,313 @@
+/*
+
+This file is part of VROOM.
+
+Copyright (c) 2015-2021, Julien Coupey.
+All rights reserved (see LICENSE).
+
+*/
+
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <string_view>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include "utils/output_binary.h"
+#include "utils/polyline.h"
+
+namespace vroom {
+namespace io {
+
+namespace {
+
+// Length-prefixed format mirroring the json layout, for consumers
+// that immediately re-parse the output anyway. All integers are
+// fixed-width in host byte order, fields in brackets are only present
+// with the geometry flag set:
+//
+//   file       := u32 magic "VRSB", u32 version, u8 geometry flag,
+//                 u32 code, str error (code != 0) | summary,
+//                 u32 count + unassigned jobs, u32 count + routes
+//                 (code == 0)
+//   str        := u32 size, bytes
+//   amount     := u32 size, i64 values
+//   violations := u32 count, (u8 cause, u32 duration) each
+//   summary    := u32 cost, u32 unassigned, amount delivery, amount
+//                 pickup, u32 service, u32 duration, u32 waiting_time,
+//                 u32 priority, [u32 distance], violations, u32
+//                 loading, u32 solving, [u32 routing]
+//   unassigned := u64 id, u8 type, u8 has_location, [f64 lon, f64 lat]
+//   step       := u8 type, str description, u8 has_location, [f64 lon,
+//                 f64 lat], u64 id, u32 service, u32 waiting_time,
+//                 amount load, u32 arrival, u32 duration, violations,
+//                 [u32 distance]
+//   route      := u64 vehicle, u32 cost, str description, amount
+//                 delivery, amount pickup, u32 service, u32 duration,
+//                 u32 waiting_time, u32 priority, [u32 distance], u32
+//                 count + steps, violations, u32 count + (i32 lat, i32
+//                 lon) points
+//
+// Route geometries are decoded from their polyline form and carried
+// as raw coordinate pairs scaled by 1e5, saving consumers the varint
+// decoding. Location coordinates after a set has_location byte are
+// plain doubles, as in the json output. Job, pickup and delivery
+// steps all use u8 type 3, 4 and 5 with start, end and break being 0,
+// 1 and 2; unassigned job types start at 3 likewise. Violation causes
+// follow the VIOLATION enum order, with the duration only meaningful
+// for lead_time and delay.
+constexpr uint32_t BINARY_MAGIC = 0x56525342; // "VRSB"
+constexpr uint32_t BINARY_VERSION = 1;
+
+class BinaryWriter {
+private:
+  FILE* _out;
+
+public:
+  explicit BinaryWriter(FILE* out) : _out(out) {
+  }
+
+  template <typename T> void value(T v) {
+    std::fwrite(&v, sizeof(v), 1, _out);
+  }
+
+  void str(std::string_view s) {
+    value<uint32_t>(s.size());
+    std::fwrite(s.data(), 1, s.size(), _out);
+  }
+
+  void amount(const Amount& a) {
+    value<uint32_t>(a.size());
+    for (std::size_t i = 0; i < a.size(); ++i) {
+      value<int64_t>(a[i]);
+    }
+  }
+
+  void location(const Location& loc) {
+    value<uint8_t>(loc.has_coordinates() ? 1 : 0);
+    if (loc.has_coordinates()) {
+      value<double>(loc.lon());
+      value<double>(loc.lat());
+    }
+  }
+
+  void violations(const Violations& v) {
+    value<uint32_t>(v.types.size());
+    for (const auto type : v.types) {
+      value<uint8_t>(static_cast<uint8_t>(type));
+      uint32_t duration = 0;
+      if (type == VIOLATION::LEAD_TIME) {
+        duration = v.lead_time;
+      }
+      if (type == VIOLATION::DELAY) {
+        duration = v.delay;
+      }
+      value<uint32_t>(duration);
+    }
+  }
+};
+
+uint8_t job_type_code(JOB_TYPE job_type) {
+  switch (job_type) {
+  case JOB_TYPE::SINGLE:
+    return 3;
+  case JOB_TYPE::PICKUP:
+    return 4;
+  case JOB_TYPE::DELIVERY:
+    return 5;
+  }
+  return 3;
+}
+
+uint8_t step_type_code(STEP_TYPE step_type, JOB_TYPE job_type) {
+  switch (step_type) {
+  case STEP_TYPE::START:
+    return 0;
+  case STEP_TYPE::END:
+    return 1;
+  case STEP_TYPE::BREAK:
+    return 2;
+  case STEP_TYPE::JOB:
+    break;
+  }
+  return job_type_code(job_type);
+}
+
+void write_summary(BinaryWriter& w, const Summary& summary, bool geometry) {
+  w.value<uint32_t>(summary.cost);
+  w.value<uint32_t>(summary.unassigned);
+  w.amount(summary.delivery);
+  w.amount(summary.pickup);
+  w.value<uint32_t>(summary.service);
+  w.value<uint32_t>(summary.duration);
+  w.value<uint32_t>(summary.waiting_time);
+  w.value<uint32_t>(summary.priority);
+  if (geometry) {
+    w.value<uint32_t>(summary.distance);
+  }
+  w.violations(summary.violations);
+  w.value<uint32_t>(summary.computing_times.loading);
+  w.value<uint32_t>(summary.computing_times.solving);
+  if (geometry) {
+    w.value<uint32_t>(summary.computing_times.routing);
+  }
+}
+
+void write_step(BinaryWriter& w, const Step& s, bool geometry) {
+  w.value<uint8_t>(step_type_code(s.step_type, s.job_type));
+  w.str(s.description);
+  w.location(s.location);
+  w.value<uint64_t>(s.id);
+  w.value<uint32_t>(s.service);
+  w.value<uint32_t>(s.waiting_time);
+  w.amount(s.load);
+  w.value<uint32_t>(s.arrival);
+  w.value<uint32_t>(s.duration);
+  w.violations(s.violations);
+  if (geometry) {
+    w.value<uint32_t>(s.distance);
+  }
+}
+
+void write_route(BinaryWriter& w, const Route& route, bool geometry) {
+  w.value<uint64_t>(route.vehicle);
+  w.value<uint32_t>(route.cost);
+  w.str(route.description);
+  w.amount(route.delivery);
+  w.amount(route.pickup);
+  w.value<uint32_t>(route.service);
+  w.value<uint32_t>(route.duration);
+  w.value<uint32_t>(route.waiting_time);
+  w.value<uint32_t>(route.priority);
+  if (geometry) {
+    w.value<uint32_t>(route.distance);
+  }
+
+  w.value<uint32_t>(route.steps.size());
+  for (const auto& step : route.steps) {
+    write_step(w, step, geometry);
+  }
+
+  w.violations(route.violations);
+
+  std::vector<std::array<int32_t, 2>> points;
+  utils::polyline::decode(route.geometry, points);
+  w.value<uint32_t>(points.size());
+  for (const auto& point : points) {
+    w.value<int32_t>(point[0]);
+    w.value<int32_t>(point[1]);
+  }
+}
+
+// Alternative assignments (Input::set_nb_alternatives) are not part
+// of the binary layout and only show up in json output.
+void write_solution(BinaryWriter& w, const Solution& sol, bool geometry) {
+  w.value<uint32_t>(BINARY_MAGIC);
+  w.value<uint32_t>(BINARY_VERSION);
+  w.value<uint8_t>(geometry ? 1 : 0);
+
+  w.value<uint32_t>(sol.code);
+  if (sol.code != 0) {
+    w.str(sol.error);
+    return;
+  }
+
+  write_summary(w, sol.summary, geometry);
+
+  w.value<uint32_t>(sol.unassigned.size());
+  for (const auto& job : sol.unassigned) {
+    w.value<uint64_t>(job.id);
+    w.value<uint8_t>(job_type_code(job.type));
+    w.location(job.location);
+  }
+
+  w.value<uint32_t>(sol.routes.size());
+  for (const auto& route : sol.routes) {
+    write_route(w, route, geometry);
+  }
+}
+
+} // namespace
+
+void write_to_binary(const Solution& sol,
+                     bool geometry,
+                     const std::string& output_file) {
+  // Write to relevant output.
+  FILE* out =
+    output_file.empty() ? stdout : std::fopen(output_file.c_str(), "wb");
+  if (out == nullptr) {
+    // Fall back to standard output rather than losing the solution.
+    out = stdout;
+  }
+
+  BinaryWriter writer(out);
+  write_solution(writer, sol, geometry);
+
+  if (out == stdout) {
+    std::fflush(stdout);
+  } else {
+    std::fclose(out);
+  }
+}
+
+#ifndef _WIN32
+
+void write_to_shm(const Solution& sol,
+                  bool geometry,
+                  const std::string& segment_name,
+                  const std::string& output_file) {
+  // Lay the usual binary stream out in a POSIX shared memory
+  // segment: the segment is file-backed so the serializer streams
+  // into it directly and same-host consumers mmap and parse the flat
+  // layout in place, skipping the pipe write and re-parse entirely.
+  const int fd =
+    shm_open(segment_name.c_str(), O_CREAT | O_RDWR | O_TRUNC, 0600);
+  if (fd == -1) {
+    // Fall back to the regular channel rather than losing the
+    // solution.
+    write_to_binary(sol, geometry, output_file);
+    return;
+  }
+
+  FILE* out = fdopen(fd, "wb");
+  if (out == nullptr) {
+    close(fd);
+    shm_unlink(segment_name.c_str());
+    write_to_binary(sol, geometry, output_file);
+    return;
+  }
+
+  BinaryWriter writer(out);
+  write_solution(writer, sol, geometry);
+  const long segment_size = std::ftell(out);
+  std::fclose(out);
+
+  // Hand the descriptor over on the regular output channel. The
+  // consumer owns the segment lifetime from here and is expected to
+  // shm_unlink it once done.
+  FILE* descriptor_out =
+    output_file.empty() ? stdout : std::fopen(output_file.c_str(), "w");
+  if (descriptor_out == nullptr) {
+    descriptor_out = stdout;
+  }
+  std::fprintf(descriptor_out,
+               "{\"shm\":\"%s\",\"size\":%ld}\n",
+               segment_name.c_str(),
+               segment_size);
+  if (descriptor_out == stdout) {
+    std::fflush(stdout);
+  } else {
+    std::fclose(descriptor_out);
+  }
+}
+
+#endif
+
+} // namespace io
+} // namespace vroom
@@ -0,0 +1,43 @@
+#ifndef OUTPUT_BINARY_H
+#define OUTPUT_BINARY_H
+
+/*
+
+This file is part of VROOM.
+
+Copyright (c) 2015-2021, Julien Coupey.
+All rights reserved (see LICENSE).
+
+*/
+
+#include <string>
+
+#include "structures/vroom/solution/solution.h"
+
+namespace vroom {
+namespace io {
+
+// Write solution in the compact binary format (see the layout
+// description in output_binary.cpp) to output_file, or to standard
+// output if output_file is empty. The solution is serialized on the
+// fly so writing memory does not depend on solution size.
+void write_to_binary(const Solution& sol,
+                     bool geometry,
+                     const std::string& output_file);
+
+#ifndef _WIN32
+// Write solution in the same binary format to the POSIX shared
+// memory segment named segment_name, letting same-host consumers
+// mmap and read it zero-copy, then write a small json descriptor
+// (segment name and byte size) to output_file or standard output.
+// The consumer is expected to shm_unlink the segment once done.
+void write_to_shm(const Solution& sol,
+                  bool geometry,
+                  const std::string& segment_name,
+                  const std::string& output_file);
+#endif
+
+} // namespace io
+} // namespace vroom
+
+#endif
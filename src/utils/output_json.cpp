@@ -7,9 +7,10 @@ All rights reserved (see LICENSE).
 
 */
 
-#include <fstream>
-#include <iostream>
+#include <cstdio>
+#include <thread>
 
+#include "../include/rapidjson/filewritestream.h"
 #include "../include/rapidjson/stringbuffer.h"
 #include "../include/rapidjson/writer.h"
 
@@ -18,22 +19,31 @@ All rights reserved (see LICENSE).
 namespace vroom {
 namespace io {
 
-inline rapidjson::Value
-get_violations(const Violations& violations,
-               rapidjson::Document::AllocatorType& allocator) {
-  rapidjson::Value json_violations(rapidjson::kArrayType);
+// The solution is streamed straight to the output instead of being
+// materialized as a rapidjson document first: with detailed
+// geometries and hundreds of routes the intermediate DOM used to
+// transiently hold the whole output a second time.
+
+namespace {
+
+template <class Writer>
+void write_violations(Writer& writer, const Violations& violations) {
+  writer.Key("violations");
+  writer.StartArray();
 
   for (const auto type : violations.types) {
-    rapidjson::Value json_violation(rapidjson::kObjectType);
+    writer.StartObject();
     std::string cause;
     switch (type) {
     case VIOLATION::LEAD_TIME:
       cause = "lead_time";
-      json_violation.AddMember("duration", violations.lead_time, allocator);
+      writer.Key("duration");
+      writer.Uint(violations.lead_time);
       break;
     case VIOLATION::DELAY:
       cause = "delay";
-      json_violation.AddMember("duration", violations.delay, allocator);
+      writer.Key("duration");
+      writer.Uint(violations.delay);
       break;
     case VIOLATION::LOAD:
       cause = "load";
@@ -49,209 +59,135 @@ get_violations(const Violations& violations,
       break;
     }
 
-    json_violation.AddMember("cause", rapidjson::Value(), allocator);
-    json_violation["cause"].SetString(cause.c_str(), cause.size(), allocator);
-
-    json_violations.PushBack(json_violation, allocator);
+    writer.Key("cause");
+    writer.String(cause.c_str(), cause.size());
+    writer.EndObject();
   }
 
-  return json_violations;
-}
-
-rapidjson::Document to_json(const Solution& sol, bool geometry) {
-  rapidjson::Document json_output;
-  json_output.SetObject();
-  rapidjson::Document::AllocatorType& allocator = json_output.GetAllocator();
+  writer.EndArray();
 
-  json_output.AddMember("code", sol.code, allocator);
-  if (sol.code != 0) {
-    json_output.AddMember("error", rapidjson::Value(), allocator);
-    json_output["error"].SetString(sol.error.c_str(), sol.error.size());
-  } else {
-    json_output.AddMember("summary",
-                          to_json(sol.summary, geometry, allocator),
-                          allocator);
-
-    rapidjson::Value json_unassigned(rapidjson::kArrayType);
-    for (const auto& job : sol.unassigned) {
-      rapidjson::Value json_job(rapidjson::kObjectType);
-      json_job.AddMember("id", job.id, allocator);
-      if (job.location.has_coordinates()) {
-        json_job.AddMember("location",
-                           to_json(job.location, allocator),
-                           allocator);
-      }
-      json_job.AddMember("type", rapidjson::Value(), allocator);
-      std::string str_type;
-      switch (job.type) {
-      case JOB_TYPE::SINGLE:
-        str_type = "job";
-        break;
-      case JOB_TYPE::PICKUP:
-        str_type = "pickup";
-        break;
-      case JOB_TYPE::DELIVERY:
-        str_type = "delivery";
-        break;
-      }
-      json_job["type"].SetString(str_type.c_str(), str_type.size(), allocator);
-
-      json_unassigned.PushBack(json_job, allocator);
-    }
-
-    json_output.AddMember("unassigned", json_unassigned, allocator);
-
-    rapidjson::Value json_routes(rapidjson::kArrayType);
-    for (const auto& route : sol.routes) {
-      json_routes.PushBack(to_json(route, geometry, allocator), allocator);
-    }
-
-    json_output.AddMember("routes", json_routes, allocator);
+  if (violations.approximate) {
+    writer.Key("approximated_violations");
+    writer.Bool(true);
   }
-
-  return json_output;
 }
 
-rapidjson::Value to_json(const Summary& summary,
-                         bool geometry,
-                         rapidjson::Document::AllocatorType& allocator) {
-  rapidjson::Value json_summary(rapidjson::kObjectType);
-
-  json_summary.AddMember("cost", summary.cost, allocator);
-  json_summary.AddMember("unassigned", summary.unassigned, allocator);
-
-  if (summary.delivery.size() > 0) {
-    rapidjson::Value json_delivery(rapidjson::kArrayType);
-    for (std::size_t i = 0; i < summary.delivery.size(); ++i) {
-      json_delivery.PushBack(summary.delivery[i], allocator);
-    }
-    json_summary.AddMember("delivery", json_delivery, allocator);
-
-    // Support for deprecated "amount" key.
-    rapidjson::Value json_amount(rapidjson::kArrayType);
-    for (std::size_t i = 0; i < summary.delivery.size(); ++i) {
-      json_amount.PushBack(summary.delivery[i], allocator);
-    }
-    json_summary.AddMember("amount", json_amount, allocator);
+template <class Writer>
+void write_amount(Writer& writer, const char* key, const Amount& amount) {
+  writer.Key(key);
+  writer.StartArray();
+  for (std::size_t i = 0; i < amount.size(); ++i) {
+    writer.Int64(amount[i]);
   }
+  writer.EndArray();
+}
 
-  if (summary.pickup.size() > 0) {
-    rapidjson::Value json_pickup(rapidjson::kArrayType);
-    for (std::size_t i = 0; i < summary.pickup.size(); ++i) {
-      json_pickup.PushBack(summary.pickup[i], allocator);
-    }
-    json_summary.AddMember("pickup", json_pickup, allocator);
-  }
+template <class Writer>
+void write_location(Writer& writer, const Location& loc) {
+  writer.Key("location");
+  writer.StartArray();
+  writer.Double(loc.lon());
+  writer.Double(loc.lat());
+  writer.EndArray();
+}
+
+template <class Writer>
+void write_computing_times(Writer& writer,
+                           const ComputingTimes& ct,
+                           bool geometry) {
+  writer.Key("computing_times");
+  writer.StartObject();
 
-  json_summary.AddMember("service", summary.service, allocator);
-  json_summary.AddMember("duration", summary.duration, allocator);
-  json_summary.AddMember("waiting_time", summary.waiting_time, allocator);
-  json_summary.AddMember("priority", summary.priority, allocator);
+  writer.Key("loading");
+  writer.Uint(ct.loading);
+  writer.Key("solving");
+  writer.Uint(ct.solving);
 
   if (geometry) {
-    json_summary.AddMember("distance", summary.distance, allocator);
+    // Log route information timing when using routing engine.
+    writer.Key("routing");
+    writer.Uint(ct.routing);
   }
 
-  json_summary.AddMember("violations",
-                         get_violations(summary.violations, allocator),
-                         allocator);
-
-  json_summary.AddMember("computing_times",
-                         to_json(summary.computing_times, geometry, allocator),
-                         allocator);
+  writer.EndObject();
+}
 
-  return json_summary;
+template <class Writer>
+void write_memory_stats(Writer& writer, const MemoryStats& stats) {
+  writer.Key("memory");
+  writer.StartObject();
+
+  writer.Key("peak_rss_kb");
+  writer.Uint64(stats.peak_rss_kb);
+  writer.Key("allocated_bytes");
+  writer.Uint64(stats.allocated_bytes);
+
+  writer.Key("allocations");
+  writer.StartObject();
+  writer.Key("loading");
+  writer.Uint64(stats.loading_allocations);
+  writer.Key("solving");
+  writer.Uint64(stats.solving_allocations);
+  writer.Key("routing");
+  writer.Uint64(stats.routing_allocations);
+  writer.EndObject();
+
+  writer.EndObject();
 }
 
-rapidjson::Value to_json(const Route& route,
-                         bool geometry,
-                         rapidjson::Document::AllocatorType& allocator) {
-  rapidjson::Value json_route(rapidjson::kObjectType);
+template <class Writer>
+void write_summary(Writer& writer,
+                   const Summary& summary,
+                   bool geometry) {
+  writer.Key("summary");
+  writer.StartObject();
 
-  json_route.AddMember("vehicle", route.vehicle, allocator);
-  json_route.AddMember("cost", route.cost, allocator);
+  writer.Key("cost");
+  writer.Uint(summary.cost);
+  writer.Key("unassigned");
+  writer.Uint(summary.unassigned);
 
-  if (!route.description.empty()) {
-    json_route.AddMember("description", rapidjson::Value(), allocator);
-    json_route["description"].SetString(route.description.c_str(),
-                                        route.description.size(),
-                                        allocator);
-  }
-
-  if (route.delivery.size() > 0) {
-    rapidjson::Value json_delivery(rapidjson::kArrayType);
-    for (std::size_t i = 0; i < route.delivery.size(); ++i) {
-      json_delivery.PushBack(route.delivery[i], allocator);
-    }
-    json_route.AddMember("delivery", json_delivery, allocator);
+  if (summary.delivery.size() > 0) {
+    write_amount(writer, "delivery", summary.delivery);
 
     // Support for deprecated "amount" key.
-    rapidjson::Value json_amount(rapidjson::kArrayType);
-    for (std::size_t i = 0; i < route.delivery.size(); ++i) {
-      json_amount.PushBack(route.delivery[i], allocator);
-    }
-    json_route.AddMember("amount", json_amount, allocator);
+    write_amount(writer, "amount", summary.delivery);
   }
 
-  if (route.pickup.size() > 0) {
-    rapidjson::Value json_pickup(rapidjson::kArrayType);
-    for (std::size_t i = 0; i < route.pickup.size(); ++i) {
-      json_pickup.PushBack(route.pickup[i], allocator);
-    }
-    json_route.AddMember("pickup", json_pickup, allocator);
+  if (summary.pickup.size() > 0) {
+    write_amount(writer, "pickup", summary.pickup);
   }
 
-  json_route.AddMember("service", route.service, allocator);
-  json_route.AddMember("duration", route.duration, allocator);
-  json_route.AddMember("waiting_time", route.waiting_time, allocator);
-  json_route.AddMember("priority", route.priority, allocator);
+  writer.Key("service");
+  writer.Uint(summary.service);
+  writer.Key("duration");
+  writer.Uint(summary.duration);
+  writer.Key("waiting_time");
+  writer.Uint(summary.waiting_time);
+  writer.Key("priority");
+  writer.Uint(summary.priority);
 
   if (geometry) {
-    json_route.AddMember("distance", route.distance, allocator);
-  }
-
-  rapidjson::Value json_steps(rapidjson::kArrayType);
-  for (const auto& step : route.steps) {
-    json_steps.PushBack(to_json(step, geometry, allocator), allocator);
-  }
-
-  json_route.AddMember("steps", json_steps, allocator);
-
-  json_route.AddMember("violations",
-                       get_violations(route.violations, allocator),
-                       allocator);
-
-  if (!route.geometry.empty()) {
-    json_route.AddMember("geometry", rapidjson::Value(), allocator);
-    json_route["geometry"].SetString(route.geometry.c_str(),
-                                     route.geometry.size());
+    writer.Key("distance");
+    writer.Uint(summary.distance);
   }
 
-  return json_route;
-}
-
-rapidjson::Value to_json(const ComputingTimes& ct,
-                         bool geometry,
-                         rapidjson::Document::AllocatorType& allocator) {
-  rapidjson::Value json_ct(rapidjson::kObjectType);
+  write_violations(writer, summary.violations);
 
-  json_ct.AddMember("loading", ct.loading, allocator);
-  json_ct.AddMember("solving", ct.solving, allocator);
+  write_computing_times(writer, summary.computing_times, geometry);
 
-  if (geometry) {
-    // Log route information timing when using routing engine.
-    json_ct.AddMember("routing", ct.routing, allocator);
+  if (summary.memory_stats.has_value()) {
+    write_memory_stats(writer, summary.memory_stats.value());
   }
 
-  return json_ct;
+  writer.EndObject();
 }
 
-rapidjson::Value to_json(const Step& s,
-                         bool geometry,
-                         rapidjson::Document::AllocatorType& allocator) {
-  rapidjson::Value json_step(rapidjson::kObjectType);
+template <class Writer>
+void write_step(Writer& writer, const Step& s, bool geometry) {
+  writer.StartObject();
 
-  json_step.AddMember("type", rapidjson::Value(), allocator);
+  writer.Key("type");
   std::string str_type;
   switch (s.step_type) {
   case STEP_TYPE::START:
@@ -277,82 +213,282 @@ rapidjson::Value to_json(const Step& s,
     }
     break;
   }
-  json_step["type"].SetString(str_type.c_str(), str_type.size(), allocator);
+  writer.String(str_type.c_str(), str_type.size());
 
   if (!s.description.empty()) {
-    json_step.AddMember("description", rapidjson::Value(), allocator);
-    json_step["description"].SetString(s.description.c_str(),
-                                       s.description.size(),
-                                       allocator);
+    writer.Key("description");
+    writer.String(s.description.data(), s.description.size());
   }
 
   if (s.location.has_coordinates()) {
-    json_step.AddMember("location", to_json(s.location, allocator), allocator);
+    write_location(writer, s.location);
   }
 
   if (s.step_type == STEP_TYPE::JOB or s.step_type == STEP_TYPE::BREAK) {
-    json_step.AddMember("id", s.id, allocator);
+    writer.Key("id");
+    writer.Uint64(s.id);
   }
 
-  json_step.AddMember("service", s.service, allocator);
-  json_step.AddMember("waiting_time", s.waiting_time, allocator);
+  writer.Key("service");
+  writer.Uint(s.service);
+  writer.Key("waiting_time");
+  writer.Uint(s.waiting_time);
 
   // Should be removed at some point as step.job is deprecated.
   if (s.step_type == STEP_TYPE::JOB) {
-    json_step.AddMember("job", s.id, allocator);
+    writer.Key("job");
+    writer.Uint64(s.id);
   }
 
   if (s.load.size() > 0) {
-    rapidjson::Value json_load(rapidjson::kArrayType);
-    for (std::size_t i = 0; i < s.load.size(); ++i) {
-      json_load.PushBack(s.load[i], allocator);
-    }
-    json_step.AddMember("load", json_load, allocator);
+    write_amount(writer, "load", s.load);
   }
 
-  json_step.AddMember("arrival", s.arrival, allocator);
-  json_step.AddMember("duration", s.duration, allocator);
+  writer.Key("arrival");
+  writer.Uint(s.arrival);
+  writer.Key("duration");
+  writer.Uint(s.duration);
 
-  json_step.AddMember("violations",
-                      get_violations(s.violations, allocator),
-                      allocator);
+  write_violations(writer, s.violations);
 
   if (geometry) {
-    json_step.AddMember("distance", s.distance, allocator);
+    writer.Key("distance");
+    writer.Uint(s.distance);
   }
 
-  return json_step;
+  writer.EndObject();
 }
 
-rapidjson::Value to_json(const Location& loc,
-                         rapidjson::Document::AllocatorType& allocator) {
-  rapidjson::Value json_coords(rapidjson::kArrayType);
+template <class Writer>
+void write_route(Writer& writer,
+                 const Route& route,
+                 bool geometry,
+                 bool inline_geometry) {
+  writer.StartObject();
 
-  json_coords.PushBack(loc.lon(), allocator);
-  json_coords.PushBack(loc.lat(), allocator);
+  writer.Key("vehicle");
+  writer.Uint64(route.vehicle);
+  writer.Key("cost");
+  writer.Uint(route.cost);
 
-  return json_coords;
+  if (!route.description.empty()) {
+    writer.Key("description");
+    writer.String(route.description.data(), route.description.size());
+  }
+
+  if (route.delivery.size() > 0) {
+    write_amount(writer, "delivery", route.delivery);
+
+    // Support for deprecated "amount" key.
+    write_amount(writer, "amount", route.delivery);
+  }
+
+  if (route.pickup.size() > 0) {
+    write_amount(writer, "pickup", route.pickup);
+  }
+
+  writer.Key("service");
+  writer.Uint(route.service);
+  writer.Key("duration");
+  writer.Uint(route.duration);
+  writer.Key("waiting_time");
+  writer.Uint(route.waiting_time);
+  writer.Key("priority");
+  writer.Uint(route.priority);
+
+  if (geometry) {
+    writer.Key("distance");
+    writer.Uint(route.distance);
+  }
+
+  writer.Key("steps");
+  writer.StartArray();
+  for (const auto& step : route.steps) {
+    write_step(writer, step, geometry);
+  }
+  writer.EndArray();
+
+  write_violations(writer, route.violations);
+
+  if (inline_geometry and !route.geometry.empty()) {
+    writer.Key("geometry");
+    writer.String(route.geometry.c_str(), route.geometry.size());
+  }
+
+  writer.EndObject();
+}
+
+template <class Writer>
+void write_solution(Writer& writer,
+                    const Solution& sol,
+                    bool geometry,
+                    const std::string& geometry_file = "",
+                    bool plan_diff = false) {
+  writer.StartObject();
+
+  writer.Key("code");
+  writer.Uint(sol.code);
+  if (sol.code != 0) {
+    writer.Key("error");
+    writer.String(sol.error.c_str(), sol.error.size());
+  } else {
+    write_summary(writer, sol.summary, geometry);
+
+    writer.Key("unassigned");
+    writer.StartArray();
+    for (const auto& job : sol.unassigned) {
+      writer.StartObject();
+      writer.Key("id");
+      writer.Uint64(job.id);
+      if (job.location.has_coordinates()) {
+        write_location(writer, job.location);
+      }
+      writer.Key("type");
+      std::string str_type;
+      switch (job.type) {
+      case JOB_TYPE::SINGLE:
+        str_type = "job";
+        break;
+      case JOB_TYPE::PICKUP:
+        str_type = "pickup";
+        break;
+      case JOB_TYPE::DELIVERY:
+        str_type = "delivery";
+        break;
+      }
+      writer.String(str_type.c_str(), str_type.size());
+      writer.EndObject();
+    }
+    writer.EndArray();
+
+    writer.Key("routes");
+    writer.StartArray();
+    for (const auto& route : sol.routes) {
+      if (plan_diff and route.unchanged) {
+        continue;
+      }
+      write_route(writer, route, geometry, geometry_file.empty());
+    }
+    writer.EndArray();
+
+    if (plan_diff) {
+      // Routes matching the warm-start assignment are only
+      // referenced by id, consumers keep their previous content.
+      writer.Key("unchanged_routes");
+      writer.StartArray();
+      for (const auto& route : sol.routes) {
+        if (route.unchanged) {
+          writer.Uint64(route.vehicle);
+        }
+      }
+      writer.EndArray();
+    }
+
+    if (!sol.alternatives.empty()) {
+      // Fallback assignments retained from the solving parameter
+      // sweep, best first. Written without geometry detail since
+      // only the primary solution goes through the routing phase.
+      writer.Key("alternatives");
+      writer.StartArray();
+      for (const auto& alternative : sol.alternatives) {
+        write_solution(writer, alternative, false);
+      }
+      writer.EndArray();
+    }
+
+    if (!geometry_file.empty()) {
+      writer.Key("geometry_file");
+      writer.String(geometry_file.c_str(), geometry_file.size());
+    }
+  }
+
+  writer.EndObject();
+}
+
+// Heavy per-route detail written to the secondary file referenced
+// with the geometry_file key: route geometries keyed by vehicle id.
+void write_geometries(const Solution& sol, const std::string& geometry_file) {
+  FILE* out = std::fopen(geometry_file.c_str(), "w");
+  if (out == nullptr) {
+    // Consumers will notice the referenced file missing.
+    return;
+  }
+
+  char write_buffer[65536];
+  rapidjson::FileWriteStream output_stream(out,
+                                           write_buffer,
+                                           sizeof(write_buffer));
+  rapidjson::Writer<rapidjson::FileWriteStream> writer(output_stream);
+
+  writer.StartObject();
+  writer.Key("geometries");
+  writer.StartObject();
+  for (const auto& route : sol.routes) {
+    const auto key = std::to_string(route.vehicle);
+    writer.Key(key.c_str(), key.size());
+    writer.String(route.geometry.c_str(), route.geometry.size());
+  }
+  writer.EndObject();
+  writer.EndObject();
+
+  output_stream.Flush();
+  std::fclose(out);
+}
+
+} // namespace
+
+std::string solution_to_json(const Solution& sol,
+                             bool geometry,
+                             bool plan_diff) {
+  rapidjson::StringBuffer buffer;
+  rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+
+  write_solution(writer, sol, geometry, "", plan_diff);
+
+  return std::string(buffer.GetString(), buffer.GetSize());
 }
 
 void write_to_json(const Solution& sol,
                    bool geometry,
-                   const std::string& output_file) {
-  auto json_output = to_json(sol, geometry);
-
-  // Rapidjson writing process.
-  rapidjson::StringBuffer s;
-  rapidjson::Writer<rapidjson::StringBuffer> r_writer(s);
-  json_output.Accept(r_writer);
+                   const std::string& output_file,
+                   const std::string& geometry_file,
+                   bool plan_diff) {
+  // Stream the heavy geometry detail to its own file concurrently
+  // with the assignment core, which stays small and fast to parse.
+  std::thread geometry_writer;
+  if (!geometry_file.empty()) {
+    geometry_writer =
+      std::thread(write_geometries, std::cref(sol), std::cref(geometry_file));
+  }
 
   // Write to relevant output.
-  if (output_file.empty()) {
-    // Log to standard output.
-    std::cout << s.GetString() << std::endl;
+  FILE* out =
+    output_file.empty() ? stdout : std::fopen(output_file.c_str(), "w");
+  if (out == nullptr) {
+    // Fall back to standard output rather than losing the solution.
+    out = stdout;
+  }
+
+  char write_buffer[65536];
+  rapidjson::FileWriteStream output_stream(out,
+                                           write_buffer,
+                                           sizeof(write_buffer));
+  rapidjson::Writer<rapidjson::FileWriteStream> writer(output_stream);
+
+  write_solution(writer, sol, geometry, geometry_file, plan_diff);
+
+  output_stream.Flush();
+
+  if (out == stdout) {
+    // Keep the trailing newline from the previous logging behavior.
+    std::fputc('\n', stdout);
+    std::fflush(stdout);
   } else {
-    // Log to file.
-    std::ofstream out_stream(output_file, std::ofstream::out);
-    out_stream << s.GetString();
-    out_stream.close();
+    std::fclose(out);
+  }
+
+  if (geometry_writer.joinable()) {
+    geometry_writer.join();
   }
 }
 
@@ -10,36 +10,31 @@ All rights reserved (see LICENSE).
 
 */
 
-#include "../include/rapidjson/document.h"
 #include "structures/vroom/solution/solution.h"
 
 namespace vroom {
 namespace io {
 
-rapidjson::Document to_json(const Solution& sol, bool geometry);
-
-rapidjson::Value to_json(const Summary& summary,
-                         bool geometry,
-                         rapidjson::Document::AllocatorType& allocator);
-
-rapidjson::Value to_json(const ComputingTimes& computing_times,
-                         bool geometry,
-                         rapidjson::Document::AllocatorType& allocator);
-
-rapidjson::Value to_json(const Route& route,
-                         bool geometry,
-                         rapidjson::Document::AllocatorType& allocator);
-
-rapidjson::Value to_json(const Step& s,
-                         bool geometry,
-                         rapidjson::Document::AllocatorType& allocator);
-
-rapidjson::Value to_json(const Location& loc,
-                         rapidjson::Document::AllocatorType& allocator);
-
+// Serialize sol as a json string, e.g. for an http response. In
+// plan-diff mode, routes whose job sequence matches the warm-start
+// assignment are left out and only referenced by vehicle id in an
+// unchanged_routes key, shrinking re-solve outputs to what actually
+// changed.
+std::string solution_to_json(const Solution& sol,
+                             bool geometry,
+                             bool plan_diff = false);
+
+// Stream sol as json to output_file, or standard output when
+// output_file is empty. The solution is serialized on the fly so
+// writing memory does not depend on solution size. When
+// geometry_file is set, route geometries are written there instead of
+// being inlined and the main document references it with a
+// geometry_file key, keeping the assignment core small.
 void write_to_json(const Solution& sol,
                    bool geometry,
-                   const std::string& output_file);
+                   const std::string& output_file,
+                   const std::string& geometry_file = "",
+                   bool plan_diff = false);
 
 } // namespace io
 } // namespace vroom
@@ -0,0 +1,108 @@
+/*
+
+This file is part of VROOM.
+
+Copyright (c) 2015-2021, Julien Coupey.
+All rights reserved (see LICENSE).
+
+*/
+
+#include "utils/polyline.h"
+#include "utils/cpu_dispatch.h"
+
+namespace vroom {
+namespace utils {
+namespace polyline {
+
+namespace {
+
+// Values are zigzag-mapped to unsigned and split into 5-bit chunks,
+// each offset into the printable ASCII range with a continuation bit.
+constexpr int CHUNK_SIZE = 5;
+constexpr int ASCII_OFFSET = 63;
+constexpr uint32_t CHUNK_MASK = 0x1f;
+constexpr uint32_t CONTINUATION_BIT = 0x20;
+
+void append_value(int32_t delta, std::string& out) {
+  uint32_t value = static_cast<uint32_t>(delta) << 1;
+  if (delta < 0) {
+    value = ~value;
+  }
+
+  while (value >= CONTINUATION_BIT) {
+    out += static_cast<char>(((value & CHUNK_MASK) | CONTINUATION_BIT) +
+                             ASCII_OFFSET);
+    value >>= CHUNK_SIZE;
+  }
+  out += static_cast<char>(value + ASCII_OFFSET);
+}
+
+} // namespace
+
+void decode(const std::string& shape,
+            std::vector<std::array<int32_t, 2>>& points) {
+  // A coordinate pair takes at least two characters.
+  points.reserve(points.size() + shape.size() / 2);
+
+  const std::size_t size = shape.size();
+  std::size_t i = 0;
+  int32_t lat = 0;
+  int32_t lon = 0;
+
+  while (i < size) {
+    std::array<int32_t, 2> deltas;
+    for (auto& delta : deltas) {
+      uint32_t value = 0;
+      int shift = 0;
+      uint32_t chunk;
+      do {
+        if (i == size) {
+          return;
+        }
+        chunk = static_cast<uint32_t>(shape[i++] - ASCII_OFFSET);
+        value |= (chunk & CHUNK_MASK) << shift;
+        shift += CHUNK_SIZE;
+      } while (chunk & CONTINUATION_BIT);
+
+      delta = static_cast<int32_t>((value & 1) ? ~(value >> 1) : (value >> 1));
+    }
+
+    lat += deltas[0];
+    lon += deltas[1];
+    points.push_back({lat, lon});
+  }
+}
+
+// Flat loop over plain integers kept as a leaf function so per-target
+// clones can vectorize it.
+VROOM_TARGET_CLONES
+void rescale(std::vector<std::array<int32_t, 2>>& points, int32_t divisor) {
+  const int32_t half = divisor / 2;
+  for (auto& point : points) {
+    for (auto& value : point) {
+      value = (value >= 0) ? (value + half) / divisor
+                           : -((half - value) / divisor);
+    }
+  }
+}
+
+std::string encode(const std::vector<std::array<int32_t, 2>>& points) {
+  std::string out;
+  // Nearby points mostly fit 2 + 2 characters.
+  out.reserve(4 * points.size());
+
+  int32_t lat = 0;
+  int32_t lon = 0;
+  for (const auto& point : points) {
+    append_value(point[0] - lat, out);
+    append_value(point[1] - lon, out);
+    lat = point[0];
+    lon = point[1];
+  }
+
+  return out;
+}
+
+} // namespace polyline
+} // namespace utils
+} // namespace vroom
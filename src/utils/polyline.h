@@ -0,0 +1,45 @@
+#ifndef POLYLINE_H
+#define POLYLINE_H
+
+/*
+
+This file is part of VROOM.
+
+Copyright (c) 2015-2021, Julien Coupey.
+All rights reserved (see LICENSE).
+
+*/
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace vroom {
+namespace utils {
+namespace polyline {
+
+// Batch codec for Google encoded polylines, working on integer
+// (lat, lon) pairs scaled by 10^precision. Unlike the generic header
+// in include/, values never round-trip through doubles and the output
+// string is built in a single buffer, which matters when re-encoding
+// multi-thousand-point server geometries.
+
+// Append the points of an encoded polyline. Decoding stops at the
+// first truncated value so a mangled shape yields a shorter polyline,
+// never garbage coordinates.
+void decode(const std::string& shape,
+            std::vector<std::array<int32_t, 2>>& points);
+
+// Divide all coordinates in place with round-half-away, switching
+// between encoding precisions (e.g. 10 for 6 to 5 digits).
+void rescale(std::vector<std::array<int32_t, 2>>& points, int32_t divisor);
+
+// Delta-encode points into a polyline string.
+std::string encode(const std::vector<std::array<int32_t, 2>>& points);
+
+} // namespace polyline
+} // namespace utils
+} // namespace vroom
+
+#endif
@@ -0,0 +1,107 @@
+#ifndef SOLUTION_POOL_H
+#define SOLUTION_POOL_H
+
+/*
+
+This file is part of VROOM.
+
+Copyright (c) 2015-2021, Julien Coupey.
+All rights reserved (see LICENSE).
+
+*/
+
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+#include "structures/vroom/solution_state.h"
+
+namespace vroom {
+namespace utils {
+
+// Best-known solution slot shared by solving threads. Dominance
+// checks against the best known indicators are designed to stay
+// cheap enough for very frequent pruning reads, and the full best
+// solution is published as an immutable snapshot swapped RCU-style:
+// readers pin the current snapshot and keep using it while a better
+// one replaces the pointer, so publication never blocks them.
+template <class Solution> class SolutionPool {
+public:
+  struct Entry {
+    SolutionIndicators indicators;
+    Solution solution;
+  };
+
+private:
+  // Packed indicators key of the best known solution, split over two
+  // 64-bit words versioned by an epoch counter (even between
+  // updates, seqlock-style). Reads are a couple of atomic loads with
+  // a retry on the rare torn read. A single 128-bit compare-and-swap
+  // would be simpler but baseline x86-64 builds cannot assume
+  // cmpxchg16b, so atomics that wide may silently fall back to a
+  // lock. The all-ones initial key compares worse than any real key,
+  // doubling as the empty marker.
+  std::atomic<uint64_t> _epoch{0};
+  std::atomic<uint64_t> _key_high{std::numeric_limits<uint64_t>::max()};
+  std::atomic<uint64_t> _key_low{std::numeric_limits<uint64_t>::max()};
+  std::shared_ptr<const Entry> _entry;
+  // Serializes writers only, readers never take it.
+  std::mutex _write_mutex;
+
+public:
+  // Whether the pool holds a solution strictly better than indic.
+  bool dominates(const SolutionIndicators& indic) const {
+    while (true) {
+      const uint64_t stamp = _epoch.load(std::memory_order_acquire);
+      const uint64_t high = _key_high.load(std::memory_order_acquire);
+      const uint64_t low = _key_low.load(std::memory_order_acquire);
+      if (stamp % 2 == 1 or stamp != _epoch.load(std::memory_order_acquire)) {
+        // Torn read during a concurrent publication, retry.
+        continue;
+      }
+      return std::make_pair(high, low) < indic.packed_key();
+    }
+  }
+
+  // Current best solution, or nullptr while the pool is empty. The
+  // returned snapshot is immutable and remains valid after better
+  // solutions get published.
+  std::shared_ptr<const Entry> snapshot() const {
+    return std::atomic_load_explicit(&_entry, std::memory_order_acquire);
+  }
+
+  // Publish candidate if it improves on the best known solution,
+  // returning whether it did. The solution is copied into a fresh
+  // snapshot so the caller keeps ownership of its own copy.
+  bool try_publish(const SolutionIndicators& indic, const Solution& solution) {
+    std::lock_guard<std::mutex> guard(_write_mutex);
+
+    const auto current = snapshot();
+    if (current != nullptr and !(indic < current->indicators)) {
+      return false;
+    }
+
+    auto entry = std::make_shared<Entry>();
+    entry->indicators = indic;
+    entry->solution = solution;
+    std::atomic_store_explicit(&_entry,
+                               std::shared_ptr<const Entry>(std::move(entry)),
+                               std::memory_order_release);
+
+    const auto key = indic.packed_key();
+    // Odd epoch marks the key pair as in flux for concurrent reads.
+    _epoch.fetch_add(1, std::memory_order_acq_rel);
+    _key_high.store(key.first, std::memory_order_release);
+    _key_low.store(key.second, std::memory_order_release);
+    _epoch.fetch_add(1, std::memory_order_release);
+    return true;
+  }
+};
+
+} // namespace utils
+} // namespace vroom
+
+#endif
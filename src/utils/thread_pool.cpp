@@ -0,0 +1,209 @@
+/*
+
+This file is part of VROOM.
+
+Copyright (c) 2015-2021, Julien Coupey.
+All rights reserved (see LICENSE).
+
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+
+#include "utils/metrics.h"
+#include "utils/numa.h"
+#include "utils/thread_pool.h"
+
+namespace vroom {
+namespace utils {
+
+unsigned effective_concurrency() {
+  unsigned concurrency = std::max(1u, std::thread::hardware_concurrency());
+
+#ifdef __linux__
+  // cgroup v2 exposes "quota period" in a single file ("max" for
+  // unlimited) while v1 splits them across two files with -1 for
+  // unlimited. Whichever is present caps the usable CPU budget,
+  // rounded up so fractional quotas still get a thread.
+  long long quota = -1;
+  long long period = -1;
+
+  std::ifstream v2("/sys/fs/cgroup/cpu.max");
+  if (v2.is_open()) {
+    std::string quota_str;
+    if (v2 >> quota_str >> period and quota_str != "max") {
+      quota = std::strtoll(quota_str.c_str(), nullptr, 10);
+    }
+  } else {
+    std::ifstream v1_quota("/sys/fs/cgroup/cpu/cpu.cfs_quota_us");
+    std::ifstream v1_period("/sys/fs/cgroup/cpu/cpu.cfs_period_us");
+    if (!(v1_quota >> quota)) {
+      quota = -1;
+    }
+    if (!(v1_period >> period)) {
+      period = -1;
+    }
+  }
+
+  if (quota > 0 and period > 0) {
+    const long long budget = std::max(1LL, (quota + period - 1) / period);
+    if (budget < static_cast<long long>(concurrency)) {
+      concurrency = static_cast<unsigned>(budget);
+    }
+  }
+#endif
+
+  // An explicit solver CPU set is a tighter budget still: more
+  // workers than CPUs in the set would just time-share the pins.
+  const std::size_t nb_cpus = nb_solver_cpus();
+  if (nb_cpus > 0 and nb_cpus < concurrency) {
+    concurrency = static_cast<unsigned>(nb_cpus);
+  }
+
+  return concurrency;
+}
+
+ThreadPool& ThreadPool::instance() {
+  static ThreadPool pool;
+  return pool;
+}
+
+ThreadPool::ThreadPool() : _stop(false) {
+  // The calling thread works too so that many workers are enough to
+  // saturate the CPU budget.
+  const auto nb_workers = effective_concurrency();
+  // On multi-node machines workers are pinned round-robin over CPUs
+  // so they sit on all nodes and keep a stable node-local view of
+  // whatever pages they first touch. Single-node machines keep
+  // default scheduling unless an explicit CPU set restricts the
+  // process (see -C command-line flag). The calling thread is left
+  // alone so a daemon's accept loop keeps its own scheduling.
+  const bool pin_workers =
+    nb_solver_cpus() > 0 or has_multiple_numa_nodes();
+  for (unsigned w = 0; w < nb_workers; ++w) {
+    _workers.emplace_back([this, w, pin_workers]() {
+      if (pin_workers) {
+        pin_thread_to_cpu(w);
+      }
+      apply_solver_scheduling();
+      worker();
+    });
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> guard(_mutex);
+    _stop = true;
+  }
+  _cv.notify_all();
+  for (auto& w : _workers) {
+    w.join();
+  }
+}
+
+std::function<void()> ThreadPool::pop_task() {
+  auto& batch = _batches.front();
+  auto task = std::move(batch.front());
+  batch.pop_front();
+  if (batch.empty()) {
+    _batches.pop_front();
+  } else {
+    // Rotate so the next worker serves another active batch.
+    _batches.splice(_batches.end(), _batches, _batches.begin());
+  }
+  return task;
+}
+
+void ThreadPool::worker() {
+  for (;;) {
+    std::function<void()> work;
+    {
+      std::unique_lock<std::mutex> lock(_mutex);
+      _cv.wait(lock, [&]() { return _stop or !_batches.empty(); });
+      if (_batches.empty()) {
+        // Only left on stop as spurious wake-ups are filtered above.
+        return;
+      }
+      work = pop_task();
+    }
+    work();
+  }
+}
+
+void ThreadPool::run(std::vector<std::function<void()>>&& tasks) {
+  if (tasks.empty()) {
+    return;
+  }
+  if (tasks.size() == 1) {
+    const auto start = std::chrono::steady_clock::now();
+    tasks.front()();
+    metrics::pool_tasks(1,
+                        std::chrono::duration_cast<std::chrono::milliseconds>(
+                          std::chrono::steady_clock::now() - start)
+                          .count());
+    return;
+  }
+
+  // Completion tracking for this batch only: the shared queue may
+  // simultaneously hold tasks from other (e.g. nested) batches.
+  struct BatchState {
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::size_t remaining;
+  };
+  auto state = std::make_shared<BatchState>();
+  state->remaining = tasks.size();
+
+  {
+    std::lock_guard<std::mutex> guard(_mutex);
+    _batches.emplace_back();
+    auto& batch = _batches.back();
+    for (auto& task : tasks) {
+      batch.emplace_back([task = std::move(task), state]() {
+        const auto start = std::chrono::steady_clock::now();
+        task();
+        metrics::pool_tasks(
+          1,
+          std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - start)
+            .count());
+        std::lock_guard<std::mutex> state_guard(state->mutex);
+        if (--state->remaining == 0) {
+          state->cv.notify_all();
+        }
+      });
+    }
+  }
+  _cv.notify_all();
+
+  // Work along with the pool until this batch completed. Progress is
+  // always possible since any thread holding work executes it, and
+  // round-robin dispatch means helping does not starve other batches.
+  for (;;) {
+    {
+      std::lock_guard<std::mutex> state_guard(state->mutex);
+      if (state->remaining == 0) {
+        break;
+      }
+    }
+    std::function<void()> work;
+    {
+      std::lock_guard<std::mutex> guard(_mutex);
+      if (_batches.empty()) {
+        break;
+      }
+      work = pop_task();
+    }
+    work();
+  }
+
+  std::unique_lock<std::mutex> lock(state->mutex);
+  state->cv.wait(lock, [&]() { return state->remaining == 0; });
+}
+
+} // namespace utils
+} // namespace vroom
@@ -0,0 +1,75 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+/*
+
+This file is part of VROOM.
+
+Copyright (c) 2015-2021, Julien Coupey.
+All rights reserved (see LICENSE).
+
+*/
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace vroom {
+namespace utils {
+
+// Process-wide pool of worker threads shared by all parallel phases
+// (matrix fetch, heuristic solving, local search), so repeated solve
+// calls from a long-running process reuse the same threads instead
+// of spawning and joining fresh ones every time. The worker count is
+// the machine-wide core budget: concurrent solves time-share it
+// instead of each spawning its own threads and oversubscribing the
+// box.
+// Number of threads worth running in this process:
+// hardware_concurrency capped by the cgroup CPU quota when one is
+// set, so containers with a 2-core budget on a 64-core machine do
+// not oversubscribe. At least 1.
+unsigned effective_concurrency();
+
+class ThreadPool {
+public:
+  static ThreadPool& instance();
+
+  // Run all tasks and block until they completed. The calling thread
+  // takes part in the work, so nested run calls from inside a task
+  // cannot starve. Tasks are expected to handle their own exceptions,
+  // matching the usual exception_ptr pattern at call sites.
+  void run(std::vector<std::function<void()>>&& tasks);
+
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+private:
+  ThreadPool();
+
+  void worker();
+
+  // Pop the next task, rotating across active batches. Requires
+  // holding _mutex and at least one pending batch.
+  std::function<void()> pop_task();
+
+  std::mutex _mutex;
+  std::condition_variable _cv;
+  // Pending tasks grouped per run call ("batch"). Dispatching
+  // round-robin across batches partitions the workers among
+  // concurrent solves instead of queuing them behind each other, and
+  // capacity reflows to the remaining solves as batches drain.
+  std::list<std::deque<std::function<void()>>> _batches;
+  bool _stop;
+  std::vector<std::thread> _workers;
+};
+
+} // namespace utils
+} // namespace vroom
+
+#endif
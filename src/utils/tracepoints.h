@@ -0,0 +1,40 @@
+#ifndef TRACEPOINTS_H
+#define TRACEPOINTS_H
+
+/*
+
+This file is part of VROOM.
+
+Copyright (c) 2015-2021, Julien Coupey.
+All rights reserved (see LICENSE).
+
+*/
+
+// USDT static tracepoints on solver hot paths. Each probe compiles
+// to a single nop until a tracer attaches, so production binaries
+// carry them for free and latency can be attributed with perf or
+// bpftrace without rebuilding, e.g.
+//
+//   bpftrace -e 'usdt:./vroom:vroom:ls_round_end { @ = hist(arg0); }'
+//
+// Probes expand to nothing when the SystemTap development header is
+// absent at build time.
+
+#if defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define VROOM_HAS_TRACEPOINTS 1
+#endif
+#endif
+
+#ifdef VROOM_HAS_TRACEPOINTS
+#define VROOM_TRACE(name) DTRACE_PROBE(vroom, name)
+#define VROOM_TRACE1(name, a) DTRACE_PROBE1(vroom, name, a)
+#define VROOM_TRACE2(name, a, b) DTRACE_PROBE2(vroom, name, a, b)
+#else
+#define VROOM_TRACE(name) ((void)0)
+#define VROOM_TRACE1(name, a) ((void)0)
+#define VROOM_TRACE2(name, a, b) ((void)0)
+#endif
+
+#endif